@@ -22,6 +22,7 @@ LOCAL_SRC_FILES:= \
     ./dm/bta_dm_cfg.c \
     ./dm/bta_dm_api.c \
     ./dm/bta_dm_sco.c \
+    ./dm/bta_dm_sdp_batch.c \
     ./gatt/bta_gattc_api.c \
     ./gatt/bta_gatts_act.c \
     ./gatt/bta_gatts_main.c \
@@ -122,3 +123,50 @@ LOCAL_C_INCLUDES+= . \
 
 
 include $(BUILD_STATIC_LIBRARY)
+
+#####################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/sys \
+    $(LOCAL_PATH)/dm \
+    $(LOCAL_PATH)/gatt \
+    $(LOCAL_PATH)/hh \
+    $(LOCAL_PATH)/../gki/common \
+    $(LOCAL_PATH)/../gki/ulinux \
+    $(LOCAL_PATH)/../include \
+    $(LOCAL_PATH)/../stack/include \
+    $(LOCAL_PATH)/../stack/btm \
+    $(LOCAL_PATH)/../udrv/include \
+    $(LOCAL_PATH)/../vnd/include \
+    $(LOCAL_PATH)/../utils/include \
+    $(bdroid_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ../gki/common/gki_buffer.c \
+    ./dm/bta_dm_act.c \
+    ./dm/bta_dm_sdp_batch.c \
+    ./gatt/bta_gattc_cache.c \
+    ./hh/bta_hh_act.c \
+    ./hh/bta_hh_cfg.c \
+    ./hh/bta_hh_main.c \
+    ./hh/bta_hh_utils.c \
+    ./sys/bd.c \
+    ./sys/utl.c \
+    ./test/bta_dm_act_stubs.cpp \
+    ./test/bta_dm_sdp_batch_test.cpp \
+    ./test/bta_gattc_cache_test.cpp \
+    ./test/bta_gattc_stubs.cpp \
+    ./test/bta_hh_stubs.cpp \
+    ./test/bta_hh_test.cpp \
+    ./test/fake_bta_sys.cpp
+
+LOCAL_CFLAGS := -DBUILDCFG $(bdroid_CFLAGS)
+LOCAL_CONLYFLAGS := -std=c99
+LOCAL_MODULE := btatests
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog
+
+include $(BUILD_NATIVE_TEST)
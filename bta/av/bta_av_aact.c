@@ -595,6 +595,8 @@ void bta_av_stream_data_cback(UINT8 handle, BT_HDR *p_pkt, UINT32 time_stamp, UI
         return;
     }
     p_pkt->event = BTA_AV_MEDIA_DATA_EVT;
+    /* use the offset area for the time stamp, as on the source side */
+    *(UINT32 *)(p_pkt + 1) = time_stamp;
     p_scb->seps[p_scb->sep_idx].p_app_data_cback(BTA_AV_MEDIA_DATA_EVT, (tBTA_AV_MEDIA*)p_pkt);
     GKI_freebuf(p_pkt);  /* a copy of packet had been delivered, we free this buffer */
 }
@@ -2214,6 +2216,49 @@ void bta_av_reconfig (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
     }
 }
 
+/*******************************************************************************
+**
+** Function         bta_av_get_media_buf
+**
+** Description      Get the next media buffer to send: from q_info.a2d if it
+**                  has any, otherwise from co_data, in which case the buffer
+**                  is dup'ed to the other channels.
+**
+** Returns          the buffer, or NULL if there is no data.
+**
+*******************************************************************************/
+static BT_HDR *bta_av_get_media_buf (tBTA_AV_SCB *p_scb, UINT32 *p_timestamp,
+                                     BOOLEAN *p_new_buf)
+{
+    BT_HDR  *p_buf;
+    UINT32  data_len;
+
+    p_buf = (BT_HDR *)GKI_dequeue (&p_scb->q_info.a2d);
+    if(p_buf)
+    {
+        /* use q_info.a2d data, read the timestamp */
+        *p_timestamp = *(UINT32 *)(p_buf + 1);
+        *p_new_buf = FALSE;
+    }
+    else
+    {
+        *p_new_buf = TRUE;
+        /* q_info.a2d empty, call co_data, dup data to other channels */
+        p_buf = (BT_HDR *)p_scb->p_cos->data(p_scb->codec_type, &data_len,
+                                         p_timestamp);
+
+        if (p_buf)
+        {
+            /* use the offset area for the time stamp */
+            *(UINT32 *)(p_buf + 1) = *p_timestamp;
+
+            /* dup the data to other channels */
+            bta_av_dup_audio_buf(p_scb, p_buf);
+        }
+    }
+    return p_buf;
+}
+
 /*******************************************************************************
 **
 ** Function         bta_av_data_path
@@ -2226,11 +2271,13 @@ void bta_av_reconfig (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
 void bta_av_data_path (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
 {
     BT_HDR  *p_buf;
-    UINT32  data_len;
     UINT32  timestamp;
     BOOLEAN new_buf = FALSE;
     UINT8   m_pt = 0x60 | p_scb->codec_type;
     tAVDT_DATA_OPT_MASK     opt;
+    BT_HDR  *batch[BTA_AV_QUEUE_DATA_CHK_NUM];
+    UINT32  batch_ts[BTA_AV_QUEUE_DATA_CHK_NUM];
+    UINT8   num_batch;
     UNUSED(p_data);
 
     if (!p_scb->cong)
@@ -2241,28 +2288,7 @@ void bta_av_data_path (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
         //Always get the current number of bufs que'd up
         p_scb->l2c_bufs = (UINT8)L2CA_FlushChannel (p_scb->l2c_cid, L2CAP_FLUSH_CHANS_GET);
 
-        p_buf = (BT_HDR *)GKI_dequeue (&p_scb->q_info.a2d);
-        if(p_buf)
-        {
-            /* use q_info.a2d data, read the timestamp */
-            timestamp = *(UINT32 *)(p_buf + 1);
-        }
-        else
-        {
-            new_buf = TRUE;
-            /* q_info.a2d empty, call co_data, dup data to other channels */
-            p_buf = (BT_HDR *)p_scb->p_cos->data(p_scb->codec_type, &data_len,
-                                             &timestamp);
-
-            if (p_buf)
-            {
-                /* use the offset area for the time stamp */
-                *(UINT32 *)(p_buf + 1) = timestamp;
-
-                /* dup the data to other channels */
-                bta_av_dup_audio_buf(p_scb, p_buf);
-            }
-        }
+        p_buf = bta_av_get_media_buf(p_scb, &timestamp, &new_buf);
 
         if(p_buf)
         {
@@ -2282,7 +2308,24 @@ void bta_av_data_path (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
                     opt |= AVDT_DATA_OPT_NO_RTP;
                 }
 
-                AVDT_WriteReqOpt(p_scb->avdt_handle, p_buf, timestamp, m_pt, opt);
+                /* fill the room left at L2CAP in one write, so a backlog
+                 * drains in one write confirm instead of one per packet */
+                batch[0] = p_buf;
+                batch_ts[0] = timestamp;
+                num_batch = 1;
+                while ((p_scb->l2c_bufs + num_batch) < BTA_AV_QUEUE_DATA_CHK_NUM)
+                {
+                    if ((p_buf = bta_av_get_media_buf(p_scb, &timestamp, &new_buf)) == NULL)
+                        break;
+                    batch[num_batch] = p_buf;
+                    batch_ts[num_batch] = timestamp;
+                    num_batch++;
+                }
+
+                if (num_batch == 1)
+                    AVDT_WriteReqOpt(p_scb->avdt_handle, batch[0], batch_ts[0], m_pt, opt);
+                else
+                    AVDT_WriteReqBatch(p_scb->avdt_handle, num_batch, batch, batch_ts, m_pt, opt);
                 p_scb->cong = TRUE;
             }
             else
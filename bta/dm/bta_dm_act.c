@@ -51,6 +51,11 @@ static void bta_dm_service_search_remname_cback (BD_ADDR bd_addr, DEV_CLASS dc,
 static void bta_dm_rem_name_cback (BD_ADDR bd_addr, DEV_CLASS dc, BD_NAME bd_name);
 static void bta_dm_remname_cback (tBTM_REMOTE_DEV_NAME *p_remote_name);
 static void bta_dm_find_services ( BD_ADDR bd_addr);
+#if (defined BTA_DM_SDP_BATCH_SEARCH) && (BTA_DM_SDP_BATCH_SEARCH == TRUE)
+static BOOLEAN bta_dm_find_services_batched (BD_ADDR bd_addr);
+static UINT32 bta_dm_sdp_batch_result (UINT8 uuid_list[][MAX_UUID_SIZE], UINT32 max_uuids,
+                                       UINT16 sdp_result);
+#endif
 static void bta_dm_discover_next_device(void);
 static void bta_dm_sdp_callback (UINT16 sdp_status);
 static UINT8 bta_dm_authorize_cback (BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name, UINT8 *service_name, UINT8 service_id, BOOLEAN is_originator);
@@ -696,6 +701,9 @@ void bta_dm_remove_device (tBTA_DM_MSG *p_data)
     int i;
     tBTA_DM_SEC sec_event;
 
+    /* the cached SDP results go with the bond */
+    SDP_CacheInvalidate(p_dev->bd_addr);
+
 #if (BLE_INCLUDED == TRUE && BTA_GATT_INCLUDED == TRUE)
     /* need to remove all pending background connection before unpair */
     BTA_GATTC_CancelOpen(0, p_dev->bd_addr, FALSE);
@@ -1359,6 +1367,9 @@ void bta_dm_discover (tBTA_DM_MSG *p_data)
     bta_dm_search_cb.services_to_search = bta_dm_search_cb.services;
     bta_dm_search_cb.service_index = 0;
     bta_dm_search_cb.services_found = 0;
+    bta_dm_search_cb.sdp_batch_mask = 0;
+    bta_dm_search_cb.sdp_batch_off = FALSE;
+    bta_dm_search_cb.sdp_transactions = 0;
     bta_dm_search_cb.peer_name[0] = 0;
     bta_dm_search_cb.sdp_search = p_data->discover.sdp_search;
     bta_dm_search_cb.p_btm_inq_info = BTM_InqDbRead (p_data->discover.bd_addr);
@@ -1776,6 +1787,15 @@ void bta_dm_sdp_result (tBTA_DM_MSG *p_data)
         || (p_data->sdp_event.sdp_result == SDP_DB_FULL))
     {
         APPL_TRACE_DEBUG("sdp_result::0x%x", p_data->sdp_event.sdp_result);
+#if (defined BTA_DM_SDP_BATCH_SEARCH) && (BTA_DM_SDP_BATCH_SEARCH == TRUE)
+        /* one batched search answered for several services, split it back per service */
+        if (bta_dm_search_cb.sdp_batch_mask)
+        {
+            num_uuids = bta_dm_sdp_batch_result(uuid_list, sizeof(uuid_list) / MAX_UUID_SIZE,
+                                                p_data->sdp_event.sdp_result);
+        }
+        else
+#endif
         do
         {
 
@@ -1947,6 +1967,9 @@ void bta_dm_sdp_result (tBTA_DM_MSG *p_data)
 
             BTM_SecDeleteRmtNameNotifyCallback(&bta_dm_service_search_remname_cback);
 
+            APPL_TRACE_DEBUG("bta_dm_sdp_result services found with %d SDP transaction(s)",
+                              bta_dm_search_cb.sdp_transactions);
+
 
             if ((p_msg = (tBTA_DM_MSG *) GKI_getbuf(sizeof(tBTA_DM_MSG))) != NULL)
             {
@@ -2029,6 +2052,7 @@ void bta_dm_sdp_result (tBTA_DM_MSG *p_data)
         /* not able to connect go to next device */
         GKI_freebuf(bta_dm_search_cb.p_sdp_db);
         bta_dm_search_cb.p_sdp_db = NULL;
+        bta_dm_search_cb.sdp_batch_mask = 0;
 
         BTM_SecDeleteRmtNameNotifyCallback(&bta_dm_service_search_remname_cback);
 
@@ -2335,6 +2359,107 @@ void bta_dm_search_cancel_notify (tBTA_DM_MSG *p_data)
 
 }
 
+#if (defined BTA_DM_SDP_BATCH_SEARCH) && (BTA_DM_SDP_BATCH_SEARCH == TRUE)
+/*******************************************************************************
+**
+** Function         bta_dm_find_services_batched
+**
+** Description      Starts a single SDP search covering every remaining BR/EDR
+**                  service that is looked up by its 16-bit service class UUID.
+**
+**                  An SDP service search pattern matches records containing
+**                  ALL of its UUIDs, so the services can not simply be listed
+**                  in one pattern. Instead the search is made on the L2CAP
+**                  protocol UUID, which every BR/EDR record contains, and the
+**                  records are sorted back per service in bta_dm_sdp_result.
+**
+** Returns          TRUE if the batched search was started
+**
+*******************************************************************************/
+static BOOLEAN bta_dm_find_services_batched (BD_ADDR bd_addr)
+{
+    tSDP_UUID           uuid;
+    tBTA_SERVICE_MASK   batch_mask;
+
+    /* an earlier batch did not fit the SDP database */
+    if (bta_dm_search_cb.sdp_batch_off)
+        return FALSE;
+
+    batch_mask = bta_dm_sdp_batch_mask(bta_dm_search_cb.services, bta_dm_search_cb.services_to_search,
+                                       bta_dm_search_cb.service_index);
+    if (batch_mask == 0)
+        return FALSE;
+
+    if ((bta_dm_search_cb.p_sdp_db = (tSDP_DISCOVERY_DB *)GKI_getbuf(BTA_DM_SDP_DB_SIZE)) == NULL)
+    {
+        APPL_TRACE_ERROR("#### Failed to allocate SDP DB buffer! ####");
+        return FALSE;
+    }
+
+    memset (&uuid, 0, sizeof(tSDP_UUID));
+    uuid.len = LEN_UUID_16;
+    uuid.uu.uuid16 = UUID_PROTOCOL_L2CAP;
+
+    APPL_TRACE_DEBUG("bta_dm_find_services_batched: mask = %08x", batch_mask);
+
+    SDP_InitDiscoveryDb (bta_dm_search_cb.p_sdp_db, BTA_DM_SDP_DB_SIZE, 1, &uuid, 0, NULL);
+
+    memset(g_disc_raw_data_buf, 0, sizeof(g_disc_raw_data_buf));
+    bta_dm_search_cb.p_sdp_db->raw_data = g_disc_raw_data_buf;
+    bta_dm_search_cb.p_sdp_db->raw_size = MAX_DISC_RAW_DATA_BUF;
+
+    bta_dm_search_cb.services_to_search &= (tBTA_SERVICE_MASK)(~batch_mask);
+
+    if (!SDP_ServiceSearchAttributeRequest (bd_addr, bta_dm_search_cb.p_sdp_db, &bta_dm_sdp_callback))
+    {
+        /* if discovery not successful with this device
+        proceed to next one, same as for a single service search */
+        GKI_freebuf(bta_dm_search_cb.p_sdp_db);
+        bta_dm_search_cb.p_sdp_db = NULL;
+        bta_dm_search_cb.service_index = BTA_MAX_SERVICE_ID;
+        return FALSE;
+    }
+
+    bta_dm_search_cb.sdp_batch_mask = batch_mask;
+    bta_dm_search_cb.sdp_transactions++;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_batch_result
+**
+** Description      Sorts the records of a batched SDP search back per service,
+**                  updating services_found and the list of found UUIDs. If
+**                  the SDP database filled up, the services not found are
+**                  searched again one at a time.
+**
+** Returns          number of UUIDs added to uuid_list
+**
+*******************************************************************************/
+static UINT32 bta_dm_sdp_batch_result (UINT8 uuid_list[][MAX_UUID_SIZE], UINT32 max_uuids,
+                                       UINT16 sdp_result)
+{
+    tBTA_SERVICE_MASK   unsettled;
+    UINT32              num_uuids = 0;
+
+    unsettled = bta_dm_sdp_batch_split(bta_dm_search_cb.p_sdp_db, bta_dm_search_cb.sdp_batch_mask,
+                                       (BOOLEAN)(sdp_result == SDP_DB_FULL),
+                                       &bta_dm_search_cb.services_found,
+                                       uuid_list, max_uuids, &num_uuids);
+    if (unsettled)
+    {
+        APPL_TRACE_WARNING("bta_dm_sdp_batch_result: SDP database full, searching %08x singly",
+                            unsettled);
+        bta_dm_search_cb.services_to_search |= unsettled;
+        bta_dm_search_cb.sdp_batch_off = TRUE;
+    }
+
+    bta_dm_search_cb.sdp_batch_mask = 0;
+    return num_uuids;
+}
+#endif
+
 /*******************************************************************************
 **
 ** Function         bta_dm_find_services
@@ -2354,6 +2479,11 @@ static void bta_dm_find_services ( BD_ADDR bd_addr)
 
     memset (&uuid, 0, sizeof(tSDP_UUID));
 
+#if (defined BTA_DM_SDP_BATCH_SEARCH) && (BTA_DM_SDP_BATCH_SEARCH == TRUE)
+    if (bta_dm_find_services_batched(bd_addr))
+        return;
+#endif
+
     while(bta_dm_search_cb.service_index < BTA_MAX_SERVICE_ID)
     {
         if( bta_dm_search_cb.services_to_search
@@ -2448,6 +2578,7 @@ static void bta_dm_find_services ( BD_ADDR bd_addr)
                 }
                 else
                 {
+                    bta_dm_search_cb.sdp_transactions++;
 #if BLE_INCLUDED == TRUE && BTA_GATT_INCLUDED == TRUE
                     if ((bta_dm_search_cb.service_index == BTA_BLE_SERVICE_ID &&
                          bta_dm_search_cb.uuid_to_search == 0) ||
@@ -2603,6 +2734,9 @@ static void bta_dm_discover_device(BD_ADDR remote_bd_addr)
         bta_dm_search_cb.service_index      = 0;
         bta_dm_search_cb.services_found     = 0;
         bta_dm_search_cb.services_to_search = bta_dm_search_cb.services;
+        bta_dm_search_cb.sdp_batch_mask     = 0;
+        bta_dm_search_cb.sdp_batch_off      = FALSE;
+        bta_dm_search_cb.sdp_transactions   = 0;
 #if BLE_INCLUDED == TRUE && BTA_GATT_INCLUDED == TRUE
         bta_dm_search_cb.uuid_to_search     = bta_dm_search_cb.num_uuid;
 #endif
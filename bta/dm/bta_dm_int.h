@@ -1017,6 +1017,9 @@ typedef struct
     UINT8                  peer_scn;
     BOOLEAN                sdp_search;
     tBTA_TRANSPORT         transport;
+    tBTA_SERVICE_MASK      sdp_batch_mask;   /* services covered by the outstanding batched SDP search */
+    BOOLEAN                sdp_batch_off;    /* a batched search filled the SDP database, search singly */
+    UINT8                  sdp_transactions; /* number of SDP transactions issued for this discovery */
 #if ((defined BLE_INCLUDED) && (BLE_INCLUDED == TRUE))
     tBTA_DM_SEARCH_CBACK * p_scan_cback;
 #if ((defined BTA_GATT_INCLUDED) && (BTA_GATT_INCLUDED == TRUE))
@@ -1261,6 +1264,16 @@ extern void bta_dm_search_cancel_transac_cmpl(tBTA_DM_MSG *p_data);
 extern void bta_dm_disc_rmt_name (tBTA_DM_MSG *p_data);
 extern tBTA_DM_PEER_DEVICE * bta_dm_find_peer_device(BD_ADDR peer_addr);
 
+#if (defined BTA_DM_SDP_BATCH_SEARCH) && (BTA_DM_SDP_BATCH_SEARCH == TRUE)
+extern tBTA_SERVICE_MASK bta_dm_sdp_batch_mask(tBTA_SERVICE_MASK services,
+                                               tBTA_SERVICE_MASK services_to_search,
+                                               UINT8 start_index);
+extern tBTA_SERVICE_MASK bta_dm_sdp_batch_split(tSDP_DISCOVERY_DB *p_db, tBTA_SERVICE_MASK batch_mask,
+                                                BOOLEAN db_full, tBTA_SERVICE_MASK *p_found,
+                                                UINT8 uuid_list[][MAX_UUID_SIZE], UINT32 max_uuids,
+                                                UINT32 *p_num_uuids);
+#endif
+
 extern void bta_dm_ble_config_local_privacy (tBTA_DM_MSG *p_data);
 
 extern void bta_dm_pm_active(BD_ADDR peer_addr);
@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the planning of batched SDP service discovery: which
+ *  of the requested services one search can cover, and how its records are
+ *  sorted back per service.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_sys.h"
+#include "bta_api.h"
+#include "bta_dm_int.h"
+#include "sdp_api.h"
+
+#if (defined BTA_DM_SDP_BATCH_SEARCH) && (BTA_DM_SDP_BATCH_SEARCH == TRUE)
+
+extern const UINT16 bta_service_id_to_uuid_lkup_tbl [];
+extern void sdpu_uuid16_to_uuid128(UINT16 uuid16, UINT8* p_uuid128);
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_batch_mask
+**
+** Description      Selects the services of services_to_search, from service
+**                  index start_index on, that one SDP search can cover: the
+**                  BR/EDR services looked up by a 16-bit service class UUID.
+**                  PNP, GATT and user UUID searches keep their own search.
+**
+** Returns          The services to search together, 0 if batching does not
+**                  save a transaction
+**
+*******************************************************************************/
+tBTA_SERVICE_MASK bta_dm_sdp_batch_mask(tBTA_SERVICE_MASK services,
+                                        tBTA_SERVICE_MASK services_to_search,
+                                        UINT8 start_index)
+{
+    tBTA_SERVICE_MASK   batch_mask = 0;
+    UINT8               num_services = 0;
+    UINT8               xx;
+
+    /* a search for all services is already a single L2CAP based search */
+    if (services == BTA_ALL_SERVICE_MASK)
+        return 0;
+
+    for (xx = start_index; xx < BTA_MAX_SERVICE_ID; xx++)
+    {
+        if (xx == BTA_RES_SERVICE_ID || xx == BTA_USER_SERVICE_ID
+#if BLE_INCLUDED == TRUE && BTA_GATT_INCLUDED == TRUE
+            || xx == BTA_BLE_SERVICE_ID
+#endif
+            || bta_service_id_to_uuid_lkup_tbl[xx] == 0)
+            continue;
+
+        if (services_to_search & (tBTA_SERVICE_MASK)(BTA_SERVICE_ID_TO_SERVICE_MASK(xx)))
+        {
+            batch_mask |= (tBTA_SERVICE_MASK)(BTA_SERVICE_ID_TO_SERVICE_MASK(xx));
+            num_services++;
+        }
+    }
+
+    /* nothing to gain for a single service */
+    return (num_services < 2) ? 0 : batch_mask;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_batch_split
+**
+** Description      Sorts the records of a batched search back per service,
+**                  adding the services found to *p_found and their UUIDs to
+**                  uuid_list. If the database filled up, the records of the
+**                  services not found may have been cut off, so they are
+**                  not reported absent but returned to be searched again.
+**
+** Returns          The services the search did not settle
+**
+*******************************************************************************/
+tBTA_SERVICE_MASK bta_dm_sdp_batch_split(tSDP_DISCOVERY_DB *p_db, tBTA_SERVICE_MASK batch_mask,
+                                         BOOLEAN db_full, tBTA_SERVICE_MASK *p_found,
+                                         UINT8 uuid_list[][MAX_UUID_SIZE], UINT32 max_uuids,
+                                         UINT32 *p_num_uuids)
+{
+    tBTA_SERVICE_MASK   service_mask, unsettled = 0;
+    UINT16              service;
+    UINT8               xx;
+
+    for (xx = 0; xx < BTA_MAX_SERVICE_ID; xx++)
+    {
+        service_mask = (tBTA_SERVICE_MASK)(BTA_SERVICE_ID_TO_SERVICE_MASK(xx));
+        if ((batch_mask & service_mask) == 0)
+            continue;
+
+        service = bta_service_id_to_uuid_lkup_tbl[xx];
+        if (SDP_FindServiceInDb(p_db, service, NULL) != NULL)
+        {
+            *p_found |= service_mask;
+            if (*p_num_uuids < max_uuids)
+            {
+                sdpu_uuid16_to_uuid128(service, uuid_list[*p_num_uuids]);
+                (*p_num_uuids)++;
+            }
+        }
+        else if (db_full)
+        {
+            unsettled |= service_mask;
+        }
+    }
+
+    return unsettled;
+}
+
+#endif
@@ -63,7 +63,8 @@ static tGATT_CBACK bta_gattc_cl_cback =
     bta_gattc_disc_cmpl_cback,
     NULL,
     bta_gattc_enc_cmpl_cback,
-    bta_gattc_cong_cback
+    bta_gattc_cong_cback,
+    bta_gattc_disc_res_batch_cback
 };
 
 /* opcode(tGATTC_OPTYPE) order has to be comply with internal event order */
@@ -42,6 +42,9 @@ static tBTA_GATT_STATUS bta_gattc_sdp_service_disc(UINT16 conn_id, tBTA_GATTC_SE
 
 #define BTA_GATT_SDP_DB_SIZE 3750
 
+/* cache space taken by an attribute with a uuid_len bytes UUID */
+#define BTA_GATTC_CACHE_ATTR_LEN(uuid_len)  (sizeof(tBTA_GATTC_CACHE_ATTR) + (uuid_len))
+
 /*****************************************************************************
 **  Constants
 *****************************************************************************/
@@ -129,16 +132,22 @@ static void bta_gattc_display_explore_record(tBTA_GATTC_ATTR_REC *p_rec, UINT8 n
 **
 ** Function         bta_gattc_alloc_cache_buf
 **
-** Description      Allocate a GKI buffer for database cache.
+** Description      Allocate a GKI buffer for database cache.  The buffer is
+**                  sized for the bytes reserved with bta_gattc_reserve_cache_buf
+**                  when that is more than a cache pool buffer holds.
 **
 ** Returns          status
 **
 *******************************************************************************/
 BT_HDR *bta_gattc_alloc_cache_buf(tBTA_GATTC_SERV *p_srvc_cb)
 {
-    BT_HDR  *p_buf;
+    BT_HDR  *p_buf = NULL;
+
+    if (p_srvc_cb->reserve_byte > GKI_get_pool_bufsize(GATT_DB_POOL_ID))
+        p_buf = (BT_HDR *)GKI_getbuf(p_srvc_cb->reserve_byte);
+    p_srvc_cb->reserve_byte = 0;
 
-    if ((p_buf = (BT_HDR *)GKI_getpoolbuf(GATT_DB_POOL_ID)) == NULL)
+    if (p_buf == NULL && (p_buf = (BT_HDR *)GKI_getpoolbuf(GATT_DB_POOL_ID)) == NULL)
     {
         APPL_TRACE_DEBUG("No resources: GKI buffer allocation failed.");
         utl_freebuf((void **)&p_srvc_cb->p_srvc_list);
@@ -160,6 +169,30 @@ BT_HDR *bta_gattc_alloc_cache_buf(tBTA_GATTC_SERV *p_srvc_cb)
 }
 /*******************************************************************************
 **
+** Function         bta_gattc_reserve_cache_buf
+**
+** Description      Announce that about len bytes of attributes are going to
+**                  be added to the cache.  What does not fit in the current
+**                  buffer goes into one buffer of the right size, instead of
+**                  a chain of small pool buffers.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void bta_gattc_reserve_cache_buf(tBTA_GATTC_SERV *p_srvc_cb, UINT32 len)
+{
+    if (len <= p_srvc_cb->free_byte)
+        return;
+
+    len -= p_srvc_cb->free_byte;
+    if (len > BTA_GATTC_CACHE_BUF_MAX)
+        len = BTA_GATTC_CACHE_BUF_MAX;
+
+    if (len > p_srvc_cb->reserve_byte)
+        p_srvc_cb->reserve_byte = (UINT16)len;
+}
+/*******************************************************************************
+**
 ** Function         bta_gattc_init_cache
 **
 ** Description      Initialize the database cache and discovery related resources.
@@ -175,6 +208,7 @@ tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb)
         GKI_freebuf (GKI_dequeue (&p_srvc_cb->cache_buffer));
 
     utl_freebuf((void **)&p_srvc_cb->p_srvc_list);
+    p_srvc_cb->reserve_byte = 0;
 
     if ((p_srvc_cb->p_srvc_list = (tBTA_GATTC_ATTR_REC*)GKI_getbuf(BTA_GATTC_ATTR_LIST_SIZE)) == NULL)
     {
@@ -642,6 +676,35 @@ static void bta_gattc_incl_srvc_disc_cmpl(UINT16 conn_id, tBTA_GATTC_SERV *p_srv
 }
 /*******************************************************************************
 **
+** Function         bta_gattc_char_cache_len
+**
+** Description      Estimate the cache space taken by the characteristics just
+**                  discovered and their descriptors.  The descriptors of a
+**                  characteristic fill the handles up to the next
+**                  declaration, so the handle range bounds their number.
+**
+** Returns          number of bytes
+**
+*******************************************************************************/
+static UINT32 bta_gattc_char_cache_len(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    tBTA_GATTC_ATTR_REC *p_rec = p_srvc_cb->p_srvc_list + p_srvc_cb->cur_char_idx;
+    UINT32  len = 0;
+    UINT16  num_dscp, i;
+
+    for (i = 0; i < p_srvc_cb->total_char; i ++, p_rec ++)
+    {
+        num_dscp = p_rec->e_handle - p_rec->s_handle;
+        if (num_dscp > BTA_GATTC_CACHE_DSCP_MAX)
+            num_dscp = BTA_GATTC_CACHE_DSCP_MAX;
+
+        len += BTA_GATTC_CACHE_ATTR_LEN(p_rec->uuid.len) +
+               num_dscp * BTA_GATTC_CACHE_ATTR_LEN(LEN_UUID_16);
+    }
+    return len;
+}
+/*******************************************************************************
+**
 ** Function         bta_gattc_char_disc_cmpl
 **
 ** Description      process the characteristic discovery complete event
@@ -656,6 +719,9 @@ static void bta_gattc_char_disc_cmpl(UINT16 conn_id, tBTA_GATTC_SERV *p_srvc_cb)
     /* if there are characteristic needs to be explored */
     if (p_srvc_cb->total_char > 0)
     {
+        /* make room for the characteristics and their descriptors */
+        bta_gattc_reserve_cache_buf(p_srvc_cb, bta_gattc_char_cache_len(p_srvc_cb));
+
         /* add the first characteristic into cache */
         bta_gattc_add_attr_to_cache (p_srvc_cb,
                                      p_rec->s_handle,
@@ -952,7 +1018,78 @@ static tBTA_GATT_STATUS bta_gattc_sdp_service_disc(UINT16 conn_id, tBTA_GATTC_SE
 }
 /*******************************************************************************
 **
+** Function         bta_gattc_proc_disc_res
+**
+** Description      Add one discovery result to the explore list or the cache.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_gattc_proc_disc_res(tBTA_GATTC_SERV *p_srvc_cb, tGATT_DISC_TYPE disc_type,
+                                    tGATT_DISC_RES *p_data)
+{
+    BOOLEAN          pri_srvc;
+
+    switch (disc_type)
+    {
+        case GATT_DISC_SRVC_ALL:
+            /* discover services result, add services into a service list */
+            bta_gattc_add_srvc_to_list(p_srvc_cb,
+                                       p_data->handle,
+                                       p_data->value.group_value.e_handle,
+                                       p_data->value.group_value.service_type,
+                                       TRUE);
+
+            break;
+        case GATT_DISC_SRVC_BY_UUID:
+            bta_gattc_add_srvc_to_list(p_srvc_cb,
+                                       p_data->handle,
+                                       p_data->value.group_value.e_handle,
+                                       p_data->value.group_value.service_type,
+                                       TRUE);
+            break;
+
+        case GATT_DISC_INC_SRVC:
+            /* add included service into service list if it's secondary or it never showed up
+               in the primary service search */
+            pri_srvc = bta_gattc_srvc_in_list(p_srvc_cb,
+                                              p_data->value.incl_service.s_handle,
+                                              p_data->value.incl_service.e_handle,
+                                              p_data->value.incl_service.service_type);
+
+            if (!pri_srvc)
+                bta_gattc_add_srvc_to_list(p_srvc_cb,
+                                           p_data->value.incl_service.s_handle,
+                                           p_data->value.incl_service.e_handle,
+                                           p_data->value.incl_service.service_type,
+                                           FALSE);
+            /* add into database */
+            bta_gattc_add_attr_to_cache(p_srvc_cb,
+                                        p_data->handle,
+                                        &p_data->value.incl_service.service_type,
+                                        pri_srvc,
+                                        BTA_GATTC_ATTR_TYPE_INCL_SRVC);
+            break;
+
+        case GATT_DISC_CHAR:
+            /* add char value into database */
+            bta_gattc_add_char_to_list(p_srvc_cb,
+                                       p_data->handle,
+                                       p_data->value.dclr_value.val_handle,
+                                       p_data->value.dclr_value.char_uuid,
+                                       p_data->value.dclr_value.char_prop);
+            break;
+
+        case GATT_DISC_CHAR_DSCPT:
+            bta_gattc_add_attr_to_cache(p_srvc_cb, p_data->handle, &p_data->type, 0,
+                                        BTA_GATTC_ATTR_TYPE_CHAR_DESCR);
+            break;
+    }
+}
+/*******************************************************************************
+**
 ** Function         bta_gattc_disc_res_cback
+**                  bta_gattc_disc_res_batch_cback
 **                  bta_gattc_disc_cmpl_cback
 **
 ** Description      callback functions to GATT client stack.
@@ -963,69 +1100,42 @@ static tBTA_GATT_STATUS bta_gattc_sdp_service_disc(UINT16 conn_id, tBTA_GATTC_SE
 void bta_gattc_disc_res_cback (UINT16 conn_id, tGATT_DISC_TYPE disc_type, tGATT_DISC_RES *p_data)
 {
     tBTA_GATTC_SERV * p_srvc_cb = NULL;
-    BOOLEAN          pri_srvc;
     tBTA_GATTC_CLCB *p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
 
     p_srvc_cb = bta_gattc_find_scb_by_cid(conn_id);
 
     if (p_srvc_cb != NULL && p_clcb != NULL && p_clcb->state == BTA_GATTC_DISCOVER_ST)
-    {
-        switch (disc_type)
-        {
-            case GATT_DISC_SRVC_ALL:
-                /* discover services result, add services into a service list */
-                bta_gattc_add_srvc_to_list(p_srvc_cb,
-                                           p_data->handle,
-                                           p_data->value.group_value.e_handle,
-                                           p_data->value.group_value.service_type,
-                                           TRUE);
-
-                break;
-            case GATT_DISC_SRVC_BY_UUID:
-                bta_gattc_add_srvc_to_list(p_srvc_cb,
-                                           p_data->handle,
-                                           p_data->value.group_value.e_handle,
-                                           p_data->value.group_value.service_type,
-                                           TRUE);
-                break;
+        bta_gattc_proc_disc_res(p_srvc_cb, disc_type, p_data);
+}
+void bta_gattc_disc_res_batch_cback (UINT16 conn_id, tGATT_DISC_TYPE disc_type,
+                                     UINT16 num_res, tGATT_DISC_RES *p_data)
+{
+    tBTA_GATTC_SERV * p_srvc_cb = NULL;
+    tBTA_GATTC_CLCB *p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+    UINT32          len = 0;
+    UINT16          i;
 
-            case GATT_DISC_INC_SRVC:
-                /* add included service into service list if it's secondary or it never showed up
-                   in the primary service search */
-                pri_srvc = bta_gattc_srvc_in_list(p_srvc_cb,
-                                                  p_data->value.incl_service.s_handle,
-                                                  p_data->value.incl_service.e_handle,
-                                                  p_data->value.incl_service.service_type);
-
-                if (!pri_srvc)
-                    bta_gattc_add_srvc_to_list(p_srvc_cb,
-                                               p_data->value.incl_service.s_handle,
-                                               p_data->value.incl_service.e_handle,
-                                               p_data->value.incl_service.service_type,
-                                               FALSE);
-                /* add into database */
-                bta_gattc_add_attr_to_cache(p_srvc_cb,
-                                            p_data->handle,
-                                            &p_data->value.incl_service.service_type,
-                                            pri_srvc,
-                                            BTA_GATTC_ATTR_TYPE_INCL_SRVC);
-                break;
+    p_srvc_cb = bta_gattc_find_scb_by_cid(conn_id);
 
-            case GATT_DISC_CHAR:
-                /* add char value into database */
-                bta_gattc_add_char_to_list(p_srvc_cb,
-                                           p_data->handle,
-                                           p_data->value.dclr_value.val_handle,
-                                           p_data->value.dclr_value.char_uuid,
-                                           p_data->value.dclr_value.char_prop);
-                break;
+    if (p_srvc_cb == NULL || p_clcb == NULL || p_clcb->state != BTA_GATTC_DISCOVER_ST)
+        return;
 
-            case GATT_DISC_CHAR_DSCPT:
-                bta_gattc_add_attr_to_cache(p_srvc_cb, p_data->handle, &p_data->type, 0,
-                                            BTA_GATTC_ATTR_TYPE_CHAR_DESCR);
-                break;
+    /* included services and descriptors go straight into the cache, make
+       room for the whole batch */
+    if (disc_type == GATT_DISC_INC_SRVC || disc_type == GATT_DISC_CHAR_DSCPT)
+    {
+        for (i = 0; i < num_res; i ++)
+        {
+            if (disc_type == GATT_DISC_INC_SRVC)
+                len += BTA_GATTC_CACHE_ATTR_LEN(p_data[i].value.incl_service.service_type.len);
+            else
+                len += BTA_GATTC_CACHE_ATTR_LEN(p_data[i].type.len);
         }
+        bta_gattc_reserve_cache_buf(p_srvc_cb, len);
     }
+
+    for (i = 0; i < num_res; i ++)
+        bta_gattc_proc_disc_res(p_srvc_cb, disc_type, &p_data[i]);
 }
 void bta_gattc_disc_cmpl_cback (UINT16 conn_id, tGATT_DISC_TYPE disc_type, tGATT_STATUS status)
 {
@@ -1509,6 +1619,18 @@ tBTA_GATT_STATUS bta_gattc_query_cache(UINT16 conn_id,
 void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
                              tBTA_GATTC_NV_ATTR *p_attr, UINT16 attr_index)
 {
+    UINT32  len = 0;
+    UINT16  i;
+
+    /* the size of this block is known, load it into as few buffers as possible */
+    for (i = 0; p_attr != NULL && i < num_attr; i ++)
+    {
+        if (p_attr[i].attr_type == BTA_GATTC_ATTR_TYPE_SRVC)
+            len += sizeof(tBTA_GATTC_CACHE);
+        else
+            len += BTA_GATTC_CACHE_ATTR_LEN(p_attr[i].uuid.len);
+    }
+
     /* first attribute loading, initialize buffer */
     APPL_TRACE_ERROR("bta_gattc_rebuild_cache");
     if (attr_index == 0)
@@ -1516,6 +1638,9 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
         while (p_srvc_cb->cache_buffer.p_first)
             GKI_freebuf (GKI_dequeue (&p_srvc_cb->cache_buffer));
 
+        p_srvc_cb->free_byte = p_srvc_cb->reserve_byte = 0;
+        bta_gattc_reserve_cache_buf(p_srvc_cb, len);
+
         if (bta_gattc_alloc_cache_buf(p_srvc_cb) == NULL)
         {
             APPL_TRACE_ERROR("allocate cache buffer failed, no resources");
@@ -1525,6 +1650,10 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
             p_srvc_cb->p_cur_srvc = p_srvc_cb->p_srvc_cache = NULL;
         }
     }
+    else
+    {
+        bta_gattc_reserve_cache_buf(p_srvc_cb, len);
+    }
 
     while (num_attr > 0 && p_attr != NULL)
     {
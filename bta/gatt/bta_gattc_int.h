@@ -296,6 +296,18 @@ typedef struct
 #define BTA_GATTC_MAX_CACHE_CHAR    40
 #define BTA_GATTC_ATTR_LIST_SIZE    (BTA_GATTC_MAX_CACHE_CHAR * sizeof(tBTA_GATTC_ATTR_REC))
 
+/* largest cache buffer allocated at once for a block of attributes whose size
+** is known up front */
+#ifndef BTA_GATTC_CACHE_BUF_MAX
+#define BTA_GATTC_CACHE_BUF_MAX     GKI_MAX_BUF_SIZE
+#endif
+
+/* most descriptors per characteristic that cache space is reserved for before
+** the descriptors are discovered */
+#ifndef BTA_GATTC_CACHE_DSCP_MAX
+#define BTA_GATTC_CACHE_DSCP_MAX    8
+#endif
+
 #ifndef BTA_GATTC_CACHE_SRVR_SIZE
     #define BTA_GATTC_CACHE_SRVR_SIZE   600
 #endif
@@ -328,6 +340,7 @@ typedef struct
     BUFFER_Q            cache_buffer;   /* buffer queue used for storing the cache data */
     UINT8               *p_free;        /* starting point to next available byte */
     UINT16              free_byte;      /* number of available bytes in server cache buffer */
+    UINT16              reserve_byte;   /* bytes about to be added beyond free_byte, sizes the next cache buffer */
     UINT8               update_count;   /* indication received */
     UINT8               num_clcb;       /* number of associated CLCB */
 
@@ -542,6 +555,8 @@ extern void bta_gattc_cpygattid(tBTA_GATT_ID *p_des, tBTA_GATT_ID *p_src);
 
 /* discovery functions */
 extern void bta_gattc_disc_res_cback (UINT16 conn_id, tGATT_DISC_TYPE disc_type, tGATT_DISC_RES *p_data);
+extern void bta_gattc_disc_res_batch_cback (UINT16 conn_id, tGATT_DISC_TYPE disc_type,
+                                            UINT16 num_res, tGATT_DISC_RES *p_data);
 extern void bta_gattc_disc_cmpl_cback (UINT16 conn_id, tGATT_DISC_TYPE disc_type, tGATT_STATUS status);
 extern tBTA_GATT_STATUS bta_gattc_discover_procedure(UINT16 conn_id, tBTA_GATTC_SERV *p_server_cb, UINT8 disc_type);
 extern tBTA_GATT_STATUS bta_gattc_discover_pri_service(UINT16 conn_id, tBTA_GATTC_SERV *p_server_cb, UINT8 disc_type);
@@ -693,6 +693,59 @@ void bta_gatts_indicate_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
     }
 }
 
+/*******************************************************************************
+**
+** Function         bta_gatts_notify_multi_handle
+**
+** Description      GATTS send one handle value notification to several
+**                  connections, reporting the per link status to the owner.
+**
+** Returns          none.
+**
+*******************************************************************************/
+void bta_gatts_notify_multi_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
+{
+    tBTA_GATTS_API_NOTIFY_MULTI *p_notify = &p_msg->api_notify_multi;
+    tBTA_GATTS_SRVC_CB  *p_srvc_cb;
+    tBTA_GATTS_RCB      *p_rcb;
+    tGATT_STATUS        status[GATT_MAX_PHY_CHANNEL];
+    tGATT_IF            gatt_if;
+    BD_ADDR             remote_bda;
+    tBTA_TRANSPORT      transport;
+    tBTA_GATTS          cb_data;
+    UINT8               i;
+
+    if ((p_srvc_cb = bta_gatts_find_srvc_cb_by_attr_id (p_cb, p_notify->attr_id)) == NULL)
+    {
+        APPL_TRACE_ERROR("Not an registered servce attribute ID: 0x%04x", p_notify->attr_id);
+        return;
+    }
+
+    GATTS_HandleValueNotifyMulti(p_notify->num_conn, p_notify->conn_id, p_notify->attr_id,
+                                 p_notify->len, p_notify->value, status);
+
+    p_rcb = &p_cb->rcb[p_srvc_cb->rcb_idx];
+
+    for (i = 0; i < p_notify->num_conn; i ++)
+    {
+        /* if over BR_EDR, inform PM for mode change */
+        if (GATT_GetConnectionInfor(p_notify->conn_id[i], &gatt_if, remote_bda, &transport) &&
+            transport == BTA_TRANSPORT_BR_EDR)
+        {
+            bta_sys_busy(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+            bta_sys_idle(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+        }
+
+        if (p_rcb->in_use && p_rcb->p_cback)
+        {
+            cb_data.req_data.status = status[i];
+            cb_data.req_data.conn_id = p_notify->conn_id[i];
+
+            (*p_rcb->p_cback)(BTA_GATTS_CONF_EVT, &cb_data);
+        }
+    }
+}
+
 
 /*******************************************************************************
 **
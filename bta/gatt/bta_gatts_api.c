@@ -408,6 +408,55 @@ void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id, UINT16 dat
     }
     return;
 
+}
+
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueNotifyMulti
+**
+** Description      This function is called to send one notification to several
+**                  connections with a single message.
+**
+** Parameters       num_conn - number of connections in p_conn_id.
+**                  p_conn_id - connection identifiers.
+**                  attr_id - attribute ID to notify.
+**                  data_len - notification data length.
+**                  p_data: data to notify.
+**
+** Returns          None
+**
+*******************************************************************************/
+void BTA_GATTS_HandleValueNotifyMulti (UINT8 num_conn, UINT16 *p_conn_id, UINT16 attr_id,
+                                       UINT16 data_len, UINT8 *p_data)
+{
+    tBTA_GATTS_API_NOTIFY_MULTI  *p_buf;
+    UINT16  len = sizeof(tBTA_GATTS_API_NOTIFY_MULTI);
+
+    if (num_conn == 0 || num_conn > GATT_MAX_PHY_CHANNEL || p_conn_id == NULL ||
+        data_len > BTA_GATT_MAX_ATTR_LEN)
+    {
+        APPL_TRACE_ERROR("BTA_GATTS_HandleValueNotifyMulti: illegal parameter num_conn=%d len=%d",
+                          num_conn, data_len);
+        return;
+    }
+
+    if ((p_buf = (tBTA_GATTS_API_NOTIFY_MULTI *) GKI_getbuf(len)) != NULL)
+    {
+        p_buf->hdr.event = BTA_GATTS_API_NOTIFY_MULTI_EVT;
+        p_buf->attr_id = attr_id;
+        p_buf->num_conn = num_conn;
+        memcpy(p_buf->conn_id, p_conn_id, num_conn * sizeof(UINT16));
+        p_buf->len = 0;
+
+        if (data_len > 0 && p_data != NULL)
+        {
+            p_buf->len = data_len;
+            memcpy(p_buf->value, p_data, data_len);
+        }
+        bta_sys_sendmsg(p_buf);
+    }
+    return;
+
 }
 /*******************************************************************************
 **
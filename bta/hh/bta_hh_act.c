@@ -47,6 +47,7 @@
 static void bta_hh_cback (UINT8 dev_handle, BD_ADDR addr, UINT8 event,
                             UINT32 data, BT_HDR *pdata);
 static tBTA_HH_STATUS bta_hh_get_trans_status(UINT32 result);
+static BOOLEAN bta_hh_intr_data_direct(tBTA_HH_DEV_CB *p_cb, BT_HDR *pdata, UINT64 rx_time_us);
 
 #if BTA_HH_DEBUG
 static char* bta_hh_get_w4_event(UINT16 event);
@@ -682,6 +683,7 @@ void bta_hh_data_act(tBTA_HH_DEV_CB *p_cb, tBTA_HH_DATA * p_data)
                     p_cb->mode, p_cb->sub_class, p_cb->dscp_info.ctry_code, p_cb->addr, p_cb->app_id);
 
     utl_freebuf((void **)&pdata);
+    bta_hh_update_input_latency(p_cb->input_lat.queued, p_data->hid_cback.rx_time_us);
 }
 
 
@@ -926,6 +928,7 @@ void bta_hh_close_act (tBTA_HH_DEV_CB *p_cb, tBTA_HH_DATA *p_data)
     /* otherwise report CLOSE/VC_UNPLUG event */
     else
     {
+        bta_hh_dump_input_latency(p_cb);
         /* finalize device driver */
         bta_hh_co_close(p_cb->hid_handle, p_cb->app_id);
         /* inform role manager */
@@ -1217,8 +1220,10 @@ static void bta_hh_cback (UINT8 dev_handle, BD_ADDR addr, UINT8 event,
                         UINT32 data, BT_HDR *pdata)
 {
     tBTA_HH_CBACK_DATA    *p_buf = NULL;
+    tBTA_HH_DEV_CB        *p_cb = NULL;
     UINT16  sm_event = BTA_HH_INVALID_EVT;
     UINT8   xx = 0;
+    UINT64  rx_time_us = 0;
 
 #if BTA_HH_DEBUG
     APPL_TRACE_DEBUG("bta_hh_cback::HID_event [%s]", bta_hh_hid_event_name(event));
@@ -1234,6 +1239,14 @@ static void bta_hh_cback (UINT8 dev_handle, BD_ADDR addr, UINT8 event,
         break;
     case HID_HDEV_EVT_INTR_DATA:
         sm_event = BTA_HH_INT_DATA_EVT;
+        rx_time_us = GKI_now_us();
+        xx = bta_hh_dev_handle_to_cb_idx(dev_handle);
+        if (xx < BTA_HH_MAX_DEVICE)
+        {
+            p_cb = &bta_hh_cb.kdev[xx];
+            if (bta_hh_intr_data_direct(p_cb, pdata, rx_time_us))
+                return;
+        }
         break;
     case HID_HDEV_EVT_HANDSHAKE:
         sm_event = BTA_HH_INT_HANDSK_EVT;
@@ -1283,11 +1296,43 @@ static void bta_hh_cback (UINT8 dev_handle, BD_ADDR addr, UINT8 event,
         p_buf->data       = data;
         bdcpy(p_buf->addr, addr);
         p_buf->p_data     = pdata;
+        p_buf->rx_time_us = rx_time_us;
+
+        if (sm_event == BTA_HH_INT_DATA_EVT && p_cb != NULL)
+            p_cb->intr_data_queued++;
 
         bta_sys_sendmsg(p_buf);
     }
 
 }
+
+/*******************************************************************************
+**
+** Function         bta_hh_intr_data_direct
+**
+** Description      Input report fast path. The HID host callback runs in the
+**                  same task as the BTA state machine, so a report for a
+**                  connected device can be written to the platform driver
+**                  right away instead of making a trip through the BTA
+**                  mailbox. Reports still queued for the device are
+**                  delivered first to keep them in order.
+**
+** Returns          TRUE if the report was delivered and its buffer freed.
+**
+*******************************************************************************/
+static BOOLEAN bta_hh_intr_data_direct(tBTA_HH_DEV_CB *p_cb, BT_HDR *pdata, UINT64 rx_time_us)
+{
+    if (pdata == NULL || p_cb->state != BTA_HH_CONN_ST || p_cb->intr_data_queued)
+        return FALSE;
+
+    bta_hh_co_data(p_cb->hid_handle, (UINT8 *)(pdata + 1) + pdata->offset, pdata->len,
+                   p_cb->mode, p_cb->sub_class, p_cb->dscp_info.ctry_code, p_cb->addr,
+                   p_cb->app_id);
+
+    GKI_freebuf(pdata);
+    bta_hh_update_input_latency(p_cb->input_lat.direct, rx_time_us);
+    return TRUE;
+}
 /*******************************************************************************
 **
 ** Function         bta_hh_get_trans_status
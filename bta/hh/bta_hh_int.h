@@ -140,8 +140,21 @@ typedef struct
     BD_ADDR         addr;
     UINT32          data;
     BT_HDR          *p_data;
+    UINT64          rx_time_us;     /* when an interrupt channel report arrived */
 }tBTA_HH_CBACK_DATA;
 
+/* Input report latency, from the HID host callback to the report being
+** written to the platform driver. Bucket 0 counts reports delivered within
+** 1 us, bucket n those taking [2^(n-1), 2^n) us; the last bucket is open.
+*/
+#define BTA_HH_LAT_BUCKETS      16
+
+typedef struct
+{
+    UINT32          direct[BTA_HH_LAT_BUCKETS];  /* delivered from the HID callback */
+    UINT32          queued[BTA_HH_LAT_BUCKETS];  /* delivered through the state machine */
+} tBTA_HH_LAT_HIST;
+
 typedef struct
 {
     BT_HDR              hdr;
@@ -284,6 +297,8 @@ typedef struct
 #endif
 
     BOOLEAN             security_pending;
+    UINT8               intr_data_queued;   /* interrupt reports waiting in the BTA mailbox */
+    tBTA_HH_LAT_HIST    input_lat;
 } tBTA_HH_DEV_CB;
 
 /* key board parsing control block */
@@ -371,6 +386,8 @@ extern void bta_hh_update_di_info(tBTA_HH_DEV_CB *p_cb, UINT16 vendor_id, UINT16
 extern void bta_hh_cleanup_disable(tBTA_HH_STATUS status);
 
 extern UINT8 bta_hh_dev_handle_to_cb_idx(UINT8 dev_handle);
+extern void bta_hh_update_input_latency(UINT32 *p_hist, UINT64 rx_time_us);
+extern void bta_hh_dump_input_latency(tBTA_HH_DEV_CB *p_cb);
 
 /* action functions used outside state machine */
 extern void bta_hh_api_enable(tBTA_HH_DATA *p_data);
@@ -495,6 +495,10 @@ BOOLEAN bta_hh_hdl_event(BT_HDR *p_msg)
             if ((index != BTA_HH_IDX_INVALID)  && (index < BTA_HH_MAX_DEVICE))
                 p_cb = &bta_hh_cb.kdev[index];
 
+            /* Lets bta_hh_cback deliver reports directly again once drained */
+            if (p_msg->event == BTA_HH_INT_DATA_EVT && p_cb != NULL && p_cb->intr_data_queued)
+                p_cb->intr_data_queued--;
+
 #if BTA_HH_DEBUG
             APPL_TRACE_DEBUG("bta_hh_hdl_event:: handle = %d dev_cb[%d] ", p_msg->layer_specific, index);
 #endif
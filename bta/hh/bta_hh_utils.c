@@ -556,6 +556,60 @@ UINT8 bta_hh_dev_handle_to_cb_idx(UINT8 dev_handle)
     return index;
 
 }
+/*******************************************************************************
+**
+** Function         bta_hh_update_input_latency
+**
+** Description      Count one delivered input report in a latency histogram.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_hh_update_input_latency(UINT32 *p_hist, UINT64 rx_time_us)
+{
+    UINT64  lat_us;
+    UINT8   bucket = 0;
+
+    if (rx_time_us == 0)
+        return;
+
+    lat_us = GKI_now_us() - rx_time_us;
+    while (lat_us && bucket < BTA_HH_LAT_BUCKETS - 1)
+    {
+        lat_us >>= 1;
+        bucket ++;
+    }
+    p_hist[bucket] ++;
+}
+
+/*******************************************************************************
+**
+** Function         bta_hh_dump_input_latency
+**
+** Description      Trace the input report latency histograms of a device and
+**                  reset them.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_hh_dump_input_latency(tBTA_HH_DEV_CB *p_cb)
+{
+    UINT8   xx;
+
+    APPL_TRACE_DEBUG("HID input latency, handle %d: bucket < us: direct queued", p_cb->hid_handle);
+    for (xx = 0; xx < BTA_HH_LAT_BUCKETS; xx ++)
+    {
+        if (p_cb->input_lat.direct[xx] || p_cb->input_lat.queued[xx])
+        {
+            APPL_TRACE_DEBUG("  %2s%6lu: %8lu %8lu", (xx == BTA_HH_LAT_BUCKETS - 1) ? ">=" : "<",
+                             (xx == BTA_HH_LAT_BUCKETS - 1) ? (1UL << (xx - 1)) : (1UL << xx),
+                             (unsigned long)p_cb->input_lat.direct[xx],
+                             (unsigned long)p_cb->input_lat.queued[xx]);
+        }
+    }
+    memset(&p_cb->input_lat, 0, sizeof(tBTA_HH_LAT_HIST));
+}
+
 #if BTA_HH_DEBUG
 /*******************************************************************************
 **
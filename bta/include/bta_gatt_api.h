@@ -1335,6 +1335,27 @@ BTA_API extern void BTA_GATTC_ConfigureMTU (UINT16 conn_id, UINT16 mtu);
                                                          UINT8 *p_data,
                                                          BOOLEAN need_confirm);
 
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueNotifyMulti
+**
+** Description      This function is called to send one notification to several
+**                  connections. A BTA_GATTS_CONF_EVT carrying the per link
+**                  status is reported for each connection.
+**
+** Parameters       num_conn - number of connections in p_conn_id.
+**                  p_conn_id - connection identifiers.
+**                  attr_id - attribute ID to notify.
+**                  data_len - notification data length.
+**                  p_data: data to notify.
+**
+** Returns          None
+**
+*******************************************************************************/
+    BTA_API extern void BTA_GATTS_HandleValueNotifyMulti (UINT8 num_conn, UINT16 *p_conn_id,
+                                                          UINT16 attr_id, UINT16 data_len,
+                                                          UINT8 *p_data);
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_SendRsp
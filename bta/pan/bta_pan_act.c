@@ -738,12 +738,13 @@ void bta_pan_write_buf(tBTA_PAN_SCB *p_scb, tBTA_PAN_DATA *p_data)
     {
         bta_pan_pm_conn_busy(p_scb);
 
-        PAN_WriteBuf (p_scb->handle,
-                      ((tBTA_PAN_DATA_PARAMS *)p_data)->dst,
-                      ((tBTA_PAN_DATA_PARAMS *)p_data)->src,
-                      ((tBTA_PAN_DATA_PARAMS *)p_data)->protocol,
-                      (BT_HDR *)p_data,
-                      ((tBTA_PAN_DATA_PARAMS *)p_data)->ext);
+        if (PAN_WriteBuf (p_scb->handle,
+                          ((tBTA_PAN_DATA_PARAMS *)p_data)->dst,
+                          ((tBTA_PAN_DATA_PARAMS *)p_data)->src,
+                          ((tBTA_PAN_DATA_PARAMS *)p_data)->protocol,
+                          (BT_HDR *)p_data,
+                          ((tBTA_PAN_DATA_PARAMS *)p_data)->ext) == PAN_Q_SIZE_EXCEEDED)
+            GKI_freebuf(p_data);
         bta_pan_pm_conn_idle(p_scb);
 
     }
@@ -0,0 +1,181 @@
+// Stubs for the stack and system calls of bta_dm_act.c that the tests do not
+// exercise. Calls the tests drive are faked in the test files.
+
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_api.h"
+#include "bta_sys.h"
+#include "bta_dm_int.h"
+#include "bta_dm_ci.h"
+#include "bta_dm_co.h"
+#include "bta_gatt_api.h"
+#include "btm_api.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "gap_api.h"
+#include "gki.h"
+#include "l2c_api.h"
+#include "sdp_api.h"
+#include "utl.h"
+
+tBTA_DM_CB bta_dm_cb;
+tBTA_DM_SEARCH_CB bta_dm_search_cb;
+tBTA_DM_DI_CB bta_dm_di_cb;
+tBTA_DM_CONNECTED_SRVCS bta_dm_conn_srvcs;
+tBTM_CB btm_cb;
+const tBTA_DM_CFG bta_dm_cfg = { 0 };
+const tBTA_DM_EIR_CONF bta_dm_eir_cfg = { 0 };
+tBTA_DM_CFG *p_bta_dm_cfg = (tBTA_DM_CFG *)&bta_dm_cfg;
+tBTA_DM_RM *p_bta_dm_rm_cfg;
+tBTA_DM_EIR_CONF *p_bta_dm_eir_cfg = (tBTA_DM_EIR_CONF *)&bta_dm_eir_cfg;
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+const BD_ADDR BT_BD_ANY = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+tBTA_STATUS BTA_DmGetDiRecord(UINT8, tBTA_DI_GET_RECORD *, tBTA_DISCOVERY_DB *) { return 0; }
+void BTA_GATTC_AppRegister(tBT_UUID *, tBTA_GATTC_CBACK (*)) {}
+void BTA_GATTC_CancelOpen(tBTA_GATTC_IF, UINT8 *, BOOLEAN) {}
+void BTA_GATTC_Close(UINT16) {}
+void BTA_GATTC_Open(tBTA_GATTC_IF, UINT8 *, BOOLEAN, tBTA_GATT_TRANSPORT) {}
+void BTA_GATTC_Refresh(UINT8 *) {}
+void BTA_GATTC_ServiceSearchRequest(UINT16, tBT_UUID *) {}
+void BTM_AddEirService(UINT32 *, UINT16) {}
+tBTM_STATUS BTM_BleAdvFilterParamSetup(int, tBTM_BLE_PF_FILT_INDEX, tBTM_BLE_PF_FILT_PARAMS *, tBLE_BD_ADDR *, tBTM_BLE_PF_PARAM_CBACK (*), tBTM_BLE_REF_VALUE) { return 0; }
+tBTM_STATUS BTM_BleBroadcast(BOOLEAN) { return 0; }
+tBTM_STATUS BTM_BleCfgAdvInstData(UINT8, BOOLEAN, tBTM_BLE_AD_MASK, tBTM_BLE_ADV_DATA *) { return 0; }
+tBTM_STATUS BTM_BleCfgFilterCondition(tBTM_BLE_SCAN_COND_OP, tBTM_BLE_PF_COND_TYPE, tBTM_BLE_PF_FILT_INDEX, tBTM_BLE_PF_COND_PARAM *, tBTM_BLE_PF_CFG_CBACK (*), tBTM_BLE_REF_VALUE) { return 0; }
+void BTM_BleClearBgConnDev(void) {}
+void BTM_BleConfigPrivacy(BOOLEAN) {}
+tBTM_STATUS BTM_BleDisableAdvInstance(UINT8) { return 0; }
+tBTM_STATUS BTM_BleDisableBatchScan(tBTM_BLE_REF_VALUE) { return 0; }
+tBTM_STATUS BTM_BleEnableAdvInstance(tBTM_BLE_ADV_PARAMS *, tBTM_BLE_MULTI_ADV_CBACK (*), void *) { return 0; }
+tBTM_STATUS BTM_BleEnableBatchScan(tBTM_BLE_BATCH_SCAN_MODE, UINT32, UINT32, tBTM_BLE_DISCARD_RULE, tBLE_ADDR_TYPE, tBTM_BLE_REF_VALUE) { return 0; }
+tBTM_STATUS BTM_BleEnableDisableFilterFeature(UINT8, tBTM_BLE_PF_STATUS_CBACK (*), tBTM_BLE_REF_VALUE) { return 0; }
+tBTM_STATUS BTM_BleGetEnergyInfo(tBTM_BLE_ENERGY_INFO_CBACK (*)) { return 0; }
+void BTM_BleGetVendorCapabilities(tBTM_BLE_VSC_CB *) {}
+void BTM_BleLoadLocalKeys(UINT8, tBTM_BLE_LOCAL_KEYS *) {}
+UINT8 BTM_BleMaxMultiAdvInstanceCount(void) { return 0; }
+tBTM_STATUS BTM_BleObserve(BOOLEAN, UINT8, tBTM_INQ_RESULTS_CB (*), tBTM_CMPL_CB (*)) { return 0; }
+void BTM_BlePasskeyReply(UINT8 *, UINT8, UINT32) {}
+tBTM_STATUS BTM_BleReadScanReports(tBTM_BLE_SCAN_MODE, tBTM_BLE_REF_VALUE) { return 0; }
+tBTM_STATUS BTM_BleSetAdvParams(UINT16, UINT16, tBLE_BD_ADDR *, tBTM_BLE_ADV_CHNL_MAP) { return 0; }
+BOOLEAN BTM_BleSetBgConnType(tBTM_BLE_CONN_TYPE, tBTM_BLE_SEL_CBACK (*)) { return 0; }
+void BTM_BleSetConnScanParams(UINT16, UINT16) {}
+void BTM_BleSetPrefConnParams(UINT8 *, UINT16, UINT16, UINT16, UINT16) {}
+tBTM_STATUS BTM_BleSetStorageConfig(UINT8, UINT8, UINT8, tBTM_BLE_SCAN_SETUP_CBACK (*), tBTM_BLE_SCAN_THRESHOLD_CBACK (*), tBTM_BLE_SCAN_REP_CBACK (*), tBTM_BLE_REF_VALUE) { return 0; }
+tBTM_STATUS BTM_BleTrackAdvertiser(tBTM_BLE_TRACK_ADV_CBACK (*), tBTM_BLE_REF_VALUE) { return 0; }
+tBTM_STATUS BTM_BleUpdateAdvInstParam(UINT8, tBTM_BLE_ADV_PARAMS *) { return 0; }
+tBTM_STATUS BTM_BleWriteAdvData(tBTM_BLE_AD_MASK, tBTM_BLE_ADV_DATA *) { return 0; }
+tBTM_STATUS BTM_BleWriteScanRsp(tBTM_BLE_AD_MASK, tBTM_BLE_ADV_DATA *) { return 0; }
+tBTM_STATUS BTM_CancelInquiry(void) { return 0; }
+tBTM_STATUS BTM_CancelRemoteDeviceName(void) { return 0; }
+tBTM_STATUS BTM_ClearInqDb(UINT8 *) { return 0; }
+void BTM_ConfirmReqReply(tBTM_STATUS, UINT8 *) {}
+void BTM_DeviceAuthorized(UINT8 *, UINT8, UINT32 *) {}
+void BTM_DeviceReset(tBTM_CMPL_CB (*)) {}
+tBTM_STATUS BTM_EnableTestMode(void) { return 0; }
+UINT8 BTM_GetEirSupportedServices(UINT32 *, UINT8 **, UINT8, UINT8 *) { return 0; }
+void BTM_GetLocalDeviceAddr(UINT8 *) {}
+UINT16 BTM_GetNumAclLinks(void) { return 0; }
+BOOLEAN BTM_HasEirService(UINT32 *, UINT16) { return 0; }
+tBTM_EIR_SEARCH_RESULT BTM_HasInquiryEirService(tBTM_INQ_RESULTS *, UINT16) { return 0; }
+tBTM_STATUS BTM_Hci_Raw_Command(UINT16, UINT8, UINT8 *, tBTM_RAW_CMPL_CB (*)) { return 0; }
+tBTM_INQ_INFO *BTM_InqDbFirst(void) { return 0; }
+tBTM_INQ_INFO *BTM_InqDbNext(tBTM_INQ_INFO *) { return 0; }
+tBTM_INQ_INFO *BTM_InqDbRead(UINT8 *) { return 0; }
+void BTM_IoCapRsp(UINT8 *, tBTM_IO_CAP, tBTM_OOB_DATA, tBTM_AUTH_REQ) {}
+BOOLEAN BTM_IsAclConnectionUp(UINT8 *, tBT_TRANSPORT) { return 0; }
+UINT16 BTM_IsInquiryActive(void) { return 0; }
+void BTM_PINCodeReply(UINT8 *, UINT8, UINT8, UINT8 *, UINT32 *) {}
+void BTM_PasskeyReqReply(tBTM_STATUS, UINT8 *, UINT32) {}
+void BTM_ReadDevInfo(UINT8 *, tBT_DEVICE_TYPE *, tBLE_ADDR_TYPE *) {}
+tBTM_STATUS BTM_ReadLinkQuality(UINT8 *, tBTM_CMPL_CB (*)) { return 0; }
+tBTM_STATUS BTM_ReadLocalDeviceName(char **) { return 0; }
+tBTM_STATUS BTM_ReadLocalDeviceNameFromController(tBTM_CMPL_CB (*)) { return 0; }
+UINT8 *BTM_ReadLocalFeatures(void) { return 0; }
+tBTM_STATUS BTM_ReadLocalOobData(void) { return 0; }
+tBTM_STATUS BTM_ReadRSSI(UINT8 *, tBTM_CMPL_CB (*)) { return 0; }
+UINT8 *BTM_ReadRemoteFeatures(UINT8 *) { return 0; }
+tBTM_STATUS BTM_ReadRemoteVersion(UINT8 *, UINT8 *, UINT16 *, UINT16 *) { return 0; }
+UINT32 *BTM_ReadTrustedMask(UINT8 *) { return 0; }
+tBTM_STATUS BTM_RegBusyLevelNotif(tBTM_BL_CHANGE_CB (*), UINT8 *, tBTM_BL_EVENT_MASK) { return 0; }
+void BTM_RemoteOobDataReply(tBTM_STATUS, UINT8 *, UINT8 *, UINT8 *) {}
+void BTM_RemoveEirService(UINT32 *, UINT16) {}
+BOOLEAN BTM_SecAddBleDevice(UINT8 *, UINT8 *, tBT_DEVICE_TYPE, tBLE_ADDR_TYPE) { return 0; }
+BOOLEAN BTM_SecAddBleKey(UINT8 *, tBTM_LE_KEY_VALUE *, tBTM_LE_KEY_TYPE) { return 0; }
+BOOLEAN BTM_SecAddDevice(UINT8 *, UINT8 *, UINT8 *, UINT8 *, UINT32 *, UINT8 *, UINT8, tBTM_IO_CAP, UINT8) { return 0; }
+BOOLEAN BTM_SecAddRmtNameNotifyCallback(tBTM_RMT_NAME_CALLBACK (*)) { return 0; }
+tBTM_STATUS BTM_SecBond(UINT8 *, UINT8, UINT8 *, UINT32 *) { return 0; }
+tBTM_STATUS BTM_SecBondByTransport(UINT8 *, tBT_TRANSPORT, UINT8, UINT8 *, UINT32 *) { return 0; }
+tBTM_STATUS BTM_SecBondCancel(UINT8 *) { return 0; }
+BOOLEAN BTM_SecDeleteDevice(UINT8 *) { return 0; }
+BOOLEAN BTM_SecDeleteRmtNameNotifyCallback(tBTM_RMT_NAME_CALLBACK (*)) { return 0; }
+char *BTM_SecReadDevName(UINT8 *) { return 0; }
+BOOLEAN BTM_SecRegister(tBTM_APPL_INFO *) { return 0; }
+void BTM_SecurityGrant(UINT8 *, UINT8) {}
+tBTM_STATUS BTM_SetAfhChannelAssessment(BOOLEAN) { return 0; }
+tBTM_STATUS BTM_SetAfhChannels(UINT8, UINT8) { return 0; }
+tBTM_STATUS BTM_SetConnectability(UINT16, UINT16, UINT16) { return 0; }
+void BTM_SetDefaultLinkPolicy(UINT16) {}
+void BTM_SetDefaultLinkSuperTout(UINT16) {}
+tBTM_STATUS BTM_SetDeviceClass(UINT8 *) { return 0; }
+tBTM_STATUS BTM_SetDiscoverability(UINT16, UINT16, UINT16) { return 0; }
+tBTM_STATUS BTM_SetEncryption(UINT8 *, tBT_TRANSPORT, tBTM_SEC_CBACK (*), void *) { return 0; }
+tBTM_STATUS BTM_SetLinkPolicy(UINT8 *, UINT16 *) { return 0; }
+tBTM_STATUS BTM_SetLocalDeviceName(char *) { return 0; }
+void BTM_SetPairableMode(BOOLEAN, BOOLEAN) {}
+tBTM_STATUS BTM_StartInquiry(tBTM_INQ_PARMS *, tBTM_INQ_RESULTS_CB (*), tBTM_CMPL_CB (*)) { return 0; }
+tBTM_STATUS BTM_SwitchRole(UINT8 *, UINT8, tBTM_CMPL_CB (*)) { return 0; }
+tBTM_STATUS BTM_VendorSpecificCommand(UINT16, UINT8, UINT8 *, tBTM_VSC_CMPL_CB (*)) { return 0; }
+tBTM_STATUS BTM_WriteEIR(BT_HDR *) { return 0; }
+tBTM_STATUS BTM_WriteInquiryTxPower(INT8) { return 0; }
+tBTM_STATUS BTM_WritePageTimeout(UINT16) { return 0; }
+BOOLEAN GAP_BleReadPeerPrefConnParams(UINT8 *) { return 0; }
+BOOLEAN L2CA_EnableUpdateBleConnParams(UINT8 *, BOOLEAN) { return 0; }
+UINT8 L2CA_SetDesireRole(UINT8) { return 0; }
+BOOLEAN L2CA_SetIdleTimeoutByBdAddr(UINT8 *, UINT16) { return 0; }
+BOOLEAN L2CA_UpdateBleConnParams(UINT8 *, UINT16, UINT16, UINT16, UINT16) { return 0; }
+void SDP_CacheInvalidate(UINT8 *) {}
+UINT16 SDP_DiDiscover(UINT8 *, tSDP_DISCOVERY_DB *, UINT32, tSDP_DISC_CMPL_CB (*)) { return 0; }
+tSDP_DISC_ATTR *SDP_FindAttributeInRec(tSDP_DISC_REC *, UINT16) { return 0; }
+BOOLEAN SDP_FindProtocolListElemInRec(tSDP_DISC_REC *, UINT16, tSDP_PROTOCOL_ELEM *) { return 0; }
+tSDP_DISC_REC *SDP_FindServiceInDb_128bit(tSDP_DISCOVERY_DB *, tSDP_DISC_REC *) { return 0; }
+tSDP_DISC_REC *SDP_FindServiceUUIDInDb(tSDP_DISCOVERY_DB *, tBT_UUID *, tSDP_DISC_REC *) { return 0; }
+BOOLEAN SDP_FindServiceUUIDInRec(tSDP_DISC_REC *, tBT_UUID *) { return 0; }
+BOOLEAN SDP_FindServiceUUIDInRec_128bit(tSDP_DISC_REC *, tBT_UUID *) { return 0; }
+UINT8 SDP_GetNumDiRecords(tSDP_DISCOVERY_DB *) { return 0; }
+void bta_dm_co_ble_io_req(UINT8 *, tBTA_IO_CAP *, tBTA_OOB_DATA *, tBTA_LE_AUTH_REQ *, UINT8 *, tBTA_LE_KEY_TYPE *, tBTA_LE_KEY_TYPE *) {}
+void bta_dm_co_ble_load_local_keys(tBTA_DM_BLE_LOCAL_KEY_MASK *, UINT8 *, tBTA_BLE_LOCAL_ID_KEYS *) {}
+void bta_dm_co_io_req(UINT8 *, tBTA_IO_CAP *, tBTA_OOB_DATA *, tBTA_AUTH_REQ *, BOOLEAN) {}
+void bta_dm_co_io_rsp(UINT8 *, tBTA_IO_CAP, tBTA_OOB_DATA, tBTA_AUTH_REQ) {}
+void bta_dm_co_lk_upgrade(UINT8 *, BOOLEAN *) {}
+void bta_dm_co_loc_oob(BOOLEAN, UINT8 *, UINT8 *) {}
+void bta_dm_co_rmt_oob(UINT8 *) {}
+void bta_dm_disable_pm(void) {}
+tBTA_DM_PEER_DEVICE *bta_dm_find_peer_device(UINT8 *) { return 0; }
+void bta_dm_init_pm(void) {}
+void bta_dm_pm_active(UINT8 *) {}
+tBTA_DM_CONTRL_STATE bta_dm_pm_obtain_controller_state(void) { return 0; }
+void bta_sys_disable(tBTA_SYS_HW_MODULE) {}
+void bta_sys_hw_register(tBTA_SYS_HW_MODULE, tBTA_SYS_HW_CBACK (*)) {}
+void bta_sys_hw_unregister(tBTA_SYS_HW_MODULE) {}
+void bta_sys_notify_collision(BD_ADDR_PTR) {}
+void bta_sys_notify_role_chg(BD_ADDR_PTR, UINT8, UINT8) {}
+void bta_sys_policy_register(tBTA_SYS_CONN_CBACK (*)) {}
+void bta_sys_remove_uuid(UINT16) {}
+void bta_sys_rm_register(tBTA_SYS_CONN_CBACK (*)) {}
+void bta_sys_start_timer(TIMER_LIST_ENT *, UINT16, INT32) {}
+void bta_sys_stop_timer(TIMER_LIST_ENT *) {}
+void *btm_ble_multi_adv_get_ref(UINT8) { return 0; }
+UINT16 btm_get_acl_disc_reason_code(void) { return 0; }
+tBTM_STATUS btm_remove_acl(UINT8 *, tBT_TRANSPORT) { return 0; }
+
+void sdpu_uuid16_to_uuid128(UINT16 uuid16, UINT8 *p_uuid128) {
+  memset(p_uuid128, 0, MAX_UUID_SIZE);
+  p_uuid128[2] = (UINT8)(uuid16 >> 8);
+  p_uuid128[3] = (UINT8)uuid16;
+}
+}
@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <set>
+#include <string.h>
+#include <vector>
+
+#include "fake_bta_sys.h"
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_api.h"
+#include "bta_sys.h"
+#include "bta_dm_int.h"
+#include "btm_api.h"
+#include "gki.h"
+#include "sdp_api.h"
+#include "utl.h"
+
+extern const UINT16 bta_service_id_to_uuid_lkup_tbl[];
+}
+
+#define MASK(id) ((tBTA_SERVICE_MASK)BTA_SERVICE_ID_TO_SERVICE_MASK(id))
+#define UUID(id) (bta_service_id_to_uuid_lkup_tbl[id])
+
+// The peer: the service classes of its records, in the order it sends them.
+static std::vector<UINT16> peer_records;
+
+// Records a batched search fits in the database before it is full, 0 if all.
+static size_t db_fits;
+
+// SDP searches started by bta_dm_act.c and the one in progress.
+static int transactions;
+static tSDP_DISCOVERY_DB *p_search_db;
+static tSDP_DISC_CMPL_CB *p_search_cb;
+static UINT16 last_filter;
+static tSDP_DISC_REC fake_rec;
+
+extern "C" {
+void LogMsg(UINT32, const char *, ...) {}
+
+tBTM_STATUS BTM_ReadRemoteDeviceName(BD_ADDR, tBTM_CMPL_CB *, tBT_TRANSPORT) {
+  return BTM_NO_RESOURCES;
+}
+
+BOOLEAN SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB *p_db, UINT32 len, UINT16 num_uuid,
+                            tSDP_UUID *p_uuid_list, UINT16, UINT16 *) {
+  memset(p_db, 0, len);
+  p_db->num_uuid_filters = num_uuid;
+  memcpy(p_db->uuid_filters, p_uuid_list, num_uuid * sizeof(tSDP_UUID));
+  return TRUE;
+}
+
+BOOLEAN SDP_ServiceSearchAttributeRequest(BD_ADDR, tSDP_DISCOVERY_DB *p_db, tSDP_DISC_CMPL_CB *p_cb) {
+  ++transactions;
+  last_filter = p_db->uuid_filters[0].uu.uuid16;
+  p_search_db = p_db;
+  p_search_cb = p_cb;
+  return TRUE;
+}
+
+// A record is in the database if it matches the search filter and, for the
+// L2CAP search of a batch, made it in before the database filled up.
+tSDP_DISC_REC *SDP_FindServiceInDb(tSDP_DISCOVERY_DB *p_db, UINT16 service_uuid, tSDP_DISC_REC *p_start_rec) {
+  UINT16 filter = p_db->uuid_filters[0].uu.uuid16;
+
+  if (p_start_rec != NULL || service_uuid == 0)
+    return NULL;
+
+  for (size_t i = 0; i < peer_records.size(); ++i) {
+    if (filter == UUID_PROTOCOL_L2CAP && db_fits != 0 && i >= db_fits)
+      break;
+    if (peer_records[i] == service_uuid && (filter == UUID_PROTOCOL_L2CAP || filter == service_uuid))
+      return &fake_rec;
+  }
+  return NULL;
+}
+}
+
+static void search_done(tBTA_DM_SEARCH_EVT, tBTA_DM_SEARCH *) {}
+
+class SdpBatchTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      peer_records.clear();
+      db_fits = 0;
+      transactions = 0;
+      p_search_db = NULL;
+      p_search_cb = NULL;
+      memset(&bta_dm_search_cb, 0, sizeof(bta_dm_search_cb));
+    }
+
+    // Discovers |services| on the peer through bta_dm_discover and
+    // bta_dm_sdp_result, answering each SDP search from |peer_records|.
+    // Returns the services found.
+    tBTA_SERVICE_MASK discover(tBTA_SERVICE_MASK services) {
+      tBTA_DM_API_DISCOVER discover;
+      tBTA_SERVICE_MASK found = 0;
+      bool done = false;
+
+      memset(&discover, 0, sizeof(discover));
+      discover.services = services;
+      discover.p_cback = search_done;
+      discover.transport = BT_TRANSPORT_BR_EDR;
+      bta_dm_discover((tBTA_DM_MSG *)&discover);
+
+      while (!done) {
+        if (bta_sys_msgs.empty()) {
+          if (p_search_cb == NULL)
+            break;
+
+          // Complete the search in progress.
+          tSDP_DISC_CMPL_CB *p_cb = p_search_cb;
+          UINT16 status = SDP_SUCCESS;
+          p_search_cb = NULL;
+          if (p_search_db->uuid_filters[0].uu.uuid16 == UUID_PROTOCOL_L2CAP &&
+              db_fits != 0 && db_fits < peer_records.size())
+            status = SDP_DB_FULL;
+          (*p_cb)(status);
+          continue;
+        }
+
+        BT_HDR *p_msg = bta_sys_msgs.front();
+        bta_sys_msgs.pop_front();
+        if (p_msg->event == BTA_DM_SDP_RESULT_EVT) {
+          bta_dm_sdp_result((tBTA_DM_MSG *)p_msg);
+        } else if (p_msg->event == BTA_DM_DISCOVERY_RESULT_EVT) {
+          tBTA_DM_DISC_RES *p_res = &((tBTA_DM_MSG *)p_msg)->disc_result.result.disc_res;
+          found = p_res->services;
+          utl_freebuf((void **)&p_res->p_uuid_list);
+          utl_freebuf((void **)&p_res->p_raw_data);
+          done = true;
+        }
+        GKI_freebuf(p_msg);
+      }
+
+      EXPECT_TRUE(done);
+      return found;
+    }
+};
+
+TEST_F(SdpBatchTest, test_batches_several_services) {
+  tBTA_SERVICE_MASK services = MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_HSP_SERVICE_ID) |
+                               MASK(BTA_A2DP_SOURCE_SERVICE_ID) | MASK(BTA_AVRCP_SERVICE_ID);
+
+  peer_records.push_back(UUID(BTA_HFP_SERVICE_ID));
+  peer_records.push_back(UUID(BTA_AVRCP_SERVICE_ID));
+
+  EXPECT_EQ(MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_AVRCP_SERVICE_ID), discover(services));
+  EXPECT_EQ(1, transactions);
+  EXPECT_EQ(UUID_PROTOCOL_L2CAP, last_filter);
+}
+
+TEST_F(SdpBatchTest, test_single_service_is_not_batched) {
+  peer_records.push_back(UUID(BTA_HFP_SERVICE_ID));
+
+  EXPECT_EQ(MASK(BTA_HFP_SERVICE_ID), discover(MASK(BTA_HFP_SERVICE_ID)));
+  EXPECT_EQ(1, transactions);
+  EXPECT_EQ(UUID(BTA_HFP_SERVICE_ID), last_filter);
+}
+
+TEST_F(SdpBatchTest, test_missing_services_without_full_db_are_absent) {
+  tBTA_SERVICE_MASK services = MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_HSP_SERVICE_ID) |
+                               MASK(BTA_OPP_SERVICE_ID);
+
+  peer_records.push_back(UUID(BTA_OPP_SERVICE_ID));
+
+  EXPECT_EQ(MASK(BTA_OPP_SERVICE_ID), discover(services));
+  EXPECT_EQ(1, transactions);
+}
+
+TEST_F(SdpBatchTest, test_full_db_searches_remaining_services_singly) {
+  tBTA_SERVICE_MASK services = MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_HSP_SERVICE_ID) |
+                               MASK(BTA_OPP_SERVICE_ID) | MASK(BTA_FTP_SERVICE_ID);
+
+  // The database holds the first two records; HFP and OPP come after.
+  peer_records.push_back(UUID(BTA_HSP_SERVICE_ID));
+  peer_records.push_back(UUID(BTA_FTP_SERVICE_ID));
+  peer_records.push_back(UUID(BTA_HFP_SERVICE_ID));
+  peer_records.push_back(UUID(BTA_OPP_SERVICE_ID));
+  db_fits = 2;
+
+  // The batch settles HSP and FTP; HFP and OPP are each searched again.
+  EXPECT_EQ(services, discover(services));
+  EXPECT_EQ(1 + 2, transactions);
+}
+
+TEST_F(SdpBatchTest, test_full_db_does_not_batch_again) {
+  tBTA_SERVICE_MASK services = MASK(BTA_SPP_SERVICE_ID) | MASK(BTA_DUN_SERVICE_ID) |
+                               MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_OPP_SERVICE_ID);
+
+  peer_records.push_back(UUID(BTA_HFP_SERVICE_ID));
+  peer_records.push_back(UUID(BTA_SPP_SERVICE_ID));
+  peer_records.push_back(UUID(BTA_DUN_SERVICE_ID));
+  db_fits = 1;
+
+  // Nothing is lost: SPP and DUN are found singly, OPP is absent.
+  EXPECT_EQ(MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_SPP_SERVICE_ID) | MASK(BTA_DUN_SERVICE_ID),
+            discover(services));
+  EXPECT_EQ(1 + 3, transactions);
+}
+
+TEST_F(SdpBatchTest, test_all_services_are_not_batched) {
+  EXPECT_EQ(0u, bta_dm_sdp_batch_mask(BTA_ALL_SERVICE_MASK, BTA_ALL_SERVICE_MASK, 0));
+}
+
+TEST_F(SdpBatchTest, test_reserved_and_user_services_keep_own_search) {
+  tBTA_SERVICE_MASK services = BTA_RES_SERVICE_MASK | BTA_USER_SERVICE_MASK |
+                               MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_OPP_SERVICE_ID);
+
+  EXPECT_EQ(MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_OPP_SERVICE_ID),
+            bta_dm_sdp_batch_mask(services, services, 0));
+}
+
+TEST_F(SdpBatchTest, test_full_db_split_returns_unsettled_services) {
+  tBTA_SERVICE_MASK batch = MASK(BTA_HFP_SERVICE_ID) | MASK(BTA_OPP_SERVICE_ID);
+  tBTA_SERVICE_MASK found = 0;
+  tSDP_DISCOVERY_DB db;
+  UINT8 uuids[2][MAX_UUID_SIZE];
+  UINT32 num_uuids = 0;
+
+  memset(&db, 0, sizeof(db));
+  db.uuid_filters[0].uu.uuid16 = UUID_PROTOCOL_L2CAP;
+  peer_records.push_back(UUID(BTA_OPP_SERVICE_ID));
+
+  EXPECT_EQ(MASK(BTA_HFP_SERVICE_ID),
+            bta_dm_sdp_batch_split(&db, batch, TRUE, &found, uuids, 2, &num_uuids));
+  EXPECT_EQ(MASK(BTA_OPP_SERVICE_ID), found);
+  EXPECT_EQ(1u, num_uuids);
+  EXPECT_EQ(UUID(BTA_OPP_SERVICE_ID) >> 8, uuids[0][2]);
+  EXPECT_EQ(UUID(BTA_OPP_SERVICE_ID) & 0xff, uuids[0][3]);
+}
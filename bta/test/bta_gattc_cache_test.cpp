@@ -0,0 +1,397 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_gattc_co.h"
+#include "bta_gattc_int.h"
+#include "gatt_api.h"
+#include "gki.h"
+#include "utl.h"
+}
+
+#define CONN_ID 0x0101
+
+#define NUM_SERVICES 8
+#define CHARS_PER_SERVICE 31
+// A service declaration, an include, then a declaration, a value and two
+// descriptors per characteristic.
+#define SERVICE_HANDLES (2 + CHARS_PER_SERVICE * 4)
+
+// A cache entry, flattened so caches can be compared.
+typedef std::vector<UINT8> entry_t;
+
+// The discovery BTA asked GATT for, until the test answers it.
+static bool disc_pending;
+static tGATT_DISC_TYPE disc_type;
+static tGATT_DISC_PARAM disc_param;
+
+static bool cache_saved;
+static std::vector<tBTA_GATT_STATUS> disc_errors;
+
+static tBTA_GATTC_CLCB clcb;
+static tBTA_GATTC_SERV srvc;
+
+extern "C" {
+tGATT_STATUS GATTC_Discover(UINT16 conn_id, tGATT_DISC_TYPE type, tGATT_DISC_PARAM *p_param) {
+  EXPECT_EQ(CONN_ID, conn_id);
+  EXPECT_FALSE(disc_pending);
+  disc_pending = true;
+  disc_type = type;
+  disc_param = *p_param;
+  return GATT_SUCCESS;
+}
+
+tBTA_GATTC_CLCB *bta_gattc_find_clcb_by_conn_id(UINT16 conn_id) {
+  return (conn_id == CONN_ID) ? &clcb : NULL;
+}
+
+tBTA_GATTC_SERV *bta_gattc_find_scb_by_cid(UINT16 conn_id) {
+  return (conn_id == CONN_ID) ? &srvc : NULL;
+}
+
+void bta_gattc_co_cache_open(BD_ADDR, UINT16, UINT16, BOOLEAN) {
+  cache_saved = true;
+}
+
+BOOLEAN bta_gattc_sm_execute(tBTA_GATTC_CLCB *p_clcb, UINT16 event, tBTA_GATTC_DATA *) {
+  if (event == BTA_GATTC_DISCOVER_CMPL_EVT)
+    disc_errors.push_back(p_clcb->status);
+  return TRUE;
+}
+}
+
+static void add_u16(std::vector<UINT8> &v, UINT16 x) {
+  v.push_back(x & 0xff);
+  v.push_back(x >> 8);
+}
+
+static tBT_UUID uuid16(UINT16 uuid) {
+  tBT_UUID u;
+
+  memset(&u, 0, sizeof(u));
+  u.len = LEN_UUID_16;
+  u.uu.uuid16 = uuid;
+  return u;
+}
+
+static tBT_UUID uuid128(UINT8 tag) {
+  tBT_UUID u;
+
+  memset(&u, 0, sizeof(u));
+  u.len = LEN_UUID_128;
+  for (int i = 0; i < LEN_UUID_128; ++i)
+    u.uu.uuid128[i] = (UINT8)(0xA0 + i);
+  u.uu.uuid128[0] = tag;
+  return u;
+}
+
+static void add_uuid(entry_t &e, const tBT_UUID &uuid) {
+  e.push_back(uuid.len);
+  if (uuid.len == LEN_UUID_16)
+    add_u16(e, uuid.uu.uuid16);
+  else
+    e.insert(e.end(), uuid.uu.uuid128, uuid.uu.uuid128 + uuid.len);
+}
+
+// The UUID of a cache attribute, which is stored after it in stream order.
+static void add_attr_uuid(entry_t &e, const tBTA_GATTC_CACHE_ATTR *p_attr) {
+  const UINT8 *p = (const UINT8 *)p_attr->p_uuid;
+
+  e.push_back((UINT8)p_attr->uuid_len);
+  e.insert(e.end(), p, p + p_attr->uuid_len);
+}
+
+static UINT32 gki_free_bufs(void) {
+  UINT32 count = 0;
+
+  for (UINT8 pool = 0; pool < GKI_NUM_TOTAL_BUF_POOLS; ++pool)
+    count += GKI_poolfreecount(pool);
+  return count;
+}
+
+static UINT64 now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (UINT64)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+class GattcCacheTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      build_server();
+      memset(&srvc, 0, sizeof(srvc));
+      GKI_init_q(&srvc.cache_buffer);
+      free_bufs = gki_free_bufs();
+    }
+
+    virtual void TearDown() {
+      free_cache();
+      EXPECT_EQ(free_bufs, gki_free_bufs());
+    }
+
+    void free_cache() {
+      while (srvc.cache_buffer.p_first)
+        GKI_freebuf(GKI_dequeue(&srvc.cache_buffer));
+      utl_freebuf((void **)&srvc.p_srvc_list);
+    }
+
+    static tBT_UUID service_uuid(int s) {
+      return (s % 2) ? uuid128((UINT8)s) : uuid16((UINT16)(0x1800 + s));
+    }
+
+    void add_attr(const tGATT_DISC_RES &res) {
+      attrs.push_back(res);
+    }
+
+    // The server as GATT discovery reports it: every attribute with its type,
+    // and the declarations with their values. Services alternate between 16
+    // and 128 bit UUIDs, and so do their characteristics; each service
+    // includes the next one.
+    void build_server() {
+      attrs.clear();
+      for (int s = 0; s < NUM_SERVICES; ++s) {
+        UINT16 h = (UINT16)(1 + s * SERVICE_HANDLES);
+        int inc = (s + 1) % NUM_SERVICES;
+        tGATT_DISC_RES res;
+
+        memset(&res, 0, sizeof(res));
+        res.handle = h++;
+        res.type = uuid16(GATT_UUID_PRI_SERVICE);
+        res.value.group_value.e_handle = (UINT16)(res.handle + SERVICE_HANDLES - 1);
+        res.value.group_value.service_type = service_uuid(s);
+        add_attr(res);
+
+        memset(&res, 0, sizeof(res));
+        res.handle = h++;
+        res.type = uuid16(GATT_UUID_INCLUDE_SERVICE);
+        res.value.incl_service.s_handle = (UINT16)(1 + inc * SERVICE_HANDLES);
+        res.value.incl_service.e_handle = (UINT16)((inc + 1) * SERVICE_HANDLES);
+        res.value.incl_service.service_type = service_uuid(inc);
+        add_attr(res);
+
+        for (int c = 0; c < CHARS_PER_SERVICE; ++c) {
+          tBT_UUID char_uuid = (s % 2) ? uuid128((UINT8)(s * 32 + c))
+                                       : uuid16((UINT16)(0x2A00 + c));
+
+          memset(&res, 0, sizeof(res));
+          res.handle = h++;
+          res.type = uuid16(GATT_UUID_CHAR_DECLARE);
+          res.value.dclr_value.char_prop = GATT_CHAR_PROP_BIT_READ | GATT_CHAR_PROP_BIT_NOTIFY;
+          res.value.dclr_value.val_handle = h;
+          res.value.dclr_value.char_uuid = char_uuid;
+          add_attr(res);
+
+          memset(&res, 0, sizeof(res));
+          res.handle = h++;
+          res.type = char_uuid;
+          add_attr(res);
+
+          res.handle = h++;
+          res.type = uuid16(GATT_UUID_CHAR_CLIENT_CONFIG);
+          add_attr(res);
+
+          res.handle = h++;
+          res.type = uuid16(GATT_UUID_CHAR_DESCRIPTION);
+          add_attr(res);
+        }
+      }
+    }
+
+    // The results GATT reports for the discovery asked for.
+    std::vector<tGATT_DISC_RES> disc_results() {
+      std::vector<tGATT_DISC_RES> v;
+      UINT16 type = 0;
+
+      if (disc_type == GATT_DISC_SRVC_ALL)
+        type = GATT_UUID_PRI_SERVICE;
+      else if (disc_type == GATT_DISC_INC_SRVC)
+        type = GATT_UUID_INCLUDE_SERVICE;
+      else if (disc_type == GATT_DISC_CHAR)
+        type = GATT_UUID_CHAR_DECLARE;
+
+      for (size_t i = 0; i < attrs.size(); ++i) {
+        const tGATT_DISC_RES &a = attrs[i];
+        if (a.handle < disc_param.s_handle || a.handle > disc_param.e_handle)
+          continue;
+        if (type != 0 && (a.type.len != LEN_UUID_16 || a.type.uu.uuid16 != type))
+          continue;
+        v.push_back(a);
+      }
+      return v;
+    }
+
+    // Discovers the whole server into the cache, answering each discovery
+    // with |per_pdu| results per response, as batches or one at a time.
+    void discover(bool batch, UINT16 per_pdu) {
+      free_cache();
+      memset(&srvc, 0, sizeof(srvc));
+      GKI_init_q(&srvc.cache_buffer);
+      srvc.in_use = TRUE;
+      srvc.state = BTA_GATTC_SERV_DISC;
+      memset(&clcb, 0, sizeof(clcb));
+      clcb.in_use = TRUE;
+      clcb.bta_conn_id = CONN_ID;
+      clcb.transport = BTA_TRANSPORT_LE;
+      clcb.state = BTA_GATTC_DISCOVER_ST;
+      clcb.p_srcb = &srvc;
+      disc_pending = false;
+      cache_saved = false;
+      disc_errors.clear();
+
+      ASSERT_EQ(BTA_GATT_OK, bta_gattc_init_cache(&srvc));
+      ASSERT_EQ(GATT_SUCCESS, bta_gattc_discover_pri_service(CONN_ID, &srvc, GATT_DISC_SRVC_ALL));
+
+      while (disc_pending) {
+        std::vector<tGATT_DISC_RES> res = disc_results();
+
+        disc_pending = false;
+        for (size_t i = 0; i < res.size(); i += per_pdu) {
+          UINT16 n = (UINT16)std::min((size_t)per_pdu, res.size() - i);
+          if (batch) {
+            bta_gattc_disc_res_batch_cback(CONN_ID, disc_type, n, &res[i]);
+          } else {
+            for (UINT16 k = 0; k < n; ++k)
+              bta_gattc_disc_res_cback(CONN_ID, disc_type, &res[i + k]);
+          }
+        }
+        bta_gattc_disc_cmpl_cback(CONN_ID, disc_type, GATT_SUCCESS);
+      }
+
+      EXPECT_TRUE(cache_saved);
+      EXPECT_TRUE(disc_errors.empty());
+    }
+
+    std::vector<entry_t> cache() {
+      std::vector<entry_t> v;
+
+      for (tBTA_GATTC_CACHE *p_svc = srvc.p_srvc_cache; p_svc; p_svc = p_svc->p_next) {
+        entry_t e;
+
+        add_u16(e, p_svc->s_handle);
+        add_u16(e, p_svc->e_handle);
+        add_uuid(e, p_svc->service_uuid.id.uuid);
+        e.push_back(p_svc->service_uuid.id.inst_id);
+        e.push_back(p_svc->service_uuid.is_primary);
+        v.push_back(e);
+
+        for (tBTA_GATTC_CACHE_ATTR *p_attr = p_svc->p_attr; p_attr; p_attr = p_attr->p_next) {
+          e.clear();
+          add_u16(e, p_attr->attr_handle);
+          e.push_back(p_attr->attr_type);
+          e.push_back(p_attr->property);
+          e.push_back(p_attr->inst_id);
+          add_attr_uuid(e, p_attr);
+          v.push_back(e);
+        }
+      }
+      return v;
+    }
+
+    // The cache the server must end up as: each service with its include,
+    // then every characteristic by its value handle, followed by its
+    // descriptors.
+    std::vector<entry_t> expected() {
+      std::vector<entry_t> v;
+
+      for (size_t i = 0; i < attrs.size(); ++i) {
+        const tGATT_DISC_RES &a = attrs[i];
+        entry_t e;
+
+        if (a.type.len != LEN_UUID_16)
+          continue;
+        switch (a.type.uu.uuid16) {
+          case GATT_UUID_PRI_SERVICE:
+            add_u16(e, a.handle);
+            add_u16(e, a.value.group_value.e_handle);
+            add_uuid(e, a.value.group_value.service_type);
+            e.push_back(0);
+            e.push_back(TRUE);
+            break;
+          case GATT_UUID_INCLUDE_SERVICE:
+            add_u16(e, a.handle);
+            e.push_back(BTA_GATTC_ATTR_TYPE_INCL_SRVC);
+            e.push_back(TRUE);
+            e.push_back(0);
+            add_uuid(e, a.value.incl_service.service_type);
+            break;
+          case GATT_UUID_CHAR_DECLARE:
+            add_u16(e, a.value.dclr_value.val_handle);
+            e.push_back(BTA_GATTC_ATTR_TYPE_CHAR);
+            e.push_back(a.value.dclr_value.char_prop);
+            e.push_back(0);
+            add_uuid(e, a.value.dclr_value.char_uuid);
+            break;
+          case GATT_UUID_CHAR_CLIENT_CONFIG:
+          case GATT_UUID_CHAR_DESCRIPTION:
+            add_u16(e, a.handle);
+            e.push_back(BTA_GATTC_ATTR_TYPE_CHAR_DESCR);
+            e.push_back(0);
+            e.push_back(0);
+            add_uuid(e, a.type);
+            break;
+          default:
+            continue;
+        }
+        v.push_back(e);
+      }
+      return v;
+    }
+
+    std::vector<tGATT_DISC_RES> attrs;
+    UINT32 free_bufs;
+};
+
+TEST_F(GattcCacheTest, test_batches_build_the_same_cache) {
+  static const UINT16 sizes[] = { 1, 7, GATT_DISC_RES_BATCH_MAX };
+  std::vector<entry_t> single;
+  UINT16 single_bufs;
+
+  discover(false, 1);
+  single = cache();
+  single_bufs = srvc.cache_buffer.count;
+  ASSERT_EQ(expected(), single);
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    SCOPED_TRACE(testing::Message() << "batches of " << sizes[i]);
+    discover(true, sizes[i]);
+    EXPECT_EQ(single, cache());
+    EXPECT_GE(single_bufs, srvc.cache_buffer.count);
+  }
+}
+
+TEST_F(GattcCacheTest, test_cache_buffers_are_sized_up_front) {
+  discover(true, GATT_DISC_RES_BATCH_MAX);
+
+  // Each service and its attributes take one buffer or little more, instead
+  // of a chain of pool buffers.
+  EXPECT_GE(2 * NUM_SERVICES, srvc.cache_buffer.count);
+  EXPECT_EQ(expected(), cache());
+}
+
+// Builds the cache of the whole server the way BTA does, from results handed
+// over by GATT. Times are printed rather than asserted since they vary
+// between devices.
+TEST_F(GattcCacheTest, test_benchmark_cache_build) {
+  static const int ITERATIONS = 50;
+  UINT64 us[2];
+  UINT16 bufs[2];
+
+  for (int batch = 0; batch < 2; ++batch) {
+    UINT64 start = now_us();
+
+    for (int i = 0; i < ITERATIONS; ++i)
+      discover(batch != 0, GATT_DISC_RES_BATCH_MAX);
+    us[batch] = (now_us() - start) / ITERATIONS;
+    bufs[batch] = srvc.cache_buffer.count;
+  }
+
+  printf("cache of %u attributes: batched %llu us in %u buffers, single %llu us in %u buffers\n",
+         (unsigned)attrs.size(), (unsigned long long)us[1], bufs[1],
+         (unsigned long long)us[0], bufs[0]);
+}
@@ -0,0 +1,18 @@
+// Stubs for the stack and system calls of bta_gattc_cache.c that the tests do
+// not exercise. Calls the tests drive are faked in the test files.
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_gattc_int.h"
+
+tBTA_GATTC_CB bta_gattc_cb;
+}
+
+extern "C" {
+UINT8 *BTM_ReadDeviceClass(void) { return 0; }
+void bta_gattc_co_cache_save(UINT8 *, UINT16, UINT16, tBTA_GATTC_NV_ATTR *, UINT16, UINT16) {}
+void bta_gattc_pack_attr_uuid(tBTA_GATTC_CACHE_ATTR *, tBT_UUID *) {}
+BOOLEAN bta_gattc_srvcid_compare(tBTA_GATT_SRVC_ID *, tBTA_GATT_SRVC_ID *) { return 0; }
+BOOLEAN bta_gattc_uuid_compare(tBT_UUID *, tBT_UUID *, BOOLEAN) { return 0; }
+}
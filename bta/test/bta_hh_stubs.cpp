@@ -0,0 +1,60 @@
+// Stubs for the stack and system calls of bta_hh that the tests do not
+// exercise. Calls the tests drive are faked in the test files.
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_api.h"
+#include "bta_sys.h"
+#include "bta_hh_api.h"
+#include "bta_hh_co.h"
+#include "bta_hh_int.h"
+#include "btm_api.h"
+#include "gki.h"
+#include "hidh_api.h"
+#include "sdp_api.h"
+#include "utl.h"
+}
+
+extern "C" {
+void BTA_HhUpdateLeScanParam(UINT8, UINT16, UINT16) {}
+tBTM_STATUS BTM_GetLinkSuperTout(UINT8 *, UINT16 *) { return 0; }
+tHID_STATUS HID_HostAddDev(UINT8 *, UINT16, UINT8 *) { return 0; }
+tHID_STATUS HID_HostCloseDev(UINT8) { return 0; }
+tHID_STATUS HID_HostDeregister(void) { return 0; }
+tHID_STATUS HID_HostGetSDPRecord(UINT8 *, tSDP_DISCOVERY_DB *, UINT32, tHID_HOST_SDP_CALLBACK (*)) { return 0; }
+tHID_STATUS HID_HostOpenDev(UINT8) { return 0; }
+tHID_STATUS HID_HostRemoveDev(UINT8) { return 0; }
+tHID_STATUS HID_HostWriteDev(UINT8, UINT8, UINT8, UINT16, UINT8, BT_HDR *) { return 0; }
+UINT16 SDP_GetDiRecord(UINT8, tSDP_DI_GET_RECORD *, tSDP_DISCOVERY_DB *) { return 0; }
+void bta_hh_co_close(UINT8, UINT8) {}
+void bta_hh_co_open(UINT8, UINT8, UINT16, UINT8) {}
+void bta_hh_gatt_close(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_gatt_open(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+BOOLEAN bta_hh_is_le_device(tBTA_HH_DEV_CB *, UINT8 *) { return 0; }
+UINT8 bta_hh_le_add_device(tBTA_HH_DEV_CB *, tBTA_HH_MAINT_DEV *) { return 0; }
+void bta_hh_le_api_disc_act(tBTA_HH_DEV_CB *) {}
+void bta_hh_le_deregister(void) {}
+void bta_hh_le_enable(void) {}
+void bta_hh_le_get_dscp_act(tBTA_HH_DEV_CB *) {}
+void bta_hh_le_notify_enc_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_le_open_conn(tBTA_HH_DEV_CB *, UINT8 *) {}
+void bta_hh_le_open_fail(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_le_read_char_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_le_read_descr_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_le_remove_dev_bg_conn(tBTA_HH_DEV_CB *) {}
+void bta_hh_le_update_scpp(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_le_write_char_descr_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_le_write_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_le_write_dev_act(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_security_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_start_security(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_w4_le_read_char_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_w4_le_read_descr_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_hh_w4_le_write_cmpl(tBTA_HH_DEV_CB *, tBTA_HH_DATA *) {}
+void bta_sys_busy(UINT8, UINT8, UINT8 *) {}
+void bta_sys_conn_close(UINT8, UINT8, UINT8 *) {}
+void bta_sys_conn_open(UINT8, UINT8, UINT8 *) {}
+void bta_sys_idle(UINT8, UINT8, UINT8 *) {}
+void bta_sys_sco_close(UINT8, UINT8, UINT8 *) {}
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "fake_bta_sys.h"
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_api.h"
+#include "bta_hh_api.h"
+#include "bta_hh_co.h"
+#include "bta_hh_int.h"
+#include "gki.h"
+#include "hidh_api.h"
+}
+
+#define DEV_HANDLE 3
+
+static tHID_HOST_DEV_CALLBACK *p_hid_cback;
+
+// The first byte of every report handed to the platform driver, in order.
+static std::vector<UINT8> delivered;
+
+static UINT64 now_us;
+
+extern "C" {
+void HID_HostInit(void) {}
+
+tHID_STATUS HID_HostSetSecurityLevel(char[], UINT8) {
+  return HID_SUCCESS;
+}
+
+tHID_STATUS HID_HostRegister(tHID_HOST_DEV_CALLBACK *dev_cback) {
+  p_hid_cback = dev_cback;
+  return HID_SUCCESS;
+}
+
+void bta_hh_co_data(UINT8 dev_handle, UINT8 *p_rpt, UINT16 len, tBTA_HH_PROTO_MODE, UINT8, UINT8,
+                    BD_ADDR, UINT8) {
+  EXPECT_EQ(DEV_HANDLE, dev_handle);
+  EXPECT_EQ(1, len);
+  delivered.push_back(p_rpt[0]);
+}
+
+UINT64 GKI_now_us(void) {
+  return now_us;
+}
+}
+
+class BtaHhInputTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      tBTA_HH_DATA enable;
+
+      bta_sys_msgs.clear();
+      delivered.clear();
+      now_us = 1000;
+      p_hid_cback = NULL;
+
+      memset(&enable, 0, sizeof(enable));
+      bta_hh_api_enable(&enable);
+      ASSERT_TRUE(p_hid_cback != NULL);
+
+      p_cb = &bta_hh_cb.kdev[0];
+      p_cb->in_use = TRUE;
+      p_cb->state = BTA_HH_CONN_ST;
+      p_cb->hid_handle = DEV_HANDLE;
+      bta_hh_cb.cb_index[DEV_HANDLE] = 0;
+      memset(addr, 0x11, sizeof(addr));
+    }
+
+    virtual void TearDown() {
+      EXPECT_TRUE(bta_sys_msgs.empty());
+    }
+
+    // An input report on the interrupt channel, as HID host hands it over.
+    void intr_data(UINT8 value) {
+      BT_HDR *p_buf = (BT_HDR *)GKI_getbuf(sizeof(BT_HDR) + 1);
+      p_buf->offset = 0;
+      p_buf->len = 1;
+      *(UINT8 *)(p_buf + 1) = value;
+      (*p_hid_cback)(DEV_HANDLE, addr, HID_HDEV_EVT_INTR_DATA, 0, p_buf);
+    }
+
+    // Runs the messages posted to BTA through the HID host event handler.
+    void drain(void) {
+      while (!bta_sys_msgs.empty()) {
+        BT_HDR *p_msg = bta_sys_msgs.front();
+        bta_sys_msgs.pop_front();
+        bta_hh_hdl_event(p_msg);
+        GKI_freebuf(p_msg);
+      }
+    }
+
+    tBTA_HH_DEV_CB *p_cb;
+    BD_ADDR addr;
+};
+
+TEST_F(BtaHhInputTest, test_report_is_delivered_directly) {
+  intr_data('a');
+  intr_data('b');
+
+  EXPECT_TRUE(bta_sys_msgs.empty());
+  ASSERT_EQ(2u, delivered.size());
+  EXPECT_EQ('a', delivered[0]);
+  EXPECT_EQ('b', delivered[1]);
+  EXPECT_EQ(2u, p_cb->input_lat.direct[0]);
+}
+
+TEST_F(BtaHhInputTest, test_direct_report_does_not_overtake_queued_ones) {
+  // Reports arriving before the device is connected go through the mailbox.
+  p_cb->state = BTA_HH_W4_CONN_ST;
+  intr_data('a');
+  EXPECT_EQ(1u, bta_sys_msgs.size());
+  EXPECT_EQ(1, p_cb->intr_data_queued);
+
+  // Once connected, a report must still queue behind the one waiting.
+  p_cb->state = BTA_HH_CONN_ST;
+  intr_data('b');
+  EXPECT_EQ(2u, bta_sys_msgs.size());
+  EXPECT_EQ(2, p_cb->intr_data_queued);
+  EXPECT_TRUE(delivered.empty());
+
+  drain();
+  EXPECT_EQ(0, p_cb->intr_data_queued);
+  ASSERT_EQ(2u, delivered.size());
+  EXPECT_EQ('a', delivered[0]);
+  EXPECT_EQ('b', delivered[1]);
+
+  // With the mailbox drained the fast path is taken again.
+  intr_data('c');
+  EXPECT_TRUE(bta_sys_msgs.empty());
+  ASSERT_EQ(3u, delivered.size());
+  EXPECT_EQ('c', delivered[2]);
+}
+
+TEST_F(BtaHhInputTest, test_unknown_handle_is_queued) {
+  bta_hh_cb.cb_index[DEV_HANDLE] = BTA_HH_IDX_INVALID;
+  intr_data('a');
+
+  EXPECT_EQ(1u, bta_sys_msgs.size());
+  EXPECT_EQ(0, p_cb->intr_data_queued);
+  EXPECT_TRUE(delivered.empty());
+
+  BT_HDR *p_msg = bta_sys_msgs.front();
+  bta_sys_msgs.pop_front();
+  GKI_freebuf(((tBTA_HH_CBACK_DATA *)p_msg)->p_data);
+  GKI_freebuf(p_msg);
+}
+
+TEST_F(BtaHhInputTest, test_latency_is_counted_per_path) {
+  intr_data('a');
+
+  p_cb->state = BTA_HH_W4_CONN_ST;
+  intr_data('b');
+  p_cb->state = BTA_HH_CONN_ST;
+  now_us += 5;
+  drain();
+
+  // 0 us is counted in bucket 0, 5 us in bucket 3 for [4, 8) us.
+  EXPECT_EQ(1u, p_cb->input_lat.direct[0]);
+  EXPECT_EQ(1u, p_cb->input_lat.queued[3]);
+
+  p_cb->state = BTA_HH_W4_CONN_ST;
+  intr_data('c');
+  p_cb->state = BTA_HH_CONN_ST;
+  now_us += 1000000;
+  drain();
+  EXPECT_EQ(1u, p_cb->input_lat.queued[BTA_HH_LAT_BUCKETS - 1]);
+
+  bta_hh_dump_input_latency(p_cb);
+  for (int i = 0; i < BTA_HH_LAT_BUCKETS; ++i) {
+    EXPECT_EQ(0u, p_cb->input_lat.direct[i]);
+    EXPECT_EQ(0u, p_cb->input_lat.queued[i]);
+  }
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include "fake_bta_sys.h"
+
+extern "C" {
+#include "bta_sys.h"
+#include "gki.h"
+#include "gki_int.h"
+
+tGKI_CB gki_cb;
+
+void gki_buffer_init(void);
+
+void GKI_disable(void) {}
+void GKI_enable(void) {}
+void GKI_exception(UINT16, char *) {}
+UINT8 GKI_get_taskid(void) { return 0; }
+UINT8 GKI_send_event(UINT8, UINT16) { return GKI_SUCCESS; }
+void *GKI_os_malloc(UINT32 size) { return malloc(size); }
+void GKI_os_free(void *p_mem) { free(p_mem); }
+}
+
+// The GKI OS layer under the real buffer pools.
+class GkiEnvironment : public ::testing::Environment {
+  public:
+    virtual void SetUp() {
+      gki_buffer_init();
+    }
+};
+
+static ::testing::Environment *const gki_env =
+    ::testing::AddGlobalTestEnvironment(new GkiEnvironment);
+
+std::deque<BT_HDR *> bta_sys_msgs;
+
+extern "C" {
+void bta_sys_sendmsg(void *p_msg) {
+  bta_sys_msgs.push_back((BT_HDR *)p_msg);
+}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <deque>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+}
+
+// Messages posted through bta_sys_sendmsg, oldest first. Tests hand them to the
+// module's event handler themselves and free them.
+extern std::deque<BT_HDR *> bta_sys_msgs;
@@ -0,0 +1,40 @@
+LOCAL_PATH := $(call my-dir)
+
+# The btif sources are built into bluetooth.default by main/Android.mk; only
+# their tests are built here.
+
+#####################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/../bta/include \
+    $(LOCAL_PATH)/../gki/common \
+    $(LOCAL_PATH)/../gki/ulinux \
+    $(LOCAL_PATH)/../include \
+    $(LOCAL_PATH)/../stack/include \
+    $(LOCAL_PATH)/../udrv/include \
+    $(LOCAL_PATH)/../vnd/include \
+    $(LOCAL_PATH)/../utils/include \
+    $(bdroid_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ../gki/common/gki_buffer.c \
+    ./co/bta_hh_co.c \
+    ./src/btif_media_jb.c \
+    ./src/btif_media_pcm.c \
+    ./src/btif_pan.c \
+    ./test/bta_hh_co_test.cpp \
+    ./test/btif_media_jb_test.cpp \
+    ./test/btif_media_pcm_test.cpp \
+    ./test/btif_pan_test.cpp \
+    ./test/btif_stubs.cpp
+
+LOCAL_CFLAGS := -DBUILDCFG $(bdroid_CFLAGS)
+LOCAL_CONLYFLAGS := -std=c99
+LOCAL_MODULE := btiftests
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog
+
+include $(BUILD_NATIVE_TEST)
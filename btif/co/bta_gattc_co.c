@@ -17,17 +17,46 @@
  ******************************************************************************/
 
 
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <hardware/bluetooth.h>
+
+#define LOG_TAG "BTA_GATTC_CO"
 #include "gki.h"
 #include "bta_gattc_co.h"
 #include "bta_gattc_ci.h"
+#include "btif_common.h"
 #include "btif_util.h"
 
 #if( defined BLE_INCLUDED ) && (BLE_INCLUDED == TRUE)
 #if( defined BTA_GATT_INCLUDED ) && (BTA_GATT_INCLUDED == TRUE)
 
 #define GATT_CACHE_PREFIX "/data/misc/bluedroid/gatt_cache_"
+#define GATT_CACHE_TMP_SUFFIX ".XXXXXX"
+
+/* A cache being saved is gathered in memory and written out by the btif
+** thread pool once it is closed, so the btu task never waits on the disk.
+** Each write goes to its own temporary file; a write posted for a file that
+** already has one pending supersedes it, and the older one is dropped.
+*/
+typedef struct tCACHE_WRITE {
+    char                fname[255];
+    tBTA_GATTC_NV_ATTR  *p_attr;
+    UINT32              num_attr;
+    UINT32              max_attr;
+    BOOLEAN             superseded;
+    struct tCACHE_WRITE *p_next;
+} tCACHE_WRITE;
 
 static FILE* sCacheFD = 0;
+static tCACHE_WRITE *sCacheWrite = NULL;
+
+/* writes posted to the pool and not done yet */
+static pthread_mutex_t sWriteLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sWriteDone = PTHREAD_COND_INITIALIZER;
+static tCACHE_WRITE *sWritesPending = NULL;
 
 static void getFilename(char *buffer, BD_ADDR bda)
 {
@@ -35,13 +64,106 @@ static void getFilename(char *buffer, BD_ADDR bda)
         , bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
 }
 
+static BOOLEAN cacheWriteSuperseded(tCACHE_WRITE *p_write)
+{
+    BOOLEAN superseded;
+
+    pthread_mutex_lock(&sWriteLock);
+    superseded = p_write->superseded;
+    pthread_mutex_unlock(&sWriteLock);
+    return superseded;
+}
+
+static void cacheWrite(void *context)
+{
+    tCACHE_WRITE *p_write = (tCACHE_WRITE *)context;
+    tCACHE_WRITE **pp;
+    char tmp_name[sizeof(p_write->fname) + sizeof(GATT_CACHE_TMP_SUFFIX)];
+    FILE *fd = 0;
+    UINT32 num = 0;
+    int tmp_fd = -1;
+
+    /* a crash while writing leaves the previous cache in place */
+    snprintf(tmp_name, sizeof(tmp_name), "%s%s", p_write->fname, GATT_CACHE_TMP_SUFFIX);
+    if (!cacheWriteSuperseded(p_write))
+        tmp_fd = mkstemp(tmp_name);
+    if (tmp_fd >= 0 && (fd = fdopen(tmp_fd, "w")) == 0)
+    {
+        close(tmp_fd);
+        unlink(tmp_name);
+    }
+    if (fd != 0)
+    {
+        num = fwrite(p_write->p_attr, sizeof(tBTA_GATTC_NV_ATTR), p_write->num_attr, fd);
+        if (fclose(fd) != 0 || num != p_write->num_attr)
+        {
+            unlink(tmp_name);
+            fd = 0;
+        }
+    }
+    BTIF_TRACE_DEBUG("%s() wrote %d of %d", __FUNCTION__, num, p_write->num_attr);
+
+    pthread_mutex_lock(&sWriteLock);
+    /* checked and renamed under the lock, so a newer cache is never replaced */
+    if (fd != 0)
+    {
+        if (p_write->superseded)
+            unlink(tmp_name);
+        else
+            rename(tmp_name, p_write->fname);
+    }
+    for (pp = &sWritesPending; *pp != NULL; pp = &(*pp)->p_next)
+    {
+        if (*pp == p_write)
+        {
+            *pp = p_write->p_next;
+            break;
+        }
+    }
+    if (sWritesPending == NULL)
+        pthread_cond_broadcast(&sWriteDone);
+    pthread_mutex_unlock(&sWriteLock);
+
+    free(p_write->p_attr);
+    free(p_write);
+}
+
+static void cacheWaitWrites()
+{
+    pthread_mutex_lock(&sWriteLock);
+    while (sWritesPending != NULL)
+        pthread_cond_wait(&sWriteDone, &sWriteLock);
+    pthread_mutex_unlock(&sWriteLock);
+}
+
 static void cacheClose()
 {
+    thread_pool_t *pool = btif_thread_pool();
+    tCACHE_WRITE *p_write = sCacheWrite;
+    tCACHE_WRITE *p;
+
     if (sCacheFD != 0)
     {
         fclose(sCacheFD);
         sCacheFD = 0;
     }
+
+    if (p_write == NULL)
+        return;
+    sCacheWrite = NULL;
+
+    pthread_mutex_lock(&sWriteLock);
+    for (p = sWritesPending; p != NULL; p = p->p_next)
+    {
+        if (strcmp(p->fname, p_write->fname) == 0)
+            p->superseded = TRUE;
+    }
+    p_write->p_next = sWritesPending;
+    sWritesPending = p_write;
+    pthread_mutex_unlock(&sWriteLock);
+
+    if (pool == NULL || !thread_pool_post(pool, cacheWrite, p_write, THREAD_POOL_PRIORITY_LOW))
+        cacheWrite(p_write);
 }
 
 static bool cacheOpen(BD_ADDR bda, bool to_save)
@@ -50,7 +172,17 @@ static bool cacheOpen(BD_ADDR bda, bool to_save)
     getFilename(fname, bda);
 
     cacheClose();
-    sCacheFD = fopen(fname, to_save ? "w" : "r");
+    if (to_save)
+    {
+        sCacheWrite = (tCACHE_WRITE *)calloc(1, sizeof(tCACHE_WRITE));
+        if (sCacheWrite != NULL)
+            strlcpy(sCacheWrite->fname, fname, sizeof(sCacheWrite->fname));
+        return (sCacheWrite != NULL);
+    }
+
+    /* a cache still being written is read back complete */
+    cacheWaitWrites();
+    sCacheFD = fopen(fname, "r");
 
     return (sCacheFD != 0);
 }
@@ -59,6 +191,9 @@ static void cacheReset(BD_ADDR bda)
 {
     char fname[255] = {0};
     getFilename(fname, bda);
+
+    /* or a pending write would bring the cache back */
+    cacheWaitWrites();
     unlink(fname);
 }
 
@@ -145,12 +280,37 @@ void bta_gattc_co_cache_save (BD_ADDR server_bda, UINT16 evt, UINT16 num_attr,
                               tBTA_GATTC_NV_ATTR *p_attr_list, UINT16 attr_index, UINT16 conn_id)
 {
     tBTA_GATT_STATUS    status = BTA_GATT_OK;
+    tCACHE_WRITE        *p_write = sCacheWrite;
     UNUSED(attr_index);
 
-    if (sCacheFD != 0)
+    if (p_write != NULL)
     {
-        int num = fwrite(p_attr_list, sizeof(tBTA_GATTC_NV_ATTR), num_attr, sCacheFD);
-        BTIF_TRACE_DEBUG("%s() wrote %d", __FUNCTION__, num);
+        if (p_write->num_attr + num_attr > p_write->max_attr)
+        {
+            UINT32 max_attr = p_write->max_attr ? p_write->max_attr : BTA_GATTC_NV_LOAD_MAX;
+            tBTA_GATTC_NV_ATTR *p_attr;
+
+            while (max_attr < p_write->num_attr + num_attr)
+                max_attr *= 2;
+            p_attr = (tBTA_GATTC_NV_ATTR *)realloc(p_write->p_attr,
+                                                   max_attr * sizeof(tBTA_GATTC_NV_ATTR));
+            if (p_attr == NULL)
+            {
+                /* drop the cache rather than write part of it */
+                BTIF_TRACE_ERROR("%s() unable to hold %d attributes", __FUNCTION__, max_attr);
+                free(p_write->p_attr);
+                free(p_write);
+                sCacheWrite = NULL;
+                bta_gattc_ci_cache_save(server_bda, evt, BTA_GATT_NO_RESOURCES, conn_id);
+                return;
+            }
+            p_write->p_attr = p_attr;
+            p_write->max_attr = max_attr;
+        }
+        memcpy(p_write->p_attr + p_write->num_attr, p_attr_list,
+               num_attr * sizeof(tBTA_GATTC_NV_ATTR));
+        p_write->num_attr += num_attr;
+        BTIF_TRACE_DEBUG("%s() gathered %d", __FUNCTION__, num_attr);
     }
 
     bta_gattc_ci_cache_save(server_bda, evt, status, conn_id);
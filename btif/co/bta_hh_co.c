@@ -20,7 +20,7 @@
 
 #include <ctype.h>
 #include <fcntl.h>
-#include <sys/poll.h>
+#include <sys/epoll.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <string.h>
@@ -35,6 +35,14 @@
 
 const char *dev_path = "/dev/uhid";
 
+/* A single epoll thread services the uhid fds of all connected devices.
+** hh_keep_polling is set while a device's fd is registered with it and is
+** only changed with uhid_reactor_lock held.
+*/
+static pthread_mutex_t uhid_reactor_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t uhid_reactor_once = PTHREAD_ONCE_INIT;
+static int uhid_epoll_fd = -1;
+
 #if (BLE_INCLUDED == TRUE && BTA_HH_LE_INCLUDED == TRUE)
 #include "btif_config.h"
 #define BTA_HH_NV_LOAD_MAX       16
@@ -203,6 +211,9 @@ static int uhid_event(btif_hh_device_t *p_dev)
                                                  strerror(errno));
         return -EFAULT;
     } else if (ret < 0) {
+        /* Stale readiness, the event was already consumed */
+        if (errno == EAGAIN)
+            return -EAGAIN;
         APPL_TRACE_ERROR("%s:Cannot read uhid-cdev: %s", __FUNCTION__,
                                                 strerror(errno));
         return -errno;
@@ -255,80 +266,158 @@ static int uhid_event(btif_hh_device_t *p_dev)
 
 /*******************************************************************************
 **
-** Function create_thread
+** Function uhid_reactor_remove_locked
 **
-** Description creat a select loop
+** Description stop polling the device's uhid fd, uhid_reactor_lock must be held
 **
-** Returns pthread_t
+** Returns void
 **
 *******************************************************************************/
-static inline pthread_t create_thread(void *(*start_routine)(void *), void * arg){
-    APPL_TRACE_DEBUG("create_thread: entered");
-    pthread_attr_t thread_attr;
+static void uhid_reactor_remove_locked(btif_hh_device_t *p_dev)
+{
+    if (!p_dev->hh_keep_polling)
+        return;
 
-    pthread_attr_init(&thread_attr);
-    pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
-    pthread_t thread_id = -1;
-    if ( pthread_create(&thread_id, &thread_attr, start_routine, arg)!=0 )
-    {
-        APPL_TRACE_ERROR("pthread_create : %s", strerror(errno));
-        return -1;
-    }
-    APPL_TRACE_DEBUG("create_thread: thread created successfully");
-    return thread_id;
+    if (epoll_ctl(uhid_epoll_fd, EPOLL_CTL_DEL, p_dev->fd, NULL) < 0)
+        APPL_TRACE_WARNING("%s: Cannot remove fd = %d: %s", __FUNCTION__, p_dev->fd,
+                                                            strerror(errno));
+    p_dev->hh_keep_polling = 0;
 }
 
 /*******************************************************************************
 **
-** Function btif_hh_poll_event_thread
+** Function uhid_reactor_thread
 **
-** Description the polling thread which polls for event from UHID driver
+** Description the polling thread which waits for events from the UHID driver
+**             on every registered device
 **
 ** Returns void
 **
 *******************************************************************************/
-static void *btif_hh_poll_event_thread(void *arg)
+static void *uhid_reactor_thread(void *arg)
 {
-
-    btif_hh_device_t *p_dev = arg;
-    APPL_TRACE_DEBUG("%s: Thread created fd = %d", __FUNCTION__, p_dev->fd);
-    struct pollfd pfds[1];
-    int ret;
-    pfds[0].fd = p_dev->fd;
-    pfds[0].events = POLLIN;
-
-    while(p_dev->hh_keep_polling){
-        ret = poll(pfds, 1, 50);
-        if (ret < 0) {
-            APPL_TRACE_ERROR("%s: Cannot poll for fds: %s\n", __FUNCTION__, strerror(errno));
+    struct epoll_event events[BTIF_HH_MAX_HID];
+    btif_hh_device_t *p_dev;
+    int i, n, ret;
+    UNUSED(arg);
+
+    APPL_TRACE_DEBUG("%s: Thread created epoll fd = %d", __FUNCTION__, uhid_epoll_fd);
+    for (;;) {
+        n = epoll_wait(uhid_epoll_fd, events, BTIF_HH_MAX_HID, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            APPL_TRACE_ERROR("%s: Cannot poll for fds: %s", __FUNCTION__, strerror(errno));
             break;
         }
-        if (pfds[0].revents & POLLIN) {
-            APPL_TRACE_DEBUG("btif_hh_poll_event_thread: POLLIN");
+
+        /* Holding the lock lets close/destroy know no event is being handled
+        ** for a device once they have unregistered it.
+        */
+        pthread_mutex_lock(&uhid_reactor_lock);
+        for (i = 0; i < n; i++) {
+            p_dev = events[i].data.ptr;
+
+            /* Unregistered after epoll_wait returned */
+            if (!p_dev->hh_keep_polling)
+                continue;
+
             ret = uhid_event(p_dev);
-            if (ret){
-                break;
-            }
+            if (ret && ret != -EAGAIN)
+                uhid_reactor_remove_locked(p_dev);
         }
+        pthread_mutex_unlock(&uhid_reactor_lock);
     }
 
-    p_dev->hh_poll_thread_id = -1;
     return 0;
 }
 
-static inline void btif_hh_close_poll_thread(btif_hh_device_t *p_dev)
+/*******************************************************************************
+**
+** Function uhid_reactor_init
+**
+** Description create the epoll set and its thread, run once
+**
+** Returns void
+**
+*******************************************************************************/
+static void uhid_reactor_init(void)
 {
-    APPL_TRACE_DEBUG("%s", __FUNCTION__);
-    p_dev->hh_keep_polling = 0;
-    if(p_dev->hh_poll_thread_id > 0)
-        pthread_join(p_dev->hh_poll_thread_id,NULL);
+    pthread_attr_t thread_attr;
+    pthread_t thread_id;
+
+    uhid_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (uhid_epoll_fd < 0) {
+        APPL_TRACE_ERROR("%s: epoll_create1 : %s", __FUNCTION__, strerror(errno));
+        return;
+    }
 
-    return;
+    pthread_attr_init(&thread_attr);
+    pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread_id, &thread_attr, uhid_reactor_thread, NULL) != 0) {
+        APPL_TRACE_ERROR("%s: pthread_create : %s", __FUNCTION__, strerror(errno));
+        close(uhid_epoll_fd);
+        uhid_epoll_fd = -1;
+    }
+    pthread_attr_destroy(&thread_attr);
+}
+
+/*******************************************************************************
+**
+** Function uhid_reactor_register
+**
+** Description start polling the device's uhid fd for events
+**
+** Returns void
+**
+*******************************************************************************/
+static void uhid_reactor_register(btif_hh_device_t *p_dev)
+{
+    struct epoll_event ev;
+    int flags;
+
+    pthread_once(&uhid_reactor_once, uhid_reactor_init);
+    if (uhid_epoll_fd < 0 || p_dev->fd < 0)
+        return;
+
+    pthread_mutex_lock(&uhid_reactor_lock);
+    if (!p_dev->hh_keep_polling) {
+        /* A stale event must never block the shared thread in read() */
+        flags = fcntl(p_dev->fd, F_GETFL);
+        if (flags >= 0)
+            fcntl(p_dev->fd, F_SETFL, flags | O_NONBLOCK);
+
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = p_dev;
+        if (epoll_ctl(uhid_epoll_fd, EPOLL_CTL_ADD, p_dev->fd, &ev) == 0)
+            p_dev->hh_keep_polling = 1;
+        else
+            APPL_TRACE_ERROR("%s: Cannot add fd = %d: %s", __FUNCTION__, p_dev->fd,
+                                                           strerror(errno));
+    }
+    pthread_mutex_unlock(&uhid_reactor_lock);
+}
+
+static inline void uhid_reactor_unregister(btif_hh_device_t *p_dev)
+{
+    APPL_TRACE_DEBUG("%s", __FUNCTION__);
+    pthread_mutex_lock(&uhid_reactor_lock);
+    uhid_reactor_remove_locked(p_dev);
+    pthread_mutex_unlock(&uhid_reactor_lock);
 }
 
 void bta_hh_co_destroy(int fd)
 {
     struct uhid_event ev;
+    UINT32 i;
+
+    /* Make sure the reactor is done with the fd before it goes away */
+    for (i = 0; i < BTIF_HH_MAX_HID; i++) {
+        if (btif_hh_cb.devices[i].fd == fd)
+            uhid_reactor_unregister(&btif_hh_cb.devices[i]);
+    }
+
     memset(&ev, 0, sizeof(ev));
     ev.type = UHID_DESTROY;
     uhid_write(fd, &ev);
@@ -394,8 +483,7 @@ void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class, tBTA_HH_ATTR_MASK attr_ma
                 }else
                     APPL_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
             }
-            p_dev->hh_keep_polling = 1;
-            p_dev->hh_poll_thread_id = create_thread(btif_hh_poll_event_thread, p_dev);
+            uhid_reactor_register(p_dev);
             break;
         }
         p_dev = NULL;
@@ -420,8 +508,7 @@ void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class, tBTA_HH_ATTR_MASK attr_ma
                                                                     __FUNCTION__,strerror(errno));
                 }else{
                     APPL_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
-                    p_dev->hh_keep_polling = 1;
-                    p_dev->hh_poll_thread_id = create_thread(btif_hh_poll_event_thread, p_dev);
+                    uhid_reactor_register(p_dev);
                 }
 
 
@@ -470,7 +557,7 @@ void bta_hh_co_close(UINT8 dev_handle, UINT8 app_id)
                                                         "dev_status = %d, dev_handle =%d"
                                                         ,__FUNCTION__,p_dev->dev_status
                                                         ,p_dev->dev_handle);
-            btif_hh_close_poll_thread(p_dev);
+            uhid_reactor_unregister(p_dev);
             break;
         }
      }
@@ -576,6 +663,7 @@ void bta_hh_co_send_hid_info(btif_hh_device_t *p_dev, char *dev_name, UINT16 ven
         APPL_TRACE_WARNING("%s: Error: failed to send DSCP, result = %d", __FUNCTION__, result);
 
         /* The HID report descriptor is corrupted. Close the driver. */
+        uhid_reactor_unregister(p_dev);
         close(p_dev->fd);
         p_dev->fd = -1;
     }
@@ -188,7 +188,7 @@ typedef struct
 {
     UINT16 sampling_freq;   /* 44100, 48000 etc */
     UINT16 num_channel;     /* 1 for mono or 2 stereo */
-    UINT8  bit_per_sample;  /* Number of bits per sample (8, 16) */
+    UINT8  bit_per_sample;  /* Number of bits per sample (8, 16, 24 or 32) */
 } tBTIF_AV_MEDIA_FEED_CFG_PCM;
 
 typedef union
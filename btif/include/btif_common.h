@@ -23,6 +23,7 @@
 #include "data_types.h"
 #include "bt_types.h"
 #include "bta_api.h"
+#include "thread_pool.h"
 
 #ifndef LOG_TAG
 #error "LOG_TAG not defined, please add in .c file prior to including bt_common.h"
@@ -179,6 +180,7 @@ tBTA_SERVICE_MASK btif_get_enabled_services_mask(void);
 bt_status_t btif_enable_service(tBTA_SERVICE_ID service_id);
 bt_status_t btif_disable_service(tBTA_SERVICE_ID service_id);
 int btif_is_enabled(void);
+thread_pool_t *btif_thread_pool(void);
 void btif_data_profile_register(int value);
 
 /**
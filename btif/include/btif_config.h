@@ -69,7 +69,10 @@ typedef void (*btif_config_enum_callback)(void* user_data, const char* section,
 int btif_config_enum(btif_config_enum_callback cb, void* user_data);
 
 int btif_config_save();
+/* btif_config_flush writes the config from the btif thread pool, or right
+ * away if there is none; btif_config_flush_sync always writes right away. */
 void btif_config_flush();
+void btif_config_flush_sync();
 
 #ifdef __cplusplus
 }
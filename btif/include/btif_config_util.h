@@ -50,7 +50,9 @@ extern "C" {
 **  Functions
 ********************************************************************************/
 
-int btif_config_save_file(const char* file_name);
+/* returns the config as a malloc'd, NUL terminated xml document of *bytes
+ * bytes, or NULL on failure. Takes the config lock while enumerating. */
+char* btif_config_serialize(int* bytes);
 int btif_config_load_file(const char* file_name);
 int load_bluez_adapter_info(char* adapter_path, int size);
 int load_bluez_linkkeys(const char* adapter_path);
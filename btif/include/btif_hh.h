@@ -68,8 +68,7 @@ typedef struct
     UINT8                         sub_class;
     UINT8                         app_id;
     int                           fd;
-    UINT32                        hh_poll_thread_id;
-    UINT8                         hh_keep_polling;
+    UINT8                         hh_keep_polling; // fd registered with the uhid reactor
     BOOLEAN                       vup_timer_active;
     TIMER_LIST_ENT                vup_timer;
     BOOLEAN                       local_vup; // Indicated locally initiated VUP
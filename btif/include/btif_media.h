@@ -97,6 +97,13 @@ typedef struct
         UINT8 codec_info[AVDT_CODEC_SIZE];
 } tBTIF_MEDIA_SINK_CFG_UPDATE;
 
+/* tBTIF_MEDIA_SW_VOLUME msg structure */
+typedef struct
+{
+        BT_HDR hdr;
+        UINT8 volume; /* AVRCP absolute volume, 0 - 127 */
+} tBTIF_MEDIA_SW_VOLUME;
+
 #ifdef AVK_BACKPORT
 typedef enum {
     BTIF_MEDIA_AUDIOFOCUS_LOSS = 0,
@@ -280,6 +287,7 @@ void btif_a2dp_on_suspend(void);
 void btif_a2dp_on_suspended(tBTA_AV_SUSPEND *p_av);
 void btif_a2dp_set_tx_flush(BOOLEAN enable);
 void btif_a2dp_set_rx_flush(BOOLEAN enable);
+void btif_a2dp_set_sw_volume(UINT8 volume);
 void btif_media_check_iop_exceptions(UINT8 *peer_bda);
 void btif_reset_decoder(UINT8 *p_av);
 BOOLEAN btif_media_task_start_decoding_req(void);
@@ -0,0 +1,217 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2009-2012 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_media_jb.h
+ *
+ *  Description:   A2DP sink jitter buffer and playout engine
+ *
+ *******************************************************************************/
+
+#ifndef BTIF_MEDIA_JB_H
+#define BTIF_MEDIA_JB_H
+
+#include "bt_types.h"
+#include "gki.h"
+
+/*******************************************************************************
+ **  Constants
+ *******************************************************************************/
+
+/* lowest and highest playout delay the jitter buffer adapts between */
+#ifndef BTIF_MEDIA_JB_MIN_MS
+#define BTIF_MEDIA_JB_MIN_MS            40
+#endif
+
+#ifndef BTIF_MEDIA_JB_MAX_MS
+#define BTIF_MEDIA_JB_MAX_MS            300
+#endif
+
+/* longest gap filled by loss concealment, in SBC frames; a longer gap is
+ * skipped over and an underrun this long sends the engine back to
+ * prebuffering */
+#ifndef BTIF_MEDIA_JB_PLC_MAX_FRAMES
+#define BTIF_MEDIA_JB_PLC_MAX_FRAMES    24
+#endif
+
+/* largest playout-rate correction, in 1/1000 of the sample rate */
+#ifndef BTIF_MEDIA_JB_MAX_RATE_ADJ
+#define BTIF_MEDIA_JB_MAX_RATE_ADJ      5
+#endif
+
+#define BTIF_MEDIA_JB_MAX_FRAME_SAMPLES 128     /* 16 blocks * 8 subbands */
+#define BTIF_MEDIA_JB_MAX_CHANNELS      2
+#define BTIF_MEDIA_JB_MAX_TICK_SAMPLES  1920    /* 40 ms at 48 kHz */
+
+/* PCM samples per channel held between ticks */
+#define BTIF_MEDIA_JB_FIFO_SAMPLES      (BTIF_MEDIA_JB_MAX_TICK_SAMPLES * 11 / 10 + \
+                                         2 * BTIF_MEDIA_JB_MAX_FRAME_SAMPLES)
+
+/* RTP time stamp of a queued packet, kept at the start of its offset area */
+#define BTIF_MEDIA_JB_PKT_TS(p)         (*(UINT32 *)((p) + 1))
+
+/* engine states */
+#define BTIF_MEDIA_JB_IDLE              0   /* not yet configured, nothing played */
+#define BTIF_MEDIA_JB_PREBUFFER         1   /* filling up to the target delay */
+#define BTIF_MEDIA_JB_PLAYING           2
+
+/*******************************************************************************
+ **  Data types
+ *******************************************************************************/
+
+/* Queued SBC media packet.  Laid out like BT_HDR: offset points to the A2DP
+ * media payload header, layer_specific holds the RTP sequence number. */
+typedef struct
+{
+    UINT16 num_frames_to_be_processed;
+    UINT16 len;
+    UINT16 offset;
+    UINT16 layer_specific;
+} tBT_SBC_HDR;
+
+/* Decode one SBC frame at *pp_data, advancing *pp_data and *p_len past it.
+ * Returns the number of PCM bytes written to p_pcm, 0 on failure. */
+typedef UINT32 (tBTIF_MEDIA_JB_DECODE)(const UINT8 **pp_data, UINT32 *p_len,
+                                       INT16 *p_pcm, UINT32 pcm_bytes);
+
+typedef struct
+{
+    UINT32  pkts;               /* packets received */
+    UINT32  late;               /* packets dropped as too late to play */
+    UINT32  dups;               /* duplicate packets dropped */
+    UINT32  reordered;          /* packets received out of order */
+    UINT32  overflow;           /* packets dropped as the queue was full */
+    UINT32  frames;             /* SBC frames decoded */
+    UINT32  lost_frames;        /* frames concealed for lost packets */
+    UINT32  underrun_frames;    /* frames concealed for an empty queue */
+    UINT32  skips;              /* gaps too long to conceal */
+    UINT32  rebuffers;          /* times the engine had to prebuffer again */
+    INT32   rate_adj;           /* net samples dropped (>0) or added (<0) */
+    UINT32  max_target;         /* highest target delay, samples */
+} tBTIF_MEDIA_JB_STATS;
+
+typedef struct
+{
+    BUFFER_Q                q;              /* packets in sequence order */
+    tBT_SBC_HDR             *p_cur;         /* packet being played */
+    tBTIF_MEDIA_JB_DECODE   *p_decode;
+    UINT32                  rate;           /* sample rate, also the RTP clock */
+    UINT16                  frame_samples;  /* samples per channel per SBC frame */
+    UINT16                  tick_samples;   /* samples per channel per render */
+    UINT8                   channels;
+    UINT8                   state;
+
+    /* receive side, updated by btif_media_jb_put() */
+    BOOLEAN                 rx_valid;
+    UINT16                  rx_seq;         /* highest sequence number seen */
+    UINT32                  rx_rtp;         /* its RTP time stamp */
+    UINT32                  rx_ts;          /* its position on the playout timeline */
+    UINT8                   rx_frames;      /* its number of frames */
+    UINT32                  queued;         /* samples per channel in q */
+    INT32                   min_transit;    /* least arrival - time stamp seen */
+    INT32                   last_transit;
+    UINT32                  jitter;         /* RFC 3550 interarrival jitter, samples << 4 */
+    UINT32                  peak_late;      /* decaying peak of arrival lateness */
+    UINT32                  target;         /* target playout delay, samples */
+
+    /* playout side, updated by btif_media_jb_render() */
+    BOOLEAN                 primed;         /* output started since the last flush */
+    BOOLEAN                 play_valid;
+    UINT32                  play_ts;        /* time stamp of the next frame to play */
+    UINT32                  avg_depth;      /* smoothed buffered samples << 4 */
+    UINT8                   plc_run;        /* frames concealed in a row */
+    UINT16                  plc_gain;       /* Q15 gain of the next concealed frame */
+    UINT16                  last_len;       /* samples per channel in last_pcm */
+    UINT16                  fifo_len;       /* samples per channel in fifo */
+    INT16                   last_pcm[BTIF_MEDIA_JB_MAX_FRAME_SAMPLES * BTIF_MEDIA_JB_MAX_CHANNELS];
+    INT16                   fifo[BTIF_MEDIA_JB_FIFO_SAMPLES * BTIF_MEDIA_JB_MAX_CHANNELS];
+
+    tBTIF_MEDIA_JB_STATS    stats;
+} tBTIF_MEDIA_JB;
+
+/*******************************************************************************
+ **  Functions
+ *******************************************************************************/
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_init
+ **
+ ** Description      Configure the engine for a new stream.  Any queued data
+ **                  is dropped.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_jb_init(tBTIF_MEDIA_JB *p_jb, tBTIF_MEDIA_JB_DECODE *p_decode,
+                               UINT32 rate, UINT8 channels, UINT16 frame_samples,
+                               UINT16 tick_ms);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_flush
+ **
+ ** Description      Drop all queued data and go back to prebuffering.  The
+ **                  stream configuration is kept.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_jb_flush(tBTIF_MEDIA_JB *p_jb);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_put
+ **
+ ** Description      Queue a received media packet.  The RTP time stamp must be
+ **                  stored with BTIF_MEDIA_JB_PKT_TS().  The engine takes
+ **                  ownership of the buffer.  May be called from a different
+ **                  task than btif_media_jb_render().
+ **
+ ** Returns          Number of packets queued.
+ **
+ *******************************************************************************/
+extern UINT8 btif_media_jb_put(tBTIF_MEDIA_JB *p_jb, tBT_SBC_HDR *p_pkt, UINT64 arrival_us);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_render
+ **
+ ** Description      Produce one tick of interleaved PCM into p_pcm, which must
+ **                  hold tick_samples * channels samples.  Lost and missing
+ **                  frames are concealed, and the playout rate is nudged to
+ **                  keep the buffered delay at the adaptive target.
+ **
+ ** Returns          Number of PCM bytes written; 0 before playback started.
+ **
+ *******************************************************************************/
+extern UINT32 btif_media_jb_render(tBTIF_MEDIA_JB *p_jb, INT16 *p_pcm);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_dump_stats
+ **
+ ** Description      Log the engine counters.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_jb_dump_stats(tBTIF_MEDIA_JB *p_jb);
+
+#endif /* BTIF_MEDIA_JB_H */
@@ -0,0 +1,173 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2009-2012 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_media_pcm.h
+ *
+ *  Description:   A2DP source PCM stage: sample format conversion, software
+ *                 volume, dithering and channel mapping ahead of the SBC
+ *                 encoder
+ *
+ *******************************************************************************/
+
+#ifndef BTIF_MEDIA_PCM_H
+#define BTIF_MEDIA_PCM_H
+
+#include "bt_types.h"
+
+/*******************************************************************************
+ **  Constants
+ *******************************************************************************/
+
+/* source sample formats, all interleaved and in host byte order */
+#define BTIF_MEDIA_PCM_FMT_U8           0
+#define BTIF_MEDIA_PCM_FMT_S16          1
+#define BTIF_MEDIA_PCM_FMT_S24          2   /* packed, 3 bytes per sample */
+#define BTIF_MEDIA_PCM_FMT_S32          3
+#define BTIF_MEDIA_PCM_FMT_FLOAT        4   /* full scale is +/-1.0 */
+
+/* gains are Q15, this one leaves 16 bit samples untouched */
+#define BTIF_MEDIA_PCM_UNITY_GAIN       0x8000
+
+/* number of frames a gain change is spread over */
+#ifndef BTIF_MEDIA_PCM_RAMP_FRAMES
+#define BTIF_MEDIA_PCM_RAMP_FRAMES      512
+#endif
+
+/* add triangular noise of +/-1 LSB whenever samples are requantized */
+#ifndef BTIF_MEDIA_PCM_DITHER
+#define BTIF_MEDIA_PCM_DITHER           TRUE
+#endif
+
+/*******************************************************************************
+ **  Data types
+ *******************************************************************************/
+
+typedef struct
+{
+    UINT8   fmt;            /* BTIF_MEDIA_PCM_FMT_xxx of the source */
+    UINT8   channels;       /* source channels, 1 or 2 */
+    UINT16  target;         /* Q15 gain being ramped to */
+    INT32   gain;           /* current gain, Q30 */
+    INT32   step;           /* gain change per frame while ramping, Q30 */
+    UINT16  ramp_left;      /* frames left in the ramp */
+    UINT32  noise_pos;      /* position in the dither sequence */
+} tBTIF_MEDIA_PCM;
+
+/*******************************************************************************
+ **  Functions
+ *******************************************************************************/
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_init
+ **
+ ** Description      Reset the stage to 16 bit stereo at unity gain.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_pcm_init(tBTIF_MEDIA_PCM *p_pcm);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_config
+ **
+ ** Description      Set the source format.  The gain is kept.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_pcm_config(tBTIF_MEDIA_PCM *p_pcm, UINT8 fmt, UINT8 channels);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_bits_to_fmt
+ **
+ ** Description      Map an integer PCM bit depth to a source format.
+ **
+ ** Returns          BTIF_MEDIA_PCM_FMT_xxx, S16 for unknown depths
+ **
+ *******************************************************************************/
+extern UINT8 btif_media_pcm_bits_to_fmt(UINT8 bit_per_sample);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_frame_size
+ **
+ ** Description      Size of one source frame (a sample for every channel).
+ **
+ ** Returns          Number of bytes
+ **
+ *******************************************************************************/
+extern UINT32 btif_media_pcm_frame_size(const tBTIF_MEDIA_PCM *p_pcm);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_volume_to_gain
+ **
+ ** Description      Map an AVRCP absolute volume (0 - 127) to a Q15 gain
+ **                  along a square law curve.
+ **
+ ** Returns          Q15 gain
+ **
+ *******************************************************************************/
+extern UINT16 btif_media_pcm_volume_to_gain(UINT8 volume);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_set_gain
+ **
+ ** Description      Ramp to a new Q15 gain, at most BTIF_MEDIA_PCM_UNITY_GAIN,
+ **                  over the next BTIF_MEDIA_PCM_RAMP_FRAMES frames.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_pcm_set_gain(tBTIF_MEDIA_PCM *p_pcm, UINT16 gain);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_process
+ **
+ ** Description      Turn num_frames source frames at p_buf into 16 bit samples
+ **                  with out_channels channels, in place.  Mono is duplicated
+ **                  to stereo and stereo averaged down to mono.  The buffer
+ **                  must be 16 bit aligned and hold the larger of the source
+ **                  and the converted block.
+ **
+ ** Returns          Number of bytes of converted samples
+ **
+ *******************************************************************************/
+extern UINT32 btif_media_pcm_process(tBTIF_MEDIA_PCM *p_pcm, void *p_buf,
+                                     UINT32 num_frames, UINT8 out_channels);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_downmix
+ **
+ ** Description      Average num_frames interleaved 16 bit stereo frames down
+ **                  to mono, in place.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_pcm_downmix(INT16 *p_pcm, UINT32 num_frames);
+
+#endif /* BTIF_MEDIA_PCM_H */
@@ -29,6 +29,7 @@
 
 #include "btif_pan.h"
 #include "bt_types.h"
+#include "gki.h"
 
 /*******************************************************************************
 **  Constants & Macros
@@ -81,8 +82,7 @@ typedef struct
     int open_count;
     int flow; // 1: outbound data flow on; 0: outbound data flow off
     btpan_conn_t conns[MAX_PAN_CONNS];
-    int congest_packet_size;
-    unsigned char congest_packet[1600]; //max ethernet packet size
+    BUFFER_Q rx_q; // frames read from TAP by the reader thread, waiting for BTU
 } btpan_cb_t;
 
 
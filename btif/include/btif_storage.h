@@ -152,6 +152,17 @@ bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr);
 *******************************************************************************/
 BOOLEAN btif_storage_is_device_bonded(bt_bdaddr_t *remote_bd_addr);
 
+/*******************************************************************************
+**
+** Function         btif_storage_get_num_bonded_devices
+**
+** Description      BTIF storage API - counts the bonded devices in NVRAM
+**
+** Returns          Number of bonded devices
+**
+*******************************************************************************/
+uint32_t btif_storage_get_num_bonded_devices(void);
+
 /*******************************************************************************
 **
 ** Function         btif_storage_remove_bonded_device
@@ -457,4 +468,42 @@ bt_status_t btif_storage_set_hidd(bt_bdaddr_t *remote_bd_addr);
 
 bt_status_t btif_storage_remove_hidd(bt_bdaddr_t *remote_bd_addr);
 
+/*******************************************************************************
+**
+** Function         btif_storage_register_sdp_cache
+**
+** Description      Registers NVRAM storage for the SDP search result cache
+**
+** Returns          void
+**
+*******************************************************************************/
+
+void btif_storage_register_sdp_cache(void);
+
+/*******************************************************************************
+**
+** Function         btif_storage_register_ctrl_caps
+**
+** Description      Registers NVRAM storage for the controller capabilities
+**                  read on enable
+**
+** Returns          void
+**
+*******************************************************************************/
+
+void btif_storage_register_ctrl_caps(void);
+
+/*******************************************************************************
+**
+** Function         btif_storage_register_dev_loader
+**
+** Description      Registers NVRAM as the backing store of the BTM security
+**                  database, so bonded devices are paged in on demand
+**
+** Returns          void
+**
+*******************************************************************************/
+
+void btif_storage_register_dev_loader(void);
+
 #endif /* BTIF_STORAGE_H */
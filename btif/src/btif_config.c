@@ -50,6 +50,7 @@
 #include "btif_sock_thread.h"
 #include "btif_sock_util.h"
 #include "btif_util.h"
+#include "journal.h"
 
 //#define UNIT_TEST
 #define CFG_PATH "/data/misc/bluedroid/"
@@ -57,6 +58,7 @@
 #define CFG_FILE_EXT ".xml"
 #define CFG_FILE_EXT_OLD ".old"
 #define CFG_FILE_EXT_NEW ".new"
+#define CFG_FILE_EXT_JOURNAL ".journal"
 #define CFG_GROW_SIZE (10*sizeof(cfg_node))
 #define GET_CHILD_MAX_COUNT(node) (short)((int)(node)->bytes / sizeof(cfg_node))
 #define GET_CHILD_COUNT(p) (short)((int)(p)->used / sizeof(cfg_node))
@@ -67,6 +69,21 @@
 #define MAX_NODE_BYTES 32000
 #define CFG_CMD_SAVE 1
 
+/* journal record types */
+#define CFG_JOURNAL_SET 1
+#define CFG_JOURNAL_REMOVE 2
+/* op, type, and the section, key and name terminators */
+#define CFG_JOURNAL_HDR_BYTES 6
+
+/* the xml snapshot is only rewritten once the journal has grown this big */
+#ifndef CFG_JOURNAL_COMPACT_SIZE
+#define CFG_JOURNAL_COMPACT_SIZE (64*1024)
+#endif
+/* changes made within this window are written with a single fsync */
+#ifndef CFG_JOURNAL_SYNC_DELAY_MS
+#define CFG_JOURNAL_SYNC_DELAY_MS 200
+#endif
+
 #ifndef FALSE
 #define TRUE 1
 #define FALSE 0
@@ -86,10 +103,15 @@ typedef struct cfg_node_s
 } cfg_node;
 
 static pthread_mutex_t slot_lock;
+//serializes writes of the snapshot, always taken before slot_lock
+static pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
 static int pth = -1; //poll thread handle
 static cfg_node root;
 static int cached_change;
 static int save_cmds_queued;
+static journal_t* cfg_journal;
+static int cfg_compact_needed;
+static int flush_queued;
 static void cfg_cmd_callback(int cmd_fd, int type, int flags, uint32_t user_id);
 static inline short alloc_node(cfg_node* p, short grow);
 static inline void free_node(cfg_node* p);
@@ -101,7 +123,13 @@ static inline cfg_node* find_free_node(cfg_node* p);
 static int set_node(const char* section, const char* key, const char* name,
                         const char* value, short bytes, short type);
 static int save_cfg();
+static int write_cfg(const char* file_name, const char* data, int bytes);
+static int sync_cfg();
+static void flush_cfg(void* context);
+static int compact_due();
 static void load_cfg();
+static void journal_node(int op, const char* section, const char* key, const char* name,
+                         const char* value, short bytes, short type);
 static short find_next_node(const cfg_node* p, short start, char* name, int* bytes);
 #ifdef UNIT_TEST
 static void cfg_test_load();
@@ -134,6 +162,7 @@ int btif_config_init()
             bdle("%s does not exist, need provision", CFG_PATH);
         btsock_thread_init();
         init_slot_lock(&slot_lock);
+        pthread_mutex_lock(&save_lock);
         lock_slot(&slot_lock);
         root.name = "Bluedroid";
         alloc_node(&root, CFG_GROW_SIZE);
@@ -141,6 +170,7 @@ int btif_config_init()
         pth = btsock_thread_create(NULL, cfg_cmd_callback);
         load_cfg();
         unlock_slot(&slot_lock);
+        pthread_mutex_unlock(&save_lock);
         #ifdef UNIT_TEST
             cfg_test_write();
             //cfg_test_read();
@@ -228,7 +258,10 @@ int btif_config_set(const char* section, const char* key, const char* name, cons
         lock_slot(&slot_lock);
         ret = set_node(section, key, name, value, (short)bytes, (short)type);
         if(ret && !(type & BTIF_CFG_TYPE_VOLATILE))
+        {
+            journal_node(CFG_JOURNAL_SET, section, key, name, value, (short)bytes, (short)type);
             cached_change++;
+        }
         unlock_slot(&slot_lock);
     }
     return ret;
@@ -243,7 +276,10 @@ int btif_config_remove(const char* section, const char* key, const char* name)
          lock_slot(&slot_lock);
          ret = remove_node(section, key, name);
          if(ret)
+         {
+            journal_node(CFG_JOURNAL_REMOVE, section, key, name, NULL, 0, 0);
             cached_change++;
+         }
          unlock_slot(&slot_lock);
     }
     return ret;
@@ -260,7 +296,11 @@ int btif_config_filter_remove(const char* section, const char* filter[], int fil
          lock_slot(&slot_lock);
          ret = remove_filter_node(section, filter, filter_count, max_allowed);
          if(ret)
+         {
+            //too many nodes to journal one by one, rewrite the snapshot instead
+            cfg_compact_needed = TRUE;
             cached_change++;
+         }
          unlock_slot(&slot_lock);
     }
     return ret;
@@ -358,10 +398,35 @@ int btif_config_save()
 }
 void btif_config_flush()
 {
+    thread_pool_t* pool = btif_thread_pool();
+    int post = FALSE;
+    if(!pool)
+    {
+        btif_config_flush_sync();
+        return;
+    }
+    //a queued flush has not taken its snapshot yet and will see these changes
     lock_slot(&slot_lock);
-    if(cached_change > 0)
-        save_cfg();
+    if(!flush_queued)
+        post = flush_queued = TRUE;
     unlock_slot(&slot_lock);
+    if(post && !thread_pool_post(pool, flush_cfg, NULL, THREAD_POOL_PRIORITY_NORMAL))
+    {
+        bdle("unable to post the flush, writing the config now");
+        flush_cfg(NULL);
+    }
+}
+void btif_config_flush_sync()
+{
+    int pending;
+    pthread_mutex_lock(&save_lock);
+    lock_slot(&slot_lock);
+    //fold the journal into the snapshot while we are at it
+    pending = cached_change > 0 || cfg_compact_needed || (cfg_journal && journal_size(cfg_journal) > 0);
+    unlock_slot(&slot_lock);
+    if(pending)
+        save_cfg();
+    pthread_mutex_unlock(&save_lock);
 }
 /////////////////////////////////////////////////////////////////////////////////////////////
 static inline short alloc_node(cfg_node* p, short grow)
@@ -693,28 +758,180 @@ static int remove_filter_node(const char* section, const char* filter[], int fil
     return FALSE;
 }
 
+//the caller holds save_lock. slot_lock is only held while the tree is
+//serialized, so setters are not blocked while the file is written.
 static int save_cfg()
 {
     const char* file_name = CFG_PATH CFG_FILE_NAME CFG_FILE_EXT;
     const char* file_name_new = CFG_PATH CFG_FILE_NAME CFG_FILE_EXT_NEW;
     const char* file_name_old = CFG_PATH CFG_FILE_NAME CFG_FILE_EXT_OLD;
     int ret = FALSE;
+    int bytes = 0;
+    lock_slot(&slot_lock);
+    int saved_change = cached_change;
+    char* xml = btif_config_serialize(&bytes);
+    if(xml)
+        cached_change = 0;
+    unlock_slot(&slot_lock);
+    if(!xml)
+    {
+        bdle("btif_config_serialize failed");
+        return FALSE;
+    }
     if(access(file_name_old,  F_OK) == 0)
         unlink(file_name_old);
     if(access(file_name_new, F_OK) == 0)
         unlink(file_name_new);
-   if(btif_config_save_file(file_name_new))
+    if(write_cfg(file_name_new, xml, bytes))
     {
-        cached_change = 0;
         chown(file_name_new, -1, AID_NET_BT_STACK);
         chmod(file_name_new, 0660);
         rename(file_name, file_name_old);
         rename(file_name_new, file_name);
         ret = TRUE;
     }
-    else bdle("btif_config_save_file failed");
+    else bdle("unable to write %s", file_name_new);
+    free(xml);
+    lock_slot(&slot_lock);
+    if(!ret)
+        cached_change += saved_change;
+    else if(cached_change == 0)
+    {
+        //the snapshot now holds everything, the journal can go. A crash before
+        //this point only replays changes the snapshot already has. Changes
+        //made while the file was written keep the journal, and the compaction
+        //if they were not journaled, for the next save.
+        cfg_compact_needed = FALSE;
+        if(cfg_journal)
+            journal_reset(cfg_journal);
+    }
+    unlock_slot(&slot_lock);
+    return ret;
+}
+static int write_cfg(const char* file_name, const char* data, int bytes)
+{
+    int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0660);
+    if(fd < 0)
+        return FALSE;
+    while(bytes > 0)
+    {
+        ssize_t n = write(fd, data, bytes);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            break;
+        data += n;
+        bytes -= n;
+    }
+    //the rename over the old snapshot must not land before the data does
+    int ret = bytes == 0 && fsync(fd) == 0;
+    close(fd);
+    return ret;
+}
+static int compact_due()
+{
+    return !cfg_journal || cfg_compact_needed ||
+           journal_size(cfg_journal) >= CFG_JOURNAL_COMPACT_SIZE;
+}
+static int sync_cfg()
+{
+    int ret = FALSE;
+    pthread_mutex_lock(&save_lock);
+    lock_slot(&slot_lock);
+    int full = compact_due();
+    if(!full)
+    {
+        if(journal_sync(cfg_journal))
+        {
+            cached_change = 0;
+            ret = TRUE;
+        }
+        else
+        {
+            bdle("journal sync failed, writing the full config instead");
+            full = TRUE;
+        }
+    }
+    unlock_slot(&slot_lock);
+    if(full)
+        ret = save_cfg();
+    pthread_mutex_unlock(&save_lock);
     return ret;
 }
+static void flush_cfg(void* context)
+{
+    UNUSED(context);
+    lock_slot(&slot_lock);
+    flush_queued = FALSE;
+    unlock_slot(&slot_lock);
+    btif_config_flush_sync();
+}
+static void journal_node(int op, const char* section, const char* key, const char* name,
+                         const char* value, short bytes, short type)
+{
+    if(!cfg_journal || cfg_compact_needed)
+        return;
+    if(!name)
+        name = "";
+    if(!value || bytes < 0)
+        bytes = 0;
+    int section_len = strlen(section), key_len = strlen(key), name_len = strlen(name);
+    int len = CFG_JOURNAL_HDR_BYTES + section_len + key_len + name_len + bytes;
+    char* rec = (char*)malloc(len);
+    if(rec)
+    {
+        char* p = rec;
+        *p++ = (char)op;
+        *p++ = (char)(type & 0xff);
+        *p++ = (char)((type >> 8) & 0xff);
+        memcpy(p, section, section_len + 1);
+        p += section_len + 1;
+        memcpy(p, key, key_len + 1);
+        p += key_len + 1;
+        memcpy(p, name, name_len + 1);
+        p += name_len + 1;
+        if(bytes > 0)
+            memcpy(p, value, bytes);
+    }
+    if(!rec || !journal_append(cfg_journal, rec, len))
+    {
+        bdle("unable to journal %s:%s:%s, writing the full config instead", section, key, name);
+        cfg_compact_needed = TRUE;
+    }
+    free(rec);
+}
+static const char* next_journal_str(const char** p, const char* end)
+{
+    const char* str = *p;
+    const char* nul = (const char*)memchr(str, 0, end - str);
+    if(!nul)
+        return NULL;
+    *p = nul + 1;
+    return str;
+}
+static void replay_journal_record(const void* record, size_t length, void* context)
+{
+    UNUSED(context);
+    const char* p = (const char*)record;
+    const char* end = p + length;
+    const char *section, *key, *name;
+    if(length < CFG_JOURNAL_HDR_BYTES)
+        return;
+    int op = (unsigned char)p[0];
+    short type = (short)((unsigned char)p[1] | ((unsigned char)p[2] << 8));
+    p += 3;
+    if(!(section = next_journal_str(&p, end)) || !(key = next_journal_str(&p, end)) ||
+       !(name = next_journal_str(&p, end)) || !*section || !*key)
+    {
+        bdle("malformed journal record, length:%d", (int)length);
+        return;
+    }
+    if(op == CFG_JOURNAL_SET && *name && end - p < MAX_NODE_BYTES)
+        set_node(section, key, name, p, (short)(end - p), type);
+    else if(op == CFG_JOURNAL_REMOVE)
+        remove_node(section, key, *name ? name : NULL);
+    else bdle("unknown journal record, op:%d, length:%d", op, (int)length);
+}
 
 static int load_bluez_cfg()
 {
@@ -774,6 +991,7 @@ static void load_cfg()
     const char* file_name = CFG_PATH CFG_FILE_NAME CFG_FILE_EXT;
     const char* file_name_new = CFG_PATH CFG_FILE_NAME CFG_FILE_EXT_NEW;
     const char* file_name_old = CFG_PATH CFG_FILE_NAME CFG_FILE_EXT_OLD;
+    const char* file_name_journal = CFG_PATH CFG_FILE_NAME CFG_FILE_EXT_JOURNAL;
     if(!btif_config_load_file(file_name))
     {
         unlink(file_name);
@@ -784,6 +1002,17 @@ static void load_cfg()
                 remove_bluez_cfg();
         }
     }
+    //bring the snapshot up to date with the changes made since it was written
+    size_t replayed = journal_replay(file_name_journal, replay_journal_record, NULL);
+    if(replayed)
+        bdld("replayed %d journal records", (int)replayed);
+    cfg_journal = journal_open(file_name_journal);
+    if(cfg_journal)
+    {
+        chown(file_name_journal, -1, AID_NET_BT_STACK);
+        chmod(file_name_journal, 0660);
+    }
+    else bdle("unable to open %s, every save will write the full config", file_name_journal);
     int bluez_migration_done = 0;
     btif_config_get_int("Local", "Adapter", "BluezMigrationDone", &bluez_migration_done);
     if(!bluez_migration_done)
@@ -812,9 +1041,20 @@ static void cfg_cmd_callback(int cmd_fd, int type, int size, uint32_t user_id)
             bdla(save_cmds_queued > 0);
             save_cmds_queued--;
             last_cached_change = cached_change;
-            //hold the file saving until no more change in last 3 seconds.
-            bdld("wait until no more changes in short time, cached change:%d", cached_change);
-            for(i = 0; i < 100; i ++) //5 minutes max waiting
+            if(!compact_due())
+            {
+                //appending to the journal is cheap, only gather the changes
+                //of a short burst so they share one fsync
+                unlock_slot(&slot_lock);
+                usleep(CFG_JOURNAL_SYNC_DELAY_MS * 1000);
+                lock_slot(&slot_lock);
+            }
+            else
+            {
+                //a full rewrite is due, hold it until no more change in last 3 seconds.
+                bdld("wait until no more changes in short time, cached change:%d", cached_change);
+            }
+            for(i = 0; i < 100 && compact_due(); i ++) //5 minutes max waiting
             {
                 // don't sleep if there is nothing to do
                 if(cached_change == 0)
@@ -827,10 +1067,12 @@ static void cfg_cmd_callback(int cmd_fd, int type, int size, uint32_t user_id)
                     break;
                 last_cached_change = cached_change;
             }
-            bdld("writing the bt_config.xml now, cached change:%d", cached_change);
-            if(cached_change > 0)
-                save_cfg();
+            bdld("writing the bt_config now, cached change:%d", cached_change);
+            int pending = cached_change > 0 || cfg_compact_needed;
+            //save_lock goes before slot_lock
             unlock_slot(&slot_lock);
+            if(pending)
+                sync_cfg();
             break;
         }
     }
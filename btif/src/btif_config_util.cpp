@@ -183,19 +183,27 @@ static inline void reverse_bin(char *bin, int size)
     }
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
-int btif_config_save_file(const char* file_name)
+char* btif_config_serialize(int* bytes)
 {
-    debug("in file name:%s", file_name);
     XMLDocument xml;
     XMLElement* root = xml.NewElement(BLUEDROID_ROOT);
     xml.InsertFirstChild(root);
-    int ret = FALSE;
     enum_user_data data;
     memset(&data, 0, sizeof(data));
     data.xml = &xml;
-    if(btif_config_enum(enum_config, &data))
-        ret = xml.SaveFile(file_name) == XML_SUCCESS;
-    return ret;
+    if(!btif_config_enum(enum_config, &data))
+        return NULL;
+    //same layout SaveFile writes
+    XMLPrinter printer;
+    xml.Print(&printer);
+    char* text = (char*)malloc(printer.CStrSize());
+    if(text)
+    {
+        memcpy(text, printer.CStr(), printer.CStrSize());
+        *bytes = printer.CStrSize() - 1;
+    }
+    else error("unable to allocate %d bytes", printer.CStrSize());
+    return text;
 }
 int btif_config_load_file(const char* file_name)
 {
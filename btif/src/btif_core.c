@@ -68,6 +68,11 @@
 
 #define BTIF_TASK_STR        ((INT8 *) "BTIF")
 
+/* workers for the work moved off the btif and btu tasks, 0 for one per CPU */
+#ifndef BTIF_THREAD_POOL_SIZE
+#define BTIF_THREAD_POOL_SIZE      0
+#endif
+
 /************************************************************************************
 **  Local type definitions
 ************************************************************************************/
@@ -111,6 +116,8 @@ bt_bdaddr_t btif_local_bd_addr;
 
 static UINT32 btif_task_stack[(BTIF_TASK_STACK_SIZE + 3) / 4];
 
+static thread_pool_t *btif_pool = NULL;
+
 /* holds main adapter state */
 static btif_core_state_t btif_core_state = BTIF_CORE_STATE_DISABLED;
 
@@ -308,6 +315,9 @@ static void btif_task(UINT32 params)
             #if (BLE_INCLUDED == TRUE)
             btif_dm_load_ble_local_keys();
             #endif
+            btif_storage_register_sdp_cache();
+            btif_storage_register_ctrl_caps();
+            btif_storage_register_dev_loader();
             BTA_EnableBluetooth(bte_dm_evt);
         }
 
@@ -483,6 +493,23 @@ static void btif_fetch_local_bdaddr(bt_bdaddr_t *local_addr)
 **
 *****************************************************************************/
 
+/*******************************************************************************
+**
+** Function         btif_thread_pool
+**
+** Description      Pool for work that need not run on the btif or btu tasks,
+**                  such as writing the config and the GATT caches
+**
+** Returns          The pool, NULL before init, after shutdown or if it could
+**                  not be created
+**
+*******************************************************************************/
+
+thread_pool_t *btif_thread_pool(void)
+{
+    return btif_pool;
+}
+
 /*******************************************************************************
 **
 ** Function         btif_init_bluetooth
@@ -496,6 +523,15 @@ static void btif_fetch_local_bdaddr(bt_bdaddr_t *local_addr)
 bt_status_t btif_init_bluetooth()
 {
     UINT8 status;
+
+    /* btif_config writes through the pool from its first save on */
+    if (btif_pool == NULL)
+    {
+        btif_pool = thread_pool_new("btif_pool", BTIF_THREAD_POOL_SIZE);
+        if (btif_pool == NULL)
+            BTIF_TRACE_WARNING("unable to create the thread pool, offloaded work runs inline");
+    }
+
     btif_config_init();
     bte_main_boot_entry();
 
@@ -699,7 +735,7 @@ bt_status_t btif_disable_bluetooth(void)
 
     status = BTA_DisableBluetooth();
 
-    btif_config_flush();
+    btif_config_flush_sync();
 
     /* clear the adv instances on bt turn off */
     btif_gattc_destroy_multi_adv_cb(INVALID_CLIENT_IF);
@@ -825,6 +861,10 @@ bt_status_t btif_shutdown_bluetooth(void)
     }
     unlock_slot(&mutex_bt_disable);
 
+    /* runs the config and GATT cache writes still queued */
+    thread_pool_free(btif_pool);
+    btif_pool = NULL;
+
     bt_utils_cleanup();
 
     BTIF_TRACE_DEBUG("%s done", __FUNCTION__);
@@ -949,10 +989,17 @@ static bt_status_t btif_in_get_adapter_properties(void)
     bt_bdname_t name;
     bt_scan_mode_t mode;
     uint32_t disc_timeout;
-    bt_bdaddr_t bonded_devices[BTM_SEC_MAX_DEVICE_RECORDS];
+    bt_bdaddr_t *bonded_devices;
+    uint32_t num_bonded_devices;
     bt_uuid_t local_uuids[BT_MAX_NUM_UUIDS];
     num_props = 0;
 
+    /* the bonded devices are not limited to what BTM holds at a time */
+    num_bonded_devices = btif_storage_get_num_bonded_devices();
+    bonded_devices = (bt_bdaddr_t *)malloc((num_bonded_devices + 1) * sizeof(bt_bdaddr_t));
+    if (bonded_devices == NULL)
+        return BT_STATUS_NOMEM;
+
     /* BD_ADDR */
     BTIF_STORAGE_FILL_PROPERTY(&properties[num_props], BT_PROPERTY_BDADDR,
                                sizeof(addr), &addr);
@@ -979,7 +1026,7 @@ static bt_status_t btif_in_get_adapter_properties(void)
 
     /* BONDED_DEVICES */
     BTIF_STORAGE_FILL_PROPERTY(&properties[num_props], BT_PROPERTY_ADAPTER_BONDED_DEVICES,
-                               sizeof(bonded_devices), bonded_devices);
+                               num_bonded_devices * sizeof(bt_bdaddr_t), bonded_devices);
     btif_storage_get_adapter_property(&properties[num_props]);
     num_props++;
 
@@ -992,6 +1039,7 @@ static bt_status_t btif_in_get_adapter_properties(void)
     HAL_CBACK(bt_hal_cbacks, adapter_properties_cb,
                      BT_STATUS_SUCCESS, num_props, properties);
 
+    free(bonded_devices);
     return BT_STATUS_SUCCESS;
 }
 
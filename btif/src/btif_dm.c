@@ -45,6 +45,7 @@
 #include "btif_hh.h"
 #include "btif_hd.h"
 #include "btif_config.h"
+#include "interop.h"
 
 #include "bta_gatt_api.h"
 
@@ -53,26 +54,14 @@
 ******************************************************************************/
 
 /**
- * The devices below have proven problematic during the pairing process, often
+ * Some devices have proven problematic during the pairing process, often
  * requiring multiple retries to complete pairing. To avoid degrading the user
- * experience for other devices, explicitely blacklist troubled devices here.
+ * experience for other devices, only they are retried. The list lives in the
+ * interop database.
  */
-static const UINT8 blacklist_pairing_retries[][3] = {
-    {0x9C, 0xDF, 0x03} // BMW car kits (Harman/Becker)
-};
-
 BOOLEAN blacklistPairingRetries(BD_ADDR bd_addr)
 {
-    const unsigned blacklist_size = sizeof(blacklist_pairing_retries)
-        / sizeof(blacklist_pairing_retries[0]);
-    for (unsigned i = 0; i != blacklist_size; ++i)
-    {
-        if (blacklist_pairing_retries[i][0] == bd_addr[0] &&
-            blacklist_pairing_retries[i][1] == bd_addr[1] &&
-            blacklist_pairing_retries[i][2] == bd_addr[2])
-            return TRUE;
-    }
-    return FALSE;
+    return interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, bd_addr);
 }
 
 /******************************************************************************
@@ -193,26 +182,6 @@ typedef struct
 #define UUID_HUMAN_INTERFACE_DEVICE "00001124-0000-1000-8000-00805f9b34fb"
 
 static skip_sdp_entry_t sdp_manufacturer_blacklist[] = {{76}}; //Apple Mouse and Keyboard
-static const UINT8 hid_sdp_addr_blacklist[][3] = {
-    {0x00, 0x07, 0x61} // Logitech
-    ,{0x00, 0x1d, 0xd8} // Microsoft Bluetooth Notebook Mouse 5000 #1
-    ,{0x7c, 0xed, 0x8d} // Microsoft Bluetooth Notebook Mouse 5000 #2
-};
-
-typedef struct hid_name_bllist
-{
-    char*  name;
-}hid_name_bllist_t;
-
-static hid_name_bllist_t hid_sdp_name_blacklist[] = {
-    {"Microsoft Bluetooth Notebook Mouse 5000"}
-};
-
-/* hid_auth_blacklist to FIX IOP issues with hid devices
- * that dont want to have authentication during hid connection */
-static const UINT8 hid_auth_blacklist[][3] = {
-    {0x00, 0x12, 0xa1} // Targus
-};
 
 
 /* This flag will be true if HCI_Inquiry is in progress */
@@ -491,19 +460,11 @@ BOOLEAN check_hid_le(const bt_bdaddr_t *remote_bdaddr)
 *******************************************************************************/
 static bool check_if_auth_bl(BD_ADDR peer_dev)
 {
-    int i;
-    int blacklist_size =
-            sizeof(hid_auth_blacklist)/sizeof(hid_auth_blacklist[0]);
-    for (i = 0; i < blacklist_size; i++) {
-        if (hid_auth_blacklist[i][0] == peer_dev[0] &&
-            hid_auth_blacklist[i][1] == peer_dev[1] &&
-            hid_auth_blacklist[i][2] == peer_dev[2]) {
-            APPL_TRACE_WARNING("%02x:%02x:%02x:%02x:%02x:%02x is in blacklist for "
-                "skipping authentication", peer_dev[0], peer_dev[1], peer_dev[2],
-                peer_dev[3], peer_dev[4], peer_dev[5]);
-
-            return TRUE;
-        }
+    if (interop_match_addr(INTEROP_HID_NO_AUTH, peer_dev)) {
+        APPL_TRACE_WARNING("%02x:%02x:%02x:%02x:%02x:%02x is in blacklist for "
+            "skipping authentication", peer_dev[0], peer_dev[1], peer_dev[2],
+            peer_dev[3], peer_dev[4], peer_dev[5]);
+        return TRUE;
     }
     APPL_TRACE_DEBUG("%02x:%02x:%02x:%02x:%02x:%02x is not in blacklist for "
         "skipping authentication", peer_dev[0], peer_dev[1], peer_dev[2],
@@ -577,32 +538,19 @@ BOOLEAN check_sdp_bl(const bt_bdaddr_t *remote_bdaddr)
             return TRUE;
         }
     }
-    int sdp_addr_blacklist_size =
-            sizeof(hid_sdp_addr_blacklist)/sizeof(hid_sdp_addr_blacklist[0]);
-    for (int i = 0; i < sdp_addr_blacklist_size; i++)
-    {
-        if (hid_sdp_addr_blacklist[i][0] == (*(BD_ADDR*)remote_bdaddr)[0] &&
-            hid_sdp_addr_blacklist[i][1] == (*(BD_ADDR*)remote_bdaddr)[1] &&
-            hid_sdp_addr_blacklist[i][2] == (*(BD_ADDR*)remote_bdaddr)[2]) {
-            APPL_TRACE_WARNING("%02x:%02x:%02x:%02x:%02x:%02x is in blacklist for "
-                "skipping sdp", (*(BD_ADDR*)remote_bdaddr)[0],
-                (*(BD_ADDR*)remote_bdaddr)[1], (*(BD_ADDR*)remote_bdaddr)[2],
-                (*(BD_ADDR*)remote_bdaddr)[3], (*(BD_ADDR*)remote_bdaddr)[4],
-                (*(BD_ADDR*)remote_bdaddr)[5]);
-            return TRUE;
-        }
+    if (interop_match_addr(INTEROP_HID_NO_SDP, remote_bdaddr->address)) {
+        APPL_TRACE_WARNING("%02x:%02x:%02x:%02x:%02x:%02x is in blacklist for "
+            "skipping sdp", remote_bdaddr->address[0],
+            remote_bdaddr->address[1], remote_bdaddr->address[2],
+            remote_bdaddr->address[3], remote_bdaddr->address[4],
+            remote_bdaddr->address[5]);
+        return TRUE;
     }
 
-    int sdp_name_blacklist_size =
-            sizeof(hid_sdp_name_blacklist)/sizeof(hid_name_bllist_t);
-    for (int i = 0; i < sdp_name_blacklist_size; i++)
-    {
-        if (!strncmp(hid_sdp_name_blacklist[i].name, (const char *)bdname.name,
-            strlen(hid_sdp_name_blacklist[i].name))) {
-            APPL_TRACE_WARNING("%s is in blacklist for "
-                "skipping sdp", bdname.name);
-            return TRUE;
-        }
+    if (interop_match_name(INTEROP_HID_NO_SDP, (const char *)bdname.name)) {
+        APPL_TRACE_WARNING("%s is in blacklist for "
+            "skipping sdp", bdname.name);
+        return TRUE;
     }
     return FALSE;
 }
@@ -2035,7 +1983,7 @@ static void btif_dm_upstreams_evt(UINT16 event, char* p_param)
         case BTA_DM_HW_ERROR_EVT:
             BTIF_TRACE_ERROR("Received H/W Error. ");
             /* Flush storage data */
-            btif_config_flush();
+            btif_config_flush_sync();
             usleep(100000); /* 100milliseconds */
             /* Killing the process to force a restart as part of fault tolerance */
             kill(getpid(), SIGKILL);
@@ -0,0 +1,676 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2009-2012 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_media_jb.c
+ *
+ *  Description:   A2DP sink jitter buffer and playout engine
+ *
+ *                 Received packets are put on a playout timeline built from
+ *                 their RTP time stamps (or from sequence numbers and frame
+ *                 counts when the source's time stamps are not in samples).
+ *                 The playout delay follows the peak arrival lateness seen on
+ *                 the link.  Missing frames are concealed by repeating the
+ *                 last frame with a fade, and the playout rate is nudged by
+ *                 resampling each tick so the buffered delay tracks the
+ *                 target instead of creeping with clock drift.
+ *
+ *******************************************************************************/
+
+#include <string.h>
+
+#include "bt_target.h"
+#include "bt_trace.h"
+#include "gki.h"
+#include "btif_media_jb.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+/* largest number of SBC frames in one media packet */
+#define BTIF_MEDIA_JB_MAX_PKT_FRAMES    15
+
+/* sequence number jumps beyond this are taken as a stream restart */
+#define BTIF_MEDIA_JB_MAX_SEQ_GAP       100
+
+#define BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, ms)   ((p_jb)->rate * (ms) / 1000)
+
+/*****************************************************************************
+**  Static functions
+******************************************************************************/
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_ts_delta
+ **
+ ** Description      Distance on the playout timeline between two packets
+ **                  gap sequence numbers apart.  The RTP time stamp delta is
+ **                  used when it is consistent with whole SBC frames,
+ **                  otherwise the distance is estimated from frame counts.
+ **
+ ** Returns          Distance in samples.
+ **
+ *******************************************************************************/
+static UINT32 btif_media_jb_ts_delta(tBTIF_MEDIA_JB *p_jb, UINT32 rtp_delta, UINT16 gap,
+                                     UINT8 first_frames, UINT8 frames)
+{
+    UINT32 fs = p_jb->frame_samples;
+    UINT32 lo = (first_frames + (gap - 1)) * fs;
+    UINT32 hi = (first_frames + (gap - 1) * BTIF_MEDIA_JB_MAX_PKT_FRAMES) * fs;
+
+    if ((rtp_delta >= lo) && (rtp_delta <= hi) && ((rtp_delta % fs) == 0))
+        return rtp_delta;
+
+    return (first_frames + (gap - 1) * frames) * fs;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_insert
+ **
+ ** Description      Insert a packet into the queue in sequence order.
+ **
+ ** Returns          FALSE if a packet with the same sequence number is queued.
+ **
+ *******************************************************************************/
+static BOOLEAN btif_media_jb_insert(BUFFER_Q *p_q, tBT_SBC_HDR *p_pkt)
+{
+    BUFFER_Q    tmp;
+    tBT_SBC_HDR *p;
+    BOOLEAN     done = FALSE;
+    BOOLEAN     dup = FALSE;
+
+    p = (tBT_SBC_HDR *)GKI_getlast(p_q);
+    if ((p == NULL) || ((INT16)(p_pkt->layer_specific - p->layer_specific) > 0))
+    {
+        GKI_enqueue(p_q, p_pkt);
+        return TRUE;
+    }
+
+    /* out of order; rebuild the (short) queue around it */
+    GKI_init_q(&tmp);
+    while ((p = (tBT_SBC_HDR *)GKI_dequeue(p_q)) != NULL)
+    {
+        if (!done)
+        {
+            if (p->layer_specific == p_pkt->layer_specific)
+            {
+                dup = TRUE;
+                done = TRUE;
+            }
+            else if ((INT16)(p_pkt->layer_specific - p->layer_specific) < 0)
+            {
+                GKI_enqueue(&tmp, p_pkt);
+                done = TRUE;
+            }
+        }
+        GKI_enqueue(&tmp, p);
+    }
+    *p_q = tmp;
+    return !dup;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_update_arrival
+ **
+ ** Description      Update the jitter estimate and the target playout delay
+ **                  with the arrival of a packet at timeline position ts.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_jb_update_arrival(tBTIF_MEDIA_JB *p_jb, UINT32 ts, UINT64 arrival_us,
+                                         BOOLEAN first)
+{
+    UINT32  arrival = (UINT32)(arrival_us * p_jb->rate / 1000000);
+    INT32   transit = (INT32)(arrival - ts);
+    INT32   d;
+    UINT32  late;
+    UINT32  target;
+
+    if (first)
+    {
+        p_jb->min_transit = transit;
+        p_jb->last_transit = transit;
+    }
+
+    /* RFC 3550 interarrival jitter, kept scaled by 16 */
+    d = transit - p_jb->last_transit;
+    if (d < 0)
+        d = -d;
+    p_jb->jitter += d - ((p_jb->jitter + 8) >> 4);
+    p_jb->last_transit = transit;
+
+    /* the earliest arrival is the reference; let it creep up slowly so a
+     * source clock slower than ours does not read as growing lateness */
+    if ((INT32)(transit - p_jb->min_transit) < 0)
+        p_jb->min_transit = transit;
+    late = (UINT32)(transit - p_jb->min_transit);
+    if (late > 0)
+        p_jb->min_transit++;
+    if (late > p_jb->peak_late)
+        p_jb->peak_late = late;
+    else
+        p_jb->peak_late -= (p_jb->peak_late + 1023) >> 10;
+
+    /* a tick is pulled at once, so hold at least a tick and a frame on top */
+    target = p_jb->peak_late + p_jb->tick_samples + p_jb->frame_samples;
+    if (target < BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, BTIF_MEDIA_JB_MIN_MS))
+        target = BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, BTIF_MEDIA_JB_MIN_MS);
+    if (target > BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, BTIF_MEDIA_JB_MAX_MS))
+        target = BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, BTIF_MEDIA_JB_MAX_MS);
+    p_jb->target = target;
+    if (target > p_jb->stats.max_target)
+        p_jb->stats.max_target = target;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_conceal
+ **
+ ** Description      Append one concealment frame to the fifo: the last good
+ **                  frame, faded a little more for every frame in a row.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_jb_conceal(tBTIF_MEDIA_JB *p_jb)
+{
+    INT16   *p_out = &p_jb->fifo[p_jb->fifo_len * p_jb->channels];
+    UINT16  n = p_jb->last_len ? p_jb->last_len : p_jb->frame_samples;
+    UINT32  gain = p_jb->plc_gain;
+    UINT16  xx;
+
+    if (p_jb->last_len == 0)
+    {
+        memset(p_out, 0, n * p_jb->channels * sizeof(INT16));
+    }
+    else
+    {
+        for (xx = 0; xx < n * p_jb->channels; xx++)
+            p_out[xx] = (INT16)(((INT32)p_jb->last_pcm[xx] * (INT32)gain) >> 15);
+    }
+
+    p_jb->fifo_len += n;
+    p_jb->plc_gain = (UINT16)((gain * 3) >> 2);
+    if (p_jb->plc_run < 0xFF)
+        p_jb->plc_run++;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_pull_frame
+ **
+ ** Description      Append the next frame of the timeline to the fifo:
+ **                  decoded if it was received, concealed if not.
+ **
+ ** Returns          FALSE if the queue ran dry for too long and the engine
+ **                  went back to prebuffering.
+ **
+ *******************************************************************************/
+static BOOLEAN btif_media_jb_pull_frame(tBTIF_MEDIA_JB *p_jb)
+{
+    UINT32      fs = p_jb->frame_samples;
+    tBT_SBC_HDR *p;
+    const UINT8 *p_data;
+    UINT32      len;
+    UINT32      bytes;
+    UINT32      room;
+    INT32       diff;
+    BOOLEAN     stale;
+    UINT16      n;
+
+    for (;;)
+    {
+        if (p_jb->p_cur == NULL)
+        {
+            GKI_disable();
+            p_jb->p_cur = (tBT_SBC_HDR *)GKI_dequeue(&p_jb->q);
+            if (p_jb->p_cur != NULL)
+                p_jb->queued -= p_jb->p_cur->num_frames_to_be_processed * fs;
+            GKI_enable();
+        }
+        p = p_jb->p_cur;
+
+        if (p == NULL)
+        {
+            /* underrun: conceal for a while, then start over */
+            if (p_jb->plc_run >= BTIF_MEDIA_JB_PLC_MAX_FRAMES)
+            {
+                p_jb->state = BTIF_MEDIA_JB_PREBUFFER;
+                p_jb->play_valid = FALSE;
+                p_jb->stats.rebuffers++;
+
+                /* the link is worse than we thought; aim higher */
+                GKI_disable();
+                p_jb->peak_late += p_jb->tick_samples;
+                GKI_enable();
+                return FALSE;
+            }
+            btif_media_jb_conceal(p_jb);
+            p_jb->play_ts += fs;
+            p_jb->stats.underrun_frames++;
+            return TRUE;
+        }
+
+        if (!p_jb->play_valid)
+        {
+            p_jb->play_ts = BTIF_MEDIA_JB_PKT_TS(p);
+            p_jb->play_valid = TRUE;
+        }
+
+        diff = (INT32)(BTIF_MEDIA_JB_PKT_TS(p) - p_jb->play_ts);
+        if (diff >= (INT32)fs)
+        {
+            if (diff <= (INT32)(BTIF_MEDIA_JB_PLC_MAX_FRAMES * fs))
+            {
+                /* frames before this packet were lost */
+                btif_media_jb_conceal(p_jb);
+                p_jb->play_ts += fs;
+                p_jb->stats.lost_frames++;
+                return TRUE;
+            }
+            /* too long to conceal; jump ahead */
+            p_jb->stats.skips++;
+            p_jb->play_ts = BTIF_MEDIA_JB_PKT_TS(p);
+        }
+        else if ((diff + (INT32)(p->num_frames_to_be_processed * fs)) <= 0)
+        {
+            /* already covered by concealment */
+            GKI_freebuf(p);
+            p_jb->p_cur = NULL;
+            p_jb->stats.late++;
+            continue;
+        }
+
+        /* a frame whose slot was already concealed is decoded, to find
+         * where the next one starts, but not played */
+        stale = (diff <= -(INT32)fs);
+
+        p_data = (UINT8 *)(p + 1) + p->offset + 1;
+        len = p->len - 1;
+        room = (BTIF_MEDIA_JB_FIFO_SAMPLES - p_jb->fifo_len) * p_jb->channels * sizeof(INT16);
+        bytes = (*p_jb->p_decode)(&p_data, &len, &p_jb->fifo[p_jb->fifo_len * p_jb->channels],
+                                  room);
+
+        if (bytes == 0)
+        {
+            /* drop the rest of a packet that does not decode */
+            GKI_freebuf(p);
+            p_jb->p_cur = NULL;
+            if (stale)
+                continue;
+            btif_media_jb_conceal(p_jb);
+            p_jb->play_ts += fs;
+            p_jb->stats.lost_frames++;
+            return TRUE;
+        }
+
+        p->offset += (p->len - 1) - len;
+        p->len = len + 1;
+        p->num_frames_to_be_processed--;
+        BTIF_MEDIA_JB_PKT_TS(p) += fs;
+        if ((p->num_frames_to_be_processed == 0) || (len == 0))
+        {
+            GKI_freebuf(p);
+            p_jb->p_cur = NULL;
+        }
+
+        if (stale)
+            continue;
+
+        n = (UINT16)(bytes / (p_jb->channels * sizeof(INT16)));
+        if (n <= BTIF_MEDIA_JB_MAX_FRAME_SAMPLES)
+        {
+            memcpy(p_jb->last_pcm, &p_jb->fifo[p_jb->fifo_len * p_jb->channels],
+                   n * p_jb->channels * sizeof(INT16));
+            p_jb->last_len = n;
+        }
+        p_jb->fifo_len += n;
+        p_jb->play_ts += fs;
+        p_jb->plc_run = 0;
+        p_jb->plc_gain = 0x7FFF;
+        p_jb->stats.frames++;
+        return TRUE;
+    }
+}
+
+/*****************************************************************************
+**  Functions
+******************************************************************************/
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_flush
+ **
+ ** Description      Drop all queued data and go back to prebuffering.  The
+ **                  stream configuration is kept.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_jb_flush(tBTIF_MEDIA_JB *p_jb)
+{
+    void *p_buf;
+
+    GKI_disable();
+    while ((p_buf = GKI_dequeue(&p_jb->q)) != NULL)
+        GKI_freebuf(p_buf);
+    if (p_jb->p_cur != NULL)
+    {
+        GKI_freebuf(p_jb->p_cur);
+        p_jb->p_cur = NULL;
+    }
+    p_jb->queued = 0;
+    p_jb->rx_valid = FALSE;
+    if (p_jb->state != BTIF_MEDIA_JB_IDLE)
+        p_jb->state = BTIF_MEDIA_JB_PREBUFFER;
+    p_jb->primed = FALSE;
+    p_jb->play_valid = FALSE;
+    p_jb->fifo_len = 0;
+    p_jb->last_len = 0;
+    p_jb->plc_run = 0;
+    GKI_enable();
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_init
+ **
+ ** Description      Configure the engine for a new stream.  Any queued data
+ **                  is dropped.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_jb_init(tBTIF_MEDIA_JB *p_jb, tBTIF_MEDIA_JB_DECODE *p_decode,
+                        UINT32 rate, UINT8 channels, UINT16 frame_samples,
+                        UINT16 tick_ms)
+{
+    if (p_jb->state != BTIF_MEDIA_JB_IDLE)
+        btif_media_jb_flush(p_jb);
+
+    GKI_disable();
+    memset(p_jb, 0, sizeof(tBTIF_MEDIA_JB));
+    GKI_init_q(&p_jb->q);
+    p_jb->p_decode = p_decode;
+    p_jb->rate = rate;
+    p_jb->channels = (channels > BTIF_MEDIA_JB_MAX_CHANNELS) ? BTIF_MEDIA_JB_MAX_CHANNELS : channels;
+    p_jb->frame_samples = (frame_samples > BTIF_MEDIA_JB_MAX_FRAME_SAMPLES) ?
+                          BTIF_MEDIA_JB_MAX_FRAME_SAMPLES : frame_samples;
+    p_jb->tick_samples = (UINT16)BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, tick_ms);
+    if (p_jb->tick_samples > BTIF_MEDIA_JB_MAX_TICK_SAMPLES)
+        p_jb->tick_samples = BTIF_MEDIA_JB_MAX_TICK_SAMPLES;
+    p_jb->target = BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, BTIF_MEDIA_JB_MIN_MS);
+    p_jb->state = BTIF_MEDIA_JB_PREBUFFER;
+    GKI_enable();
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_put
+ **
+ ** Description      Queue a received media packet.  The RTP time stamp must be
+ **                  stored with BTIF_MEDIA_JB_PKT_TS().  The engine takes
+ **                  ownership of the buffer.  May be called from a different
+ **                  task than btif_media_jb_render().
+ **
+ ** Returns          Number of packets queued.
+ **
+ *******************************************************************************/
+UINT8 btif_media_jb_put(tBTIF_MEDIA_JB *p_jb, tBT_SBC_HDR *p_pkt, UINT64 arrival_us)
+{
+    UINT32  fs = p_jb->frame_samples;
+    UINT32  rtp = BTIF_MEDIA_JB_PKT_TS(p_pkt);
+    UINT16  seq = p_pkt->layer_specific;
+    UINT8   frames = (UINT8)p_pkt->num_frames_to_be_processed;
+    BOOLEAN first = FALSE;
+    UINT32  ts;
+    INT16   gap;
+    void    *p_old;
+    UINT8   count;
+
+    GKI_disable();
+
+    if ((p_jb->state == BTIF_MEDIA_JB_IDLE) || (frames == 0))
+    {
+        GKI_freebuf(p_pkt);
+        count = (UINT8)p_jb->q.count;
+        GKI_enable();
+        return count;
+    }
+    p_jb->stats.pkts++;
+
+    /* place the packet on the playout timeline */
+    gap = (INT16)(seq - p_jb->rx_seq);
+    if (!p_jb->rx_valid || (gap > BTIF_MEDIA_JB_MAX_SEQ_GAP) || (gap < -BTIF_MEDIA_JB_MAX_SEQ_GAP))
+    {
+        /* first packet, or the source restarted: carry on where we were */
+        ts = p_jb->rx_valid ? p_jb->rx_ts + p_jb->rx_frames * fs : rtp;
+        first = !p_jb->rx_valid;
+        gap = 1;
+    }
+    else if (gap > 0)
+    {
+        ts = p_jb->rx_ts + btif_media_jb_ts_delta(p_jb, rtp - p_jb->rx_rtp, (UINT16)gap,
+                                                  p_jb->rx_frames, frames);
+    }
+    else if (gap < 0)
+    {
+        ts = p_jb->rx_ts - btif_media_jb_ts_delta(p_jb, p_jb->rx_rtp - rtp, (UINT16)(-gap),
+                                                  frames, frames);
+        p_jb->stats.reordered++;
+    }
+    else
+    {
+        p_jb->stats.dups++;
+        GKI_freebuf(p_pkt);
+        count = (UINT8)p_jb->q.count;
+        GKI_enable();
+        return count;
+    }
+
+    if (gap > 0)
+    {
+        p_jb->rx_valid = TRUE;
+        p_jb->rx_seq = seq;
+        p_jb->rx_rtp = rtp;
+        p_jb->rx_ts = ts;
+        p_jb->rx_frames = frames;
+    }
+    btif_media_jb_update_arrival(p_jb, ts, arrival_us, first);
+
+    BTIF_MEDIA_JB_PKT_TS(p_pkt) = ts;
+    if (p_jb->play_valid && ((INT32)(ts + frames * fs - p_jb->play_ts) <= 0))
+    {
+        p_jb->stats.late++;
+        GKI_freebuf(p_pkt);
+    }
+    else if (!btif_media_jb_insert(&p_jb->q, p_pkt))
+    {
+        p_jb->stats.dups++;
+        GKI_freebuf(p_pkt);
+    }
+    else
+    {
+        p_jb->queued += frames * fs;
+
+        /* never hold much more than the largest delay we would aim for */
+        while ((p_jb->queued > 2 * BTIF_MEDIA_JB_MS_TO_SAMPLES(p_jb, BTIF_MEDIA_JB_MAX_MS))
+            && ((p_old = GKI_dequeue(&p_jb->q)) != NULL))
+        {
+            p_jb->queued -= ((tBT_SBC_HDR *)p_old)->num_frames_to_be_processed * fs;
+            GKI_freebuf(p_old);
+            p_jb->stats.overflow++;
+        }
+    }
+
+    count = (UINT8)p_jb->q.count;
+    GKI_enable();
+    return count;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_render
+ **
+ ** Description      Produce one tick of interleaved PCM into p_pcm, which must
+ **                  hold tick_samples * channels samples.  Lost and missing
+ **                  frames are concealed, and the playout rate is nudged to
+ **                  keep the buffered delay at the adaptive target.
+ **
+ ** Returns          Number of PCM bytes written; 0 before playback started.
+ **
+ *******************************************************************************/
+UINT32 btif_media_jb_render(tBTIF_MEDIA_JB *p_jb, INT16 *p_pcm)
+{
+    UINT8   ch = p_jb->channels;
+    UINT16  tick = p_jb->tick_samples;
+    UINT32  out_bytes = tick * ch * sizeof(INT16);
+    UINT32  depth;
+    UINT32  target;
+    UINT32  max_adj;
+    INT32   err;
+    INT32   adj = 0;
+    UINT16  need;
+    UINT32  pos, step, idx, frac;
+    UINT16  xx;
+    UINT8   c;
+    INT32   a, b;
+
+    if (p_jb->state == BTIF_MEDIA_JB_IDLE)
+        return 0;
+
+    GKI_disable();
+    depth = p_jb->queued;
+    target = p_jb->target;
+    GKI_enable();
+    if (p_jb->p_cur != NULL)
+        depth += p_jb->p_cur->num_frames_to_be_processed * p_jb->frame_samples;
+    depth += p_jb->fifo_len;
+
+    if (p_jb->state == BTIF_MEDIA_JB_PREBUFFER)
+    {
+        if (depth < target)
+        {
+            if (!p_jb->primed)
+                return 0;
+
+            /* keep the audio device fed while we refill */
+            memset(p_pcm, 0, out_bytes);
+            return out_bytes;
+        }
+        p_jb->state = BTIF_MEDIA_JB_PLAYING;
+        p_jb->primed = TRUE;
+        p_jb->avg_depth = depth << 4;
+        p_jb->plc_run = 0;
+        p_jb->plc_gain = 0x7FFF;
+    }
+
+    /* playout-rate correction: consume a few samples more or less than a
+     * tick when the smoothed depth is off target by more than a frame */
+    p_jb->avg_depth += depth - ((p_jb->avg_depth + 8) >> 4);
+    err = (INT32)(p_jb->avg_depth >> 4) - (INT32)target;
+    max_adj = (tick * BTIF_MEDIA_JB_MAX_RATE_ADJ + 999) / 1000;
+    if (err > (INT32)p_jb->frame_samples)
+    {
+        adj = (err - p_jb->frame_samples) / 64 + 1;
+        if (adj > (INT32)max_adj)
+            adj = max_adj;
+    }
+    else if (err < -(INT32)p_jb->frame_samples)
+    {
+        adj = (err + p_jb->frame_samples) / 64 - 1;
+        if (adj < -(INT32)max_adj)
+            adj = -(INT32)max_adj;
+    }
+    need = (UINT16)(tick + adj);
+
+    /* one sample beyond need for the interpolation */
+    while (p_jb->fifo_len <= need)
+    {
+        if (!btif_media_jb_pull_frame(p_jb))
+        {
+            /* back to prebuffering; pad the tick with silence */
+            memset(&p_jb->fifo[p_jb->fifo_len * ch], 0,
+                   (need + 1 - p_jb->fifo_len) * ch * sizeof(INT16));
+            p_jb->fifo_len = need + 1;
+            break;
+        }
+    }
+
+    if (adj == 0)
+    {
+        memcpy(p_pcm, p_jb->fifo, out_bytes);
+    }
+    else
+    {
+        /* linear interpolation of need input samples onto tick output samples */
+        step = ((UINT32)need << 16) / tick;
+        for (xx = 0, pos = 0; xx < tick; xx++, pos += step)
+        {
+            idx = pos >> 16;
+            frac = pos & 0xFFFF;
+            for (c = 0; c < ch; c++)
+            {
+                a = p_jb->fifo[idx * ch + c];
+                b = p_jb->fifo[(idx + 1) * ch + c];
+                p_pcm[xx * ch + c] = (INT16)(a + (((b - a) * (INT32)frac) >> 16));
+            }
+        }
+        p_jb->stats.rate_adj += adj;
+    }
+
+    p_jb->fifo_len -= need;
+    memmove(p_jb->fifo, &p_jb->fifo[need * ch], p_jb->fifo_len * ch * sizeof(INT16));
+
+    if (p_jb->state != BTIF_MEDIA_JB_PLAYING)
+        p_jb->fifo_len = 0;
+
+    return out_bytes;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_jb_dump_stats
+ **
+ ** Description      Log the engine counters.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_jb_dump_stats(tBTIF_MEDIA_JB *p_jb)
+{
+    tBTIF_MEDIA_JB_STATS *p_st = &p_jb->stats;
+    UINT32 ms = p_jb->rate ? p_jb->rate / 1000 : 1;
+
+    if (p_st->pkts == 0)
+        return;
+
+    APPL_TRACE_EVENT("A2DP sink jb: pkts %u late %u dups %u reordered %u overflow %u",
+                     p_st->pkts, p_st->late, p_st->dups, p_st->reordered, p_st->overflow);
+    APPL_TRACE_EVENT("A2DP sink jb: frames %u concealed lost %u underrun %u skips %u rebuffers %u",
+                     p_st->frames, p_st->lost_frames, p_st->underrun_frames, p_st->skips,
+                     p_st->rebuffers);
+    APPL_TRACE_EVENT("A2DP sink jb: target %u ms (max %u ms) jitter %u ms rate adj %d samples",
+                     p_jb->target / ms, p_st->max_target / ms, (p_jb->jitter >> 4) / ms,
+                     p_st->rate_adj);
+}
@@ -0,0 +1,488 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2009-2012 Broadcom Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_media_pcm.c
+ *
+ *  Description:   A2DP source PCM stage
+ *
+ *                 Every block read from the audio HAL goes through here on
+ *                 its way to the SBC encoder.  Wider sample formats are
+ *                 brought down to 16 bits, the software volume is applied
+ *                 with a linear ramp on changes, triangular dither hides the
+ *                 requantization and the channel layout is matched to the
+ *                 encoder.  All of it runs in place in the read buffer.
+ *
+ *                 The loops work on groups of BTIF_MEDIA_PCM_LANES samples:
+ *                 a group is loaded into locals before anything is stored,
+ *                 so conversions that change the sample size stay correct
+ *                 in place while the compiler is free to turn each group
+ *                 into vector instructions.  A 16 bit source at unity gain
+ *                 is passed through untouched.
+ *
+ *******************************************************************************/
+
+#include <string.h>
+
+#include "bt_target.h"
+#include "bt_utils.h"
+#include "btif_media_pcm.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define BTIF_MEDIA_PCM_LANES        8
+
+/* rounding offset of a Q15 product */
+#define BTIF_MEDIA_PCM_ROUND        0x4000
+
+/* wide formats are scaled to 20 bit samples and take the gain as Q11 so a
+ * product still fits 32 bits; the result has the same 2^15 scale either way */
+#define BTIF_MEDIA_PCM_WIDE_SCALE   524288.0f
+
+#define BTIF_MEDIA_PCM_MIN(a, b)    (((a) < (b)) ? (a) : (b))
+
+/*****************************************************************************
+**  Static functions
+******************************************************************************/
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_noise
+ **
+ ** Description      Triangular dither for sample n of the stream: the sum of
+ **                  two uniform values taken from one hash of n.  A hash
+ **                  rather than a running generator keeps the samples of a
+ **                  group independent of each other.
+ **
+ ** Returns          Noise in 1/32768 of an output LSB, +/-1 LSB at most
+ **
+ *******************************************************************************/
+static INT32 btif_media_pcm_noise(UINT32 n)
+{
+#if (BTIF_MEDIA_PCM_DITHER == TRUE)
+    n *= 0x9E3779B1;
+    n ^= n >> 15;
+    n *= 0x85EBCA77;
+    n ^= n >> 13;
+    return (INT32)(n & 0x7FFF) + (INT32)((n >> 16) & 0x7FFF) - 0x7FFF;
+#else
+    UNUSED(n);
+    return 0;
+#endif
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_requant
+ **
+ ** Description      Scale a sample by a gain, dither and saturate it to 16
+ **                  bits.
+ **
+ ** Returns          16 bit sample
+ **
+ *******************************************************************************/
+static INT16 btif_media_pcm_requant(INT32 sample, INT32 gain, INT32 noise)
+{
+    INT32 s = (sample * gain + noise + BTIF_MEDIA_PCM_ROUND) >> 15;
+
+    if (s > 32767)
+        s = 32767;
+    if (s < -32768)
+        s = -32768;
+    return (INT16)s;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_load
+ **
+ ** Description      Load n (at most BTIF_MEDIA_PCM_LANES) source samples
+ **                  starting at sample index first.  16 bit samples come back
+ **                  as they are, wider ones as 20 bit values.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_pcm_load(UINT8 fmt, const UINT8 *p_buf, UINT32 first,
+                                INT32 *p_val, UINT32 n)
+{
+    UINT32 i;
+
+    switch (fmt)
+    {
+    case BTIF_MEDIA_PCM_FMT_S16:
+    {
+        const INT16 *p_src = (const INT16 *)p_buf + first;
+        for (i = 0; i < n; i++)
+            p_val[i] = p_src[i];
+        break;
+    }
+
+    case BTIF_MEDIA_PCM_FMT_S24:
+    {
+        const UINT8 *p_src = p_buf + first * 3;
+        for (i = 0; i < n; i++)
+        {
+            p_val[i] = (INT32)(((UINT32)p_src[3 * i] << 8) |
+                               ((UINT32)p_src[3 * i + 1] << 16) |
+                               ((UINT32)p_src[3 * i + 2] << 24)) >> 12;
+        }
+        break;
+    }
+
+    case BTIF_MEDIA_PCM_FMT_S32:
+    {
+        const INT32 *p_src = (const INT32 *)p_buf + first;
+        for (i = 0; i < n; i++)
+            p_val[i] = p_src[i] >> 12;
+        break;
+    }
+
+    case BTIF_MEDIA_PCM_FMT_FLOAT:
+    {
+        const float *p_src = (const float *)p_buf + first;
+        for (i = 0; i < n; i++)
+        {
+            float f = p_src[i] * BTIF_MEDIA_PCM_WIDE_SCALE;
+
+            /* written so that NaN ends up at the bottom rail */
+            if (!(f > -BTIF_MEDIA_PCM_WIDE_SCALE))
+                f = -BTIF_MEDIA_PCM_WIDE_SCALE;
+            if (f > BTIF_MEDIA_PCM_WIDE_SCALE - 1.0f)
+                f = BTIF_MEDIA_PCM_WIDE_SCALE - 1.0f;
+            p_val[i] = (INT32)f;
+        }
+        break;
+    }
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_scale
+ **
+ ** Description      Requantize samples [first, first + num_samples) of the
+ **                  block to 16 bits at the current gain, moving it by step
+ **                  every frame.  Output sample i lands at 16 bit index i.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_pcm_scale(tBTIF_MEDIA_PCM *p_pcm, UINT8 fmt, UINT8 *p_buf,
+                                 UINT32 first, UINT32 num_samples, INT32 step)
+{
+    INT16   *p_out = (INT16 *)p_buf + first;
+    INT32   val[BTIF_MEDIA_PCM_LANES];
+    INT32   gain = p_pcm->gain;
+    UINT32  ch_shift = p_pcm->channels - 1;
+    UINT32  gain_shift = (fmt == BTIF_MEDIA_PCM_FMT_S16) ? 15 : 19;
+    UINT32  noise_pos = p_pcm->noise_pos + first;
+    UINT32  i, j, n;
+
+    for (i = 0; i < num_samples; i += n)
+    {
+        n = BTIF_MEDIA_PCM_MIN(BTIF_MEDIA_PCM_LANES, num_samples - i);
+        btif_media_pcm_load(fmt, p_buf, first + i, val, n);
+
+        for (j = 0; j < n; j++)
+        {
+            INT32 g = (gain + step * (INT32)((i + j) >> ch_shift)) >> gain_shift;
+
+            p_out[j] = btif_media_pcm_requant(val[j], g, btif_media_pcm_noise(noise_pos + i + j));
+        }
+        p_out += n;
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_expand
+ **
+ ** Description      Widen unsigned 8 bit samples to signed 16 bits in place,
+ **                  last group first so no sample is overwritten unread.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_pcm_expand(UINT8 *p_buf, UINT32 num_samples)
+{
+    INT16   *p_out = (INT16 *)p_buf;
+    INT32   val[BTIF_MEDIA_PCM_LANES];
+    UINT32  i = num_samples;
+    UINT32  j;
+
+    while (i >= BTIF_MEDIA_PCM_LANES)
+    {
+        i -= BTIF_MEDIA_PCM_LANES;
+        for (j = 0; j < BTIF_MEDIA_PCM_LANES; j++)
+            val[j] = ((INT32)p_buf[i + j] - 128) * 256;
+        for (j = 0; j < BTIF_MEDIA_PCM_LANES; j++)
+            p_out[i + j] = (INT16)val[j];
+    }
+    while (i--)
+        p_out[i] = (INT16)(((INT32)p_buf[i] - 128) * 256);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_upmix
+ **
+ ** Description      Duplicate 16 bit mono samples to stereo in place, last
+ **                  group first.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_pcm_upmix(INT16 *p_pcm, UINT32 num_frames)
+{
+    INT16   val[BTIF_MEDIA_PCM_LANES];
+    UINT32  i = num_frames;
+    UINT32  j;
+
+    while (i >= BTIF_MEDIA_PCM_LANES)
+    {
+        i -= BTIF_MEDIA_PCM_LANES;
+        for (j = 0; j < BTIF_MEDIA_PCM_LANES; j++)
+            val[j] = p_pcm[i + j];
+        for (j = 0; j < BTIF_MEDIA_PCM_LANES; j++)
+        {
+            p_pcm[2 * (i + j)] = val[j];
+            p_pcm[2 * (i + j) + 1] = val[j];
+        }
+    }
+    while (i--)
+    {
+        p_pcm[2 * i + 1] = p_pcm[i];
+        p_pcm[2 * i] = p_pcm[i];
+    }
+}
+
+/*****************************************************************************
+**  Functions
+******************************************************************************/
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_init
+ **
+ ** Description      Reset the stage to 16 bit stereo at unity gain.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_pcm_init(tBTIF_MEDIA_PCM *p_pcm)
+{
+    memset(p_pcm, 0, sizeof(tBTIF_MEDIA_PCM));
+    p_pcm->fmt = BTIF_MEDIA_PCM_FMT_S16;
+    p_pcm->channels = 2;
+    p_pcm->target = BTIF_MEDIA_PCM_UNITY_GAIN;
+    p_pcm->gain = (INT32)BTIF_MEDIA_PCM_UNITY_GAIN << 15;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_config
+ **
+ ** Description      Set the source format.  The gain is kept.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_pcm_config(tBTIF_MEDIA_PCM *p_pcm, UINT8 fmt, UINT8 channels)
+{
+    p_pcm->fmt = (fmt <= BTIF_MEDIA_PCM_FMT_FLOAT) ? fmt : BTIF_MEDIA_PCM_FMT_S16;
+    p_pcm->channels = (channels == 1) ? 1 : 2;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_bits_to_fmt
+ **
+ ** Description      Map an integer PCM bit depth to a source format.
+ **
+ ** Returns          BTIF_MEDIA_PCM_FMT_xxx, S16 for unknown depths
+ **
+ *******************************************************************************/
+UINT8 btif_media_pcm_bits_to_fmt(UINT8 bit_per_sample)
+{
+    switch (bit_per_sample)
+    {
+    case 8:
+        return BTIF_MEDIA_PCM_FMT_U8;
+    case 24:
+        return BTIF_MEDIA_PCM_FMT_S24;
+    case 32:
+        return BTIF_MEDIA_PCM_FMT_S32;
+    default:
+        return BTIF_MEDIA_PCM_FMT_S16;
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_frame_size
+ **
+ ** Description      Size of one source frame (a sample for every channel).
+ **
+ ** Returns          Number of bytes
+ **
+ *******************************************************************************/
+UINT32 btif_media_pcm_frame_size(const tBTIF_MEDIA_PCM *p_pcm)
+{
+    static const UINT8 sample_size[] = {1, 2, 3, 4, 4};
+
+    return sample_size[p_pcm->fmt] * p_pcm->channels;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_volume_to_gain
+ **
+ ** Description      Map an AVRCP absolute volume (0 - 127) to a Q15 gain
+ **                  along a square law curve.
+ **
+ ** Returns          Q15 gain
+ **
+ *******************************************************************************/
+UINT16 btif_media_pcm_volume_to_gain(UINT8 volume)
+{
+    if (volume >= 127)
+        return BTIF_MEDIA_PCM_UNITY_GAIN;
+
+    return (UINT16)(((UINT32)volume * volume * BTIF_MEDIA_PCM_UNITY_GAIN + 127 * 127 / 2) /
+                    (127 * 127));
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_set_gain
+ **
+ ** Description      Ramp to a new Q15 gain, at most BTIF_MEDIA_PCM_UNITY_GAIN,
+ **                  over the next BTIF_MEDIA_PCM_RAMP_FRAMES frames.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_pcm_set_gain(tBTIF_MEDIA_PCM *p_pcm, UINT16 gain)
+{
+    INT32 target;
+
+    if (gain > BTIF_MEDIA_PCM_UNITY_GAIN)
+        gain = BTIF_MEDIA_PCM_UNITY_GAIN;
+
+    target = (INT32)gain << 15;
+    p_pcm->target = gain;
+    if (target == p_pcm->gain)
+    {
+        p_pcm->step = 0;
+        p_pcm->ramp_left = 0;
+        return;
+    }
+
+    p_pcm->step = (target - p_pcm->gain) / BTIF_MEDIA_PCM_RAMP_FRAMES;
+    p_pcm->ramp_left = BTIF_MEDIA_PCM_RAMP_FRAMES;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_process
+ **
+ ** Description      Turn num_frames source frames at p_buf into 16 bit samples
+ **                  with out_channels channels, in place.  Mono is duplicated
+ **                  to stereo and stereo averaged down to mono.  The buffer
+ **                  must be aligned for the source sample type and hold the
+ **                  larger of the source and the converted block.
+ **
+ ** Returns          Number of bytes of converted samples
+ **
+ *******************************************************************************/
+UINT32 btif_media_pcm_process(tBTIF_MEDIA_PCM *p_pcm, void *p_buf,
+                              UINT32 num_frames, UINT8 out_channels)
+{
+    UINT32  num_samples = num_frames * p_pcm->channels;
+    UINT8   fmt = p_pcm->fmt;
+    UINT32  ramp;
+
+    if (fmt == BTIF_MEDIA_PCM_FMT_U8)
+    {
+        /* exact, so the rest of the stage can treat it as 16 bit */
+        btif_media_pcm_expand((UINT8 *)p_buf, num_samples);
+        fmt = BTIF_MEDIA_PCM_FMT_S16;
+    }
+
+    if ((fmt != BTIF_MEDIA_PCM_FMT_S16) || (p_pcm->ramp_left != 0) ||
+        (p_pcm->gain != ((INT32)BTIF_MEDIA_PCM_UNITY_GAIN << 15)))
+    {
+        ramp = BTIF_MEDIA_PCM_MIN(num_frames, p_pcm->ramp_left);
+        if (ramp != 0)
+        {
+            btif_media_pcm_scale(p_pcm, fmt, (UINT8 *)p_buf, 0, ramp * p_pcm->channels,
+                                 p_pcm->step);
+            p_pcm->gain += p_pcm->step * (INT32)ramp;
+            p_pcm->ramp_left -= ramp;
+            if (p_pcm->ramp_left == 0)
+                p_pcm->gain = (INT32)p_pcm->target << 15;
+        }
+        if (ramp < num_frames)
+        {
+            btif_media_pcm_scale(p_pcm, fmt, (UINT8 *)p_buf, ramp * p_pcm->channels,
+                                 (num_frames - ramp) * p_pcm->channels, 0);
+        }
+        p_pcm->noise_pos += num_samples;
+    }
+
+    if ((p_pcm->channels == 2) && (out_channels == 1))
+        btif_media_pcm_downmix((INT16 *)p_buf, num_frames);
+    else if ((p_pcm->channels == 1) && (out_channels == 2))
+        btif_media_pcm_upmix((INT16 *)p_buf, num_frames);
+    else
+        out_channels = p_pcm->channels;
+
+    return num_frames * out_channels * sizeof(INT16);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_pcm_downmix
+ **
+ ** Description      Average num_frames interleaved 16 bit stereo frames down
+ **                  to mono, in place.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_media_pcm_downmix(INT16 *p_pcm, UINT32 num_frames)
+{
+    INT16   val[BTIF_MEDIA_PCM_LANES];
+    UINT32  i, j;
+
+    for (i = 0; i + BTIF_MEDIA_PCM_LANES <= num_frames; i += BTIF_MEDIA_PCM_LANES)
+    {
+        const INT16 *p_src = p_pcm + 2 * i;
+
+        for (j = 0; j < BTIF_MEDIA_PCM_LANES; j++)
+            val[j] = (INT16)(((INT32)p_src[2 * j] + p_src[2 * j + 1]) >> 1);
+        for (j = 0; j < BTIF_MEDIA_PCM_LANES; j++)
+            p_pcm[i + j] = val[j];
+    }
+    for (; i < num_frames; i++)
+        p_pcm[i] = (INT16)(((INT32)p_pcm[2 * i] + p_pcm[2 * i + 1]) >> 1);
+}
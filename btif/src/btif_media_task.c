@@ -58,6 +58,8 @@
 
 #include "btif_av_co.h"
 #include "btif_media.h"
+#include "btif_media_jb.h"
+#include "btif_media_pcm.h"
 
 #if (BTA_AV_INCLUDED == TRUE)
 #include "sbc_encoder.h"
@@ -141,7 +143,8 @@ enum
     BTIF_MEDIA_AUDIO_SINK_CFG_UPDATE,
     BTIF_MEDIA_AUDIO_SINK_START_DECODING,
     BTIF_MEDIA_AUDIO_SINK_STOP_DECODING,
-    BTIF_MEDIA_AUDIO_SINK_CLEAR_TRACK
+    BTIF_MEDIA_AUDIO_SINK_CLEAR_TRACK,
+    BTIF_MEDIA_SET_SW_VOLUME
 };
 
 enum {
@@ -255,14 +258,6 @@ static UINT32 a2dp_media_task_stack[(A2DP_MEDIA_TASK_STACK_SIZE + 3) / 4];
 /*****************************************************************************
  **  Data types
  *****************************************************************************/
-typedef struct
-{
-    UINT16 num_frames_to_be_processed;
-    UINT16 len;
-    UINT16 offset;
-    UINT16 layer_specific;
-} tBT_SBC_HDR;
-
 typedef struct
 {
     UINT32 aa_frame_counter;
@@ -286,7 +281,7 @@ typedef struct
 {
 #if (BTA_AV_INCLUDED == TRUE)
     BUFFER_Q TxAaQ;
-    BUFFER_Q RxSbcQ;
+    tBTIF_MEDIA_JB RxJb;    /* received SBC packets, jitter buffered */
     BOOLEAN is_tx_timer;
     BOOLEAN is_rx_timer;
     UINT16 TxAaMtuSize;
@@ -296,6 +291,7 @@ typedef struct
     tBTIF_AV_MEDIA_FEEDINGS media_feeding;
     tBTIF_AV_MEDIA_FEEDINGS_STATE media_feeding_state;
     SBC_ENC_PARAMS encoder;
+    tBTIF_MEDIA_PCM TxPcm;  /* format, volume and channel stage ahead of the encoder */
     UINT8 busy_level;
     void* av_sm_hdl;
     UINT8 a2dp_cmd_pending; /* we can have max one command pending */
@@ -303,7 +299,6 @@ typedef struct
     BOOLEAN rx_flush; /* discards any incoming data when true */
     UINT8 peer_sep;
     BOOLEAN data_channel_open;
-    UINT8   frames_to_process;
 
     UINT32  sample_rate;
     UINT8   channel_count;
@@ -372,7 +367,8 @@ static void btif_media_task_handle_cmd(BT_HDR *p_msg);
 static void btif_media_task_handle_media(BT_HDR*p_msg);
 /* Handle incoming media packets A2DP SINK streaming*/
 #if (BTA_AV_SINK_INCLUDED == TRUE)
-static void btif_media_task_handle_inc_media(tBT_SBC_HDR*p_msg);
+static UINT32 btif_media_task_sbc_decode(const UINT8 **pp_data, UINT32 *p_len,
+                                         INT16 *p_pcm, UINT32 pcm_bytes);
 #endif
 
 #if (BTA_AV_INCLUDED == TRUE)
@@ -384,6 +380,7 @@ static void btif_media_task_enc_init(BT_HDR *p_msg);
 static void btif_media_task_enc_update(BT_HDR *p_msg);
 static void btif_media_task_audio_feeding_init(BT_HDR *p_msg);
 static void btif_media_task_aa_tx_flush(BT_HDR *p_msg);
+static void btif_media_task_set_sw_volume(BT_HDR *p_msg);
 static void btif_media_aa_prep_2_send(UINT8 nb_frame);
 #if (BTA_AV_SINK_INCLUDED == TRUE)
 static void btif_media_task_aa_handle_decoder_reset(BT_HDR *p_msg);
@@ -448,6 +445,7 @@ const char* dump_media_event(UINT16 event)
         CASE_RETURN_STR(BTIF_MEDIA_AUDIO_SINK_START_DECODING)
         CASE_RETURN_STR(BTIF_MEDIA_AUDIO_SINK_STOP_DECODING)
         CASE_RETURN_STR(BTIF_MEDIA_AUDIO_SINK_CLEAR_TRACK)
+        CASE_RETURN_STR(BTIF_MEDIA_SET_SW_VOLUME)
 
         default:
             return "UNKNOWN MEDIA EVENT";
@@ -1323,6 +1321,33 @@ void btif_a2dp_set_tx_flush(BOOLEAN enable)
     btif_media_cb.tx_flush = enable;
 }
 
+/*******************************************************************************
+ **
+ ** Function         btif_a2dp_set_sw_volume
+ **
+ ** Description      Scale the outgoing audio for a sink that cannot take the
+ **                  AVRCP absolute volume itself.  volume is an AVRCP
+ **                  absolute volume, 127 and above restore full scale.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btif_a2dp_set_sw_volume(UINT8 volume)
+{
+    tBTIF_MEDIA_SW_VOLUME *p_buf;
+
+    if (NULL == (p_buf = GKI_getbuf(sizeof(tBTIF_MEDIA_SW_VOLUME))))
+    {
+        APPL_TRACE_ERROR("btif_a2dp_set_sw_volume no buffer");
+        return;
+    }
+
+    p_buf->hdr.event = BTIF_MEDIA_SET_SW_VOLUME;
+    p_buf->volume = volume;
+
+    GKI_send_msg(BT_MEDIA_TASK, BTIF_MEDIA_TASK_CMD_MBOX, p_buf);
+}
+
 #if (BTA_AV_SINK_INCLUDED == TRUE)
 #ifdef AVK_BACKPORT
 void btif_a2dp_set_audio_focus_state(btif_media_AudioFocus_state state)
@@ -1349,65 +1374,37 @@ void btif_a2dp_set_audio_focus_state(btif_media_AudioFocus_state state)
  *******************************************************************************/
 static void btif_media_task_avk_handle_timer ( void )
 {
-    UINT8 count;
-    tBT_SBC_HDR *p_msg;
-    int num_sbc_frames;
-    int num_frames_to_process;
+    UINT32 pcm_bytes;
 
-    count = btif_media_cb.RxSbcQ.count;
-    if (0 == count)
+    if (btif_media_cb.rx_flush == TRUE)
     {
-        APPL_TRACE_DEBUG("  QUE  EMPTY ");
+        btif_media_jb_flush(&btif_media_cb.RxJb);
+        return;
     }
-    else
-    {
-        if (btif_media_cb.rx_flush == TRUE)
-        {
-            btif_media_flush_q(&(btif_media_cb.RxSbcQ));
-            return;
-        }
 
-        if (btif_media_cb.RxSbcQ.count > 3)
-            num_frames_to_process =  2 * btif_media_cb.frames_to_process;
-        else
-            num_frames_to_process = btif_media_cb.frames_to_process;
-
-        APPL_TRACE_DEBUG(" Process Frames + ");
+    if (btif_media_cb.peer_sep == AVDT_TSEP_SNK)
+    {
+        APPL_TRACE_DEBUG(" State Changed happened in this tick ");
+        return;
+    }
 
-        do
-        {
-            p_msg = (tBT_SBC_HDR *)GKI_getfirst(&(btif_media_cb.RxSbcQ));
-            if (p_msg == NULL)
-                return;
-            num_sbc_frames  = p_msg->num_frames_to_be_processed; /* num of frames in Que Packets */
-            APPL_TRACE_DEBUG(" Frames left in topmost packet %d", num_sbc_frames);
-            APPL_TRACE_DEBUG(" Remaining frames to process in tick %d", num_frames_to_process);
-            APPL_TRACE_DEBUG(" Num of Packets in Que %d", btif_media_cb.RxSbcQ.count);
+    /* one tick of PCM, with lost frames concealed and the rate corrected */
+    pcm_bytes = btif_media_jb_render(&btif_media_cb.RxJb, (INT16 *)pcmData);
+    if (pcm_bytes == 0)
+    {
+        APPL_TRACE_DEBUG(" Prebuffering, %d packets", btif_media_cb.RxJb.q.count);
+        return;
+    }
 
-            if ( num_sbc_frames > num_frames_to_process) /*  Que Packet has more frames*/
-            {
-                 p_msg->num_frames_to_be_processed= num_frames_to_process;
-                 btif_media_task_handle_inc_media(p_msg);
-                 p_msg->num_frames_to_be_processed = num_sbc_frames - num_frames_to_process;
-                 num_frames_to_process = 0;
-                 break;
-            }
-            else                                        /*  Que packet has less frames */
-            {
-                btif_media_task_handle_inc_media(p_msg);
-                p_msg = (tBT_SBC_HDR *)GKI_dequeue(&(btif_media_cb.RxSbcQ));
-                if( p_msg == NULL )
-                {
-                     APPL_TRACE_ERROR("Insufficient data in que ");
-                     break;
-                }
-                num_frames_to_process = num_frames_to_process - p_msg->num_frames_to_be_processed;
-                GKI_freebuf(p_msg);
-            }
-        }while(num_frames_to_process > 0);
+#ifdef AVK_BACKPORT
+    btWriteData((void*)pcmData, pcm_bytes);
+#else
+    // ignore data if no one is listening
+    if (!btif_media_cb.data_channel_open)
+        return;
 
-        APPL_TRACE_DEBUG(" Process Frames - ");
-    }
+    UIPC_Send(UIPC_CH_ID_AV_AUDIO, 0, (UINT8 *)pcmData, pcm_bytes);
+#endif
 }
 #endif
 
@@ -1485,6 +1482,7 @@ void btif_media_task_init(void)
     UIPC_Init(NULL);
 
 #if (BTA_AV_INCLUDED == TRUE)
+    btif_media_pcm_init(&btif_media_cb.TxPcm);
     UIPC_Open(UIPC_CH_ID_AV_CTRL , btif_a2dp_ctrl_cb);
 #endif
 }
@@ -1678,6 +1676,9 @@ static void btif_media_task_handle_cmd(BT_HDR *p_msg)
      case BTIF_MEDIA_FLUSH_AA_RX:
         btif_media_task_aa_rx_flush();
         break;
+    case BTIF_MEDIA_SET_SW_VOLUME:
+        btif_media_task_set_sw_volume(p_msg);
+        break;
 #endif
     default:
         APPL_TRACE_ERROR("ERROR in btif_media_task_handle_cmd unknown event %d", p_msg->event);
@@ -1689,63 +1690,28 @@ static void btif_media_task_handle_cmd(BT_HDR *p_msg)
 #if (BTA_AV_SINK_INCLUDED == TRUE)
 /*******************************************************************************
  **
- ** Function         btif_media_task_handle_inc_media
+ ** Function         btif_media_task_sbc_decode
  **
- ** Description
+ ** Description      Jitter buffer decode callback: decode one SBC frame.
  **
- ** Returns          void
+ ** Returns          Number of PCM bytes written, 0 on failure.
  **
  *******************************************************************************/
-static void btif_media_task_handle_inc_media(tBT_SBC_HDR*p_msg)
+static UINT32 btif_media_task_sbc_decode(const UINT8 **pp_data, UINT32 *p_len,
+                                         INT16 *p_pcm, UINT32 pcm_bytes)
 {
-    UINT8 *sbc_start_frame = ((UINT8*)(p_msg + 1) + p_msg->offset + 1);
-    int count;
-    UINT32 pcmBytes, availPcmBytes;
-    OI_INT16 *pcmDataPointer = pcmData; /*Will be overwritten on next packet receipt*/
+    OI_UINT32 frame_len = *p_len;
+    OI_UINT32 pcmBytes = pcm_bytes;
     OI_STATUS status;
-    int num_sbc_frames = p_msg->num_frames_to_be_processed;
-    UINT32 sbc_frame_len = p_msg->len - 1;
-#ifdef AVK_BACKPORT
-    int retwriteAudioTrack = 0;
-#endif
-    availPcmBytes = 2*sizeof(pcmData);
 
-    if ((btif_media_cb.peer_sep == AVDT_TSEP_SNK) || (btif_media_cb.rx_flush))
-    {
-        APPL_TRACE_DEBUG(" State Changed happened in this tick ");
-        return;
-    }
-
-#ifndef AVK_BACKPORT
-    // ignore data if no one is listening
-    if (!btif_media_cb.data_channel_open)
-        return;
-#endif
-
-    APPL_TRACE_DEBUG("Number of sbc frames %d, frame_len %d", num_sbc_frames, sbc_frame_len);
-
-    for(count = 0; count < num_sbc_frames && sbc_frame_len != 0; count ++)
-    {
-        pcmBytes = availPcmBytes;
-        status = OI_CODEC_SBC_DecodeFrame(&context, (const OI_BYTE**)&sbc_start_frame,
-                                                        (OI_UINT32 *)&sbc_frame_len,
-                                                        (OI_INT16 *)pcmDataPointer,
-                                                        (OI_UINT32 *)&pcmBytes);
-        if (!OI_SUCCESS(status)) {
-            APPL_TRACE_ERROR("Decoding failure: %d\n", status);
-            break;
-        }
-        availPcmBytes -= pcmBytes;
-        pcmDataPointer += pcmBytes/2;
-        p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
-        p_msg->len = sbc_frame_len + 1;
+    status = OI_CODEC_SBC_DecodeFrame(&context, (const OI_BYTE**)pp_data, &frame_len,
+                                      (OI_INT16 *)p_pcm, &pcmBytes);
+    *p_len = frame_len;
+    if (!OI_SUCCESS(status)) {
+        APPL_TRACE_ERROR("Decoding failure: %d\n", status);
+        return 0;
     }
-#ifdef AVK_BACKPORT
-    retwriteAudioTrack = btWriteData((void*)pcmData, (2*sizeof(pcmData) - availPcmBytes));
-    APPL_TRACE_LATENCY_AUDIO("Written to audio, seq number %d", p_msg->layer_specific);
-#else
-    UIPC_Send(UIPC_CH_ID_AV_AUDIO, 0, (UINT8 *)pcmData, (2*sizeof(pcmData) - availPcmBytes));
-#endif
+    return pcmBytes;
 }
 #endif
 
@@ -1895,7 +1861,8 @@ BOOLEAN btif_media_task_aa_rx_flush_req(void)
 {
     BT_HDR *p_buf;
 
-    if (GKI_queue_is_empty(&(btif_media_cb.RxSbcQ))== TRUE) /*  Que is already empty */
+    if ((GKI_queue_is_empty(&(btif_media_cb.RxJb.q))== TRUE) /*  Que is already empty */
+        && (btif_media_cb.RxJb.p_cur == NULL))
         return TRUE;
 
     if (NULL == (p_buf = GKI_getbuf(sizeof(BT_HDR))))
@@ -1945,7 +1912,7 @@ static void btif_media_task_aa_rx_flush(void)
     /* Flush all enqueued GKI SBC  buffers (encoded) */
     APPL_TRACE_DEBUG("btif_media_task_aa_rx_flush");
 
-    btif_media_flush_q(&(btif_media_cb.RxSbcQ));
+    btif_media_jb_flush(&btif_media_cb.RxJb);
 }
 
 
@@ -1973,6 +1940,25 @@ static void btif_media_task_aa_tx_flush(BT_HDR *p_msg)
     UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, NULL);
 }
 
+/*******************************************************************************
+ **
+ ** Function         btif_media_task_set_sw_volume
+ **
+ ** Description      Ramp the outgoing audio to a new software volume
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_task_set_sw_volume(BT_HDR *p_msg)
+{
+    tBTIF_MEDIA_SW_VOLUME *p_vol = (tBTIF_MEDIA_SW_VOLUME *)p_msg;
+
+    APPL_TRACE_DEBUG("btif_media_task_set_sw_volume %d", p_vol->volume);
+
+    btif_media_pcm_set_gain(&btif_media_cb.TxPcm,
+                            btif_media_pcm_volume_to_gain(p_vol->volume));
+}
+
 /*******************************************************************************
  **
  ** Function       btif_media_task_enc_init
@@ -2286,6 +2272,10 @@ static void btif_media_task_audio_feeding_init(BT_HDR *p_msg)
     btif_media_cb.feeding_mode = p_feeding->feeding_mode;
     btif_media_cb.media_feeding = p_feeding->feeding;
 
+    btif_media_pcm_config(&btif_media_cb.TxPcm,
+            btif_media_pcm_bits_to_fmt(p_feeding->feeding.cfg.pcm.bit_per_sample),
+            (UINT8)p_feeding->feeding.cfg.pcm.num_channel);
+
     /* Handle different feeding formats */
     switch (p_feeding->feeding.format)
     {
@@ -2399,6 +2389,7 @@ static void btif_media_task_aa_handle_start_decoding(void )
 static void btif_media_task_aa_handle_clear_track (void)
 {
     APPL_TRACE_DEBUG("btif_media_task_aa_handle_clear_track");
+    btif_media_jb_dump_stats(&btif_media_cb.RxJb);
 #ifdef AVK_BACKPORT
     btStopTrack();
     btDeleteTrack();
@@ -2552,8 +2543,12 @@ static void btif_media_task_aa_handle_decoder_reset(BT_HDR *p_msg)
 
     APPL_TRACE_DEBUG("\tBit pool Min:%d Max:%d", sbc_cie.min_bitpool, sbc_cie.max_bitpool);
 
-    btif_media_cb.frames_to_process = ((freq_multiple)/(num_blocks*num_subbands)) + 1;
-    APPL_TRACE_DEBUG(" Frames to be processed in 20 ms %d",btif_media_cb.frames_to_process);
+    APPL_TRACE_DEBUG(" Frames in 20 ms %d", (freq_multiple)/(num_blocks*num_subbands));
+
+    btif_media_jb_dump_stats(&btif_media_cb.RxJb);
+    btif_media_jb_init(&btif_media_cb.RxJb, btif_media_task_sbc_decode,
+                       btif_media_cb.sample_rate, btif_media_cb.channel_count,
+                       (UINT16)(num_blocks * num_subbands), BTIF_SINK_MEDIA_TIME_TICK);
 }
 #endif
 
@@ -2920,24 +2915,21 @@ static void btif_get_num_aa_frame(UINT8 *num_of_iterations, UINT8 *num_of_frames
 UINT8 btif_media_sink_enque_buf(BT_HDR *p_pkt)
 {
     tBT_SBC_HDR *p_msg;
+    UINT8 count;
 
     if(btif_media_cb.rx_flush == TRUE) /* Flush enabled, do not enque*/
-        return btif_media_cb.RxSbcQ.count;
-    if(btif_media_cb.RxSbcQ.count == MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ)
-    {
-        GKI_freebuf(GKI_dequeue(&(btif_media_cb.RxSbcQ)));
-    }
+        return btif_media_cb.RxJb.q.count;
 
     BTIF_TRACE_VERBOSE("btif_media_sink_enque_buf + ");
-    /* allocate and Queue this buffer */
+    /* allocate and Queue this buffer; the offset area carries the RTP time stamp */
     if ((p_msg = (tBT_SBC_HDR *) GKI_getbuf(sizeof(tBT_SBC_HDR) +
                         p_pkt->offset+ p_pkt->len)) != NULL)
     {
         memcpy(p_msg, p_pkt, (sizeof(BT_HDR) + p_pkt->offset + p_pkt->len));
         p_msg->num_frames_to_be_processed = (*((UINT8*)(p_msg + 1) + p_msg->offset)) & 0x0f;
         BTIF_TRACE_VERBOSE("btif_media_sink_enque_buf + ", p_msg->num_frames_to_be_processed);
-        GKI_enqueue(&(btif_media_cb.RxSbcQ), p_msg);
-        if(btif_media_cb.RxSbcQ.count == MAX_A2DP_DELAYED_START_FRAME_COUNT)
+        count = btif_media_jb_put(&btif_media_cb.RxJb, p_msg, GKI_now_us());
+        if(count == MAX_A2DP_DELAYED_START_FRAME_COUNT)
         {
             BTIF_TRACE_DEBUG(" Initiate Decoding ");
             btif_media_task_start_decoding_req();
@@ -2948,7 +2940,7 @@ UINT8 btif_media_sink_enque_buf(BT_HDR *p_pkt)
         /* let caller deal with a failed allocation */
         BTIF_TRACE_VERBOSE("btif_media_sink_enque_buf No Buffer left - ");
     }
-    return btif_media_cb.RxSbcQ.count;
+    return btif_media_cb.RxJb.q.count;
 }
 
 /*******************************************************************************
@@ -2969,7 +2961,9 @@ BT_HDR *btif_media_aa_readbuf(void)
  **
  ** Function         btif_media_aa_read_feeding
  **
- ** Description
+ ** Description      Fill the encoder with one SBC frame worth of PCM: read
+ **                  from the audio channel, convert through the PCM stage
+ **                  and up-sample when the rates differ.
  **
  ** Returns          void
  **
@@ -2983,12 +2977,16 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
     UINT32 read_size;
     UINT16 sbc_sampling = 48000;
     UINT32 src_samples;
-    UINT16 bytes_needed = blocm_x_subband * btif_media_cb.encoder.s16NumOfChannels * \
-                          btif_media_cb.media_feeding.cfg.pcm.bit_per_sample / 8;
+    UINT32 frame_size = btif_media_pcm_frame_size(&btif_media_cb.TxPcm);
+    UINT16 bytes_needed = blocm_x_subband * btif_media_cb.encoder.s16NumOfChannels *
+                          sizeof(SINT16);
+    UINT16 up_bytes_needed = blocm_x_subband * 2 * sizeof(SINT16);
     static UINT16 up_sampled_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS
             * SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS * 2];
-    static UINT16 read_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS
+    /* sized for 32 bit source samples */
+    static UINT32 read_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS
             * SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
+    UINT8 *p_feed;
     UINT32 src_size_used;
     UINT32 dst_size_used;
     BOOLEAN fract_needed;
@@ -3014,13 +3012,24 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
     }
 
     if (sbc_sampling == btif_media_cb.media_feeding.cfg.pcm.sampling_freq) {
-        read_size = bytes_needed - btif_media_cb.media_feeding_state.pcm.aa_feed_residue;
+        /* Read straight into the encoder buffer unless the source block is
+         * wider than it, then run the PCM stage there in place */
+        read_size = blocm_x_subband * frame_size;
+        if (read_size <= sizeof(btif_media_cb.encoder.as16PcmBuffer))
+            p_feed = (UINT8 *)btif_media_cb.encoder.as16PcmBuffer;
+        else
+            p_feed = (UINT8 *)read_buffer;
+
+        read_size -= btif_media_cb.media_feeding_state.pcm.aa_feed_residue;
         nb_byte_read = UIPC_Read(channel_id, &event,
-                  ((UINT8 *)btif_media_cb.encoder.as16PcmBuffer) +
-                  btif_media_cb.media_feeding_state.pcm.aa_feed_residue,
+                  p_feed + btif_media_cb.media_feeding_state.pcm.aa_feed_residue,
                   read_size);
         if (nb_byte_read == read_size) {
             btif_media_cb.media_feeding_state.pcm.aa_feed_residue = 0;
+            btif_media_pcm_process(&btif_media_cb.TxPcm, p_feed, blocm_x_subband,
+                                   (UINT8)btif_media_cb.encoder.s16NumOfChannels);
+            if (p_feed != (UINT8 *)btif_media_cb.encoder.as16PcmBuffer)
+                memcpy(btif_media_cb.encoder.as16PcmBuffer, p_feed, bytes_needed);
             return TRUE;
         } else {
             APPL_TRACE_WARNING("### UNDERFLOW :: ONLY READ %d BYTES OUT OF %d ###",
@@ -3071,9 +3080,7 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
     }
 
     /* Compute number of bytes to read from source */
-    read_size = src_samples;
-    read_size *= btif_media_cb.media_feeding.cfg.pcm.num_channel;
-    read_size *= (btif_media_cb.media_feeding.cfg.pcm.bit_per_sample / 8);
+    read_size = src_samples * frame_size;
 
     /* Read Data from UIPC channel */
     nb_byte_read = UIPC_Read(channel_id, &event, (UINT8 *)read_buffer, read_size);
@@ -3102,16 +3109,22 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
 
         if(btif_media_cb.feeding_mode == BTIF_AV_FEEDING_ASYNCHRONOUS)
         {
-            /* Fill the unfilled part of the read buffer with silence (0) */
-            memset(((UINT8 *)read_buffer) + nb_byte_read, 0, read_size - nb_byte_read);
+            /* Fill the unfilled part of the read buffer with silence */
+            memset(((UINT8 *)read_buffer) + nb_byte_read,
+                   (btif_media_cb.TxPcm.fmt == BTIF_MEDIA_PCM_FMT_U8) ? 0x80 : 0,
+                   read_size - nb_byte_read);
             nb_byte_read = read_size;
         }
     }
 
+    /* Bring the samples to 16 bits at the current volume, keeping the
+     * source channels for the up-sampler */
+    nb_byte_read = btif_media_pcm_process(&btif_media_cb.TxPcm, read_buffer,
+            nb_byte_read / frame_size, btif_media_cb.TxPcm.channels);
+
     /* Initialize PCM up-sampling engine */
     bta_av_sbc_init_up_sample(btif_media_cb.media_feeding.cfg.pcm.sampling_freq,
-            sbc_sampling, btif_media_cb.media_feeding.cfg.pcm.bit_per_sample,
-            btif_media_cb.media_feeding.cfg.pcm.num_channel);
+            sbc_sampling, 16, btif_media_cb.media_feeding.cfg.pcm.num_channel);
 
     /* re-sample read buffer */
     /* The output PCM buffer will be stereo, 16 bit per sample */
@@ -3130,19 +3143,23 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
     btif_media_cb.media_feeding_state.pcm.aa_feed_residue += dst_size_used;
 
     /* only copy the pcm sample when we have up-sampled enough PCM */
-    if(btif_media_cb.media_feeding_state.pcm.aa_feed_residue >= bytes_needed)
+    if(btif_media_cb.media_feeding_state.pcm.aa_feed_residue >= up_bytes_needed)
     {
         /* Copy the output pcm samples in SBC encoding buffer */
         memcpy((UINT8 *)btif_media_cb.encoder.as16PcmBuffer,
                 (UINT8 *)up_sampled_buffer,
-                bytes_needed);
+                up_bytes_needed);
+        /* the up-sampler always produces stereo */
+        if (btif_media_cb.encoder.s16NumOfChannels == 1)
+            btif_media_pcm_downmix(btif_media_cb.encoder.as16PcmBuffer, blocm_x_subband);
+
         /* update the residue */
-        btif_media_cb.media_feeding_state.pcm.aa_feed_residue -= bytes_needed;
+        btif_media_cb.media_feeding_state.pcm.aa_feed_residue -= up_bytes_needed;
 
         if (btif_media_cb.media_feeding_state.pcm.aa_feed_residue != 0)
         {
             memcpy((UINT8 *)up_sampled_buffer,
-                   (UINT8 *)up_sampled_buffer + bytes_needed,
+                   (UINT8 *)up_sampled_buffer + up_bytes_needed,
                    btif_media_cb.media_feeding_state.pcm.aa_feed_residue);
         }
         return TRUE;
@@ -3150,7 +3167,7 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
 
 #if (defined(DEBUG_MEDIA_AV_FLOW) && (DEBUG_MEDIA_AV_FLOW == TRUE))
     APPL_TRACE_DEBUG("btif_media_aa_read_feeding residue:%d, dst_size_used %d, bytes_needed %d",
-            btif_media_cb.media_feeding_state.pcm.aa_feed_residue, dst_size_used, bytes_needed);
+            btif_media_cb.media_feeding_state.pcm.aa_feed_residue, dst_size_used, up_bytes_needed);
 #endif
 
     return FALSE;
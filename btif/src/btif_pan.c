@@ -32,6 +32,7 @@
 #include <sys/select.h>
 #include <sys/poll.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <stdio.h>
@@ -77,8 +78,6 @@
 
 #define asrt(s) if(!(s)) BTIF_TRACE_ERROR("btif_pan: ## %s assert %s failed at line:%d ##",__FUNCTION__, #s, __LINE__)
 
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
-
 btpan_cb_t btpan_cb;
 
 BD_ADDR local_addr;
@@ -94,6 +93,7 @@ static void btpan_tap_fd_signaled(int fd, int type, int flags, uint32_t user_id)
 static void btpan_cleanup_conn(btpan_conn_t* conn);
 static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN *p_data);
 static void btu_exec_tap_fd_read(void *p_param);
+static void btpan_tap_flush_rx(void);
 
 static btpan_interface_t pan_if = {
     sizeof(pan_if),
@@ -129,6 +129,7 @@ void btif_pan_init()
         memset(&btpan_cb, 0, sizeof(btpan_cb));
         btpan_cb.tap_fd = -1;
         btpan_cb.flow = 1;
+        GKI_init_q(&btpan_cb.rx_q);
         int i;
         for(i = 0; i < MAX_PAN_CONNS; i++)
             btpan_cleanup_conn(&btpan_cb.conns[i]);
@@ -445,25 +446,20 @@ int btpan_tap_send(int tap_fd, const BD_ADDR src, const BD_ADDR dst, UINT16 prot
     if(tap_fd != -1)
     {
         tETH_HDR eth_hdr;
+        struct iovec iov[2];
         //if(is_empty_eth_addr(dst))
         //    memcpy(&eth_hdr.h_dest, local_addr, ETH_ADDR_LEN);
         //else
         memcpy(&eth_hdr.h_dest, dst, ETH_ADDR_LEN);
         memcpy(&eth_hdr.h_src, src, ETH_ADDR_LEN);
         eth_hdr.h_proto = htons(proto);
-        char packet[2014];
-        memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
-        if(len > 2000)
-        {
-            ALOGE("btpan_tap_send eth packet size:%d is exceeded limit!", len);
-            return -1;
-        }
-        memcpy(packet + sizeof(tETH_HDR), buf, len);
 
-        /* Send data to network interface */
-        //btnet_send(btpan_cb.conn[i].sock.sock, &buffer, (len + sizeof(tETH_HDR)));
-        //dump_bin("packet to network", packet, len + sizeof(tETH_HDR));
-        int ret = write(tap_fd, packet, len + sizeof(tETH_HDR));
+        /* Send header and payload as one frame without copying the payload */
+        iov[0].iov_base = &eth_hdr;
+        iov[0].iov_len = sizeof(tETH_HDR);
+        iov[1].iov_base = (void *)buf;
+        iov[1].iov_len = len;
+        int ret = writev(tap_fd, iov, 2);
         BTIF_TRACE_DEBUG("ret:%d", ret);
         return ret;
     }
@@ -475,6 +471,7 @@ int btpan_tap_close(int fd)
 {
     tap_if_down(TAP_IF_NAME);
     close(fd);
+    btpan_tap_flush_rx();
     if(pan_pth >= 0)
         btsock_thread_wakeup(pan_pth);
     return 0;
@@ -696,50 +693,22 @@ static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN *p_data)
     btif_transfer_context(bta_pan_callback_transfer, event, (char*)p_data, sizeof(tBTA_PAN), NULL);
 }
 
-#define IS_EXCEPTION(e) ((e) & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL))
+// Runs in BTU context: hands the frames queued by the TAP reader thread to BNEP.
+// The BNEP header is built in the headroom in front of each frame, so nothing
+// is copied here.
 static void btu_exec_tap_fd_read(void *p_param) {
-    struct pollfd ufd;
     int fd = (int)p_param;
+    BT_HDR *buffer;
 
-    if (fd == -1 || fd != btpan_cb.tap_fd)
+    if (fd == -1 || fd != btpan_cb.tap_fd) {
+        btpan_tap_flush_rx();
         return;
+    }
 
-    // Don't occupy BTU context too long, avoid GKI buffer overruns and
-    // give other profiles a chance to run by limiting the amount of memory
-    // PAN can use from the shared pool buffer.
-    for(int i = 0; i < PAN_POOL_MAX && btif_is_enabled() && btpan_cb.flow; i++) {
-        BT_HDR *buffer = (BT_HDR *)GKI_getpoolbuf(PAN_POOL_ID);
-        if (!buffer) {
-            BTIF_TRACE_WARNING("%s unable to allocate buffer for packet.", __func__);
-            break;
-        }
-        buffer->offset = PAN_MINIMUM_OFFSET;
-        buffer->len = GKI_get_buf_size(buffer) - sizeof(BT_HDR) - buffer->offset;
-
-        UINT8 *packet = (UINT8 *)buffer + sizeof(BT_HDR) + buffer->offset;
-
-        // If we don't have an undelivered packet left over, pull one from the TAP driver.
-        // We save it in the congest_packet right away in case we can't deliver it in this
-        // attempt.
-        if (!btpan_cb.congest_packet_size) {
-            ssize_t ret = read(fd, btpan_cb.congest_packet, sizeof(btpan_cb.congest_packet));
-            switch (ret) {
-                case -1:
-                    BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__, strerror(errno));
-                    GKI_freebuf(buffer);
-                    return;
-                case 0:
-                    BTIF_TRACE_WARNING("%s end of file reached.", __func__);
-                    GKI_freebuf(buffer);
-                    return;
-                default:
-                    btpan_cb.congest_packet_size = ret;
-                    break;
-            }
-        }
-
-        memcpy(packet, btpan_cb.congest_packet, MIN(btpan_cb.congest_packet_size, buffer->len));
-        buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
+    // Frames stay queued while the outbound flow is off.
+    while (btif_is_enabled() && btpan_cb.flow &&
+           (buffer = (BT_HDR *)GKI_dequeue(&btpan_cb.rx_q)) != NULL) {
+        UINT8 *packet = (UINT8 *)(buffer + 1) + buffer->offset;
 
         if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR *)packet)) {
             // Extract the ethernet header from the buffer since the PAN_WriteBuf inside
@@ -750,23 +719,79 @@ static void btu_exec_tap_fd_read(void *p_param) {
             // Skip the ethernet header.
             buffer->len -= sizeof(tETH_HDR);
             buffer->offset += sizeof(tETH_HDR);
-            if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-                btpan_cb.congest_packet_size = 0;
+            if (forward_bnep(&hdr, buffer) == FORWARD_CONGEST) {
+                // BNEP hands the frame back. Put it back at the head of the
+                // queue and stop reading until BNEP turns the flow on again,
+                // which calls btpan_set_flow_control() and resumes both.
+                buffer->len += sizeof(tETH_HDR);
+                buffer->offset -= sizeof(tETH_HDR);
+                GKI_enqueue_head(&btpan_cb.rx_q, buffer);
+                btpan_cb.flow = 0;
+                BTIF_TRACE_DEBUG("%s BNEP congested, holding %d frames", __func__,
+                                 btpan_cb.rx_q.count);
+                break;
+            }
         } else {
             BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__, buffer->len);
-            btpan_cb.congest_packet_size = 0;
             GKI_freebuf(buffer);
         }
+    }
+
+    // Let the reader thread pull more frames once everything read so far is delivered.
+    if (btpan_cb.flow && GKI_queue_is_empty(&btpan_cb.rx_q))
+        btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
+}
+
+// Runs on the TAP reader thread: reads as many frames as are ready, straight
+// into GKI buffers that reserve PAN_MINIMUM_OFFSET of headroom, and posts them
+// to BTU in one batch. The number of queued frames is bounded by PAN_POOL_MAX
+// so PAN cannot drain the shared pool.
+static void btpan_tap_read_batch(int fd) {
+    int count = 0;
+    bool rearm = true;
+
+    while (btpan_cb.flow && btpan_cb.rx_q.count < PAN_POOL_MAX) {
+        BT_HDR *buffer = (BT_HDR *)GKI_getpoolbuf(PAN_POOL_ID);
+        if (!buffer) {
+            BTIF_TRACE_WARNING("%s unable to allocate buffer for packet.", __func__);
+            break;
+        }
+        buffer->offset = PAN_MINIMUM_OFFSET;
 
-        // Bail out of the loop if reading from the TAP fd would block.
-        ufd.fd = fd;
-        ufd.events = POLLIN;
-        ufd.revents = 0;
-        if(poll(&ufd, 1, 0) <= 0 || IS_EXCEPTION(ufd.revents)) {
-            btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-            return;
+        ssize_t ret = read(fd, (UINT8 *)(buffer + 1) + buffer->offset,
+                           GKI_get_buf_size(buffer) - sizeof(BT_HDR) - buffer->offset);
+        if (ret <= 0) {
+            int err = errno;
+            GKI_freebuf(buffer);
+            if (ret == -1 && (err == EAGAIN || err == EWOULDBLOCK))
+                break;
+            if (ret == 0) {
+                BTIF_TRACE_WARNING("%s end of file reached.", __func__);
+            } else {
+                BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__, strerror(err));
+            }
+            rearm = false;
+            break;
         }
+        buffer->len = ret;
+        GKI_enqueue(&btpan_cb.rx_q, buffer);
+        count++;
     }
+
+    // BTU re-arms the fd once the queue is drained; with nothing queued, do it here.
+    if (!GKI_queue_is_empty(&btpan_cb.rx_q))
+        bta_dmexecutecallback(btu_exec_tap_fd_read, (void *)fd);
+    else if (rearm && btpan_cb.flow)
+        btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
+
+    BTIF_TRACE_DEBUG("%s read %d frames", __func__, count);
+}
+
+static void btpan_tap_flush_rx(void) {
+    BT_HDR *buffer;
+
+    while ((buffer = (BT_HDR *)GKI_dequeue(&btpan_cb.rx_q)) != NULL)
+        GKI_freebuf(buffer);
 }
 
 static void btif_pan_close_all_conns() {
@@ -790,5 +815,5 @@ static void btpan_tap_fd_signaled(int fd, int type, int flags, uint32_t user_id)
         btpan_tap_close(fd);
         btif_pan_close_all_conns();
     } else if(flags & SOCK_THREAD_FD_RD)
-        bta_dmexecutecallback(btu_exec_tap_fd_read, (void *)fd);
+        btpan_tap_read_batch(fd);
 }
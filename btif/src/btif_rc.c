@@ -36,6 +36,7 @@
 #include "btif_common.h"
 #include "btif_util.h"
 #include "btif_av.h"
+#include "btif_media.h"
 #include "hardware/bt_rc.h"
 #include "uinput.h"
 
@@ -142,6 +143,7 @@ typedef struct {
     btif_rc_reg_notifications_t rc_notif[MAX_RC_NOTIFICATIONS];
     unsigned int                rc_volume;
     uint8_t                     rc_vol_label;
+    BOOLEAN                     rc_sw_volume;   /* volume applied to the stream locally */
 } btif_rc_cb_t;
 
 typedef struct {
@@ -232,6 +234,7 @@ static void register_volumechange(UINT8 label);
 static void lbl_init();
 static void lbl_destroy();
 static void init_all_transactions();
+static void reset_sw_volume();
 static bt_status_t  get_transaction(rc_transaction_t **ptransaction);
 static void release_transaction(UINT8 label);
 static rc_transaction_t* get_transaction_by_lbl(UINT8 label);
@@ -390,6 +393,11 @@ void close_uinput (void)
 
 void handle_rc_features()
 {
+    /* a peer found to take absolute volume must not be scaled twice */
+    if (btif_rc_cb.rc_sw_volume && (btif_rc_cb.rc_features & BTA_AV_FEAT_RCTG) &&
+        (btif_rc_cb.rc_features & BTA_AV_FEAT_ADV_CTRL))
+        reset_sw_volume();
+
     if (bt_rc_callbacks != NULL)
     {
         /*Enabling Absolute volume and other avrcp TG specific features only if A2dp Src and
@@ -514,6 +522,8 @@ void handle_rc_connect (tBTA_AV_RC_OPEN *p_rc_open)
         btif_rc_cb.rc_features = p_rc_open->peer_features;
         btif_rc_cb.rc_vol_label=MAX_LABEL;
         btif_rc_cb.rc_volume=MAX_VOLUME;
+        /* a gain left by an earlier peer must not scale this one */
+        reset_sw_volume();
 
         btif_rc_cb.rc_connected = TRUE;
         btif_rc_cb.rc_handle = p_rc_open->rc_handle;
@@ -587,6 +597,7 @@ void handle_rc_disconnect (tBTA_AV_RC_CLOSE *p_rc_close)
     btif_rc_cb.rc_features = 0;
     btif_rc_cb.rc_vol_label=MAX_LABEL;
     btif_rc_cb.rc_volume=MAX_VOLUME;
+    reset_sw_volume();
     init_all_transactions();
     if (bt_rc_callbacks != NULL)
     {
@@ -2743,11 +2754,40 @@ static bt_status_t set_volume(uint8_t volume)
             status = BT_STATUS_FAIL;
         }
     }
+    else if (btif_rc_cb.rc_connected && btif_rc_cb.rc_features != 0)
+    {
+        /* The peer cannot take the volume, scale the stream instead */
+        BTIF_TRACE_DEBUG("%s: Peer lacks absolute volume, software volume=%d",
+                         __FUNCTION__, volume);
+        btif_a2dp_set_sw_volume(volume);
+        btif_rc_cb.rc_sw_volume = TRUE;
+        btif_rc_cb.rc_volume = volume;
+        status = BT_STATUS_SUCCESS;
+    }
     else
-        status=BT_STATUS_NOT_READY;
+    {
+        /* features of a peer that connected to us are not known yet */
+        status = BT_STATUS_NOT_READY;
+    }
     return status;
 }
 
+/***************************************************************************
+**
+** Function         reset_sw_volume
+**
+** Description      Restores the stream to full scale and forgets the
+**                  software volume set for a peer without absolute volume.
+**
+** Returns          void
+**
+***************************************************************************/
+static void reset_sw_volume()
+{
+    btif_a2dp_set_sw_volume(MAX_VOLUME);
+    btif_rc_cb.rc_sw_volume = FALSE;
+}
+
 
 /***************************************************************************
 **
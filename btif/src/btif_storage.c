@@ -51,8 +51,11 @@
 #include "btif_hh.h"
 #include "bta_hd_api.h"
 #include "btif_hd.h"
+#include "sdp_api.h"
+#include "interop.h"
 
 #include <cutils/log.h>
+#include <cutils/properties.h>
 
 /************************************************************************************
 **  Constants & Macros
@@ -104,6 +107,8 @@
 #define BTIF_STORAGE_KEY_AUTOPAIR_DYNAMIC_BLACKLIST_ADDR "DynamicAddressBlacklist"
 
 #define BTIF_AUTO_PAIR_CONF_VALUE_SEPARATOR ","
+/* Address entries are compared on the Lower Address Part, "XX:XX:XX" */
+#define BTIF_AUTO_PAIR_ADDR_PREFIX_LEN 3
 
 
 /* This is a local property to add a device found */
@@ -166,6 +171,12 @@
 #endif
 
 
+#define BTIF_STORAGE_PATH_SDP_CACHE  "SdpCache"
+#define BTIF_STORAGE_PATH_CTRL_CAPS  "ControllerCaps"
+
+/* overrides the lifetime of cached SDP results, in seconds, 0 disables the cache */
+#define BTIF_STORAGE_SDP_CACHE_TTL_PROPERTY "persist.bluetooth.sdpcachettl"
+
 #define BTIF_STORAGE_HL_APP          "hl_app"
 #define BTIF_STORAGE_HL_APP_CB       "hl_app_cb"
 #define BTIF_STORAGE_HL_APP_DATA     "hl_app_data_"
@@ -177,9 +188,18 @@
 typedef struct
 {
     uint32_t num_devices;
-    bt_bdaddr_t devices[BTM_SEC_MAX_DEVICE_RECORDS];
+    uint32_t size;
+    bt_bdaddr_t *devices;
 } btif_bonded_devices_t;
 
+/* What the fetch functions do with each bonded device found in NVRAM */
+#define BTIF_STORAGE_FETCH_ONLY     0   /* check that it has keys */
+#define BTIF_STORAGE_ADD_BTA        1   /* list it and add it to BTA */
+#define BTIF_STORAGE_ADD_DEFER      2   /* list it, BTM pages it in when needed */
+#define BTIF_STORAGE_ADD_SYNC       3   /* add it to BTM, called from the BTU task */
+
+#define BTIF_STORAGE_IS_ADD(add)    ((add) == BTIF_STORAGE_ADD_BTA || (add) == BTIF_STORAGE_ADD_SYNC)
+
 /************************************************************************************
 **  External variables
 ************************************************************************************/
@@ -556,7 +576,7 @@ static bt_status_t btif_in_fetch_bonded_device(char *bdstr)
         }
 #if (BLE_INCLUDED == TRUE)
         btif_bonded_devices_t* bonded = 0;
-        if((btif_in_fetch_bonded_ble_device(bdstr, FALSE, bonded) != BT_STATUS_SUCCESS)
+        if((btif_in_fetch_bonded_ble_device(bdstr, BTIF_STORAGE_FETCH_ONLY, bonded) != BT_STATUS_SUCCESS)
                 && (!bt_linkkey_file_found))
         {
             BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", bdstr);
@@ -572,12 +592,200 @@ static bt_status_t btif_in_fetch_bonded_device(char *bdstr)
     return BT_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+**
+** Function         btif_in_bonded_devices_add
+**
+** Description      Internal helper function to append a device to a bonded
+**                  devices list, growing it as needed
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_in_bonded_devices_add(btif_bonded_devices_t *p_bonded_devices,
+                                       const bt_bdaddr_t *bd_addr)
+{
+    if (p_bonded_devices->num_devices == p_bonded_devices->size)
+    {
+        uint32_t size = p_bonded_devices->size ? p_bonded_devices->size * 2 : 16;
+        bt_bdaddr_t *devices = realloc(p_bonded_devices->devices, size * sizeof(bt_bdaddr_t));
+
+        if (devices == NULL)
+        {
+            BTIF_TRACE_ERROR("%s: unable to list more than %d bonded devices", __FUNCTION__,
+                             p_bonded_devices->num_devices);
+            return;
+        }
+        p_bonded_devices->devices = devices;
+        p_bonded_devices->size = size;
+    }
+    memcpy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], bd_addr, sizeof(bt_bdaddr_t));
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_bonded_devices_free
+**
+** Description      Internal helper function to release a bonded devices list
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_in_bonded_devices_free(btif_bonded_devices_t *p_bonded_devices)
+{
+    free(p_bonded_devices->devices);
+    memset(p_bonded_devices, 0, sizeof(btif_bonded_devices_t));
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_add_device
+**
+** Description      Internal helper function to add a BR/EDR device to the
+**                  security database, through BTA or directly to BTM when
+**                  called from the BTU task
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_in_add_device(int add, BD_ADDR bd_addr, DEV_CLASS dev_class,
+                               LINK_KEY link_key, UINT8 key_type, UINT8 pin_len)
+{
+    UINT32 trusted_mask[BTM_SEC_SERVICE_ARRAY_SIZE];
+
+    if (add == BTIF_STORAGE_ADD_SYNC)
+    {
+        memset(trusted_mask, 0, sizeof(trusted_mask));
+        BTM_SecAddDevice(bd_addr, dev_class, NULL, NULL, trusted_mask, link_key, key_type, 0, pin_len);
+    }
+    else
+    {
+        BTA_DmAddDevice(bd_addr, dev_class, link_key, 0, 0, key_type, 0, pin_len);
+    }
+}
+
+#if (BLE_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         btif_in_add_ble_device
+**
+** Description      Internal helper function to add a LE device to the
+**                  security database, through BTA or directly to BTM when
+**                  called from the BTU task
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_in_add_ble_device(int add, BD_ADDR bd_addr, int addr_type)
+{
+    if (add == BTIF_STORAGE_ADD_SYNC)
+        BTM_SecAddBleDevice(bd_addr, NULL, BT_DEVICE_TYPE_BLE, (tBLE_ADDR_TYPE)addr_type);
+    else
+        BTA_DmAddBleDevice(bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
+}
+
+/*******************************************************************************
+**
+** Function         btif_in_add_ble_key
+**
+** Description      Internal helper function to add a LE key to the security
+**                  database, through BTA or directly to BTM when called from
+**                  the BTU task
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_in_add_ble_key(int add, BD_ADDR bd_addr, tBTA_LE_KEY_VALUE *p_key,
+                                tBTA_LE_KEY_TYPE key_type)
+{
+    if (add == BTIF_STORAGE_ADD_SYNC)
+        BTM_SecAddBleKey(bd_addr, (tBTM_LE_KEY_VALUE *)p_key, key_type);
+    else
+        BTA_DmAddBleKey(bd_addr, p_key, key_type);
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         btif_in_fetch_remote_device
+**
+** Description      Internal helper function to fetch one bonded device from
+**                  NVRAM, add it as requested by |add| and list it in
+**                  |p_bonded_devices| if not NULL
+**
+** Returns          TRUE if the device has a link key or LE keys
+**
+*******************************************************************************/
+static BOOLEAN btif_in_fetch_remote_device(char *kname, int add,
+                                           btif_bonded_devices_t *p_bonded_devices)
+{
+    BOOLEAN bt_linkkey_file_found=FALSE;
+    BOOLEAN ble_keys_found=FALSE;
+    int device_type;
+    int type = BTIF_CFG_TYPE_BIN;
+    LINK_KEY link_key;
+    int size = sizeof(link_key);
+
+    if(btif_config_get("Remote", kname, "LinkKey", (char*)link_key, &size, &type))
+    {
+        int linkkey_type;
+        if(btif_config_get_int("Remote", kname, "LinkKeyType", &linkkey_type))
+        {
+            int pin_len = 0;
+            btif_config_get_int("Remote", kname, "PinLength", &pin_len);
+            bt_bdaddr_t bd_addr;
+            str2bd(kname, &bd_addr);
+            if(BTIF_STORAGE_IS_ADD(add))
+            {
+                DEV_CLASS dev_class = {0, 0, 0};
+                int cod;
+                if(btif_config_get_int("Remote", kname, "DevClass", &cod))
+                    uint2devclass((UINT32)cod, dev_class);
+                btif_in_add_device(add, bd_addr.address, dev_class, link_key, (UINT8)linkkey_type, (UINT8)pin_len);
+            }
+
+#if BLE_INCLUDED == TRUE
+            if (add != BTIF_STORAGE_FETCH_ONLY && add != BTIF_STORAGE_ADD_SYNC &&
+                btif_config_get_int("Remote", kname, "DevType", &device_type) &&
+                (device_type == BT_DEVICE_TYPE_DUMO) )
+            {
+                btif_gatts_add_bonded_dev_from_nv(bd_addr.address);
+            }
+#endif
+            bt_linkkey_file_found = TRUE;
+            if (p_bonded_devices)
+                btif_in_bonded_devices_add(p_bonded_devices, &bd_addr);
+        }
+        else
+        {
+#if (BLE_INCLUDED == FALSE)
+            BTIF_TRACE_ERROR("bounded device:%s, LinkKeyType or PinLength is invalid", kname);
+#endif
+        }
+    }
+#if (BLE_INCLUDED == TRUE)
+    ble_keys_found = (btif_in_fetch_bonded_ble_device(kname, add, p_bonded_devices) == BT_STATUS_SUCCESS);
+    if(!ble_keys_found && !bt_linkkey_file_found)
+    {
+        BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", kname);
+    }
+#else
+    if(!bt_linkkey_file_found)
+        BTIF_TRACE_DEBUG("Remote device:%s, no link key", kname);
+#endif
+    return (bt_linkkey_file_found || ble_keys_found);
+}
+
 /*******************************************************************************
 **
 ** Function         btif_in_fetch_bonded_devices
 **
 ** Description      Internal helper function to fetch the bonded devices
-**                  from NVRAM
+**                  from NVRAM. When adding, only as many devices as the BTM
+**                  security database holds are added; the rest are listed
+**                  and paged in on demand by btif_storage_load_dev.
+**                  The caller must release the list with
+**                  btif_in_bonded_devices_free.
 **
 ** Returns          BT_STATUS_SUCCESS if successful, BT_STATUS_FAIL otherwise
 **
@@ -587,68 +795,21 @@ static bt_status_t btif_in_fetch_bonded_devices(btif_bonded_devices_t *p_bonded_
     BTIF_TRACE_DEBUG("in add:%d", add);
     memset(p_bonded_devices, 0, sizeof(btif_bonded_devices_t));
 
-    char kname[128], vname[128];
+    char kname[128];
     short kpos;
     int kname_size;
     kname_size = sizeof(kname);
     kname[0] = 0;
     kpos = 0;
-    BOOLEAN bt_linkkey_file_found=FALSE;
-    int device_type;
 
     do
     {
         kpos = btif_config_next_key(kpos, "Remote", kname, &kname_size);
         BTIF_TRACE_DEBUG("Remote device:%s, size:%d", kname, kname_size);
-        int type = BTIF_CFG_TYPE_BIN;
-        LINK_KEY link_key;
-        int size = sizeof(link_key);
-        if(btif_config_get("Remote", kname, "LinkKey", (char*)link_key, &size, &type))
-        {
-            int linkkey_type;
-            if(btif_config_get_int("Remote", kname, "LinkKeyType", &linkkey_type))
-            {
-                int pin_len;
-                btif_config_get_int("Remote", kname, "PinLength", &pin_len);
-                bt_bdaddr_t bd_addr;
-                str2bd(kname, &bd_addr);
-                if(add)
-                {
-                    DEV_CLASS dev_class = {0, 0, 0};
-                    int cod;
-                    if(btif_config_get_int("Remote", kname, "DevClass", &cod))
-                        uint2devclass((UINT32)cod, dev_class);
-                    BTA_DmAddDevice(bd_addr.address, dev_class, link_key, 0, 0, (UINT8)linkkey_type, 0, pin_len);
-
-#if BLE_INCLUDED == TRUE
-                    if (btif_config_get_int("Remote", kname, "DevType", &device_type) &&
-                       (device_type == BT_DEVICE_TYPE_DUMO) )
-                    {
-                        btif_gatts_add_bonded_dev_from_nv(bd_addr.address);
-                    }
-#endif
-                }
-                bt_linkkey_file_found = TRUE;
-                memcpy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], &bd_addr, sizeof(bt_bdaddr_t));
-            }
-            else
-            {
-#if (BLE_INCLUDED == TRUE)
-                bt_linkkey_file_found = FALSE;
-#else
-                BTIF_TRACE_ERROR("bounded device:%s, LinkKeyType or PinLength is invalid", kname);
-#endif
-            }
-        }
-#if (BLE_INCLUDED == TRUE)
-            if(!(btif_in_fetch_bonded_ble_device(kname,add, p_bonded_devices)) && (!bt_linkkey_file_found))
-            {
-                BTIF_TRACE_DEBUG("Remote device:%s, no link key or ble key found", kname);
-            }
-#else
-            if(!bt_linkkey_file_found)
-                BTIF_TRACE_DEBUG("Remote device:%s, no link key", kname);
-#endif
+        if (add == BTIF_STORAGE_ADD_BTA && p_bonded_devices->num_devices >= BTM_SEC_MAX_DEVICE_RECORDS)
+            btif_in_fetch_remote_device(kname, BTIF_STORAGE_ADD_DEFER, p_bonded_devices);
+        else
+            btif_in_fetch_remote_device(kname, add, p_bonded_devices);
         kname_size = sizeof(kname);
         kname[0] = 0;
     } while(kpos != -1);
@@ -656,6 +817,29 @@ static bt_status_t btif_in_fetch_bonded_devices(btif_bonded_devices_t *p_bonded_
     return BT_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+**
+** Function         btif_storage_load_dev
+**
+** Description      BTM device loader - adds a bonded device that is not in
+**                  the security database from NVRAM. Runs on the BTU task.
+**
+** Returns          TRUE if the device is bonded and was added
+**
+*******************************************************************************/
+static BOOLEAN btif_storage_load_dev(BD_ADDR bd_addr)
+{
+    bt_bdaddr_t addr;
+    bdstr_t bdstr;
+
+    bdcpy(addr.address, bd_addr);
+    bd2str(&addr, &bdstr);
+    if (!btif_config_exist("Remote", bdstr, NULL))
+        return FALSE;
+
+    return btif_in_fetch_remote_device(bdstr, BTIF_STORAGE_ADD_SYNC, NULL);
+}
+
 /************************************************************************************
 **  Externs
 ************************************************************************************/
@@ -698,18 +882,25 @@ bt_status_t btif_storage_get_adapter_property(bt_property_t *property)
     else if (property->type == BT_PROPERTY_ADAPTER_BONDED_DEVICES)
     {
         btif_bonded_devices_t bonded_devices;
+        int len;
 
-        btif_in_fetch_bonded_devices(&bonded_devices, 0);
+        btif_in_fetch_bonded_devices(&bonded_devices, BTIF_STORAGE_FETCH_ONLY);
 
         BTIF_TRACE_DEBUG("%s: Number of bonded devices: %d Property:BT_PROPERTY_ADAPTER_BONDED_DEVICES", __FUNCTION__, bonded_devices.num_devices);
 
-        if (bonded_devices.num_devices > 0)
+        /* if there are no bonded_devices, then length shall be 0 */
+        len = bonded_devices.num_devices * sizeof(bt_bdaddr_t);
+        if (len > property->len)
         {
-            property->len = bonded_devices.num_devices * sizeof(bt_bdaddr_t);
-            memcpy(property->val, bonded_devices.devices, property->len);
+            BTIF_TRACE_ERROR("%s: only %d of %d bonded devices fit", __FUNCTION__,
+                             property->len / sizeof(bt_bdaddr_t), bonded_devices.num_devices);
+            len = property->len - property->len % sizeof(bt_bdaddr_t);
         }
+        property->len = len;
+        if (len > 0)
+            memcpy(property->val, bonded_devices.devices, len);
 
-        /* if there are no bonded_devices, then length shall be 0 */
+        btif_in_bonded_devices_free(&bonded_devices);
         return BT_STATUS_SUCCESS;
     }
     else if (property->type == BT_PROPERTY_UUIDS)
@@ -924,6 +1115,155 @@ bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr)
 
 }
 
+/*******************************************************************************
+**
+** Function         btif_storage_sdp_cache_load
+**
+** Description      SDP cache callback - reads the cached SDP results of a
+**                  remote device from NVRAM
+**
+** Returns          TRUE if an entry was found, FALSE otherwise
+**
+*******************************************************************************/
+static BOOLEAN btif_storage_sdp_cache_load(BD_ADDR bd_addr, UINT8 *p_buf, UINT16 *p_len)
+{
+    bt_bdaddr_t remote_bd_addr;
+    bdstr_t bdstr;
+    int size = *p_len;
+    int type = BTIF_CFG_TYPE_BIN;
+
+    bdcpy(remote_bd_addr.address, bd_addr);
+    bd2str(&remote_bd_addr, &bdstr);
+    if (!btif_config_get("Remote", bdstr, BTIF_STORAGE_PATH_SDP_CACHE, (char*)p_buf, &size, &type))
+        return FALSE;
+
+    *p_len = (UINT16)size;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_sdp_cache_store
+**
+** Description      SDP cache callback - writes the cached SDP results of a
+**                  remote device to NVRAM, or removes them if len is 0
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_storage_sdp_cache_store(BD_ADDR bd_addr, UINT8 *p_buf, UINT16 len)
+{
+    bt_bdaddr_t remote_bd_addr;
+    bdstr_t bdstr;
+
+    bdcpy(remote_bd_addr.address, bd_addr);
+    bd2str(&remote_bd_addr, &bdstr);
+    if (len == 0)
+    {
+        if (btif_config_exist("Remote", bdstr, BTIF_STORAGE_PATH_SDP_CACHE))
+            btif_config_remove("Remote", bdstr, BTIF_STORAGE_PATH_SDP_CACHE);
+    }
+    else
+    {
+        btif_config_set("Remote", bdstr, BTIF_STORAGE_PATH_SDP_CACHE, (const char*)p_buf,
+                        len, BTIF_CFG_TYPE_BIN);
+    }
+    btif_config_save();
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_register_sdp_cache
+**
+** Description      BTIF storage API - lets the SDP client keep its cached
+**                  search results in NVRAM across restarts, and applies the
+**                  cache lifetime set in BTIF_STORAGE_SDP_CACHE_TTL_PROPERTY
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_register_sdp_cache(void)
+{
+    tSDP_CACHE_STORAGE storage;
+    char ttl[PROPERTY_VALUE_MAX];
+
+    storage.p_load = btif_storage_sdp_cache_load;
+    storage.p_store = btif_storage_sdp_cache_store;
+    SDP_CacheRegisterStorage(&storage);
+
+    if (property_get(BTIF_STORAGE_SDP_CACHE_TTL_PROPERTY, ttl, NULL) > 0)
+        SDP_CacheSetTtl((UINT32)strtoul(ttl, NULL, 10));
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_ctrl_caps_load
+**
+** Description      Controller capabilities callback - reads the snapshot taken
+**                  at a previous enable from NVRAM
+**
+** Returns          TRUE if a snapshot of the right size was found
+**
+*******************************************************************************/
+static BOOLEAN btif_storage_ctrl_caps_load(tBTM_CTRL_CAPS *p_caps)
+{
+    int size = sizeof(tBTM_CTRL_CAPS);
+    int type = BTIF_CFG_TYPE_BIN;
+
+    if (!btif_config_get("Local", "Adapter", BTIF_STORAGE_PATH_CTRL_CAPS, (char*)p_caps, &size, &type))
+        return FALSE;
+
+    /* written by a build with a different layout */
+    return size == sizeof(tBTM_CTRL_CAPS);
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_ctrl_caps_store
+**
+** Description      Controller capabilities callback - writes the snapshot to
+**                  NVRAM
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_storage_ctrl_caps_store(const tBTM_CTRL_CAPS *p_caps)
+{
+    btif_config_set("Local", "Adapter", BTIF_STORAGE_PATH_CTRL_CAPS, (const char*)p_caps,
+                    sizeof(tBTM_CTRL_CAPS), BTIF_CFG_TYPE_BIN);
+    btif_config_save();
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_register_ctrl_caps
+**
+** Description      BTIF storage API - lets BTM skip most of the controller
+**                  capability reads on enable when the firmware is unchanged
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_register_ctrl_caps(void)
+{
+    BTM_RegisterCtrlCapsCache(btif_storage_ctrl_caps_load, btif_storage_ctrl_caps_store);
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_register_dev_loader
+**
+** Description      BTIF storage API - lets BTM page bonded devices in from
+**                  NVRAM when they do not fit in its security database
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_register_dev_loader(void)
+{
+    BTM_SecRegisterDevLoader(btif_storage_load_dev);
+}
+
 /*******************************************************************************
 **
 ** Function         btif_storage_is_device_bonded
@@ -983,7 +1323,7 @@ bt_status_t btif_storage_load_bonded_devices(void)
     bt_uuid_t remote_uuids[BT_MAX_NUM_UUIDS];
     uint32_t cod, devtype, trustval;
 
-    btif_in_fetch_bonded_devices(&bonded_devices, 1);
+    btif_in_fetch_bonded_devices(&bonded_devices, BTIF_STORAGE_ADD_BTA);
 
     /* Now send the adapter_properties_cb with all adapter_properties */
     {
@@ -1084,9 +1424,30 @@ bt_status_t btif_storage_load_bonded_devices(void)
                                        num_props, remote_properties);
         }
     }
+    btif_in_bonded_devices_free(&bonded_devices);
     return BT_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+**
+** Function         btif_storage_get_num_bonded_devices
+**
+** Description      BTIF storage API - counts the bonded devices in NVRAM
+**
+** Returns          Number of bonded devices
+**
+*******************************************************************************/
+uint32_t btif_storage_get_num_bonded_devices(void)
+{
+    btif_bonded_devices_t bonded_devices;
+    uint32_t num_devices;
+
+    btif_in_fetch_bonded_devices(&bonded_devices, BTIF_STORAGE_FETCH_ONLY);
+    num_devices = bonded_devices.num_devices;
+    btif_in_bonded_devices_free(&bonded_devices);
+    return num_devices;
+}
+
 #if (BLE_INCLUDED == TRUE)
 
 /*******************************************************************************
@@ -1338,11 +1699,11 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                                                  buf,
                                                  sizeof(btif_dm_ble_penc_keys_t)) == BT_STATUS_SUCCESS)
             {
-                if(add)
+                if (BTIF_STORAGE_IS_ADD(add))
                 {
                     if (!is_device_added)
                     {
-                        BTA_DmAddBleDevice(bta_bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
+                        btif_in_add_ble_device(add, bta_bd_addr, addr_type);
                         is_device_added = TRUE;
                     }
                     p = (tBTA_LE_KEY_VALUE *)buf;
@@ -1357,7 +1718,7 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                     BTIF_TRACE_DEBUG("p->penc_key.ediv=0x%04x",p->penc_key.ediv);
                     BTIF_TRACE_DEBUG("p->penc_key.sec_level=0x%02x",p->penc_key.sec_level);
                     BTIF_TRACE_DEBUG("p->penc_key.key_size=0x%02x",p->penc_key.key_size);
-                    BTA_DmAddBleKey (bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_PENC);
+                    btif_in_add_ble_key(add, bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_PENC);
                 }
                 key_found = TRUE;
             }
@@ -1368,11 +1729,11 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                                                  buf,
                                                  sizeof(btif_dm_ble_pid_keys_t)) == BT_STATUS_SUCCESS)
             {
-                if(add)
+                if (BTIF_STORAGE_IS_ADD(add))
                 {
                     if (!is_device_added)
                     {
-                        BTA_DmAddBleDevice(bta_bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
+                        btif_in_add_ble_device(add, bta_bd_addr, addr_type);
                         is_device_added = TRUE;
                     }
                     p = (tBTA_LE_KEY_VALUE *)buf;
@@ -1388,7 +1749,7 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                                             ,i,p->pid_key.static_addr[i]);
                     }
 
-                    BTA_DmAddBleKey (bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_PID);
+                    btif_in_add_ble_key(add, bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_PID);
                 }
                 key_found = TRUE;
             }
@@ -1399,11 +1760,11 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                                                  buf,
                                                  sizeof(btif_dm_ble_pcsrk_keys_t)) == BT_STATUS_SUCCESS)
             {
-                if(add)
+                if (BTIF_STORAGE_IS_ADD(add))
                 {
                     if (!is_device_added)
                     {
-                        BTA_DmAddBleDevice(bta_bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
+                        btif_in_add_ble_device(add, bta_bd_addr, addr_type);
                         is_device_added = TRUE;
                     }
 
@@ -1415,7 +1776,7 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                     BTIF_TRACE_DEBUG("p->pcsrk_key.counter=0x%08x",p->psrk_key.counter);
                     BTIF_TRACE_DEBUG("p->pcsrk_key.sec_level=0x%02x",p->psrk_key.sec_level);
 
-                    BTA_DmAddBleKey (bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_PCSRK);
+                    btif_in_add_ble_key(add, bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_PCSRK);
                 }
                 key_found = TRUE;
             }
@@ -1426,11 +1787,11 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                                                  buf,
                                                  sizeof(btif_dm_ble_lenc_keys_t)) == BT_STATUS_SUCCESS)
             {
-                if(add)
+                if (BTIF_STORAGE_IS_ADD(add))
                 {
                     if (!is_device_added)
                     {
-                        BTA_DmAddBleDevice(bta_bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
+                        btif_in_add_ble_device(add, bta_bd_addr, addr_type);
                         is_device_added = TRUE;
                     }
                     p = (tBTA_LE_KEY_VALUE *)buf;
@@ -1438,7 +1799,7 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                     BTIF_TRACE_DEBUG("p->lenc_key.key_size=0x%02x",p->lenc_key.key_size);
                     BTIF_TRACE_DEBUG("p->lenc_key.sec_level=0x%02x",p->lenc_key.sec_level);
 
-                    BTA_DmAddBleKey (bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_LENC);
+                    btif_in_add_ble_key(add, bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_LENC);
                 }
                 key_found = TRUE;
             }
@@ -1449,11 +1810,11 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                                                  buf,
                                                  sizeof(btif_dm_ble_lcsrk_keys_t)) == BT_STATUS_SUCCESS)
             {
-                if(add)
+                if (BTIF_STORAGE_IS_ADD(add))
                 {
                     if (!is_device_added)
                     {
-                        BTA_DmAddBleDevice(bta_bd_addr, addr_type, BT_DEVICE_TYPE_BLE);
+                        btif_in_add_ble_device(add, bta_bd_addr, addr_type);
                         is_device_added = TRUE;
                     }
                     p = (tBTA_LE_KEY_VALUE *)buf;
@@ -1461,15 +1822,15 @@ bt_status_t btif_in_fetch_bonded_ble_device(char *remote_bd_addr,int add, btif_b
                     BTIF_TRACE_DEBUG("p->lcsrk_key.counter=0x%08x",p->lcsrk_key.counter);
                     BTIF_TRACE_DEBUG("p->lcsrk_key.sec_level=0x%02x",p->lcsrk_key.sec_level);
 
-                    BTA_DmAddBleKey (bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_LCSRK);
+                    btif_in_add_ble_key(add, bta_bd_addr, (tBTA_LE_KEY_VALUE *)buf, BTIF_DM_LE_KEY_LCSRK);
                 }
                 key_found = TRUE;
             }
 
             /* Fill in the bonded devices */
-            if (is_device_added && p_bonded_devices)
+            if (key_found && p_bonded_devices && add != BTIF_STORAGE_FETCH_ONLY)
             {
-                memcpy(&p_bonded_devices->devices[p_bonded_devices->num_devices++], &bd_addr, sizeof(bt_bdaddr_t));
+                btif_in_bonded_devices_add(p_bonded_devices, &bd_addr);
                 btif_gatts_add_bonded_dev_from_nv(bta_bd_addr);
             }
 
@@ -1762,6 +2123,98 @@ bt_status_t btif_storage_read_hl_apps_cb(char *value, int value_size)
 }
 
 
+/*******************************************************************************
+**
+** Function         btif_storage_parse_addr_prefix
+**
+** Description      Internal helper function to parse an address or address
+**                  prefix of the auto pair lists, such as "00:0F:F6". Only
+**                  the first BTIF_AUTO_PAIR_ADDR_PREFIX_LEN bytes are kept.
+**
+** Returns          BTIF_AUTO_PAIR_ADDR_PREFIX_LEN, 0 if malformed or shorter
+**
+*******************************************************************************/
+static UINT8 btif_storage_parse_addr_prefix(const char *str, BD_ADDR bd_addr)
+{
+    UINT8 len = 0;
+
+    while (isspace((unsigned char)*str))
+        str++;
+
+    while (len < BTIF_AUTO_PAIR_ADDR_PREFIX_LEN &&
+           isxdigit((unsigned char)str[0]) && isxdigit((unsigned char)str[1]))
+    {
+        char byte[3] = { str[0], str[1], '\0' };
+
+        bd_addr[len++] = (UINT8)strtoul(byte, NULL, 16);
+        str += 2;
+        if (*str != ':')
+            break;
+        str++;
+    }
+
+    /* a shorter entry never matched an address in the old lists */
+    return (len == BTIF_AUTO_PAIR_ADDR_PREFIX_LEN) ? len : 0;
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_compile_autopair_list
+**
+** Description      Internal helper function to hand the auto pair lists of the
+**                  config to the interop database, so that a lookup no longer
+**                  scans the config lines. Entries already there are kept.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_storage_compile_autopair_list(void)
+{
+    static const struct {
+        const char          *key;
+        tINTEROP_FEATURE    feature;
+        BOOLEAN             is_name;
+        tINTEROP_NAME_MATCH match;
+    } lists[] = {
+        { BTIF_STORAGE_KEY_AUTOPAIR_BLACKLIST_ADDR, INTEROP_DISABLE_AUTO_PAIRING, FALSE, 0 },
+        { BTIF_STORAGE_KEY_AUTOPAIR_BLACKLIST_EXACTNAME, INTEROP_DISABLE_AUTO_PAIRING, TRUE, INTEROP_NAME_EXACT },
+        { BTIF_STORAGE_KEY_AUTOPAIR_BLACKLIST_PARTIALNAME, INTEROP_DISABLE_AUTO_PAIRING, TRUE, INTEROP_NAME_SUBSTR },
+        { BTIF_STORAGE_KEY_AUTOPAIR_FIXPIN_KBLIST, INTEROP_KEYBOARD_FIXED_PIN_ZEROS, FALSE, 0 },
+        { BTIF_STORAGE_KEY_AUTOPAIR_DYNAMIC_BLACKLIST_ADDR, INTEROP_DISABLE_AUTO_PAIRING, FALSE, 0 },
+    };
+    static BOOLEAN compiled = FALSE;
+    char value[BTIF_STORAGE_MAX_LINE_SZ];
+    char *token, *saveptr;
+    BD_ADDR bd_addr;
+    UINT8 len;
+    size_t i;
+
+    if (compiled)
+        return;
+    compiled = TRUE;
+
+    for (i = 0; i < ARRAY_SIZE(lists); ++i)
+    {
+        int value_size = sizeof(value);
+        if (!btif_config_get_str("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST,
+                                 lists[i].key, value, &value_size))
+            continue;
+
+        for (token = strtok_r(value, BTIF_AUTO_PAIR_CONF_VALUE_SEPARATOR, &saveptr); token != NULL;
+             token = strtok_r(NULL, BTIF_AUTO_PAIR_CONF_VALUE_SEPARATOR, &saveptr))
+        {
+            if (lists[i].is_name)
+            {
+                interop_add_name(lists[i].feature, token, lists[i].match);
+            }
+            else if ((len = btif_storage_parse_addr_prefix(token, bd_addr)) != 0)
+            {
+                interop_add_addr(lists[i].feature, bd_addr, len);
+            }
+        }
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         btif_storage_load_autopair_device_list
@@ -1775,6 +2228,7 @@ bt_status_t btif_storage_read_hl_apps_cb(char *value, int value_size)
 bt_status_t btif_storage_load_autopair_device_list() {
     // Configuration has already been loaded. No need to reload.
     if (btif_config_exist("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST, NULL)) {
+        btif_storage_compile_autopair_list();
         return BT_STATUS_SUCCESS;
     }
 
@@ -1800,6 +2254,7 @@ bt_status_t btif_storage_load_autopair_device_list() {
     }
 
     config_free(config);
+    btif_storage_compile_autopair_list();
     return BT_STATUS_SUCCESS;
 }
 
@@ -1815,58 +2270,15 @@ bt_status_t btif_storage_load_autopair_device_list() {
 *******************************************************************************/
 BOOLEAN  btif_storage_is_device_autopair_blacklisted(bt_bdaddr_t *remote_bd_addr)
 {
-    char *token;
-    int ret;
-    bdstr_t bdstr;
     char *dev_name_str;
-    uint8_t i = 0;
-    char value[BTIF_STORAGE_MAX_LINE_SZ];
-    int value_size = sizeof(value);
-
-    bd2str(remote_bd_addr, &bdstr);
-
-    /* Consider only  Lower Address Part from BD Address */
-    bdstr[8] = '\0';
 
-    if(btif_config_get_str("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST,
-                BTIF_STORAGE_KEY_AUTOPAIR_BLACKLIST_ADDR, value, &value_size))
-    {
-        if (strcasestr(value,bdstr) != NULL)
-            return TRUE;
-    }
+    if (interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, remote_bd_addr->address))
+        return TRUE;
 
     dev_name_str = BTM_SecReadDevName((remote_bd_addr->address));
 
-    if (dev_name_str != NULL)
-    {
-        value_size = sizeof(value);
-        if(btif_config_get_str("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST,
-                    BTIF_STORAGE_KEY_AUTOPAIR_BLACKLIST_EXACTNAME, value, &value_size))
-        {
-            if (strstr(value,dev_name_str) != NULL)
-                return TRUE;
-        }
-        value_size = sizeof(value);
-        if(btif_config_get_str("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST,
-                    BTIF_STORAGE_KEY_AUTOPAIR_BLACKLIST_PARTIALNAME, value, &value_size))
-        {
-            token = strtok(value, BTIF_AUTO_PAIR_CONF_VALUE_SEPARATOR);
-            while (token != NULL)
-            {
-                if (strstr(dev_name_str, token) != NULL)
-                    return TRUE;
-
-                token = strtok(NULL, BTIF_AUTO_PAIR_CONF_VALUE_SEPARATOR);
-            }
-        }
-    }
-    if(btif_config_get_str("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST,
-                BTIF_STORAGE_KEY_AUTOPAIR_DYNAMIC_BLACKLIST_ADDR, value, &value_size))
-    {
-        if (strstr(value,bdstr) != NULL)
-            return TRUE;
-    }
-    return FALSE;
+    return dev_name_str != NULL &&
+           interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, dev_name_str);
 }
 
 /*******************************************************************************
@@ -1906,6 +2318,8 @@ bt_status_t btif_storage_add_device_to_autopair_blacklist(bt_bdaddr_t *remote_bd
     ret = btif_config_set_str("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST,
                         BTIF_STORAGE_KEY_AUTOPAIR_DYNAMIC_BLACKLIST_ADDR, linebuf);
 
+    interop_add_addr(INTEROP_DISABLE_AUTO_PAIRING, remote_bd_addr->address, 3);
+
     return ret ? BT_STATUS_SUCCESS:BT_STATUS_FAIL;
 }
 
@@ -1921,26 +2335,7 @@ bt_status_t btif_storage_add_device_to_autopair_blacklist(bt_bdaddr_t *remote_bd
 *******************************************************************************/
 BOOLEAN btif_storage_is_fixed_pin_zeros_keyboard(bt_bdaddr_t *remote_bd_addr)
 {
-    int ret;
-    bdstr_t bdstr;
-    char *dev_name_str;
-    uint8_t i = 0;
-    char linebuf[BTIF_STORAGE_MAX_LINE_SZ];
-
-    bd2str(remote_bd_addr, &bdstr);
-
-    /*consider on LAP part of BDA string*/
-    bdstr[8] = '\0';
-
-    int line_size = sizeof(linebuf);
-    if(btif_config_get_str("Local", BTIF_STORAGE_PATH_AUTOPAIR_BLACKLIST,
-                            BTIF_STORAGE_KEY_AUTOPAIR_FIXPIN_KBLIST, linebuf, &line_size))
-    {
-        if (strcasestr(linebuf,bdstr) != NULL)
-            return TRUE;
-    }
-    return FALSE;
-
+    return interop_match_addr(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, remote_bd_addr->address);
 }
 
 static const char *wii_names[4] = {
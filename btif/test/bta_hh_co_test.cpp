@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/uhid.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_hh_co.h"
+#include "btif_hh.h"
+
+btif_hh_cb_t btif_hh_cb;
+
+extern void bta_hh_co_destroy(int fd);
+}
+
+#define NUM_DEVS 3
+
+// A SET_REPORT the reactor thread asked for: the device handle, the report
+// type and the first report byte.
+struct set_report_t {
+  UINT8 dev_handle;
+  bthh_report_type_t r_type;
+  UINT8 value;
+};
+
+static pthread_mutex_t reports_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reports_cond = PTHREAD_COND_INITIALIZER;
+static std::vector<set_report_t> reports;
+
+extern "C" {
+btif_hh_device_t *btif_hh_find_connected_dev_by_handle(UINT8 handle) {
+  for (int i = 0; i < BTIF_HH_MAX_HID; ++i)
+    if (btif_hh_cb.devices[i].dev_status == BTHH_CONN_STATE_CONNECTED &&
+        btif_hh_cb.devices[i].dev_handle == handle)
+      return &btif_hh_cb.devices[i];
+  return NULL;
+}
+
+void btif_hh_setreport(btif_hh_device_t *p_dev, bthh_report_type_t r_type, UINT16 size,
+                       UINT8 *report) {
+  set_report_t r = { p_dev->dev_handle, r_type, size ? report[0] : (UINT8)0 };
+
+  pthread_mutex_lock(&reports_lock);
+  reports.push_back(r);
+  pthread_cond_broadcast(&reports_cond);
+  pthread_mutex_unlock(&reports_lock);
+}
+}
+
+// Each device's uhid fd is one end of a socketpair; the test plays the kernel
+// on the other end.
+class UhidReactorTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&btif_hh_cb, 0, sizeof(btif_hh_cb));
+      for (int i = 0; i < BTIF_HH_MAX_HID; ++i)
+        btif_hh_cb.devices[i].fd = -1;
+      for (int i = 0; i < NUM_DEVS; ++i)
+        kernel[i] = -1;
+      pthread_mutex_lock(&reports_lock);
+      reports.clear();
+      pthread_mutex_unlock(&reports_lock);
+    }
+
+    virtual void TearDown() {
+      for (int i = 0; i < NUM_DEVS; ++i) {
+        if (btif_hh_cb.devices[i].fd >= 0)
+          bta_hh_co_destroy(btif_hh_cb.devices[i].fd);
+        if (kernel[i] >= 0)
+          close(kernel[i]);
+      }
+    }
+
+    // Connects device |i| as a reconnection, so bta_hh_co_open takes the fd
+    // already set up instead of opening /dev/uhid.
+    void open_dev(int i) {
+      btif_hh_device_t *p_dev = &btif_hh_cb.devices[i];
+      int sv[2];
+
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+      p_dev->fd = sv[0];
+      kernel[i] = sv[1];
+      p_dev->dev_status = BTHH_CONN_STATE_CONNECTED;
+      p_dev->dev_handle = (UINT8)(i + 1);
+      bta_hh_co_open(p_dev->dev_handle, 0, 0, 0);
+    }
+
+    void send_output(int i, UINT8 rtype, UINT8 value) {
+      struct uhid_event ev;
+
+      memset(&ev, 0, sizeof(ev));
+      ev.type = UHID_OUTPUT;
+      ev.u.output.rtype = rtype;
+      ev.u.output.size = 1;
+      ev.u.output.data[0] = value;
+      ASSERT_EQ((ssize_t)sizeof(ev), write(kernel[i], &ev, sizeof(ev)));
+    }
+
+    // Waits up to a second for |count| reports in total.
+    bool wait_reports(size_t count) {
+      struct timespec deadline;
+      bool done;
+
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += 1;
+      pthread_mutex_lock(&reports_lock);
+      while (reports.size() < count &&
+             pthread_cond_timedwait(&reports_cond, &reports_lock, &deadline) != ETIMEDOUT)
+        ;
+      done = reports.size() >= count;
+      pthread_mutex_unlock(&reports_lock);
+      return done;
+    }
+
+    size_t reports_for(UINT8 dev_handle) {
+      size_t count = 0;
+
+      pthread_mutex_lock(&reports_lock);
+      for (size_t n = 0; n < reports.size(); ++n)
+        if (reports[n].dev_handle == dev_handle)
+          ++count;
+      pthread_mutex_unlock(&reports_lock);
+      return count;
+    }
+
+    // Waits up to a second for the reactor to drop device |i|.
+    bool wait_unregistered(int i) {
+      for (int n = 0; n < 1000; ++n) {
+        if (!btif_hh_cb.devices[i].hh_keep_polling)
+          return true;
+        usleep(1000);
+      }
+      return false;
+    }
+
+    int kernel[NUM_DEVS];
+};
+
+TEST_F(UhidReactorTest, test_open_registers_every_device) {
+  for (int i = 0; i < NUM_DEVS; ++i) {
+    open_dev(i);
+    EXPECT_EQ(1, btif_hh_cb.devices[i].hh_keep_polling);
+    EXPECT_TRUE(fcntl(btif_hh_cb.devices[i].fd, F_GETFL) & O_NONBLOCK);
+  }
+
+  for (int n = 0; n < 10; ++n)
+    for (int i = 0; i < NUM_DEVS; ++i)
+      send_output(i, UHID_OUTPUT_REPORT, (UINT8)n);
+  ASSERT_TRUE(wait_reports(10 * NUM_DEVS));
+
+  for (int i = 0; i < NUM_DEVS; ++i)
+    EXPECT_EQ(10u, reports_for((UINT8)(i + 1)));
+}
+
+TEST_F(UhidReactorTest, test_output_report_types) {
+  open_dev(0);
+  send_output(0, UHID_FEATURE_REPORT, 1);
+  send_output(0, UHID_OUTPUT_REPORT, 2);
+  send_output(0, UHID_INPUT_REPORT, 3);
+  ASSERT_TRUE(wait_reports(3));
+
+  // One device's events are handled in order.
+  EXPECT_EQ(BTHH_FEATURE_REPORT, reports[0].r_type);
+  EXPECT_EQ(1, reports[0].value);
+  EXPECT_EQ(BTHH_OUTPUT_REPORT, reports[1].r_type);
+  EXPECT_EQ(2, reports[1].value);
+  EXPECT_EQ(BTHH_INPUT_REPORT, reports[2].r_type);
+  EXPECT_EQ(3, reports[2].value);
+}
+
+TEST_F(UhidReactorTest, test_hang_up_unregisters_only_that_device) {
+  open_dev(0);
+  open_dev(1);
+
+  close(kernel[0]);
+  kernel[0] = -1;
+  ASSERT_TRUE(wait_unregistered(0));
+
+  // The other device is still serviced.
+  EXPECT_EQ(1, btif_hh_cb.devices[1].hh_keep_polling);
+  send_output(1, UHID_OUTPUT_REPORT, 7);
+  ASSERT_TRUE(wait_reports(1));
+  EXPECT_EQ(0u, reports_for(1));
+  EXPECT_EQ(1u, reports_for(2));
+}
+
+TEST_F(UhidReactorTest, test_close_unregisters_and_reopen_registers_again) {
+  open_dev(0);
+
+  bta_hh_co_close(btif_hh_cb.devices[0].dev_handle, 0);
+  EXPECT_EQ(0, btif_hh_cb.devices[0].hh_keep_polling);
+
+  // Nothing is read from the fd while it is unregistered.
+  send_output(0, UHID_OUTPUT_REPORT, 1);
+  EXPECT_FALSE(wait_reports(1));
+
+  // Reconnecting picks up the event left waiting.
+  bta_hh_co_open(btif_hh_cb.devices[0].dev_handle, 0, 0, 0);
+  EXPECT_EQ(1, btif_hh_cb.devices[0].hh_keep_polling);
+  ASSERT_TRUE(wait_reports(1));
+  EXPECT_EQ(1, reports[0].value);
+}
+
+TEST_F(UhidReactorTest, test_destroy_unregisters_and_closes) {
+  struct uhid_event ev;
+
+  open_dev(0);
+  bta_hh_co_destroy(btif_hh_cb.devices[0].fd);
+  EXPECT_EQ(0, btif_hh_cb.devices[0].hh_keep_polling);
+  btif_hh_cb.devices[0].fd = -1;
+
+  ASSERT_EQ((ssize_t)sizeof(ev), read(kernel[0], &ev, sizeof(ev)));
+  EXPECT_EQ(UHID_DESTROY, ev.type);
+  EXPECT_EQ(0, read(kernel[0], &ev, sizeof(ev)));
+}
+
+TEST_F(UhidReactorTest, test_input_report_is_written_to_uhid) {
+  struct uhid_event ev;
+  UINT8 rpt[3] = { 1, 2, 3 };
+  BD_ADDR addr = { 0 };
+
+  open_dev(0);
+  bta_hh_co_data(btif_hh_cb.devices[0].dev_handle, rpt, sizeof(rpt), 0, 0, 0, addr, 0);
+
+  ASSERT_EQ((ssize_t)sizeof(ev), read(kernel[0], &ev, sizeof(ev)));
+  EXPECT_EQ(UHID_INPUT, ev.type);
+  ASSERT_EQ(sizeof(rpt), ev.u.input.size);
+  EXPECT_EQ(0, memcmp(rpt, ev.u.input.data, sizeof(rpt)));
+}
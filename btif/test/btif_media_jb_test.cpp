@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btif_media_jb.h"
+#include "gki.h"
+}
+
+#define RATE 32000
+#define CHANNELS 2
+#define FRAME_SAMPLES 128
+#define TICK_MS 20
+#define TICK_SAMPLES (RATE * TICK_MS / 1000)
+#define PKT_FRAMES 5
+#define PKT_OFFSET 4
+
+// Every decoded frame carries this level, so concealed frames can be told
+// apart by their fade.
+#define LEVEL 8192
+
+// A packet of a replayed trace: when it arrives and its sequence number. The
+// RTP time stamp follows from the sequence number and frame |k| of packet
+// |seq| is frame number seq * PKT_FRAMES + k.
+struct trace_pkt_t {
+  UINT32 arrival_ms;
+  UINT16 seq;
+};
+
+// The number of every frame the engine decoded, in order.
+static std::vector<UINT8> decoded;
+
+extern "C" {
+// One frame is one byte holding the frame number.
+static UINT32 fake_decode(const UINT8 **pp_data, UINT32 *p_len, INT16 *p_pcm,
+                          UINT32 pcm_bytes) {
+  UINT32 bytes = FRAME_SAMPLES * CHANNELS * sizeof(INT16);
+
+  if (*p_len == 0 || pcm_bytes < bytes)
+    return 0;
+  decoded.push_back(**pp_data);
+  ++*pp_data;
+  --*p_len;
+  for (int i = 0; i < FRAME_SAMPLES * CHANNELS; ++i)
+    p_pcm[i] = LEVEL;
+  return bytes;
+}
+}
+
+class JitterBufferTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      decoded.clear();
+      out.clear();
+      silent_ticks = 0;
+      next_pkt = 0;
+      memset(&jb, 0, sizeof(jb));
+      btif_media_jb_init(&jb, fake_decode, RATE, CHANNELS, FRAME_SAMPLES, TICK_MS);
+      now_ms = 0;
+    }
+
+    virtual void TearDown() {
+      btif_media_jb_flush(&jb);
+    }
+
+    tBT_SBC_HDR *media_pkt(UINT16 seq) {
+      tBT_SBC_HDR *p_pkt = (tBT_SBC_HDR *)GKI_getbuf(sizeof(tBT_SBC_HDR) + PKT_OFFSET + 1 +
+                                                     PKT_FRAMES);
+      UINT8 *p = (UINT8 *)(p_pkt + 1) + PKT_OFFSET;
+
+      p_pkt->offset = PKT_OFFSET;
+      p_pkt->len = 1 + PKT_FRAMES;
+      p_pkt->layer_specific = seq;
+      p_pkt->num_frames_to_be_processed = PKT_FRAMES;
+      BTIF_MEDIA_JB_PKT_TS(p_pkt) = (UINT32)seq * PKT_FRAMES * FRAME_SAMPLES;
+      *p++ = PKT_FRAMES;
+      for (int k = 0; k < PKT_FRAMES; ++k)
+        *p++ = (UINT8)(seq * PKT_FRAMES + k);
+      return p_pkt;
+    }
+
+    // Plays the trace as the media task would: every tick, the packets that
+    // have arrived by then are queued and one tick is rendered. The trace
+    // must be in arrival order; a later call carries on where this one left.
+    void replay(const std::vector<trace_pkt_t> &trace, int ticks) {
+      INT16 pcm[TICK_SAMPLES * CHANNELS];
+
+      for (int t = 0; t < ticks; ++t, now_ms += TICK_MS) {
+        while (next_pkt < trace.size() && trace[next_pkt].arrival_ms <= now_ms) {
+          btif_media_jb_put(&jb, media_pkt(trace[next_pkt].seq),
+                            (UINT64)trace[next_pkt].arrival_ms * 1000);
+          ++next_pkt;
+        }
+
+        UINT8 state = jb.state;
+        UINT32 bytes = btif_media_jb_render(&jb, pcm);
+        if (bytes == 0)
+          continue;
+        ASSERT_EQ(sizeof(pcm), bytes);
+        if (state != BTIF_MEDIA_JB_PLAYING && jb.state != BTIF_MEDIA_JB_PLAYING)
+          ++silent_ticks;
+        out.insert(out.end(), pcm, pcm + TICK_SAMPLES * CHANNELS);
+      }
+    }
+
+    // A packet every tick from |first| on, starting at |start_ms|.
+    std::vector<trace_pkt_t> steady(UINT32 start_ms, UINT16 first, UINT16 count) {
+      std::vector<trace_pkt_t> trace;
+
+      for (UINT16 i = 0; i < count; ++i) {
+        trace_pkt_t pkt = { start_ms + i * TICK_MS, (UINT16)(first + i) };
+        trace.push_back(pkt);
+      }
+      return trace;
+    }
+
+    // Checks at least |count| frames were decoded, and that they are the
+    // frames from |first| on in order, less |missing|.
+    void expect_decoded(int first, size_t count, const std::vector<int> &missing) {
+      std::vector<UINT8> expected;
+
+      ASSERT_LE(count, decoded.size());
+      for (int n = first; expected.size() < decoded.size(); ++n)
+        if (std::find(missing.begin(), missing.end(), n) == missing.end())
+          expected.push_back((UINT8)n);
+      EXPECT_EQ(expected, decoded);
+    }
+
+    // The number of output samples at |level|.
+    size_t samples_at(INT16 level) {
+      return std::count(out.begin(), out.end(), level);
+    }
+
+    tBTIF_MEDIA_JB jb;
+    std::vector<INT16> out;
+    int silent_ticks;
+    size_t next_pkt;
+    UINT32 now_ms;
+};
+
+TEST_F(JitterBufferTest, test_steady_stream_plays_every_frame) {
+  std::vector<trace_pkt_t> trace = steady(0, 0, 20);
+
+  replay(trace, 18);
+
+  // Playback starts with the second packet, which makes up the minimum delay.
+  EXPECT_EQ(BTIF_MEDIA_JB_PLAYING, jb.state);
+  expect_decoded(0, 17 * PKT_FRAMES, std::vector<int>());
+  EXPECT_EQ(18u, jb.stats.pkts);
+  EXPECT_EQ(0u, jb.stats.lost_frames);
+  EXPECT_EQ(0u, jb.stats.underrun_frames);
+  EXPECT_EQ(0u, jb.stats.late);
+  EXPECT_EQ(0, silent_ticks);
+  EXPECT_EQ(out.size(), samples_at(LEVEL));
+}
+
+TEST_F(JitterBufferTest, test_reordered_packets_play_in_order) {
+  std::vector<trace_pkt_t> trace = steady(0, 0, 20);
+
+  // Packet 6 overtakes packet 5, just in time for it to be played.
+  trace[5].arrival_ms -= 1;
+  trace[5].seq = 6;
+  trace[6].arrival_ms -= TICK_MS;
+  trace[6].seq = 5;
+
+  replay(trace, 18);
+
+  expect_decoded(0, 17 * PKT_FRAMES, std::vector<int>());
+  EXPECT_EQ(1u, jb.stats.reordered);
+  EXPECT_EQ(0u, jb.stats.lost_frames);
+  EXPECT_EQ(0u, jb.stats.late);
+  EXPECT_EQ(out.size(), samples_at(LEVEL));
+}
+
+TEST_F(JitterBufferTest, test_duplicates_are_dropped) {
+  std::vector<trace_pkt_t> trace = steady(0, 0, 20);
+  trace_pkt_t dup_queued = { 103, 6 };
+  trace_pkt_t dup_last = { 104, 7 };
+
+  // Packets 6 and 7 come early, then each is seen again: packet 6 while it
+  // is queued behind packet 7, packet 7 as the last one received.
+  trace[6].arrival_ms = 101;
+  trace[7].arrival_ms = 102;
+  trace.insert(trace.begin() + 8, dup_queued);
+  trace.insert(trace.begin() + 9, dup_last);
+
+  replay(trace, 18);
+
+  expect_decoded(0, 17 * PKT_FRAMES, std::vector<int>());
+  EXPECT_EQ(2u, jb.stats.dups);
+  EXPECT_EQ(0u, jb.stats.lost_frames);
+  EXPECT_EQ(out.size(), samples_at(LEVEL));
+}
+
+TEST_F(JitterBufferTest, test_lost_packet_is_concealed) {
+  std::vector<trace_pkt_t> trace = steady(0, 0, 20);
+  std::vector<int> missing;
+
+  // Packet 6 never arrives; packet 7 is already queued when the gap is
+  // reached.
+  trace.erase(trace.begin() + 6);
+  trace[6].arrival_ms -= TICK_MS;
+  for (int k = 0; k < PKT_FRAMES; ++k)
+    missing.push_back(6 * PKT_FRAMES + k);
+
+  replay(trace, 18);
+
+  expect_decoded(0, 16 * PKT_FRAMES, missing);
+  EXPECT_EQ((UINT32)PKT_FRAMES, jb.stats.lost_frames);
+  EXPECT_EQ(0u, jb.stats.underrun_frames);
+  EXPECT_EQ(BTIF_MEDIA_JB_PLAYING, jb.state);
+
+  // The last frame is repeated, fading by a quarter every frame; then the
+  // stream picks up again at full level.
+  UINT32 gain = 0x7FFF;
+  for (int k = 0; k < PKT_FRAMES; ++k, gain = (gain * 3) >> 2) {
+    INT16 faded = (INT16)((LEVEL * (INT32)gain) >> 15);
+    EXPECT_LE((size_t)(FRAME_SAMPLES - 1) * CHANNELS, samples_at(faded)) << "frame " << k;
+  }
+  EXPECT_LT(out.size() - 2 * PKT_FRAMES * FRAME_SAMPLES * CHANNELS, samples_at(LEVEL));
+}
+
+TEST_F(JitterBufferTest, test_underrun_goes_back_to_prebuffering) {
+  std::vector<trace_pkt_t> trace = steady(0, 0, 10);
+  std::vector<trace_pkt_t> resumed = steady(400, 10, 40);
+
+  // The source stops for a while, then carries on.
+  trace.insert(trace.end(), resumed.begin(), resumed.end());
+  replay(trace, 20);
+
+  // Concealment covers the first frames of the underrun only; the engine
+  // then prebuffers again and plays silence meanwhile.
+  EXPECT_EQ(BTIF_MEDIA_JB_PREBUFFER, jb.state);
+  EXPECT_EQ((UINT32)BTIF_MEDIA_JB_PLC_MAX_FRAMES, jb.stats.underrun_frames);
+  EXPECT_EQ(1u, jb.stats.rebuffers);
+  EXPECT_LT(0, silent_ticks);
+  EXPECT_LE((size_t)silent_ticks * TICK_SAMPLES * CHANNELS, samples_at(0));
+  expect_decoded(0, 10 * PKT_FRAMES, std::vector<int>());
+  EXPECT_EQ((size_t)(10 * PKT_FRAMES), decoded.size());
+
+  // Playback resumes from the first packet after the gap, with a higher
+  // target to ride out the next one.
+  replay(trace, 40);
+  EXPECT_EQ(BTIF_MEDIA_JB_PLAYING, jb.state);
+  EXPECT_LT((UINT32)(RATE * BTIF_MEDIA_JB_MIN_MS / 1000), jb.target);
+  expect_decoded(0, 11 * PKT_FRAMES, std::vector<int>());
+  EXPECT_EQ((UINT32)BTIF_MEDIA_JB_PLC_MAX_FRAMES, jb.stats.underrun_frames);
+  EXPECT_EQ(1u, jb.stats.rebuffers);
+}
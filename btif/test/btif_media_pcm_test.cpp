@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btif_media_pcm.h"
+}
+
+// Frames per block the media task hands over: 16 blocks of 8 subbands.
+#define BLOCK_FRAMES 128
+
+struct pcm_fmt_t {
+  UINT8 fmt;
+  UINT8 size;
+  const char *name;
+};
+
+static const pcm_fmt_t formats[] = {
+  { BTIF_MEDIA_PCM_FMT_U8, 1, "u8" },
+  { BTIF_MEDIA_PCM_FMT_S16, 2, "s16" },
+  { BTIF_MEDIA_PCM_FMT_S24, 3, "s24" },
+  { BTIF_MEDIA_PCM_FMT_S32, 4, "s32" },
+  { BTIF_MEDIA_PCM_FMT_FLOAT, 4, "float" },
+};
+
+static double clamp(double x, double lo, double hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+// Stores x (full scale +/-1.0) as a sample of the format and returns the value
+// the stage should see in it, in double precision.
+static double encode(UINT8 fmt, UINT8 *p, double x) {
+  switch (fmt) {
+    case BTIF_MEDIA_PCM_FMT_U8: {
+      int v = (int)clamp(floor(x * 128 + 0.5) + 128, 0, 255);
+      *p = (UINT8)v;
+      return (v - 128) / 128.0;
+    }
+    case BTIF_MEDIA_PCM_FMT_S16: {
+      INT16 v = (INT16)clamp(floor(x * 32768 + 0.5), -32768, 32767);
+      memcpy(p, &v, sizeof(v));
+      return v / 32768.0;
+    }
+    case BTIF_MEDIA_PCM_FMT_S24: {
+      INT32 v = (INT32)clamp(floor(x * 8388608 + 0.5), -8388608, 8388607);
+      p[0] = (UINT8)v;
+      p[1] = (UINT8)(v >> 8);
+      p[2] = (UINT8)(v >> 16);
+      return v / 8388608.0;
+    }
+    case BTIF_MEDIA_PCM_FMT_S32: {
+      INT32 v = (INT32)clamp(floor(x * 2147483648.0 + 0.5), -2147483648.0, 2147483647.0);
+      memcpy(p, &v, sizeof(v));
+      return v / 2147483648.0;
+    }
+    default: {
+      // Out of range values are clipped at 20 bit full scale.
+      float f = (float)x;
+      memcpy(p, &f, sizeof(f));
+      return clamp(f, -1.0, 1.0 - 1.0 / 524288);
+    }
+  }
+}
+
+// A block in a buffer aligned for any format and large enough for the source
+// and the converted samples, and the source values in double precision.
+struct block_t {
+  std::vector<UINT32> buf;
+  std::vector<double> ref;
+};
+
+static block_t make_block(const pcm_fmt_t &f, UINT8 channels, UINT32 frames, UINT32 seed) {
+  UINT32 samples = frames * channels;
+  UINT32 bytes = samples * f.size;
+  block_t b;
+
+  if (bytes < frames * 2 * sizeof(INT16))
+    bytes = frames * 2 * sizeof(INT16);
+  b.buf.resize((bytes + 3) / 4);
+  for (UINT32 i = 0; i < samples; ++i) {
+    // Slightly beyond full scale, so the rails are hit as well.
+    seed = seed * 1664525u + 1013904223u;
+    double x = ((seed >> 8) / 16777216.0) * 2.2 - 1.1;
+    b.ref.push_back(encode(f.fmt, (UINT8 *)&b.buf[0] + i * f.size, x));
+  }
+  return b;
+}
+
+// The largest difference from the exact result the stage may make: the +/-1
+// LSB dither and rounding, plus for the wide formats the gain taken as Q11,
+// off by up to 15/32768 of full scale.
+static double tolerance(UINT8 fmt, double x) {
+  if (fmt == BTIF_MEDIA_PCM_FMT_U8 || fmt == BTIF_MEDIA_PCM_FMT_S16)
+    return 1.5;
+  return 1.6 + 15 * fabs(x);
+}
+
+static double expected(double x, double gain) {
+  return clamp(x * gain, -32768, 32767);
+}
+
+class PcmStageTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      btif_media_pcm_init(&pcm);
+    }
+
+    // Converts a block from |in_ch| to |out_ch| channels at a steady gain and
+    // checks every output sample against the double precision result.
+    void check_block(const pcm_fmt_t &f, UINT8 in_ch, UINT8 out_ch, UINT32 frames, UINT16 gain) {
+      block_t b = make_block(f, in_ch, frames, frames * 7 + f.fmt);
+      INT16 *p_out = (INT16 *)&b.buf[0];
+
+      btif_media_pcm_config(&pcm, f.fmt, in_ch);
+      settle_gain(gain);
+      UINT32 bytes = btif_media_pcm_process(&pcm, &b.buf[0], frames, out_ch);
+      ASSERT_EQ(frames * out_ch * sizeof(INT16), bytes) << f.name;
+
+      for (UINT32 n = 0; n < frames; ++n) {
+        if (in_ch == out_ch) {
+          for (UINT8 c = 0; c < in_ch; ++c) {
+            double x = b.ref[n * in_ch + c];
+            ASSERT_NEAR(expected(x, gain), p_out[n * in_ch + c], tolerance(f.fmt, x))
+                << f.name << " frame " << n;
+          }
+        } else if (out_ch == 2) {
+          double x = b.ref[n];
+          ASSERT_NEAR(expected(x, gain), p_out[2 * n], tolerance(f.fmt, x))
+              << f.name << " frame " << n;
+          ASSERT_EQ(p_out[2 * n], p_out[2 * n + 1]) << f.name << " frame " << n;
+        } else {
+          // The average of the two requantized samples, rounded down.
+          double l = b.ref[2 * n], r = b.ref[2 * n + 1];
+          double mix = (expected(l, gain) + expected(r, gain)) / 2;
+          ASSERT_NEAR(mix, p_out[n], (tolerance(f.fmt, l) + tolerance(f.fmt, r)) / 2 + 0.5)
+              << f.name << " frame " << n;
+        }
+      }
+    }
+
+    // Sets the gain and runs out the ramp to it.
+    void settle_gain(UINT16 gain) {
+      std::vector<INT16> scratch(BTIF_MEDIA_PCM_RAMP_FRAMES * 2 * 2);
+      UINT8 fmt = pcm.fmt;
+      UINT8 channels = pcm.channels;
+
+      btif_media_pcm_set_gain(&pcm, gain);
+      btif_media_pcm_config(&pcm, BTIF_MEDIA_PCM_FMT_S16, 2);
+      btif_media_pcm_process(&pcm, &scratch[0], BTIF_MEDIA_PCM_RAMP_FRAMES, 2);
+      btif_media_pcm_config(&pcm, fmt, channels);
+    }
+
+    tBTIF_MEDIA_PCM pcm;
+};
+
+TEST_F(PcmStageTest, test_unity_gain_is_exact_for_16_bits) {
+  block_t b = make_block(formats[1], 2, 131, 1);
+  std::vector<UINT32> src = b.buf;
+
+  EXPECT_EQ(131u * 4, btif_media_pcm_process(&pcm, &b.buf[0], 131, 2));
+  EXPECT_EQ(src, b.buf);
+
+  // 8 bit samples widen exactly.
+  b = make_block(formats[0], 2, 131, 2);
+  btif_media_pcm_config(&pcm, BTIF_MEDIA_PCM_FMT_U8, 2);
+  btif_media_pcm_process(&pcm, &b.buf[0], 131, 2);
+  for (size_t i = 0; i < b.ref.size(); ++i)
+    ASSERT_EQ(b.ref[i] * 32768, ((INT16 *)&b.buf[0])[i]) << i;
+}
+
+// Sizes that are a whole number of groups, and ones that leave a tail.
+static const UINT32 block_sizes[] = { 1, 7, 8, BLOCK_FRAMES, BLOCK_FRAMES + 3 };
+
+TEST_F(PcmStageTest, test_stereo_matches_reference) {
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    for (size_t s = 0; s < sizeof(block_sizes) / sizeof(block_sizes[0]); ++s) {
+      check_block(formats[f], 2, 2, block_sizes[s], BTIF_MEDIA_PCM_UNITY_GAIN);
+      check_block(formats[f], 2, 2, block_sizes[s], btif_media_pcm_volume_to_gain(100));
+    }
+}
+
+TEST_F(PcmStageTest, test_mono_to_stereo_matches_reference) {
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    for (size_t s = 0; s < sizeof(block_sizes) / sizeof(block_sizes[0]); ++s) {
+      check_block(formats[f], 1, 2, block_sizes[s], BTIF_MEDIA_PCM_UNITY_GAIN);
+      check_block(formats[f], 1, 2, block_sizes[s], btif_media_pcm_volume_to_gain(100));
+    }
+}
+
+TEST_F(PcmStageTest, test_stereo_to_mono_matches_reference) {
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    for (size_t s = 0; s < sizeof(block_sizes) / sizeof(block_sizes[0]); ++s) {
+      check_block(formats[f], 2, 1, block_sizes[s], BTIF_MEDIA_PCM_UNITY_GAIN);
+      check_block(formats[f], 2, 1, block_sizes[s], btif_media_pcm_volume_to_gain(100));
+    }
+}
+
+TEST_F(PcmStageTest, test_mono_passes_through) {
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    check_block(formats[f], 1, 1, BLOCK_FRAMES + 3, btif_media_pcm_volume_to_gain(64));
+}
+
+TEST_F(PcmStageTest, test_gain_ramps_linearly) {
+  UINT16 to = btif_media_pcm_volume_to_gain(40);
+  UINT32 frames = BTIF_MEDIA_PCM_RAMP_FRAMES + 64;
+
+  btif_media_pcm_config(&pcm, BTIF_MEDIA_PCM_FMT_S24, 2);
+  btif_media_pcm_set_gain(&pcm, to);
+
+  // Spread over blocks that do not line up with the ramp.
+  block_t b = make_block(formats[2], 2, frames, 3);
+  for (UINT32 done = 0; done < frames; done += 100) {
+    UINT32 n = frames - done < 100 ? frames - done : 100;
+    btif_media_pcm_process(&pcm, (UINT8 *)&b.buf[0] + done * 2 * 3, n, 2);
+
+    const INT16 *p_out = (const INT16 *)((UINT8 *)&b.buf[0] + done * 2 * 3);
+    for (UINT32 k = 0; k < n * 2; ++k) {
+      UINT32 frame = done + k / 2;
+      double ramp = frame < BTIF_MEDIA_PCM_RAMP_FRAMES ?
+                    (double)frame / BTIF_MEDIA_PCM_RAMP_FRAMES : 1.0;
+      double gain = BTIF_MEDIA_PCM_UNITY_GAIN + (to - (double)BTIF_MEDIA_PCM_UNITY_GAIN) * ramp;
+      double x = b.ref[frame * 2 + k % 2];
+      ASSERT_NEAR(expected(x, gain), p_out[k], tolerance(BTIF_MEDIA_PCM_FMT_S24, x) + 1)
+          << "frame " << frame;
+    }
+  }
+  EXPECT_EQ(0, pcm.ramp_left);
+  EXPECT_EQ((INT32)to << 15, pcm.gain);
+}
+
+static UINT64 cpu_time_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (UINT64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// CPU time to process one block for every format and channel path, at unity
+// and at a reduced gain. The copy that restores the source before each run is
+// timed on its own and taken off. Times are printed rather than asserted
+// since they vary between devices.
+TEST_F(PcmStageTest, test_benchmark_per_block) {
+  static const int ITERATIONS = 2000;
+  static const UINT8 paths[][2] = { { 2, 2 }, { 1, 2 }, { 2, 1 } };
+
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); ++p)
+      for (int g = 0; g < 2; ++g) {
+        UINT16 gain = g ? btif_media_pcm_volume_to_gain(100) : BTIF_MEDIA_PCM_UNITY_GAIN;
+        block_t b = make_block(formats[f], paths[p][0], BLOCK_FRAMES, 5);
+        std::vector<UINT32> work(b.buf.size());
+        size_t bytes = b.buf.size() * sizeof(UINT32);
+
+        btif_media_pcm_config(&pcm, formats[f].fmt, paths[p][0]);
+        settle_gain(gain);
+
+        UINT64 start = cpu_time_ns();
+        for (int i = 0; i < ITERATIONS; ++i)
+          memcpy(&work[0], &b.buf[0], bytes);
+        UINT64 copy_ns = cpu_time_ns() - start;
+
+        start = cpu_time_ns();
+        for (int i = 0; i < ITERATIONS; ++i) {
+          memcpy(&work[0], &b.buf[0], bytes);
+          btif_media_pcm_process(&pcm, &work[0], BLOCK_FRAMES, paths[p][1]);
+        }
+        UINT64 total_ns = cpu_time_ns() - start;
+
+        printf("%-5s %u->%u ch, %s gain: %llu ns per block of %d frames\n", formats[f].name,
+               paths[p][0], paths[p][1], g ? "reduced" : "unity",
+               (unsigned long long)((total_ns > copy_ns ? total_ns - copy_ns : 0) / ITERATIONS),
+               BLOCK_FRAMES);
+      }
+}
@@ -0,0 +1,316 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <deque>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_api.h"
+#include "btif_pan_internal.h"
+#include "btif_sock_thread.h"
+#include "gki.h"
+#include "pan_api.h"
+}
+
+#define PAN_HANDLE 1
+#define ETH_HDR_LEN 14
+
+static const BD_ADDR peer = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const BD_ADDR local = { 0x00, 0xaa, 0xbb, 0xcc, 0xdd, 0xee };
+
+// A frame handed to PAN, and the headroom left in front of it for BNEP.
+struct pan_frame_t {
+  UINT16 handle;
+  BD_ADDR dst;
+  BD_ADDR src;
+  UINT16 protocol;
+  UINT16 offset;
+  std::vector<UINT8> payload;
+};
+
+static std::vector<pan_frame_t> pan_frames;
+static std::deque<tPAN_RESULT> pan_results;
+
+static btsock_signaled_cb tap_signaled;
+static int tap_arms;
+static std::deque<std::pair<tBTA_DM_EXEC_CBACK *, void *> > btu_q;
+
+extern "C" {
+int btif_is_enabled(void) {
+  return 1;
+}
+
+int btsock_thread_create(btsock_signaled_cb callback, btsock_cmd_cb) {
+  tap_signaled = callback;
+  return 0;
+}
+
+int btsock_thread_add_fd(int, int, int, int flags, uint32_t) {
+  if (flags & SOCK_THREAD_FD_RD)
+    ++tap_arms;
+  return TRUE;
+}
+
+void bta_dmexecutecallback(tBTA_DM_EXEC_CBACK *p_callback, void *p_param) {
+  btu_q.push_back(std::make_pair(p_callback, p_param));
+}
+
+// Records the frame; like PAN, keeps the buffer only on PAN_Q_SIZE_EXCEEDED.
+tPAN_RESULT PAN_WriteBuf(UINT16 handle, BD_ADDR dst, BD_ADDR src, UINT16 protocol, BT_HDR *p_buf,
+                         BOOLEAN) {
+  pan_frame_t frame;
+  UINT8 *p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+  tPAN_RESULT result = PAN_SUCCESS;
+
+  if (!pan_results.empty()) {
+    result = pan_results.front();
+    pan_results.pop_front();
+  }
+
+  frame.handle = handle;
+  memcpy(frame.dst, dst, BD_ADDR_LEN);
+  memcpy(frame.src, src, BD_ADDR_LEN);
+  frame.protocol = protocol;
+  frame.offset = p_buf->offset;
+  frame.payload.assign(p, p + p_buf->len);
+  pan_frames.push_back(frame);
+
+  if (result != PAN_Q_SIZE_EXCEEDED)
+    GKI_freebuf(p_buf);
+  return result;
+}
+}
+
+static UINT32 gki_free_bufs(void) {
+  UINT32 count = 0;
+
+  for (UINT8 pool = 0; pool < GKI_NUM_TOTAL_BUF_POOLS; ++pool)
+    count += GKI_poolfreecount(pool);
+  return count;
+}
+
+// The payload byte |i| of frame |n|, so reordered or mixed frames show up.
+static UINT8 payload_byte(int n, size_t i) {
+  return (UINT8)(n * 31 + i);
+}
+
+class BtifPanTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds));
+      fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+
+      memset(&btpan_cb, 0, sizeof(btpan_cb));
+      for (int i = 0; i < MAX_PAN_CONNS; ++i)
+        btpan_cb.conns[i].handle = -1;
+      btpan_cb.conns[0].handle = PAN_HANDLE;
+      memcpy(btpan_cb.conns[0].peer, peer, BD_ADDR_LEN);
+      btpan_cb.tap_fd = fds[0];
+      btpan_cb.flow = 1;
+      GKI_init_q(&btpan_cb.rx_q);
+
+      create_tap_read_thread(fds[0]);
+      ASSERT_TRUE(tap_signaled != NULL);
+
+      pan_frames.clear();
+      pan_results.clear();
+      btu_q.clear();
+      tap_arms = 0;
+      free_bufs = gki_free_bufs();
+    }
+
+    virtual void TearDown() {
+      BT_HDR *p_buf;
+
+      while ((p_buf = (BT_HDR *)GKI_dequeue(&btpan_cb.rx_q)) != NULL)
+        GKI_freebuf(p_buf);
+      EXPECT_EQ(free_bufs, gki_free_bufs());
+      close(fds[0]);
+      if (fds[1] >= 0)
+        close(fds[1]);
+    }
+
+    // Writes frame |n| to the TAP end: an Ethernet header, then |len| bytes.
+    void tap_write(int n, size_t len, UINT16 protocol = 0x0800) {
+      std::vector<UINT8> frame(ETH_HDR_LEN + len);
+      UINT16 proto = htons(protocol);
+
+      memcpy(&frame[0], peer, BD_ADDR_LEN);
+      memcpy(&frame[6], local, BD_ADDR_LEN);
+      memcpy(&frame[12], &proto, 2);
+      for (size_t i = 0; i < len; ++i)
+        frame[ETH_HDR_LEN + i] = payload_byte(n, i);
+      ASSERT_EQ((ssize_t)frame.size(), write(fds[1], &frame[0], frame.size()));
+    }
+
+    // The reader thread wakes up on the TAP fd.
+    void tap_readable() {
+      tap_signaled(fds[0], 0, SOCK_THREAD_FD_RD, 0);
+    }
+
+    // BTU runs what was posted to it.
+    void run_btu() {
+      while (!btu_q.empty()) {
+        std::pair<tBTA_DM_EXEC_CBACK *, void *> cb = btu_q.front();
+        btu_q.pop_front();
+        cb.first(cb.second);
+      }
+    }
+
+    void expect_frame(size_t k, int n, size_t len) {
+      ASSERT_LT(k, pan_frames.size());
+      const pan_frame_t &frame = pan_frames[k];
+      EXPECT_EQ(PAN_HANDLE, frame.handle);
+      EXPECT_EQ(0, memcmp(peer, frame.dst, BD_ADDR_LEN));
+      EXPECT_EQ(0, memcmp(local, frame.src, BD_ADDR_LEN));
+      EXPECT_EQ(0x0800, frame.protocol);
+      EXPECT_EQ(PAN_MINIMUM_OFFSET + ETH_HDR_LEN, frame.offset);
+      ASSERT_EQ(len, frame.payload.size());
+      for (size_t i = 0; i < len; ++i)
+        ASSERT_EQ(payload_byte(n, i), frame.payload[i]);
+    }
+
+    int fds[2];
+    UINT32 free_bufs;
+};
+
+TEST_F(BtifPanTest, test_ready_frames_are_read_in_one_batch) {
+  for (int n = 0; n < 10; ++n)
+    tap_write(n, 60 + n * 100);
+
+  tap_readable();
+
+  // One post to BTU for the whole batch, and the fd is not re-armed yet.
+  EXPECT_EQ(1u, btu_q.size());
+  EXPECT_EQ(10, btpan_cb.rx_q.count);
+  EXPECT_EQ(0, tap_arms);
+  EXPECT_TRUE(pan_frames.empty());
+
+  run_btu();
+  ASSERT_EQ(10u, pan_frames.size());
+  for (int n = 0; n < 10; ++n)
+    expect_frame(n, n, 60 + n * 100);
+  EXPECT_EQ(1, tap_arms);
+  EXPECT_TRUE(GKI_queue_is_empty(&btpan_cb.rx_q));
+}
+
+TEST_F(BtifPanTest, test_batch_is_bounded_by_pan_pool_share) {
+  for (int n = 0; n < PAN_POOL_MAX + 5; ++n)
+    tap_write(n, 100);
+
+  tap_readable();
+  EXPECT_EQ(PAN_POOL_MAX, btpan_cb.rx_q.count);
+  run_btu();
+  EXPECT_EQ((size_t)PAN_POOL_MAX, pan_frames.size());
+  EXPECT_EQ(1, tap_arms);
+
+  tap_readable();
+  run_btu();
+  ASSERT_EQ((size_t)PAN_POOL_MAX + 5, pan_frames.size());
+  for (int n = 0; n < PAN_POOL_MAX + 5; ++n)
+    expect_frame(n, n, 100);
+}
+
+TEST_F(BtifPanTest, test_congestion_holds_frames_until_flow_is_on) {
+  for (int n = 0; n < 10; ++n)
+    tap_write(n, 200);
+  pan_results.assign(3, PAN_SUCCESS);
+  pan_results.push_back(PAN_Q_SIZE_EXCEEDED);
+
+  tap_readable();
+  run_btu();
+
+  // The fourth frame was handed back; it and the rest wait, unread ones too.
+  EXPECT_EQ(4u, pan_frames.size());
+  EXPECT_EQ(7, btpan_cb.rx_q.count);
+  EXPECT_EQ(0, btpan_cb.flow);
+  EXPECT_EQ(0, tap_arms);
+  tap_write(10, 200);
+
+  btpan_set_flow_control(TRUE);
+  EXPECT_EQ(1, tap_arms);
+  run_btu();
+
+  // The frame handed back goes again first, and in one piece.
+  ASSERT_EQ(11u, pan_frames.size());
+  for (int n = 0; n < 4; ++n)
+    expect_frame(n, n, 200);
+  for (int n = 3; n < 10; ++n)
+    expect_frame(n + 1, n, 200);
+
+  tap_readable();
+  run_btu();
+  ASSERT_EQ(12u, pan_frames.size());
+  expect_frame(11, 10, 200);
+}
+
+TEST_F(BtifPanTest, test_runt_and_unknown_frames_are_dropped) {
+  UINT8 runt[ETH_HDR_LEN] = { 0 };
+
+  ASSERT_EQ((ssize_t)sizeof(runt), write(fds[1], runt, sizeof(runt)));
+  tap_write(0, 100, 0x1234);
+  tap_write(1, 100);
+
+  tap_readable();
+  run_btu();
+
+  ASSERT_EQ(1u, pan_frames.size());
+  expect_frame(0, 1, 100);
+}
+
+TEST_F(BtifPanTest, test_end_of_file_stops_reading) {
+  close(fds[1]);
+  fds[1] = -1;
+
+  tap_readable();
+
+  EXPECT_TRUE(btu_q.empty());
+  EXPECT_EQ(0, tap_arms);
+}
+
+TEST_F(BtifPanTest, test_send_writes_header_and_payload_as_one_frame) {
+  UINT8 payload[300];
+  UINT8 frame[ETH_HDR_LEN + sizeof(payload) + 1];
+
+  for (size_t i = 0; i < sizeof(payload); ++i)
+    payload[i] = payload_byte(7, i);
+
+  EXPECT_EQ((int)(ETH_HDR_LEN + sizeof(payload)),
+            btpan_tap_send(fds[0], peer, local, 0x86dd, (const char *)payload, sizeof(payload),
+                           FALSE, FALSE));
+
+  ASSERT_EQ((ssize_t)(ETH_HDR_LEN + sizeof(payload)), read(fds[1], frame, sizeof(frame)));
+  EXPECT_EQ(0, memcmp(local, &frame[0], BD_ADDR_LEN));
+  EXPECT_EQ(0, memcmp(peer, &frame[6], BD_ADDR_LEN));
+  EXPECT_EQ(0x86, frame[12]);
+  EXPECT_EQ(0xdd, frame[13]);
+  EXPECT_EQ(0, memcmp(payload, &frame[ETH_HDR_LEN], sizeof(payload)));
+}
+
+TEST_F(BtifPanTest, test_loopback_throughput) {
+  const int frames = 20000, burst = 32, len = 1500 - ETH_HDR_LEN;
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int n = 0; n < frames; n += burst) {
+    for (int i = 0; i < burst; ++i)
+      tap_write(n + i, len);
+    tap_readable();
+    run_btu();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("TAP to PAN: %d frames of %d bytes in %.0f ms, %.0f Mbit/s\n", frames, len + ETH_HDR_LEN,
+         secs * 1000, frames * (len + ETH_HDR_LEN) * 8 / secs / 1e6);
+
+  ASSERT_EQ((size_t)frames, pan_frames.size());
+  expect_frame(frames - 1, frames - 1, len);
+}
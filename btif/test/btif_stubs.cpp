@@ -0,0 +1,68 @@
+// The GKI OS layer under the real buffer pools, and stubs for the calls of the
+// btif sources under test that the tests do not exercise. Calls the tests
+// drive are faked in the test files.
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "btif_stubs"
+
+#include <hardware/bluetooth.h>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bta_pan_api.h"
+#include "btif_common.h"
+#include "btif_config.h"
+#include "btif_hh.h"
+#include "btif_util.h"
+#include "btm_api.h"
+#include "gki.h"
+#include "gki_int.h"
+
+tGKI_CB gki_cb;
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+UINT8 btif_trace_level = BT_TRACE_LEVEL_NONE;
+
+void gki_buffer_init(void);
+
+void GKI_disable(void) {}
+void GKI_enable(void) {}
+void GKI_exception(UINT16, char *) {}
+UINT8 GKI_get_taskid(void) { return 0; }
+UINT8 GKI_send_event(UINT8, UINT16) { return GKI_SUCCESS; }
+void *GKI_os_malloc(UINT32 size) { return malloc(size); }
+void GKI_os_free(void *p_mem) { free(p_mem); }
+
+void LogMsg(UINT32, const char *, ...) {}
+}
+
+class GkiEnvironment : public ::testing::Environment {
+  public:
+    virtual void SetUp() {
+      gki_buffer_init();
+    }
+};
+
+static ::testing::Environment *const gki_env =
+    ::testing::AddGlobalTestEnvironment(new GkiEnvironment);
+
+extern "C" {
+void BTA_PanClose(UINT16) {}
+void BTA_PanDisable(void) {}
+void BTA_PanEnable(tBTA_PAN_CBACK (*)) {}
+void BTA_PanOpen(UINT8 *, tBTA_PAN_ROLE, tBTA_PAN_ROLE) {}
+void BTA_PanSetRole(tBTA_PAN_ROLE, tBTA_PAN_ROLE_INFO *, tBTA_PAN_ROLE_INFO *, tBTA_PAN_ROLE_INFO *) {}
+void BTM_GetLocalDeviceAddr(UINT8 *) {}
+char *bd2str(const bt_bdaddr_t *, bdstr_t (*)) { return 0; }
+void bdcpy(UINT8 *, const UINT8 *) {}
+int btif_config_get(const char *, const char *, const char *, char *, int *, int *) { return 0; }
+int btif_config_remove(const char *, const char *, const char *) { return 0; }
+int btif_config_set(const char *, const char *, const char *, const char *, int, int) { return 0; }
+bt_status_t btif_transfer_context(tBTIF_CBACK (*), UINT16, char *, int, tBTIF_COPY_CBACK (*)) { return BT_STATUS_SUCCESS; }
+int btsock_thread_exit(int) { return 0; }
+int btsock_thread_wakeup(int) { return 0; }
+}
@@ -348,6 +348,12 @@
 #define BTA_DM_SDP_DB_SIZE  8000
 #endif
 
+/* TRUE to discover all requested BR/EDR services of a device with a single
+** SDP ServiceSearchAttribute transaction, FALSE for one transaction per service */
+#ifndef BTA_DM_SDP_BATCH_SEARCH
+#define BTA_DM_SDP_BATCH_SEARCH  TRUE
+#endif
+
 #ifndef HL_INCLUDED
 #define HL_INCLUDED  TRUE
 #endif
@@ -739,6 +745,22 @@ BT_API extern void bte_ssr_cleanup(void);
 #define HCI_MAX_SIMUL_CMDS          0
 #endif
 
+/* Number of HCI commands that can be waiting for Command Complete or Command Status at once.
+** Further commands stay on the transmit queue until a slot frees up. Must be less than 255. */
+#ifndef BTU_MAX_PEND_CMDS
+#define BTU_MAX_PEND_CMDS           16
+#endif
+
+/* If TRUE, BTU keeps per opcode counts and a latency histogram of HCI commands */
+#ifndef BTU_CMD_STATS_INCLUDED
+#define BTU_CMD_STATS_INCLUDED      TRUE
+#endif
+
+/* Number of distinct opcodes BTU keeps statistics for */
+#ifndef BTU_CMD_STATS_SIZE
+#define BTU_CMD_STATS_SIZE          64
+#endif
+
 /* Timeout for receiving response to HCI command */
 #ifndef BTU_CMD_CMPL_TIMEOUT
 #define BTU_CMD_CMPL_TIMEOUT        8
@@ -995,11 +1017,19 @@ and USER_HW_DISABLE_API macros */
 #define BTM_DEFAULT_SCO_MODE        2
 #endif
 
-/* The number of security records for peer devices. */
+/* The number of security records for peer devices. When a loader is registered
+** with BTM_SecRegisterDevLoader, bonded devices beyond this are kept in storage
+** and paged in when they are needed. */
 #ifndef BTM_SEC_MAX_DEVICE_RECORDS
 #define BTM_SEC_MAX_DEVICE_RECORDS  100
 #endif
 
+/* The number of buckets used to look up security records by BD address and by
+** connection handle. Must be a power of 2. */
+#ifndef BTM_SEC_DEV_HASH_SIZE
+#define BTM_SEC_DEV_HASH_SIZE       128
+#endif
+
 /* The number of security records for services. */
 #ifndef BTM_SEC_MAX_SERVICE_RECORDS
 #define BTM_SEC_MAX_SERVICE_RECORDS 32
@@ -1186,12 +1216,14 @@ and USER_HW_DISABLE_API macros */
 #define L2CAP_FCR_INCLUDED TRUE
 #endif
 
-/* The maximum number of simultaneous channels that L2CAP can support. */
+/* The maximum number of simultaneous channels that L2CAP can support. This sizes
+** the pool; L2capMaxChannels in bt_stack.conf can lower it at run time. */
 #ifndef MAX_L2CAP_CHANNELS
 #define MAX_L2CAP_CHANNELS          16
 #endif
 
-/* The maximum number of simultaneous links that L2CAP can support. */
+/* The maximum number of simultaneous links that L2CAP can support. This sizes
+** the pool; L2capMaxLinks in bt_stack.conf can lower it at run time. */
 #ifndef MAX_L2CAP_CHANNELS
 #define MAX_L2CAP_LINKS             7
 #else
@@ -1461,6 +1493,12 @@ and USER_HW_DISABLE_API macros */
 #define GATT_MAX_SR_PROFILES        32 /* max is 32 */
 #endif
 
+/* Number of attribute type buckets kept per GATT server service database.
+** Read By Type requests only visit the attributes of the matching bucket. */
+#ifndef GATT_DB_TYPE_HASH_SIZE
+#define GATT_DB_TYPE_HASH_SIZE      16
+#endif
+
 #ifndef GATT_MAX_APPS
 #define GATT_MAX_APPS            32 /* note: 2 apps used internally GATT and GAP */
 #endif
@@ -1488,6 +1526,12 @@ and USER_HW_DISABLE_API macros */
 #define GATT_MAX_BG_CONN_DEV        32
 #endif
 
+/* Number of discovery results the GATT client parses from a response PDU
+** before handing them to the application in one batch. */
+#ifndef GATT_DISC_RES_BATCH_MAX
+#define GATT_DISC_RES_BATCH_MAX     32
+#endif
+
 /******************************************************************************
 **
 ** SMP
@@ -1555,6 +1599,12 @@ and USER_HW_DISABLE_API macros */
 #define SDP_MAX_PAD_LEN             600
 #endif
 
+/* The maximum number of distinct UUIDs in the SDP server's UUID-to-record
+** index. If the records hold more, searches fall back to walking the records. */
+#ifndef SDP_MAX_UUID_INDEX
+#define SDP_MAX_UUID_INDEX          64
+#endif
+
 /* The maximum length, in bytes, of an attribute. */
 #ifndef SDP_MAX_ATTR_LEN
 //#if defined(HID_DEV_INCLUDED) && (HID_DEV_INCLUDED==TRUE)
@@ -1590,6 +1640,27 @@ and USER_HW_DISABLE_API macros */
 #define SDP_MAX_LIST_BYTE_COUNT     4096
 #endif
 
+/* TRUE to keep the ServiceSearchAttribute results of remote devices so repeat
+** searches can be answered without an SDP connection */
+#ifndef SDP_CACHE_INCLUDED
+#define SDP_CACHE_INCLUDED          TRUE
+#endif
+
+/* Number of remote devices whose SDP results are kept in memory */
+#ifndef SDP_CACHE_MAX_DEVICES
+#define SDP_CACHE_MAX_DEVICES       8
+#endif
+
+/* Number of distinct searches cached per remote device */
+#ifndef SDP_CACHE_MAX_ENTRIES
+#define SDP_CACHE_MAX_ENTRIES       4
+#endif
+
+/* Default lifetime of a cached search result, in seconds. 0 disables the cache */
+#ifndef SDP_CACHE_TTL
+#define SDP_CACHE_TTL               (7 * 24 * 60 * 60)
+#endif
+
 /* The maximum number of parameters in an SDP protocol element. */
 #ifndef SDP_MAX_PROTOCOL_PARAMS
 #define SDP_MAX_PROTOCOL_PARAMS     2
@@ -2065,7 +2136,8 @@ Range: Minimum 12000 (12 secs) on BR/EDR when supporting PBF.
 #define BNEP_MAX_XMITQ_DEPTH        20
 #endif
 
-/* Maximum number BNEP of connections supported. */
+/* Maximum number BNEP of connections supported. This sizes the pool;
+** BnepMaxConnections in bt_stack.conf can lower it at run time. */
 #ifndef BNEP_MAX_CONNECTIONS
 #define BNEP_MAX_CONNECTIONS        7
 #endif
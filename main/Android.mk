@@ -36,6 +36,8 @@ LOCAL_SRC_FILES += \
 	../btif/src/btif_hd.c \
 	../btif/src/btif_hl.c \
 	../btif/src/btif_mce.c \
+	../btif/src/btif_media_jb.c \
+	../btif/src/btif_media_pcm.c \
 	../btif/src/btif_media_task.c \
 	../btif/src/btif_pan.c \
 	../btif/src/btif_profile_queue.c \
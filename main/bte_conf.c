@@ -31,6 +31,11 @@ extern char hci_logfile[256];
 extern BOOLEAN hci_logging_enabled;
 extern BOOLEAN hci_save_log;
 extern BOOLEAN trace_conf_enabled;
+extern UINT16 l2c_max_links;
+extern UINT16 l2c_max_channels;
+#if (defined(BNEP_INCLUDED) && BNEP_INCLUDED == TRUE)
+extern UINT16 bnep_max_connections;
+#endif
 void bte_trace_conf_config(const config_t *config);
 
 // Reads the stack configuration file and populates global variables with
@@ -51,6 +56,14 @@ void bte_load_conf(const char *path) {
   hci_save_log = config_get_bool(config, CONFIG_DEFAULT_SECTION, "BtSnoopSaveLog", false);
   trace_conf_enabled = config_get_bool(config, CONFIG_DEFAULT_SECTION, "TraceConf", false);
 
+  // Control block pool limits. The pools are sized at build time; these only
+  // lower how much of them may be in use at once.
+  l2c_max_links = config_get_int(config, CONFIG_DEFAULT_SECTION, "L2capMaxLinks", l2c_max_links);
+  l2c_max_channels = config_get_int(config, CONFIG_DEFAULT_SECTION, "L2capMaxChannels", l2c_max_channels);
+#if (defined(BNEP_INCLUDED) && BNEP_INCLUDED == TRUE)
+  bnep_max_connections = config_get_int(config, CONFIG_DEFAULT_SECTION, "BnepMaxConnections", bnep_max_connections);
+#endif
+
   bte_trace_conf_config(config);
   config_free(config);
 }
@@ -9,10 +9,14 @@ LOCAL_SRC_FILES := \
     ./src/alarm.c \
     ./src/config.c \
     ./src/fixed_queue.c \
+    ./src/hash_map.c \
+    ./src/ilist.c \
+    ./src/journal.c \
     ./src/list.c \
     ./src/reactor.c \
     ./src/semaphore.c \
-    ./src/thread.c
+    ./src/thread.c \
+    ./src/thread_pool.c
 
 LOCAL_CFLAGS := -std=c99 -Wall -Werror
 LOCAL_MODULE := libosi
@@ -32,8 +36,12 @@ LOCAL_C_INCLUDES := \
 LOCAL_SRC_FILES := \
     ./test/alarm_test.cpp \
     ./test/config_test.cpp \
+    ./test/hash_map_test.cpp \
+    ./test/ilist_test.cpp \
+    ./test/journal_test.cpp \
     ./test/list_test.cpp \
     ./test/reactor_test.cpp \
+    ./test/thread_pool_test.cpp \
     ./test/thread_test.cpp
 
 LOCAL_CFLAGS := -Wall -Werror
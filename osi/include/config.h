@@ -14,6 +14,10 @@
 //   not exist. In other words, |config_has_section| will return false for
 //   empty sections.
 // - Duplicate keys in a section will overwrite previous values.
+// - The file is mapped and parsed in one pass; lookups are hashed on the
+//   section and key, so they take the same time however large the file is.
+// - Strings returned by |config_get_string| remain valid until |config_free|,
+//   even if the key is set again.
 
 #include <stdbool.h>
 
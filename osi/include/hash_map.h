@@ -0,0 +1,88 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// An intrusive hash map with open addressing. Elements embed a
+// |hash_map_entry_t| and the map holds pointers to those entries in a single
+// table, so inserting never allocates unless the table has to grow, and an
+// entry is removed in constant time without a lookup. The map does not own
+// its entries or their keys; a key must stay valid while its entry is in the
+// map.
+
+struct hash_map_t;
+typedef struct hash_map_t hash_map_t;
+
+typedef size_t hash_index_t;
+
+typedef struct hash_map_entry_t {
+  const void *key;
+  hash_index_t hash;   // cached hash of |key|.
+  size_t slot;         // position in the table, maintained by the map.
+} hash_map_entry_t;
+
+typedef hash_index_t (*hash_map_hash_cb)(const void *key);
+typedef bool (*hash_map_key_equal_cb)(const void *a, const void *b);
+typedef bool (*hash_map_iter_cb)(hash_map_entry_t *entry, void *context);
+
+// Returns the element of |type| whose |member| is |entry|.
+#define HASH_MAP_ENTRY(entry, type, member) \
+  ((type *)((char *)(entry) - offsetof(type, member)))
+
+// Returns a new, empty map whose table holds |capacity| entries before it
+// needs to grow. |hash_cb| and |key_equal_cb| may be NULL, in which case keys
+// are compared as pointers. Returns NULL if not enough memory could be
+// allocated. The map must be freed with |hash_map_free|.
+hash_map_t *hash_map_new(size_t capacity, hash_map_hash_cb hash_cb, hash_map_key_equal_cb key_equal_cb);
+
+// Frees the map but not its entries. |map| may be NULL.
+void hash_map_free(hash_map_t *map);
+
+// Returns true if |map| has no entries. |map| may not be NULL.
+bool hash_map_is_empty(const hash_map_t *map);
+
+// Returns the number of entries in |map|. |map| may not be NULL.
+size_t hash_map_size(const hash_map_t *map);
+
+// Adds |entry| under |key|. Returns false if an entry with an equal key is
+// already in the map, or if the table needed to grow and could not. |entry|
+// must not be in any map. |map|, |key| and |entry| may not be NULL.
+bool hash_map_insert(hash_map_t *map, const void *key, hash_map_entry_t *entry);
+
+// Returns the entry with a key equal to |key|, or NULL if there is none.
+// Neither |map| nor |key| may be NULL.
+hash_map_entry_t *hash_map_get(const hash_map_t *map, const void *key);
+
+// Removes |entry|, which must be in |map|. The entry itself is untouched
+// apart from its bookkeeping. Neither |map| nor |entry| may be NULL.
+void hash_map_remove(hash_map_t *map, hash_map_entry_t *entry);
+
+// Removes every entry from |map|. |map| may not be NULL.
+void hash_map_clear(hash_map_t *map);
+
+// Calls |callback| with each entry of |map| in no particular order, until it
+// returns false. The map must not be modified from |callback|. Neither |map|
+// nor |callback| may be NULL.
+void hash_map_foreach(const hash_map_t *map, hash_map_iter_cb callback, void *context);
+
+// Hash and comparison functions for NUL-terminated string keys.
+hash_index_t hash_map_string_hash(const void *key);
+bool hash_map_string_equal(const void *a, const void *b);
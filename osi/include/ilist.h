@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// An intrusive doubly linked list. Elements embed an |ilist_node_t| and are
+// linked through it, so the list never allocates and an element is removed
+// in constant time given its node. The list does not own its elements.
+
+typedef struct ilist_node_t {
+  struct ilist_node_t *next;
+  struct ilist_node_t *prev;
+} ilist_node_t;
+
+// A list may be embedded in another structure; it must be initialized with
+// |ilist_init| or |ILIST_INITIALIZER| before use.
+typedef struct ilist_t {
+  ilist_node_t head;   // sentinel; head.next is the first node.
+  size_t length;
+} ilist_t;
+
+#define ILIST_INITIALIZER(list) { { &(list).head, &(list).head }, 0 }
+
+// Returns the element of |type| whose |member| is |node|.
+#define ILIST_ENTRY(node, type, member) \
+  ((type *)((char *)(node) - offsetof(type, member)))
+
+// Initializes |list| to the empty list. |list| may not be NULL.
+void ilist_init(ilist_t *list);
+
+// Marks |node| as not being on any list, so |ilist_node_is_linked| may be
+// called on it. |node| may not be NULL.
+void ilist_node_init(ilist_node_t *node);
+
+// Returns true if |node| is on a list. Nodes removed with |ilist_remove| are
+// not on any list. |node| may not be NULL.
+bool ilist_node_is_linked(const ilist_node_t *node);
+
+// Returns true if |list| has no nodes. |list| may not be NULL.
+bool ilist_is_empty(const ilist_t *list);
+
+// Returns the number of nodes in |list|. |list| may not be NULL.
+size_t ilist_length(const ilist_t *list);
+
+// Returns the first or last node of |list|, or NULL if it is empty. |list|
+// may not be NULL.
+ilist_node_t *ilist_front(const ilist_t *list);
+ilist_node_t *ilist_back(const ilist_t *list);
+
+// Links |node| at the beginning or end of |list|, or after |prev|, which must
+// be on |list|. |node| must not be on any list. None of the arguments may be
+// NULL.
+void ilist_prepend(ilist_t *list, ilist_node_t *node);
+void ilist_append(ilist_t *list, ilist_node_t *node);
+void ilist_insert_after(ilist_t *list, ilist_node_t *prev, ilist_node_t *node);
+
+// Unlinks |node|, which must be on |list|. The element itself is untouched.
+// Neither |list| nor |node| may be NULL.
+void ilist_remove(ilist_t *list, ilist_node_t *node);
+
+// Unlinks every node of |list|. |list| may not be NULL.
+void ilist_clear(ilist_t *list);
+
+// Iteration, in the style of list.h: the node returned by |ilist_end| is not
+// an element and ends the walk. A node may be removed while it is visited if
+// its successor was taken first.
+ilist_node_t *ilist_begin(const ilist_t *list);
+ilist_node_t *ilist_end(const ilist_t *list);
+ilist_node_t *ilist_next(const ilist_node_t *node);
@@ -0,0 +1,68 @@
+#pragma once
+
+// This module implements an append-only journal of opaque records, meant to
+// sit next to a snapshot file so that small changes can be made durable
+// without rewriting the snapshot every time. Records are buffered in memory
+// by |journal_append| and written out, followed by a single fsync, by
+// |journal_sync|; clients decide how many records go into one sync.
+
+// Implementation notes:
+// - Every record is framed with its length and a CRC32 of its payload.
+// - A crash or power loss can leave a partial record at the end of the file.
+//   |journal_replay| stops at the first record that is short or fails its
+//   CRC and ignores everything after it; |journal_open| truncates that tail
+//   away so new records are never appended behind garbage.
+// - Records are replayed in the order they were appended. Clients that
+//   compact the journal into a snapshot should write the snapshot first and
+//   only then call |journal_reset|, so a crash in between replays records the
+//   snapshot already contains. Records should therefore be idempotent.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Largest payload accepted by |journal_append|. Anything bigger found while
+// replaying is treated as corruption.
+#define JOURNAL_MAX_RECORD_SIZE 65536
+
+struct journal_t;
+typedef struct journal_t journal_t;
+
+// Called once for every intact record, in order, by |journal_replay|. |record|
+// is only valid for the duration of the call.
+typedef void (*journal_replay_cb)(const void *record, size_t length, void *context);
+
+// Opens the journal at |path| for appending, creating it if it does not exist.
+// A torn or corrupt tail is truncated. Returns NULL if the file could not be
+// opened or memory could not be allocated. |path| must not be NULL. The caller
+// must call |journal_close| on the returned handle.
+journal_t *journal_open(const char *path);
+
+// Closes |journal|. Records that were appended but not synced are dropped.
+// |journal| may be NULL.
+void journal_close(journal_t *journal);
+
+// Buffers one record of |length| bytes. Nothing is written to disk until the
+// next |journal_sync|. Returns false if |length| is 0 or larger than
+// |JOURNAL_MAX_RECORD_SIZE|, or memory could not be allocated. |journal| and
+// |record| must not be NULL.
+bool journal_append(journal_t *journal, const void *record, size_t length);
+
+// Writes all buffered records to disk and waits for them to be durable. On
+// failure the file is cut back to its last synced length and the records stay
+// buffered for the next attempt. Returns true if there was nothing to write.
+// |journal| must not be NULL.
+bool journal_sync(journal_t *journal);
+
+// Discards every record, synced or not, leaving an empty journal. Used after
+// the contents have been compacted into a snapshot. |journal| must not be NULL.
+bool journal_reset(journal_t *journal);
+
+// Returns the size of the journal in bytes, including records not yet synced.
+// |journal| must not be NULL.
+size_t journal_size(const journal_t *journal);
+
+// Calls |callback| for every intact record in the journal at |path|, oldest
+// first, stopping at the first torn or corrupt one. The file is not modified.
+// Returns the number of records replayed; a missing file replays nothing.
+// |path| and |callback| must not be NULL.
+size_t journal_replay(const char *path, journal_replay_cb callback, void *context);
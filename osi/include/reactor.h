@@ -21,10 +21,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "ilist.h"
 #include "osi.h"
 
 // This module implements the Reactor pattern.
 // See http://en.wikipedia.org/wiki/Reactor_pattern for details.
+// The reactor is built on epoll, so registering, unregistering and waking up
+// on an event do not depend on how many objects are registered, and file
+// descriptors are not limited to FD_SETSIZE.
 
 struct reactor_t;
 typedef struct reactor_t reactor_t;
@@ -32,12 +36,20 @@ typedef struct reactor_t reactor_t;
 struct reactor_object_t;
 typedef struct reactor_object_t reactor_object_t;
 
+struct reactor_timer_t;
+typedef struct reactor_timer_t reactor_timer_t;
+
+typedef void (*reactor_timer_cb)(void *context);
+
 // Enumerates the types of events a reactor object is interested
 // in responding to.
 typedef enum {
   REACTOR_INTEREST_READ  = 1,
   REACTOR_INTEREST_WRITE = 2,
   REACTOR_INTEREST_READ_WRITE = 3,
+  // May be or'ed with the above. The object is only reported when the file
+  // descriptor becomes ready again, so it must be drained every time.
+  REACTOR_INTEREST_EDGE = 4,
 } reactor_interest_t;
 
 // Enumerates the reasons a reactor has stopped.
@@ -55,6 +67,8 @@ struct reactor_object_t {
 
   void (*read_ready)(void *context);   // function to call when the file descriptor becomes readable.
   void (*write_ready)(void *context);  // function to call when the file descriptor becomes writeable.
+
+  ilist_node_t node;                   // links the object into the reactor; not for clients.
 };
 
 // Creates a new reactor object. Returns NULL on failure. The returned object
@@ -80,10 +94,36 @@ reactor_status_t reactor_run_once_timeout(reactor_t *reactor, timeout_t timeout_
 void reactor_stop(reactor_t *reactor);
 
 // Registers an object with the reactor. |obj| is neither copied nor is its ownership transferred
-// so the pointer must remain valid until it is unregistered with |reactor_unregister|. Neither
-// |reactor| nor |obj| may be NULL.
+// so the pointer must remain valid until it is unregistered with |reactor_unregister|. |obj|
+// must not already be registered, and its |fd| and |interest| must not change while it is.
+// Neither |reactor| nor |obj| may be NULL.
 void reactor_register(reactor_t *reactor, reactor_object_t *obj);
 
-// Unregisters a previously registered object with the |reactor|. Neither |reactor| nor |obj|
-// may be NULL.
+// Unregisters a previously registered object with the |reactor|. Once this returns, no
+// callback for |obj| will be started, even for events already reported in the current
+// iteration. Called from another thread, it also waits for a callback of |obj| that is
+// running on the reactor thread to return, so that callback must not wait on the caller.
+// Called from the reactor thread, e.g. from one of |obj|'s own callbacks, it does not
+// wait, and |obj| may be freed once it returns. Unregistering an object a second time
+// does nothing. The object's file descriptor must not have been closed yet. Neither
+// |reactor| nor |obj| may be NULL.
 void reactor_unregister(reactor_t *reactor, reactor_object_t *obj);
+
+// Creates a timer that calls |callback| with |context| on the thread running |reactor|
+// when it expires. The timer is backed by a timerfd on CLOCK_MONOTONIC, so it does not
+// count time spent in suspend; use alarm.h for timers that must wake the device.
+// Returns NULL on failure. The timer must be freed with |reactor_timer_free| before
+// |reactor| is. Neither |reactor| nor |callback| may be NULL.
+reactor_timer_t *reactor_timer_new(reactor_t *reactor, reactor_timer_cb callback, void *context);
+
+// Cancels and frees |timer|. |timer| may be NULL.
+void reactor_timer_free(reactor_timer_t *timer);
+
+// Arms |timer| to expire |deadline_ms| from now, and then every |period_ms| if
+// |period_ms| is not 0. Setting an armed timer replaces its deadline. |timer| may
+// not be NULL.
+void reactor_timer_set(reactor_timer_t *timer, timeout_t deadline_ms, timeout_t period_ms);
+
+// Disarms |timer|. When called on the reactor thread, an expiry that has been
+// reported but not yet dispatched is dropped as well. |timer| may not be NULL.
+void reactor_timer_cancel(reactor_timer_t *timer);
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "thread.h"
+
+// This module implements a pool of worker threads for CPU-bound work that
+// does not need to run on a particular thread. Every worker owns one deque per
+// priority: it takes its own work from the back and, when it runs out, steals
+// from the front of the other workers' deques. Tasks of a higher priority are
+// always taken before tasks of a lower one, but there is no ordering between
+// tasks of the same priority. A task must not block waiting on another task
+// except through |thread_pool_group_join|.
+
+// Largest number of workers in one pool.
+#define THREAD_POOL_MAX_THREADS 32
+
+struct thread_pool_t;
+typedef struct thread_pool_t thread_pool_t;
+
+struct thread_pool_group_t;
+typedef struct thread_pool_group_t thread_pool_group_t;
+
+typedef enum {
+  THREAD_POOL_PRIORITY_HIGH,
+  THREAD_POOL_PRIORITY_NORMAL,
+  THREAD_POOL_PRIORITY_LOW,
+  THREAD_POOL_PRIORITY_COUNT,
+} thread_pool_priority_t;
+
+// Creates a pool of |num_threads| workers named after |name|, or one per
+// online CPU if |num_threads| is 0. Returns NULL on failure. The returned pool
+// must be freed with |thread_pool_free|. |name| may not be NULL.
+thread_pool_t *thread_pool_new(const char *name, size_t num_threads);
+
+// Runs every task already posted to |pool|, then stops its workers and frees
+// it. Must not be called from a task of |pool|. |pool| may be NULL.
+void thread_pool_free(thread_pool_t *pool);
+
+// Returns the number of workers in |pool|. |pool| may not be NULL.
+size_t thread_pool_size(const thread_pool_t *pool);
+
+// Calls |func| with |context| on one of the workers of |pool|. Tasks posted
+// from a worker go to the back of its own deque, so they are likely to run
+// there while its caches are warm. Returns false if memory could not be
+// allocated. Neither |pool| nor |func| may be NULL.
+bool thread_pool_post(thread_pool_t *pool, thread_fn func, void *context, thread_pool_priority_t priority);
+
+// Creates a group to fork tasks into and join them. Returns NULL on failure.
+// The group must be joined and then freed with |thread_pool_group_free|.
+// |pool| may not be NULL.
+thread_pool_group_t *thread_pool_group_new(thread_pool_t *pool);
+
+// Frees |group|, which must have been joined since its last fork. |group| may
+// be NULL.
+void thread_pool_group_free(thread_pool_group_t *group);
+
+// Posts |func| with |context| to the pool of |group| as a member of |group|.
+// Tasks may fork more tasks into the same or other groups. Returns false if
+// memory could not be allocated. Neither |group| nor |func| may be NULL.
+bool thread_pool_group_fork(thread_pool_group_t *group, thread_fn func, void *context, thread_pool_priority_t priority);
+
+// Returns once every task forked into |group| has run. While waiting, the
+// caller runs pending tasks of the pool itself, so it is safe to join from a
+// task, even in a pool of one worker. |group| may not be NULL.
+void thread_pool_group_join(thread_pool_group_t *group);
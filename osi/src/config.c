@@ -2,67 +2,148 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <utils/Log.h>
 
 #include "config.h"
-#include "list.h"
 
-typedef struct {
-  char *key;
-  char *value;
-} entry_t;
-
-typedef struct {
-  char *name;
-  list_t *entries;
+// Sections, entries and strings all live in an arena that is released at
+// once by |config_free|. Lookups go through a hash table keyed by section
+// and key, so they do not depend on the size of the file.
+
+typedef struct arena_block_t {
+  struct arena_block_t *next;
+  size_t used;
+  size_t size;
+  char data[];
+} arena_block_t;
+
+typedef struct section_t {
+  const char *name;
+  uint32_t hash;
+  struct section_t *next;   // in its bucket
 } section_t;
 
+typedef struct entry_t {
+  const section_t *section;
+  const char *key;
+  const char *value;
+  uint32_t hash;
+  struct entry_t *next;     // in its bucket
+} entry_t;
+
 struct config_t {
-  list_t *sections;
+  arena_block_t *arena;
+
+  section_t **sections;
+  size_t num_sections;
+  size_t section_buckets;   // a power of two
+
+  entry_t **entries;
+  size_t num_entries;
+  size_t entry_buckets;     // a power of two
 };
 
-static void config_parse(FILE *fp, config_t *config);
+static const size_t ARENA_BLOCK_SIZE = 4096;
+static const size_t INITIAL_BUCKETS = 16;
+
+static bool config_parse(config_t *config, const char *data, size_t size);
+
+static void *arena_alloc(config_t *config, size_t size);
+static char *arena_strndup(config_t *config, const char *str, size_t len);
 
-static section_t *section_new(const char *name);
-static void section_free(void *ptr);
-static section_t *section_find(const config_t *config, const char *section);
+static const uint32_t HASH_SEED = 2166136261u;
 
-static entry_t *entry_new(const char *key, const char *value);
-static void entry_free(void *ptr);
+static uint32_t hash_add(uint32_t hash, const char *str, size_t len);
+static bool grow(void ***buckets, size_t *num_buckets, size_t count, size_t next_offset, size_t hash_offset);
+
+static section_t *section_find(const config_t *config, const char *section, uint32_t hash);
+static section_t *section_add(config_t *config, const char *name);
 static entry_t *entry_find(const config_t *config, const char *section, const char *key);
+static bool entry_set(config_t *config, section_t *section, const char *key, size_t key_len, const char *value, size_t value_len);
 
 config_t *config_new(const char *filename) {
   assert(filename != NULL);
 
-  FILE *fp = fopen(filename, "rt");
-  if (!fp) {
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) {
     ALOGE("%s unable to open file '%s': %s", __func__, filename, strerror(errno));
     return NULL;
   }
 
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    ALOGE("%s unable to stat file '%s': %s", __func__, filename, strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  // mmap refuses empty files; an empty file is an empty config.
+  void *data = NULL;
+  size_t size = (size_t)st.st_size;
+  if (size > 0) {
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      ALOGE("%s unable to map file '%s': %s", __func__, filename, strerror(errno));
+      close(fd);
+      return NULL;
+    }
+  }
+  close(fd);
+
   config_t *config = calloc(1, sizeof(config_t));
   if (!config) {
     ALOGE("%s unable to allocate memory for config_t.", __func__);
-    fclose(fp);
-    return NULL;
+    goto error;
   }
 
-  config->sections = list_new(section_free);
-  config_parse(fp, config);
+  config->section_buckets = INITIAL_BUCKETS;
+  config->sections = calloc(config->section_buckets, sizeof(section_t *));
+  config->entry_buckets = INITIAL_BUCKETS;
+  config->entries = calloc(config->entry_buckets, sizeof(entry_t *));
+  if (!config->sections || !config->entries) {
+    ALOGE("%s unable to allocate memory for the index.", __func__);
+    goto error;
+  }
 
-  fclose(fp);
+  if (size > 0 && !config_parse(config, data, size)) {
+    ALOGE("%s unable to allocate memory for the contents of '%s'.", __func__, filename);
+    goto error;
+  }
 
+  if (data)
+    munmap(data, size);
   return config;
+
+error:;
+  if (data)
+    munmap(data, size);
+  config_free(config);
+  return NULL;
 }
 
 void config_free(config_t *config) {
   if (!config)
     return;
 
-  list_free(config->sections);
+  arena_block_t *block = config->arena;
+  while (block) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  free(config->sections);
+  free(config->entries);
   free(config);
 }
 
@@ -70,7 +151,7 @@ bool config_has_section(const config_t *config, const char *section) {
   assert(config != NULL);
   assert(section != NULL);
 
-  return (section_find(config, section) != NULL);
+  return (section_find(config, section, hash_add(HASH_SEED, section, strlen(section))) != NULL);
 }
 
 bool config_has_key(const config_t *config, const char *section, const char *key) {
@@ -143,142 +224,243 @@ void config_set_bool(config_t *config, const char *section, const char *key, boo
 }
 
 void config_set_string(config_t *config, const char *section, const char *key, const char *value) {
-  section_t *sec = section_find(config, section);
-  if (!sec) {
-    sec = section_new(section);
-    if (sec)
-      list_append(config->sections, sec);
-    else
-    {
-      ALOGE("%s: Unable to allocate memory for section", __func__);
-      return;
-    }
-  }
+  assert(config != NULL);
+  assert(section != NULL);
+  assert(key != NULL);
+  assert(value != NULL);
 
-  for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
-    entry_t *entry = list_node(node);
-    if (!strcmp(entry->key, key)) {
-      free(entry->value);
-      entry->value = strdup(value);
-      return;
-    }
+  section_t *sec = section_find(config, section, hash_add(HASH_SEED, section, strlen(section)));
+  if (!sec) {
+    char *name = arena_strndup(config, section, strlen(section));
+    sec = name ? section_add(config, name) : NULL;
   }
 
-  entry_t *entry = entry_new(key, value);
-  list_append(sec->entries, entry);
+  if (!sec || !entry_set(config, sec, key, strlen(key), value, strlen(value)))
+    ALOGE("%s unable to allocate memory for '%s' in section '%s'.", __func__, key, section);
 }
 
-static char *trim(char *str) {
-  while (isspace(*str))
-    ++str;
-
-  if (!*str)
-    return str;
-
-  char *end_str = str + strlen(str) - 1;
-  while (end_str > str && isspace(*end_str))
-    --end_str;
-
-  end_str[1] = '\0';
-  return str;
+// Narrows [*start, *end) to exclude leading and trailing whitespace.
+static void trim(const char **start, const char **end) {
+  while (*start < *end && isspace((unsigned char)**start))
+    ++*start;
+  while (*end > *start && isspace((unsigned char)(*end)[-1]))
+    --*end;
 }
 
-static void config_parse(FILE *fp, config_t *config) {
-  assert(fp != NULL);
+// Parses the file contents in place; only sections, keys and values are
+// copied out, into the arena. Returns false if memory ran out.
+static bool config_parse(config_t *config, const char *data, size_t size) {
   assert(config != NULL);
+  assert(data != NULL);
 
+  const char *data_end = data + size;
   int line_num = 0;
-  char line[1024];
-  char section[1024];
-  strcpy(section, CONFIG_DEFAULT_SECTION);
 
-  while (fgets(line, sizeof(line), fp)) {
-    char *line_ptr = trim(line);
+  section_t *section = NULL;
+  const char *section_name = CONFIG_DEFAULT_SECTION;
+  size_t section_len = strlen(CONFIG_DEFAULT_SECTION);
+
+  for (const char *line = data; line < data_end; ) {
+    const char *newline = memchr(line, '\n', data_end - line);
+    const char *next = newline ? newline + 1 : data_end;
+    // As with a C string, a NUL ends the line.
+    const char *nul = memchr(line, '\0', next - line);
+    const char *start = line;
+    const char *end = nul ? nul : next;
+
+    line = next;
     ++line_num;
+    trim(&start, &end);
 
     // Skip blank and comment lines.
-    if (*line_ptr == '\0' || *line_ptr == '#')
+    if (start == end || *start == '#')
       continue;
 
-    if (*line_ptr == '[') {
-      size_t len = strlen(line_ptr);
-      if (line_ptr[len - 1] != ']') {
+    if (*start == '[') {
+      if (end[-1] != ']' || end - start < 2) {
         ALOGD("%s unterminated section name on line %d.", __func__, line_num);
         continue;
       }
-      strncpy(section, line_ptr + 1, len - 2);
-      section[len - 2] = '\0';
+      section = NULL;
+      section_name = start + 1;
+      section_len = end - start - 2;
     } else {
-      char *split = strchr(line_ptr, '=');
+      const char *split = memchr(start, '=', end - start);
       if (!split) {
         ALOGD("%s no key/value separator found on line %d.", __func__, line_num);
         continue;
       }
 
-      *split = '\0';
-      config_set_string(config, section, trim(line_ptr), trim(split + 1));
+      // Sections are created on their first key, so empty ones do not exist.
+      if (!section) {
+        char *name = arena_strndup(config, section_name, section_len);
+        if (!name)
+          return false;
+        section = section_find(config, name, hash_add(HASH_SEED, name, section_len));
+        if (!section && !(section = section_add(config, name)))
+          return false;
+      }
+
+      const char *key = start, *key_end = split;
+      const char *value = split + 1, *value_end = end;
+      trim(&key, &key_end);
+      trim(&value, &value_end);
+      if (!entry_set(config, section, key, key_end - key, value, value_end - value))
+        return false;
     }
   }
+
+  return true;
 }
 
-static section_t *section_new(const char *name) {
-  section_t *section = calloc(1, sizeof(section_t));
-  if (!section)
+static void *arena_alloc(config_t *config, size_t size) {
+  // Keep every allocation aligned for the structs placed in the arena.
+  size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+  arena_block_t *block = config->arena;
+  if (!block || block->size - block->used < size) {
+    size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    block = malloc(sizeof(arena_block_t) + block_size);
+    if (!block)
+      return NULL;
+    block->used = 0;
+    block->size = block_size;
+
+    // Leave a partly used block at the head if the new one is a one-off.
+    if (config->arena && block_size > ARENA_BLOCK_SIZE) {
+      block->next = config->arena->next;
+      config->arena->next = block;
+    } else {
+      block->next = config->arena;
+      config->arena = block;
+    }
+  }
+
+  void *ptr = block->data + block->used;
+  block->used += size;
+  return ptr;
+}
+
+static char *arena_strndup(config_t *config, const char *str, size_t len) {
+  char *copy = arena_alloc(config, len + 1);
+  if (!copy)
     return NULL;
 
-  section->name = strdup(name);
-  section->entries = list_new(entry_free);
-  return section;
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+  return copy;
 }
 
-static void section_free(void *ptr) {
-  if (!ptr)
-    return;
+// FNV-1a over |len| bytes of |str|, continued from |hash| so a key can be
+// hashed after its section. A terminator is mixed in so "ab" + "c" and
+// "a" + "bc" differ.
+static uint32_t hash_add(uint32_t hash, const char *str, size_t len) {
+  for (size_t i = 0; i < len; ++i)
+    hash = (hash ^ (uint8_t)str[i]) * 16777619u;
+  return (hash ^ 0xff) * 16777619u;
+}
+
+// Doubles a bucket array once it holds as many items as buckets. Items are
+// chained through the pointer at |next_offset| and keep their hash at
+// |hash_offset|.
+static bool grow(void ***buckets, size_t *num_buckets, size_t count, size_t next_offset, size_t hash_offset) {
+  if (count < *num_buckets)
+    return true;
 
-  section_t *section = ptr;
-  free(section->name);
-  list_free(section->entries);
+  size_t new_num = *num_buckets * 2;
+  void **new_buckets = calloc(new_num, sizeof(void *));
+  if (!new_buckets)
+    return false;
+
+  for (size_t i = 0; i < *num_buckets; ++i) {
+    void *item = (*buckets)[i];
+    while (item) {
+      void *next = *(void **)((char *)item + next_offset);
+      uint32_t hash = *(uint32_t *)((char *)item + hash_offset);
+      *(void **)((char *)item + next_offset) = new_buckets[hash & (new_num - 1)];
+      new_buckets[hash & (new_num - 1)] = item;
+      item = next;
+    }
+  }
+
+  free(*buckets);
+  *buckets = new_buckets;
+  *num_buckets = new_num;
+  return true;
 }
 
-static section_t *section_find(const config_t *config, const char *section) {
-  for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
-    section_t *sec = list_node(node);
-    if (!strcmp(sec->name, section))
+static section_t *section_find(const config_t *config, const char *section, uint32_t hash) {
+  for (section_t *sec = config->sections[hash & (config->section_buckets - 1)]; sec; sec = sec->next)
+    if (sec->hash == hash && !strcmp(sec->name, section))
       return sec;
-  }
 
   return NULL;
 }
 
-static entry_t *entry_new(const char *key, const char *value) {
-  entry_t *entry = calloc(1, sizeof(entry_t));
-  if (!entry)
+// |name| must already be in the arena.
+static section_t *section_add(config_t *config, const char *name) {
+  if (!grow((void ***)&config->sections, &config->section_buckets, config->num_sections,
+            offsetof(section_t, next), offsetof(section_t, hash)))
     return NULL;
 
-  entry->key = strdup(key);
-  entry->value = strdup(value);
-  return entry;
-}
+  section_t *sec = arena_alloc(config, sizeof(section_t));
+  if (!sec)
+    return NULL;
 
-static void entry_free(void *ptr) {
-  if (!ptr)
-    return;
+  sec->name = name;
+  sec->hash = hash_add(HASH_SEED, name, strlen(name));
 
-  entry_t *entry = ptr;
-  free(entry->key);
-  free(entry->value);
+  size_t bucket = sec->hash & (config->section_buckets - 1);
+  sec->next = config->sections[bucket];
+  config->sections[bucket] = sec;
+  ++config->num_sections;
+  return sec;
 }
 
 static entry_t *entry_find(const config_t *config, const char *section, const char *key) {
-  section_t *sec = section_find(config, section);
-  if (!sec)
-    return NULL;
+  uint32_t hash = hash_add(hash_add(HASH_SEED, section, strlen(section)), key, strlen(key));
 
-  for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
-    entry_t *entry = list_node(node);
-    if (!strcmp(entry->key, key))
+  for (entry_t *entry = config->entries[hash & (config->entry_buckets - 1)]; entry; entry = entry->next)
+    if (entry->hash == hash && !strcmp(entry->key, key) && !strcmp(entry->section->name, section))
       return entry;
-  }
 
   return NULL;
 }
+
+// Sets |key| in |section| to |value|; neither needs to be NUL terminated.
+// A replaced value stays in the arena until the config is freed.
+static bool entry_set(config_t *config, section_t *section, const char *key, size_t key_len, const char *value, size_t value_len) {
+  char *value_copy = arena_strndup(config, value, value_len);
+  if (!value_copy)
+    return false;
+
+  uint32_t hash = hash_add(section->hash, key, key_len);
+
+  for (entry_t *entry = config->entries[hash & (config->entry_buckets - 1)]; entry; entry = entry->next) {
+    if (entry->hash == hash && entry->section == section &&
+        !strncmp(entry->key, key, key_len) && entry->key[key_len] == '\0') {
+      entry->value = value_copy;
+      return true;
+    }
+  }
+
+  if (!grow((void ***)&config->entries, &config->entry_buckets, config->num_entries,
+            offsetof(entry_t, next), offsetof(entry_t, hash)))
+    return false;
+
+  entry_t *entry = arena_alloc(config, sizeof(entry_t));
+  char *key_copy = arena_strndup(config, key, key_len);
+  if (!entry || !key_copy)
+    return false;
+
+  entry->section = section;
+  entry->key = key_copy;
+  entry->value = value_copy;
+  entry->hash = hash;
+
+  size_t bucket = hash & (config->entry_buckets - 1);
+  entry->next = config->entries[bucket];
+  config->entries[bucket] = entry;
+  ++config->num_entries;
+  return true;
+}
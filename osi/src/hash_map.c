@@ -0,0 +1,217 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_map.h"
+
+// The table is a power of two in size and kept at most three quarters full.
+// Removal shifts back the entries that probed past the freed slot, so there
+// are no tombstones and lookups stop at the first empty slot.
+
+struct hash_map_t {
+  hash_map_entry_t **table;
+  size_t mask;
+  size_t size;
+  hash_map_hash_cb hash_cb;
+  hash_map_key_equal_cb key_equal_cb;
+};
+
+static const size_t MIN_TABLE_SIZE = 8;
+
+static hash_index_t hash_of(const hash_map_t *map, const void *key);
+static bool key_equal(const hash_map_t *map, const void *a, const void *b);
+static bool grow(hash_map_t *map);
+
+hash_map_t *hash_map_new(size_t capacity, hash_map_hash_cb hash_cb, hash_map_key_equal_cb key_equal_cb) {
+  hash_map_t *map = calloc(1, sizeof(hash_map_t));
+  if (!map)
+    return NULL;
+
+  size_t table_size = MIN_TABLE_SIZE;
+  while (table_size / 4 * 3 < capacity)
+    table_size *= 2;
+
+  map->table = calloc(table_size, sizeof(hash_map_entry_t *));
+  if (!map->table) {
+    free(map);
+    return NULL;
+  }
+
+  map->mask = table_size - 1;
+  map->hash_cb = hash_cb;
+  map->key_equal_cb = key_equal_cb;
+  return map;
+}
+
+void hash_map_free(hash_map_t *map) {
+  if (!map)
+    return;
+
+  free(map->table);
+  free(map);
+}
+
+bool hash_map_is_empty(const hash_map_t *map) {
+  assert(map != NULL);
+
+  return (map->size == 0);
+}
+
+size_t hash_map_size(const hash_map_t *map) {
+  assert(map != NULL);
+
+  return map->size;
+}
+
+bool hash_map_insert(hash_map_t *map, const void *key, hash_map_entry_t *entry) {
+  assert(map != NULL);
+  assert(key != NULL);
+  assert(entry != NULL);
+
+  hash_index_t hash = hash_of(map, key);
+  size_t slot = hash & map->mask;
+  for (; map->table[slot]; slot = (slot + 1) & map->mask)
+    if (map->table[slot]->hash == hash && key_equal(map, map->table[slot]->key, key))
+      return false;
+
+  if ((map->size + 1) > (map->mask + 1) / 4 * 3) {
+    if (!grow(map))
+      return false;
+    for (slot = hash & map->mask; map->table[slot]; slot = (slot + 1) & map->mask)
+      ;
+  }
+
+  entry->key = key;
+  entry->hash = hash;
+  entry->slot = slot;
+  map->table[slot] = entry;
+  ++map->size;
+  return true;
+}
+
+hash_map_entry_t *hash_map_get(const hash_map_t *map, const void *key) {
+  assert(map != NULL);
+  assert(key != NULL);
+
+  hash_index_t hash = hash_of(map, key);
+  for (size_t slot = hash & map->mask; map->table[slot]; slot = (slot + 1) & map->mask)
+    if (map->table[slot]->hash == hash && key_equal(map, map->table[slot]->key, key))
+      return map->table[slot];
+
+  return NULL;
+}
+
+void hash_map_remove(hash_map_t *map, hash_map_entry_t *entry) {
+  assert(map != NULL);
+  assert(entry != NULL);
+  assert(entry->slot <= map->mask);
+  assert(map->table[entry->slot] == entry);
+
+  size_t hole = entry->slot;
+  map->table[hole] = NULL;
+  --map->size;
+
+  for (size_t slot = (hole + 1) & map->mask; map->table[slot]; slot = (slot + 1) & map->mask) {
+    size_t home = map->table[slot]->hash & map->mask;
+
+    // Move the entry if the hole lies between its home and its slot.
+    if (((slot - home) & map->mask) >= ((slot - hole) & map->mask)) {
+      map->table[hole] = map->table[slot];
+      map->table[hole]->slot = hole;
+      map->table[slot] = NULL;
+      hole = slot;
+    }
+  }
+}
+
+void hash_map_clear(hash_map_t *map) {
+  assert(map != NULL);
+
+  memset(map->table, 0, (map->mask + 1) * sizeof(hash_map_entry_t *));
+  map->size = 0;
+}
+
+void hash_map_foreach(const hash_map_t *map, hash_map_iter_cb callback, void *context) {
+  assert(map != NULL);
+  assert(callback != NULL);
+
+  for (size_t slot = 0; slot <= map->mask; ++slot)
+    if (map->table[slot] && !callback(map->table[slot], context))
+      return;
+}
+
+hash_index_t hash_map_string_hash(const void *key) {
+  assert(key != NULL);
+
+  // FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (const char *str = key; *str; ++str)
+    hash = (hash ^ (uint8_t)*str) * 16777619u;
+  return hash;
+}
+
+bool hash_map_string_equal(const void *a, const void *b) {
+  assert(a != NULL);
+  assert(b != NULL);
+
+  return !strcmp(a, b);
+}
+
+static hash_index_t hash_of(const hash_map_t *map, const void *key) {
+  if (map->hash_cb)
+    return map->hash_cb(key);
+
+  // Pointers are aligned and clustered; spread them over the low bits.
+  uint32_t hash = (uint32_t)((uintptr_t)key >> 3) * 2654435761u;
+  return hash ^ (hash >> 16);
+}
+
+static bool key_equal(const hash_map_t *map, const void *a, const void *b) {
+  if (map->key_equal_cb)
+    return map->key_equal_cb(a, b);
+
+  return (a == b);
+}
+
+static bool grow(hash_map_t *map) {
+  size_t table_size = (map->mask + 1) * 2;
+  hash_map_entry_t **table = calloc(table_size, sizeof(hash_map_entry_t *));
+  if (!table)
+    return false;
+
+  for (size_t i = 0; i <= map->mask; ++i) {
+    hash_map_entry_t *entry = map->table[i];
+    if (!entry)
+      continue;
+
+    size_t slot = entry->hash & (table_size - 1);
+    while (table[slot])
+      slot = (slot + 1) & (table_size - 1);
+    entry->slot = slot;
+    table[slot] = entry;
+  }
+
+  free(map->table);
+  map->table = table;
+  map->mask = table_size - 1;
+  return true;
+}
@@ -0,0 +1,135 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <assert.h>
+
+#include "ilist.h"
+
+void ilist_init(ilist_t *list) {
+  assert(list != NULL);
+
+  list->head.next = &list->head;
+  list->head.prev = &list->head;
+  list->length = 0;
+}
+
+void ilist_node_init(ilist_node_t *node) {
+  assert(node != NULL);
+
+  node->next = NULL;
+  node->prev = NULL;
+}
+
+bool ilist_node_is_linked(const ilist_node_t *node) {
+  assert(node != NULL);
+
+  return (node->next != NULL);
+}
+
+bool ilist_is_empty(const ilist_t *list) {
+  assert(list != NULL);
+
+  return (list->length == 0);
+}
+
+size_t ilist_length(const ilist_t *list) {
+  assert(list != NULL);
+
+  return list->length;
+}
+
+ilist_node_t *ilist_front(const ilist_t *list) {
+  assert(list != NULL);
+
+  return list->length ? list->head.next : NULL;
+}
+
+ilist_node_t *ilist_back(const ilist_t *list) {
+  assert(list != NULL);
+
+  return list->length ? list->head.prev : NULL;
+}
+
+void ilist_prepend(ilist_t *list, ilist_node_t *node) {
+  assert(list != NULL);
+
+  ilist_insert_after(list, &list->head, node);
+}
+
+void ilist_append(ilist_t *list, ilist_node_t *node) {
+  assert(list != NULL);
+
+  ilist_insert_after(list, list->head.prev, node);
+}
+
+void ilist_insert_after(ilist_t *list, ilist_node_t *prev, ilist_node_t *node) {
+  assert(list != NULL);
+  assert(prev != NULL);
+  assert(node != NULL);
+  assert(prev->next != NULL);
+
+  node->prev = prev;
+  node->next = prev->next;
+  prev->next->prev = node;
+  prev->next = node;
+  ++list->length;
+}
+
+void ilist_remove(ilist_t *list, ilist_node_t *node) {
+  assert(list != NULL);
+  assert(node != NULL);
+  assert(node != &list->head);
+  assert(node->next != NULL);
+  assert(list->length > 0);
+
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next = NULL;
+  node->prev = NULL;
+  --list->length;
+}
+
+void ilist_clear(ilist_t *list) {
+  assert(list != NULL);
+
+  for (ilist_node_t *node = list->head.next; node != &list->head; ) {
+    ilist_node_t *next = node->next;
+    node->next = NULL;
+    node->prev = NULL;
+    node = next;
+  }
+  ilist_init(list);
+}
+
+ilist_node_t *ilist_begin(const ilist_t *list) {
+  assert(list != NULL);
+
+  return list->head.next;
+}
+
+ilist_node_t *ilist_end(const ilist_t *list) {
+  assert(list != NULL);
+
+  return (ilist_node_t *)&list->head;
+}
+
+ilist_node_t *ilist_next(const ilist_node_t *node) {
+  assert(node != NULL);
+
+  return node->next;
+}
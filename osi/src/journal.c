@@ -0,0 +1,247 @@
+#define LOG_TAG "bt_osi_journal"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include "journal.h"
+
+// On-disk frame of a record. The payload follows immediately.
+typedef struct {
+  uint32_t length;
+  uint32_t crc;
+} record_header_t;
+
+struct journal_t {
+  int fd;
+  size_t synced;      // bytes on disk, all of them intact records
+  uint8_t *pending;   // framed records waiting for |journal_sync|
+  size_t pending_len;
+  size_t pending_size;
+};
+
+static size_t journal_scan(int fd, journal_replay_cb callback, void *context, size_t *count);
+static bool read_all(int fd, void *buf, size_t len);
+static bool write_all(int fd, const void *buf, size_t len);
+static uint32_t crc32(const uint8_t *data, size_t len);
+
+journal_t *journal_open(const char *path) {
+  assert(path != NULL);
+
+  journal_t *journal = calloc(1, sizeof(journal_t));
+  if (!journal) {
+    ALOGE("%s unable to allocate memory for journal_t.", __func__);
+    return NULL;
+  }
+
+  journal->fd = open(path, O_RDWR | O_CREAT, 0660);
+  if (journal->fd == -1) {
+    ALOGE("%s unable to open file '%s': %s", __func__, path, strerror(errno));
+    free(journal);
+    return NULL;
+  }
+
+  struct stat st;
+  size_t valid = journal_scan(journal->fd, NULL, NULL, NULL);
+  if (fstat(journal->fd, &st) == 0 && (size_t)st.st_size != valid) {
+    ALOGW("%s dropping %zu bytes of torn or corrupt records from '%s'.", __func__, (size_t)st.st_size - valid, path);
+    if (ftruncate(journal->fd, valid) == -1 || fsync(journal->fd) == -1) {
+      ALOGE("%s unable to truncate '%s': %s", __func__, path, strerror(errno));
+      journal_close(journal);
+      return NULL;
+    }
+  }
+
+  if (lseek(journal->fd, valid, SEEK_SET) == -1) {
+    ALOGE("%s unable to seek in '%s': %s", __func__, path, strerror(errno));
+    journal_close(journal);
+    return NULL;
+  }
+
+  journal->synced = valid;
+  return journal;
+}
+
+void journal_close(journal_t *journal) {
+  if (!journal)
+    return;
+
+  close(journal->fd);
+  free(journal->pending);
+  free(journal);
+}
+
+bool journal_append(journal_t *journal, const void *record, size_t length) {
+  assert(journal != NULL);
+  assert(record != NULL);
+
+  if (length == 0 || length > JOURNAL_MAX_RECORD_SIZE)
+    return false;
+
+  size_t needed = journal->pending_len + sizeof(record_header_t) + length;
+  if (needed > journal->pending_size) {
+    size_t size = journal->pending_size ? journal->pending_size : 256;
+    while (size < needed)
+      size *= 2;
+    uint8_t *pending = realloc(journal->pending, size);
+    if (!pending) {
+      ALOGE("%s unable to allocate %zu bytes for pending records.", __func__, size);
+      return false;
+    }
+    journal->pending = pending;
+    journal->pending_size = size;
+  }
+
+  record_header_t header = {
+    .length = (uint32_t)length,
+    .crc = crc32(record, length),
+  };
+  memcpy(journal->pending + journal->pending_len, &header, sizeof(header));
+  memcpy(journal->pending + journal->pending_len + sizeof(header), record, length);
+  journal->pending_len = needed;
+  return true;
+}
+
+bool journal_sync(journal_t *journal) {
+  assert(journal != NULL);
+
+  if (journal->pending_len == 0)
+    return true;
+
+  if (!write_all(journal->fd, journal->pending, journal->pending_len) || fsync(journal->fd) == -1) {
+    ALOGE("%s unable to write %zu bytes: %s", __func__, journal->pending_len, strerror(errno));
+    // Don't leave a partial write behind; later records would be appended
+    // after it and never replayed.
+    if (ftruncate(journal->fd, journal->synced) == -1 || lseek(journal->fd, journal->synced, SEEK_SET) == -1)
+      ALOGE("%s unable to roll back: %s", __func__, strerror(errno));
+    return false;
+  }
+
+  journal->synced += journal->pending_len;
+  journal->pending_len = 0;
+  return true;
+}
+
+bool journal_reset(journal_t *journal) {
+  assert(journal != NULL);
+
+  journal->pending_len = 0;
+  if (ftruncate(journal->fd, 0) == -1 || lseek(journal->fd, 0, SEEK_SET) == -1 || fsync(journal->fd) == -1) {
+    ALOGE("%s unable to truncate journal: %s", __func__, strerror(errno));
+    return false;
+  }
+
+  journal->synced = 0;
+  return true;
+}
+
+size_t journal_size(const journal_t *journal) {
+  assert(journal != NULL);
+
+  return journal->synced + journal->pending_len;
+}
+
+size_t journal_replay(const char *path, journal_replay_cb callback, void *context) {
+  assert(path != NULL);
+  assert(callback != NULL);
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    if (errno != ENOENT)
+      ALOGE("%s unable to open file '%s': %s", __func__, path, strerror(errno));
+    return 0;
+  }
+
+  size_t count = 0;
+  journal_scan(fd, callback, context, &count);
+  close(fd);
+  return count;
+}
+
+// Walks the records in |fd| from the start, handing each intact one to
+// |callback| if it is not NULL. Returns the length of the intact prefix.
+static size_t journal_scan(int fd, journal_replay_cb callback, void *context, size_t *count) {
+  size_t offset = 0;
+  size_t records = 0;
+  size_t buf_size = 0;
+  uint8_t *buf = NULL;
+
+  if (lseek(fd, 0, SEEK_SET) == -1)
+    return 0;
+
+  for (;;) {
+    record_header_t header;
+    if (!read_all(fd, &header, sizeof(header)))
+      break;
+    if (header.length == 0 || header.length > JOURNAL_MAX_RECORD_SIZE)
+      break;
+
+    if (header.length > buf_size) {
+      uint8_t *grown = realloc(buf, header.length);
+      if (!grown) {
+        ALOGE("%s unable to allocate %u bytes for a record.", __func__, header.length);
+        break;
+      }
+      buf = grown;
+      buf_size = header.length;
+    }
+
+    if (!read_all(fd, buf, header.length) || crc32(buf, header.length) != header.crc)
+      break;
+
+    if (callback)
+      callback(buf, header.length, context);
+    offset += sizeof(header) + header.length;
+    ++records;
+  }
+
+  free(buf);
+  if (count)
+    *count = records;
+  return offset;
+}
+
+static bool read_all(int fd, void *buf, size_t len) {
+  uint8_t *p = buf;
+  while (len > 0) {
+    ssize_t ret = read(fd, p, len);
+    if (ret == -1 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return false;
+    p += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+static bool write_all(int fd, const void *buf, size_t len) {
+  const uint8_t *p = buf;
+  while (len > 0) {
+    ssize_t ret = write(fd, p, len);
+    if (ret == -1 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return false;
+    p += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+// CRC-32 (IEEE 802.3), bit at a time. Records are small and written rarely.
+static uint32_t crc32(const uint8_t *data, size_t len) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
@@ -20,45 +20,90 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
 #include <sys/eventfd.h>
-#include <sys/select.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 #include <utils/Log.h>
 
-#include "list.h"
+#include "ilist.h"
 #include "reactor.h"
 
 #if !defined(EFD_SEMAPHORE)
 #  define EFD_SEMAPHORE (1 << 0)
 #endif
 
+// Events collected by one |epoll_wait|.
+#define MAX_EVENTS 64
+
 struct reactor_t {
+  int epoll_fd;
   int event_fd;
-  list_t *objects;
+
+  // Protects everything below so |reactor_unregister| can strike an object
+  // from the batch being dispatched and wait for its callbacks to return.
+  pthread_mutex_t lock;
+  pthread_cond_t dispatch_done;
+  ilist_t objects;                 // registered objects.
+  struct epoll_event events[MAX_EVENTS];
+  int num_events;
+  pthread_t run_thread;            // valid while |num_events| is not 0.
+  reactor_object_t *dispatching;   // object whose callbacks are running.
+};
+
+struct reactor_timer_t {
+  reactor_t *reactor;
+  reactor_object_t object;
+  reactor_timer_cb callback;
+  void *context;
 };
 
-static reactor_status_t run_reactor(reactor_t *reactor, int iterations, struct timeval *tv);
+static reactor_status_t run_reactor(reactor_t *reactor, int iterations, int timeout_ms);
+static void timer_read_ready(void *context);
 
 reactor_t *reactor_new(void) {
   reactor_t *ret = (reactor_t *)calloc(1, sizeof(reactor_t));
   if (!ret)
     return NULL;
 
+  ret->epoll_fd = -1;
+  ret->event_fd = -1;
+
+  ret->epoll_fd = epoll_create(MAX_EVENTS);
+  if (ret->epoll_fd == -1) {
+    ALOGE("%s unable to create epoll instance: %s", __func__, strerror(errno));
+    goto error;
+  }
+
   ret->event_fd = eventfd(0, EFD_SEMAPHORE);
   if (ret->event_fd == -1) {
     ALOGE("%s unable to create eventfd: %s", __func__, strerror(errno));
     goto error;
   }
 
-  ret->objects = list_new(NULL);
-  if (!ret->objects)
+  // The stop event is the only one whose data is the reactor itself.
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.ptr = ret;
+  if (epoll_ctl(ret->epoll_fd, EPOLL_CTL_ADD, ret->event_fd, &event) == -1) {
+    ALOGE("%s unable to register eventfd with epoll set: %s", __func__, strerror(errno));
     goto error;
+  }
 
+  pthread_mutex_init(&ret->lock, NULL);
+  pthread_cond_init(&ret->dispatch_done, NULL);
+  ilist_init(&ret->objects);
   return ret;
 
 error:;
-  list_free(ret->objects);
-  close(ret->event_fd);
+  if (ret->epoll_fd != -1)
+    close(ret->epoll_fd);
+  if (ret->event_fd != -1)
+    close(ret->event_fd);
   free(ret);
   return NULL;
 }
@@ -67,28 +112,27 @@ void reactor_free(reactor_t *reactor) {
   if (!reactor)
     return;
 
-  list_free(reactor->objects);
+  // Objects still registered are left alone; they may have gone out of scope.
+  pthread_cond_destroy(&reactor->dispatch_done);
+  pthread_mutex_destroy(&reactor->lock);
   close(reactor->event_fd);
+  close(reactor->epoll_fd);
   free(reactor);
 }
 
 reactor_status_t reactor_start(reactor_t *reactor) {
   assert(reactor != NULL);
-  return run_reactor(reactor, 0, NULL);
+  return run_reactor(reactor, 0, -1);
 }
 
 reactor_status_t reactor_run_once(reactor_t *reactor) {
   assert(reactor != NULL);
-  return run_reactor(reactor, 1, NULL);
+  return run_reactor(reactor, 1, -1);
 }
 
 reactor_status_t reactor_run_once_timeout(reactor_t *reactor, timeout_t timeout_ms) {
   assert(reactor != NULL);
-
-  struct timeval tv;
-  tv.tv_sec = timeout_ms / 1000;
-  tv.tv_usec = (timeout_ms % 1000) * 1000;
-  return run_reactor(reactor, 1, &tv);
+  return run_reactor(reactor, 1, timeout_ms > INT32_MAX ? INT32_MAX : (int)timeout_ms);
 }
 
 void reactor_stop(reactor_t *reactor) {
@@ -101,74 +145,203 @@ void reactor_register(reactor_t *reactor, reactor_object_t *obj) {
   assert(reactor != NULL);
   assert(obj != NULL);
 
-  list_append(reactor->objects, obj);
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  if (obj->interest & REACTOR_INTEREST_READ)
+    event.events |= (EPOLLIN | EPOLLRDHUP);
+  if (obj->interest & REACTOR_INTEREST_WRITE)
+    event.events |= EPOLLOUT;
+  if (obj->interest & REACTOR_INTEREST_EDGE)
+    event.events |= EPOLLET;
+  event.data.ptr = obj;
+
+  if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, obj->fd, &event) == -1) {
+    ALOGE("%s unable to register fd %d to epoll set: %s", __func__, obj->fd, strerror(errno));
+    ilist_node_init(&obj->node);
+    return;
+  }
+
+  pthread_mutex_lock(&reactor->lock);
+  ilist_append(&reactor->objects, &obj->node);
+  pthread_mutex_unlock(&reactor->lock);
 }
 
 void reactor_unregister(reactor_t *reactor, reactor_object_t *obj) {
   assert(reactor != NULL);
   assert(obj != NULL);
 
-  list_remove(reactor->objects, obj);
+  pthread_mutex_lock(&reactor->lock);
+
+  // The fd of an object already unregistered may have been reused by another
+  // object, so it must not be removed from the epoll set again.
+  if (!ilist_node_is_linked(&obj->node)) {
+    pthread_mutex_unlock(&reactor->lock);
+    return;
+  }
+  ilist_remove(&reactor->objects, &obj->node);
+
+  if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, obj->fd, NULL) == -1)
+    ALOGE("%s unable to unregister fd %d from epoll set: %s", __func__, obj->fd, strerror(errno));
+
+  // Events for |obj| may already have been collected; make sure they are not
+  // dispatched.
+  for (int i = 0; i < reactor->num_events; ++i)
+    if (reactor->events[i].data.ptr == obj)
+      reactor->events[i].data.ptr = NULL;
+
+  // Wait for callbacks of |obj| running on the reactor thread, unless this
+  // is the reactor thread and one of them is unregistering it.
+  while (reactor->dispatching == obj && !pthread_equal(reactor->run_thread, pthread_self()))
+    pthread_cond_wait(&reactor->dispatch_done, &reactor->lock);
+
+  pthread_mutex_unlock(&reactor->lock);
+}
+
+reactor_timer_t *reactor_timer_new(reactor_t *reactor, reactor_timer_cb callback, void *context) {
+  assert(reactor != NULL);
+  assert(callback != NULL);
+
+  reactor_timer_t *timer = (reactor_timer_t *)calloc(1, sizeof(reactor_timer_t));
+  if (!timer) {
+    ALOGE("%s unable to allocate memory for timer.", __func__);
+    return NULL;
+  }
+
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+  if (fd == -1) {
+    ALOGE("%s unable to create timerfd: %s", __func__, strerror(errno));
+    free(timer);
+    return NULL;
+  }
+
+  timer->reactor = reactor;
+  timer->callback = callback;
+  timer->context = context;
+  timer->object.context = timer;
+  timer->object.fd = fd;
+  timer->object.interest = REACTOR_INTEREST_READ;
+  timer->object.read_ready = timer_read_ready;
+  reactor_register(reactor, &timer->object);
+  return timer;
+}
+
+void reactor_timer_free(reactor_timer_t *timer) {
+  if (!timer)
+    return;
+
+  reactor_unregister(timer->reactor, &timer->object);
+  close(timer->object.fd);
+  free(timer);
 }
 
-// Runs the reactor loop for a maximum of |iterations| with the given timeout, |tv|.
-// 0 |iterations| means loop forever.
-// NULL |tv| means no timeout (block until an event occurs).
+void reactor_timer_set(reactor_timer_t *timer, timeout_t deadline_ms, timeout_t period_ms) {
+  assert(timer != NULL);
+
+  // A zero |it_value| disarms a timerfd; expire as soon as possible instead.
+  struct itimerspec spec;
+  spec.it_value.tv_sec = deadline_ms / 1000;
+  spec.it_value.tv_nsec = deadline_ms ? (deadline_ms % 1000) * 1000000L : 1;
+  spec.it_interval.tv_sec = period_ms / 1000;
+  spec.it_interval.tv_nsec = (period_ms % 1000) * 1000000L;
+
+  if (timerfd_settime(timer->object.fd, 0, &spec, NULL) == -1)
+    ALOGE("%s unable to set timer: %s", __func__, strerror(errno));
+}
+
+void reactor_timer_cancel(reactor_timer_t *timer) {
+  assert(timer != NULL);
+
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  if (timerfd_settime(timer->object.fd, 0, &spec, NULL) == -1)
+    ALOGE("%s unable to cancel timer: %s", __func__, strerror(errno));
+
+  // Disarming does not clear an expiry already counted; |timer_read_ready|
+  // skips the callback when there is nothing left to read.
+  uint64_t expirations;
+  while (read(timer->object.fd, &expirations, sizeof(expirations)) == -1 && errno == EINTR);
+}
+
+// Runs the reactor loop for a maximum of |iterations|, waiting at most
+// |timeout_ms| for each. 0 |iterations| means loop forever.
+// -1 |timeout_ms| means no timeout (block until an event occurs).
 // |reactor| may not be NULL.
-static reactor_status_t run_reactor(reactor_t *reactor, int iterations, struct timeval *tv) {
+static reactor_status_t run_reactor(reactor_t *reactor, int iterations, int timeout_ms) {
   assert(reactor != NULL);
 
   for (int i = 0; iterations == 0 || i < iterations; ++i) {
-    fd_set read_set;
-    fd_set write_set;
-    FD_ZERO(&read_set);
-    FD_ZERO(&write_set);
-    FD_SET(reactor->event_fd, &read_set);
-
-    int max_fd = reactor->event_fd;
-    for (const list_node_t *iter = list_begin(reactor->objects); iter != list_end(reactor->objects); iter = list_next(iter)) {
-      reactor_object_t *object = (reactor_object_t *)list_node(iter);
-      int fd = object->fd;
-      reactor_interest_t interest = object->interest;
-      if (interest & REACTOR_INTEREST_READ)
-        FD_SET(fd, &read_set);
-      if (interest & REACTOR_INTEREST_WRITE)
-        FD_SET(fd, &write_set);
-      if (fd > max_fd)
-        max_fd = fd;
-    }
-
+    // |num_events| is 0 here, so |reactor_unregister| leaves |events| alone.
     int ret;
     do {
-      ret = select(max_fd + 1, &read_set, &write_set, NULL, tv);
+      ret = epoll_wait(reactor->epoll_fd, reactor->events, MAX_EVENTS, timeout_ms);
     } while (ret == -1 && errno == EINTR);
 
     if (ret == -1) {
-      ALOGE("%s error in select: %s", __func__, strerror(errno));
+      ALOGE("%s error in epoll_wait: %s", __func__, strerror(errno));
       return REACTOR_STATUS_ERROR;
     }
 
     if (ret == 0)
       return REACTOR_STATUS_TIMEOUT;
 
-    if (FD_ISSET(reactor->event_fd, &read_set)) {
-      eventfd_t value;
-      eventfd_read(reactor->event_fd, &value);
-      return REACTOR_STATUS_STOP;
+    for (int j = 0; j < ret; ++j) {
+      if (reactor->events[j].data.ptr == reactor) {
+        eventfd_t value;
+        eventfd_read(reactor->event_fd, &value);
+        return REACTOR_STATUS_STOP;
+      }
     }
 
-    for (const list_node_t *iter = list_begin(reactor->objects); ret > 0 && iter != list_end(reactor->objects); iter = list_next(iter)) {
-      reactor_object_t *object = (reactor_object_t *)list_node(iter);
-      int fd = object->fd;
-      if (FD_ISSET(fd, &read_set)) {
+    pthread_mutex_lock(&reactor->lock);
+    reactor->num_events = ret;
+    reactor->run_thread = pthread_self();
+    pthread_mutex_unlock(&reactor->lock);
+
+    for (int j = 0; j < ret; ++j) {
+      pthread_mutex_lock(&reactor->lock);
+      reactor_object_t *object = (reactor_object_t *)reactor->events[j].data.ptr;
+      uint32_t revents = reactor->events[j].events;
+      reactor->dispatching = object;
+      pthread_mutex_unlock(&reactor->lock);
+
+      if (!object)
+        continue;
+
+      if ((revents & (EPOLLIN | EPOLLHUP | EPOLLRDHUP | EPOLLERR)) && (object->interest & REACTOR_INTEREST_READ))
         object->read_ready(object->context);
-        --ret;
-      }
-      if (FD_ISSET(fd, &write_set)) {
+
+      // The read callback may have unregistered the object.
+      pthread_mutex_lock(&reactor->lock);
+      object = (reactor_object_t *)reactor->events[j].data.ptr;
+      pthread_mutex_unlock(&reactor->lock);
+
+      if (object && (revents & (EPOLLOUT | EPOLLERR)) && (object->interest & REACTOR_INTEREST_WRITE))
         object->write_ready(object->context);
-        --ret;
-      }
+
+      pthread_mutex_lock(&reactor->lock);
+      reactor->dispatching = NULL;
+      pthread_cond_broadcast(&reactor->dispatch_done);
+      pthread_mutex_unlock(&reactor->lock);
     }
+
+    pthread_mutex_lock(&reactor->lock);
+    reactor->num_events = 0;
+    pthread_mutex_unlock(&reactor->lock);
   }
+
   return REACTOR_STATUS_DONE;
 }
+
+static void timer_read_ready(void *context) {
+  assert(context != NULL);
+
+  reactor_timer_t *timer = (reactor_timer_t *)context;
+  uint64_t expirations;
+  ssize_t ret;
+  do {
+    ret = read(timer->object.fd, &expirations, sizeof(expirations));
+  } while (ret == -1 && errno == EINTR);
+
+  if (ret == sizeof(expirations))
+    timer->callback(timer->context);
+}
@@ -186,6 +186,7 @@ static void *run_thread(void *start_arg) {
 
   reactor_register(thread->reactor, &work_queue_object);
   reactor_start(thread->reactor);
+  reactor_unregister(thread->reactor, &work_queue_object);
 
   // Make sure we dispatch all queued work items before exiting the thread.
   // This allows a caller to safely tear down by enqueuing a teardown
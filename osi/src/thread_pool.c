@@ -0,0 +1,455 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_thread_pool"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+#include "thread_pool.h"
+
+// Each deque has its own lock, so the owner and a thief only contend when
+// they meet on the same deque. Workers that find nothing to do sleep on the
+// pool's condition variable; |pending| counts tasks that are in a deque and
+// |sleepers| the workers waiting, so posting only takes the pool lock when a
+// worker has to be woken.
+
+typedef struct {
+  thread_fn func;
+  void *context;
+  thread_pool_group_t *group;
+} task_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  task_t **tasks;     // ring buffer.
+  size_t capacity;    // a power of two.
+  size_t top;         // thieves take from here.
+  size_t bottom;      // the owner pushes and takes here.
+} deque_t;
+
+typedef struct {
+  thread_pool_t *pool;
+  pthread_t pthread;
+  size_t index;
+  deque_t deques[THREAD_POOL_PRIORITY_COUNT];
+} worker_t;
+
+struct thread_pool_t {
+  char name[THREAD_NAME_MAX + 1];
+  worker_t *workers;
+  size_t num_workers;
+  pthread_key_t worker_key;   // the worker_t of the calling thread, if any.
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool stopping;
+  volatile int pending;
+  volatile int sleepers;
+  volatile unsigned int next_worker;
+};
+
+struct thread_pool_group_t {
+  thread_pool_t *pool;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int outstanding;
+};
+
+static const size_t INITIAL_DEQUE_CAPACITY = 32;
+
+// How long a joiner with nothing to run sleeps before looking for work again.
+// Tasks forked by the tasks it waits for may only be reachable by it.
+static const long JOIN_POLL_NS = 1000000L;
+
+static bool deque_init(deque_t *deque);
+static void deque_cleanup(deque_t *deque);
+static bool deque_push(deque_t *deque, task_t *task);
+static task_t *deque_pop(deque_t *deque);
+static task_t *deque_steal(deque_t *deque);
+
+static bool post_task(thread_pool_t *pool, task_t *task, thread_pool_priority_t priority);
+static task_t *find_task(thread_pool_t *pool, worker_t *self);
+static void run_task(thread_pool_t *pool, task_t *task);
+static void *run_worker(void *context);
+static void stop_workers(thread_pool_t *pool, size_t num_started);
+
+thread_pool_t *thread_pool_new(const char *name, size_t num_threads) {
+  assert(name != NULL);
+
+  if (num_threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = cpus > 0 ? (size_t)cpus : 1;
+  }
+  if (num_threads > THREAD_POOL_MAX_THREADS)
+    num_threads = THREAD_POOL_MAX_THREADS;
+
+  thread_pool_t *pool = calloc(1, sizeof(thread_pool_t));
+  if (!pool) {
+    ALOGE("%s unable to allocate memory for pool.", __func__);
+    return NULL;
+  }
+
+  pool->workers = calloc(num_threads, sizeof(worker_t));
+  if (!pool->workers) {
+    ALOGE("%s unable to allocate memory for workers.", __func__);
+    free(pool);
+    return NULL;
+  }
+
+  strncpy(pool->name, name, THREAD_NAME_MAX);
+  pool->num_workers = num_threads;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+  pthread_key_create(&pool->worker_key, NULL);
+
+  // Every deque must exist before the first worker starts stealing.
+  bool ok = true;
+  for (size_t i = 0; i < num_threads; ++i) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+    for (int j = 0; j < THREAD_POOL_PRIORITY_COUNT; ++j)
+      ok = deque_init(&pool->workers[i].deques[j]) && ok;
+  }
+
+  size_t num_started = 0;
+  int error = ok ? 0 : ENOMEM;
+  while (!error && num_started < num_threads) {
+    error = pthread_create(&pool->workers[num_started].pthread, NULL, run_worker, &pool->workers[num_started]);
+    if (!error)
+      ++num_started;
+  }
+
+  if (error) {
+    ALOGE("%s unable to start worker %zu: %s", __func__, num_started, strerror(error));
+    stop_workers(pool, num_started);
+    return NULL;
+  }
+
+  return pool;
+}
+
+void thread_pool_free(thread_pool_t *pool) {
+  if (!pool)
+    return;
+
+  assert(pthread_getspecific(pool->worker_key) == NULL);
+  stop_workers(pool, pool->num_workers);
+}
+
+size_t thread_pool_size(const thread_pool_t *pool) {
+  assert(pool != NULL);
+
+  return pool->num_workers;
+}
+
+bool thread_pool_post(thread_pool_t *pool, thread_fn func, void *context, thread_pool_priority_t priority) {
+  assert(pool != NULL);
+  assert(func != NULL);
+  assert(priority < THREAD_POOL_PRIORITY_COUNT);
+
+  task_t *task = malloc(sizeof(task_t));
+  if (!task) {
+    ALOGE("%s unable to allocate memory for task.", __func__);
+    return false;
+  }
+
+  task->func = func;
+  task->context = context;
+  task->group = NULL;
+  if (!post_task(pool, task, priority)) {
+    free(task);
+    return false;
+  }
+  return true;
+}
+
+thread_pool_group_t *thread_pool_group_new(thread_pool_t *pool) {
+  assert(pool != NULL);
+
+  thread_pool_group_t *group = calloc(1, sizeof(thread_pool_group_t));
+  if (!group) {
+    ALOGE("%s unable to allocate memory for group.", __func__);
+    return NULL;
+  }
+
+  group->pool = pool;
+  pthread_mutex_init(&group->lock, NULL);
+  pthread_cond_init(&group->cond, NULL);
+  return group;
+}
+
+void thread_pool_group_free(thread_pool_group_t *group) {
+  if (!group)
+    return;
+
+  assert(group->outstanding == 0);
+  pthread_cond_destroy(&group->cond);
+  pthread_mutex_destroy(&group->lock);
+  free(group);
+}
+
+bool thread_pool_group_fork(thread_pool_group_t *group, thread_fn func, void *context, thread_pool_priority_t priority) {
+  assert(group != NULL);
+  assert(func != NULL);
+  assert(priority < THREAD_POOL_PRIORITY_COUNT);
+
+  task_t *task = malloc(sizeof(task_t));
+  if (!task) {
+    ALOGE("%s unable to allocate memory for task.", __func__);
+    return false;
+  }
+
+  task->func = func;
+  task->context = context;
+  task->group = group;
+
+  pthread_mutex_lock(&group->lock);
+  ++group->outstanding;
+  pthread_mutex_unlock(&group->lock);
+
+  if (!post_task(group->pool, task, priority)) {
+    pthread_mutex_lock(&group->lock);
+    --group->outstanding;
+    pthread_mutex_unlock(&group->lock);
+    free(task);
+    return false;
+  }
+  return true;
+}
+
+void thread_pool_group_join(thread_pool_group_t *group) {
+  assert(group != NULL);
+
+  thread_pool_t *pool = group->pool;
+  worker_t *self = pthread_getspecific(pool->worker_key);
+
+  pthread_mutex_lock(&group->lock);
+  while (group->outstanding > 0) {
+    pthread_mutex_unlock(&group->lock);
+
+    task_t *task = find_task(pool, self);
+    if (task) {
+      run_task(pool, task);
+      pthread_mutex_lock(&group->lock);
+      continue;
+    }
+
+    pthread_mutex_lock(&group->lock);
+    if (group->outstanding > 0) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += JOIN_POLL_NS;
+      if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_nsec -= 1000000000L;
+        ++deadline.tv_sec;
+      }
+      pthread_cond_timedwait(&group->cond, &group->lock, &deadline);
+    }
+  }
+  pthread_mutex_unlock(&group->lock);
+}
+
+static bool deque_init(deque_t *deque) {
+  deque->tasks = calloc(INITIAL_DEQUE_CAPACITY, sizeof(task_t *));
+  deque->capacity = INITIAL_DEQUE_CAPACITY;
+  deque->top = 0;
+  deque->bottom = 0;
+  pthread_mutex_init(&deque->lock, NULL);
+  return (deque->tasks != NULL);
+}
+
+static void deque_cleanup(deque_t *deque) {
+  assert(deque->top == deque->bottom);
+
+  pthread_mutex_destroy(&deque->lock);
+  free(deque->tasks);
+  deque->tasks = NULL;
+}
+
+static bool deque_push(deque_t *deque, task_t *task) {
+  pthread_mutex_lock(&deque->lock);
+
+  if (deque->bottom - deque->top == deque->capacity) {
+    size_t capacity = deque->capacity * 2;
+    task_t **tasks = malloc(capacity * sizeof(task_t *));
+    if (!tasks) {
+      pthread_mutex_unlock(&deque->lock);
+      return false;
+    }
+
+    for (size_t i = deque->top; i != deque->bottom; ++i)
+      tasks[i & (capacity - 1)] = deque->tasks[i & (deque->capacity - 1)];
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->capacity = capacity;
+  }
+
+  deque->tasks[deque->bottom & (deque->capacity - 1)] = task;
+  ++deque->bottom;
+  pthread_mutex_unlock(&deque->lock);
+  return true;
+}
+
+static task_t *deque_pop(deque_t *deque) {
+  task_t *task = NULL;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom != deque->top) {
+    --deque->bottom;
+    task = deque->tasks[deque->bottom & (deque->capacity - 1)];
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return task;
+}
+
+static task_t *deque_steal(deque_t *deque) {
+  task_t *task = NULL;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom != deque->top) {
+    task = deque->tasks[deque->top & (deque->capacity - 1)];
+    ++deque->top;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return task;
+}
+
+static bool post_task(thread_pool_t *pool, task_t *task, thread_pool_priority_t priority) {
+  worker_t *target = pthread_getspecific(pool->worker_key);
+  if (!target)
+    target = &pool->workers[__sync_fetch_and_add(&pool->next_worker, 1) % pool->num_workers];
+
+  if (!deque_push(&target->deques[priority], task)) {
+    ALOGE("%s unable to grow the deque of worker %zu.", __func__, target->index);
+    return false;
+  }
+
+  // Pairs with the sleeper count in |run_worker|: either the worker sees the
+  // task as pending or we see it as sleeping and wake it.
+  __sync_fetch_and_add(&pool->pending, 1);
+  if (__sync_fetch_and_add(&pool->sleepers, 0) > 0) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+  }
+  return true;
+}
+
+// Takes the most urgent task reachable from |self|, which is NULL on threads
+// outside the pool: its own deque first, then the others', one priority at a
+// time.
+static task_t *find_task(thread_pool_t *pool, worker_t *self) {
+  size_t start = self ? self->index : 0;
+
+  for (int priority = 0; priority < THREAD_POOL_PRIORITY_COUNT; ++priority) {
+    if (self) {
+      task_t *task = deque_pop(&self->deques[priority]);
+      if (task)
+        return task;
+    }
+
+    for (size_t i = self ? 1 : 0; i < pool->num_workers; ++i) {
+      worker_t *victim = &pool->workers[(start + i) % pool->num_workers];
+      task_t *task = deque_steal(&victim->deques[priority]);
+      if (task)
+        return task;
+    }
+  }
+
+  return NULL;
+}
+
+static void run_task(thread_pool_t *pool, task_t *task) {
+  __sync_fetch_and_sub(&pool->pending, 1);
+  task->func(task->context);
+
+  thread_pool_group_t *group = task->group;
+  free(task);
+
+  if (group) {
+    pthread_mutex_lock(&group->lock);
+    if (--group->outstanding == 0)
+      pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->lock);
+  }
+}
+
+static void *run_worker(void *context) {
+  worker_t *worker = (worker_t *)context;
+  thread_pool_t *pool = worker->pool;
+
+  // Like thread.c, names are cut to THREAD_NAME_MAX bytes.
+  char name[THREAD_NAME_MAX + 24];
+  snprintf(name, sizeof(name), "%s_%zu", pool->name, worker->index);
+  name[THREAD_NAME_MAX] = '\0';
+  if (prctl(PR_SET_NAME, (unsigned long)name) == -1)
+    ALOGE("%s unable to set thread name: %s", __func__, strerror(errno));
+  pthread_setspecific(pool->worker_key, worker);
+
+  for (;;) {
+    task_t *task = find_task(pool, worker);
+    if (task) {
+      run_task(pool, task);
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    __sync_fetch_and_add(&pool->sleepers, 1);
+    while (__sync_fetch_and_add(&pool->pending, 0) == 0 && !pool->stopping)
+      pthread_cond_wait(&pool->cond, &pool->lock);
+    __sync_fetch_and_sub(&pool->sleepers, 1);
+    bool done = pool->stopping && __sync_fetch_and_add(&pool->pending, 0) == 0;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (done)
+      break;
+  }
+
+  return NULL;
+}
+
+// Lets the first |num_started| workers drain the pool and exit, then frees
+// everything.
+static void stop_workers(thread_pool_t *pool, size_t num_started) {
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i < num_started; ++i)
+    pthread_join(pool->workers[i].pthread, NULL);
+
+  for (size_t i = 0; i < pool->num_workers; ++i)
+    for (int j = 0; j < THREAD_POOL_PRIORITY_COUNT; ++j)
+      deque_cleanup(&pool->workers[i].deques[j]);
+
+  pthread_key_delete(pool->worker_key);
+  pthread_cond_destroy(&pool->cond);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->workers);
+  free(pool);
+}
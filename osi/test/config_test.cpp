@@ -1,10 +1,16 @@
 #include <gtest/gtest.h>
 
 extern "C" {
+#include <stdio.h>
+#include <time.h>
+
 #include "config.h"
 }
 
 static const char CONFIG_FILE[] = "/data/local/tmp/config_test.conf";
+static const char CONFIG_LARGE_FILE[] = "/data/local/tmp/config_test_large.conf";
+static const int LARGE_SECTIONS = 500;
+static const int LARGE_KEYS = 20;
 static const char CONFIG_FILE_CONTENT[] =
 "                                                                                    \n\
 first_key=value                                                                      \n\
@@ -111,3 +117,149 @@ TEST_F(ConfigTest, config_get_int_default) {
   EXPECT_EQ(config_get_int(config, "DID", "primaryRecord", 123), 123);
   config_free(config);
 }
+
+TEST_F(ConfigTest, config_get_bool) {
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_TRUE(config_get_bool(config, "DID", "primaryRecord", false));
+  EXPECT_FALSE(config_get_bool(config, "DID", "version", false));
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_set_new_key) {
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_FALSE(config_has_section(config, "NEW"));
+  config_set_int(config, "NEW", "key", 42);
+  config_set_bool(config, "NEW", "flag", true);
+  EXPECT_TRUE(config_has_section(config, "NEW"));
+  EXPECT_EQ(config_get_int(config, "NEW", "key", 0), 42);
+  EXPECT_TRUE(config_get_bool(config, "NEW", "flag", false));
+  EXPECT_FALSE(config_has_key(config, "DID", "key"));
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_set_overwrites) {
+  config_t *config = config_new(CONFIG_FILE);
+  const char *old_value = config_get_string(config, "DID", "productId", NULL);
+  config_set_string(config, "DID", "productId", "0x1300");
+  EXPECT_STREQ(config_get_string(config, "DID", "productId", NULL), "0x1300");
+  EXPECT_STREQ(old_value, "0x1200");
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_empty_file) {
+  FILE *fp = fopen(CONFIG_FILE, "wt");
+  fclose(fp);
+
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_TRUE(config != NULL);
+  EXPECT_FALSE(config_has_section(config, CONFIG_DEFAULT_SECTION));
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_no_trailing_newline) {
+  FILE *fp = fopen(CONFIG_FILE, "wt");
+  fputs("[A]\nkey = last", fp);
+  fclose(fp);
+
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_STREQ(config_get_string(config, "A", "key", NULL), "last");
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_long_line) {
+  char value[4096 * 3];
+  memset(value, 'x', sizeof(value) - 1);
+  value[sizeof(value) - 1] = '\0';
+
+  FILE *fp = fopen(CONFIG_FILE, "wt");
+  fprintf(fp, "[A]\nlong = %s\nshort = 1\n", value);
+  fclose(fp);
+
+  config_t *config = config_new(CONFIG_FILE);
+  EXPECT_STREQ(config_get_string(config, "A", "long", NULL), value);
+  EXPECT_EQ(config_get_int(config, "A", "short", 0), 1);
+  config_free(config);
+}
+
+static void write_large_config(void) {
+  FILE *fp = fopen(CONFIG_LARGE_FILE, "wt");
+  for (int i = 0; i < LARGE_SECTIONS; ++i) {
+    fprintf(fp, "# Device %d\n[%02x:%02x:00:00:00:00]\n", i, i >> 8, i & 0xff);
+    for (int j = 0; j < LARGE_KEYS; ++j)
+      fprintf(fp, "Key%d = %d\n", j, i * LARGE_KEYS + j);
+  }
+  fclose(fp);
+}
+
+TEST_F(ConfigTest, config_large) {
+  write_large_config();
+
+  config_t *config = config_new(CONFIG_LARGE_FILE);
+  ASSERT_TRUE(config != NULL);
+  for (int i = 0; i < LARGE_SECTIONS; ++i) {
+    char section[32];
+    char key[16];
+    sprintf(section, "%02x:%02x:00:00:00:00", i >> 8, i & 0xff);
+    for (int j = 0; j < LARGE_KEYS; ++j) {
+      sprintf(key, "Key%d", j);
+      EXPECT_EQ(config_get_int(config, section, key, -1), i * LARGE_KEYS + j);
+    }
+  }
+  config_free(config);
+}
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// Reports parse and lookup times; timings vary too much between devices to
+// assert on, so this only checks that every lookup succeeds.
+TEST_F(ConfigTest, config_benchmark) {
+  static const int ITERATIONS = 1000;
+  write_large_config();
+
+  uint64_t start = now_us();
+  for (int i = 0; i < ITERATIONS; ++i)
+    config_free(config_new(CONFIG_FILE));
+  uint64_t small_parse = now_us() - start;
+
+  start = now_us();
+  for (int i = 0; i < ITERATIONS / 100; ++i)
+    config_free(config_new(CONFIG_LARGE_FILE));
+  uint64_t large_parse = now_us() - start;
+
+  config_t *config = config_new(CONFIG_FILE);
+  int found = 0;
+  start = now_us();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    found += config_has_key(config, "DID", "recordNumber");
+    found += config_has_key(config, "DID", "version");
+    found += config_has_key(config, CONFIG_DEFAULT_SECTION, "first_key");
+  }
+  uint64_t small_lookup = now_us() - start;
+  config_free(config);
+  EXPECT_EQ(found, ITERATIONS * 3);
+
+  config = config_new(CONFIG_LARGE_FILE);
+  found = 0;
+  start = now_us();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    char section[32];
+    int n = i % LARGE_SECTIONS;
+    sprintf(section, "%02x:%02x:00:00:00:00", n >> 8, n & 0xff);
+    found += config_has_key(config, section, "Key0");
+    found += config_has_key(config, section, "Key19");
+  }
+  uint64_t large_lookup = now_us() - start;
+  config_free(config);
+  EXPECT_EQ(found, ITERATIONS * 2);
+
+  printf("config parse: small %llu us, %d sections x %d keys %llu us\n",
+         (unsigned long long)(small_parse / ITERATIONS), LARGE_SECTIONS, LARGE_KEYS,
+         (unsigned long long)(large_parse / (ITERATIONS / 100)));
+  printf("config lookup: small %llu ns, large %llu ns\n",
+         (unsigned long long)(small_lookup * 1000 / (ITERATIONS * 3)),
+         (unsigned long long)(large_lookup * 1000 / (ITERATIONS * 2)));
+}
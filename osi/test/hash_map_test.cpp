@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <stdio.h>
+#include <time.h>
+
+#include "hash_map.h"
+#include "list.h"
+#include "osi.h"
+}
+
+typedef struct {
+  int value;
+  hash_map_entry_t entry;
+} element_t;
+
+static bool count_cb(hash_map_entry_t *, void *context) {
+  ++*(size_t *)context;
+  return true;
+}
+
+static bool stop_cb(hash_map_entry_t *, void *context) {
+  ++*(size_t *)context;
+  return false;
+}
+
+TEST(HashMapTest, test_new_free) {
+  hash_map_t *map = hash_map_new(0, NULL, NULL);
+  ASSERT_TRUE(map != NULL);
+  EXPECT_TRUE(hash_map_is_empty(map));
+  EXPECT_EQ(hash_map_size(map), 0U);
+  hash_map_free(map);
+}
+
+TEST(HashMapTest, test_free_null) {
+  hash_map_free(NULL);
+}
+
+TEST(HashMapTest, test_insert_get_pointer_keys) {
+  element_t x[5];
+  hash_map_t *map = hash_map_new(ARRAY_SIZE(x), NULL, NULL);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    EXPECT_TRUE(hash_map_insert(map, &x[i], &x[i].entry));
+
+  EXPECT_EQ(hash_map_size(map), ARRAY_SIZE(x));
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i) {
+    hash_map_entry_t *entry = hash_map_get(map, &x[i]);
+    ASSERT_TRUE(entry != NULL);
+    EXPECT_EQ(HASH_MAP_ENTRY(entry, element_t, entry), &x[i]);
+  }
+
+  int y;
+  EXPECT_TRUE(hash_map_get(map, &y) == NULL);
+  hash_map_free(map);
+}
+
+TEST(HashMapTest, test_insert_duplicate) {
+  element_t x[2];
+  hash_map_t *map = hash_map_new(0, hash_map_string_hash, hash_map_string_equal);
+
+  char key1[] = "key";
+  char key2[] = "key";
+  EXPECT_TRUE(hash_map_insert(map, key1, &x[0].entry));
+  EXPECT_FALSE(hash_map_insert(map, key2, &x[1].entry));
+  EXPECT_EQ(hash_map_size(map), 1U);
+  EXPECT_EQ(hash_map_get(map, key2), &x[0].entry);
+  hash_map_free(map);
+}
+
+TEST(HashMapTest, test_grow) {
+  static const int COUNT = 1000;
+  element_t *x = (element_t *)calloc(COUNT, sizeof(element_t));
+  char (*keys)[16] = (char (*)[16])calloc(COUNT, 16);
+  hash_map_t *map = hash_map_new(1, hash_map_string_hash, hash_map_string_equal);
+
+  for (int i = 0; i < COUNT; ++i) {
+    sprintf(keys[i], "key%d", i);
+    x[i].value = i;
+    ASSERT_TRUE(hash_map_insert(map, keys[i], &x[i].entry));
+  }
+
+  EXPECT_EQ(hash_map_size(map), (size_t)COUNT);
+  for (int i = 0; i < COUNT; ++i) {
+    char key[16];
+    sprintf(key, "key%d", i);
+    hash_map_entry_t *entry = hash_map_get(map, key);
+    ASSERT_TRUE(entry != NULL);
+    EXPECT_EQ(HASH_MAP_ENTRY(entry, element_t, entry)->value, i);
+  }
+
+  hash_map_free(map);
+  free(keys);
+  free(x);
+}
+
+TEST(HashMapTest, test_remove) {
+  static const int COUNT = 200;
+  element_t x[COUNT];
+  hash_map_t *map = hash_map_new(COUNT, NULL, NULL);
+
+  for (int i = 0; i < COUNT; ++i)
+    hash_map_insert(map, &x[i], &x[i].entry);
+
+  // Removing every third entry shifts others back; they must stay reachable.
+  for (int i = 0; i < COUNT; i += 3)
+    hash_map_remove(map, &x[i].entry);
+
+  for (int i = 0; i < COUNT; ++i) {
+    if (i % 3)
+      EXPECT_EQ(hash_map_get(map, &x[i]), &x[i].entry);
+    else
+      EXPECT_TRUE(hash_map_get(map, &x[i]) == NULL);
+  }
+  EXPECT_EQ(hash_map_size(map), (size_t)(COUNT - (COUNT + 2) / 3));
+
+  for (int i = 0; i < COUNT; ++i)
+    if (i % 3)
+      hash_map_remove(map, &x[i].entry);
+  EXPECT_TRUE(hash_map_is_empty(map));
+
+  // Removed entries may be inserted again.
+  EXPECT_TRUE(hash_map_insert(map, &x[0], &x[0].entry));
+  EXPECT_EQ(hash_map_get(map, &x[0]), &x[0].entry);
+  hash_map_free(map);
+}
+
+TEST(HashMapTest, test_clear_and_foreach) {
+  element_t x[10];
+  hash_map_t *map = hash_map_new(0, NULL, NULL);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    hash_map_insert(map, &x[i], &x[i].entry);
+
+  size_t count = 0;
+  hash_map_foreach(map, count_cb, &count);
+  EXPECT_EQ(count, ARRAY_SIZE(x));
+
+  count = 0;
+  hash_map_foreach(map, stop_cb, &count);
+  EXPECT_EQ(count, 1U);
+
+  hash_map_clear(map);
+  EXPECT_TRUE(hash_map_is_empty(map));
+  count = 0;
+  hash_map_foreach(map, count_cb, &count);
+  EXPECT_EQ(count, 0U);
+  hash_map_free(map);
+}
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static bool find_cb(void *data, void *context) {
+  if (data == context)
+    ++*(int *)data;
+  return true;
+}
+
+// Compares lookup by pointer against a walk of list.h, the way code without
+// a map finds an element today. Times are printed rather than asserted since
+// they vary between devices.
+TEST(HashMapTest, test_benchmark_against_list) {
+  static const int COUNT = 256;
+  static const int ITERATIONS = 100;
+  element_t *x = (element_t *)calloc(COUNT, sizeof(element_t));
+
+  list_t *list = list_new(NULL);
+  for (int i = 0; i < COUNT; ++i)
+    list_append(list, &x[i]);
+
+  uint64_t start = now_us();
+  for (int i = 0; i < ITERATIONS; ++i)
+    for (int j = 0; j < COUNT; ++j)
+      list_foreach_ext(list, find_cb, &x[j]);
+  uint64_t list_time = now_us() - start;
+  list_free(list);
+
+  hash_map_t *map = hash_map_new(COUNT, NULL, NULL);
+  for (int i = 0; i < COUNT; ++i)
+    hash_map_insert(map, &x[i], &x[i].entry);
+
+  start = now_us();
+  for (int i = 0; i < ITERATIONS; ++i)
+    for (int j = 0; j < COUNT; ++j)
+      ++HASH_MAP_ENTRY(hash_map_get(map, &x[j]), element_t, entry)->value;
+  uint64_t map_time = now_us() - start;
+  hash_map_free(map);
+
+  for (int i = 0; i < COUNT; ++i)
+    EXPECT_EQ(x[i].value, ITERATIONS * 2);
+  free(x);
+
+  printf("lookup among %d elements: list %llu ns, hash_map %llu ns\n", COUNT,
+         (unsigned long long)(list_time * 1000 / (ITERATIONS * COUNT)),
+         (unsigned long long)(map_time * 1000 / (ITERATIONS * COUNT)));
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <stdio.h>
+#include <time.h>
+
+#include "ilist.h"
+#include "list.h"
+#include "osi.h"
+}
+
+typedef struct {
+  int value;
+  ilist_node_t node;
+} element_t;
+
+static ilist_node_t *node_at(const ilist_t *list, size_t index) {
+  ilist_node_t *node = ilist_begin(list);
+  while (index--)
+    node = ilist_next(node);
+  return node;
+}
+
+TEST(IlistTest, test_init_is_empty) {
+  ilist_t list;
+  ilist_init(&list);
+  EXPECT_TRUE(ilist_is_empty(&list));
+  EXPECT_EQ(ilist_length(&list), 0U);
+  EXPECT_TRUE(ilist_front(&list) == NULL);
+  EXPECT_TRUE(ilist_back(&list) == NULL);
+  EXPECT_EQ(ilist_begin(&list), ilist_end(&list));
+}
+
+TEST(IlistTest, test_initializer) {
+  ilist_t list = ILIST_INITIALIZER(list);
+  EXPECT_TRUE(ilist_is_empty(&list));
+  EXPECT_EQ(ilist_begin(&list), ilist_end(&list));
+}
+
+TEST(IlistTest, test_append_multiple) {
+  element_t x[5];
+  ilist_t list;
+  ilist_init(&list);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i) {
+    x[i].value = i;
+    ilist_append(&list, &x[i].node);
+  }
+
+  EXPECT_EQ(ilist_length(&list), ARRAY_SIZE(x));
+  EXPECT_EQ(ilist_front(&list), &x[0].node);
+  EXPECT_EQ(ilist_back(&list), &x[ARRAY_SIZE(x) - 1].node);
+
+  int i = 0;
+  for (const ilist_node_t *node = ilist_begin(&list); node != ilist_end(&list); node = ilist_next(node), ++i)
+    EXPECT_EQ(ILIST_ENTRY(node, element_t, node)->value, i);
+  EXPECT_EQ(i, (int)ARRAY_SIZE(x));
+}
+
+TEST(IlistTest, test_prepend_multiple) {
+  element_t x[5];
+  ilist_t list;
+  ilist_init(&list);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    ilist_prepend(&list, &x[i].node);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    EXPECT_EQ(node_at(&list, i), &x[ARRAY_SIZE(x) - 1 - i].node);
+}
+
+TEST(IlistTest, test_insert_after) {
+  element_t x[3];
+  ilist_t list;
+  ilist_init(&list);
+
+  ilist_append(&list, &x[0].node);
+  ilist_append(&list, &x[2].node);
+  ilist_insert_after(&list, &x[0].node, &x[1].node);
+
+  EXPECT_EQ(ilist_length(&list), 3U);
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    EXPECT_EQ(node_at(&list, i), &x[i].node);
+}
+
+TEST(IlistTest, test_remove_middle_and_ends) {
+  element_t x[5];
+  ilist_t list;
+  ilist_init(&list);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    ilist_append(&list, &x[i].node);
+
+  ilist_remove(&list, &x[2].node);
+  ilist_remove(&list, &x[0].node);
+  ilist_remove(&list, &x[4].node);
+
+  EXPECT_EQ(ilist_length(&list), 2U);
+  EXPECT_EQ(ilist_front(&list), &x[1].node);
+  EXPECT_EQ(ilist_back(&list), &x[3].node);
+  EXPECT_FALSE(ilist_node_is_linked(&x[2].node));
+  EXPECT_TRUE(ilist_node_is_linked(&x[1].node));
+}
+
+TEST(IlistTest, test_remove_while_iterating) {
+  element_t x[6];
+  ilist_t list;
+  ilist_init(&list);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i) {
+    x[i].value = i;
+    ilist_append(&list, &x[i].node);
+  }
+
+  for (ilist_node_t *node = ilist_begin(&list); node != ilist_end(&list); ) {
+    ilist_node_t *next = ilist_next(node);
+    if (ILIST_ENTRY(node, element_t, node)->value % 2)
+      ilist_remove(&list, node);
+    node = next;
+  }
+
+  EXPECT_EQ(ilist_length(&list), 3U);
+  for (size_t i = 0; i < 3; ++i)
+    EXPECT_EQ(node_at(&list, i), &x[i * 2].node);
+}
+
+TEST(IlistTest, test_clear) {
+  element_t x[5];
+  ilist_t list;
+  ilist_init(&list);
+
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    ilist_append(&list, &x[i].node);
+
+  ilist_clear(&list);
+  EXPECT_TRUE(ilist_is_empty(&list));
+  for (size_t i = 0; i < ARRAY_SIZE(x); ++i)
+    EXPECT_FALSE(ilist_node_is_linked(&x[i].node));
+
+  // Cleared nodes may be linked again.
+  ilist_append(&list, &x[3].node);
+  EXPECT_EQ(ilist_front(&list), &x[3].node);
+}
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// Compares append and remove against list.h with the access pattern of the
+// reactor: objects come and go from the middle of a short list. Times are
+// printed rather than asserted since they vary between devices.
+TEST(IlistTest, test_benchmark_against_list) {
+  static const int ITERATIONS = 10000;
+  element_t x[32];
+
+  list_t *list = list_new(NULL);
+  uint64_t start = now_us();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    for (size_t j = 0; j < ARRAY_SIZE(x); ++j)
+      list_append(list, &x[j]);
+    for (size_t j = 0; j < ARRAY_SIZE(x); ++j)
+      list_remove(list, &x[(j * 7) % ARRAY_SIZE(x)]);
+  }
+  uint64_t list_time = now_us() - start;
+  EXPECT_TRUE(list_is_empty(list));
+  list_free(list);
+
+  ilist_t ilist;
+  ilist_init(&ilist);
+  start = now_us();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    for (size_t j = 0; j < ARRAY_SIZE(x); ++j)
+      ilist_append(&ilist, &x[j].node);
+    for (size_t j = 0; j < ARRAY_SIZE(x); ++j)
+      ilist_remove(&ilist, &x[(j * 7) % ARRAY_SIZE(x)].node);
+  }
+  uint64_t ilist_time = now_us() - start;
+  EXPECT_TRUE(ilist_is_empty(&ilist));
+
+  printf("append+remove of %d elements: list %llu ns, ilist %llu ns\n", (int)ARRAY_SIZE(x),
+         (unsigned long long)(list_time * 1000 / ITERATIONS),
+         (unsigned long long)(ilist_time * 1000 / ITERATIONS));
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "journal.h"
+}
+
+static const char JOURNAL_FILE[] = "/data/local/tmp/journal_test.journal";
+
+static void collect(const void *record, size_t length, void *context) {
+  std::vector<std::string> *records = (std::vector<std::string> *)context;
+  records->push_back(std::string((const char *)record, length));
+}
+
+static std::vector<std::string> replay_all() {
+  std::vector<std::string> records;
+  journal_replay(JOURNAL_FILE, collect, &records);
+  return records;
+}
+
+static off_t file_size() {
+  struct stat st;
+  if (stat(JOURNAL_FILE, &st) == -1)
+    return -1;
+  return st.st_size;
+}
+
+static void append_str(journal_t *journal, const char *str) {
+  EXPECT_TRUE(journal_append(journal, str, strlen(str)));
+}
+
+class JournalTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      unlink(JOURNAL_FILE);
+    }
+
+    virtual void TearDown() {
+      unlink(JOURNAL_FILE);
+    }
+};
+
+TEST_F(JournalTest, journal_open) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  EXPECT_TRUE(journal != NULL);
+  EXPECT_EQ(journal_size(journal), 0U);
+  EXPECT_EQ(file_size(), 0);
+  journal_close(journal);
+}
+
+TEST_F(JournalTest, journal_open_bad_path) {
+  EXPECT_TRUE(journal_open("/meow/journal") == NULL);
+}
+
+TEST_F(JournalTest, journal_close_null) {
+  journal_close(NULL);
+}
+
+TEST_F(JournalTest, journal_replay_no_file) {
+  EXPECT_EQ(replay_all().size(), 0U);
+}
+
+TEST_F(JournalTest, journal_append_empty) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  EXPECT_FALSE(journal_append(journal, "", 0));
+  EXPECT_EQ(journal_size(journal), 0U);
+  journal_close(journal);
+}
+
+TEST_F(JournalTest, journal_append_too_large) {
+  std::vector<char> record(JOURNAL_MAX_RECORD_SIZE + 1, 'x');
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  EXPECT_FALSE(journal_append(journal, &record[0], record.size()));
+  EXPECT_TRUE(journal_append(journal, &record[0], JOURNAL_MAX_RECORD_SIZE));
+  journal_close(journal);
+}
+
+TEST_F(JournalTest, journal_append_buffers_until_sync) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "first");
+  append_str(journal, "second");
+  EXPECT_GT(journal_size(journal), 0U);
+  EXPECT_EQ(file_size(), 0);
+  EXPECT_EQ(replay_all().size(), 0U);
+
+  EXPECT_TRUE(journal_sync(journal));
+  EXPECT_EQ(file_size(), (off_t)journal_size(journal));
+  journal_close(journal);
+
+  std::vector<std::string> records = replay_all();
+  ASSERT_EQ(records.size(), 2U);
+  EXPECT_EQ(records[0], "first");
+  EXPECT_EQ(records[1], "second");
+}
+
+TEST_F(JournalTest, journal_close_drops_unsynced) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "synced");
+  journal_sync(journal);
+  append_str(journal, "lost");
+  journal_close(journal);
+
+  std::vector<std::string> records = replay_all();
+  ASSERT_EQ(records.size(), 1U);
+  EXPECT_EQ(records[0], "synced");
+}
+
+TEST_F(JournalTest, journal_reopen_appends) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "one");
+  journal_sync(journal);
+  journal_close(journal);
+
+  journal = journal_open(JOURNAL_FILE);
+  EXPECT_EQ(journal_size(journal), (size_t)file_size());
+  append_str(journal, "two");
+  journal_sync(journal);
+  journal_close(journal);
+
+  std::vector<std::string> records = replay_all();
+  ASSERT_EQ(records.size(), 2U);
+  EXPECT_EQ(records[0], "one");
+  EXPECT_EQ(records[1], "two");
+}
+
+TEST_F(JournalTest, journal_reset) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "old");
+  journal_sync(journal);
+  append_str(journal, "pending");
+  EXPECT_TRUE(journal_reset(journal));
+  EXPECT_EQ(journal_size(journal), 0U);
+  EXPECT_EQ(file_size(), 0);
+
+  append_str(journal, "new");
+  journal_sync(journal);
+  journal_close(journal);
+
+  std::vector<std::string> records = replay_all();
+  ASSERT_EQ(records.size(), 1U);
+  EXPECT_EQ(records[0], "new");
+}
+
+// Simulates a crash part way through writing the last record.
+TEST_F(JournalTest, journal_torn_tail) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "complete");
+  journal_sync(journal);
+  off_t intact = file_size();
+  append_str(journal, "torn record");
+  journal_sync(journal);
+  journal_close(journal);
+
+  ASSERT_EQ(truncate(JOURNAL_FILE, file_size() - 3), 0);
+  std::vector<std::string> records = replay_all();
+  ASSERT_EQ(records.size(), 1U);
+  EXPECT_EQ(records[0], "complete");
+
+  // Opening cuts the torn record off so new records replay after the intact ones.
+  journal = journal_open(JOURNAL_FILE);
+  EXPECT_EQ(file_size(), intact);
+  append_str(journal, "after crash");
+  journal_sync(journal);
+  journal_close(journal);
+
+  records = replay_all();
+  ASSERT_EQ(records.size(), 2U);
+  EXPECT_EQ(records[0], "complete");
+  EXPECT_EQ(records[1], "after crash");
+}
+
+// Simulates a crash that only got part of a record header out.
+TEST_F(JournalTest, journal_torn_header) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "complete");
+  journal_sync(journal);
+  off_t intact = file_size();
+  journal_close(journal);
+
+  FILE *fp = fopen(JOURNAL_FILE, "ab");
+  fwrite("\x05\x00", 1, 2, fp);
+  fclose(fp);
+
+  EXPECT_EQ(replay_all().size(), 1U);
+  journal = journal_open(JOURNAL_FILE);
+  EXPECT_EQ(file_size(), intact);
+  journal_close(journal);
+}
+
+TEST_F(JournalTest, journal_corrupt_record) {
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "good");
+  append_str(journal, "flipped");
+  append_str(journal, "unreachable");
+  journal_sync(journal);
+  journal_close(journal);
+
+  // Flip a byte in the payload of the second record.
+  FILE *fp = fopen(JOURNAL_FILE, "r+b");
+  std::string contents(file_size(), '\0');
+  ASSERT_EQ(fread(&contents[0], 1, contents.size(), fp), contents.size());
+  size_t pos = contents.find("flipped");
+  ASSERT_NE(pos, std::string::npos);
+  fseek(fp, pos, SEEK_SET);
+  fputc('F', fp);
+  fclose(fp);
+
+  std::vector<std::string> records = replay_all();
+  ASSERT_EQ(records.size(), 1U);
+  EXPECT_EQ(records[0], "good");
+
+  journal = journal_open(JOURNAL_FILE);
+  append_str(journal, "recovered");
+  journal_sync(journal);
+  journal_close(journal);
+
+  records = replay_all();
+  ASSERT_EQ(records.size(), 2U);
+  EXPECT_EQ(records[1], "recovered");
+}
+
+TEST_F(JournalTest, journal_replay_binary_records) {
+  const unsigned char binary[] = { 0x00, 0xff, 0x00, 0x10 };
+  journal_t *journal = journal_open(JOURNAL_FILE);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_TRUE(journal_append(journal, binary, sizeof(binary)));
+  journal_sync(journal);
+  journal_close(journal);
+
+  std::vector<std::string> records = replay_all();
+  ASSERT_EQ(records.size(), 100U);
+  EXPECT_EQ(records[99], std::string((const char *)binary, sizeof(binary)));
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include <pthread.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/select.h>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -35,6 +39,12 @@ static uint64_t get_timestamp(void) {
   return tv.tv_sec * 1000 + tv.tv_usec / 1000;
 }
 
+static uint64_t get_timestamp_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
 TEST(ReactorTest, reactor_new) {
   reactor_t *reactor = reactor_new();
   EXPECT_TRUE(reactor != NULL);
@@ -99,3 +109,270 @@ TEST(ReactorTest, reactor_run_once_timeout) {
 
   reactor_free(reactor);
 }
+
+typedef struct {
+  reactor_t *reactor;
+  reactor_object_t object;
+  int count;
+  bool drain;
+  reactor_object_t *victim;
+} counter_t;
+
+static void counter_read_ready(void *context) {
+  counter_t *counter = (counter_t *)context;
+  ++counter->count;
+
+  if (counter->drain) {
+    eventfd_t value;
+    eventfd_read(counter->object.fd, &value);
+  }
+
+  if (counter->victim)
+    reactor_unregister(counter->reactor, counter->victim);
+}
+
+static void counter_init(counter_t *counter, reactor_t *reactor, reactor_interest_t interest) {
+  memset(counter, 0, sizeof(*counter));
+  counter->reactor = reactor;
+  counter->drain = true;
+  counter->object.context = counter;
+  counter->object.fd = eventfd(0, EFD_NONBLOCK);
+  counter->object.interest = interest;
+  counter->object.read_ready = counter_read_ready;
+}
+
+TEST(ReactorTest, reactor_dispatch_read) {
+  reactor_t *reactor = reactor_new();
+  counter_t counter;
+  counter_init(&counter, reactor, REACTOR_INTEREST_READ);
+  reactor_register(reactor, &counter.object);
+
+  eventfd_write(counter.object.fd, 1);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 1000), REACTOR_STATUS_DONE);
+  EXPECT_EQ(counter.count, 1);
+
+  reactor_unregister(reactor, &counter.object);
+  eventfd_write(counter.object.fd, 1);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 10), REACTOR_STATUS_TIMEOUT);
+  EXPECT_EQ(counter.count, 1);
+
+  close(counter.object.fd);
+  reactor_free(reactor);
+}
+
+TEST(ReactorTest, reactor_unregister_from_callback) {
+  reactor_t *reactor = reactor_new();
+  counter_t counters[2];
+  for (int i = 0; i < 2; ++i) {
+    counter_init(&counters[i], reactor, REACTOR_INTEREST_READ);
+    reactor_register(reactor, &counters[i].object);
+  }
+
+  // Whichever callback runs first unregisters the other, which must then not
+  // be called even though its event was collected in the same iteration.
+  counters[0].victim = &counters[1].object;
+  counters[1].victim = &counters[0].object;
+  eventfd_write(counters[0].object.fd, 1);
+  eventfd_write(counters[1].object.fd, 1);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 1000), REACTOR_STATUS_DONE);
+  EXPECT_EQ(counters[0].count + counters[1].count, 1);
+
+  for (int i = 0; i < 2; ++i) {
+    reactor_unregister(reactor, &counters[i].object);
+    close(counters[i].object.fd);
+  }
+  reactor_free(reactor);
+}
+
+TEST(ReactorTest, reactor_edge_triggered) {
+  reactor_t *reactor = reactor_new();
+  counter_t counter;
+  counter_init(&counter, reactor, (reactor_interest_t)(REACTOR_INTEREST_READ | REACTOR_INTEREST_EDGE));
+  counter.drain = false;
+  reactor_register(reactor, &counter.object);
+
+  eventfd_write(counter.object.fd, 1);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 1000), REACTOR_STATUS_DONE);
+  EXPECT_EQ(counter.count, 1);
+
+  // Still readable, but there has been no new edge.
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 10), REACTOR_STATUS_TIMEOUT);
+  EXPECT_EQ(counter.count, 1);
+
+  eventfd_write(counter.object.fd, 1);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 1000), REACTOR_STATUS_DONE);
+  EXPECT_EQ(counter.count, 2);
+
+  reactor_unregister(reactor, &counter.object);
+  close(counter.object.fd);
+  reactor_free(reactor);
+}
+
+typedef struct {
+  reactor_object_t object;
+  volatile bool started;
+  volatile bool finished;
+} slow_object_t;
+
+static void slow_read_ready(void *context) {
+  slow_object_t *slow = (slow_object_t *)context;
+  eventfd_t value;
+  eventfd_read(slow->object.fd, &value);
+
+  slow->started = true;
+  usleep(50 * 1000);
+  slow->finished = true;
+}
+
+TEST(ReactorTest, reactor_unregister_waits_for_callback) {
+  reactor_t *reactor = reactor_new();
+  slow_object_t slow;
+  memset(&slow, 0, sizeof(slow));
+  slow.object.context = &slow;
+  slow.object.fd = eventfd(0, EFD_NONBLOCK);
+  slow.object.interest = REACTOR_INTEREST_READ;
+  slow.object.read_ready = slow_read_ready;
+  reactor_register(reactor, &slow.object);
+
+  spawn_reactor_thread(reactor);
+  eventfd_write(slow.object.fd, 1);
+  while (!slow.started)
+    usleep(1000);
+
+  // Called off the reactor thread, unregistering returns only once the
+  // callback that is running has.
+  reactor_unregister(reactor, &slow.object);
+  EXPECT_TRUE(slow.finished);
+
+  reactor_stop(reactor);
+  join_reactor_thread();
+  close(slow.object.fd);
+  reactor_free(reactor);
+}
+
+TEST(ReactorTest, reactor_unregister_twice_keeps_reused_fd) {
+  reactor_t *reactor = reactor_new();
+  counter_t first, second;
+  counter_init(&first, reactor, REACTOR_INTEREST_READ);
+  reactor_register(reactor, &first.object);
+  reactor_unregister(reactor, &first.object);
+  close(first.object.fd);
+
+  // |second| gets the fd number |first| had; a second unregister of |first|
+  // must not remove it from the reactor.
+  counter_init(&second, reactor, REACTOR_INTEREST_READ);
+  EXPECT_EQ(second.object.fd, first.object.fd);
+  reactor_register(reactor, &second.object);
+  reactor_unregister(reactor, &first.object);
+
+  eventfd_write(second.object.fd, 1);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 1000), REACTOR_STATUS_DONE);
+  EXPECT_EQ(second.count, 1);
+
+  reactor_unregister(reactor, &second.object);
+  close(second.object.fd);
+  reactor_free(reactor);
+}
+
+static void timer_expired(void *context) {
+  ++*(int *)context;
+}
+
+TEST(ReactorTest, reactor_timer) {
+  reactor_t *reactor = reactor_new();
+  int count = 0;
+  reactor_timer_t *timer = reactor_timer_new(reactor, timer_expired, &count);
+  ASSERT_TRUE(timer != NULL);
+
+  uint64_t start = get_timestamp();
+  reactor_timer_set(timer, 20, 0);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 1000), REACTOR_STATUS_DONE);
+  EXPECT_GE(get_timestamp() - start, static_cast<uint64_t>(20));
+  EXPECT_EQ(count, 1);
+
+  reactor_timer_set(timer, 0, 10);
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(reactor_run_once_timeout(reactor, 1000), REACTOR_STATUS_DONE);
+  EXPECT_EQ(count, 4);
+
+  reactor_timer_cancel(timer);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 30), REACTOR_STATUS_TIMEOUT);
+  EXPECT_EQ(count, 4);
+
+  reactor_timer_free(timer);
+  reactor_free(reactor);
+}
+
+TEST(ReactorTest, reactor_timer_cancel_expired) {
+  reactor_t *reactor = reactor_new();
+  int count = 0;
+  reactor_timer_t *timer = reactor_timer_new(reactor, timer_expired, &count);
+
+  reactor_timer_set(timer, 0, 0);
+  usleep(10 * 1000);
+  reactor_timer_cancel(timer);
+  EXPECT_EQ(reactor_run_once_timeout(reactor, 20), REACTOR_STATUS_TIMEOUT);
+  EXPECT_EQ(count, 0);
+
+  reactor_timer_free(timer);
+  reactor_free(reactor);
+}
+
+// Registers thousands of file descriptors, beyond FD_SETSIZE when the file
+// limit allows, and reports the cost of registration and of dispatching one
+// ready descriptor among them. Times are printed rather than asserted since
+// they vary between devices.
+TEST(ReactorTest, reactor_benchmark_many_fds) {
+  static const int WANTED = 4096;
+  static const int ITERATIONS = 2000;
+
+  struct rlimit limit;
+  getrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur < (rlim_t)WANTED + 64 && limit.rlim_max > limit.rlim_cur) {
+    limit.rlim_cur = limit.rlim_max < (rlim_t)WANTED + 64 ? limit.rlim_max : (rlim_t)WANTED + 64;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  int num_fds = (int)limit.rlim_cur - 64 < WANTED ? (int)limit.rlim_cur - 64 : WANTED;
+  ASSERT_GT(num_fds, 0);
+
+  reactor_t *reactor = reactor_new();
+  counter_t *counters = (counter_t *)calloc(num_fds, sizeof(counter_t));
+  for (int i = 0; i < num_fds; ++i)
+    counter_init(&counters[i], reactor, REACTOR_INTEREST_READ);
+
+  uint64_t start = get_timestamp_us();
+  for (int i = 0; i < num_fds; ++i)
+    reactor_register(reactor, &counters[i].object);
+  uint64_t register_us = get_timestamp_us() - start;
+
+  start = get_timestamp_us();
+  for (int i = 0; i < ITERATIONS; ++i) {
+    counter_t *counter = &counters[(i * 7919) % num_fds];
+    eventfd_write(counter->object.fd, 1);
+    EXPECT_EQ(reactor_run_once(reactor), REACTOR_STATUS_DONE);
+  }
+  uint64_t dispatch_us = get_timestamp_us() - start;
+
+  int total = 0;
+  for (int i = 0; i < num_fds; ++i)
+    total += counters[i].count;
+  EXPECT_EQ(total, ITERATIONS);
+
+  // The last descriptors are beyond what select() could watch.
+  if (counters[num_fds - 1].object.fd >= FD_SETSIZE) {
+    eventfd_write(counters[num_fds - 1].object.fd, 1);
+    EXPECT_EQ(reactor_run_once(reactor), REACTOR_STATUS_DONE);
+    EXPECT_GT(counters[num_fds - 1].count, 0);
+  }
+
+  printf("%d fds: register %llu ns each, dispatch %llu ns each\n", num_fds,
+         (unsigned long long)(register_us * 1000 / num_fds),
+         (unsigned long long)(dispatch_us * 1000 / ITERATIONS));
+
+  for (int i = 0; i < num_fds; ++i) {
+    reactor_unregister(reactor, &counters[i].object);
+    close(counters[i].object.fd);
+  }
+  free(counters);
+  reactor_free(reactor);
+}
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "semaphore.h"
+#include "thread_pool.h"
+}
+
+static void increment(void *context) {
+  __sync_fetch_and_add((int *)context, 1);
+}
+
+static uint64_t get_timestamp_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+TEST(ThreadPoolTest, test_new_free) {
+  thread_pool_t *pool = thread_pool_new("test_pool", 2);
+  ASSERT_TRUE(pool != NULL);
+  EXPECT_EQ(thread_pool_size(pool), 2U);
+  thread_pool_free(pool);
+}
+
+TEST(ThreadPoolTest, test_new_one_per_cpu) {
+  thread_pool_t *pool = thread_pool_new("test_pool", 0);
+  ASSERT_TRUE(pool != NULL);
+  EXPECT_GE(thread_pool_size(pool), 1U);
+  thread_pool_free(pool);
+}
+
+TEST(ThreadPoolTest, test_free_null) {
+  thread_pool_free(NULL);
+}
+
+TEST(ThreadPoolTest, test_free_runs_posted_tasks) {
+  static const int COUNT = 1000;
+  int count = 0;
+
+  thread_pool_t *pool = thread_pool_new("test_pool", 4);
+  for (int i = 0; i < COUNT; ++i)
+    EXPECT_TRUE(thread_pool_post(pool, increment, &count, THREAD_POOL_PRIORITY_NORMAL));
+  thread_pool_free(pool);
+
+  EXPECT_EQ(count, COUNT);
+}
+
+typedef struct {
+  semaphore_t *started;
+  semaphore_t *release;
+} blocker_t;
+
+static void block(void *context) {
+  blocker_t *blocker = (blocker_t *)context;
+  semaphore_post(blocker->started);
+  semaphore_wait(blocker->release);
+}
+
+typedef struct {
+  char order[8];
+  int length;
+} order_t;
+
+static order_t order;
+
+static void record_high(void *) { order.order[order.length++] = 'H'; }
+static void record_normal(void *) { order.order[order.length++] = 'N'; }
+static void record_low(void *) { order.order[order.length++] = 'L'; }
+
+TEST(ThreadPoolTest, test_priorities) {
+  thread_pool_t *pool = thread_pool_new("test_pool", 1);
+  blocker_t blocker = { semaphore_new(0), semaphore_new(0) };
+  memset(&order, 0, sizeof(order));
+
+  // Hold the only worker so the others queue up behind it.
+  thread_pool_post(pool, block, &blocker, THREAD_POOL_PRIORITY_NORMAL);
+  semaphore_wait(blocker.started);
+
+  thread_pool_post(pool, record_low, NULL, THREAD_POOL_PRIORITY_LOW);
+  thread_pool_post(pool, record_normal, NULL, THREAD_POOL_PRIORITY_NORMAL);
+  thread_pool_post(pool, record_high, NULL, THREAD_POOL_PRIORITY_HIGH);
+  semaphore_post(blocker.release);
+  thread_pool_free(pool);
+
+  EXPECT_STREQ(order.order, "HNL");
+  semaphore_free(blocker.started);
+  semaphore_free(blocker.release);
+}
+
+TEST(ThreadPoolTest, test_group_join) {
+  static const int COUNT = 500;
+  int count = 0;
+
+  thread_pool_t *pool = thread_pool_new("test_pool", 4);
+  thread_pool_group_t *group = thread_pool_group_new(pool);
+  for (int i = 0; i < COUNT; ++i)
+    EXPECT_TRUE(thread_pool_group_fork(group, increment, &count, THREAD_POOL_PRIORITY_NORMAL));
+  thread_pool_group_join(group);
+  EXPECT_EQ(count, COUNT);
+
+  // A joined group may be reused.
+  thread_pool_group_fork(group, increment, &count, THREAD_POOL_PRIORITY_NORMAL);
+  thread_pool_group_join(group);
+  EXPECT_EQ(count, COUNT + 1);
+
+  thread_pool_group_free(group);
+  thread_pool_free(pool);
+}
+
+TEST(ThreadPoolTest, test_group_join_empty) {
+  thread_pool_t *pool = thread_pool_new("test_pool", 1);
+  thread_pool_group_t *group = thread_pool_group_new(pool);
+  thread_pool_group_join(group);
+  thread_pool_group_free(group);
+  thread_pool_free(pool);
+}
+
+typedef struct {
+  thread_pool_t *pool;
+  int n;
+  int result;
+} fib_t;
+
+// Forks both halves and joins them from inside a task, which only works if
+// joining workers run other tasks while they wait.
+static void fib(void *context) {
+  fib_t *arg = (fib_t *)context;
+  if (arg->n < 2) {
+    arg->result = arg->n;
+    return;
+  }
+
+  fib_t left = { arg->pool, arg->n - 1, 0 };
+  fib_t right = { arg->pool, arg->n - 2, 0 };
+  thread_pool_group_t *group = thread_pool_group_new(arg->pool);
+  thread_pool_group_fork(group, fib, &left, THREAD_POOL_PRIORITY_NORMAL);
+  thread_pool_group_fork(group, fib, &right, THREAD_POOL_PRIORITY_NORMAL);
+  thread_pool_group_join(group);
+  thread_pool_group_free(group);
+  arg->result = left.result + right.result;
+}
+
+TEST(ThreadPoolTest, test_nested_fork_join) {
+  for (size_t threads = 1; threads <= 4; threads *= 2) {
+    thread_pool_t *pool = thread_pool_new("test_pool", threads);
+    fib_t arg = { pool, 15, 0 };
+    thread_pool_group_t *group = thread_pool_group_new(pool);
+    thread_pool_group_fork(group, fib, &arg, THREAD_POOL_PRIORITY_NORMAL);
+    thread_pool_group_join(group);
+    thread_pool_group_free(group);
+    thread_pool_free(pool);
+    EXPECT_EQ(arg.result, 610);
+  }
+}
+
+typedef struct {
+  uint32_t seed;
+  uint32_t result;
+} work_t;
+
+// Enough arithmetic to keep a core busy for a while without touching memory.
+static void crunch(void *context) {
+  work_t *work = (work_t *)context;
+  uint32_t x = work->seed;
+  for (int i = 0; i < 200000; ++i)
+    x = x * 1664525u + 1013904223u;
+  work->result = x;
+}
+
+// Reports how fork/join throughput scales with the number of workers. Times
+// are printed rather than asserted since they depend on the device and its
+// load.
+TEST(ThreadPoolTest, test_benchmark_scaling) {
+  static const int TASKS = 256;
+  work_t *work = (work_t *)calloc(TASKS, sizeof(work_t));
+  uint64_t base_us = 0;
+  uint32_t expected = 0;
+
+  for (size_t threads = 1; threads <= 8; threads *= 2) {
+    thread_pool_t *pool = thread_pool_new("bench_pool", threads);
+    thread_pool_group_t *group = thread_pool_group_new(pool);
+    for (int i = 0; i < TASKS; ++i)
+      work[i].seed = i;
+
+    uint64_t start = get_timestamp_us();
+    for (int i = 0; i < TASKS; ++i)
+      thread_pool_group_fork(group, crunch, &work[i], THREAD_POOL_PRIORITY_NORMAL);
+    thread_pool_group_join(group);
+    uint64_t elapsed_us = get_timestamp_us() - start;
+
+    uint32_t sum = 0;
+    for (int i = 0; i < TASKS; ++i)
+      sum += work[i].result;
+    if (threads == 1) {
+      base_us = elapsed_us;
+      expected = sum;
+    }
+    EXPECT_EQ(sum, expected);
+
+    printf("%zu threads: %llu us, speedup %.2f\n", threads, (unsigned long long)elapsed_us,
+           elapsed_us ? (double)base_us / elapsed_us : 0.0);
+
+    thread_pool_group_free(group);
+    thread_pool_free(pool);
+  }
+
+  free(work);
+}
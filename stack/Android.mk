@@ -127,6 +127,7 @@ LOCAL_SRC_FILES:= \
     ./sdp/sdp_utils.c \
     ./sdp/sdp_api.c \
     ./sdp/sdp_discovery.c \
+    ./sdp/sdp_cache.c \
     ./pan/pan_main.c \
     ./srvc/srvc_battery.c \
     ./srvc/srvc_battery_int.h \
@@ -163,3 +164,63 @@ LOCAL_SHARED_LIBRARIES := libcutils libc
 LOCAL_MULTILIB := 32
 
 include $(BUILD_STATIC_LIBRARY)
+
+#####################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/avdt \
+    $(LOCAL_PATH)/btm \
+    $(LOCAL_PATH)/l2cap \
+    $(LOCAL_PATH)/sdp \
+    $(LOCAL_PATH)/gatt \
+    $(LOCAL_PATH)/bnep \
+    $(LOCAL_PATH)/../include \
+    $(LOCAL_PATH)/../gki/common \
+    $(LOCAL_PATH)/../gki/ulinux \
+    $(LOCAL_PATH)/../udrv/include \
+    $(LOCAL_PATH)/../vnd/include \
+    $(LOCAL_PATH)/../utils/include \
+    $(bdroid_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ../gki/common/gki_buffer.c \
+    ../utils/src/slab.c \
+    ./avdt/avdt_ad.c \
+    ./avdt/avdt_api.c \
+    ./avdt/avdt_scb.c \
+    ./avdt/avdt_scb_act.c \
+    ./bnep/bnep_utils.c \
+    ./btm/btm_dev.c \
+    ./btm/btm_devctl.c \
+    ./btu/btu_hcif.c \
+    ./gatt/att_protocol.c \
+    ./gatt/gatt_api.c \
+    ./gatt/gatt_auth.c \
+    ./gatt/gatt_cl.c \
+    ./gatt/gatt_db.c \
+    ./gatt/gatt_main.c \
+    ./gatt/gatt_utils.c \
+    ./sdp/sdp_cache.c \
+    ./test/avdt_write_test.cpp \
+    ./test/bnep_filter_test.cpp \
+    ./test/btm_dev_test.cpp \
+    ./test/btm_devctl_test.cpp \
+    ./test/btu_hcif_test.cpp \
+    ./test/fake_l2cap.cpp \
+    ./test/gatt_api_test.cpp \
+    ./test/gatt_cl_test.cpp \
+    ./test/gatt_disc_test.cpp \
+    ./test/gatt_db_test.cpp \
+    ./test/sdp_cache_test.cpp \
+    ./test/stack_stubs.cpp
+
+LOCAL_CFLAGS := $(bdroid_CFLAGS)
+LOCAL_CONLYFLAGS := -std=c99
+LOCAL_MODULE := stacktests
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog
+
+include $(BUILD_NATIVE_TEST)
@@ -1017,6 +1017,62 @@ UINT16 AVDT_WriteReqOpt(UINT8 handle, BT_HDR *p_pkt, UINT32 time_stamp, UINT8 m_
     {
         evt.apiwrite.p_buf = p_pkt;
         evt.apiwrite.time_stamp = time_stamp;
+        evt.apiwrite.num_batch = 0;
+        evt.apiwrite.m_pt = m_pt;
+        evt.apiwrite.opt = opt;
+#if AVDT_MULTIPLEXING == TRUE
+        GKI_init_q (&evt.apiwrite.frag_q);
+#endif
+        avdt_scb_event(p_scb, AVDT_SCB_API_WRITE_REQ_EVT, &evt);
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+**
+** Function         AVDT_WriteReqBatch
+**
+** Description      Send several media packets to the peer device at once.
+**                  This works like AVDT_WriteReqOpt(), except that all the
+**                  packets are handed to L2CAP together and a single
+**                  AVDT_WRITE_CFM_EVT is sent once the whole batch has been
+**                  queued.  time_stamp[i] is the time stamp of pp_pkt[i].
+**
+**                  Every buffer must meet the AVDT_WriteReqOpt() offset
+**                  requirement and is freed by the protocol stack.
+**
+** Returns          AVDT_SUCCESS if successful, otherwise error.
+**
+*******************************************************************************/
+UINT16 AVDT_WriteReqBatch(UINT8 handle, UINT8 num_pkts, BT_HDR **pp_pkt,
+                          UINT32 *p_time_stamp, UINT8 m_pt, tAVDT_DATA_OPT_MASK opt)
+{
+    tAVDT_SCB       *p_scb;
+    tAVDT_SCB_EVT   evt;
+    UINT16          result = AVDT_SUCCESS;
+    UINT8           xx;
+
+    BTTRC_AVDT_API0(AVDT_TRACE_API_WRITE_REQ);
+
+    if (num_pkts == 0)
+    {
+        result = AVDT_BAD_PARAMS;
+    }
+    /* map handle to scb */
+    else if ((p_scb = avdt_scb_by_hdl(handle)) == NULL)
+    {
+        for (xx = 0; xx < num_pkts; xx++)
+            GKI_freebuf(pp_pkt[xx]);
+        result = AVDT_BAD_HANDLE;
+    }
+    else
+    {
+        /* the packets and time stamps are used before avdt_scb_event returns */
+        evt.apiwrite.p_buf = NULL;
+        evt.apiwrite.pp_batch = pp_pkt;
+        evt.apiwrite.p_batch_ts = p_time_stamp;
+        evt.apiwrite.num_batch = num_pkts;
         evt.apiwrite.m_pt = m_pt;
         evt.apiwrite.opt = opt;
 #if AVDT_MULTIPLEXING == TRUE
@@ -1292,6 +1348,7 @@ AVDT_API extern UINT16 AVDT_WriteDataReq(UINT8 handle, UINT8 *p_data, UINT32 dat
 
         /* process the fragments queue */
         evt.apiwrite.time_stamp = time_stamp;
+        evt.apiwrite.num_batch = 0;
         evt.apiwrite.m_pt = m_pt | (marker<<7);
         avdt_scb_event(p_scb, AVDT_SCB_API_WRITE_REQ_EVT, &evt);
     } while (0);
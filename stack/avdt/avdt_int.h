@@ -458,6 +458,9 @@ typedef struct {
     UINT8       *p_data;
     UINT32      data_len;
 #endif
+    BT_HDR      **pp_batch;      /* packets from AVDT_WriteReqBatch(). p_buf should be 0 */
+    UINT32      *p_batch_ts;     /* time stamp of each packet in pp_batch */
+    UINT8       num_batch;
     UINT8       m_pt;
     tAVDT_DATA_OPT_MASK     opt;
 } tAVDT_SCB_APIWRITE;
@@ -487,8 +490,11 @@ typedef struct {
     tAVDT_CFG       req_cfg;        /* requested configuration */
     TIMER_LIST_ENT  timer_entry;    /* timer entry */
     BT_HDR          *p_pkt;         /* packet waiting to be sent */
+    BUFFER_Q        media_q;        /* batch of packets waiting to be sent */
     tAVDT_CCB       *p_ccb;         /* ccb associated with this scb */
     UINT16          media_seq;      /* media packet sequence number */
+    UINT8           rtp_hdr[AVDT_MEDIA_HDR_SIZE]; /* media header template; sequence
+                                                     number and time stamp set per packet */
     BOOLEAN         allocated;      /* whether scb is allocated or unused */
     BOOLEAN         in_use;         /* whether stream being used by peer */
     UINT8           role;           /* initiator/acceptor role in current procedure */
@@ -612,6 +618,8 @@ extern tAVDT_SCB *avdt_scb_by_hdl(UINT8 hdl);
 extern UINT8 avdt_scb_verify(tAVDT_CCB *p_ccb, UINT8 state, UINT8 *p_seid, UINT16 num_seid, UINT8 *p_err_code);
 extern void avdt_scb_peer_seid_list(tAVDT_MULTI *p_multi);
 extern UINT32 avdt_scb_gen_ssrc(tAVDT_SCB *p_scb);
+extern void avdt_scb_bld_media_hdr(tAVDT_SCB *p_scb, BT_HDR *p_buf, UINT8 m_pt, UINT32 time_stamp);
+extern BOOLEAN avdt_scb_free_media_q(tAVDT_SCB *p_scb);
 
 /* SCB action functions */
 extern void avdt_scb_hdl_abort_cmd(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
@@ -644,6 +652,7 @@ extern void avdt_scb_hdl_tc_open(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_hdl_tc_close_sto(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_hdl_tc_open_sto(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_hdl_write_req(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
+extern void avdt_scb_hdl_write_req_batch(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_snd_abort_req(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_snd_abort_rsp(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_snd_close_req(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
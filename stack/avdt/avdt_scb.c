@@ -603,6 +603,7 @@ tAVDT_SCB *avdt_scb_alloc(tAVDT_CS *p_cs)
             p_scb->p_ccb = NULL;
 
             memcpy(&p_scb->cs, p_cs, sizeof(tAVDT_CS));
+            GKI_init_q(&p_scb->media_q);
 #if AVDT_MULTIPLEXING == TRUE
             /* initialize fragments gueue */
             GKI_init_q(&p_scb->frag_q);
@@ -654,6 +655,8 @@ void avdt_scb_dealloc(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
     AVDT_TRACE_DEBUG("avdt_scb_dealloc hdl=%d", avdt_scb_to_hdl(p_scb));
     btu_stop_timer(&p_scb->timer_entry);
 
+    avdt_scb_free_media_q(p_scb);
+
 #if AVDT_MULTIPLEXING == TRUE
     /* free fragments we're holding, if any; it shouldn't happen */
     while ((p_buf = GKI_dequeue (&p_scb->frag_q)) != NULL)
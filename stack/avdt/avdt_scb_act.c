@@ -76,6 +76,67 @@ UINT32 avdt_scb_gen_ssrc(tAVDT_SCB *p_scb)
     return ((UINT32)(p_scb->cs.cfg.codec_info[1] | p_scb->cs.cfg.codec_info[2]));
 }
 
+/*******************************************************************************
+**
+** Function         avdt_scb_bld_media_hdr
+**
+** Description      This function prepends a media packet header to the
+**                  buffer.  The constant part of the header (octet 1, payload
+**                  type and SSRC) is kept as a template in the SCB, so only
+**                  the sequence number and time stamp are written per packet.
+**
+** Returns          Nothing.
+**
+*******************************************************************************/
+void avdt_scb_bld_media_hdr(tAVDT_SCB *p_scb, BT_HDR *p_buf, UINT8 m_pt, UINT32 time_stamp)
+{
+    UINT8   *p;
+
+    /* the SSRC is fixed for the life of the SCB; rebuild only if m_pt changes */
+    if ((p_scb->rtp_hdr[0] != AVDT_MEDIA_OCTET1) || (p_scb->rtp_hdr[1] != m_pt))
+    {
+        p = p_scb->rtp_hdr;
+        UINT8_TO_BE_STREAM(p, AVDT_MEDIA_OCTET1);
+        UINT8_TO_BE_STREAM(p, m_pt);
+        UINT16_TO_BE_STREAM(p, 0);
+        UINT32_TO_BE_STREAM(p, 0);
+        UINT32_TO_BE_STREAM(p, avdt_scb_gen_ssrc(p_scb));
+    }
+
+    p_buf->len += AVDT_MEDIA_HDR_SIZE;
+    p_buf->offset -= AVDT_MEDIA_HDR_SIZE;
+    p_scb->media_seq++;
+    p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+
+    memcpy(p, p_scb->rtp_hdr, AVDT_MEDIA_HDR_SIZE);
+    p += 2;
+    UINT16_TO_BE_STREAM(p, p_scb->media_seq);
+    UINT32_TO_BE_STREAM(p, time_stamp);
+}
+
+/*******************************************************************************
+**
+** Function         avdt_scb_free_media_q
+**
+** Description      This function frees the batch of media packets waiting
+**                  to be sent, if any.
+**
+** Returns          TRUE if any packet was freed.
+**
+*******************************************************************************/
+BOOLEAN avdt_scb_free_media_q(tAVDT_SCB *p_scb)
+{
+    BT_HDR  *p_buf;
+    BOOLEAN freed = FALSE;
+
+    while ((p_buf = (BT_HDR *)GKI_dequeue(&p_scb->media_q)) != NULL)
+    {
+        GKI_freebuf(p_buf);
+        freed = TRUE;
+    }
+    return freed;
+}
+
 /*******************************************************************************
 **
 ** Function         avdt_scb_hdl_abort_cmd
@@ -1014,6 +1075,7 @@ void avdt_scb_hdl_tc_close(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
         GKI_freebuf(p_scb->p_pkt);
         p_scb->p_pkt = NULL;
     }
+    avdt_scb_free_media_q(p_scb);
 
     /* stop transport channel timer */
     btu_stop_timer(&p_scb->timer_entry);
@@ -1215,9 +1277,6 @@ void avdt_scb_hdl_tc_open_sto(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
 *******************************************************************************/
 void avdt_scb_hdl_write_req_no_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
 {
-    UINT8   *p;
-    UINT32  ssrc;
-
     /* free packet we're holding, if any; to be replaced with new */
     if (p_scb->p_pkt != NULL)
     {
@@ -1226,29 +1285,68 @@ void avdt_scb_hdl_write_req_no_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
         /* this shouldn't be happening */
         AVDT_TRACE_WARNING("Dropped media packet; congested");
     }
+    if (avdt_scb_free_media_q(p_scb))
+    {
+        AVDT_TRACE_WARNING("Dropped media batch; congested");
+    }
 
     /* build a media packet */
     /* Add RTP header if required */
     if ( !(p_data->apiwrite.opt & AVDT_DATA_OPT_NO_RTP) )
     {
-        ssrc = avdt_scb_gen_ssrc(p_scb);
-
-        p_data->apiwrite.p_buf->len += AVDT_MEDIA_HDR_SIZE;
-        p_data->apiwrite.p_buf->offset -= AVDT_MEDIA_HDR_SIZE;
-        p_scb->media_seq++;
-        p = (UINT8 *)(p_data->apiwrite.p_buf + 1) + p_data->apiwrite.p_buf->offset;
-
-        UINT8_TO_BE_STREAM(p, AVDT_MEDIA_OCTET1);
-        UINT8_TO_BE_STREAM(p, p_data->apiwrite.m_pt);
-        UINT16_TO_BE_STREAM(p, p_scb->media_seq);
-        UINT32_TO_BE_STREAM(p, p_data->apiwrite.time_stamp);
-        UINT32_TO_BE_STREAM(p, ssrc);
+        avdt_scb_bld_media_hdr(p_scb, p_data->apiwrite.p_buf, p_data->apiwrite.m_pt,
+                               p_data->apiwrite.time_stamp);
     }
 
     /* store it */
     p_scb->p_pkt = p_data->apiwrite.p_buf;
 }
 
+/*******************************************************************************
+**
+** Function         avdt_scb_hdl_write_req_batch
+**
+** Description      This function frees the media packets currently stored in
+**                  the SCB, if any.  Then it builds a media packet from each
+**                  of the passed in buffers and queues them in the SCB so
+**                  they are sent together.
+**
+** Returns          Nothing.
+**
+*******************************************************************************/
+void avdt_scb_hdl_write_req_batch(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
+{
+    BT_HDR  *p_buf;
+    UINT8   xx;
+
+    /* free packets we're holding, if any; to be replaced with new */
+    if (p_scb->p_pkt != NULL)
+    {
+        GKI_freebuf(p_scb->p_pkt);
+        p_scb->p_pkt = NULL;
+
+        /* this shouldn't be happening */
+        AVDT_TRACE_WARNING("Dropped media packet; congested");
+    }
+    if (avdt_scb_free_media_q(p_scb))
+    {
+        AVDT_TRACE_WARNING("Dropped media batch; congested");
+    }
+
+    for (xx = 0; xx < p_data->apiwrite.num_batch; xx++)
+    {
+        p_buf = p_data->apiwrite.pp_batch[xx];
+
+        /* Add RTP header if required */
+        if ( !(p_data->apiwrite.opt & AVDT_DATA_OPT_NO_RTP) )
+        {
+            avdt_scb_bld_media_hdr(p_scb, p_buf, p_data->apiwrite.m_pt,
+                                   p_data->apiwrite.p_batch_ts[xx]);
+        }
+        GKI_enqueue(&p_scb->media_q, p_buf);
+    }
+}
+
 #if AVDT_MULTIPLEXING == TRUE
 /*******************************************************************************
 **
@@ -1335,6 +1433,9 @@ void avdt_scb_hdl_write_req_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
 *******************************************************************************/
 void avdt_scb_hdl_write_req(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
 {
+    if (p_data->apiwrite.num_batch != 0)
+        avdt_scb_hdl_write_req_batch(p_scb, p_data);
+    else
 #if AVDT_MULTIPLEXING == TRUE
     if (GKI_queue_is_empty(&p_data->apiwrite.frag_q))
 #endif
@@ -1433,6 +1534,7 @@ void avdt_scb_snd_stream_close(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
         GKI_freebuf(p_scb->p_pkt);
         p_scb->p_pkt = NULL;
     }
+    avdt_scb_free_media_q(p_scb);
 
 #if 0
     if(p_scb->cong)
@@ -1853,6 +1955,7 @@ void avdt_scb_set_remove(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
 void avdt_scb_free_pkt(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
 {
     tAVDT_CTRL      avdt_ctrl;
+    UINT8           xx;
 #if AVDT_MULTIPLEXING == TRUE
     BT_HDR          *p_frag;
 #endif
@@ -1865,6 +1968,10 @@ void avdt_scb_free_pkt(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
     if(p_data->apiwrite.p_buf)
         GKI_freebuf(p_data->apiwrite.p_buf);
 
+    /* free packets of a batch write */
+    for (xx = 0; xx < p_data->apiwrite.num_batch; xx++)
+        GKI_freebuf(p_data->apiwrite.pp_batch[xx]);
+
 #if AVDT_MULTIPLEXING == TRUE
     /* clean fragments queue */
     while((p_frag = (BT_HDR*)GKI_dequeue (&p_data->apiwrite.frag_q)) != NULL)
@@ -1918,6 +2025,14 @@ void avdt_scb_clr_pkt(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
 
         AVDT_TRACE_DEBUG("Dropped stored media packet");
 
+        /* we need to call callback to keep data flow going */
+        (*p_scb->cs.p_ctrl_cback)(avdt_scb_to_hdl(p_scb), NULL, AVDT_WRITE_CFM_EVT,
+                                  &avdt_ctrl);
+    }
+    else if (avdt_scb_free_media_q(p_scb))
+    {
+        AVDT_TRACE_DEBUG("Dropped stored media batch");
+
         /* we need to call callback to keep data flow going */
         (*p_scb->cs.p_ctrl_cback)(avdt_scb_to_hdl(p_scb), NULL, AVDT_WRITE_CFM_EVT,
                                   &avdt_ctrl);
@@ -1973,6 +2088,14 @@ void avdt_scb_chk_snd_pkt(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
             p_scb->p_pkt = NULL;
             avdt_ad_write_req(AVDT_CHAN_MEDIA, p_scb->p_ccb, p_scb, p_pkt);
 
+            (*p_scb->cs.p_ctrl_cback)(avdt_scb_to_hdl(p_scb), NULL, AVDT_WRITE_CFM_EVT, &avdt_ctrl);
+        }
+        else if (!GKI_queue_is_empty(&p_scb->media_q))
+        {
+            /* hand the whole batch to L2CAP; one confirm for all of it */
+            while ((p_pkt = (BT_HDR *)GKI_dequeue(&p_scb->media_q)) != NULL)
+                avdt_ad_write_req(AVDT_CHAN_MEDIA, p_scb->p_ccb, p_scb, p_pkt);
+
             (*p_scb->cs.p_ctrl_cback)(avdt_scb_to_hdl(p_scb), NULL, AVDT_WRITE_CFM_EVT, &avdt_ctrl);
         }
 #if AVDT_MULTIPLEXING == TRUE
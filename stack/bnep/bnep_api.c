@@ -46,6 +46,12 @@ void BNEP_Init (void)
     bnep_cb.trace_level = BT_TRACE_LEVEL_NONE;    /* No traces */
 #endif
 
+    if (!slab_init (&bnep_bcb_slab, bnep_cb.bcb, sizeof (tBNEP_CONN), BNEP_MAX_CONNECTIONS,
+                    bnep_max_connections, TRUE))
+    {
+        BNEP_TRACE_ERROR ("BNEP_Init: unable to set up the connection pool");
+    }
+
     /* Start a timer to read our BD address */
     btu_start_timer (&bnep_cb.bnep_tle, BTU_TTYPE_BNEP, 2);
 }
@@ -202,6 +208,7 @@ tBNEP_RESULT BNEP_Connect (BD_ADDR p_rem_bda,
         if ((cid = L2CA_ConnectReq (BT_PSM_BNEP, p_bcb->rem_bda)) != 0)
         {
             p_bcb->l2cap_cid = cid;
+            slab_map_set (&bnep_bcb_slab, p_bcb, cid);
 
         }
         else
@@ -354,7 +361,8 @@ tBNEP_RESULT BNEP_Disconnect (UINT16 handle)
 ** Returns:         BNEP_WRONG_HANDLE       - if passed handle is not valid
 **                  BNEP_MTU_EXCEDED        - If the data length is greater than MTU
 **                  BNEP_IGNORE_CMD         - If the packet is filtered out
-**                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full
+**                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full, the buffer
+**                                            is not freed
 **                  BNEP_SUCCESS            - If written successfully
 **
 *******************************************************************************/
@@ -383,6 +391,11 @@ tBNEP_RESULT BNEP_WriteBuf (UINT16 handle,
         return (BNEP_MTU_EXCEDED);
     }
 
+    /* Check transmit queue before the filter can touch the buffer, the caller
+    ** keeps it and may retry once the flow is back on */
+    if (p_bcb->xmit_q.count >= BNEP_MAX_XMITQ_DEPTH)
+        return (BNEP_Q_SIZE_EXCEEDED);
+
     /* Check if the packet should be filtered out */
     p_data = (UINT8 *)(p_buf + 1) + p_buf->offset;
     if (bnep_is_packet_allowed (p_bcb, p_dest_addr, protocol, fw_ext_present, p_data) != BNEP_SUCCESS)
@@ -431,13 +444,6 @@ tBNEP_RESULT BNEP_WriteBuf (UINT16 handle,
         }
     }
 
-    /* Check transmit queue */
-    if (p_bcb->xmit_q.count >= BNEP_MAX_XMITQ_DEPTH)
-    {
-        GKI_freebuf (p_buf);
-        return (BNEP_Q_SIZE_EXCEEDED);
-    }
-
     /* Build the BNEP header */
     bnepu_build_bnep_hdr (p_bcb, p_buf, protocol, p_src_addr, p_dest_addr, fw_ext_present);
 
@@ -30,6 +30,7 @@
 #include "bnep_api.h"
 #include "btm_int.h"
 #include "btu.h"
+#include "slab.h"
 
 
 /* BNEP frame types
@@ -78,6 +79,15 @@
 /* 802.1p protocol packet will have actual protocol field in side the payload */
 #define BNEP_802_1_P_PROTOCOL           0x8100
 
+/* Protocols checked against a bitmap instead of the compiled filter ranges */
+#define BNEP_IPV4_PROTOCOL              0x0800
+#define BNEP_ARP_PROTOCOL               0x0806
+#define BNEP_IPV6_PROTOCOL              0x86DD
+
+#define BNEP_COMMON_PROT_IPV4           0x01
+#define BNEP_COMMON_PROT_ARP            0x02
+#define BNEP_COMMON_PROT_IPV6           0x04
+
 /* Timeout definitions.
 */
 #define BNEP_CONN_TIMEOUT           20               /* Connection related timeout */
@@ -152,6 +162,16 @@ typedef struct
     BD_ADDR           rcvd_mcast_filter_start[BNEP_MAX_MULTI_FILTERS];
     BD_ADDR           rcvd_mcast_filter_end[BNEP_MAX_MULTI_FILTERS];
 
+    /* Received filters compiled for the data path: sorted, overlaps merged */
+    UINT8             rcvd_prot_common;         /* BNEP_COMMON_PROT_xxx passing the filters */
+    UINT16            rcvd_prot_ranges;
+    UINT16            rcvd_prot_range_start[BNEP_MAX_PROT_FILTERS];
+    UINT16            rcvd_prot_range_end[BNEP_MAX_PROT_FILTERS];
+
+    UINT16            rcvd_mcast_ranges;
+    UINT64            rcvd_mcast_range_start[BNEP_MAX_MULTI_FILTERS];
+    UINT64            rcvd_mcast_range_end[BNEP_MAX_MULTI_FILTERS];
+
     UINT16            bad_pkts_rcvd;
     UINT8             re_transmits;
     UINT16            handle;
@@ -201,6 +221,16 @@ BNEP_API extern tBNEP_CB  *bnep_cb_ptr;
 #define bnep_cb (*bnep_cb_ptr)
 #endif
 
+/* Allocator of bnep_cb.bcb, kept outside bnep_cb as that is cleared on init.
+** BCBs are also mapped by L2CAP CID.
+*/
+extern tSLAB   bnep_bcb_slab;
+
+/* How many BCBs may be in use at once, at most BNEP_MAX_CONNECTIONS. Set from
+** the stack configuration before BNEP_Init.
+*/
+extern UINT16  bnep_max_connections;
+
 /* Functions provided by bnep_main.c
 */
 extern tBNEP_RESULT bnep_register_with_l2cap (void);
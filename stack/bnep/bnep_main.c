@@ -51,6 +51,9 @@
 tBNEP_CB   bnep_cb;
 #endif
 
+tSLAB      bnep_bcb_slab;
+UINT16     bnep_max_connections = BNEP_MAX_CONNECTIONS;
+
 const UINT16 bnep_frame_hdr_sizes[] = {14, 1, 2, 8, 8};
 
 /********************************************************************************/
@@ -137,6 +140,7 @@ static void bnep_connect_ind (BD_ADDR  bd_addr, UINT16 l2cap_cid, UINT16 psm, UI
 
     /* Save the L2CAP Channel ID. */
     p_bcb->l2cap_cid = l2cap_cid;
+    slab_map_set (&bnep_bcb_slab, p_bcb, l2cap_cid);
 
     /* Send response to the L2CAP layer. */
     L2CA_ConnectRsp (bd_addr, l2cap_id, l2cap_cid, L2CAP_CONN_OK, L2CAP_CONN_OK);
@@ -37,6 +37,17 @@
 /********************************************************************************/
 static UINT8 *bnepu_init_hdr (BT_HDR *p_buf, UINT16 hdr_len, UINT8 pkt_type);
 
+#if (defined (BNEP_SUPPORTS_PROT_FILTERS) && BNEP_SUPPORTS_PROT_FILTERS == TRUE)
+static void bnepu_compile_prot_filters (tBNEP_CONN *p_bcb);
+static BOOLEAN bnepu_prot_in_filters (tBNEP_CONN *p_bcb, UINT16 proto);
+static UINT8 bnepu_common_prot_mask (UINT16 proto);
+#endif
+
+#if (defined (BNEP_SUPPORTS_MULTI_FILTERS) && BNEP_SUPPORTS_MULTI_FILTERS == TRUE)
+static void bnepu_compile_mcast_filters (tBNEP_CONN *p_bcb);
+static UINT64 bnepu_bda_to_uint64 (BD_ADDR bda);
+#endif
+
 void bnepu_process_peer_multicast_filter_set (tBNEP_CONN *p_bcb, UINT8 *p_filters, UINT16 len);
 void bnepu_send_peer_multicast_filter_rsp (tBNEP_CONN *p_bcb, UINT16 response_code);
 
@@ -45,23 +56,18 @@ void bnepu_send_peer_multicast_filter_rsp (tBNEP_CONN *p_bcb, UINT16 response_co
 **
 ** Function         bnepu_find_bcb_by_cid
 **
-** Description      This function searches the bcb table for an entry with the
-**                  passed CID.
+** Description      This function looks up the BCB with the passed CID, which
+**                  is mapped when the CID is saved.
 **
 ** Returns          the BCB address, or NULL if not found.
 **
 *******************************************************************************/
 tBNEP_CONN *bnepu_find_bcb_by_cid (UINT16 cid)
 {
-    UINT16          xx;
-    tBNEP_CONN     *p_bcb;
+    tBNEP_CONN     *p_bcb = SLAB_FIND (&bnep_bcb_slab, tBNEP_CONN, cid);
 
-    /* Look through each connection control block */
-    for (xx = 0, p_bcb = bnep_cb.bcb; xx < BNEP_MAX_CONNECTIONS; xx++, p_bcb++)
-    {
-        if ((p_bcb->con_state != BNEP_STATE_IDLE) && (p_bcb->l2cap_cid == cid))
-            return (p_bcb);
-    }
+    if ((p_bcb) && (p_bcb->con_state != BNEP_STATE_IDLE) && (p_bcb->l2cap_cid == cid))
+        return (p_bcb);
 
     /* If here, not found */
     return (NULL);
@@ -109,27 +115,20 @@ tBNEP_CONN *bnepu_find_bcb_by_bd_addr (UINT8 *p_bda)
 *******************************************************************************/
 tBNEP_CONN *bnepu_allocate_bcb (BD_ADDR p_rem_bda)
 {
-    UINT16          xx;
-    tBNEP_CONN     *p_bcb;
+    tBNEP_CONN     *p_bcb = SLAB_ALLOC (&bnep_bcb_slab, tBNEP_CONN);
 
-    /* Look through each connection control block for a free one */
-    for (xx = 0, p_bcb = bnep_cb.bcb; xx < BNEP_MAX_CONNECTIONS; xx++, p_bcb++)
-    {
-        if (p_bcb->con_state == BNEP_STATE_IDLE)
-        {
-            memset ((UINT8 *)p_bcb, 0, sizeof (tBNEP_CONN));
+    /* If no free BCB found */
+    if (p_bcb == NULL)
+        return (NULL);
 
-            p_bcb->conn_tle.param = (UINT32) p_bcb;
+    memset ((UINT8 *)p_bcb, 0, sizeof (tBNEP_CONN));
 
-            memcpy ((UINT8 *)(p_bcb->rem_bda), (UINT8 *)p_rem_bda, BD_ADDR_LEN);
-            p_bcb->handle = xx + 1;
+    p_bcb->conn_tle.param = (UINT32) p_bcb;
 
-            return (p_bcb);
-        }
-    }
+    memcpy ((UINT8 *)(p_bcb->rem_bda), (UINT8 *)p_rem_bda, BD_ADDR_LEN);
+    p_bcb->handle = slab_index (&bnep_bcb_slab, p_bcb) + 1;
 
-    /* If here, no free BCB found */
-    return (NULL);
+    return (p_bcb);
 }
 
 
@@ -151,6 +150,9 @@ void bnepu_release_bcb (tBNEP_CONN *p_bcb)
     p_bcb->con_state        = BNEP_STATE_IDLE;
     p_bcb->p_pending_data   = NULL;
 
+    /* Back on the free list; the CID no longer finds it */
+    slab_free (&bnep_bcb_slab, p_bcb);
+
     /* Free transmit queue */
     while (p_bcb->xmit_q.count)
     {
@@ -892,6 +894,118 @@ UINT8 *bnep_process_control_packet (tBNEP_CONN *p_bcb, UINT8 *p, UINT16 *rem_len
 }
 
 
+#if (defined (BNEP_SUPPORTS_PROT_FILTERS) && BNEP_SUPPORTS_PROT_FILTERS == TRUE)
+/*******************************************************************************
+**
+** Function         bnepu_common_prot_mask
+**
+** Description      Maps one of the common protocols to its bit in
+**                  rcvd_prot_common.
+**
+** Returns          BNEP_COMMON_PROT_xxx, or 0 for any other protocol
+**
+*******************************************************************************/
+static UINT8 bnepu_common_prot_mask (UINT16 proto)
+{
+    switch (proto)
+    {
+    case BNEP_IPV4_PROTOCOL:
+        return BNEP_COMMON_PROT_IPV4;
+    case BNEP_ARP_PROTOCOL:
+        return BNEP_COMMON_PROT_ARP;
+    case BNEP_IPV6_PROTOCOL:
+        return BNEP_COMMON_PROT_IPV6;
+    }
+    return 0;
+}
+
+
+/*******************************************************************************
+**
+** Function         bnepu_prot_in_filters
+**
+** Description      Binary search of the compiled protocol ranges.
+**
+** Returns          TRUE if the protocol falls within one of the ranges
+**
+*******************************************************************************/
+static BOOLEAN bnepu_prot_in_filters (tBNEP_CONN *p_bcb, UINT16 proto)
+{
+    UINT16  lo = 0, hi = p_bcb->rcvd_prot_ranges, mid;
+
+    /* Find the first range starting above the protocol */
+    while (lo < hi)
+    {
+        mid = (UINT16) ((lo + hi) >> 1);
+        if (p_bcb->rcvd_prot_range_start[mid] <= proto)
+            lo = (UINT16) (mid + 1);
+        else
+            hi = mid;
+    }
+
+    return ((lo > 0) && (proto <= p_bcb->rcvd_prot_range_end[lo - 1]));
+}
+
+
+/*******************************************************************************
+**
+** Function         bnepu_compile_prot_filters
+**
+** Description      Rebuilds the data path view of the received protocol
+**                  filters: the ranges are sorted by start, overlapping or
+**                  adjacent ones merged, and the common protocols looked
+**                  up once so that most packets need a single bit test.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bnepu_compile_prot_filters (tBNEP_CONN *p_bcb)
+{
+    UINT16  xx, yy, n = 0;
+    UINT16  start, end;
+    UINT16  *p_start = p_bcb->rcvd_prot_range_start;
+    UINT16  *p_end   = p_bcb->rcvd_prot_range_end;
+
+    /* Insertion sort, there are at most BNEP_MAX_PROT_FILTERS entries */
+    for (xx = 0; xx < p_bcb->rcvd_num_filters; xx++)
+    {
+        start = p_bcb->rcvd_prot_filter_start[xx];
+        end   = p_bcb->rcvd_prot_filter_end[xx];
+
+        for (yy = xx; (yy > 0) && (p_start[yy - 1] > start); yy--)
+        {
+            p_start[yy] = p_start[yy - 1];
+            p_end[yy]   = p_end[yy - 1];
+        }
+        p_start[yy] = start;
+        p_end[yy]   = end;
+    }
+
+    for (xx = 0; xx < p_bcb->rcvd_num_filters; xx++)
+    {
+        if ((n > 0) && ((UINT32) p_start[xx] <= (UINT32) p_end[n - 1] + 1))
+        {
+            if (p_end[xx] > p_end[n - 1])
+                p_end[n - 1] = p_end[xx];
+            continue;
+        }
+        p_start[n] = p_start[xx];
+        p_end[n]   = p_end[xx];
+        n++;
+    }
+    p_bcb->rcvd_prot_ranges = n;
+
+    p_bcb->rcvd_prot_common = 0;
+    if (bnepu_prot_in_filters (p_bcb, BNEP_IPV4_PROTOCOL))
+        p_bcb->rcvd_prot_common |= BNEP_COMMON_PROT_IPV4;
+    if (bnepu_prot_in_filters (p_bcb, BNEP_ARP_PROTOCOL))
+        p_bcb->rcvd_prot_common |= BNEP_COMMON_PROT_ARP;
+    if (bnepu_prot_in_filters (p_bcb, BNEP_IPV6_PROTOCOL))
+        p_bcb->rcvd_prot_common |= BNEP_COMMON_PROT_IPV6;
+}
+#endif
+
+
 /*******************************************************************************
 **
 ** Function         bnepu_process_peer_filter_set
@@ -967,6 +1081,7 @@ void bnepu_process_peer_filter_set (tBNEP_CONN *p_bcb, UINT8 *p_filters, UINT16
         p_bcb->rcvd_prot_filter_start[xx] = start;
         p_bcb->rcvd_prot_filter_end[xx]   = end;
     }
+    bnepu_compile_prot_filters (p_bcb);
 
     bnepu_send_peer_filter_rsp (p_bcb, resp_code);
 #else
@@ -1079,6 +1194,80 @@ void bnepu_process_multicast_filter_rsp (tBNEP_CONN *p_bcb, UINT8 *p_data)
 
 
 
+#if (defined (BNEP_SUPPORTS_MULTI_FILTERS) && BNEP_SUPPORTS_MULTI_FILTERS == TRUE)
+/*******************************************************************************
+**
+** Function         bnepu_bda_to_uint64
+**
+** Description      Packs an address into an integer that orders the same
+**                  way as a memcmp of the address bytes.
+**
+** Returns          the 48 bit address value
+**
+*******************************************************************************/
+static UINT64 bnepu_bda_to_uint64 (BD_ADDR bda)
+{
+    return (((UINT64) bda[0] << 40) | ((UINT64) bda[1] << 32) |
+            ((UINT64) bda[2] << 24) | ((UINT64) bda[3] << 16) |
+            ((UINT64) bda[4] << 8)  |  (UINT64) bda[5]);
+}
+
+
+/*******************************************************************************
+**
+** Function         bnepu_compile_mcast_filters
+**
+** Description      Rebuilds the data path view of the received multicast
+**                  filters as sorted, merged 48 bit integer ranges.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bnepu_compile_mcast_filters (tBNEP_CONN *p_bcb)
+{
+    UINT16  xx, yy, n = 0;
+    UINT64  start, end;
+    UINT64  *p_start = p_bcb->rcvd_mcast_range_start;
+    UINT64  *p_end   = p_bcb->rcvd_mcast_range_end;
+
+    /* Nothing to search when every multicast is blocked */
+    if (p_bcb->rcvd_mcast_filters == 0xFFFF)
+    {
+        p_bcb->rcvd_mcast_ranges = 0;
+        return;
+    }
+
+    for (xx = 0; xx < p_bcb->rcvd_mcast_filters; xx++)
+    {
+        start = bnepu_bda_to_uint64 (p_bcb->rcvd_mcast_filter_start[xx]);
+        end   = bnepu_bda_to_uint64 (p_bcb->rcvd_mcast_filter_end[xx]);
+
+        for (yy = xx; (yy > 0) && (p_start[yy - 1] > start); yy--)
+        {
+            p_start[yy] = p_start[yy - 1];
+            p_end[yy]   = p_end[yy - 1];
+        }
+        p_start[yy] = start;
+        p_end[yy]   = end;
+    }
+
+    for (xx = 0; xx < p_bcb->rcvd_mcast_filters; xx++)
+    {
+        if ((n > 0) && (p_start[xx] <= p_end[n - 1] + 1))
+        {
+            if (p_end[xx] > p_end[n - 1])
+                p_end[n - 1] = p_end[xx];
+            continue;
+        }
+        p_start[n] = p_start[xx];
+        p_end[n]   = p_end[xx];
+        n++;
+    }
+    p_bcb->rcvd_mcast_ranges = n;
+}
+#endif
+
+
 /*******************************************************************************
 **
 ** Function         bnepu_process_peer_multicast_filter_set
@@ -1153,6 +1342,7 @@ void bnepu_process_peer_multicast_filter_set (tBNEP_CONN *p_bcb, UINT8 *p_filter
             break;
         }
     }
+    bnepu_compile_mcast_filters (p_bcb);
 
     BNEP_TRACE_EVENT ("BNEP multicast filters %d", p_bcb->rcvd_mcast_filters);
     bnepu_send_peer_multicast_filter_rsp (p_bcb, resp_code);
@@ -1327,7 +1517,9 @@ tBNEP_RESULT bnep_is_packet_allowed (tBNEP_CONN *p_bcb,
 #if (defined (BNEP_SUPPORTS_PROT_FILTERS) && BNEP_SUPPORTS_PROT_FILTERS == TRUE)
     if (p_bcb->rcvd_num_filters)
     {
-        UINT16          i, proto;
+        UINT16          proto;
+        UINT8           mask;
+        BOOLEAN         allowed;
 
         /* Findout the actual protocol to check for the filtering */
         proto = protocol;
@@ -1349,14 +1541,14 @@ tBNEP_RESULT bnep_is_packet_allowed (tBNEP_CONN *p_bcb,
             BE_STREAM_TO_UINT16 (proto, p_data);
         }
 
-        for (i=0; i<p_bcb->rcvd_num_filters; i++)
-        {
-            if ((p_bcb->rcvd_prot_filter_start[i] <= proto) &&
-                (proto <= p_bcb->rcvd_prot_filter_end[i]))
-                break;
-        }
+        /* Common protocols were looked up when the filters were set */
+        mask = bnepu_common_prot_mask (proto);
+        if (mask)
+            allowed = ((p_bcb->rcvd_prot_common & mask) != 0);
+        else
+            allowed = bnepu_prot_in_filters (p_bcb, proto);
 
-        if (i == p_bcb->rcvd_num_filters)
+        if (!allowed)
         {
             BNEP_TRACE_DEBUG ("Ignoring protocol 0x%x in BNEP data write", proto);
             return BNEP_IGNORE_CMD;
@@ -1369,25 +1561,23 @@ tBNEP_RESULT bnep_is_packet_allowed (tBNEP_CONN *p_bcb,
     if ((p_dest_addr[0] & 0x01) &&
         p_bcb->rcvd_mcast_filters)
     {
-        UINT16          i;
+        UINT16          lo = 0, hi = p_bcb->rcvd_mcast_ranges, mid;
+        UINT64          addr = bnepu_bda_to_uint64 (p_dest_addr);
 
-        /* Check if every multicast should be filtered */
-        if (p_bcb->rcvd_mcast_filters != 0xFFFF)
+        /* Find the first compiled range starting above the address. When every
+        ** multicast is filtered there are no ranges and the search finds nothing.
+        */
+        while (lo < hi)
         {
-            /* Check if the address is mentioned in the filter range */
-            for (i = 0; i < p_bcb->rcvd_mcast_filters; i++)
-            {
-                if ((memcmp (p_bcb->rcvd_mcast_filter_start[i], p_dest_addr, BD_ADDR_LEN) <= 0) &&
-                    (memcmp (p_bcb->rcvd_mcast_filter_end[i], p_dest_addr, BD_ADDR_LEN) >= 0))
-                    break;
-            }
+            mid = (UINT16) ((lo + hi) >> 1);
+            if (p_bcb->rcvd_mcast_range_start[mid] <= addr)
+                lo = (UINT16) (mid + 1);
+            else
+                hi = mid;
         }
 
-        /*
-        ** If every multicast should be filtered or the address is not in the filter range
-        ** drop the packet
-        */
-        if ((p_bcb->rcvd_mcast_filters == 0xFFFF) || (i == p_bcb->rcvd_mcast_filters))
+        /* Drop the packet if the address is not in the filter range */
+        if ((lo == 0) || (addr > p_bcb->rcvd_mcast_range_end[lo - 1]))
         {
             BNEP_TRACE_DEBUG ("Ignoring multicast address %x.%x.%x.%x.%x.%x in BNEP data write",
                 p_dest_addr[0], p_dest_addr[1], p_dest_addr[2],
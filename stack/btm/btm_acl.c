@@ -39,6 +39,7 @@
 #include "hcidefs.h"
 #include "bd.h"
 #include "bt_utils.h"
+#include "interop.h"
 
 static void btm_read_remote_features (UINT16 handle);
 static void btm_read_remote_ext_features (UINT16 handle, UINT8 page_number);
@@ -48,35 +49,19 @@ static void btm_process_remote_ext_features (tACL_CONN *p_acl_cb, UINT8 num_read
 
 #define BTM_DEV_REPLY_TIMEOUT   3       /* 3 second timeout waiting for responses */
 
-/* Black listed car kits/headsets for role switch */
-static const UINT8 btm_role_switch_black_list_prefix[][3] = {{0x00, 0x0d, 0xfd}, /* MOT EQ5 */
-                                                             {0x00, 0x1b, 0xdc}  /* BSHSBE20 */
-                                                            };
-
 /*******************************************************************************
 **
 ** Function         btm_blacklistted_for_role_switch
 **
 ** Description      This function is called to find the blacklisted carkits
-**                  for role switch.
+**                  for role switch. The list lives in the interop database.
 **
 ** Returns          TRUE, if black listed
 **
 *******************************************************************************/
 BOOLEAN btm_blacklistted_for_role_switch (BD_ADDR addr)
 {
-    int blacklistsize = 0;
-    int i =0;
-
-    blacklistsize = sizeof(btm_role_switch_black_list_prefix)/sizeof(btm_role_switch_black_list_prefix[0]);
-    for (i=0; i < blacklistsize; i++)
-    {
-        if (0 == memcmp(btm_role_switch_black_list_prefix[i], addr, 3))
-        {
-            return TRUE;
-        }
-    }
-    return FALSE;
+    return interop_match_addr(INTEROP_DISABLE_ROLE_SWITCH, addr);
 }
 
 /*******************************************************************************
@@ -69,7 +69,6 @@ BOOLEAN BTM_SecAddBleDevice (BD_ADDR bd_addr, BD_NAME bd_name, tBT_DEVICE_TYPE d
                              tBLE_ADDR_TYPE addr_type)
 {
     tBTM_SEC_DEV_REC  *p_dev_rec;
-    UINT8               i = 0;
     tBTM_INQ_INFO      *p_info=NULL;
 
     BTM_TRACE_DEBUG ("BTM_SecAddBleDevice dev_type=0x%x", dev_type);
@@ -80,34 +79,21 @@ BOOLEAN BTM_SecAddBleDevice (BD_ADDR bd_addr, BD_NAME bd_name, tBT_DEVICE_TYPE d
         BTM_TRACE_DEBUG("Add a new device");
 
         /* There is no device record, allocate one.
-         * If we can not find an empty spot for this one, let it fail. */
-        for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++)
-        {
-            if (!(btm_cb.sec_dev_rec[i].sec_flags & BTM_SEC_IN_USE))
-            {
-                BTM_TRACE_DEBUG ("allocate a new dev rec idx=0x%x ", i );
-                p_dev_rec = &btm_cb.sec_dev_rec[i];
-
-                /* Mark this record as in use and initialize */
-                memset (p_dev_rec, 0, sizeof (tBTM_SEC_DEV_REC));
-                p_dev_rec->sec_flags = BTM_SEC_IN_USE;
-                memcpy (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
-                p_dev_rec->hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_BR_EDR);
-                p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_LE);
-
-                /* update conn params, use default value for background connection params */
-                p_dev_rec->conn_params.min_conn_int     =
-                p_dev_rec->conn_params.max_conn_int     =
-                p_dev_rec->conn_params.supervision_tout =
-                p_dev_rec->conn_params.slave_latency    = BTM_BLE_CONN_PARAM_UNDEF;
-
-                BTM_TRACE_DEBUG ("hci_handl=0x%x ",  p_dev_rec->ble_hci_handle );
-                break;
-            }
-        }
-
-        if (!p_dev_rec)
+         * If we can not find an empty or idle spot for this one, let it fail. */
+        if ((p_dev_rec = btm_sec_alloc_rec (bd_addr)) == NULL)
             return(FALSE);
+
+        p_dev_rec->hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_BR_EDR);
+        p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_LE);
+        p_dev_rec->timestamp = btm_cb.dev_rec_count++;
+
+        /* update conn params, use default value for background connection params */
+        p_dev_rec->conn_params.min_conn_int     =
+        p_dev_rec->conn_params.max_conn_int     =
+        p_dev_rec->conn_params.supervision_tout =
+        p_dev_rec->conn_params.slave_latency    = BTM_BLE_CONN_PARAM_UNDEF;
+
+        BTM_TRACE_DEBUG ("hci_handl=0x%x ",  p_dev_rec->ble_hci_handle );
     }
     else
     {
@@ -86,62 +86,6 @@ tBTM_STATUS btm_ble_obtain_vsc_details()
     return st;
 }
 
-/*******************************************************************************
-**
-** Function         btm_ble_advfilt_enq_op_q
-**
-** Description      enqueue an adv filter operation in q to check command complete
-**                  status
-**
-** Returns          void
-**
-*******************************************************************************/
-void btm_ble_advfilt_enq_op_q(UINT8 action, UINT8 ocf, tBTM_BLE_FILT_CB_EVT cb_evt,
-                              tBTM_BLE_REF_VALUE ref, tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback,
-                              tBTM_BLE_PF_PARAM_CBACK  *p_filt_param_cback)
-{
-    btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.next_idx] = (action |(ocf << 4));
-    btm_ble_adv_filt_cb.op_q.ref_value[btm_ble_adv_filt_cb.op_q.next_idx] = ref;
-    btm_ble_adv_filt_cb.op_q.cb_evt[btm_ble_adv_filt_cb.op_q.next_idx] = cb_evt;
-    btm_ble_adv_filt_cb.op_q.p_scan_cfg_cback[btm_ble_adv_filt_cb.op_q.next_idx] = p_cmpl_cback;
-    btm_ble_adv_filt_cb.op_q.p_filt_param_cback[btm_ble_adv_filt_cb.op_q.next_idx]
-        = p_filt_param_cback;
-    BTM_TRACE_DEBUG("btm_ble_advfilt_enq_op_q: act_ocf:%d, action:%d, ocf:%d,cb_evt;%d, cback:%x",
-        btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.next_idx], action,
-        ocf, cb_evt, p_cmpl_cback);
-    btm_ble_adv_filt_cb.op_q.next_idx = (btm_ble_adv_filt_cb.op_q.next_idx + 1)
-                    % BTM_BLE_PF_TYPE_MAX;
-}
-
-/*******************************************************************************
-**
-** Function         btm_ble_advfilt_deq_op_q
-**
-** Description      dequeue an adv filter operation from q when command complete
-**                  is received
-**
-** Returns          void
-**
-*******************************************************************************/
-void btm_ble_advfilt_deq_op_q(UINT8 *p_action,UINT8 *p_ocf, tBTM_BLE_FILT_CB_EVT *p_cb_evt,
-                              tBTM_BLE_REF_VALUE *p_ref, tBTM_BLE_PF_CFG_CBACK ** p_cmpl_cback,
-                              tBTM_BLE_PF_PARAM_CBACK  **p_filt_param_cback)
-{
-    *p_ocf = (btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.pending_idx] >> 4);
-    *p_action = (btm_ble_adv_filt_cb.op_q.action_ocf[btm_ble_adv_filt_cb.op_q.pending_idx]
-                & BTM_BLE_ADV_FILT_SUBCODE_MASK);
-    *p_ref = btm_ble_adv_filt_cb.op_q.ref_value[btm_ble_adv_filt_cb.op_q.pending_idx];
-    *p_cb_evt = btm_ble_adv_filt_cb.op_q.cb_evt[btm_ble_adv_filt_cb.op_q.pending_idx];
-    *p_cmpl_cback = btm_ble_adv_filt_cb.op_q.p_scan_cfg_cback[btm_ble_adv_filt_cb.op_q.pending_idx];
-    *p_filt_param_cback =
-        btm_ble_adv_filt_cb.op_q.p_filt_param_cback[btm_ble_adv_filt_cb.op_q.pending_idx];
-
-    btm_ble_adv_filt_cb.op_q.pending_idx = (btm_ble_adv_filt_cb.op_q.pending_idx + 1)
-        % BTM_BLE_PF_TYPE_MAX;
-    BTM_TRACE_DEBUG("btm_ble_advfilt_deq_op_q: ocf:%d, action:%d, ref_value:%d, cb_evt:%x",
-        *p_ocf,*p_action, *p_ref, *p_cb_evt);
-}
-
 /*******************************************************************************
 **
 ** Function         btm_ble_condtype_to_ocf
@@ -250,17 +194,21 @@ void btm_ble_scan_pf_cmpl_cback(tBTM_VSC_CMPL *p_params)
     tBTM_BLE_REF_VALUE ref_value = 0;
     tBTM_BLE_PF_CFG_CBACK *p_scan_cfg_cback = NULL;
     tBTM_BLE_PF_PARAM_CBACK *p_filt_param_cback = NULL;
+    tBTM_BLE_ADV_FILT_OP op;
 
-    if (evt_len < 3 || evt_len > 4)
+    if (evt_len < 3 || evt_len > 4 || p_params->context_len != sizeof(op))
     {
         BTM_TRACE_ERROR("cannot interpret APCF callback status = %d, length = %d", status, evt_len);
-        btm_ble_advfilt_deq_op_q(&action, &ocf, &cb_evt, &ref_value, &p_scan_cfg_cback,
-                                 &p_filt_param_cback);
         return;
     }
 
-    btm_ble_advfilt_deq_op_q(&action, &ocf, &cb_evt, &ref_value, &p_scan_cfg_cback,
-                             &p_filt_param_cback);
+    /* the operation this command was sent for */
+    memcpy(&op, p_params->p_context, sizeof(op));
+    ocf = op.ocf;
+    cb_evt = op.cb_evt;
+    ref_value = op.ref_value;
+    p_scan_cfg_cback = op.p_scan_cfg_cback;
+    p_filt_param_cback = op.p_filt_param_cback;
 
     STREAM_TO_UINT8(status, p);
     STREAM_TO_UINT8(op_subcode, p);
@@ -343,6 +291,44 @@ void btm_ble_scan_pf_cmpl_cback(tBTM_VSC_CMPL *p_params)
     }
 }
 
+/*******************************************************************************
+**
+** Function         btm_ble_advfilt_vsc
+**
+** Description      send an adv filter VSC, carrying the operation with it so the
+**                  command complete status can be matched to it
+**
+** Parameters       len, p_param - command parameters, starting with the sub code
+**                                 and the action
+**                  cb_evt - event to report on completion
+**                  ref_value - reference value
+**                  p_cmpl_cback - config callback, for BTM_BLE_FILT_CFG
+**                  p_filt_param_cback - param callback, for BTM_BLE_FILT_ADV_PARAM
+**
+** Returns          status
+**
+*******************************************************************************/
+static tBTM_STATUS btm_ble_advfilt_vsc(UINT8 len, UINT8 *p_param, tBTM_BLE_FILT_CB_EVT cb_evt,
+                                       tBTM_BLE_REF_VALUE ref_value,
+                                       tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback,
+                                       tBTM_BLE_PF_PARAM_CBACK *p_filt_param_cback)
+{
+    tBTM_BLE_ADV_FILT_OP op;
+
+    op.ocf = p_param[0];
+    op.action = p_param[1];
+    op.cb_evt = cb_evt;
+    op.ref_value = ref_value;
+    op.p_scan_cfg_cback = p_cmpl_cback;
+    op.p_filt_param_cback = p_filt_param_cback;
+    BTM_TRACE_DEBUG("btm_ble_advfilt_vsc: action:%d, ocf:%d,cb_evt;%d, cback:%x",
+        op.action, op.ocf, cb_evt, p_cmpl_cback);
+
+    return BTM_VendorSpecificCommandWithContext(HCI_BLE_ADV_FILTER_OCF, len, p_param,
+                                                btm_ble_scan_pf_cmpl_cback,
+                                                &op, sizeof(op));
+}
+
 /*******************************************************************************
 **
 ** Function         btm_ble_find_addr_filter_counter
@@ -442,7 +428,10 @@ BOOLEAN btm_ble_dealloc_addr_filter_counter(tBLE_BD_ADDR *p_bd_addr, UINT8 filte
 *******************************************************************************/
 tBTM_STATUS btm_ble_update_pf_local_name(tBTM_BLE_SCAN_COND_OP action,
                                          tBTM_BLE_PF_FILT_INDEX filt_index,
-                                         tBTM_BLE_PF_COND_PARAM *p_cond)
+                                         tBTM_BLE_PF_COND_PARAM *p_cond,
+                                         tBTM_BLE_FILT_CB_EVT cb_evt,
+                                         tBTM_BLE_REF_VALUE ref_value,
+                                         tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     tBTM_BLE_PF_LOCAL_NAME_COND *p_local_name = (p_cond == NULL) ? NULL : &p_cond->local_name;
     UINT8       param[BTM_BLE_PF_STR_LEN_MAX + BTM_BLE_ADV_FILT_META_HDR_LENGTH],
@@ -472,10 +461,7 @@ tBTM_STATUS btm_ble_update_pf_local_name(tBTM_BLE_SCAN_COND_OP action,
     }
 
     /* send local name filter */
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              len,
-                              param,
-                              btm_ble_scan_pf_cmpl_cback))
+    if ((st = btm_ble_advfilt_vsc(len, param, cb_evt, ref_value, p_cmpl_cback, NULL))
             != BTM_NO_RESOURCES)
     {
         memset(&btm_ble_adv_filt_cb.cur_filter_target, 0, sizeof(tBLE_BD_ADDR));
@@ -532,7 +518,8 @@ tBTM_STATUS btm_ble_update_pf_manu_data(tBTM_BLE_SCAN_COND_OP action,
                                         tBTM_BLE_PF_COND_PARAM *p_data,
                                         tBTM_BLE_PF_COND_TYPE cond_type,
                                         tBTM_BLE_FILT_CB_EVT cb_evt,
-                                        tBTM_BLE_REF_VALUE ref_value)
+                                        tBTM_BLE_REF_VALUE ref_value,
+                                        tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     tBTM_BLE_PF_MANU_COND *p_manu_data = (p_data == NULL) ? NULL : &p_data->manu_data;
     tBTM_BLE_PF_SRVC_PATTERN_COND *p_srvc_data = (p_data == NULL) ? NULL : &p_data->srvc_data;
@@ -624,10 +611,8 @@ tBTM_STATUS btm_ble_update_pf_manu_data(tBTM_BLE_SCAN_COND_OP action,
     }
 
     /* send manufacturer*/
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              len,
-                              param,
-                              btm_ble_scan_pf_cmpl_cback)) != BTM_NO_RESOURCES)
+    if ((st = btm_ble_advfilt_vsc(len, param, cb_evt, ref_value, p_cmpl_cback, NULL))
+            != BTM_NO_RESOURCES)
     {
         memset(&btm_ble_adv_filt_cb.cur_filter_target, 0, sizeof(tBLE_BD_ADDR));
     }
@@ -721,7 +706,10 @@ UINT8 btm_ble_cs_update_pf_counter(tBTM_BLE_SCAN_COND_OP action,
 *******************************************************************************/
 tBTM_STATUS btm_ble_update_addr_filter(tBTM_BLE_SCAN_COND_OP action,
                                        tBTM_BLE_PF_FILT_INDEX filt_index,
-                                       tBTM_BLE_PF_COND_PARAM *p_cond)
+                                       tBTM_BLE_PF_COND_PARAM *p_cond,
+                                       tBTM_BLE_FILT_CB_EVT cb_evt,
+                                       tBTM_BLE_REF_VALUE ref_value,
+                                       tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     UINT8       param[BTM_BLE_META_ADDR_LEN + BTM_BLE_ADV_FILT_META_HDR_LENGTH],
                 * p= param;
@@ -746,10 +734,8 @@ tBTM_STATUS btm_ble_update_addr_filter(tBTM_BLE_SCAN_COND_OP action,
         UINT8_TO_STREAM(p, p_addr->type);
     }
     /* send address filter */
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_META_ADDR_LEN),
-                              param,
-                              btm_ble_scan_pf_cmpl_cback)) != BTM_NO_RESOURCES)
+    if ((st = btm_ble_advfilt_vsc((UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_META_ADDR_LEN),
+                              param, cb_evt, ref_value, p_cmpl_cback, NULL)) != BTM_NO_RESOURCES)
     {
         memset(&btm_ble_adv_filt_cb.cur_filter_target, 0, sizeof(tBLE_BD_ADDR));
     }
@@ -776,7 +762,8 @@ tBTM_STATUS btm_ble_update_uuid_filter(tBTM_BLE_SCAN_COND_OP action,
                                        tBTM_BLE_PF_COND_TYPE filter_type,
                                        tBTM_BLE_PF_COND_PARAM *p_cond,
                                        tBTM_BLE_FILT_CB_EVT cb_evt,
-                                       tBTM_BLE_REF_VALUE ref_value)
+                                       tBTM_BLE_REF_VALUE ref_value,
+                                       tBTM_BLE_PF_CFG_CBACK *p_cmpl_cback)
 {
     UINT8       param[BTM_BLE_META_UUID_LEN + BTM_BLE_ADV_FILT_META_HDR_LENGTH],
                 * p= param,
@@ -818,17 +805,15 @@ tBTM_STATUS btm_ble_update_uuid_filter(tBTM_BLE_SCAN_COND_OP action,
         BDADDR_TO_STREAM(p, p_uuid_cond->p_target_addr->bda);
         UINT8_TO_STREAM(p, p_uuid_cond->p_target_addr->type);
 
-        /* send address filter */
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
+        /* send address filter, the user is only told about the UUID filter */
+        if ((st = btm_ble_advfilt_vsc(
                                   (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_META_ADDR_LEN),
-                                  param,
-                                  btm_ble_scan_pf_cmpl_cback)) == BTM_NO_RESOURCES)
+                                  param, 0, ref_value, NULL, NULL)) == BTM_NO_RESOURCES)
         {
             BTM_TRACE_ERROR("Update Address filter into controller failed.");
             return st;
         }
 
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_ADDR, cb_evt, ref_value, NULL, NULL);
         BTM_TRACE_DEBUG("Updated Address filter");
     }
 
@@ -892,10 +877,8 @@ tBTM_STATUS btm_ble_update_uuid_filter(tBTM_BLE_SCAN_COND_OP action,
     }
 
     /* send UUID filter update */
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              len,
-                              param,
-                              btm_ble_scan_pf_cmpl_cback)) != BTM_NO_RESOURCES)
+    if ((st = btm_ble_advfilt_vsc(len, param, cb_evt, ref_value, p_cmpl_cback, NULL))
+            != BTM_NO_RESOURCES)
     {
         if (p_uuid_cond && p_uuid_cond->p_target_addr)
             memcpy(&btm_ble_adv_filt_cb.cur_filter_target, p_uuid_cond->p_target_addr,
@@ -959,38 +942,25 @@ tBTM_STATUS btm_ble_clear_scan_pf_filter(tBTM_BLE_SCAN_COND_OP action,
     {
         /* clear manufactuer data filter */
         st = btm_ble_update_pf_manu_data(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL,
-                                    BTM_BLE_PF_MANU_DATA, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_MANU_DATA, cb_evt,
-                                    ref_value, NULL, NULL);
+                                    BTM_BLE_PF_MANU_DATA, cb_evt, ref_value, NULL);
 
         /* clear local name filter */
-        st = btm_ble_update_pf_local_name(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_LOCAL_NAME, cb_evt,
-                                    ref_value, NULL, NULL);
+        st = btm_ble_update_pf_local_name(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL,
+                                    cb_evt, ref_value, NULL);
 
         /* update the counter for service data */
         st = btm_ble_update_srvc_data_change(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL);
 
         /* clear UUID filter */
         st = btm_ble_update_uuid_filter(BTM_BLE_SCAN_COND_CLEAR, filt_index,
-                                   BTM_BLE_PF_SRVC_UUID, NULL, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_UUID, cb_evt, ref_value, NULL, NULL);
+                                   BTM_BLE_PF_SRVC_UUID, NULL, cb_evt, ref_value, NULL);
 
         st = btm_ble_update_uuid_filter(BTM_BLE_SCAN_COND_CLEAR, filt_index,
-                                   BTM_BLE_PF_SRVC_SOL_UUID, NULL, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_SOL_UUID, cb_evt,
-                                    ref_value, NULL, NULL);
+                                   BTM_BLE_PF_SRVC_SOL_UUID, NULL, cb_evt, ref_value, NULL);
 
         /* clear service data filter */
         st = btm_ble_update_pf_manu_data(BTM_BLE_SCAN_COND_CLEAR, filt_index, NULL,
-                                    BTM_BLE_PF_SRVC_DATA_PATTERN, cb_evt, ref_value);
-        if(BTM_CMD_STARTED == st)
-           btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_SRVC_DATA, cb_evt,
-                                    ref_value, NULL, NULL);
+                                    BTM_BLE_PF_SRVC_DATA_PATTERN, cb_evt, ref_value, NULL);
     }
 
     /* select feature based on control block settings */
@@ -1005,10 +975,9 @@ tBTM_STATUS btm_ble_clear_scan_pf_filter(tBTM_BLE_SCAN_COND_OP action,
     /* set logic condition as OR as default */
     UINT8_TO_STREAM(p, BTM_BLE_PF_LOGIC_OR);
 
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
+    if ((st = btm_ble_advfilt_vsc(
                                (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_PF_FEAT_SEL_LEN),
-                                param,
-                                btm_ble_scan_pf_cmpl_cback))
+                                param, BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback, NULL))
             != BTM_NO_RESOURCES)
     {
         if (p_target)
@@ -1095,16 +1064,12 @@ tBTM_STATUS BTM_BleAdvFilterParamSetup(int action, tBTM_BLE_PF_FILT_INDEX filt_i
 
         len = BTM_BLE_ADV_FILT_META_HDR_LENGTH + BTM_BLE_ADV_FILT_FEAT_SELN_LEN;
 
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                                (UINT8)len,
-                                 param,
-                                 btm_ble_scan_pf_cmpl_cback))
+        if ((st = btm_ble_advfilt_vsc((UINT8)len, param, BTM_BLE_FILT_ADV_PARAM,
+                                      ref_value, NULL, p_cmpl_cback))
                == BTM_NO_RESOURCES)
         {
             return st;
         }
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL, BTM_BLE_FILT_ADV_PARAM,
-                                 ref_value, NULL, p_cmpl_cback);
     }
     else
     if (BTM_BLE_SCAN_COND_DELETE == action)
@@ -1115,16 +1080,12 @@ tBTM_STATUS BTM_BleAdvFilterParamSetup(int action, tBTM_BLE_PF_FILT_INDEX filt_i
         /* Filter index */
         UINT8_TO_STREAM(p, filt_index);
 
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                                (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH),
-                                 param,
-                                 btm_ble_scan_pf_cmpl_cback))
+        if ((st = btm_ble_advfilt_vsc((UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH), param,
+                                      BTM_BLE_FILT_ADV_PARAM, ref_value, NULL, p_cmpl_cback))
                == BTM_NO_RESOURCES)
         {
             return st;
         }
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL,  BTM_BLE_FILT_ADV_PARAM,
-                                 ref_value, NULL, p_cmpl_cback);
     }
     else
     if (BTM_BLE_SCAN_COND_CLEAR == action)
@@ -1136,16 +1097,12 @@ tBTM_STATUS BTM_BleAdvFilterParamSetup(int action, tBTM_BLE_PF_FILT_INDEX filt_i
         UINT8_TO_STREAM(p, BTM_BLE_META_PF_FEAT_SEL);
         UINT8_TO_STREAM(p, BTM_BLE_SCAN_COND_CLEAR);
 
-        if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                                (UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH-1),
-                                 param,
-                                 btm_ble_scan_pf_cmpl_cback))
+        if ((st = btm_ble_advfilt_vsc((UINT8)(BTM_BLE_ADV_FILT_META_HDR_LENGTH-1), param,
+                                      BTM_BLE_FILT_ADV_PARAM, ref_value, NULL, p_cmpl_cback))
                == BTM_NO_RESOURCES)
         {
             return st;
         }
-        btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL,  BTM_BLE_FILT_ADV_PARAM,
-                                 ref_value, NULL, p_cmpl_cback);
     }
 
     return st;
@@ -1183,13 +1140,10 @@ tBTM_STATUS BTM_BleEnableDisableFilterFeature(UINT8 enable,
     /* enable adv data payload filtering */
     UINT8_TO_STREAM(p, enable);
 
-    if ((st = BTM_VendorSpecificCommand (HCI_BLE_ADV_FILTER_OCF,
-                              BTM_BLE_PCF_ENABLE_LEN, param,
-                              btm_ble_scan_pf_cmpl_cback)) == BTM_CMD_STARTED)
+    if ((st = btm_ble_advfilt_vsc(BTM_BLE_PCF_ENABLE_LEN, param, BTM_BLE_FILT_ENABLE_DISABLE,
+                                  ref_value, NULL, NULL)) == BTM_CMD_STARTED)
     {
          btm_ble_adv_filt_cb.p_filt_stat_cback = p_stat_cback;
-         btm_ble_advfilt_enq_op_q(enable, BTM_BLE_META_PF_ENABLE, BTM_BLE_FILT_ENABLE_DISABLE,
-                                  ref_value, NULL, NULL);
     }
     return st;
 }
@@ -1219,7 +1173,6 @@ tBTM_STATUS BTM_BleCfgFilterCondition(tBTM_BLE_SCAN_COND_OP action,
                                       tBTM_BLE_REF_VALUE ref_value)
 {
     tBTM_STATUS     st = BTM_ILLEGAL_VALUE;
-    UINT8 ocf = 0;
     BTM_TRACE_EVENT (" BTM_BleCfgFilterCondition action:%d, cond_type:%d, index:%d", action,
                         cond_type, filt_index);
 
@@ -1232,23 +1185,27 @@ tBTM_STATUS BTM_BleCfgFilterCondition(tBTM_BLE_SCAN_COND_OP action,
         case BTM_BLE_PF_SRVC_DATA_PATTERN:
         /* write manufacturer data filter */
         case BTM_BLE_PF_MANU_DATA:
-            st = btm_ble_update_pf_manu_data(action, filt_index, p_cond, cond_type, 0, ref_value);
+            st = btm_ble_update_pf_manu_data(action, filt_index, p_cond, cond_type,
+                                             BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         /* write local name filter */
         case BTM_BLE_PF_LOCAL_NAME:
-            st = btm_ble_update_pf_local_name(action, filt_index, p_cond);
+            st = btm_ble_update_pf_local_name(action, filt_index, p_cond,
+                                              BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         /* filter on advertiser address */
         case BTM_BLE_PF_ADDR_FILTER:
-            st = btm_ble_update_addr_filter(action, filt_index, p_cond);
+            st = btm_ble_update_addr_filter(action, filt_index, p_cond,
+                                            BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         /* filter on service/solicitated UUID */
         case BTM_BLE_PF_SRVC_UUID:
         case BTM_BLE_PF_SRVC_SOL_UUID:
-            st = btm_ble_update_uuid_filter(action, filt_index, cond_type, p_cond, 0, ref_value);
+            st = btm_ble_update_uuid_filter(action, filt_index, cond_type, p_cond,
+                                            BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback);
             break;
 
         case BTM_BLE_PF_SRVC_DATA:
@@ -1265,17 +1222,6 @@ tBTM_STATUS BTM_BleCfgFilterCondition(tBTM_BLE_SCAN_COND_OP action,
             break;
     }
 
-    if(BTM_CMD_STARTED == st && cond_type != BTM_BLE_PF_TYPE_ALL)
-    {
-       ocf = btm_ble_condtype_to_ocf(cond_type);
-       btm_ble_advfilt_enq_op_q(action, ocf, BTM_BLE_FILT_CFG, ref_value, p_cmpl_cback, NULL);
-    }
-    else
-    if(BTM_CMD_STARTED == st && BTM_BLE_PF_TYPE_ALL == cond_type)
-    {
-       btm_ble_advfilt_enq_op_q(action, BTM_BLE_META_PF_FEAT_SEL, BTM_BLE_FILT_CFG,
-                                ref_value, p_cmpl_cback, NULL);
-    }
     return st;
 }
 
@@ -90,26 +90,35 @@ void btm_ble_batchscan_filter_track_adv_vse_cback(UINT8 len, UINT8 *p)
 
 /*******************************************************************************
 **
-** Function         btm_ble_batchscan_enq_op_q
+** Function         btm_ble_batchscan_vsc
 **
-** Description      enqueue a batchscan operation in q to check command complete
-**                  status
+** Description      send a batchscan VSC, carrying the operation with it so the
+**                  command complete status can be matched to it
 **
-** Returns          void
+** Parameters       len, p_param - command parameters, starting with the sub code
+**                  cur_state - state to report on completion
+**                  cb_evt - event to report to the user, 0 for none
+**                  ref_value - reference value
+**
+** Returns          status
 **
 *******************************************************************************/
-void btm_ble_batchscan_enq_op_q(UINT8 opcode, tBTM_BLE_BATCH_SCAN_STATE cur_state,
-                                          UINT8 cb_evt, tBTM_BLE_REF_VALUE ref_value)
+static tBTM_STATUS btm_ble_batchscan_vsc(UINT8 len, UINT8 *p_param,
+                                         tBTM_BLE_BATCH_SCAN_STATE cur_state,
+                                         UINT8 cb_evt, tBTM_BLE_REF_VALUE ref_value)
 {
-    ble_batchscan_cb.op_q.sub_code[ble_batchscan_cb.op_q.next_idx] = (opcode |(cb_evt << 4));
-    ble_batchscan_cb.op_q.cur_state[ble_batchscan_cb.op_q.next_idx] = cur_state;
-    ble_batchscan_cb.op_q.ref_value[ble_batchscan_cb.op_q.next_idx] = ref_value;
-    BTM_TRACE_DEBUG("btm_ble_batchscan_enq_op_q: subcode:%d, Cur_state:%d, ref_value:%d",
-        ble_batchscan_cb.op_q.sub_code[ble_batchscan_cb.op_q.next_idx],
-        ble_batchscan_cb.op_q.cur_state[ble_batchscan_cb.op_q.next_idx],
-        ble_batchscan_cb.op_q.ref_value[ble_batchscan_cb.op_q.next_idx]);
-    ble_batchscan_cb.op_q.next_idx = (ble_batchscan_cb.op_q.next_idx + 1)
-                                        % BTM_BLE_BATCH_SCAN_MAX;
+    tBTM_BLE_BATCH_SCAN_OP op;
+
+    op.sub_code = p_param[0];
+    op.cur_state = cur_state;
+    op.cb_evt = cb_evt;
+    op.ref_value = ref_value;
+    BTM_TRACE_DEBUG("btm_ble_batchscan_vsc: subcode:%d, Cur_state:%d, ref_value:%d",
+        op.sub_code, op.cur_state, op.ref_value);
+
+    return BTM_VendorSpecificCommandWithContext(HCI_BLE_BATCH_SCAN_OCF, len, p_param,
+                                                btm_ble_batchscan_vsc_cmpl_cback,
+                                                &op, sizeof(op));
 }
 
 /*******************************************************************************
@@ -246,28 +255,6 @@ void btm_ble_batchscan_deq_rep_data(UINT8 report_format, tBTM_BLE_REF_VALUE *p_r
                                             % BTM_BLE_BATCH_SCAN_MAX;
 }
 
-/*******************************************************************************
-**
-** Function         btm_ble_batchscan_deq_op_q
-**
-** Description      dequeue a batch scan operation from q when command complete
-**                  is received
-**
-** Returns          void
-**
-*******************************************************************************/
-void btm_ble_batchscan_deq_op_q(UINT8 *p_opcode,tBTM_BLE_BATCH_SCAN_STATE *cur_state,
-                                          UINT8 *p_cb_evt, tBTM_BLE_REF_VALUE *p_ref)
-{
-    *p_cb_evt = (ble_batchscan_cb.op_q.sub_code[ble_batchscan_cb.op_q.pending_idx] >> 4);
-    *p_opcode = (ble_batchscan_cb.op_q.sub_code[ble_batchscan_cb.op_q.pending_idx]
-                                            & BTM_BLE_BATCH_SCAN_SUBCODE_MASK);
-    *p_ref = ble_batchscan_cb.op_q.ref_value[ble_batchscan_cb.op_q.pending_idx];
-    *cur_state = (ble_batchscan_cb.op_q.cur_state[ble_batchscan_cb.op_q.pending_idx]);
-    ble_batchscan_cb.op_q.pending_idx = (ble_batchscan_cb.op_q.pending_idx + 1)
-                                            % BTM_BLE_BATCH_SCAN_MAX;
-}
-
 /*******************************************************************************
 **
 ** Function         btm_ble_read_batchscan_reports
@@ -292,21 +279,15 @@ tBTM_STATUS btm_ble_read_batchscan_reports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
     UINT8_TO_STREAM (pp, BTM_BLE_BATCH_SCAN_READ_RESULTS);
     UINT8_TO_STREAM (pp, scan_mode);
 
-    if ((status = BTM_VendorSpecificCommand (HCI_BLE_BATCH_SCAN_OCF,
-            BTM_BLE_BATCH_SCAN_READ_RESULTS_LEN, param, btm_ble_batchscan_vsc_cmpl_cback))
+    /* The user needs to be provided scan read reports event */
+    if ((status = btm_ble_batchscan_vsc(BTM_BLE_BATCH_SCAN_READ_RESULTS_LEN, param,
+            ble_batchscan_cb.cur_state, BTM_BLE_BATCH_SCAN_READ_REPTS_EVT, ref_value))
             != BTM_CMD_STARTED)
     {
         BTM_TRACE_ERROR("btm_ble_read_batchscan_reports %d", status);
         return BTM_ILLEGAL_VALUE;
     }
 
-    if (BTM_CMD_STARTED == status)
-    {
-        /* The user needs to be provided scan read reports event */
-        btm_ble_batchscan_enq_op_q(BTM_BLE_BATCH_SCAN_READ_RESULTS, ble_batchscan_cb.cur_state,
-                                   BTM_BLE_BATCH_SCAN_READ_REPTS_EVT, ref_value);
-    }
-
     return status;
 }
 
@@ -334,18 +315,23 @@ void btm_ble_batchscan_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
     tBTM_BLE_BATCH_SCAN_STATE cur_state = 0;
     tBTM_STATUS btm_status = 0;
     UINT8 *p_data = NULL;
+    tBTM_BLE_BATCH_SCAN_OP op;
 
-    if (len < 2)
+    if (len < 2 || p_params->context_len != sizeof(op))
     {
         BTM_TRACE_ERROR("wrong length for btm_ble_batch_scan_vsc_cmpl_cback");
-        btm_ble_batchscan_deq_op_q(&opcode, &cur_state, &cb_evt, &ref_value);
         return;
     }
 
     STREAM_TO_UINT8(status, p);
     STREAM_TO_UINT8(subcode, p);
 
-    btm_ble_batchscan_deq_op_q(&opcode, &cur_state, &cb_evt, &ref_value);
+    /* the operation this command was sent for */
+    memcpy(&op, p_params->p_context, sizeof(op));
+    opcode = op.sub_code;
+    cur_state = op.cur_state;
+    cb_evt = op.cb_evt;
+    ref_value = op.ref_value;
 
     BTM_TRACE_DEBUG("btm_ble_batchscan op_code = %02x state = %02x cb_evt = %02x,ref_value=%d",
         opcode, cur_state, cb_evt, ref_value);
@@ -464,12 +450,14 @@ void btm_ble_batchscan_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
 ** Parameters       batch_scan_full_max -Max storage space (in %) allocated to full scanning
 **                  batch_scan_trunc_max -Max storage space (in %) allocated to truncated scanning
 **                  batch_scan_notify_threshold - Setup notification level based on total space
+**                  ref_value - Reference value
 **
 ** Returns          status
 **
 *******************************************************************************/
 tBTM_STATUS btm_ble_set_storage_config(UINT8 batch_scan_full_max, UINT8 batch_scan_trunc_max,
-                                       UINT8 batch_scan_notify_threshold)
+                                       UINT8 batch_scan_notify_threshold,
+                                       tBTM_BLE_REF_VALUE ref_value)
 {
     tBTM_STATUS     status = BTM_NO_RESOURCES;
     UINT8 param[BTM_BLE_BATCH_SCAN_STORAGE_CFG_LEN], *pp;
@@ -482,9 +470,10 @@ tBTM_STATUS btm_ble_set_storage_config(UINT8 batch_scan_full_max, UINT8 batch_sc
     UINT8_TO_STREAM (pp, batch_scan_trunc_max);
     UINT8_TO_STREAM (pp, batch_scan_notify_threshold);
 
-    if ((status = BTM_VendorSpecificCommand (HCI_BLE_BATCH_SCAN_OCF,
-                BTM_BLE_BATCH_SCAN_STORAGE_CFG_LEN, param,
-                btm_ble_batchscan_vsc_cmpl_cback))!= BTM_CMD_STARTED)
+    /* The user needs to be provided scan config storage event */
+    if ((status = btm_ble_batchscan_vsc(BTM_BLE_BATCH_SCAN_STORAGE_CFG_LEN, param,
+                ble_batchscan_cb.cur_state, BTM_BLE_BATCH_SCAN_CFG_STRG_EVT,
+                ref_value))!= BTM_CMD_STARTED)
     {
         BTM_TRACE_ERROR("btm_ble_set_storage_config %d", status);
         return BTM_ILLEGAL_VALUE;
@@ -504,13 +493,17 @@ tBTM_STATUS btm_ble_set_storage_config(UINT8 batch_scan_full_max, UINT8 batch_sc
 **                  scan_window  - Scan window
 **                  discard_rule -Discard rules
 **                  addr_type - Address type
+**                  cur_state - state to report on completion
+**                  cb_evt - event to report to the user
+**                  ref_value - Reference value
 **
 ** Returns          status
 **
 *******************************************************************************/
 tBTM_STATUS btm_ble_set_batchscan_param(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
                      UINT32 scan_interval, UINT32 scan_window, tBLE_ADDR_TYPE addr_type,
-                     tBTM_BLE_DISCARD_RULE discard_rule)
+                     tBTM_BLE_DISCARD_RULE discard_rule, tBTM_BLE_BATCH_SCAN_STATE cur_state,
+                     UINT8 cb_evt, tBTM_BLE_REF_VALUE ref_value)
 {
     tBTM_STATUS     status = BTM_NO_RESOURCES;
     UINT8 scan_param[BTM_BLE_BATCH_SCAN_PARAM_CONFIG_LEN], *pp_scan;
@@ -525,9 +518,8 @@ tBTM_STATUS btm_ble_set_batchscan_param(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
     UINT8_TO_STREAM (pp_scan, addr_type);
     UINT8_TO_STREAM (pp_scan, discard_rule);
 
-    if ((status = BTM_VendorSpecificCommand (HCI_BLE_BATCH_SCAN_OCF,
-            BTM_BLE_BATCH_SCAN_PARAM_CONFIG_LEN,
-            scan_param, btm_ble_batchscan_vsc_cmpl_cback))!= BTM_CMD_STARTED)
+    if ((status = btm_ble_batchscan_vsc(BTM_BLE_BATCH_SCAN_PARAM_CONFIG_LEN, scan_param,
+            cur_state, cb_evt, ref_value))!= BTM_CMD_STARTED)
     {
         BTM_TRACE_ERROR("btm_ble_set_batchscan_param %d", status);
         return BTM_ILLEGAL_VALUE;
@@ -543,11 +535,12 @@ tBTM_STATUS btm_ble_set_batchscan_param(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
 ** Description      This function enables the customer specific feature in controller
 **
 ** Parameters       enable_disable: true - enable, false - disable
+**                  ref_value - Reference value
 **
 ** Returns          status
 **
 *******************************************************************************/
-tBTM_STATUS btm_ble_enable_disable_batchscan(BOOLEAN should_enable)
+tBTM_STATUS btm_ble_enable_disable_batchscan(BOOLEAN should_enable, tBTM_BLE_REF_VALUE ref_value)
 {
     tBTM_STATUS     status = BTM_NO_RESOURCES;
     UINT8 shld_enable = 0x01;
@@ -564,9 +557,8 @@ tBTM_STATUS btm_ble_enable_disable_batchscan(BOOLEAN should_enable)
         UINT8_TO_STREAM (pp_enable, BTM_BLE_BATCH_SCAN_ENB_DISAB_CUST_FEATURE);
         UINT8_TO_STREAM (pp_enable, shld_enable);
 
-        if ((status = BTM_VendorSpecificCommand(HCI_BLE_BATCH_SCAN_OCF,
-                 BTM_BLE_BATCH_SCAN_ENB_DISB_LEN, enable_param,
-                 btm_ble_batchscan_vsc_cmpl_cback)) != BTM_CMD_STARTED)
+        if ((status = btm_ble_batchscan_vsc(BTM_BLE_BATCH_SCAN_ENB_DISB_LEN, enable_param,
+                 BTM_BLE_SCAN_ENABLE_CALLED, 0, ref_value)) != BTM_CMD_STARTED)
         {
             status = BTM_MODE_UNSUPPORTED;
             BTM_TRACE_ERROR("btm_ble_enable_disable_batchscan %d", status);
@@ -574,9 +566,12 @@ tBTM_STATUS btm_ble_enable_disable_batchscan(BOOLEAN should_enable)
         }
     }
     else
+    /* The user needs to be provided scan disable event */
     if ((status = btm_ble_set_batchscan_param(BTM_BLE_BATCH_SCAN_MODE_DISABLE,
                    ble_batchscan_cb.scan_interval, ble_batchscan_cb.scan_window,
-                   ble_batchscan_cb.addr_type, ble_batchscan_cb.discard_rule)) != BTM_CMD_STARTED)
+                   ble_batchscan_cb.addr_type, ble_batchscan_cb.discard_rule,
+                   BTM_BLE_SCAN_DISABLE_CALLED, BTM_BLE_BATCH_SCAN_DISABLE_EVT,
+                   ref_value)) != BTM_CMD_STARTED)
     {
          status = BTM_MODE_UNSUPPORTED;
          BTM_TRACE_ERROR("btm_ble_enable_disable_batchscan %d", status);
@@ -649,23 +644,15 @@ tBTM_STATUS BTM_BleSetStorageConfig(UINT8 batch_scan_full_max, UINT8 batch_scan_
          BTM_BLE_SCAN_DISABLED_STATE == ble_batchscan_cb.cur_state ||
          BTM_BLE_SCAN_DISABLE_CALLED == ble_batchscan_cb.cur_state)
     {
-        status = btm_ble_enable_disable_batchscan(TRUE);
+        status = btm_ble_enable_disable_batchscan(TRUE, ref_value);
         if (BTM_CMD_STARTED != status)
             return status;
 
         ble_batchscan_cb.cur_state = BTM_BLE_SCAN_ENABLE_CALLED;
-        btm_ble_batchscan_enq_op_q(BTM_BLE_BATCH_SCAN_ENB_DISAB_CUST_FEATURE,
-                                    BTM_BLE_SCAN_ENABLE_CALLED, 0, ref_value);
     }
 
     status = btm_ble_set_storage_config(batch_scan_full_max, batch_scan_trunc_max,
-                                        batch_scan_notify_threshold);
-    if (BTM_CMD_STARTED != status)
-       return status;
-            /* The user needs to be provided scan config storage event */
-     btm_ble_batchscan_enq_op_q(BTM_BLE_BATCH_SCAN_SET_STORAGE_PARAM, ble_batchscan_cb.cur_state,
-                                   BTM_BLE_BATCH_SCAN_CFG_STRG_EVT, ref_value);
-
+                                        batch_scan_notify_threshold, ref_value);
     return status;
 }
 
@@ -721,11 +708,9 @@ tBTM_STATUS BTM_BleEnableBatchScan(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
             BTM_BLE_SCAN_DISABLED_STATE == ble_batchscan_cb.cur_state ||
             BTM_BLE_SCAN_DISABLE_CALLED == ble_batchscan_cb.cur_state)
         {
-            status = btm_ble_enable_disable_batchscan(TRUE);
+            status = btm_ble_enable_disable_batchscan(TRUE, ref_value);
             if (BTM_CMD_STARTED != status)
                return status;
-            btm_ble_batchscan_enq_op_q(BTM_BLE_BATCH_SCAN_ENB_DISAB_CUST_FEATURE,
-                                       BTM_BLE_SCAN_ENABLE_CALLED, 0, ref_value);
         }
 
         ble_batchscan_cb.scan_mode = scan_mode;
@@ -733,15 +718,13 @@ tBTM_STATUS BTM_BleEnableBatchScan(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
         ble_batchscan_cb.scan_window = scan_window;
         ble_batchscan_cb.addr_type = addr_type;
         ble_batchscan_cb.discard_rule = discard_rule;
-        /* This command starts batch scanning, if enabled */
+        /* This command starts batch scanning, if enabled. The user needs to be
+           provided scan enable event */
         status = btm_ble_set_batchscan_param(scan_mode, scan_interval, scan_window, addr_type,
-                    discard_rule);
+                    discard_rule, ble_batchscan_cb.cur_state, BTM_BLE_BATCH_SCAN_ENABLE_EVT,
+                    ref_value);
         if (BTM_CMD_STARTED != status)
             return status;
-
-        /* The user needs to be provided scan enable event */
-        btm_ble_batchscan_enq_op_q(BTM_BLE_BATCH_SCAN_SET_PARAMS, ble_batchscan_cb.cur_state,
-                                   BTM_BLE_BATCH_SCAN_ENABLE_EVT, ref_value);
     }
     else
     {
@@ -779,15 +762,7 @@ tBTM_STATUS BTM_BleDisableBatchScan(tBTM_BLE_REF_VALUE ref_value)
         return BTM_ERR_PROCESSING;
     }
 
-    status = btm_ble_enable_disable_batchscan(FALSE);
-    if (BTM_CMD_STARTED == status)
-    {
-       /* The user needs to be provided scan disable event */
-       btm_ble_batchscan_enq_op_q(BTM_BLE_BATCH_SCAN_SET_PARAMS,
-                                  BTM_BLE_SCAN_DISABLE_CALLED, BTM_BLE_BATCH_SCAN_DISABLE_EVT,
-                                  ref_value);
-    }
-
+    status = btm_ble_enable_disable_batchscan(FALSE, ref_value);
     return status;
 }
 
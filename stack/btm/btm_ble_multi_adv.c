@@ -35,6 +35,7 @@
 #define BTM_BLE_MULTI_ADV_WRITE_DATA_LEN                (BTM_BLE_AD_DATA_LEN + 3)
 #define BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR_LEN           8
 
+tBTM_BLE_MULTI_ADV_CB  btm_multi_adv_cb;
 tBTM_BLE_MULTI_ADV_INST_IDX_Q btm_multi_adv_idx_q;
 
 #define BTM_BLE_MULTI_ADV_CB_EVT_MASK   0xF0
@@ -47,48 +48,6 @@ static tBTM_BLE_ADV_PARAMS local_copy = {0, 0, 0, 0, 0, 0};
 static bool is_wipower_adv = false;
 static UINT8 wipower_inst_id = BTM_BLE_MULTI_ADV_DEFAULT_STD;
 
-/*******************************************************************************
-**
-** Function         btm_ble_multi_adv_enq_op_q
-**
-** Description      enqueue a multi adv operation in q to check command complete
-**                  status.
-**
-** Returns          void
-**
-*******************************************************************************/
-void btm_ble_multi_adv_enq_op_q(UINT8 opcode, UINT8 inst_id, UINT8 cb_evt)
-{
-    tBTM_BLE_MULTI_ADV_OPQ  *p_op_q = &btm_multi_adv_cb.op_q;
-
-    p_op_q->p_inst_id[p_op_q->next_idx] = inst_id;
-
-    p_op_q->p_sub_code[p_op_q->next_idx] = (opcode |(cb_evt << 4));
-
-    p_op_q->next_idx = (p_op_q->next_idx + 1) %  BTM_BleMaxMultiAdvInstanceCount();
-}
-
-/*******************************************************************************
-**
-** Function         btm_ble_multi_adv_deq_op_q
-**
-** Description      dequeue a multi adv operation from q when command complete
-**                  is received.
-**
-** Returns          void
-**
-*******************************************************************************/
-void btm_ble_multi_adv_deq_op_q(UINT8 *p_opcode, UINT8 *p_inst_id, UINT8 *p_cb_evt)
-{
-    tBTM_BLE_MULTI_ADV_OPQ  *p_op_q = &btm_multi_adv_cb.op_q;
-
-    *p_inst_id = p_op_q->p_inst_id[p_op_q->pending_idx] & 0x7F;
-    *p_cb_evt = (p_op_q->p_sub_code[p_op_q->pending_idx] >> 4);
-    *p_opcode = (p_op_q->p_sub_code[p_op_q->pending_idx] & BTM_BLE_MULTI_ADV_SUBCODE_MASK);
-
-    p_op_q->pending_idx = (p_op_q->pending_idx + 1) %  BTM_BleMaxMultiAdvInstanceCount();
-}
-
 /*******************************************************************************
 **
 ** Function         btm_ble_multi_adv_vsc_cmpl_cback
@@ -107,8 +66,9 @@ void btm_ble_multi_adv_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
     UINT16  len = p_params->param_len;
     tBTM_BLE_MULTI_ADV_INST *p_inst ;
     UINT8   cb_evt = 0, opcode;
+    tBTM_BLE_MULTI_ADV_OP op;
 
-    if (len  < 2)
+    if (len  < 2 || p_params->context_len != sizeof(op))
     {
         BTM_TRACE_ERROR("wrong length for btm_ble_multi_adv_vsc_cmpl_cback");
         return;
@@ -117,7 +77,11 @@ void btm_ble_multi_adv_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
     STREAM_TO_UINT8(status, p);
     STREAM_TO_UINT8(subcode, p);
 
-    btm_ble_multi_adv_deq_op_q(&opcode, &inst_id, &cb_evt);
+    /* the operation this command was sent for */
+    memcpy(&op, p_params->p_context, sizeof(op));
+    opcode = op.sub_code;
+    inst_id = op.inst_id & 0x7F;
+    cb_evt = op.cb_evt;
 
     BTM_TRACE_DEBUG("op_code = %02x inst_id = %d cb_evt = %02x", opcode, inst_id, cb_evt);
 
@@ -174,6 +138,31 @@ void btm_ble_multi_adv_vsc_cmpl_cback (tBTM_VSC_CMPL *p_params)
     return;
 }
 
+/*******************************************************************************
+**
+** Function         btm_ble_multi_adv_vsc
+**
+** Description      send a multi adv VSC, carrying the sub code, instance and
+**                  callback event for btm_ble_multi_adv_vsc_cmpl_cback.
+**
+** Parameters       len, p_param: command parameters, starting with the sub code
+**
+** Returns          status
+**
+*******************************************************************************/
+static tBTM_STATUS btm_ble_multi_adv_vsc(UINT8 len, UINT8 *p_param, UINT8 inst_id, UINT8 cb_evt)
+{
+    tBTM_BLE_MULTI_ADV_OP op;
+
+    op.sub_code = p_param[0];
+    op.inst_id = inst_id;
+    op.cb_evt = cb_evt;
+
+    return BTM_VendorSpecificCommandWithContext(HCI_BLE_MULTI_ADV_OCF, len, p_param,
+                                                btm_ble_multi_adv_vsc_cmpl_cback,
+                                                &op, sizeof(op));
+}
+
 /*******************************************************************************
 **
 ** Function         btm_ble_enable_multi_adv
@@ -201,14 +190,7 @@ tBTM_STATUS btm_ble_enable_multi_adv (BOOLEAN enable, UINT8 inst_id, UINT8 cb_ev
 
     BTM_TRACE_EVENT (" btm_ble_enable_multi_adv: enb %d, Inst ID %d",enb,inst_id);
 
-    if ((rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    BTM_BLE_MULTI_ADV_ENB_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback))
-                                     == BTM_CMD_STARTED)
-    {
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_ENB, inst_id, cb_evt);
-    }
+    rt = btm_ble_multi_adv_vsc(BTM_BLE_MULTI_ADV_ENB_LEN, param, inst_id, cb_evt);
     return rt;
 }
 /*******************************************************************************
@@ -293,11 +275,8 @@ tBTM_STATUS btm_ble_multi_adv_set_params (tBTM_BLE_MULTI_ADV_INST *p_inst,
     BTM_TRACE_EVENT("set_params:Chnl Map %d,adv_fltr policy %d,ID:%d, TX Power%d",
         p_params->channel_map,p_params->adv_filter_policy,p_inst->inst_id,p_params->tx_power);
 
-    if ((rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    BTM_BLE_MULTI_ADV_SET_PARAM_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback))
-           == BTM_CMD_STARTED)
+    if ((rt = btm_ble_multi_adv_vsc(BTM_BLE_MULTI_ADV_SET_PARAM_LEN, param,
+                                    p_inst->inst_id, cb_evt)) == BTM_CMD_STARTED)
     {
         p_inst->adv_evt = p_params->adv_type;
 
@@ -310,7 +289,6 @@ tBTM_STATUS btm_ble_multi_adv_set_params (tBTM_BLE_MULTI_ADV_INST *p_inst,
                              BTM_BLE_PRIVATE_ADDR_INT);
         }
 #endif
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_SET_PARAM, p_inst->inst_id, cb_evt);
     }
     return rt;
 }
@@ -340,18 +318,14 @@ tBTM_STATUS btm_ble_multi_adv_write_rpa (tBTM_BLE_MULTI_ADV_INST *p_inst, BD_ADD
     BDADDR_TO_STREAM(pp, random_addr);
     UINT8_TO_STREAM(pp,  p_inst->inst_id);
 
-    if ((rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback)) == BTM_CMD_STARTED)
+    if ((rt = btm_ble_multi_adv_vsc(BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR_LEN, param,
+                                    p_inst->inst_id, 0)) == BTM_CMD_STARTED)
     {
         /* start a periodical timer to refresh random addr */
         btu_stop_timer(&p_inst->raddr_timer_ent);
         p_inst->raddr_timer_ent.param = (TIMER_PARAM_TYPE) p_inst;
         btu_start_timer_oneshot(&p_inst->raddr_timer_ent, BTU_TTYPE_BLE_RANDOM_ADDR,
                          BTM_BLE_PRIVATE_ADDR_INT);
-
-        btm_ble_multi_adv_enq_op_q(BTM_BLE_MULTI_ADV_SET_RANDOM_ADDR, p_inst->inst_id, 0);
     }
     return rt;
 }
@@ -698,14 +672,8 @@ tBTM_STATUS BTM_BleCfgAdvInstData (UINT8 inst_id, BOOLEAN is_scan_rsp,
         BTM_BleUpdateAdvInstParam (inst_id, &local_copy);
     }
 
-    if ((rt = BTM_VendorSpecificCommand (HCI_BLE_MULTI_ADV_OCF,
-                                    (UINT8)BTM_BLE_MULTI_ADV_WRITE_DATA_LEN,
-                                    param,
-                                    btm_ble_multi_adv_vsc_cmpl_cback))
-                                     == BTM_CMD_STARTED)
-    {
-        btm_ble_multi_adv_enq_op_q(sub_code, inst_id, BTM_BLE_MULTI_ADV_DATA_EVT);
-    }
+    rt = btm_ble_multi_adv_vsc((UINT8)BTM_BLE_MULTI_ADV_WRITE_DATA_LEN, param, inst_id,
+                               BTM_BLE_MULTI_ADV_DATA_EVT);
     return rt;
 }
 
@@ -845,26 +813,6 @@ void btm_ble_multi_adv_init()
         }
         memset(btm_multi_adv_cb.p_adv_inst, 0, sizeof(tBTM_BLE_MULTI_ADV_INST)*
                                                (btm_cb.cmn_ble_vsc_cb.adv_inst_max));
-
-        btm_multi_adv_cb.op_q.p_sub_code = GKI_getbuf( sizeof(UINT8) *
-                                                      (btm_cb.cmn_ble_vsc_cb.adv_inst_max));
-        if(!btm_multi_adv_cb.op_q.p_sub_code)
-        {
-            BTM_TRACE_ERROR("GKI_getbuf failed to get a free buffer");
-            return;
-        }
-        memset(btm_multi_adv_cb.op_q.p_sub_code, 0,
-               sizeof(UINT8)*(btm_cb.cmn_ble_vsc_cb.adv_inst_max));
-
-        btm_multi_adv_cb.op_q.p_inst_id = GKI_getbuf( sizeof(UINT8) *
-                                          (btm_cb.cmn_ble_vsc_cb.adv_inst_max));
-        if(!btm_multi_adv_cb.op_q.p_inst_id)
-        {
-            BTM_TRACE_ERROR("GKI_getbuf failed to get a free buffer");
-            return;
-        }
-        memset(btm_multi_adv_cb.op_q.p_inst_id, 0,
-               sizeof(UINT8)*(btm_cb.cmn_ble_vsc_cb.adv_inst_max));
     }
 
     for (i = 0; i < btm_cb.cmn_ble_vsc_cb.adv_inst_max ; i ++)
@@ -889,13 +837,6 @@ void btm_ble_multi_adv_cleanup(void)
     wipower_inst_id = BTM_BLE_MULTI_ADV_DEFAULT_STD;
     if (btm_multi_adv_cb.p_adv_inst)
         GKI_freebuf(btm_multi_adv_cb.p_adv_inst);
-
-    if (btm_multi_adv_cb.op_q.p_sub_code)
-         GKI_freebuf(btm_multi_adv_cb.op_q.p_sub_code);
-
-    if (btm_multi_adv_cb.op_q.p_inst_id)
-        GKI_freebuf(btm_multi_adv_cb.op_q.p_inst_id);
-
 }
 
 /*******************************************************************************
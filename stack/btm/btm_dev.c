@@ -38,6 +38,18 @@
 #include "vendor_ble.h"
 
 static tBTM_SEC_DEV_REC *btm_find_oldest_dev (void);
+static tBTM_SEC_DEV_REC *btm_sec_load_dev (BD_ADDR bd_addr);
+static void btm_sec_link_dev (tBTM_SEC_DEV_REC *p_dev_rec);
+static void btm_sec_unlink_dev (tBTM_SEC_DEV_REC *p_dev_rec);
+
+/* bucket of a BD address in btm_cb.sec_dev_hash */
+#define BTM_SEC_DEV_HASH(bd_addr) \
+    ((UINT16)((((UINT32)(bd_addr)[0] << 8 ^ (bd_addr)[1] << 16 ^ (bd_addr)[2] ^ \
+                (UINT32)(bd_addr)[3] << 24 ^ (bd_addr)[4] << 8 ^ (bd_addr)[5]) * 0x9E3779B1u) >> 16) \
+     & (BTM_SEC_DEV_HASH_SIZE - 1))
+
+/* bucket of a connection handle in btm_cb.sec_dev_handle_hint */
+#define BTM_SEC_HANDLE_HASH(handle) ((handle) & (BTM_SEC_DEV_HASH_SIZE - 1))
 
 /*******************************************************************************
 **
@@ -72,30 +84,18 @@ BOOLEAN BTM_SecAddDevice (BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name,
     if (!p_dev_rec)
     {
         /* There is no device record, allocate one.
-         * If we can not find an empty spot for this one, let it fail. */
-        for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++)
-        {
-            if (!(btm_cb.sec_dev_rec[i].sec_flags & BTM_SEC_IN_USE))
-            {
-                p_dev_rec = &btm_cb.sec_dev_rec[i];
+         * If we can not find an empty or idle spot for this one, let it fail. */
+        if ((p_dev_rec = btm_sec_alloc_rec (bd_addr)) == NULL)
+            return(FALSE);
 
-                /* Mark this record as in use and initialize */
-                memset (p_dev_rec, 0, sizeof (tBTM_SEC_DEV_REC));
-                p_dev_rec->sec_flags = BTM_SEC_IN_USE;
-                memcpy (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
-                p_dev_rec->hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_BR_EDR);
+        p_dev_rec->hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_BR_EDR);
 
 #if BLE_INCLUDED == TRUE
-                /* use default value for background connection params */
-                /* update conn params, use default value for background connection params */
-                memset(&p_dev_rec->conn_params, 0xff, sizeof(tBTM_LE_CONN_PRAMS));
+        p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_LE);
+        /* use default value for background connection params */
+        /* update conn params, use default value for background connection params */
+        memset(&p_dev_rec->conn_params, 0xff, sizeof(tBTM_LE_CONN_PRAMS));
 #endif
-                break;
-            }
-        }
-
-        if (!p_dev_rec)
-            return(FALSE);
     }
 
     p_dev_rec->timestamp = btm_cb.dev_rec_count++;
@@ -235,10 +235,13 @@ tBTM_SEC_DEV_REC *btm_sec_alloc_dev (BD_ADDR bd_addr)
     tBTM_INQ_INFO    *p_inq_info;
     int               i;
     DEV_CLASS         old_cod;
-    int               i_new_entry = BTM_SEC_MAX_DEVICE_RECORDS;
     int               i_old_entry = BTM_SEC_MAX_DEVICE_RECORDS;
     BTM_TRACE_EVENT ("btm_sec_alloc_dev");
 
+    /* a bonded device that is not resident is added back from storage */
+    if ((p_dev_rec = btm_sec_load_dev (bd_addr)) != NULL)
+        return(p_dev_rec);
+
     for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++)
     {
         /* look for old entry where device details are present */
@@ -251,40 +254,26 @@ tBTM_SEC_DEV_REC *btm_sec_alloc_dev (BD_ADDR bd_addr)
         }
     }
 
-    for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++)
+    /* if the old device entry not present go with a new or the oldest entry */
+    if (i_old_entry == BTM_SEC_MAX_DEVICE_RECORDS)
     {
-        if (!(btm_cb.sec_dev_rec[i].sec_flags & BTM_SEC_IN_USE))
-        {
-            i_new_entry = i;
-            break;
-        }
+        p_dev_rec = btm_sec_alloc_rec (bd_addr);
     }
+    else
+    {
+        p_dev_rec = &btm_cb.sec_dev_rec[i_old_entry];
+        memcpy (old_cod, p_dev_rec->dev_class, DEV_CLASS_LEN);
+        memset (p_dev_rec, 0, sizeof (tBTM_SEC_DEV_REC));
 
-    if (i_new_entry == BTM_SEC_MAX_DEVICE_RECORDS) {
-        p_dev_rec = btm_find_oldest_dev();
-    }
-    else {
-        /* if the old device entry not present go with
-            new entry */
-        if(i_old_entry == BTM_SEC_MAX_DEVICE_RECORDS) {
-            p_dev_rec = &btm_cb.sec_dev_rec[i_new_entry];
-        }
-        else {
-            p_dev_rec = &btm_cb.sec_dev_rec[i_old_entry];
-            memcpy (old_cod, p_dev_rec->dev_class, DEV_CLASS_LEN);
-        }
-    }
-    memset (p_dev_rec, 0, sizeof (tBTM_SEC_DEV_REC));
-
-    /* Retain the old COD for device */
-    if(i_old_entry != BTM_SEC_MAX_DEVICE_RECORDS) {
+        /* Retain the old COD for device */
         BTM_TRACE_EVENT ("btm_sec_alloc_dev restoring cod ");
         memcpy (p_dev_rec->dev_class, old_cod, DEV_CLASS_LEN);
 
+        p_dev_rec->sec_flags = BTM_SEC_IN_USE;
+        memcpy (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
+        btm_sec_link_dev (p_dev_rec);
     }
 
-    p_dev_rec->sec_flags = BTM_SEC_IN_USE;
-
     /* Check with the BT manager if details about remote device are known */
     /* outgoing connection */
     if ((p_inq_info = BTM_InqDbRead(bd_addr)) != NULL)
@@ -319,8 +308,6 @@ tBTM_SEC_DEV_REC *btm_sec_alloc_dev (BD_ADDR bd_addr)
             memcpy (p_dev_rec->dev_class, btm_cb.connecting_dc, DEV_CLASS_LEN);
     }
 
-    memcpy (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
-
 #if BLE_INCLUDED == TRUE
     p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle (bd_addr, BT_TRANSPORT_LE);
 #endif
@@ -333,6 +320,49 @@ tBTM_SEC_DEV_REC *btm_sec_alloc_dev (BD_ADDR bd_addr)
 }
 
 
+/*******************************************************************************
+**
+** Function         btm_sec_alloc_rec
+**
+** Description      Take a free device record, or the oldest idle one if the
+**                  database is full, and initialize it for the specified BD
+**                  address.  The record is not paged in from storage.
+**
+** Returns          Pointer to the record
+**
+*******************************************************************************/
+tBTM_SEC_DEV_REC *btm_sec_alloc_rec (BD_ADDR bd_addr)
+{
+    tBTM_SEC_DEV_REC *p_dev_rec = NULL;
+    int               i;
+
+    for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++)
+    {
+        if (!(btm_cb.sec_dev_rec[i].sec_flags & BTM_SEC_IN_USE))
+        {
+            p_dev_rec = &btm_cb.sec_dev_rec[i];
+            break;
+        }
+    }
+
+    if (p_dev_rec == NULL)
+    {
+        p_dev_rec = btm_find_oldest_dev();
+        BTM_TRACE_EVENT ("btm_sec_alloc_rec evicting %02x:%02x:%02x:%02x:%02x:%02x",
+                         p_dev_rec->bd_addr[0], p_dev_rec->bd_addr[1], p_dev_rec->bd_addr[2],
+                         p_dev_rec->bd_addr[3], p_dev_rec->bd_addr[4], p_dev_rec->bd_addr[5]);
+        btm_sec_unlink_dev (p_dev_rec);
+    }
+
+    /* Mark this record as in use and initialize */
+    memset (p_dev_rec, 0, sizeof (tBTM_SEC_DEV_REC));
+    p_dev_rec->sec_flags = BTM_SEC_IN_USE;
+    memcpy (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN);
+    btm_sec_link_dev (p_dev_rec);
+
+    return(p_dev_rec);
+}
+
 /*******************************************************************************
 **
 ** Function         btm_sec_free_dev
@@ -342,6 +372,9 @@ tBTM_SEC_DEV_REC *btm_sec_alloc_dev (BD_ADDR bd_addr)
 *******************************************************************************/
 void btm_sec_free_dev (tBTM_SEC_DEV_REC *p_dev_rec)
 {
+    if (p_dev_rec->sec_flags & BTM_SEC_IN_USE)
+        btm_sec_unlink_dev (p_dev_rec);
+
     p_dev_rec->sec_flags = 0;
 
     p_dev_rec->pin_key_len = 0;
@@ -420,7 +453,8 @@ BOOLEAN btm_dev_support_switch (BD_ADDR bd_addr)
 *******************************************************************************/
 tBTM_SEC_DEV_REC *btm_find_dev_by_handle (UINT16 handle)
 {
-    tBTM_SEC_DEV_REC *p_dev_rec = &btm_cb.sec_dev_rec[0];
+    tBTM_SEC_DEV_REC *p_dev_rec;
+    UINT16 *p_hint;
     int i;
 
     if(handle == BTM_INVALID_HCI_HANDLE)
@@ -429,6 +463,22 @@ tBTM_SEC_DEV_REC *btm_find_dev_by_handle (UINT16 handle)
         return (NULL);
     }
 
+    /* Handles are written all over the stack, so the table only remembers
+    ** where a handle was last found and the record is checked before use. */
+    p_hint = &btm_cb.sec_dev_handle_hint[BTM_SEC_HANDLE_HASH(handle)];
+    if (*p_hint != 0)
+    {
+        p_dev_rec = &btm_cb.sec_dev_rec[*p_hint - 1];
+        if ((p_dev_rec->sec_flags & BTM_SEC_IN_USE)
+            && ((p_dev_rec->hci_handle == handle)
+#if BLE_INCLUDED == TRUE
+            ||(p_dev_rec->ble_hci_handle == handle)
+#endif
+                ))
+            return(p_dev_rec);
+    }
+
+    p_dev_rec = &btm_cb.sec_dev_rec[0];
     for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++, p_dev_rec++)
     {
         if ((p_dev_rec->sec_flags & BTM_SEC_IN_USE)
@@ -437,7 +487,10 @@ tBTM_SEC_DEV_REC *btm_find_dev_by_handle (UINT16 handle)
             ||(p_dev_rec->ble_hci_handle == handle)
 #endif
                 ))
+        {
+            *p_hint = (UINT16)(i + 1);
             return(p_dev_rec);
+        }
     }
     return(NULL);
 }
@@ -479,15 +532,16 @@ tBTM_SEC_DEV_REC *btm_find_dev_by_sec_state(UINT8 sec_state)
 *******************************************************************************/
 tBTM_SEC_DEV_REC *btm_find_dev (BD_ADDR bd_addr)
 {
-    tBTM_SEC_DEV_REC *p_dev_rec = &btm_cb.sec_dev_rec[0];
-    int i;
+    tBTM_SEC_DEV_REC *p_dev_rec;
+    UINT16 idx;
 
     if (bd_addr)
     {
-        for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++, p_dev_rec++)
+        for (idx = btm_cb.sec_dev_hash[BTM_SEC_DEV_HASH(bd_addr)]; idx != 0;
+             idx = btm_cb.sec_dev_next[idx - 1])
         {
-            if ((p_dev_rec->sec_flags & BTM_SEC_IN_USE)
-                && (!memcmp (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN)))
+            p_dev_rec = &btm_cb.sec_dev_rec[idx - 1];
+            if (!memcmp (p_dev_rec->bd_addr, bd_addr, BD_ADDR_LEN))
                 return(p_dev_rec);
         }
     }
@@ -521,51 +575,148 @@ tBTM_SEC_DEV_REC *btm_find_or_alloc_dev (BD_ADDR bd_addr)
 **
 ** Function         btm_find_oldest_dev
 **
-** Description      Locates the oldest device in use. It first looks for
-**                  the oldest non-paired device.  If all devices are paired it
-**                  deletes the oldest paired device.
+** Description      Locates the oldest device in use that has no connection and
+**                  no security procedure in progress. Non-paired devices go
+**                  first, then paired devices without an LE identity key, then
+**                  the rest: a paged out device can only be found again by its
+**                  BD address, not by a resolvable private address.
+**                  If every record is busy the oldest one is returned.
 **
-** Returns          Pointer to the record or NULL
+** Returns          Pointer to the record
 **
 *******************************************************************************/
 tBTM_SEC_DEV_REC *btm_find_oldest_dev (void)
 {
     tBTM_SEC_DEV_REC *p_dev_rec = &btm_cb.sec_dev_rec[0];
-    tBTM_SEC_DEV_REC *p_oldest = p_dev_rec;
-    UINT32       ot = 0xFFFFFFFF;
+    tBTM_SEC_DEV_REC *p_oldest = NULL;
+    tBTM_SEC_DEV_REC *p_oldest_busy = p_dev_rec;
+    UINT32       ot = 0xFFFFFFFF, ot_busy = 0xFFFFFFFF;
+    UINT8        rank, best_rank = 0xFF;
+    BOOLEAN      busy;
     int i;
 
-    /* First look for the non-paired devices for the oldest entry */
     for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++, p_dev_rec++)
     {
-        if (((p_dev_rec->sec_flags & BTM_SEC_IN_USE) == 0)
-            || ((p_dev_rec->sec_flags & (BTM_SEC_LINK_KEY_KNOWN |BTM_SEC_LE_LINK_KEY_KNOWN)) != 0))
-            continue; /* Device is paired so skip it */
+        if ((p_dev_rec->sec_flags & BTM_SEC_IN_USE) == 0)
+            continue;
 
-        if (p_dev_rec->timestamp < ot)
-        {
-            p_oldest = p_dev_rec;
-            ot       = p_dev_rec->timestamp;
-        }
-    }
+        if ((p_dev_rec->sec_flags & (BTM_SEC_LINK_KEY_KNOWN | BTM_SEC_LE_LINK_KEY_KNOWN)) == 0)
+            rank = 0;
+#if BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE
+        else if (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)
+            rank = 2;
+#endif
+        else
+            rank = 1;
 
-    if (ot != 0xFFFFFFFF)
-        return(p_oldest);
+        busy = (p_dev_rec->hci_handle != BTM_SEC_INVALID_HANDLE)
+#if BLE_INCLUDED == TRUE
+            || (p_dev_rec->ble_hci_handle != BTM_SEC_INVALID_HANDLE)
+#endif
+            || (p_dev_rec->sec_state != BTM_SEC_STATE_IDLE)
+            || (p_dev_rec == btm_cb.p_collided_dev_rec);
 
-    /* All devices are paired; find the oldest */
-    p_dev_rec = &btm_cb.sec_dev_rec[0];
-    for (i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++, p_dev_rec++)
-    {
-        if ((p_dev_rec->sec_flags & BTM_SEC_IN_USE) == 0)
+        if (busy)
+        {
+            if (p_dev_rec->timestamp < ot_busy)
+            {
+                p_oldest_busy = p_dev_rec;
+                ot_busy       = p_dev_rec->timestamp;
+            }
             continue;
+        }
 
-        if (p_dev_rec->timestamp < ot)
+        if (rank < best_rank || (rank == best_rank && p_dev_rec->timestamp < ot))
         {
-            p_oldest = p_dev_rec;
-            ot       = p_dev_rec->timestamp;
+            p_oldest  = p_dev_rec;
+            ot        = p_dev_rec->timestamp;
+            best_rank = rank;
         }
     }
-    return(p_oldest);
+
+    return(p_oldest ? p_oldest : p_oldest_busy);
 }
 
+/*******************************************************************************
+**
+** Function         BTM_SecRegisterDevLoader
+**
+** Description      Register the function that pages bonded devices in from
+**                  persistent storage.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_SecRegisterDevLoader (tBTM_SEC_DEV_LOAD_CBACK *p_cback)
+{
+    btm_cb.p_dev_load_cback = p_cback;
+}
 
+/*******************************************************************************
+**
+** Function         btm_sec_load_dev
+**
+** Description      Ask the registered loader to add the record of a bonded
+**                  device that is not resident.
+**
+** Returns          Pointer to the record or NULL if the device is not bonded
+**
+*******************************************************************************/
+static tBTM_SEC_DEV_REC *btm_sec_load_dev (BD_ADDR bd_addr)
+{
+    BOOLEAN loaded;
+
+    if (btm_cb.p_dev_load_cback == NULL || btm_cb.dev_loading)
+        return(NULL);
+
+    btm_cb.dev_loading = TRUE;
+    loaded = (*btm_cb.p_dev_load_cback)(bd_addr);
+    btm_cb.dev_loading = FALSE;
+
+    if (!loaded)
+        return(NULL);
+
+    BTM_TRACE_EVENT ("btm_sec_load_dev paged in %02x:%02x:%02x:%02x:%02x:%02x",
+                     bd_addr[0], bd_addr[1], bd_addr[2], bd_addr[3], bd_addr[4], bd_addr[5]);
+    return(btm_find_dev (bd_addr));
+}
+
+/*******************************************************************************
+**
+** Function         btm_sec_link_dev
+**
+** Description      Add an in use record to the BD address lookup table
+**
+*******************************************************************************/
+static void btm_sec_link_dev (tBTM_SEC_DEV_REC *p_dev_rec)
+{
+    UINT16 idx = (UINT16)(p_dev_rec - btm_cb.sec_dev_rec);
+    UINT16 *p_bucket = &btm_cb.sec_dev_hash[BTM_SEC_DEV_HASH(p_dev_rec->bd_addr)];
+
+    btm_cb.sec_dev_next[idx] = *p_bucket;
+    *p_bucket = idx + 1;
+}
+
+/*******************************************************************************
+**
+** Function         btm_sec_unlink_dev
+**
+** Description      Remove a record from the BD address lookup table
+**
+*******************************************************************************/
+static void btm_sec_unlink_dev (tBTM_SEC_DEV_REC *p_dev_rec)
+{
+    UINT16 idx = (UINT16)(p_dev_rec - btm_cb.sec_dev_rec) + 1;
+    UINT16 *p_link = &btm_cb.sec_dev_hash[BTM_SEC_DEV_HASH(p_dev_rec->bd_addr)];
+
+    while (*p_link != 0)
+    {
+        if (*p_link == idx)
+        {
+            *p_link = btm_cb.sec_dev_next[idx - 1];
+            btm_cb.sec_dev_next[idx - 1] = 0;
+            return;
+        }
+        p_link = &btm_cb.sec_dev_next[*p_link - 1];
+    }
+}
@@ -127,6 +127,10 @@ static void btm_get_local_features (void);
 static void btm_issue_host_support_for_lmp_features (void);
 static void btm_read_local_supported_cmds (UINT8 local_controller_id);
 static void btm_hci_vs_event_handler(UINT8 evt_len, UINT8 *p);
+static void btm_reset_read_done (void);
+static void btm_reset_version_done (void);
+static void btm_reset_features_done (void);
+static void btm_store_ctrl_caps (void);
 
 #if (defined(BTM_SECURE_CONN_HOST_INCLUDED) && BTM_SECURE_CONN_HOST_INCLUDED == TRUE)
 #if (defined(BTM_READ_CTLR_CAP_INCLUDED) && BTM_READ_CTLR_CAP_INCLUDED == TRUE)
@@ -136,6 +140,9 @@ static void btm_vendor_capability_vsc_cmpl_cback (tBTM_VSC_CMPL *p_vcs_cplt_para
 
 #if BLE_INCLUDED == TRUE
 static void btm_read_ble_local_supported_features (void);
+static void btm_read_ble_caps (void);
+static void btm_ble_set_buf_size (UINT16 acl_data_size, UINT16 num_bufs);
+static void btm_reset_le_done (BOOLEAN le_read);
 #endif
 
 /*******************************************************************************
@@ -415,6 +422,8 @@ void BTM_ContinueReset (void)
 static void btm_dev_reset (void)
 {
     btm_cb.devcb.state = BTM_DEV_STATE_WAIT_RESET_CMPLT;
+    btm_cb.devcb.reset_stage = BTM_RESET_STAGE_NONE;
+    btm_cb.devcb.reset_pend = 0;
 
     /* flush out the command complete queue and command transmit queue */
     btu_hcif_flush_cmd_queue();
@@ -716,7 +725,13 @@ void btm_continue_reset (void)
 #endif
 #endif
 
+    /* buffer size and local version do not depend on each other */
+    btm_cb.devcb.reset_stage = BTM_RESET_STAGE_VERSION;
+    btm_cb.devcb.reset_pend = 2;
     btm_get_hci_buf_size ();
+#if BTM_INTERNAL_BB != TRUE
+    btm_get_local_version ();
+#endif
 
     /* default device class */
     BTM_SetDeviceClass((UINT8 *) BTM_INIT_CLASS_OF_DEVICE);
@@ -803,13 +818,13 @@ void btm_read_hci_buf_size_complete (UINT8 *p, UINT16 evt_len)
     (void) BTM_SetDiscoverability (BTM_DEFAULT_DISC_MODE, BTM_DEFAULT_DISC_WINDOW, BTM_DEFAULT_DISC_INTERVAL);
 #endif
 
+    btm_reset_read_done ();
+
 #if BTM_INTERNAL_BB == TRUE
     {
         UINT8 buf[9] = BTM_INTERNAL_LOCAL_VER;
         btm_read_local_version_complete( buf, 9 );
     }
-#else
-    btm_get_local_version ();
 #endif
 }
 
@@ -832,20 +847,121 @@ void btm_read_ble_buf_size_complete (UINT8 *p, UINT16 evt_len)
     UNUSED(evt_len);
 
     BTM_TRACE_DEBUG("btm_read_ble_buf_size_complete ");
+
+    btu_stop_timer (&btm_cb.devcb.reset_timer);
+
     STREAM_TO_UINT8  (status, p);
     if (status == HCI_SUCCESS)
     {
-        STREAM_TO_UINT16 (btu_cb.hcit_ble_acl_data_size, p);
+        STREAM_TO_UINT16 (btm_cb.devcb.ctrl_caps.le_acl_data_size, p);
         STREAM_TO_UINT8 (lm_num_le_bufs,   p);
 
-        if (btu_cb.hcit_ble_acl_data_size == 0)
-            btu_cb.hcit_ble_acl_data_size = btu_cb.hcit_acl_data_size;
+        btm_cb.devcb.ctrl_caps.le_num_bufs = (UINT8)lm_num_le_bufs;
+        btm_ble_set_buf_size (btm_cb.devcb.ctrl_caps.le_acl_data_size, lm_num_le_bufs);
+    }
+    else
+    {
+        btm_cb.devcb.ctrl_caps.le_valid = FALSE;
+    }
+    btm_reset_read_done ();
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_set_buf_size
+**
+** Description      This function sets up the LE ACL buffers from the data
+**                  size and number of buffers the controller reported.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_ble_set_buf_size (UINT16 acl_data_size, UINT16 num_bufs)
+{
+    btu_cb.hcit_ble_acl_data_size = acl_data_size;
+
+    if (btu_cb.hcit_ble_acl_data_size == 0)
+        btu_cb.hcit_ble_acl_data_size = btu_cb.hcit_acl_data_size;
+
+    btu_cb.hcit_ble_acl_pkt_size = btu_cb.hcit_ble_acl_data_size + HCI_DATA_PREAMBLE_SIZE;
+
+    l2c_link_processs_ble_num_bufs (num_bufs);
+}
+
+/*******************************************************************************
+**
+** Function         btm_read_ble_caps
+**
+** Description      This function is called once the LE host support is set up
+**                  during reset.  The LE buffer size, white list size, supported
+**                  states and features are taken from the stored controller
+**                  capabilities, or else all read at once.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_read_ble_caps (void)
+{
+    tBTM_DEVCB     *p_devcb = &btm_cb.devcb;
+    tBTM_CTRL_CAPS *p_caps = &p_devcb->ctrl_caps;
+
+    if (p_devcb->caps_loaded && p_caps->le_valid)
+    {
+        btm_cb.ble_ctr_cb.max_filter_entries = p_caps->white_list_size;
+        btm_cb.ble_ctr_cb.num_empty_filter = p_caps->white_list_size;
+        btm_ble_set_buf_size (p_caps->le_acl_data_size, p_caps->le_num_bufs);
+        memcpy (p_devcb->le_supported_states, p_caps->le_supported_states, BTM_LE_SUPPORT_STATE_SIZE);
+        memcpy (p_devcb->local_le_features, p_caps->le_features, HCI_FEATURE_BYTES_PER_PAGE);
+
+        btm_reset_le_done (FALSE);
+        return;
+    }
+
+    p_caps->le_valid = TRUE;
+    p_devcb->reset_stage = BTM_RESET_STAGE_LE;
+    p_devcb->reset_pend = 4;
+
+    btm_read_ble_wl_size ();
+    btm_get_ble_buffer_size ();
+    btm_read_ble_local_supported_states ();
+    btm_read_ble_local_supported_features ();
+}
+
+/*******************************************************************************
+**
+** Function         btm_reset_le_done
+**
+** Description      This function is called once the LE controller capabilities
+**                  are known.  Finishes the LE part of the reset sequence.
+**                  le_read is TRUE if they were just read from the controller
+**                  rather than taken from the stored capabilities.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_reset_le_done (BOOLEAN le_read)
+{
+    tBTM_DEVCB     *p_devcb = &btm_cb.devcb;
+
+    /* LE part was read from a controller whose other capabilities came from the store */
+    if (le_read && p_devcb->caps_loaded)
+        p_devcb->caps_dirty = TRUE;
 
-        btu_cb.hcit_ble_acl_pkt_size = btu_cb.hcit_ble_acl_data_size + HCI_DATA_PREAMBLE_SIZE;
+    /* write LE host support and simultatunous LE supported */
+    btsnd_hcic_ble_write_host_supported(BTM_BLE_HOST_SUPPORT, BTM_BLE_SIMULTANEOUS_HOST);
 
-        l2c_link_processs_ble_num_bufs (lm_num_le_bufs);
+    btsnd_hcic_ble_set_evt_mask((UINT8 *)HCI_BLE_EVENT_MASK_DEF);
+
+#if BTM_INTERNAL_BB == TRUE
+    {
+        UINT8 buf[9] = BTM_INTERNAL_LOCAL_FEA;
+        btm_read_local_features_complete( buf, 9 );
     }
-    btm_read_ble_local_supported_states();
+#else
+
+    /* get local feature if BRCM specific feature is not included  */
+    btm_reset_ctrlr_complete();
+#endif
 }
 /*******************************************************************************
 **
@@ -870,13 +986,16 @@ void btm_read_ble_local_supported_states_complete (UINT8 *p, UINT16 evt_len)
     if (status == HCI_SUCCESS)
     {
         STREAM_TO_ARRAY(&btm_cb.devcb.le_supported_states, p, BTM_LE_SUPPORT_STATE_SIZE);
+        memcpy (btm_cb.devcb.ctrl_caps.le_supported_states, btm_cb.devcb.le_supported_states,
+                BTM_LE_SUPPORT_STATE_SIZE);
     }
     else
     {
         BTM_TRACE_WARNING ("btm_read_ble_local_supported_features_complete status = %d", status);
+        btm_cb.devcb.ctrl_caps.le_valid = FALSE;
     }
 
-    btm_read_ble_local_supported_features();
+    btm_reset_read_done ();
 }
 
 /*******************************************************************************
@@ -903,25 +1022,16 @@ void btm_read_ble_local_supported_features_complete (UINT8 *p, UINT16 evt_len)
     if (status == HCI_SUCCESS)
     {
         STREAM_TO_ARRAY(&btm_cb.devcb.local_le_features, p, HCI_FEATURE_BYTES_PER_PAGE);
+        memcpy (btm_cb.devcb.ctrl_caps.le_features, btm_cb.devcb.local_le_features,
+                HCI_FEATURE_BYTES_PER_PAGE);
     }
     else
     {
         BTM_TRACE_WARNING ("btm_read_ble_local_supported_features_complete status = %d", status);
+        btm_cb.devcb.ctrl_caps.le_valid = FALSE;
     }
 
-    btsnd_hcic_ble_set_evt_mask((UINT8 *)HCI_BLE_EVENT_MASK_DEF);
-
-#if BTM_INTERNAL_BB == TRUE
-    {
-        UINT8 buf[9] = BTM_INTERNAL_LOCAL_FEA;
-        btm_read_local_features_complete( buf, 9 );
-    }
-#else
-
-    /* get local feature if BRCM specific feature is not included  */
-    btm_reset_ctrlr_complete();
-#endif
-
+    btm_reset_read_done ();
 }
 
 /*******************************************************************************
@@ -936,17 +1046,23 @@ void btm_read_white_list_size_complete(UINT8 *p, UINT16 evt_len)
     UNUSED(evt_len);
 
     BTM_TRACE_DEBUG("btm_read_white_list_size_complete ");
+
+    btu_stop_timer (&btm_cb.devcb.reset_timer);
+
     STREAM_TO_UINT8  (status, p);
 
     if (status == HCI_SUCCESS)
     {
         STREAM_TO_UINT8(btm_cb.ble_ctr_cb.max_filter_entries, p);
         btm_cb.ble_ctr_cb.num_empty_filter = btm_cb.ble_ctr_cb.max_filter_entries;
+        btm_cb.devcb.ctrl_caps.white_list_size = btm_cb.ble_ctr_cb.max_filter_entries;
+    }
+    else
+    {
+        btm_cb.devcb.ctrl_caps.le_valid = FALSE;
     }
-    /* write LE host support and simultatunous LE supported */
-    btsnd_hcic_ble_write_host_supported(BTM_BLE_HOST_SUPPORT, BTM_BLE_SIMULTANEOUS_HOST);
 
-    btm_get_ble_buffer_size();
+    btm_reset_read_done ();
 }
 
 #endif
@@ -982,9 +1098,120 @@ void btm_read_local_version_complete (UINT8 *p, UINT16 evt_len)
         STREAM_TO_UINT16 (p_vi->lmp_subversion, p);
     }
 
-    if (p_vi->hci_version >= HCI_PROTO_VERSION_1_2)
+    btm_reset_read_done ();
+}
+
+/*******************************************************************************
+**
+** Function         btm_reset_read_done
+**
+** Description      This function is called when a read issued as part of a
+**                  reset stage completes.  Once the last one is in, the next
+**                  stage of the reset sequence is started.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_reset_read_done (void)
+{
+    tBTM_DEVCB     *p_devcb = &btm_cb.devcb;
+    UINT8           stage = p_devcb->reset_stage;
+
+    if ((stage == BTM_RESET_STAGE_NONE) || (p_devcb->reset_pend == 0))
+        return;
+
+    if (--p_devcb->reset_pend > 0)
+    {
+        /* keep the reply timeout running for the reads still outstanding */
+        btu_start_timer (&p_devcb->reset_timer, BTU_TTYPE_BTM_DEV_CTL, BTM_DEV_REPLY_TIMEOUT);
+        return;
+    }
+
+    btu_stop_timer (&p_devcb->reset_timer);
+    p_devcb->reset_stage = BTM_RESET_STAGE_NONE;
+
+    BTM_TRACE_DEBUG ("btm_reset_read_done: stage %d complete", stage);
+
+    switch (stage)
+    {
+        case BTM_RESET_STAGE_VERSION:
+            btm_reset_version_done ();
+            break;
+
+        case BTM_RESET_STAGE_FEATURES:
+            btm_reset_features_done ();
+            break;
+
+#if BLE_INCLUDED == TRUE
+        case BTM_RESET_STAGE_LE:
+            btm_reset_le_done (TRUE);
+            break;
+#endif
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_reset_version_done
+**
+** Description      This function is called once the buffer size and local
+**                  version are known.  If the stored controller capabilities
+**                  were taken from the same controller firmware they are used
+**                  as they are, otherwise the supported commands and all the
+**                  LMP features pages are read at once.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_reset_version_done (void)
+{
+    tBTM_DEVCB         *p_devcb = &btm_cb.devcb;
+    tBTM_VERSION_INFO  *p_vi = &p_devcb->local_version;
+    tBTM_CTRL_CAPS     *p_caps = &p_devcb->ctrl_caps;
+    UINT8               page;
+
+    p_devcb->caps_loaded = FALSE;
+    p_devcb->caps_dirty  = FALSE;
+
+    if ((p_devcb->p_caps_load_cb) && ((*p_devcb->p_caps_load_cb)(p_caps))
+     && (p_caps->version.hci_version    == p_vi->hci_version)
+     && (p_caps->version.hci_revision   == p_vi->hci_revision)
+     && (p_caps->version.lmp_version    == p_vi->lmp_version)
+     && (p_caps->version.manufacturer   == p_vi->manufacturer)
+     && (p_caps->version.lmp_subversion == p_vi->lmp_subversion)
+     && (p_caps->max_page <= HCI_EXT_FEATURES_PAGE_MAX))
+    {
+        BTM_TRACE_EVENT ("btm_reset_version_done: using stored controller capabilities");
+
+        p_devcb->caps_loaded = TRUE;
+        memcpy (p_devcb->supported_cmds, p_caps->supported_cmds, HCI_NUM_SUPP_COMMANDS_BYTES);
+        memcpy (p_devcb->local_lmp_features, p_caps->lmp_features, sizeof (p_devcb->local_lmp_features));
+
+        btm_read_all_lmp_features_complete (p_caps->max_page);
+        return;
+    }
+
+    memset (p_caps, 0, sizeof (tBTM_CTRL_CAPS));
+    memcpy (&p_caps->version, p_vi, sizeof (tBTM_VERSION_INFO));
+
+    if (p_vi->hci_version >= HCI_PROTO_VERSION_2_0)
     {
-        btm_read_local_supported_cmds(LOCAL_BR_EDR_CONTROLLER_ID);
+        /* The pages beyond the last one the controller has are read too, the */
+        /* controller either fails those or returns them empty.                */
+        p_devcb->reset_stage    = BTM_RESET_STAGE_FEATURES;
+        p_devcb->reset_pend     = HCI_EXT_FEATURES_PAGE_MAX + 2;
+        p_devcb->reset_max_page = HCI_EXT_FEATURES_PAGE_0;
+        p_devcb->reset_pages    = 0;
+        p_devcb->caps_dirty     = TRUE;
+
+        btm_read_local_supported_cmds (LOCAL_BR_EDR_CONTROLLER_ID);
+        for (page = HCI_EXT_FEATURES_PAGE_0; page <= HCI_EXT_FEATURES_PAGE_MAX; page++)
+            btm_get_local_ext_features (page);
+    }
+    /* older controllers are brought up one read at a time */
+    else if (p_vi->hci_version >= HCI_PROTO_VERSION_1_2)
+    {
+        btm_read_local_supported_cmds (LOCAL_BR_EDR_CONTROLLER_ID);
     }
     else
     {
@@ -992,6 +1219,65 @@ void btm_read_local_version_complete (UINT8 *p, UINT16 evt_len)
     }
 }
 
+/*******************************************************************************
+**
+** Function         btm_reset_features_done
+**
+** Description      This function is called once the supported commands and
+**                  all the LMP features pages have been read.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_reset_features_done (void)
+{
+    tBTM_DEVCB     *p_devcb = &btm_cb.devcb;
+    tBTM_CTRL_CAPS *p_caps = &p_devcb->ctrl_caps;
+    UINT8           max_page = p_devcb->reset_max_page;
+    UINT8           page;
+
+    /* a page the controller has could not be read, don't remember this reset */
+    for (page = HCI_EXT_FEATURES_PAGE_0; page <= max_page; page++)
+    {
+        if (!(p_devcb->reset_pages & (1 << page)))
+        {
+            BTM_TRACE_WARNING ("btm_reset_features_done: features page %d not read", page);
+            p_devcb->caps_dirty = FALSE;
+        }
+    }
+
+    /* the controller has no features past its last page */
+    for (page = max_page + 1; page <= HCI_EXT_FEATURES_PAGE_MAX; page++)
+        memset (p_devcb->local_lmp_features[page], 0, HCI_FEATURE_BYTES_PER_PAGE);
+
+    /* keep the pages as the controller reported them, before host support is written */
+    memcpy (p_caps->supported_cmds, p_devcb->supported_cmds, HCI_NUM_SUPP_COMMANDS_BYTES);
+    memcpy (p_caps->lmp_features, p_devcb->local_lmp_features, sizeof (p_caps->lmp_features));
+    p_caps->max_page = max_page;
+
+    btm_read_all_lmp_features_complete (max_page);
+}
+
+/*******************************************************************************
+**
+** Function         btm_store_ctrl_caps
+**
+** Description      This function hands the controller capabilities read during
+**                  this reset to the registered store, if any.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_store_ctrl_caps (void)
+{
+    tBTM_DEVCB     *p_devcb = &btm_cb.devcb;
+
+    if (p_devcb->caps_dirty && p_devcb->p_caps_store_cb)
+        (*p_devcb->p_caps_store_cb)(&p_devcb->ctrl_caps);
+
+    p_devcb->caps_dirty = FALSE;
+}
+
 /*******************************************************************************
 **
 ** Function         btm_decode_ext_features_page
@@ -1205,6 +1491,8 @@ void btm_reset_ctrlr_complete ()
 
     btu_stop_timer (&btm_cb.devcb.reset_timer);
 
+    btm_store_ctrl_caps ();
+
     /* find the highest feature page number which contains non-zero bits */
     for (i = HCI_EXT_FEATURES_PAGE_MAX; ; i--)
     {
@@ -1358,7 +1646,7 @@ static void btm_issue_host_support_for_lmp_features (void)
 #if BLE_INCLUDED == TRUE
         if (HCI_LE_HOST_SUPPORTED(btm_cb.devcb.local_lmp_features[HCI_EXT_FEATURES_PAGE_1]))
         {
-            btm_read_ble_wl_size();
+            btm_read_ble_caps();
         }
         else
 #elif BTM_INTERNAL_BB == TRUE
@@ -1527,6 +1815,35 @@ void btm_read_local_ext_features_complete (UINT8 *p, UINT16 evt_len)
 
     STREAM_TO_UINT8 (status, p);
 
+    /* one of the pages read together during reset */
+    if (p_devcb->reset_stage == BTM_RESET_STAGE_FEATURES)
+    {
+        if (status == HCI_SUCCESS)
+        {
+            STREAM_TO_UINT8 (page_number, p);
+            STREAM_TO_UINT8 (page_number_max, p);
+
+            if ((page_number <= HCI_EXT_FEATURES_PAGE_MAX) && (page_number <= page_number_max))
+            {
+                STREAM_TO_ARRAY(p_devcb->local_lmp_features[page_number],
+                        p, HCI_FEATURE_BYTES_PER_PAGE);
+                p_devcb->reset_pages |= (1 << page_number);
+            }
+
+            if (page_number_max > HCI_EXT_FEATURES_PAGE_MAX)
+                page_number_max = HCI_EXT_FEATURES_PAGE_MAX;
+            if (page_number_max > p_devcb->reset_max_page)
+                p_devcb->reset_max_page = page_number_max;
+        }
+        else
+        {
+            /* expected for the pages past the last one, checked once all are in */
+            BTM_TRACE_DEBUG("btm_read_local_ext_features_complete status = 0x%02X", status);
+        }
+        btm_reset_read_done ();
+        return;
+    }
+
     if (status != HCI_SUCCESS)
     {
         BTM_TRACE_WARNING("btm_read_local_ext_features_complete status = 0x%02X", status);
@@ -1604,7 +1921,17 @@ void btm_read_local_supported_cmds_complete (UINT8 *p)
         STREAM_TO_ARRAY(p_devcb->supported_cmds, p, HCI_NUM_SUPP_COMMANDS_BYTES);
     }
 
-    btm_get_local_features();
+    /* read together with the features pages during reset */
+    if (p_devcb->reset_stage == BTM_RESET_STAGE_FEATURES)
+    {
+        if (status != HCI_SUCCESS)
+            p_devcb->caps_dirty = FALSE;
+        btm_reset_read_done ();
+    }
+    else
+    {
+        btm_get_local_features();
+    }
 }
 
 /*******************************************************************************
@@ -2094,6 +2421,23 @@ tBTM_DEV_STATUS_CB *BTM_RegisterForDeviceStatusNotif (tBTM_DEV_STATUS_CB *p_cb)
     return (p_prev);
 }
 
+/*******************************************************************************
+**
+** Function         BTM_RegisterCtrlCapsCache
+**
+** Description      This function is called to register a persistent store for
+**                  the controller capabilities read during device reset.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTM_RegisterCtrlCapsCache (tBTM_CTRL_CAPS_LOAD_CB *p_load_cb,
+                                tBTM_CTRL_CAPS_STORE_CB *p_store_cb)
+{
+    btm_cb.devcb.p_caps_load_cb  = p_load_cb;
+    btm_cb.devcb.p_caps_store_cb = p_store_cb;
+}
+
 
 /*******************************************************************************
 **
@@ -2151,18 +2495,44 @@ tBTM_STATUS BTM_Hci_Raw_Command(UINT16 opcode, UINT8 param_len,
 *******************************************************************************/
 tBTM_STATUS BTM_VendorSpecificCommand(UINT16 opcode, UINT8 param_len,
                                       UINT8 *p_param_buf, tBTM_VSC_CMPL_CB *p_cb)
+{
+    return BTM_VendorSpecificCommandWithContext(opcode, param_len, p_param_buf, p_cb, NULL, 0);
+}
+
+/*******************************************************************************
+**
+** Function         BTM_VendorSpecificCommandWithContext
+**
+** Description      Send a vendor specific HCI command to the controller, with
+**                  a context handed back in the command complete callback.
+**
+** Returns
+**      BTM_SUCCESS         Command sent. Does not expect command complete
+**                              event. (command cmpl callback param is NULL)
+**      BTM_CMD_STARTED     Command sent. Waiting for command cmpl event.
+**      BTM_ILLEGAL_VALUE   Context too long.
+**      BTM_NO_RESOURCES    Command not sent.
+**
+*******************************************************************************/
+tBTM_STATUS BTM_VendorSpecificCommandWithContext(UINT16 opcode, UINT8 param_len,
+                                                 UINT8 *p_param_buf, tBTM_VSC_CMPL_CB *p_cb,
+                                                 void *p_context, UINT8 context_len)
 {
     void *p_buf;
 
     BTM_TRACE_EVENT ("BTM: BTM_VendorSpecificCommand: Opcode: 0x%04X, ParamLen: %i.",
                       opcode, param_len);
 
-    /* Allocate a buffer to hold HCI command plus the callback function */
-    if ((p_buf = GKI_getbuf((UINT16)(sizeof(BT_HDR) + sizeof (tBTM_CMPL_CB *) +
+    if (context_len > BTM_VSC_CONTEXT_LEN)
+        return (BTM_ILLEGAL_VALUE);
+
+    /* Allocate a buffer to hold HCI command plus the callback function and context */
+    if ((p_buf = GKI_getbuf((UINT16)(sizeof(BT_HDR) + sizeof (tBTM_CMPL_CB *) + context_len +
                             param_len + HCIC_PREAMBLE_SIZE))) != NULL)
     {
         /* Send the HCI command (opcode will be OR'd with HCI_GRP_VENDOR_SPECIFIC) */
-        btsnd_hcic_vendor_spec_cmd (p_buf, opcode, param_len, p_param_buf, (void *)p_cb);
+        btsnd_hcic_vendor_spec_cmd_ctx (p_buf, opcode, param_len, p_param_buf, (void *)p_cb,
+                                        p_context, context_len);
 
         /* Return value */
         if (p_cb != NULL)
@@ -2187,7 +2557,7 @@ tBTM_STATUS BTM_VendorSpecificCommand(UINT16 opcode, UINT8 param_len,
 **
 *******************************************************************************/
 void btm_vsc_complete (UINT8 *p, UINT16 opcode, UINT16 evt_len,
-                       tBTM_CMPL_CB *p_vsc_cplt_cback)
+                       tBTM_CMPL_CB *p_vsc_cplt_cback, UINT8 *p_context, UINT8 context_len)
 {
     tBTM_VSC_CMPL   vcs_cplt_params;
 
@@ -2198,6 +2568,8 @@ void btm_vsc_complete (UINT8 *p, UINT16 opcode, UINT16 evt_len,
         vcs_cplt_params.opcode = opcode;        /* Number of bytes in return info */
         vcs_cplt_params.param_len = evt_len;    /* Number of bytes in return info */
         vcs_cplt_params.p_param_buf = p;
+        vcs_cplt_params.p_context = p_context;
+        vcs_cplt_params.context_len = context_len;
         (*p_vsc_cplt_cback)(&vcs_cplt_params);  /* Call the VSC complete callback function */
     }
 }
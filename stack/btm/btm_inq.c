@@ -37,6 +37,7 @@
 #include "btm_api.h"
 #include "btm_int.h"
 #include "hcidefs.h"
+#include "sdp_api.h"
 
 #define BTM_INQ_REPLY_TIMEOUT   3       /* 3 second timeout waiting for responses */
 
@@ -2332,6 +2333,11 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
                         BTM_EIR_SERVICE_ARRAY_SIZE * (BTM_EIR_ARRAY_BITS/8));
                 /* set bit map of UUID list from received EIR */
                 btm_set_eir_uuid( p, p_cur );
+#if (SDP_CACHE_INCLUDED == TRUE)
+                /* a changed service list makes cached SDP results stale */
+                SDP_CacheEirUpdate (p_cur->remote_bd_addr, (UINT8 *)p_cur->eir_uuid,
+                                    sizeof(p_cur->eir_uuid));
+#endif
                 p_eir_data = p;
             }
             else
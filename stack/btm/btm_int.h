@@ -42,7 +42,7 @@
 #endif
 #endif
 
-tBTM_BLE_MULTI_ADV_CB  btm_multi_adv_cb;
+extern tBTM_BLE_MULTI_ADV_CB  btm_multi_adv_cb;
 
 #if BTM_MAX_LOC_BD_NAME_LEN > 0
 typedef char tBTM_LOC_BD_NAME[BTM_MAX_LOC_BD_NAME_LEN + 1];
@@ -198,7 +198,7 @@ typedef struct
     tBTM_BLE_LOCAL_ID_KEYS  id_keys;        /* local BLE ID keys                    */
     BT_OCTET16              er;             /* BLE encryption key                   */
 
-#define BTM_LE_SUPPORT_STATE_SIZE   8
+#define BTM_LE_SUPPORT_STATE_SIZE   BTM_LE_SUPPORT_STATES_LEN
 UINT8                   le_supported_states[BTM_LE_SUPPORT_STATE_SIZE];
 
 
@@ -239,6 +239,23 @@ UINT8                   le_supported_states[BTM_LE_SUPPORT_STATE_SIZE];
     UINT8               lmp_features_host_may_support;  /* The flags of LMP features host may support via BR/EDR ctrlr + BTM_RE_READ_1ST_PAGE */
     UINT8               supported_cmds[HCI_NUM_SUPP_COMMANDS_BYTES]; /* Supported Commands bit field */
 
+    /* Reset sequence: independent reads are issued together and the next
+    ** stage starts once all of them have completed */
+#define BTM_RESET_STAGE_NONE            0
+#define BTM_RESET_STAGE_VERSION         1   /* buffer size and local version */
+#define BTM_RESET_STAGE_FEATURES        2   /* supported commands and LMP features pages */
+#define BTM_RESET_STAGE_LE              3   /* LE buffer size, white list, states and features */
+    UINT8               reset_stage;
+    UINT8               reset_pend;         /* reads outstanding in reset_stage */
+    UINT8               reset_max_page;     /* max LMP features page reported by controller */
+    UINT8               reset_pages;        /* bit mask of the LMP features pages read */
+
+    tBTM_CTRL_CAPS_LOAD_CB  *p_caps_load_cb;
+    tBTM_CTRL_CAPS_STORE_CB *p_caps_store_cb;
+    tBTM_CTRL_CAPS      ctrl_caps;          /* snapshot being built or loaded */
+    BOOLEAN             caps_loaded;        /* ctrl_caps matches the controller */
+    BOOLEAN             caps_dirty;         /* ctrl_caps has reads not yet stored */
+
 } tBTM_DEVCB;
 
 
@@ -924,6 +941,12 @@ typedef struct
     UINT8                    disc_reason;   /* for legacy devices */
     tBTM_SEC_SERV_REC        sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
     tBTM_SEC_DEV_REC         sec_dev_rec[BTM_SEC_MAX_DEVICE_RECORDS];
+    /* lookup tables over sec_dev_rec; entries are record index + 1, 0 is none */
+    UINT16                   sec_dev_hash[BTM_SEC_DEV_HASH_SIZE];        /* in use records by BD address */
+    UINT16                   sec_dev_next[BTM_SEC_MAX_DEVICE_RECORDS];   /* next record in the same bucket */
+    UINT16                   sec_dev_handle_hint[BTM_SEC_DEV_HASH_SIZE]; /* last record found by handle */
+    tBTM_SEC_DEV_LOAD_CBACK *p_dev_load_cback;  /* pages bonded devices in from storage */
+    BOOLEAN                  dev_loading;       /* p_dev_load_cback is running */
     tBTM_SEC_SERV_REC       *p_out_serv;
     tBTM_MKEY_CALLBACK      *mkey_cback;
 
@@ -1124,7 +1147,8 @@ extern void btm_ble_clear_white_list_complete(UINT8 *p, UINT16 evt_len);
 
 /* Vendor Specific Command complete evt handler */
 extern void btm_vsc_complete (UINT8 *p, UINT16 cc_opcode, UINT16 evt_len,
-                              tBTM_CMPL_CB *p_vsc_cplt_cback);
+                              tBTM_CMPL_CB *p_vsc_cplt_cback, UINT8 *p_context,
+                              UINT8 context_len);
 extern void btm_inq_db_reset (void);
 extern void btm_vendor_specific_evt (UINT8 *p, UINT8 evt_len);
 extern UINT8 btm_get_hci_version (void);
@@ -1142,6 +1166,7 @@ extern BOOLEAN btm_dev_support_switch (BD_ADDR bd_addr);
 extern UINT8 btm_get_voice_coding_support (void);
 
 extern tBTM_SEC_DEV_REC  *btm_sec_alloc_dev (BD_ADDR bd_addr);
+extern tBTM_SEC_DEV_REC  *btm_sec_alloc_rec (BD_ADDR bd_addr);
 extern void               btm_sec_free_dev (tBTM_SEC_DEV_REC *p_dev_rec);
 extern tBTM_SEC_DEV_REC  *btm_find_dev (BD_ADDR bd_addr);
 extern tBTM_SEC_DEV_REC  *btm_find_or_alloc_dev (BD_ADDR bd_addr);
@@ -144,23 +144,265 @@ static void btu_hcif_encryption_key_refresh_cmpl_evt (UINT8 *p);
 static void btu_ble_rc_param_req_evt(UINT8 *p);
 #endif
     #endif
+/*******************************************************************************
+**
+** Function         btu_hcif_init_cmd_cb
+**
+** Description      This function initializes the command control block of a
+**                  controller. The control block must already be zeroed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btu_hcif_init_cmd_cb (UINT8 controller_id)
+{
+    tHCI_CMD_CB *p_hci_cmd_cb = &(btu_cb.hci_cmd_cb[controller_id]);
+
+    p_hci_cmd_cb->cmd_window = 1;
+    memset (p_hci_cmd_cb->pend_hash, BTU_CMD_SLOT_NONE, sizeof(p_hci_cmd_cb->pend_hash));
+}
+
+#if (defined(BTU_CMD_STATS_INCLUDED) && BTU_CMD_STATS_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         btu_hcif_find_cmd_stats
+**
+** Description      This function looks up the statistics entry of an opcode,
+**                  optionally claiming an unused entry for it.
+**
+** Returns          pointer to the entry, or NULL if not found or table full
+**
+*******************************************************************************/
+static tHCI_CMD_STATS *btu_hcif_find_cmd_stats (tHCI_CMD_CB *p_hci_cmd_cb, UINT16 opcode,
+                                                BOOLEAN create)
+{
+    tHCI_CMD_STATS *p_stats;
+    UINT16         xx, idx = (UINT16)((opcode * 31) % BTU_CMD_STATS_SIZE);
+
+    for (xx = 0; xx < BTU_CMD_STATS_SIZE; xx++)
+    {
+        p_stats = &p_hci_cmd_cb->stats[(idx + xx) % BTU_CMD_STATS_SIZE];
+
+        if (p_stats->opcode == opcode)
+            return p_stats;
+
+        if (p_stats->opcode == HCI_COMMAND_NONE)
+        {
+            if (!create)
+                return NULL;
+
+            p_stats->opcode = opcode;
+            return p_stats;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btu_hcif_update_cmd_stats
+**
+** Description      This function records the completion of a command.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btu_hcif_update_cmd_stats (tHCI_CMD_CB *p_hci_cmd_cb, tHCI_PEND_CMD *p_pend,
+                                       BOOLEAN timed_out)
+{
+    tHCI_CMD_STATS *p_stats = btu_hcif_find_cmd_stats (p_hci_cmd_cb, p_pend->opcode, TRUE);
+    UINT64         elapsed_us = GKI_now_us() - p_pend->sent_us;
+    UINT32         latency_us = (elapsed_us > 0xFFFFFFFF) ? 0xFFFFFFFF : (UINT32)elapsed_us;
+    UINT32         ms = latency_us / 1000;
+    UINT8          bucket = 0;
+
+    if (p_stats == NULL)
+        return;
+
+    while (ms != 0 && bucket < BTU_CMD_LAT_BUCKETS - 1)
+    {
+        ms >>= 1;
+        bucket++;
+    }
+
+    p_stats->count++;
+    p_stats->total_us += latency_us;
+    p_stats->lat_hist[bucket]++;
+    if (latency_us > p_stats->max_us)
+        p_stats->max_us = latency_us;
+    if (timed_out)
+        p_stats->timeouts++;
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         btu_hcif_find_pend_cmd
+**
+** Description      This function finds the oldest outstanding command with
+**                  the given opcode.
+**
+** Returns          slot index, or BTU_CMD_SLOT_NONE if there is none
+**
+*******************************************************************************/
+static UINT8 btu_hcif_find_pend_cmd (tHCI_CMD_CB *p_hci_cmd_cb, UINT16 opcode)
+{
+    UINT8 slot = p_hci_cmd_cb->pend_hash[BTU_CMD_HASH(opcode)];
+
+    while (slot != BTU_CMD_SLOT_NONE && p_hci_cmd_cb->pend[slot].opcode != opcode)
+        slot = p_hci_cmd_cb->pend[slot].next;
+
+    return slot;
+}
+
+/*******************************************************************************
+**
+** Function         btu_hcif_oldest_pend_cmd
+**
+** Description      This function finds the outstanding command that was sent
+**                  first.
+**
+** Returns          slot index, or BTU_CMD_SLOT_NONE if there is none
+**
+*******************************************************************************/
+static UINT8 btu_hcif_oldest_pend_cmd (tHCI_CMD_CB *p_hci_cmd_cb)
+{
+    UINT8 xx, slot = BTU_CMD_SLOT_NONE;
+
+    for (xx = 0; xx < BTU_MAX_PEND_CMDS; xx++)
+    {
+        if (p_hci_cmd_cb->pend[xx].p_cmd == NULL)
+            continue;
+
+        /* sequence numbers wrap, compare distances */
+        if (slot == BTU_CMD_SLOT_NONE ||
+            (INT32)(p_hci_cmd_cb->pend[xx].seq - p_hci_cmd_cb->pend[slot].seq) < 0)
+            slot = xx;
+    }
+    return slot;
+}
+
+/*******************************************************************************
+**
+** Function         btu_hcif_remove_pend_cmd
+**
+** Description      This function takes a command out of the pending table
+**                  and records its latency.
+**
+** Returns          the stored copy of the command, to be freed by the caller
+**
+*******************************************************************************/
+static BT_HDR *btu_hcif_remove_pend_cmd (tHCI_CMD_CB *p_hci_cmd_cb, UINT8 slot,
+                                         BOOLEAN timed_out)
+{
+    tHCI_PEND_CMD *p_pend = &p_hci_cmd_cb->pend[slot];
+    UINT8         *p_link = &p_hci_cmd_cb->pend_hash[BTU_CMD_HASH(p_pend->opcode)];
+    BT_HDR        *p_cmd = p_pend->p_cmd;
+
+    while (*p_link != slot)
+        p_link = &p_hci_cmd_cb->pend[*p_link].next;
+    *p_link = p_pend->next;
+
+#if (defined(BTU_CMD_STATS_INCLUDED) && BTU_CMD_STATS_INCLUDED == TRUE)
+    btu_hcif_update_cmd_stats (p_hci_cmd_cb, p_pend, timed_out);
+#else
+    UNUSED(timed_out);
+#endif
+
+    p_pend->p_cmd = NULL;
+    p_hci_cmd_cb->pend_count--;
+    return p_cmd;
+}
+
+/*******************************************************************************
+**
+** Function         btu_hcif_restart_cmd_timer
+**
+** Description      This function restarts the command complete timer if any
+**                  command is still outstanding, and stops it otherwise.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btu_hcif_restart_cmd_timer (UINT8 controller_id)
+{
+    tHCI_CMD_CB *p_hci_cmd_cb = &(btu_cb.hci_cmd_cb[controller_id]);
+
+    if (BTU_CMD_CMPL_TIMEOUT > 0)
+    {
+        if (p_hci_cmd_cb->pend_count != 0)
+        {
+#if (defined(BTU_CMD_CMPL_TOUT_DOUBLE_CHECK) && BTU_CMD_CMPL_TOUT_DOUBLE_CHECK == TRUE)
+            p_hci_cmd_cb->checked_hcisu = FALSE;
+#endif
+            btu_start_timer (&(p_hci_cmd_cb->cmd_cmpl_timer),
+                             (UINT16)(BTU_TTYPE_BTU_CMD_CMPL + controller_id),
+                             BTU_CMD_CMPL_TIMEOUT);
+        }
+        else
+        {
+            btu_stop_timer (&(p_hci_cmd_cb->cmd_cmpl_timer));
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btu_hcif_cmd_cback
+**
+** Description      This function extracts the completion callback and caller
+**                  context carried by a stored command.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btu_hcif_cmd_cback (BT_HDR *p_cmd, UINT16 opcode, void **pp_cback,
+                                UINT8 **pp_context, UINT8 *p_context_len)
+{
+    *pp_cback = NULL;
+    *pp_context = NULL;
+    *p_context_len = 0;
+
+    if (p_cmd == NULL)
+        return;
+
+    if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC
+#if BLE_INCLUDED == TRUE
+        || (opcode == HCI_BLE_RAND )
+        || (opcode == HCI_BLE_ENCRYPT)
+#endif
+       )
+    {
+        *pp_cback = *((void **)(p_cmd + 1));
+
+        if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC &&
+            p_cmd->layer_specific != 0)
+        {
+            *pp_context = (UINT8 *)(p_cmd + 1) + sizeof(void *);
+            *p_context_len = (UINT8)p_cmd->layer_specific;
+        }
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         btu_hcif_store_cmd
 **
-** Description      This function stores a copy of an outgoing command and
-**                  and sets a timer waiting for a event in response to the
-**                  command.
+** Description      This function stores a copy of an outgoing command in the
+**                  pending table and sets a timer waiting for a event in
+**                  response to the command.
 **
 ** Returns          void
 **
 *******************************************************************************/
 static void btu_hcif_store_cmd (UINT8 controller_id, BT_HDR *p_buf)
 {
-    tHCI_CMD_CB *p_hci_cmd_cb;
+    tHCI_CMD_CB   *p_hci_cmd_cb;
+    tHCI_PEND_CMD *p_pend;
     UINT16  opcode;
     BT_HDR  *p_cmd;
-    UINT8   *p;
+    UINT8   *p, *p_link;
+    UINT8   slot;
 
     /* Validate controller ID */
     if (controller_id >= BTU_MAX_LOCAL_CTRLS)
@@ -178,31 +420,43 @@ static void btu_hcif_store_cmd (UINT8 controller_id, BT_HDR *p_buf)
         return;
     }
 
+    /* btu_hcif_send_cmd only sends when a slot is free */
+    for (slot = 0; slot < BTU_MAX_PEND_CMDS; slot++)
+    {
+        if (p_hci_cmd_cb->pend[slot].p_cmd == NULL)
+            break;
+    }
+    if (slot == BTU_MAX_PEND_CMDS)
+    {
+        HCI_TRACE_ERROR("BTU HCI(id=%d) no slot for opcode 0x%04x", controller_id, opcode);
+        return;
+    }
+
     /* allocate buffer (HCI_GET_CMD_BUF will either get a buffer from HCI_CMD_POOL or from 'best-fit' pool) */
     if ((p_cmd = HCI_GET_CMD_BUF(p_buf->len + p_buf->offset - HCIC_PREAMBLE_SIZE)) == NULL)
     {
         return;
     }
 
-    /* copy buffer */
+    /* copy the header and everything up to the end of the command, which
+    ** includes the callback and context of commands that carry them */
     memcpy (p_cmd, p_buf, sizeof(BT_HDR));
+    memcpy ((UINT8 *)(p_cmd + 1), (UINT8 *)(p_buf + 1), p_buf->offset + p_buf->len);
 
-    /* If vendor specific save the callback function */
-    if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC
-#if BLE_INCLUDED == TRUE
-        || (opcode == HCI_BLE_RAND )
-        || (opcode == HCI_BLE_ENCRYPT)
-#endif
-       )
-    {
-        memcpy ((UINT8 *)(p_cmd + 1), (UINT8 *)(p_buf + 1), sizeof(void *));
-    }
+    p_pend = &p_hci_cmd_cb->pend[slot];
+    p_pend->p_cmd = p_cmd;
+    p_pend->opcode = opcode;
+    p_pend->seq = p_hci_cmd_cb->pend_seq++;
+    p_pend->sent_us = GKI_now_us();
+    p_pend->next = BTU_CMD_SLOT_NONE;
 
-    memcpy ((UINT8 *)(p_cmd + 1) + p_cmd->offset,
-            (UINT8 *)(p_buf + 1) + p_buf->offset, p_buf->len);
+    /* append to its bucket so commands with the same opcode stay in order */
+    p_link = &p_hci_cmd_cb->pend_hash[BTU_CMD_HASH(opcode)];
+    while (*p_link != BTU_CMD_SLOT_NONE)
+        p_link = &p_hci_cmd_cb->pend[*p_link].next;
+    *p_link = slot;
 
-    /* queue copy of cmd */
-    GKI_enqueue(&(p_hci_cmd_cb->cmd_cmpl_q), p_cmd);
+    p_hci_cmd_cb->pend_count++;
 
     /* start timer */
     if (BTU_CMD_CMPL_TIMEOUT > 0)
@@ -475,8 +729,8 @@ void btu_hcif_send_cmd (UINT8 controller_id, BT_HDR *p_buf)
         p_hci_cmd_cb->cmd_window = p_hci_cmd_cb->cmd_xmit_q.count + 1;
     }
 
-    /* See if we can send anything */
-    while (p_hci_cmd_cb->cmd_window != 0)
+    /* See if we can send anything, keeping a pending slot for each command */
+    while ((p_hci_cmd_cb->cmd_window != 0) && (p_hci_cmd_cb->pend_count < BTU_MAX_PEND_CMDS))
     {
         if (!p_buf)
             p_buf = (BT_HDR *)GKI_dequeue (&(p_hci_cmd_cb->cmd_xmit_q));
@@ -1011,7 +1265,8 @@ static void btu_hcif_esco_connection_chg_evt (UINT8 *p)
 **
 *******************************************************************************/
 static void btu_hcif_hdl_command_complete (UINT16 opcode, UINT8 *p, UINT16 evt_len,
-                                           void *p_cplt_cback)
+                                           void *p_cplt_cback, UINT8 *p_context,
+                                           UINT8 context_len)
 {
     switch (opcode)
     {
@@ -1188,7 +1443,8 @@ static void btu_hcif_hdl_command_complete (UINT16 opcode, UINT8 *p, UINT16 evt_l
 
         default:
             if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC)
-                btm_vsc_complete (p, opcode, evt_len, (tBTM_CMPL_CB *)p_cplt_cback);
+                btm_vsc_complete (p, opcode, evt_len, (tBTM_CMPL_CB *)p_cplt_cback,
+                                  p_context, context_len);
             break;
     }
 }
@@ -1206,8 +1462,11 @@ static void btu_hcif_command_complete_evt (UINT8 controller_id, UINT8 *p, UINT16
 {
     tHCI_CMD_CB *p_hci_cmd_cb = &(btu_cb.hci_cmd_cb[controller_id]);
     UINT16      cc_opcode;
-    BT_HDR      *p_cmd;
-    void        *p_cplt_cback = NULL;
+    BT_HDR      *p_cmd = NULL;
+    void        *p_cplt_cback;
+    UINT8       *p_context;
+    UINT8       context_len;
+    UINT8       slot;
 
     STREAM_TO_UINT8  (p_hci_cmd_cb->cmd_window, p);
 
@@ -1224,74 +1483,35 @@ static void btu_hcif_command_complete_evt (UINT8 controller_id, UINT8 *p, UINT16
     if ((cc_opcode != HCI_RESET) && (cc_opcode != HCI_HOST_NUM_PACKETS_DONE) &&
         (cc_opcode != HCI_COMMAND_NONE))
     {
-        /* dequeue and free stored command */
-
-/* always use cmd code check, when one cmd timeout waiting for cmd_cmpl,
-   it'll cause the rest of the command goes in wrong order                  */
-        p_cmd = (BT_HDR *) GKI_getfirst (&p_hci_cmd_cb->cmd_cmpl_q);
-
-        while (p_cmd)
-        {
-            UINT16 opcode_dequeued;
-            UINT8  *p_dequeued;
-
-            /* Make sure dequeued command is for the command_cplt received */
-            p_dequeued = (UINT8 *)(p_cmd + 1) + p_cmd->offset;
-            STREAM_TO_UINT16 (opcode_dequeued, p_dequeued);
+        /* always look the command up by opcode; when one command times out the
+        ** rest may complete out of order */
+        slot = btu_hcif_find_pend_cmd (p_hci_cmd_cb, cc_opcode);
 
-            /* extract the callback for vendor specific commands for which
-               controller has responded with 0xffff*/
-            if ( (opcode_dequeued != cc_opcode)
 #if (defined(BTM_READ_CTLR_CAP_INCLUDED) && BTM_READ_CTLR_CAP_INCLUDED == TRUE)
-                && !((opcode_dequeued == HCI_BLE_VENDOR_CAP_OCF) &&
-                   ((opcode_dequeued & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) &&
-                   ((cc_opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC))
-#endif
-            )
-            {
-                /* opcode does not match, check next command in the queue */
-                p_cmd = (BT_HDR *) GKI_getnext(p_cmd);
-                continue;
-            }
-            GKI_remove_from_queue(&p_hci_cmd_cb->cmd_cmpl_q, p_cmd);
-
-            /* If command was a VSC, then extract command_complete callback */
-            if ((cc_opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC
-#if BLE_INCLUDED == TRUE
-                || (cc_opcode == HCI_BLE_RAND )
-                || (cc_opcode == HCI_BLE_ENCRYPT)
+        /* some controllers answer the vendor capability command with another
+        ** vendor specific opcode (e.g. 0xffff) */
+        if ((slot == BTU_CMD_SLOT_NONE) &&
+            ((cc_opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC))
+        {
+            slot = btu_hcif_find_pend_cmd (p_hci_cmd_cb, HCI_BLE_VENDOR_CAP_OCF);
+        }
 #endif
-               )
-            {
-                p_cplt_cback = *((void **)(p_cmd + 1));
-            }
-
-            GKI_freebuf (p_cmd);
 
-            break;
-        }
+        if (slot != BTU_CMD_SLOT_NONE)
+            p_cmd = btu_hcif_remove_pend_cmd (p_hci_cmd_cb, slot, FALSE);
 
-        /* if more commands in queue restart timer */
-        if (BTU_CMD_CMPL_TIMEOUT > 0)
-        {
-            if (!GKI_queue_is_empty (&(p_hci_cmd_cb->cmd_cmpl_q)))
-            {
-#if (defined(BTU_CMD_CMPL_TOUT_DOUBLE_CHECK) && BTU_CMD_CMPL_TOUT_DOUBLE_CHECK == TRUE)
-                p_hci_cmd_cb->checked_hcisu = FALSE;
-#endif
-                btu_start_timer (&(p_hci_cmd_cb->cmd_cmpl_timer),
-                                 (UINT16)(BTU_TTYPE_BTU_CMD_CMPL + controller_id),
-                                 BTU_CMD_CMPL_TIMEOUT);
-            }
-            else
-            {
-                btu_stop_timer (&(p_hci_cmd_cb->cmd_cmpl_timer));
-            }
-        }
+        /* if more commands pending restart timer */
+        btu_hcif_restart_cmd_timer (controller_id);
     }
 
+    /* If command was a VSC, then extract command_complete callback */
+    btu_hcif_cmd_cback (p_cmd, cc_opcode, &p_cplt_cback, &p_context, &context_len);
+
     /* handle event */
-    btu_hcif_hdl_command_complete (cc_opcode, p, evt_len, p_cplt_cback);
+    btu_hcif_hdl_command_complete (cc_opcode, p, evt_len, p_cplt_cback, p_context, context_len);
+
+    if (p_cmd != NULL)
+        GKI_freebuf (p_cmd);
 
     /* see if we can send more commands */
     btu_hcif_send_cmd (controller_id, NULL);
@@ -1308,7 +1528,8 @@ static void btu_hcif_command_complete_evt (UINT8 controller_id, UINT8 *p, UINT16
 **
 *******************************************************************************/
 static void btu_hcif_hdl_command_status (UINT16 opcode, UINT8 status, UINT8 *p_cmd,
-                                         void *p_vsc_status_cback)
+                                         void *p_vsc_status_cback, UINT8 *p_context,
+                                         UINT8 context_len)
 {
     BD_ADDR         bd_addr;
     UINT16          handle;
@@ -1455,7 +1676,8 @@ static void btu_hcif_hdl_command_status (UINT16 opcode, UINT8 status, UINT8 *p_c
 */
                     default:
                         if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC)
-                            btm_vsc_complete (&status, opcode, 1, (tBTM_CMPL_CB *)p_vsc_status_cback);
+                            btm_vsc_complete (&status, opcode, 1, (tBTM_CMPL_CB *)p_vsc_status_cback,
+                                              p_context, context_len);
                         break;
                 }
 
@@ -1463,7 +1685,8 @@ static void btu_hcif_hdl_command_status (UINT16 opcode, UINT8 status, UINT8 *p_c
             else
             {
                 if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC)
-                    btm_vsc_complete (&status, opcode, 1, (tBTM_CMPL_CB *)p_vsc_status_cback);
+                    btm_vsc_complete (&status, opcode, 1, (tBTM_CMPL_CB *)p_vsc_status_cback,
+                                      p_context, context_len);
             }
 #if BTM_PWR_MGR_INCLUDED == TRUE
     }
@@ -1484,10 +1707,12 @@ static void btu_hcif_command_status_evt (UINT8 controller_id, UINT8 *p)
     tHCI_CMD_CB * p_hci_cmd_cb = &(btu_cb.hci_cmd_cb[controller_id]);
     UINT8       status;
     UINT16      opcode;
-    UINT16      cmd_opcode;
     BT_HDR      *p_cmd = NULL;
     UINT8       *p_data = NULL;
-    void        *p_vsc_status_cback = NULL;
+    void        *p_vsc_status_cback;
+    UINT8       *p_context;
+    UINT8       context_len;
+    UINT8       slot;
 
     STREAM_TO_UINT8  (status, p);
     STREAM_TO_UINT8  (p_hci_cmd_cb->cmd_window, p);
@@ -1503,54 +1728,25 @@ static void btu_hcif_command_status_evt (UINT8 controller_id, UINT8 *p)
     if ((opcode != HCI_RESET) && (opcode != HCI_HOST_NUM_PACKETS_DONE) &&
         (opcode != HCI_COMMAND_NONE))
     {
-        /*look for corresponding command in cmd_queue*/
-        p_cmd = (BT_HDR *) GKI_getfirst(&(p_hci_cmd_cb->cmd_cmpl_q));
-        while (p_cmd)
+        /*look for corresponding command in the pending table*/
+        if ((slot = btu_hcif_find_pend_cmd (p_hci_cmd_cb, opcode)) != BTU_CMD_SLOT_NONE)
         {
-            p_data = (UINT8 *)(p_cmd + 1) + p_cmd->offset;
-            STREAM_TO_UINT16 (cmd_opcode, p_data);
+            p_cmd = btu_hcif_remove_pend_cmd (p_hci_cmd_cb, slot, FALSE);
 
-            /* Make sure this  command is for the command_status received */
-            if (cmd_opcode != opcode)
-            {
-                /* opcode does not match, check next command in the queue */
-                p_cmd = (BT_HDR *) GKI_getnext(p_cmd);
-                continue;
-            }
-            else
-            {
-                GKI_remove_from_queue(&p_hci_cmd_cb->cmd_cmpl_q, p_cmd);
-
-                /* If command was a VSC, then extract command_status callback */
-                 if ((cmd_opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC)
-                {
-                    p_vsc_status_cback = *((void **)(p_cmd + 1));
-                }
-                break;
-            }
+            /* parameters of the command, past the opcode */
+            p_data = (UINT8 *)(p_cmd + 1) + p_cmd->offset + sizeof(UINT16);
         }
 
-        /* if more commands in queue restart timer */
-        if (BTU_CMD_CMPL_TIMEOUT > 0)
-        {
-            if (!GKI_queue_is_empty (&(p_hci_cmd_cb->cmd_cmpl_q)))
-            {
-#if (defined(BTU_CMD_CMPL_TOUT_DOUBLE_CHECK) && BTU_CMD_CMPL_TOUT_DOUBLE_CHECK == TRUE)
-                p_hci_cmd_cb->checked_hcisu = FALSE;
-#endif
-                btu_start_timer (&(p_hci_cmd_cb->cmd_cmpl_timer),
-                                 (UINT16)(BTU_TTYPE_BTU_CMD_CMPL + controller_id),
-                                 BTU_CMD_CMPL_TIMEOUT);
-            }
-            else
-            {
-                btu_stop_timer (&(p_hci_cmd_cb->cmd_cmpl_timer));
-            }
-        }
+        /* if more commands pending restart timer */
+        btu_hcif_restart_cmd_timer (controller_id);
     }
 
+    /* If command was a VSC, then extract command_status callback */
+    btu_hcif_cmd_cback (p_cmd, opcode, &p_vsc_status_cback, &p_context, &context_len);
+
     /* handle command */
-    btu_hcif_hdl_command_status (opcode, status, p_data, p_vsc_status_cback);
+    btu_hcif_hdl_command_status (opcode, status, p_data, p_vsc_status_cback, p_context,
+                                 context_len);
 
     /* free stored command */
     if (p_cmd != NULL)
@@ -1580,7 +1776,10 @@ void btu_hcif_cmd_timeout (UINT8 controller_id)
     tHCI_CMD_CB * p_hci_cmd_cb = &(btu_cb.hci_cmd_cb[controller_id]);
     BT_HDR  *p_cmd;
     UINT8   *p;
-    void    *p_cplt_cback = NULL;
+    void    *p_cplt_cback;
+    UINT8   *p_context;
+    UINT8   context_len;
+    UINT8   slot;
     UINT16  opcode;
     UINT16  event;
 
@@ -1606,26 +1805,17 @@ void btu_hcif_cmd_timeout (UINT8 controller_id)
     ** the flow of commands from the stack doesn't hang */
     p_hci_cmd_cb->cmd_window = 1;
 
-    /* get queued command */
-    if ((p_cmd = (BT_HDR *) GKI_dequeue (&(p_hci_cmd_cb->cmd_cmpl_q))) == NULL)
+    /* the command sent first is the one that timed out */
+    if ((slot = btu_hcif_oldest_pend_cmd (p_hci_cmd_cb)) == BTU_CMD_SLOT_NONE)
     {
         HCI_TRACE_WARNING("Cmd timeout; no cmd in queue");
         return;
     }
+    p_cmd = btu_hcif_remove_pend_cmd (p_hci_cmd_cb, slot, TRUE);
 
-    /* if more commands in queue restart timer */
-    if (BTU_CMD_CMPL_TIMEOUT > 0)
-    {
-        if (!GKI_queue_is_empty (&(p_hci_cmd_cb->cmd_cmpl_q)))
-        {
-#if (defined(BTU_CMD_CMPL_TOUT_DOUBLE_CHECK) && BTU_CMD_CMPL_TOUT_DOUBLE_CHECK == TRUE)
-            p_hci_cmd_cb->checked_hcisu = FALSE;
-#endif
-            btu_start_timer (&(p_hci_cmd_cb->cmd_cmpl_timer),
-                             (UINT16)(BTU_TTYPE_BTU_CMD_CMPL + controller_id),
-                             BTU_CMD_CMPL_TIMEOUT);
-        }
-    }
+    /* if more commands pending restart timer */
+    if (p_hci_cmd_cb->pend_count != 0)
+        btu_hcif_restart_cmd_timer (controller_id);
 
     p = (UINT8 *)(p_cmd + 1) + p_cmd->offset;
 #if (NFC_INCLUDED == TRUE)
@@ -1675,24 +1865,17 @@ void btu_hcif_cmd_timeout (UINT8 controller_id)
         case HCI_SETUP_ESCO_CONNECTION:
 #endif
             /* fake a command status */
-            btu_hcif_hdl_command_status (opcode, HCI_ERR_UNSPECIFIED, p, NULL);
+            btu_hcif_hdl_command_status (opcode, HCI_ERR_UNSPECIFIED, p, NULL, NULL, 0);
             break;
 
         default:
             /* If vendor specific restore the callback function */
-            if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC
-#if BLE_INCLUDED == TRUE
-                || (opcode == HCI_BLE_RAND ) ||
-                (opcode == HCI_BLE_ENCRYPT)
-#endif
-               )
-            {
-                p_cplt_cback = *((void **)(p_cmd + 1));
-            }
+            btu_hcif_cmd_cback (p_cmd, opcode, &p_cplt_cback, &p_context, &context_len);
 
             /* fake a command complete; first create a fake event */
             event = HCI_ERR_UNSPECIFIED;
-            btu_hcif_hdl_command_complete (opcode, (UINT8 *)&event, 1, p_cplt_cback);
+            btu_hcif_hdl_command_complete (opcode, (UINT8 *)&event, 1, p_cplt_cback,
+                                           p_context, context_len);
             break;
     }
 
@@ -2257,19 +2440,86 @@ static void btu_hcif_simple_pair_complete_evt (UINT8 *p)
 *******************************************************************************/
 void btu_hcif_flush_cmd_queue(void)
 {
+    tHCI_CMD_CB *p_hci_cmd_cb = &btu_cb.hci_cmd_cb[0];
     BT_HDR *p_cmd;
+    UINT8  xx;
 
-    btu_cb.hci_cmd_cb[0].cmd_window = 0;
-    while ((p_cmd = (BT_HDR *) GKI_dequeue (&btu_cb.hci_cmd_cb[0].cmd_cmpl_q)) != NULL)
+    p_hci_cmd_cb->cmd_window = 0;
+    for (xx = 0; xx < BTU_MAX_PEND_CMDS; xx++)
     {
-        GKI_freebuf (p_cmd);
+        if (p_hci_cmd_cb->pend[xx].p_cmd != NULL)
+        {
+            GKI_freebuf (p_hci_cmd_cb->pend[xx].p_cmd);
+            p_hci_cmd_cb->pend[xx].p_cmd = NULL;
+        }
     }
+    memset (p_hci_cmd_cb->pend_hash, BTU_CMD_SLOT_NONE, sizeof(p_hci_cmd_cb->pend_hash));
+    p_hci_cmd_cb->pend_count = 0;
     while ((p_cmd = (BT_HDR *) GKI_dequeue (&btu_cb.hci_cmd_cb[0].cmd_xmit_q)) != NULL)
     {
         GKI_freebuf (p_cmd);
     }
 }
 
+#if (defined(BTU_CMD_STATS_INCLUDED) && BTU_CMD_STATS_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         btu_hcif_get_cmd_stats
+**
+** Description      This function returns the completion statistics of one
+**                  HCI command opcode since the stack was enabled.
+**
+** Returns          pointer to the statistics, or NULL if the opcode has not
+**                  completed yet
+**
+*******************************************************************************/
+const tHCI_CMD_STATS *btu_hcif_get_cmd_stats (UINT8 controller_id, UINT16 opcode)
+{
+    if (controller_id >= BTU_MAX_LOCAL_CTRLS || opcode == HCI_COMMAND_NONE)
+        return NULL;
+
+    return btu_hcif_find_cmd_stats (&btu_cb.hci_cmd_cb[controller_id], opcode, FALSE);
+}
+
+/*******************************************************************************
+**
+** Function         btu_hcif_dump_cmd_stats
+**
+** Description      This function traces the count, timeouts, mean and maximum
+**                  latency and latency histogram of every opcode sent.  It must
+**                  run on the BTU task, which updates the stats, and is called
+**                  as that task exits.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btu_hcif_dump_cmd_stats (UINT8 controller_id)
+{
+    tHCI_CMD_STATS *p_stats;
+    UINT16         xx;
+    UINT32         *h;
+
+    if (controller_id >= BTU_MAX_LOCAL_CTRLS)
+        return;
+
+    HCI_TRACE_EVENT("BTU HCI(id=%d) command latency, buckets <1 <2 <4 ... <1024 >=1024 ms",
+                  controller_id);
+
+    for (xx = 0; xx < BTU_CMD_STATS_SIZE; xx++)
+    {
+        p_stats = &btu_cb.hci_cmd_cb[controller_id].stats[xx];
+        if (p_stats->opcode == HCI_COMMAND_NONE)
+            continue;
+
+        h = p_stats->lat_hist;
+        HCI_TRACE_EVENT("  0x%04x n=%u tout=%u avg=%uus max=%uus [%u %u %u %u %u %u %u %u %u %u %u %u]",
+                      p_stats->opcode, p_stats->count, p_stats->timeouts,
+                      (UINT32)(p_stats->total_us / p_stats->count), p_stats->max_us,
+                      h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7], h[8], h[9], h[10], h[11]);
+    }
+}
+#endif
+
 /*******************************************************************************
 **
 ** Function         btu_hcif_enhanced_flush_complete_evt
@@ -102,7 +102,7 @@ void BTE_Init(void)
     btu_cb.trace_level = HCI_INITIAL_TRACE_LEVEL;
 
     for ( i = 0; i < BTU_MAX_LOCAL_CTRLS; i++ ) /* include BR/EDR */
-        btu_cb.hci_cmd_cb[i].cmd_window = 1;
+        btu_hcif_init_cmd_cb((UINT8)i);
 }
 
 
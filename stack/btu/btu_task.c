@@ -631,6 +631,11 @@ BTU_API UINT32 btu_task (UINT32 param)
             break;
     }
 
+#if (defined(BTU_CMD_STATS_INCLUDED) && BTU_CMD_STATS_INCLUDED == TRUE)
+    /* the stats are only updated by this task, trace them once it has stopped */
+    btu_hcif_dump_cmd_stats(LOCAL_BR_EDR_CONTROLLER_ID);
+#endif
+
     return(0);
 }
 
@@ -845,6 +850,12 @@ void process_quick_timer_evt(TIMER_LIST_Q *p_tlq)
                 l2c_process_timeout (p_tle);
                 break;
 
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+            case BTU_TTYPE_SDP:             /* search answered from the SDP cache */
+                sdp_cache_search_cmpl ((tCONN_CB *)p_tle->param);
+                break;
+#endif
+
             default:
                 break;
         }
@@ -919,7 +930,7 @@ void btu_stop_timer_oneshot(TIMER_LIST_ENT *p_tle) {
 *******************************************************************************/
 void btu_check_bt_sleep (void)
 {
-    if ((btu_cb.hci_cmd_cb[LOCAL_BR_EDR_CONTROLLER_ID].cmd_cmpl_q.count == 0)
+    if ((btu_cb.hci_cmd_cb[LOCAL_BR_EDR_CONTROLLER_ID].pend_count == 0)
         &&(btu_cb.hci_cmd_cb[LOCAL_BR_EDR_CONTROLLER_ID].cmd_xmit_q.count == 0))
     {
         if (l2cb.controller_xmit_window == l2cb.num_lm_acl_bufs)
@@ -194,12 +194,13 @@ BT_HDR *attp_build_read_by_type_value_cmd (UINT16 payload_size, tGATT_FIND_TYPE_
 **
 ** Function         attp_build_read_multi_cmd
 **
-** Description      Build a read multiple request
+** Description      Build a read multiple or read multiple variable length
+**                  request
 **
 ** Returns          None.
 **
 *******************************************************************************/
-BT_HDR *attp_build_read_multi_cmd(UINT16 payload_size, UINT16 num_handle, UINT16 *p_handle)
+BT_HDR *attp_build_read_multi_cmd(UINT8 op_code, UINT16 payload_size, UINT16 num_handle, UINT16 *p_handle)
 {
     BT_HDR      *p_buf = NULL;
     UINT8       *p, i = 0;
@@ -211,7 +212,7 @@ BT_HDR *attp_build_read_multi_cmd(UINT16 payload_size, UINT16 num_handle, UINT16
         p_buf->offset = L2CAP_MIN_OFFSET;
         p_buf->len = 1;
 
-        UINT8_TO_STREAM (p, GATT_REQ_READ_MULTI);
+        UINT8_TO_STREAM (p, op_code);
 
         for (i = 0; i < num_handle && p_buf->len + 2 <= payload_size; i ++)
         {
@@ -611,7 +612,7 @@ tGATT_STATUS attp_send_cl_msg (tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 op_code,
             break;
 
         case GATT_REQ_READ_MULTI:
-            p_cmd = attp_build_read_multi_cmd(p_tcb->payload_size,
+            p_cmd = attp_build_read_multi_cmd(op_code, p_tcb->payload_size,
                                               p_msg->read_multi.num_handles,
                                               p_msg->read_multi.handles);
             break;
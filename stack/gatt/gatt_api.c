@@ -705,6 +705,100 @@ tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
     return cmd_sent;
 }
 
+/*******************************************************************************
+**
+** Function         GATTS_HandleValueNotifyMulti
+**
+** Description      This function sends one handle value notification to a set
+**                  of clients. The PDU is built once; each link gets a copy
+**                  truncated to its own MTU. Links already congested are
+**                  skipped so that a slow client does not hold L2CAP buffers
+**                  needed by the others.
+**
+** Parameter        num_conn: number of connections in p_conn_id.
+**                  p_conn_id: connection identifiers.
+**                  attr_handle: Attribute handle of this handle value notification.
+**                  val_len: Length of the notified attribute value.
+**                  p_val: Pointer to the notified attribute value data.
+**                  p_status: output, per connection result.
+**
+** Returns          GATT_SUCCESS if sent to at least one link; otherwise error code.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_HandleValueNotifyMulti (UINT8 num_conn, UINT16 *p_conn_id,
+                                           UINT16 attr_handle, UINT16 val_len,
+                                           UINT8 *p_val, tGATT_STATUS *p_status)
+{
+    tGATT_STATUS    cmd_sent = GATT_ILLEGAL_PARAMETER;
+    BT_HDR          *p_pdu, *p_buf;
+    tGATT_TCB       *p_tcb;
+    UINT16          pdu_len;
+    UINT8           i;
+
+    GATT_TRACE_API ("GATTS_HandleValueNotifyMulti num_conn=%d handle=0x%04x", num_conn, attr_handle);
+
+    if (num_conn == 0 || p_conn_id == NULL || p_status == NULL ||
+        !GATT_HANDLE_IS_VALID (attr_handle) || val_len > GATT_MAX_ATTR_LEN)
+    {
+        return cmd_sent;
+    }
+
+    /* opcode and handle in front of the full value; links with a smaller MTU
+    ** take a truncated copy */
+    if ((p_pdu = attp_build_value_cmd ((UINT16)(val_len + 3), GATT_HANDLE_VALUE_NOTIF,
+                                       attr_handle, 0, val_len, p_val)) == NULL)
+    {
+        for (i = 0; i < num_conn; i ++)
+            p_status[i] = GATT_NO_RESOURCES;
+        return GATT_NO_RESOURCES;
+    }
+
+    for (i = 0; i < num_conn; i ++)
+    {
+        p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(p_conn_id[i]));
+
+        if (gatt_get_regcb(GATT_GET_GATT_IF(p_conn_id[i])) == NULL || p_tcb == NULL)
+        {
+            GATT_TRACE_ERROR ("GATTS_HandleValueNotifyMulti Unknown  conn_id: %u ", p_conn_id[i]);
+            p_status[i] = GATT_ILLEGAL_PARAMETER;
+            continue;
+        }
+
+        if (p_tcb->congested)
+        {
+            p_status[i] = GATT_BUSY;
+            continue;
+        }
+
+        pdu_len = (p_pdu->len < p_tcb->payload_size) ? p_pdu->len : p_tcb->payload_size;
+
+        if ((p_buf = (BT_HDR *)GKI_getbuf((UINT16)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + pdu_len))) == NULL)
+        {
+            p_status[i] = GATT_NO_RESOURCES;
+            continue;
+        }
+
+        p_buf->offset = L2CAP_MIN_OFFSET;
+        p_buf->len = pdu_len;
+        memcpy((UINT8 *)(p_buf + 1) + L2CAP_MIN_OFFSET,
+               (UINT8 *)(p_pdu + 1) + p_pdu->offset, pdu_len);
+
+        p_status[i] = attp_send_sr_msg (p_tcb, p_buf);
+
+        if (p_status[i] == GATT_CONGESTED)
+            p_tcb->congested = TRUE;
+
+        if (p_status[i] == GATT_SUCCESS || p_status[i] == GATT_CONGESTED)
+            cmd_sent = GATT_SUCCESS;
+        else if (cmd_sent != GATT_SUCCESS)
+            cmd_sent = p_status[i];
+    }
+
+    GKI_freebuf(p_pdu);
+
+    return cmd_sent;
+}
+
 /*******************************************************************************
 **
 ** Function         GATTS_SendRsp
@@ -1105,6 +1199,63 @@ tGATT_STATUS GATTC_ExecuteWrite (UINT16 conn_id, BOOLEAN is_execute)
     return status;
 }
 
+/*******************************************************************************
+**
+** Function         GATTC_WriteStream
+**
+** Description      This function is called to stream a large buffer to one
+**                  attribute as a series of MTU-sized Write Commands.
+**
+** Parameters       conn_id: connection identifier.
+**                  handle: attribute handle to write.
+**                  len: number of bytes in p_data.
+**                  p_data: data to send; must stay valid until p_cback is called.
+**                  p_cback: called once when the stream ends, possibly from
+**                           within this function.
+**
+** Returns          GATT_SUCCESS if the stream started successfully.
+**
+*******************************************************************************/
+tGATT_STATUS GATTC_WriteStream (UINT16 conn_id, UINT16 handle, UINT32 len,
+                                UINT8 *p_data, tGATT_STREAM_CMPL_CBACK *p_cback)
+{
+    tGATT_IF        gatt_if=GATT_GET_GATT_IF(conn_id);
+    UINT8           tcb_idx = GATT_GET_TCB_IDX(conn_id);
+    tGATT_TCB       *p_tcb = gatt_get_tcb_by_idx(tcb_idx);
+    tGATT_REG       *p_reg = gatt_get_regcb(gatt_if);
+    tGATT_WRITE_STREAM *p_strm;
+
+    GATT_TRACE_API ("GATTC_WriteStream conn_id=%d handle=0x%04x len=%u", conn_id, handle, len);
+
+    if ( (p_tcb == NULL) || (p_reg==NULL) || (p_data == NULL) || (len == 0) ||
+         (p_cback == NULL) || (handle == 0) || (gatt_get_ch_state(p_tcb) != GATT_CH_OPEN) )
+    {
+        GATT_TRACE_ERROR("GATTC_WriteStream Illegal param: conn_id %d", conn_id);
+        return GATT_ILLEGAL_PARAMETER;
+    }
+
+    p_strm = &p_tcb->wr_stream;
+    if (p_strm->in_use)
+    {
+        GATT_TRACE_ERROR("GATTC_WriteStream GATT_BUSY conn_id = %d", conn_id);
+        return GATT_BUSY;
+    }
+
+    memset(p_strm, 0, sizeof(tGATT_WRITE_STREAM));
+    p_strm->p_data     = p_data;
+    p_strm->len        = len;
+    p_strm->conn_id    = conn_id;
+    p_strm->handle     = handle;
+    p_strm->p_cback    = p_cback;
+    p_strm->start_tick = GKI_get_os_tick_count();
+    p_strm->in_use     = TRUE;
+
+    /* may end the stream, and call p_cback, before returning */
+    gatt_cl_stream_pump(p_tcb);
+
+    return GATT_SUCCESS;
+}
+
 /*******************************************************************************
 **
 ** Function         GATTC_SendHandleValueConfirm
@@ -41,6 +41,7 @@
 #define GATT_INFO_RSP_MIN_LEN   1
 #define GATT_MTU_RSP_MIN_LEN    2
 #define GATT_READ_BY_TYPE_RSP_MIN_LEN    1
+#define GATT_READ_MULTI_VAR_LEN_SIZE     2 /* length prefix of each value */
 
 /********************************************************************************
 **                       G L O B A L      G A T T       D A T A                 *
@@ -400,6 +401,35 @@ void gatt_send_prepare_write(tGATT_TCB  *p_tcb, tGATT_CLCB *p_clcb)
 }
 
 
+/*******************************************************************************
+**
+** Function         gatt_cl_deliver_disc_res
+**
+** Description      Hand a run of parsed discovery results to the application,
+**                  in one call if it registered a batch callback.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_cl_deliver_disc_res(tGATT_CLCB *p_clcb, UINT16 num_res, tGATT_DISC_RES *p_res)
+{
+    tGATT_CBACK     *p_cb = &p_clcb->p_reg->app_cb;
+    UINT16          i;
+
+    if (num_res == 0)
+        return;
+
+    if (p_cb->p_disc_res_batch_cb)
+    {
+        (*p_cb->p_disc_res_batch_cb)(p_clcb->conn_id, p_clcb->op_subtype, num_res, p_res);
+    }
+    else if (p_cb->p_disc_res_cb)
+    {
+        for (i = 0; i < num_res; i ++)
+            (*p_cb->p_disc_res_cb)(p_clcb->conn_id, p_clcb->op_subtype, &p_res[i]);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_process_find_type_value_rsp
@@ -412,7 +442,8 @@ void gatt_send_prepare_write(tGATT_TCB  *p_tcb, tGATT_CLCB *p_clcb)
 *******************************************************************************/
 void gatt_process_find_type_value_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT16 len, UINT8 *p_data)
 {
-    tGATT_DISC_RES      result;
+    tGATT_DISC_RES      result[GATT_DISC_RES_BATCH_MAX], *p_res;
+    UINT16              num_res = 0, e_handle = 0;
     UINT8               *p = p_data;
 
     UNUSED(p_tcb);
@@ -422,25 +453,31 @@ void gatt_process_find_type_value_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UIN
     if (p_clcb->operation != GATTC_OPTYPE_DISCOVERY || p_clcb->op_subtype != GATT_DISC_SRVC_BY_UUID)
         return;
 
-    memset (&result, 0, sizeof(tGATT_DISC_RES));
-    result.type.len = 2;
-    result.type.uu.uuid16 = GATT_UUID_PRI_SERVICE;
-
     /* returns a series of handle ranges */
     while (len >= 4)
     {
-        STREAM_TO_UINT16 (result.handle, p);
-        STREAM_TO_UINT16 (result.value.group_value.e_handle, p);
-        memcpy (&result.value.group_value.service_type,  &p_clcb->uuid, sizeof(tBT_UUID));
+        p_res = &result[num_res];
+        memset (p_res, 0, sizeof(tGATT_DISC_RES));
+        p_res->type.len = 2;
+        p_res->type.uu.uuid16 = GATT_UUID_PRI_SERVICE;
+
+        STREAM_TO_UINT16 (p_res->handle, p);
+        STREAM_TO_UINT16 (e_handle, p);
+        p_res->value.group_value.e_handle = e_handle;
+        memcpy (&p_res->value.group_value.service_type,  &p_clcb->uuid, sizeof(tBT_UUID));
 
         len -= 4;
 
-        if (p_clcb->p_reg->app_cb.p_disc_res_cb)
-            (*p_clcb->p_reg->app_cb.p_disc_res_cb)(p_clcb->conn_id, p_clcb->op_subtype, &result);
+        if (++num_res == GATT_DISC_RES_BATCH_MAX)
+        {
+            gatt_cl_deliver_disc_res(p_clcb, num_res, result);
+            num_res = 0;
+        }
     }
+    gatt_cl_deliver_disc_res(p_clcb, num_res, result);
 
     /* last handle  + 1 */
-    p_clcb->s_handle = (result.value.group_value.e_handle == 0) ? 0 : (result.value.group_value.e_handle + 1);
+    p_clcb->s_handle = (e_handle == 0) ? 0 : (e_handle + 1);
     /* initiate another request */
     gatt_act_discovery(p_clcb) ;
 }
@@ -458,7 +495,8 @@ void gatt_process_find_type_value_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UIN
 void gatt_process_read_info_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8 op_code,
                                 UINT16 len, UINT8 *p_data)
 {
-    tGATT_DISC_RES  result;
+    tGATT_DISC_RES  result[GATT_DISC_RES_BATCH_MAX], *p_res;
+    UINT16  num_res = 0, handle = 0;
     UINT8   *p = p_data, uuid_len = 0, type;
 
     UNUSED(p_tcb);
@@ -484,23 +522,29 @@ void gatt_process_read_info_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8 op_c
 
     while (len >= uuid_len + 2)
     {
-        STREAM_TO_UINT16 (result.handle, p);
+        p_res = &result[num_res];
+        STREAM_TO_UINT16 (handle, p);
+        p_res->handle = handle;
 
         if (uuid_len > 0)
         {
-            if (!gatt_parse_uuid_from_cmd(&result.type, uuid_len, &p))
+            if (!gatt_parse_uuid_from_cmd(&p_res->type, uuid_len, &p))
                 break;
         }
         else
-            memcpy (&result.type, &p_clcb->uuid, sizeof(tBT_UUID));
+            memcpy (&p_res->type, &p_clcb->uuid, sizeof(tBT_UUID));
 
         len -= (uuid_len + 2);
 
-        if (p_clcb->p_reg->app_cb.p_disc_res_cb)
-            (*p_clcb->p_reg->app_cb.p_disc_res_cb)(p_clcb->conn_id, p_clcb->op_subtype, &result);
+        if (++num_res == GATT_DISC_RES_BATCH_MAX)
+        {
+            gatt_cl_deliver_disc_res(p_clcb, num_res, result);
+            num_res = 0;
+        }
     }
+    gatt_cl_deliver_disc_res(p_clcb, num_res, result);
 
-    p_clcb->s_handle = (result.handle == 0) ? 0 :(result.handle + 1);
+    p_clcb->s_handle = (handle == 0) ? 0 :(handle + 1);
     /* initiate another request */
     gatt_act_discovery(p_clcb) ;
 }
@@ -744,13 +788,15 @@ void gatt_process_notification(tGATT_TCB *p_tcb, UINT8 op_code,
 void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8 op_code,
                                     UINT16 len, UINT8 *p_data)
 {
-    tGATT_DISC_RES      result;
-    tGATT_DISC_VALUE    record_value;
+    tGATT_DISC_RES      result[GATT_DISC_RES_BATCH_MAX], *p_res;
+    tGATT_DISC_VALUE    *p_value;
     UINT8               *p = p_data, value_len, handle_len = 2;
-    UINT16              handle = 0;
+    UINT16              handle = 0, num_res = 0;
 
     /* discovery procedure and no callback function registered */
-    if (((!p_clcb->p_reg) || (!p_clcb->p_reg->app_cb.p_disc_res_cb)) && (p_clcb->operation == GATTC_OPTYPE_DISCOVERY))
+    if (((!p_clcb->p_reg) ||
+         (!p_clcb->p_reg->app_cb.p_disc_res_cb && !p_clcb->p_reg->app_cb.p_disc_res_batch_cb)) &&
+        (p_clcb->operation == GATTC_OPTYPE_DISCOVERY))
         return;
 
     if (len < GATT_READ_BY_TYPE_RSP_MIN_LEN)
@@ -778,22 +824,26 @@ void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8
     value_len -= handle_len; /* substract the handle pairs bytes */
     len -= 1;
 
+    /* results parsed so far are handed over before the procedure ends or
+       pauses on one of the early returns below */
     while (len >= (handle_len + value_len))
     {
         STREAM_TO_UINT16(handle, p);
 
         if (!GATT_HANDLE_IS_VALID(handle))
         {
+            gatt_cl_deliver_disc_res(p_clcb, num_res, result);
             gatt_end_operation(p_clcb, GATT_INVALID_HANDLE, NULL);
             return;
         }
 
-        memset(&result, 0, sizeof(tGATT_DISC_RES));
-        memset(&record_value, 0, sizeof(tGATT_DISC_VALUE));
+        p_res = &result[num_res];
+        p_value = &p_res->value;
+        memset(p_res, 0, sizeof(tGATT_DISC_RES));
 
-        result.handle = handle;
-        result.type.len = 2;
-        result.type.uu.uuid16 = disc_type_to_uuid[p_clcb->op_subtype];
+        p_res->handle = handle;
+        p_res->type.len = 2;
+        p_res->type.uu.uuid16 = disc_type_to_uuid[p_clcb->op_subtype];
 
         /* discover all services */
         if (p_clcb->operation == GATTC_OPTYPE_DISCOVERY &&
@@ -804,13 +854,14 @@ void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8
 
             if (!GATT_HANDLE_IS_VALID(handle))
             {
+                gatt_cl_deliver_disc_res(p_clcb, num_res, result);
                 gatt_end_operation(p_clcb, GATT_INVALID_HANDLE, NULL);
                 return;
             }
             else
             {
-                record_value.group_value.e_handle = handle;
-                if (!gatt_parse_uuid_from_cmd(&record_value.group_value.service_type, value_len, &p))
+                p_value->group_value.e_handle = handle;
+                if (!gatt_parse_uuid_from_cmd(&p_value->group_value.service_type, value_len, &p))
                 {
                     GATT_TRACE_ERROR("discover all service response parsing failure");
                     break;
@@ -820,21 +871,22 @@ void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8
         /* discover included service */
         else if (p_clcb->operation == GATTC_OPTYPE_DISCOVERY && p_clcb->op_subtype == GATT_DISC_INC_SRVC)
         {
-            STREAM_TO_UINT16(record_value.incl_service.s_handle, p);
-            STREAM_TO_UINT16(record_value.incl_service.e_handle, p);
+            STREAM_TO_UINT16(p_value->incl_service.s_handle, p);
+            STREAM_TO_UINT16(p_value->incl_service.e_handle, p);
 
             if(value_len == 6)
             {
-                STREAM_TO_UINT16(record_value.incl_service.service_type.uu.uuid16, p);
-                record_value.incl_service.service_type.len = LEN_UUID_16;
+                STREAM_TO_UINT16(p_value->incl_service.service_type.uu.uuid16, p);
+                p_value->incl_service.service_type.len = LEN_UUID_16;
             }
             else if (value_len == 4)
             {
-                p_clcb->s_handle = record_value.incl_service.s_handle;
+                gatt_cl_deliver_disc_res(p_clcb, num_res, result);
+
+                p_clcb->s_handle = p_value->incl_service.s_handle;
                 p_clcb->read_uuid128.wait_for_read_rsp = TRUE;
                 p_clcb->read_uuid128.next_disc_start_hdl = handle + 1;
-                memcpy(&p_clcb->read_uuid128.result, &result, sizeof(result));
-                memcpy(&p_clcb->read_uuid128.result.value, &record_value, sizeof (result.value));
+                memcpy(&p_clcb->read_uuid128.result, p_res, sizeof(tGATT_DISC_RES));
                 p_clcb->op_subtype |= 0x90;
                 gatt_act_read(p_clcb, 0);
                 return;
@@ -842,6 +894,7 @@ void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8
             else
             {
                GATT_TRACE_ERROR("gatt_process_read_by_type_rsp INCL_SRVC failed with invalid data value_len=%d", value_len);
+               gatt_cl_deliver_disc_res(p_clcb, num_res, result);
                gatt_end_operation(p_clcb, GATT_INVALID_PDU, (void *)p);
                return;
             }
@@ -872,22 +925,24 @@ void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8
         }
         else /* discover characterisitic */
         {
-            STREAM_TO_UINT8 (record_value.dclr_value.char_prop, p);
-            STREAM_TO_UINT16(record_value.dclr_value.val_handle, p);
-            if (!GATT_HANDLE_IS_VALID(record_value.dclr_value.val_handle))
+            STREAM_TO_UINT8 (p_value->dclr_value.char_prop, p);
+            STREAM_TO_UINT16(p_value->dclr_value.val_handle, p);
+            if (!GATT_HANDLE_IS_VALID(p_value->dclr_value.val_handle))
             {
+                gatt_cl_deliver_disc_res(p_clcb, num_res, result);
                 gatt_end_operation(p_clcb, GATT_INVALID_HANDLE, NULL);
                 return;
             }
-            if (!gatt_parse_uuid_from_cmd(&record_value.dclr_value.char_uuid, (UINT16)(value_len - 3), &p))
+            if (!gatt_parse_uuid_from_cmd(&p_value->dclr_value.char_uuid, (UINT16)(value_len - 3), &p))
             {
+                gatt_cl_deliver_disc_res(p_clcb, num_res, result);
                 gatt_end_operation(p_clcb, GATT_SUCCESS, NULL);
                 /* invalid format, and skip the result */
                 return;
             }
 
             /* UUID not matching */
-            if (!gatt_uuid_compare(record_value.dclr_value.char_uuid, p_clcb->uuid))
+            if (!gatt_uuid_compare(p_value->dclr_value.char_uuid, p_clcb->uuid))
             {
                 len -= (value_len + 2);
                 continue; /* skip the result, and look for next one */
@@ -897,7 +952,7 @@ void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8
             {
                 /* only read the first matching UUID characteristic value, and
                   discard the rest results */
-                p_clcb->s_handle = record_value.dclr_value.val_handle;
+                p_clcb->s_handle = p_value->dclr_value.val_handle;
                 p_clcb->op_subtype |= 0x80;
                 gatt_act_read(p_clcb, 0);
                 return;
@@ -905,13 +960,15 @@ void gatt_process_read_by_type_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8
         }
         len -= (value_len + handle_len);
 
-        /* result is (handle, 16bits UUID) pairs */
-        memcpy (&result.value, &record_value, sizeof (result.value));
-
-        /* send callback if is discover procedure */
-        if (p_clcb->operation == GATTC_OPTYPE_DISCOVERY && p_clcb->p_reg->app_cb.p_disc_res_cb)
-            (*p_clcb->p_reg->app_cb.p_disc_res_cb)(p_clcb->conn_id, p_clcb->op_subtype, &result);
+        /* keep the result if this is a discover procedure */
+        if (p_clcb->operation == GATTC_OPTYPE_DISCOVERY &&
+            ++num_res == GATT_DISC_RES_BATCH_MAX)
+        {
+            gatt_cl_deliver_disc_res(p_clcb, num_res, result);
+            num_res = 0;
+        }
     }
+    gatt_cl_deliver_disc_res(p_clcb, num_res, result);
 
     p_clcb->s_handle = (handle == 0) ? 0 : (handle + 1);
 
@@ -1002,8 +1059,7 @@ void gatt_process_read_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb,  UINT8 op_code,
 
                 memcpy(p_clcb->read_uuid128.result.value.incl_service.service_type.uu.uuid128, p, len);
                 p_clcb->read_uuid128.result.value.incl_service.service_type.len = LEN_UUID_128;
-                if ( p_clcb->p_reg->app_cb.p_disc_res_cb)
-                    (*p_clcb->p_reg->app_cb.p_disc_res_cb)(p_clcb->conn_id, p_clcb->op_subtype, &p_clcb->read_uuid128.result);
+                gatt_cl_deliver_disc_res(p_clcb, 1, &p_clcb->read_uuid128.result);
                 gatt_act_discovery(p_clcb) ;
             }
             else
@@ -1016,6 +1072,103 @@ void gatt_process_read_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb,  UINT8 op_code,
 }
 
 
+/*******************************************************************************
+**
+** Function         gatt_cl_retry_single_read
+**
+** Description      Re-issue a read that was folded into a Read Multiple
+**                  Variable Length request as a plain Read Request.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_cl_retry_single_read(tGATT_CLCB *p_clcb)
+{
+    p_clcb->no_coalesce = TRUE;
+    p_clcb->counter = 0;
+
+    /* gatt_act_read cleared the value-handle flag when the read was first queued */
+    if (p_clcb->op_subtype == GATT_READ_CHAR_VALUE)
+        p_clcb->op_subtype = GATT_READ_CHAR_VALUE_HDL;
+
+    gatt_act_read(p_clcb, 0);
+}
+
+/*******************************************************************************
+**
+** Function         gatt_process_read_multi_var_rsp
+**
+** Description      Split a Read Multiple Variable Length response (or the
+**                  error answering it) back to the reads it was built from.
+**                  A value that is missing or truncated by the MTU is read
+**                  again on its own.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_process_read_multi_var_rsp(tGATT_TCB *p_tcb, UINT8 op_code, UINT16 len,
+                                            UINT8 *p_data, UINT8 num_clcb, UINT16 *p_clcb_idx)
+{
+    tGATT_CLCB  *p_clcb;
+    UINT8       *p = p_data, i, served = 0, reason;
+    UINT16      attr_len = 0;
+    BOOLEAN     complete;
+
+    if (op_code != GATT_RSP_READ_MULTI_VAR || len >= p_tcb->payload_size)
+    {
+        if (op_code == GATT_RSP_ERROR && len >= 4)
+        {
+            p += 3;
+            STREAM_TO_UINT8(reason, p);
+
+            /* the peer does not know the opcode, stop merging reads on this link */
+            if (reason == GATT_REQ_NOT_SUPPORTED)
+                p_tcb->no_read_multi_var = TRUE;
+        }
+        GATT_TRACE_DEBUG("gatt_process_read_multi_var_rsp: op_code=0x%x, read %d handles singly",
+                          op_code, num_clcb);
+        len = 0;
+    }
+
+    for (i = 0; i < num_clcb; i ++)
+    {
+        p_clcb = &gatt_cb.clcb[p_clcb_idx[i]];
+        complete = FALSE;
+
+        if (len >= GATT_READ_MULTI_VAR_LEN_SIZE)
+        {
+            STREAM_TO_UINT16(attr_len, p);
+            len -= GATT_READ_MULTI_VAR_LEN_SIZE;
+            complete = (attr_len <= len);
+        }
+
+        if (p_clcb->in_use && p_clcb->p_tcb == p_tcb)
+        {
+            if (complete)
+            {
+                gatt_process_read_rsp(p_tcb, p_clcb, GATT_RSP_READ, attr_len, p);
+                served ++;
+            }
+            else
+                gatt_cl_retry_single_read(p_clcb);
+        }
+
+        if (complete)
+        {
+            p += attr_len;
+            len -= attr_len;
+        }
+        else /* nothing after a truncated value can be used */
+            len = 0;
+    }
+
+    if (served > 1)
+        p_tcb->cl_rtt_saved += served - 1;
+
+    GATT_TRACE_DEBUG("gatt_process_read_multi_var_rsp: %d of %d reads served, %d round trips saved on link",
+                      served, num_clcb, p_tcb->cl_rtt_saved);
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_process_handle_rsp
@@ -1080,6 +1233,92 @@ UINT8 gatt_cmd_to_rsp_code (UINT8 cmd_code)
     }
     return rsp_code;
 }
+/*******************************************************************************
+**
+** Function         gatt_cl_read_mergeable
+**
+** Description      Check whether a queued command is a plain single-handle
+**                  read that a Read Multiple Variable Length request can
+**                  answer.
+**
+** Returns          TRUE if the command can be merged.
+**
+*******************************************************************************/
+static BOOLEAN gatt_cl_read_mergeable(tGATT_TCB *p_tcb, tGATT_CMD_Q *p_cmd)
+{
+    tGATT_CLCB  *p_clcb = &gatt_cb.clcb[p_cmd->clcb_idx];
+
+    return (p_cmd->to_send && p_cmd->p_cmd != NULL &&
+            p_cmd->op_code == GATT_REQ_READ &&
+            p_clcb->in_use && p_clcb->p_tcb == p_tcb &&
+            !p_clcb->no_coalesce && p_clcb->counter == 0 &&
+            p_clcb->operation == GATTC_OPTYPE_READ &&
+            (p_clcb->op_subtype == GATT_READ_BY_HANDLE ||
+             p_clcb->op_subtype == GATT_READ_CHAR_VALUE));
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_coalesce_reads
+**
+** Description      Fold the single-handle reads queued at the head of the
+**                  command queue, from any application, into one Read
+**                  Multiple Variable Length request. The folded slots stay
+**                  queued without a PDU so the response can be routed back
+**                  to each requester.
+**
+**                  Plain Read Multiple is not used: its response carries no
+**                  lengths and cannot be split per requester.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_cl_coalesce_reads(tGATT_TCB *p_tcb)
+{
+    tGATT_CMD_Q *p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+    tGATT_CMD_Q *p_next;
+    UINT16      handles[GATT_MAX_READ_MULTI_HANDLES];
+    UINT8       num = 0, idx = p_tcb->pending_cl_req;
+    BT_HDR      *p_buf;
+
+    /* a server that does not know the opcode answers Request Not Supported,
+       which turns merging off for the link */
+    if (p_tcb->no_read_multi_var || p_tcb->transport != BT_TRANSPORT_LE)
+        return;
+
+    while (idx != p_tcb->next_slot_inq &&
+           num < GATT_MAX_READ_MULTI_HANDLES &&
+           1 + (num + 1) * 2 <= p_tcb->payload_size &&
+           gatt_cl_read_mergeable(p_tcb, &p_tcb->cl_cmd_q[idx]))
+    {
+        handles[num ++] = gatt_cb.clcb[p_tcb->cl_cmd_q[idx].clcb_idx].s_handle;
+        idx = (idx + 1) % GATT_CL_MAX_LCB;
+    }
+
+    if (num < 2)
+        return;
+
+    if ((p_buf = attp_build_read_multi_cmd(GATT_REQ_READ_MULTI_VAR, p_tcb->payload_size,
+                                           num, handles)) == NULL)
+        return;
+
+    GKI_freebuf(p_cmd->p_cmd);
+    p_cmd->p_cmd      = p_buf;
+    p_cmd->op_code    = GATT_REQ_READ_MULTI_VAR;
+    p_cmd->num_merged = num - 1;
+
+    for (idx = (p_tcb->pending_cl_req + 1) % GATT_CL_MAX_LCB; -- num > 0;
+         idx = (idx + 1) % GATT_CL_MAX_LCB)
+    {
+        p_next = &p_tcb->cl_cmd_q[idx];
+        GKI_freebuf(p_next->p_cmd);
+        p_next->p_cmd = NULL;
+        p_next->to_send = FALSE;
+    }
+
+    GATT_TRACE_DEBUG("gatt_cl_coalesce_reads: %d reads in one request", p_cmd->num_merged + 1);
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_cl_send_next_cmd_inq
@@ -1101,6 +1340,8 @@ BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb)
            p_tcb->pending_cl_req != p_tcb->next_slot_inq &&
            p_cmd->to_send && p_cmd->p_cmd != NULL)
     {
+        gatt_cl_coalesce_reads(p_tcb);
+
         att_ret = attp_send_msg_to_l2cap(p_tcb, p_cmd->p_cmd);
 
         if (att_ret == GATT_SUCCESS || att_ret == GATT_CONGESTED)
@@ -1129,10 +1370,18 @@ BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb)
         }
         else
         {
+            UINT8 num_merged = p_cmd->num_merged;
+
             GATT_TRACE_ERROR("gatt_cl_send_next_cmd_inq: L2CAP sent error");
 
+            p_tcb->pending_cl_req = (p_tcb->pending_cl_req + 1) % GATT_CL_MAX_LCB;
             memset(p_cmd, 0, sizeof(tGATT_CMD_Q));
-            p_tcb->pending_cl_req ++;
+
+            /* the reads folded into this request will not be answered either */
+            while (num_merged -- > 0 &&
+                   (p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code)) != NULL)
+                gatt_end_operation(p_clcb, GATT_ERROR, NULL);
+
             p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
         }
 
@@ -1140,6 +1389,102 @@ BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb)
     return sent;
 }
 
+/*******************************************************************************
+**
+** Function         gatt_cl_stream_end
+**
+** Description      Finish the Write Command stream on this connection and
+**                  report it to the application that started it.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_cl_stream_end(tGATT_TCB *p_tcb, tGATT_STATUS status)
+{
+    tGATT_WRITE_STREAM  *p_strm = &p_tcb->wr_stream;
+    tGATT_STREAM_CMPL_CBACK *p_cback = p_strm->p_cback;
+    tGATT_STREAM_STATS  stats = p_strm->stats;
+    tGATT_REG           *p_reg = gatt_get_regcb(GATT_GET_GATT_IF(p_strm->conn_id));
+    UINT16              conn_id = p_strm->conn_id, handle = p_strm->handle;
+
+    stats.duration_ms = GKI_TICKS_TO_MS(GKI_get_os_tick_count() - p_strm->start_tick);
+    p_strm->in_use = FALSE;
+
+    GATT_TRACE_DEBUG("gatt_cl_stream_end status=%d bytes=%u pkts=%u stalls=%u in %u ms (%u B/s)",
+                      status, stats.bytes, stats.num_pkts, stats.num_stalls, stats.duration_ms,
+                      stats.duration_ms ? stats.bytes * 1000 / stats.duration_ms : stats.bytes);
+
+    /* the application may have deregistered while the stream was running */
+    if (p_reg != NULL && p_cback != NULL)
+        (*p_cback)(conn_id, handle, status, &stats);
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_stream_pump
+**
+** Description      Hand Write Command segments of the active stream to L2CAP
+**                  until the stream is done or the channel congests. Called
+**                  again when L2CAP reports the channel uncongested.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_cl_stream_pump(tGATT_TCB *p_tcb)
+{
+    tGATT_WRITE_STREAM  *p_strm = &p_tcb->wr_stream;
+    tGATT_STATUS        att_ret;
+    BT_HDR              *p_buf;
+    UINT16              seg_len;
+
+    if (!p_strm->in_use)
+        return;
+
+    if (gatt_get_regcb(GATT_GET_GATT_IF(p_strm->conn_id)) == NULL)
+    {
+        GATT_TRACE_WARNING("gatt_cl_stream_pump: application gone, stream dropped");
+        p_strm->in_use = FALSE;
+        return;
+    }
+
+    while (p_strm->offset < p_strm->len && !p_tcb->congested)
+    {
+        /* opcode and handle take three bytes of every PDU */
+        seg_len = p_tcb->payload_size - 3;
+        if (seg_len > p_strm->len - p_strm->offset)
+            seg_len = (UINT16)(p_strm->len - p_strm->offset);
+
+        if ((p_buf = attp_build_value_cmd(p_tcb->payload_size, GATT_CMD_WRITE, p_strm->handle, 0,
+                                          seg_len, p_strm->p_data + p_strm->offset)) == NULL)
+        {
+            gatt_cl_stream_end(p_tcb, GATT_NO_RESOURCES);
+            return;
+        }
+
+        att_ret = attp_send_msg_to_l2cap(p_tcb, p_buf);
+        if (att_ret != GATT_SUCCESS && att_ret != GATT_CONGESTED)
+        {
+            GATT_TRACE_ERROR("gatt_cl_stream_pump: L2CAP sent error");
+            gatt_cl_stream_end(p_tcb, GATT_ERROR);
+            return;
+        }
+
+        p_strm->offset += seg_len;
+        p_strm->stats.bytes += seg_len;
+        p_strm->stats.num_pkts ++;
+
+        if (att_ret == GATT_CONGESTED)
+        {
+            p_tcb->congested = TRUE;
+            if (p_strm->offset < p_strm->len)
+                p_strm->stats.num_stalls ++;
+        }
+    }
+
+    if (p_strm->offset >= p_strm->len)
+        gatt_cl_stream_end(p_tcb, GATT_SUCCESS);
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_client_handle_server_rsp
@@ -1154,31 +1499,53 @@ BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb)
 void gatt_client_handle_server_rsp (tGATT_TCB *p_tcb, UINT8 op_code,
                                     UINT16 len, UINT8 *p_data)
 {
-    tGATT_CLCB   *p_clcb = NULL;
-    UINT8        rsp_code;
+    tGATT_CLCB   *p_clcb = NULL, *p_member;
+    UINT8        rsp_code, member_code, num_clcb = 0, i;
+    UINT16       clcb_idx[GATT_MAX_READ_MULTI_HANDLES];
 
     if (op_code != GATT_HANDLE_VALUE_IND && op_code != GATT_HANDLE_VALUE_NOTIF)
     {
-        p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code);
-
-        rsp_code = gatt_cmd_to_rsp_code(rsp_code);
-
-        if (p_clcb == NULL || (rsp_code != op_code && op_code != GATT_RSP_ERROR))
+        /* check the response against the pending request before dequeuing it,
+           so a wrong response leaves it, and the reads folded into it, pending
+           until the real response or the response timeout */
+        rsp_code = 0;
+        if (p_tcb->pending_cl_req != p_tcb->next_slot_inq)
+            rsp_code = gatt_cmd_to_rsp_code(p_tcb->cl_cmd_q[p_tcb->pending_cl_req].op_code);
+
+        if (p_tcb->pending_cl_req == p_tcb->next_slot_inq ||
+            (rsp_code != op_code && op_code != GATT_RSP_ERROR))
         {
             GATT_TRACE_WARNING ("ATT - Ignore wrong response. Receives (%02x) \
                                 Request(%02x) Ignored", op_code, rsp_code);
 
             return;
         }
-        else
+
+        num_clcb = p_tcb->cl_cmd_q[p_tcb->pending_cl_req].num_merged + 1;
+        p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code);
+        btu_stop_timer (&p_clcb->rsp_timer_ent);
+        p_clcb->retry_count = 0;
+
+        /* dequeue every read folded into this request before any is re-issued */
+        if (num_clcb > 1)
         {
-            btu_stop_timer (&p_clcb->rsp_timer_ent);
-            p_clcb->retry_count = 0;
+            clcb_idx[0] = p_clcb->clcb_idx;
+            for (i = 1; i < num_clcb; i ++)
+            {
+                if ((p_member = gatt_cmd_dequeue(p_tcb, &member_code)) == NULL)
+                    break;
+                clcb_idx[i] = p_member->clcb_idx;
+            }
+            num_clcb = i;
         }
     }
+    if (num_clcb > 1)
+    {
+        gatt_process_read_multi_var_rsp(p_tcb, op_code, len, p_data, num_clcb, clcb_idx);
+    }
     /* the size of the message may not be bigger than the local max PDU size*/
     /* The message has to be smaller than the agreed MTU, len does not count op_code */
-    if (len >= p_tcb->payload_size)
+    else if (len >= p_tcb->payload_size)
     {
         GATT_TRACE_ERROR("invalid response/indicate pkt size: %d, PDU size: %d", len + 1, p_tcb->payload_size);
         if (op_code != GATT_HANDLE_VALUE_NOTIF &&
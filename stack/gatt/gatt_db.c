@@ -42,6 +42,10 @@ static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db);
 static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PERM perm);
 static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr);
 static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 len);
+static void gatts_db_attr_uuid(tGATT_ATTR16 *p_attr, tBT_UUID *p_uuid);
+static UINT8 gatts_db_type_bucket(tBT_UUID *p_uuid);
+static void gatts_db_index_attr(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr);
+static void gatts_db_unindex_attr(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr);
 
 static BOOLEAN gatts_db_add_service_declaration(tGATT_SVC_DB *p_db, tBT_UUID *p_service, BOOLEAN is_pri);
 static tGATT_STATUS gatts_send_app_read_request(tGATT_TCB *p_tcb, UINT8 op_code,
@@ -62,6 +66,8 @@ static tGATT_STATUS gatts_send_app_read_request(tGATT_TCB *p_tcb, UINT8 op_code,
 BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN is_pri,
                                UINT16 s_hdl, UINT16 num_handle)
 {
+    UINT32  tbl_size = (UINT32)num_handle * sizeof(void *);
+
     if (!allocate_svc_db_buf(p_db))
     {
         GATT_TRACE_ERROR("gatts_init_service_db failed, no resources");
@@ -74,6 +80,20 @@ BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN
     /* update service database information */
     p_db->next_handle   = s_hdl;
     p_db->end_handle    = s_hdl + num_handle;
+    p_db->start_handle  = s_hdl;
+    memset(p_db->type_head, 0, sizeof(p_db->type_head));
+    memset(p_db->type_tail, 0, sizeof(p_db->type_tail));
+
+    /* handle lookup table; it lives on the service buffer queue so it is released
+    ** together with the attributes. Services too large for one buffer fall back
+    ** to walking the attribute list. */
+    p_db->p_attr_tbl = NULL;
+    if (tbl_size != 0 && tbl_size <= GKI_MAX_BUF_SIZE &&
+        (p_db->p_attr_tbl = (void **)GKI_getbuf((UINT16)tbl_size)) != NULL)
+    {
+        memset(p_db->p_attr_tbl, 0, tbl_size);
+        GKI_enqueue(&p_db->svc_buffer, p_db->p_attr_tbl);
+    }
 
     return gatts_db_add_service_declaration(p_db, p_service, is_pri);
 }
@@ -104,6 +124,185 @@ tBT_UUID * gatts_get_service_uuid (tGATT_SVC_DB *p_db)
     }
 }
 
+/*******************************************************************************
+**
+** Function         gatts_find_attr_by_handle
+**
+** Description      Locate an attribute of a service database by its handle.
+**
+** Parameter        p_db: database pointer.
+**                  handle: attribute handle.
+**
+** Returns          pointer to the attribute (tGATT_ATTR16/32/128), NULL if the
+**                  handle is not in use.
+**
+*******************************************************************************/
+void *gatts_find_attr_by_handle(tGATT_SVC_DB *p_db, UINT16 handle)
+{
+    tGATT_ATTR16    *p_attr;
+
+    if (!p_db || handle < p_db->start_handle || handle >= p_db->next_handle)
+        return NULL;
+
+    if (p_db->p_attr_tbl)
+        return p_db->p_attr_tbl[handle - p_db->start_handle];
+
+    p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
+
+    while (p_attr && p_attr->handle != handle)
+        p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+
+    return p_attr;
+}
+
+/*******************************************************************************
+**
+** Function         gatts_db_attr_uuid
+**
+** Description      Get the type of an attribute as a tBT_UUID.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatts_db_attr_uuid(tGATT_ATTR16 *p_attr, tBT_UUID *p_uuid)
+{
+    if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
+    {
+        p_uuid->len = LEN_UUID_16;
+        p_uuid->uu.uuid16 = p_attr->uuid;
+    }
+    else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
+    {
+        p_uuid->len = LEN_UUID_32;
+        p_uuid->uu.uuid32 = ((tGATT_ATTR32 *)p_attr)->uuid;
+    }
+    else
+    {
+        p_uuid->len = LEN_UUID_128;
+        memcpy(p_uuid->uu.uuid128, ((tGATT_ATTR128 *)p_attr)->uuid, LEN_UUID_128);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         gatts_db_type_bucket
+**
+** Description      Hash an attribute type into a type bucket. UUIDs derived
+**                  from the Bluetooth base UUID hash on their 32 bits value so
+**                  that the 16, 32 and 128 bits forms of a type share a bucket,
+**                  matching gatt_uuid_compare().
+**
+** Returns          bucket index.
+**
+*******************************************************************************/
+static UINT8 gatts_db_type_bucket(tBT_UUID *p_uuid)
+{
+    UINT8   base[LEN_UUID_128], *p;
+    UINT32  key = 0, word;
+    UINT8   i;
+
+    if (p_uuid->len == LEN_UUID_16)
+        key = p_uuid->uu.uuid16;
+    else if (p_uuid->len == LEN_UUID_32)
+        key = p_uuid->uu.uuid32;
+    else
+    {
+        gatt_convert_uuid32_to_uuid128(base, 0);
+
+        if (memcmp(p_uuid->uu.uuid128, base, LEN_UUID_128 - 4) == 0)
+        {
+            p = &p_uuid->uu.uuid128[LEN_UUID_128 - 4];
+            STREAM_TO_UINT32(key, p);
+        }
+        else
+        {
+            p = p_uuid->uu.uuid128;
+            for (i = 0; i < LEN_UUID_128 / 4; i ++)
+            {
+                STREAM_TO_UINT32(word, p);
+                key ^= word;
+            }
+        }
+    }
+
+    return (UINT8)(((key * 0x9E3779B1) >> 16) % GATT_DB_TYPE_HASH_SIZE);
+}
+
+/*******************************************************************************
+**
+** Function         gatts_db_index_attr
+**
+** Description      Add a newly allocated attribute to the handle table and to
+**                  the tail of its type bucket.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatts_db_index_attr(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr)
+{
+    tBT_UUID    uuid;
+    UINT8       bucket;
+
+    if (!p_db->p_attr_tbl)
+        return;
+
+    p_db->p_attr_tbl[p_attr->handle - p_db->start_handle] = p_attr;
+
+    gatts_db_attr_uuid(p_attr, &uuid);
+    bucket = gatts_db_type_bucket(&uuid);
+
+    if (p_db->type_tail[bucket] == 0)
+        p_db->type_head[bucket] = p_attr->handle;
+    else
+        ((tGATT_ATTR16 *)p_db->p_attr_tbl[p_db->type_tail[bucket] - p_db->start_handle])->type_next = p_attr->handle;
+
+    p_db->type_tail[bucket] = p_attr->handle;
+}
+
+/*******************************************************************************
+**
+** Function         gatts_db_unindex_attr
+**
+** Description      Remove the last allocated attribute from the handle table
+**                  and from its type bucket.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatts_db_unindex_attr(tGATT_SVC_DB *p_db, tGATT_ATTR16 *p_attr)
+{
+    tGATT_ATTR16    *p_prev;
+    tBT_UUID        uuid;
+    UINT8           bucket;
+    UINT16          handle;
+
+    if (!p_db->p_attr_tbl)
+        return;
+
+    p_db->p_attr_tbl[p_attr->handle - p_db->start_handle] = NULL;
+
+    gatts_db_attr_uuid(p_attr, &uuid);
+    bucket = gatts_db_type_bucket(&uuid);
+
+    if (p_db->type_head[bucket] == p_attr->handle)
+    {
+        p_db->type_head[bucket] = p_db->type_tail[bucket] = 0;
+        return;
+    }
+
+    for (handle = p_db->type_head[bucket]; handle != 0; handle = p_prev->type_next)
+    {
+        p_prev = (tGATT_ATTR16 *)p_db->p_attr_tbl[handle - p_db->start_handle];
+
+        if (p_prev->type_next == p_attr->handle)
+        {
+            p_prev->type_next = 0;
+            p_db->type_tail[bucket] = handle;
+            break;
+        }
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         gatts_check_attr_readability
@@ -341,31 +540,26 @@ tGATT_STATUS gatts_db_read_attr_value_by_type (tGATT_TCB   *p_tcb,
     UINT16      len = 0;
     UINT8       *p = (UINT8 *)(p_rsp + 1) + p_rsp->len + L2CAP_MIN_OFFSET;
     tBT_UUID    attr_uuid;
+    BOOLEAN     by_bucket;
 #if (defined(BLE_DELAY_REQUEST_ENC) && (BLE_DELAY_REQUEST_ENC == TRUE))
     UINT8       flag;
 #endif
 
     if (p_db && p_db->p_attr_list)
     {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
+        /* walk only the type bucket when the database is indexed; an unspecified
+        ** type matches every attribute and needs the full list */
+        by_bucket = (p_db->p_attr_tbl != NULL && type.len != 0);
+
+        if (by_bucket)
+            p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db,
+                                        p_db->type_head[gatts_db_type_bucket(&type)]);
+        else
+            p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
 
         while (p_attr && p_attr->handle <= e_handle)
         {
-            if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
-            {
-                attr_uuid.len = LEN_UUID_16;
-                attr_uuid.uu.uuid16 = p_attr->uuid;
-            }
-            else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
-            {
-                attr_uuid.len = LEN_UUID_32;
-                attr_uuid.uu.uuid32 = ((tGATT_ATTR32 *)p_attr)->uuid;
-            }
-            else
-            {
-                attr_uuid.len = LEN_UUID_128;
-                memcpy(attr_uuid.uu.uuid128, ((tGATT_ATTR128 *)p_attr)->uuid, LEN_UUID_128);
-            }
+            gatts_db_attr_uuid(p_attr, &attr_uuid);
 
             if (p_attr->handle >= s_handle && gatt_uuid_compare(type, attr_uuid))
             {
@@ -409,7 +603,11 @@ tGATT_STATUS gatts_db_read_attr_value_by_type (tGATT_TCB   *p_tcb,
                     break;
                 }
             }
-            p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+
+            if (by_bucket)
+                p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, p_attr->type_next);
+            else
+                p_attr = (tGATT_ATTR16 *)p_attr->p_next;
         }
     }
 
@@ -649,25 +847,15 @@ tGATT_STATUS gatts_read_attr_value_by_handle(tGATT_TCB *p_tcb,
     tGATT_ATTR16  *p_attr;
     UINT8       *pp = p_value;
 
-    if (p_db && p_db->p_attr_list)
+    if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL)
     {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
+        status = read_attr_value (p_attr, offset, &pp,
+                                  (BOOLEAN)(op_code == GATT_REQ_READ_BLOB),
+                                  mtu, p_len, sec_flag, key_size);
 
-        while (p_attr && handle >= p_attr->handle)
+        if (status == GATT_PENDING)
         {
-            if (p_attr->handle == handle)
-            {
-                status = read_attr_value (p_attr, offset, &pp,
-                                          (BOOLEAN)(op_code == GATT_REQ_READ_BLOB),
-                                          mtu, p_len, sec_flag, key_size);
-
-                if (status == GATT_PENDING)
-                {
-                    status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, offset, trans_id);
-                }
-                break;
-            }
-            p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+            status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, offset, trans_id);
         }
     }
 
@@ -702,21 +890,11 @@ tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB *p_db,
     tGATT_STATUS status = GATT_NOT_FOUND;
     tGATT_ATTR16  *p_attr;
 
-    if (p_db && p_db->p_attr_list)
+    if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL)
     {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
-
-        while (p_attr && handle >= p_attr->handle)
-        {
-            if (p_attr->handle == handle)
-            {
-                status = gatts_check_attr_readability (p_attr, 0,
-                                                       is_long,
-                                                       sec_flag, key_size);
-                break;
-            }
-            p_attr = (tGATT_ATTR16 *) p_attr->p_next;
-        }
+        status = gatts_check_attr_readability (p_attr, 0,
+                                               is_long,
+                                               sec_flag, key_size);
     }
 
     return status;
@@ -752,153 +930,142 @@ tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,
     GATT_TRACE_DEBUG( "gatts_write_attr_perm_check op_code=0x%0x handle=0x%04x offset=%d len=%d sec_flag=0x%0x key_size=%d",
                        op_code, handle, offset, len, sec_flag, key_size);
 
-    if (p_db != NULL)
+    if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL)
     {
-        p_attr = (tGATT_ATTR16 *) p_db->p_attr_list;
+        perm = p_attr->permission;
+        min_key_size = (((perm & GATT_ENCRYPT_KEY_SIZE_MASK) >> 12));
+        if (min_key_size != 0 )
+        {
+            min_key_size +=6;
+        }
+        GATT_TRACE_DEBUG( "gatts_write_attr_perm_check p_attr->permission =0x%04x min_key_size==0x%04x",
+                           p_attr->permission,
+                           min_key_size);
 
-        while (p_attr != NULL)
+        if ((op_code == GATT_CMD_WRITE || op_code == GATT_REQ_WRITE)
+            && (perm & GATT_WRITE_SIGNED_PERM))
         {
-            if (p_attr->handle == handle)
+            /* use the rules for the mixed security see section 10.2.3*/
+            /* use security mode 1 level 2 when the following condition follows */
+            /* LE security mode 2 level 1 and LE security mode 1 level 2 */
+            if ((perm & GATT_PERM_WRITE_SIGNED) && (perm & GATT_PERM_WRITE_ENCRYPTED))
             {
-                perm = p_attr->permission;
-                min_key_size = (((perm & GATT_ENCRYPT_KEY_SIZE_MASK) >> 12));
-                if (min_key_size != 0 )
-                {
-                    min_key_size +=6;
-                }
-                GATT_TRACE_DEBUG( "gatts_write_attr_perm_check p_attr->permission =0x%04x min_key_size==0x%04x",
-                                   p_attr->permission,
-                                   min_key_size);
-
-                if ((op_code == GATT_CMD_WRITE || op_code == GATT_REQ_WRITE)
-                    && (perm & GATT_WRITE_SIGNED_PERM))
-                {
-                    /* use the rules for the mixed security see section 10.2.3*/
-                    /* use security mode 1 level 2 when the following condition follows */
-                    /* LE security mode 2 level 1 and LE security mode 1 level 2 */
-                    if ((perm & GATT_PERM_WRITE_SIGNED) && (perm & GATT_PERM_WRITE_ENCRYPTED))
-                    {
-                        perm = GATT_PERM_WRITE_ENCRYPTED;
-                    }
-                    /* use security mode 1 level 3 when the following condition follows */
-                    /* LE security mode 2 level 2 and security mode 1 and LE */
-                    else if (((perm & GATT_PERM_WRITE_SIGNED_MITM) && (perm & GATT_PERM_WRITE_ENCRYPTED)) ||
-                              /* LE security mode 2 and security mode 1 level 3 */
-                             ((perm & GATT_WRITE_SIGNED_PERM) && (perm & GATT_PERM_WRITE_ENC_MITM)))
-                    {
-                        perm = GATT_PERM_WRITE_ENC_MITM;
-                    }
-                }
+                perm = GATT_PERM_WRITE_ENCRYPTED;
+            }
+            /* use security mode 1 level 3 when the following condition follows */
+            /* LE security mode 2 level 2 and security mode 1 and LE */
+            else if (((perm & GATT_PERM_WRITE_SIGNED_MITM) && (perm & GATT_PERM_WRITE_ENCRYPTED)) ||
+                      /* LE security mode 2 and security mode 1 level 3 */
+                     ((perm & GATT_WRITE_SIGNED_PERM) && (perm & GATT_PERM_WRITE_ENC_MITM)))
+            {
+                perm = GATT_PERM_WRITE_ENC_MITM;
+            }
+        }
 
-                if ((op_code == GATT_SIGN_CMD_WRITE) && !(perm & GATT_WRITE_SIGNED_PERM))
-                {
-                    status = GATT_WRITE_NOT_PERMIT;
-                    GATT_TRACE_DEBUG( "gatts_write_attr_perm_check - sign cmd write not allowed");
-                }
-                 if ((op_code == GATT_SIGN_CMD_WRITE) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED))
-                {
-                    status = GATT_INVALID_PDU;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - Error!! sign cmd write sent on a encypted link");
-                }
-                else if (!(perm & GATT_WRITE_ALLOWED))
-                {
+        if ((op_code == GATT_SIGN_CMD_WRITE) && !(perm & GATT_WRITE_SIGNED_PERM))
+        {
+            status = GATT_WRITE_NOT_PERMIT;
+            GATT_TRACE_DEBUG( "gatts_write_attr_perm_check - sign cmd write not allowed");
+        }
+         if ((op_code == GATT_SIGN_CMD_WRITE) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED))
+        {
+            status = GATT_INVALID_PDU;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - Error!! sign cmd write sent on a encypted link");
+        }
+        else if (!(perm & GATT_WRITE_ALLOWED))
+        {
+            status = GATT_WRITE_NOT_PERMIT;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_WRITE_NOT_PERMIT");
+        }
+        /* require authentication, but not been authenticated */
+        else if ((perm & GATT_WRITE_AUTH_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_UNAUTHED))
+        {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION");
+        }
+        else if ((perm & GATT_WRITE_MITM_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_AUTHED))
+        {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: MITM required");
+        }
+        else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED))
+        {
+            status = GATT_INSUF_ENCRYPTION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_ENCRYPTION");
+        }
+        else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED) && (key_size < min_key_size))
+        {
+            status = GATT_INSUF_KEY_SIZE;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_KEY_SIZE");
+        }
+        /* LE security mode 2 attribute  */
+        else if (perm & GATT_WRITE_SIGNED_PERM && op_code != GATT_SIGN_CMD_WRITE && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)
+            &&  (perm & GATT_WRITE_ALLOWED) == 0)
+        {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: LE security mode 2 required");
+        }
+        else /* writable: must be char value declaration or char descritpors */
+        {
+            if(p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
+            {
+            switch (p_attr->uuid)
+            {
+                case GATT_UUID_CHAR_PRESENT_FORMAT:/* should be readable only */
+                case GATT_UUID_CHAR_EXT_PROP:/* should be readable only */
+                case GATT_UUID_CHAR_AGG_FORMAT: /* should be readable only */
+                    case GATT_UUID_CHAR_VALID_RANGE:
                     status = GATT_WRITE_NOT_PERMIT;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_WRITE_NOT_PERMIT");
-                }
-                /* require authentication, but not been authenticated */
-                else if ((perm & GATT_WRITE_AUTH_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_UNAUTHED))
-                {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION");
-                }
-                else if ((perm & GATT_WRITE_MITM_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_AUTHED))
-                {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: MITM required");
-                }
-                else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED))
-                {
-                    status = GATT_INSUF_ENCRYPTION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_ENCRYPTION");
-                }
-                else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED) && (key_size < min_key_size))
-                {
-                    status = GATT_INSUF_KEY_SIZE;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_KEY_SIZE");
-                }
-                /* LE security mode 2 attribute  */
-                else if (perm & GATT_WRITE_SIGNED_PERM && op_code != GATT_SIGN_CMD_WRITE && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)
-                    &&  (perm & GATT_WRITE_ALLOWED) == 0)
-                {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: LE security mode 2 required");
-                }
-                else /* writable: must be char value declaration or char descritpors */
-                {
-                    if(p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16)
-                    {
-                    switch (p_attr->uuid)
-                    {
-                        case GATT_UUID_CHAR_PRESENT_FORMAT:/* should be readable only */
-                        case GATT_UUID_CHAR_EXT_PROP:/* should be readable only */
-                        case GATT_UUID_CHAR_AGG_FORMAT: /* should be readable only */
-                            case GATT_UUID_CHAR_VALID_RANGE:
-                            status = GATT_WRITE_NOT_PERMIT;
-                            break;
-
-                        case GATT_UUID_CHAR_CLIENT_CONFIG:
+                    break;
+
+                case GATT_UUID_CHAR_CLIENT_CONFIG:
 /* coverity[MISSING_BREAK] */
 /* intnended fall through, ignored */
-                            /* fall through */
-                        case GATT_UUID_CHAR_SRVR_CONFIG:
-                            max_size = 2;
-                        case GATT_UUID_CHAR_DESCRIPTION:
-                        default: /* any other must be character value declaration */
-                            status = GATT_SUCCESS;
-                            break;
-                        }
-                    }
-                    else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128 ||
+                    /* fall through */
+                case GATT_UUID_CHAR_SRVR_CONFIG:
+                    max_size = 2;
+                case GATT_UUID_CHAR_DESCRIPTION:
+                default: /* any other must be character value declaration */
+                    status = GATT_SUCCESS;
+                    break;
+                }
+            }
+            else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128 ||
 				              p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32)
-                    {
-                         status = GATT_SUCCESS;
-                    }
-                    else
-                    {
-                        status = GATT_INVALID_PDU;
-                    }
+            {
+                 status = GATT_SUCCESS;
+            }
+            else
+            {
+                status = GATT_INVALID_PDU;
+            }
 
-                    if (p_data == NULL && len  > 0)
-                    {
-                        status = GATT_INVALID_PDU;
-                    }
-                    /* these attribute does not allow write blob */
+            if (p_data == NULL && len  > 0)
+            {
+                status = GATT_INVALID_PDU;
+            }
+            /* these attribute does not allow write blob */
 // btla-specific ++
-                    else if ( (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) &&
-                              (p_attr->uuid == GATT_UUID_CHAR_CLIENT_CONFIG ||
-                               p_attr->uuid == GATT_UUID_CHAR_SRVR_CONFIG) )
+            else if ( (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) &&
+                      (p_attr->uuid == GATT_UUID_CHAR_CLIENT_CONFIG ||
+                       p_attr->uuid == GATT_UUID_CHAR_SRVR_CONFIG) )
 // btla-specific --
-                    {
-                        if (op_code == GATT_REQ_PREPARE_WRITE && offset != 0) /* does not allow write blob */
-                        {
-                            status = GATT_NOT_LONG;
-                            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_NOT_LONG");
-                        }
-                        else if (len != max_size)    /* data does not match the required format */
-                        {
-                            status = GATT_INVALID_ATTR_LEN;
-                            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INVALID_PDU");
-                        }
-                        else
-                        {
-                            status = GATT_SUCCESS;
-                        }
-                    }
+            {
+                if (op_code == GATT_REQ_PREPARE_WRITE && offset != 0) /* does not allow write blob */
+                {
+                    status = GATT_NOT_LONG;
+                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_NOT_LONG");
+                }
+                else if (len != max_size)    /* data does not match the required format */
+                {
+                    status = GATT_INVALID_ATTR_LEN;
+                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INVALID_PDU");
+                }
+                else
+                {
+                    status = GATT_SUCCESS;
                 }
-                break;
             }
-            else
-                p_attr = (tGATT_ATTR16 *)p_attr->p_next;
         }
     }
 
@@ -988,7 +1155,7 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
         p_db->p_attr_list = p_attr16;
     else
     {
-        p_last = (tGATT_ATTR16 *)p_db->p_attr_list;
+        p_last = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, (UINT16)(p_attr16->handle - 1));
 
         while (p_last != NULL && p_last->p_next != NULL)
             p_last = (tGATT_ATTR16 *)p_last->p_next;
@@ -996,6 +1163,8 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
         p_last->p_next = p_attr16;
     }
 
+    gatts_db_index_attr(p_db, p_attr16);
+
     if (p_attr16->uuid_type == GATT_ATTR_UUID_TYPE_16)
     {
         GATT_TRACE_DEBUG("=====> handle = [0x%04x] uuid16 = [0x%04x] perm=0x%02x ",
@@ -1060,7 +1229,10 @@ static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr)
     }
     /* else attr not found */
     if ( found)
+    {
+        gatts_db_unindex_attr(p_db, (tGATT_ATTR16 *)p_attr);
         p_db->next_handle --;
+    }
 
     return found;
 }
@@ -180,6 +180,8 @@ typedef struct
     tGATT_ATTR_UUID_TYPE                uuid_type;
     tGATT_PERM                          permission;
     UINT16                              handle;
+    UINT16                              type_next; /* next handle in the same type
+                                                      bucket, 0 if last */
     UINT16                              uuid;
 } tGATT_ATTR16;
 
@@ -193,6 +195,8 @@ typedef struct
     tGATT_ATTR_UUID_TYPE                uuid_type;
     tGATT_PERM                          permission;
     UINT16                              handle;
+    UINT16                              type_next; /* next handle in the same type
+                                                      bucket, 0 if last */
     UINT32                              uuid;
 } tGATT_ATTR32;
 
@@ -207,6 +211,8 @@ typedef struct
     tGATT_ATTR_UUID_TYPE                uuid_type;
     tGATT_PERM                          permission;
     UINT16                              handle;
+    UINT16                              type_next; /* next handle in the same type
+                                                      bucket, 0 if last */
     UINT8                               uuid[LEN_UUID_128];
 } tGATT_ATTR128;
 
@@ -221,6 +227,11 @@ typedef struct
     UINT32          mem_free;                   /* Memory still available       */
     UINT16          end_handle;                 /* Last handle number           */
     UINT16          next_handle;                /* Next usable handle value     */
+    UINT16          start_handle;               /* First handle number          */
+    void            **p_attr_tbl;               /* attributes indexed by (handle - start_handle),
+                                                  NULL if the range is too large to index */
+    UINT16          type_head[GATT_DB_TYPE_HASH_SIZE]; /* first handle of each type bucket */
+    UINT16          type_tail[GATT_DB_TYPE_HASH_SIZE]; /* last handle of each type bucket */
 } tGATT_SVC_DB;
 
 /* Data Structure used for GATT server                                        */
@@ -260,6 +271,20 @@ typedef struct
 
 
 
+/* client Write Command stream, one per connection */
+typedef struct
+{
+    UINT8                   *p_data;        /* caller buffer, valid until completion */
+    UINT32                  len;
+    UINT32                  offset;         /* next byte to send */
+    UINT32                  start_tick;
+    UINT16                  conn_id;
+    UINT16                  handle;
+    tGATT_STREAM_CMPL_CBACK *p_cback;
+    tGATT_STREAM_STATS      stats;
+    BOOLEAN                 in_use;
+} tGATT_WRITE_STREAM;
+
 /* command queue for each connection */
 typedef struct
 {
@@ -267,6 +292,7 @@ typedef struct
     UINT16      clcb_idx;
     UINT8       op_code;
     BOOLEAN     to_send;
+    UINT8       num_merged;     /* following slots answered by this Read Multiple Variable */
 }tGATT_CMD_Q;
 
 
@@ -380,6 +406,10 @@ typedef struct
     UINT8             pending_cl_req;
     UINT8             next_slot_inq;    /* index of next available slot in queue */
 
+    BOOLEAN         congested;          /* L2CAP reported the ATT channel congested */
+    tGATT_WRITE_STREAM wr_stream;
+    BOOLEAN         no_read_multi_var;  /* peer rejected Read Multiple Variable Length */
+    UINT16          cl_rtt_saved;       /* round trips saved by coalescing client reads */
     BOOLEAN         in_use;
     UINT8           tcb_idx;
 } tGATT_TCB;
@@ -414,6 +444,7 @@ typedef struct
     BOOLEAN                 in_use;
     TIMER_LIST_ENT          rsp_timer_ent;  /* peer response timer */
     UINT8                   retry_count;
+    BOOLEAN                 no_coalesce;    /* read must go out as a single Read Request */
 
 } tGATT_CLCB;
 
@@ -564,6 +595,8 @@ extern tGATT_PROFILE_CLCB *gatt_profile_clcb_alloc (UINT16 conn_id, BD_ADDR bda,
 /* Functions provided by att_protocol.c */
 extern tGATT_STATUS attp_send_cl_msg (tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 op_code, tGATT_CL_MSG *p_msg);
 extern BT_HDR *attp_build_sr_msg(tGATT_TCB *p_tcb, UINT8 op_code, tGATT_SR_MSG *p_msg);
+extern BT_HDR *attp_build_value_cmd (UINT16 payload_size, UINT8 op_code, UINT16 handle, UINT16 offset, UINT16 len, UINT8 *p_data);
+extern BT_HDR *attp_build_read_multi_cmd(UINT8 op_code, UINT16 payload_size, UINT16 num_handle, UINT16 *p_handle);
 extern tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB *p_tcb, BT_HDR *p_toL2CAP);
 
@@ -597,6 +630,8 @@ extern tGATTS_PENDING_NEW_SRV_START *gatt_add_pending_new_srv_start( tGATTS_HNDL
 extern void gatt_free_srvc_db_buffer_app_id(tBT_UUID *p_app_id);
 extern BOOLEAN gatt_update_listen_mode(void);
 extern BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb);
+extern void gatt_cl_stream_pump(tGATT_TCB *p_tcb);
+extern void gatt_cl_stream_end(tGATT_TCB *p_tcb, tGATT_STATUS status);
 
 /* reserved handle list */
 extern tGATT_HDL_LIST_ELEM *gatt_find_hdl_buffer_by_app_id (tBT_UUID *p_app_uuid128, tBT_UUID *p_svc_uuid, UINT16 svc_inst);
@@ -698,6 +733,7 @@ extern tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_co
 extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB *p_db, BOOLEAN is_long, UINT16 handle, tGATT_SEC_FLAG sec_flag,UINT8 key_size);
 extern void gatts_update_srv_list_elem(UINT8 i_sreg, UINT16 handle, BOOLEAN is_primary);
 extern tBT_UUID * gatts_get_service_uuid (tGATT_SVC_DB *p_db);
+extern void *gatts_find_attr_by_handle(tGATT_SVC_DB *p_db, UINT16 handle);
 
 extern void gatt_reset_bgdev_list(void);
 #endif
@@ -474,10 +474,14 @@ static void gatt_channel_congestion(tGATT_TCB *p_tcb, BOOLEAN congested)
     tGATT_REG *p_reg=NULL;
     UINT16 conn_id;
 
+    if (p_tcb != NULL)
+        p_tcb->congested = congested;
+
     /* if uncongested, check to see if there is any more pending data */
     if (p_tcb != NULL && congested == FALSE)
     {
         gatt_cl_send_next_cmd_inq(p_tcb);
+        gatt_cl_stream_pump(p_tcb);
     }
     /* notifying all applications for the connection up event */
     for (i = 0, p_reg = gatt_cb.cl_rcb ; i < GATT_MAX_APPS; i++, p_reg++)
@@ -961,7 +965,7 @@ void gatt_data_process (tGATT_TCB *p_tcb, BT_HDR *p_buf)
         /* remove the two MSBs associated with sign write and write cmd */
         pseudo_op_code = op_code & (~GATT_WRITE_CMD_MASK);
 
-        if (pseudo_op_code < GATT_OP_CODE_MAX)
+        if (pseudo_op_code < GATT_OP_CODE_MAX || op_code == GATT_RSP_READ_MULTI_VAR)
         {
             if (op_code == GATT_SIGN_CMD_WRITE)
             {
@@ -630,8 +630,9 @@ static tGATT_STATUS gatt_build_find_info_rsp(tGATT_SR_REG *p_rcb, BT_HDR *p_msg,
     if (!p_rcb->p_db || !p_rcb->p_db->p_attr_list)
         return status;
 
-    /* check the attribute database */
-    p_attr = (tGATT_ATTR16 *) p_rcb->p_db->p_attr_list;
+    /* check the attribute database, starting from the first handle in range */
+    p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_rcb->p_db,
+                                                       (UINT16)((s_hdl > p_rcb->s_hdl) ? s_hdl : p_rcb->s_hdl));
 
     p = (UINT8 *)(p_msg + 1) + L2CAP_MIN_OFFSET + p_msg->len;
 
@@ -1258,9 +1259,8 @@ void gatts_process_attribute_req (tGATT_TCB *p_tcb, UINT8 op_code,
 {
     UINT16          handle = 0;
     UINT8           *p = p_data, i;
-    tGATT_SR_REG    *p_rcb = gatt_cb.sr_reg;
+    tGATT_SR_REG    *p_rcb;
     tGATT_STATUS    status = GATT_INVALID_HANDLE;
-    tGATT_ATTR16    *p_attr;
 
     if (len < 2)
     {
@@ -1285,41 +1285,30 @@ void gatts_process_attribute_req (tGATT_TCB *p_tcb, UINT8 op_code,
     }
 #endif
 
-    if (GATT_HANDLE_IS_VALID(handle))
+    if (GATT_HANDLE_IS_VALID(handle) &&
+        (i = gatt_sr_find_i_rcb_by_handle(handle)) < GATT_MAX_SR_PROFILES)
     {
-        for (i = 0; i < GATT_MAX_SR_PROFILES; i ++, p_rcb ++)
+        p_rcb = &gatt_cb.sr_reg[i];
+
+        if (gatts_find_attr_by_handle(p_rcb->p_db, handle) != NULL)
         {
-            if (p_rcb->in_use && p_rcb->s_hdl <= handle && p_rcb->e_hdl >= handle)
+            switch (op_code)
             {
-                p_attr = (tGATT_ATTR16 *)p_rcb->p_db->p_attr_list;
+                case GATT_REQ_READ: /* read char/char descriptor value */
+                case GATT_REQ_READ_BLOB:
+                    gatts_process_read_req(p_tcb, p_rcb, op_code, handle, len, p);
+                    break;
 
-                while (p_attr)
-                {
-                    if (p_attr->handle == handle)
-                    {
-                        switch (op_code)
-                        {
-                            case GATT_REQ_READ: /* read char/char descriptor value */
-                            case GATT_REQ_READ_BLOB:
-                                gatts_process_read_req(p_tcb, p_rcb, op_code, handle, len, p);
-                                break;
-
-                            case GATT_REQ_WRITE: /* write char/char descriptor value */
-                            case GATT_CMD_WRITE:
-                            case GATT_SIGN_CMD_WRITE:
-                            case GATT_REQ_PREPARE_WRITE:
-                                gatts_process_write_req(p_tcb, i, handle, op_code, len, p);
-                                break;
-                            default:
-                                break;
-                        }
-                        status = GATT_SUCCESS;
-                        break;
-                    }
-                    p_attr = (tGATT_ATTR16 *)p_attr->p_next;
-                }
-                break;
+                case GATT_REQ_WRITE: /* write char/char descriptor value */
+                case GATT_CMD_WRITE:
+                case GATT_SIGN_CMD_WRITE:
+                case GATT_REQ_PREPARE_WRITE:
+                    gatts_process_write_req(p_tcb, i, handle, op_code, len, p);
+                    break;
+                default:
+                    break;
             }
+            status = GATT_SUCCESS;
         }
     }
 
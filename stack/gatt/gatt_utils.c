@@ -402,6 +402,9 @@ void gatt_free_srvc_db_buffer_app_id(tBT_UUID *p_app_id)
 
             p_elem->svc_db.mem_free = 0;
             p_elem->svc_db.p_attr_list = p_elem->svc_db.p_free_mem = NULL;
+            p_elem->svc_db.p_attr_tbl = NULL;
+            memset(p_elem->svc_db.type_head, 0, sizeof(p_elem->svc_db.type_head));
+            memset(p_elem->svc_db.type_tail, 0, sizeof(p_elem->svc_db.type_tail));
         }
     }
 }
@@ -2024,6 +2027,7 @@ BOOLEAN gatt_cmd_enq(tGATT_TCB *p_tcb, UINT16 clcb_idx, BOOLEAN to_send, UINT8 o
     p_cmd->op_code  = op_code;
     p_cmd->p_cmd    = p_buf;
     p_cmd->clcb_idx = clcb_idx;
+    p_cmd->num_merged = 0;
 
     if (!to_send)
     {
@@ -2231,6 +2235,9 @@ void gatt_cleanup_upon_disc(BD_ADDR bda, UINT16 reason, tBT_TRANSPORT transport)
             }
         }
 
+        if (p_tcb->wr_stream.in_use)
+            gatt_cl_stream_end(p_tcb, GATT_ERROR);
+
         btu_stop_timer (&p_tcb->ind_ack_timer_ent);
         btu_stop_timer (&p_tcb->conf_timer_ent);
         gatt_free_pending_ind(p_tcb);
@@ -3478,6 +3478,7 @@ void btsnd_hcic_raw_cmd (void *buffer, UINT16 opcode, UINT8 len,
 
     p->len    = HCIC_PREAMBLE_SIZE + len;
     p->offset = sizeof(void *);
+    p->layer_specific = 0;              /* no context after the callback pointer */
 
     *((void **)pp) = p_cmd_cplt_cback;  /* Store command complete callback in buffer */
     pp += sizeof(void *);               /* Skip over callback pointer */
@@ -3491,16 +3492,31 @@ void btsnd_hcic_raw_cmd (void *buffer, UINT16 opcode, UINT8 len,
 
 void btsnd_hcic_vendor_spec_cmd (void *buffer, UINT16 opcode, UINT8 len,
                                  UINT8 *p_data, void *p_cmd_cplt_cback)
+{
+    btsnd_hcic_vendor_spec_cmd_ctx (buffer, opcode, len, p_data, p_cmd_cplt_cback, NULL, 0);
+}
+
+void btsnd_hcic_vendor_spec_cmd_ctx (void *buffer, UINT16 opcode, UINT8 len,
+                                     UINT8 *p_data, void *p_cmd_cplt_cback,
+                                     void *p_context, UINT8 context_len)
 {
     BT_HDR *p = (BT_HDR *)buffer;
     UINT8 *pp = (UINT8 *)(p + 1);
 
     p->len    = HCIC_PREAMBLE_SIZE + len;
-    p->offset = sizeof(void *);
+    p->offset = sizeof(void *) + context_len;
+    p->layer_specific = context_len;
 
     *((void **)pp) = p_cmd_cplt_cback;  /* Store command complete callback in buffer */
     pp += sizeof(void *);               /* Skip over callback pointer */
 
+    /* Caller context follows the callback, handed back on completion */
+    if (context_len != 0)
+    {
+        memcpy (pp, p_context, context_len);
+        pp += context_len;
+    }
+
     UINT16_TO_STREAM (pp, HCI_GRP_VENDOR_SPECIFIC | opcode);
     UINT8_TO_STREAM  (pp, len);
     ARRAY_TO_STREAM  (pp, p_data, len);
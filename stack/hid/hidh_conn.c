@@ -42,6 +42,7 @@
 #include "hidh_api.h"
 #include "hidh_int.h"
 #include "bt_utils.h"
+#include "interop.h"
 
 static UINT8 find_conn_by_cid (UINT16 cid);
 static void hidh_conn_retry (UINT8 dhandle);
@@ -74,17 +75,12 @@ static const tL2CAP_APPL_INFO hst_reg_info =
     NULL                        /* tL2CA_TX_COMPLETE_CB */
 };
 
-/* hid_auth_blacklist to FIX IOP issues with hid devices
- * that dont want to have authentication during hid connection */
-static const UINT8 hid_auth_blacklist[][3] = {
-    {0x00, 0x12, 0xa1} // Targus
-};
-
 /*****************************************************************************
 **
 ** Function        check_if_auth_bl
 **
-** Description     Checks if a given device is blacklisted to skip authentication
+** Description     Checks if a given device is blacklisted to skip authentication.
+**                 The list lives in the interop database, shared with btif.
 **
 ** Parameters     remote_bdaddr
 **
@@ -93,18 +89,10 @@ static const UINT8 hid_auth_blacklist[][3] = {
 *******************************************************************************/
 static bool check_if_auth_bl (BD_ADDR peer_dev)
 {
-    int i;
-    int blacklist_size =
-            sizeof(hid_auth_blacklist)/sizeof(hid_auth_blacklist[0]);
-    for (i = 0; i < blacklist_size; i++) {
-        if (hid_auth_blacklist[i][0] == peer_dev[0] &&
-            hid_auth_blacklist[i][1] == peer_dev[1] &&
-            hid_auth_blacklist[i][2] == peer_dev[2]) {
-            APPL_TRACE_WARNING("%02x:%02x:%02x:%02x:%02x:%02x is in blacklist for auth",
-                    peer_dev[0], peer_dev[1], peer_dev[2], peer_dev[3], peer_dev[4], peer_dev[5]);
-
-            return true;
-        }
+    if (interop_match_addr(INTEROP_HID_NO_AUTH, peer_dev)) {
+        APPL_TRACE_WARNING("%02x:%02x:%02x:%02x:%02x:%02x is in blacklist for auth",
+                peer_dev[0], peer_dev[1], peer_dev[2], peer_dev[3], peer_dev[4], peer_dev[5]);
+        return true;
     }
     APPL_TRACE_DEBUG("%02x:%02x:%02x:%02x:%02x:%02x is not in blacklist for auth",
             peer_dev[0], peer_dev[1], peer_dev[2], peer_dev[3], peer_dev[4], peer_dev[5]);
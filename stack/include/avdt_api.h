@@ -835,6 +835,26 @@ AVDT_API extern UINT16 AVDT_WriteReq(UINT8 handle, BT_HDR *p_pkt, UINT32 time_st
 AVDT_API extern UINT16 AVDT_WriteReqOpt(UINT8 handle, BT_HDR *p_pkt, UINT32 time_stamp,
                                      UINT8 m_pt, tAVDT_DATA_OPT_MASK opt);
 
+/*******************************************************************************
+**
+** Function         AVDT_WriteReqBatch
+**
+** Description      Send several media packets to the peer device at once.
+**                  This works like AVDT_WriteReqOpt(), except that all the
+**                  packets are handed to L2CAP together and a single
+**                  AVDT_WRITE_CFM_EVT is sent once the whole batch has been
+**                  queued.  time_stamp[i] is the time stamp of pp_pkt[i].
+**
+**                  Every buffer must meet the AVDT_WriteReqOpt() offset
+**                  requirement and is freed by the protocol stack.
+**
+** Returns          AVDT_SUCCESS if successful, otherwise error.
+**
+*******************************************************************************/
+AVDT_API extern UINT16 AVDT_WriteReqBatch(UINT8 handle, UINT8 num_pkts, BT_HDR **pp_pkt,
+                                          UINT32 *p_time_stamp, UINT8 m_pt,
+                                          tAVDT_DATA_OPT_MASK opt);
+
 /*******************************************************************************
 **
 ** Function         AVDT_ConnectReq
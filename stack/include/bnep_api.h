@@ -329,7 +329,8 @@ BNEP_API extern tBNEP_RESULT BNEP_Disconnect (UINT16 handle);
 ** Returns:         BNEP_WRONG_HANDLE       - if passed handle is not valid
 **                  BNEP_MTU_EXCEDED        - If the data length is greater than MTU
 **                  BNEP_IGNORE_CMD         - If the packet is filtered out
-**                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full
+**                  BNEP_Q_SIZE_EXCEEDED    - If the Tx Q is full, the buffer
+**                                            is not freed
 **                  BNEP_SUCCESS            - If written successfully
 **
 *******************************************************************************/
@@ -113,6 +113,8 @@ typedef struct
     UINT16  opcode;
     UINT16  param_len;
     UINT8   *p_param_buf;
+    UINT8   *p_context;     /* context given to BTM_VendorSpecificCommandWithContext, or NULL */
+    UINT8   context_len;
 } tBTM_VSC_CMPL;
 
 /* Structure returned with HCI Raw Command complete callback */
@@ -124,6 +126,9 @@ typedef struct
 } tBTM_RAW_CMPL;
 
 #define  BTM_VSC_CMPL_DATA_SIZE  (BTM_MAX_VENDOR_SPECIFIC_LEN + sizeof(tBTM_VSC_CMPL))
+
+/* Largest context BTM_VendorSpecificCommandWithContext can carry */
+#define  BTM_VSC_CONTEXT_LEN     24
 /**************************************************
 **  Device Control and General Callback Functions
 ***************************************************/
@@ -145,6 +150,33 @@ typedef UINT8 tBTM_DEV_STATUS;
 typedef void (tBTM_DEV_STATUS_CB) (tBTM_DEV_STATUS status);
 
 
+/* Controller capabilities read during device reset.  They only change with
+** the controller firmware, so a snapshot keyed by the local version lets a
+** later reset skip most of the reads.  See BTM_RegisterCtrlCapsCache().
+*/
+#define BTM_LE_SUPPORT_STATES_LEN   8
+
+typedef struct
+{
+    tBTM_VERSION_INFO   version;                /* key, snapshot only used on an exact match */
+    UINT8               supported_cmds[HCI_NUM_SUPP_COMMANDS_BYTES];
+    UINT8               max_page;               /* last valid LMP features page */
+    BD_FEATURES         lmp_features[HCI_EXT_FEATURES_PAGE_MAX + 1];    /* before host support is written */
+    BOOLEAN             le_valid;               /* the LE fields below are filled in */
+    UINT16              le_acl_data_size;
+    UINT8               le_num_bufs;
+    UINT8               white_list_size;
+    UINT8               le_supported_states[BTM_LE_SUPPORT_STATES_LEN];
+    BD_FEATURES         le_features;
+} tBTM_CTRL_CAPS;
+
+/* Fill in p_caps with the stored snapshot.  Returns FALSE if there is none. */
+typedef BOOLEAN (tBTM_CTRL_CAPS_LOAD_CB) (tBTM_CTRL_CAPS *p_caps);
+
+/* Store a snapshot read from the controller */
+typedef void (tBTM_CTRL_CAPS_STORE_CB) (const tBTM_CTRL_CAPS *p_caps);
+
+
 /* Callback function for when a vendor specific event occurs. The length and
 ** array of returned parameter bytes are included. This asynchronous event
 ** is enabled/disabled by calling BTM_RegisterForVSEvents().
@@ -1647,6 +1679,14 @@ typedef UINT8 (tBTM_SP_CALLBACK) (tBTM_SP_EVT event, tBTM_SP_EVT_DATA *p_data);
 
 typedef void (tBTM_MKEY_CALLBACK) (BD_ADDR bd_addr, UINT8 status, UINT8 key_flag) ;
 
+/* Device loader: called when a device has no security record, to add the record
+** from persistent storage with BTM_SecAddDevice/BTM_SecAddBleDevice/BTM_SecAddBleKey.
+** Parameters are
+**              BD Address of remote
+** Returns TRUE if the device was bonded and its record has been added.
+*/
+typedef BOOLEAN (tBTM_SEC_DEV_LOAD_CBACK) (BD_ADDR bd_addr);
+
 /* Encryption enabled/disabled complete: Optionally passed with BTM_SetEncryption.
 ** Parameters are
 **              BD Address of remote
@@ -2261,6 +2301,22 @@ extern "C" {
 *******************************************************************************/
     BTM_API extern tBTM_DEV_STATUS_CB *BTM_RegisterForDeviceStatusNotif (tBTM_DEV_STATUS_CB *p_cb);
 
+/*******************************************************************************
+**
+** Function         BTM_RegisterCtrlCapsCache
+**
+** Description      This function is called to register a persistent store for
+**                  the controller capabilities.  On the next device reset the
+**                  stored snapshot is used in place of the capability reads if
+**                  the controller reports the same local version.  Must be
+**                  called before BTM_DeviceReset().  Pass NULLs to disable.
+**
+** Returns          void
+**
+*******************************************************************************/
+    BTM_API extern void BTM_RegisterCtrlCapsCache (tBTM_CTRL_CAPS_LOAD_CB *p_load_cb,
+                                                   tBTM_CTRL_CAPS_STORE_CB *p_store_cb);
+
 
 /*******************************************************************************
 **
@@ -2330,6 +2386,32 @@ extern "C" {
                                                          tBTM_VSC_CMPL_CB *p_cb);
 
 
+/*******************************************************************************
+**
+** Function         BTM_VendorSpecificCommandWithContext
+**
+** Description      Send a vendor specific HCI command to the controller. Up to
+**                  BTM_VSC_CONTEXT_LEN bytes at p_context are copied and
+**                  handed back in the p_context field of the completion, so
+**                  callers do not have to queue their own record of each
+**                  command sent.
+**
+** Returns
+**      BTM_SUCCESS         Command sent. Does not expect command complete
+**                              event. (command cmpl callback param is NULL)
+**      BTM_CMD_STARTED     Command sent. Waiting for command cmpl event.
+**      BTM_ILLEGAL_VALUE   Context too long.
+**      BTM_NO_RESOURCES    Command not sent.
+**
+*******************************************************************************/
+    BTM_API extern tBTM_STATUS BTM_VendorSpecificCommandWithContext(UINT16 opcode,
+                                                         UINT8 param_len,
+                                                         UINT8 *p_param_buf,
+                                                         tBTM_VSC_CMPL_CB *p_cb,
+                                                         void *p_context,
+                                                         UINT8 context_len);
+
+
 /*******************************************************************************
 **
 ** Function         BTM_AllocateSCN
@@ -3957,6 +4039,22 @@ BTM_API extern tBTM_STATUS BTM_SetWBSCodec (tBTM_SCO_CODEC_TYPE codec_type);
 *******************************************************************************/
     BTM_API extern BOOLEAN BTM_SecDeleteDevice (BD_ADDR bd_addr);
 
+/*******************************************************************************
+**
+** Function         BTM_SecRegisterDevLoader
+**
+** Description      Register the function that pages bonded devices in from
+**                  persistent storage. Once registered, the security database
+**                  is a cache of BTM_SEC_MAX_DEVICE_RECORDS records: the oldest
+**                  idle record is evicted when a new one is needed, and a
+**                  bonded device that is not resident is added back through
+**                  p_cback the next time a record is needed for it.
+**
+** Returns          void
+**
+*******************************************************************************/
+    BTM_API extern void BTM_SecRegisterDevLoader (tBTM_SEC_DEV_LOAD_CBACK *p_cback);
+
 
 /*******************************************************************************
 **
@@ -440,13 +440,13 @@ typedef struct
     tBTM_BLE_ADV_TX_POWER tx_power;
 }tBTM_BLE_ADV_PARAMS;
 
+/* multi adv operation, carried with its VSC and returned on command complete */
 typedef struct
 {
-    UINT8   *p_sub_code; /* dynamic array to store sub code */
-    UINT8   *p_inst_id;  /* dynamic array to store instance id */
-    UINT8   pending_idx;
-    UINT8   next_idx;
-}tBTM_BLE_MULTI_ADV_OPQ;
+    UINT8   sub_code;
+    UINT8   inst_id;
+    UINT8   cb_evt;
+}tBTM_BLE_MULTI_ADV_OP;
 
 typedef void (tBTM_BLE_MULTI_ADV_CBACK)(tBTM_BLE_MULTI_ADV_EVT evt, UINT8 inst_id,
                 void *p_ref, tBTM_STATUS status);
@@ -472,7 +472,6 @@ typedef struct
 typedef struct
 {
     tBTM_BLE_MULTI_ADV_INST *p_adv_inst; /* dynamic array to store adv instance */
-    tBTM_BLE_MULTI_ADV_OPQ  op_q;
 }tBTM_BLE_MULTI_ADV_CB;
 
 typedef void (tBTM_BLE_SCAN_THRESHOLD_CBACK)(tBTM_BLE_REF_VALUE ref_value);
@@ -505,14 +504,14 @@ enum
 };
 typedef UINT8 tBTM_BLE_DISCARD_RULE;
 
+/* batch scan operation, carried with its VSC and returned on command complete */
 typedef struct
 {
-    UINT8   sub_code[BTM_BLE_BATCH_SCAN_MAX];
-    tBTM_BLE_BATCH_SCAN_STATE cur_state[BTM_BLE_BATCH_SCAN_MAX];
-    tBTM_BLE_REF_VALUE        ref_value[BTM_BLE_BATCH_SCAN_MAX];
-    UINT8   pending_idx;
-    UINT8   next_idx;
-}tBTM_BLE_BATCH_SCAN_OPQ;
+    UINT8   sub_code;
+    tBTM_BLE_BATCH_SCAN_STATE cur_state;
+    UINT8   cb_evt;
+    tBTM_BLE_REF_VALUE        ref_value;
+}tBTM_BLE_BATCH_SCAN_OP;
 
 typedef struct
 {
@@ -533,7 +532,6 @@ typedef struct
     UINT32                  scan_window;
     tBLE_ADDR_TYPE          addr_type;
     tBTM_BLE_DISCARD_RULE   discard_rule;
-    tBTM_BLE_BATCH_SCAN_OPQ  op_q;
     tBTM_BLE_BATCH_SCAN_REP_Q main_rep_q;
     tBTM_BLE_SCAN_SETUP_CBACK     *p_setup_cback;
     tBTM_BLE_SCAN_THRESHOLD_CBACK *p_thres_cback;
@@ -699,16 +697,16 @@ typedef union
     tBTM_BLE_PF_SRVC_PATTERN_COND           srvc_data;      /* service data pattern */
 }tBTM_BLE_PF_COND_PARAM;
 
+/* adv filter operation, carried with its VSC and returned on command complete */
 typedef struct
 {
-    UINT8   action_ocf[BTM_BLE_PF_TYPE_MAX];
-    tBTM_BLE_REF_VALUE  ref_value[BTM_BLE_PF_TYPE_MAX];
-    tBTM_BLE_PF_PARAM_CBACK  *p_filt_param_cback[BTM_BLE_PF_TYPE_MAX];
-    tBTM_BLE_PF_CFG_CBACK *p_scan_cfg_cback[BTM_BLE_PF_TYPE_MAX];
-    UINT8   cb_evt[BTM_BLE_PF_TYPE_MAX];
-    UINT8   pending_idx;
-    UINT8   next_idx;
-}tBTM_BLE_ADV_FILTER_ADV_OPQ;
+    UINT8   action;
+    UINT8   ocf;
+    UINT8   cb_evt;
+    tBTM_BLE_REF_VALUE  ref_value;
+    tBTM_BLE_PF_PARAM_CBACK  *p_filt_param_cback;
+    tBTM_BLE_PF_CFG_CBACK *p_scan_cfg_cback;
+}tBTM_BLE_ADV_FILT_OP;
 
 #define BTM_BLE_MAX_FILTER_COUNTER  (BTM_BLE_MAX_ADDR_FILTER + 1) /* per device filter + one generic filter indexed by 0 */
 
@@ -730,7 +728,6 @@ typedef struct
     tBTM_BLE_PF_COUNT   *p_addr_filter_count; /* per BDA filter array */
     tBLE_BD_ADDR        cur_filter_target;
     tBTM_BLE_PF_STATUS_CBACK *p_filt_stat_cback;
-    tBTM_BLE_ADV_FILTER_ADV_OPQ  op_q;
 }tBTM_BLE_ADV_FILTER_CB;
 
 /* Sub codes */
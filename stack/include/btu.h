@@ -210,11 +210,60 @@ typedef struct
 #define NFC_CONTROLLER_ID       (1)
 #define BTU_MAX_LOCAL_CTRLS     (1 + NFC_MAX_LOCAL_CTRLS) /* only BR/EDR */
 
+/* Commands that complete through a callback (vendor specific, LE rand and
+** encrypt) carry it at the start of the buffer, ahead of the HCI packet at
+** offset. A vendor specific command may also carry caller context right
+** after the callback, with its length in layer_specific. The context is
+** handed back with the completion.
+*/
+
+/* A command sent to the controller and waiting for Command Complete or
+** Command Status. Slots are chained per opcode hash bucket in the order the
+** commands were sent, so the oldest command with an opcode is found first.
+*/
+#define BTU_CMD_HASH_SIZE       16          /* must be a power of 2 */
+#define BTU_CMD_HASH(opcode)    (((opcode) ^ ((opcode) >> 10)) & (BTU_CMD_HASH_SIZE - 1))
+#define BTU_CMD_SLOT_NONE       0xFF
+
+typedef struct
+{
+    BT_HDR          *p_cmd;         /* copy of the command, NULL if the slot is free */
+    UINT64          sent_us;        /* time the command was handed to the transport */
+    UINT32          seq;            /* send order, the oldest command times out first */
+    UINT16          opcode;
+    UINT8           next;           /* next slot in the same bucket */
+} tHCI_PEND_CMD;
+
+#if (defined(BTU_CMD_STATS_INCLUDED) && BTU_CMD_STATS_INCLUDED == TRUE)
+/* Completions of one opcode. Latency runs from handing the command to the
+** transport until its Command Complete or Command Status is processed.
+** Bucket 0 of the histogram counts latencies under 1 ms, bucket n those
+** under 2^n ms and the last bucket everything slower.
+*/
+#define BTU_CMD_LAT_BUCKETS     12
+
+typedef struct
+{
+    UINT16          opcode;         /* HCI_COMMAND_NONE if the entry is unused */
+    UINT32          count;          /* completions, including those faked on timeout */
+    UINT32          timeouts;
+    UINT32          max_us;
+    UINT64          total_us;
+    UINT32          lat_hist[BTU_CMD_LAT_BUCKETS];
+} tHCI_CMD_STATS;
+#endif
+
 /* AMP HCI control block */
 typedef struct
 {
     BUFFER_Q         cmd_xmit_q;
-    BUFFER_Q         cmd_cmpl_q;
+    tHCI_PEND_CMD    pend[BTU_MAX_PEND_CMDS];
+    UINT8            pend_hash[BTU_CMD_HASH_SIZE];  /* first slot of each bucket */
+    UINT8            pend_count;
+    UINT32           pend_seq;
+#if (defined(BTU_CMD_STATS_INCLUDED) && BTU_CMD_STATS_INCLUDED == TRUE)
+    tHCI_CMD_STATS   stats[BTU_CMD_STATS_SIZE];
+#endif
     UINT16           cmd_window;
     TIMER_LIST_ENT   cmd_cmpl_timer;        /* Command complete timer */
 #if (defined(BTU_CMD_CMPL_TOUT_DOUBLE_CHECK) && BTU_CMD_CMPL_TOUT_DOUBLE_CHECK == TRUE)
@@ -300,6 +349,11 @@ BTU_API extern void  btu_hcif_process_event (UINT8 controller_id, BT_HDR *p_buf)
 BTU_API extern void  btu_hcif_send_cmd (UINT8 controller_id, BT_HDR *p_msg);
 BTU_API extern void  btu_hcif_send_host_rdy_for_data(void);
 BTU_API extern void  btu_hcif_cmd_timeout (UINT8 controller_id);
+BTU_API extern void  btu_hcif_init_cmd_cb (UINT8 controller_id);
+#if (defined(BTU_CMD_STATS_INCLUDED) && BTU_CMD_STATS_INCLUDED == TRUE)
+BTU_API extern const tHCI_CMD_STATS *btu_hcif_get_cmd_stats (UINT8 controller_id, UINT16 opcode);
+BTU_API extern void  btu_hcif_dump_cmd_stats (UINT8 controller_id);
+#endif
 
 /* Functions provided by btu_core.c
 ************************************
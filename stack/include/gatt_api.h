@@ -97,6 +97,8 @@ typedef UINT8 tGATT_STATUS;
 #define  GATT_HANDLE_VALUE_NOTIF             0x1B
 #define  GATT_HANDLE_VALUE_IND               0x1D
 #define  GATT_HANDLE_VALUE_CONF              0x1E
+#define  GATT_REQ_READ_MULTI_VAR             0x20 /* added in V5.2 */
+#define  GATT_RSP_READ_MULTI_VAR             0x21
 #define  GATT_SIGN_CMD_WRITE                 0xD2 /* changed in V4.0 1101-0010 (signed write)  see write cmd above*/
 #define  GATT_OP_CODE_MAX                    GATT_HANDLE_VALUE_CONF + 1 /* 0x1E = 30 + 1 = 31*/
 
@@ -559,6 +561,11 @@ typedef UINT8 tGATT_IF;
 typedef void (tGATT_DISC_RES_CB) (UINT16 conn_id, tGATT_DISC_TYPE disc_type,
                                     tGATT_DISC_RES *p_data);
 
+/* discover result batch callback function: all results of one response PDU,
+** in handle order */
+typedef void (tGATT_DISC_RES_BATCH_CB) (UINT16 conn_id, tGATT_DISC_TYPE disc_type,
+                                        UINT16 num_res, tGATT_DISC_RES *p_data);
+
 /* discover complete callback function */
 typedef void (tGATT_DISC_CMPL_CB) (UINT16 conn_id, tGATT_DISC_TYPE disc_type, tGATT_STATUS status);
 
@@ -580,10 +587,24 @@ typedef void (tGATT_CONGESTION_CBACK )(UINT16 conn_id, BOOLEAN congested);
 /* Define a callback function when encryption is established. */
 typedef void (tGATT_ENC_CMPL_CB)(tGATT_IF gatt_if, BD_ADDR bda);
 
+/* Write stream statistics, reported once when the stream completes */
+typedef struct
+{
+    UINT32      bytes;          /* attribute value bytes sent */
+    UINT32      num_pkts;       /* Write Commands sent */
+    UINT32      num_stalls;     /* times the stream waited for the channel to uncongest */
+    UINT32      duration_ms;    /* from stream start to the last segment handed to L2CAP */
+} tGATT_STREAM_STATS;
+
+/* write stream complete callback */
+typedef void (tGATT_STREAM_CMPL_CBACK)(UINT16 conn_id, UINT16 handle, tGATT_STATUS status,
+                                       tGATT_STREAM_STATS *p_stats);
+
 
 /* Define the structure that applications use to register with
 ** GATT. This structure includes callback functions. All functions
-** MUST be provided.
+** MUST be provided, except p_disc_res_batch_cb: when it is set, discovery
+** results are delivered through it instead of p_disc_res_cb.
 */
 typedef struct
 {
@@ -594,6 +615,7 @@ typedef struct
     tGATT_REQ_CBACK                 *p_req_cb;
     tGATT_ENC_CMPL_CB               *p_enc_cmpl_cb;
     tGATT_CONGESTION_CBACK          *p_congestion_cb;
+    tGATT_DISC_RES_BATCH_CB         *p_disc_res_batch_cb;
 } tGATT_CBACK;
 
 /***********************  Start Handle Management Definitions   **********************
@@ -880,6 +902,31 @@ extern "C"
     GATT_API extern  tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
                                                                  UINT16 val_len, UINT8 *p_val);
 
+/*******************************************************************************
+**
+** Function         GATTS_HandleValueNotifyMulti
+**
+** Description      This function sends one handle value notification to a set
+**                  of clients. The PDU is built once and copied to each link.
+**
+** Parameter        num_conn: number of connections in p_conn_id.
+**                  p_conn_id: connection identifiers.
+**                  attr_handle: Attribute handle of this handle value notification.
+**                  val_len: Length of the notified attribute value.
+**                  p_val: Pointer to the notified attribute value data.
+**                  p_status: output, per connection result:
+**                            GATT_SUCCESS if sent,
+**                            GATT_CONGESTED if sent and the link is now congested,
+**                            GATT_BUSY if not sent because the link is congested,
+**                            or another error code.
+**
+** Returns          GATT_SUCCESS if sent to at least one link; otherwise error code.
+**
+*******************************************************************************/
+    GATT_API extern  tGATT_STATUS GATTS_HandleValueNotifyMulti (UINT8 num_conn, UINT16 *p_conn_id,
+                                                                UINT16 attr_handle, UINT16 val_len,
+                                                                UINT8 *p_val, tGATT_STATUS *p_status);
+
 
 /*******************************************************************************
 **
@@ -984,6 +1031,33 @@ extern "C"
 *******************************************************************************/
     GATT_API extern tGATT_STATUS GATTC_ExecuteWrite (UINT16 conn_id, BOOLEAN is_execute);
 
+/*******************************************************************************
+**
+** Function         GATTC_WriteStream
+**
+** Description      This function is called to stream a large buffer to one
+**                  attribute as a series of MTU-sized Write Commands. Segments
+**                  are handed to L2CAP until the channel congests and resume
+**                  when it uncongests; no CLCB or per-packet callback is used.
+**                  The link's current security level applies.
+**                  If the whole buffer goes out without the channel congesting,
+**                  or sending fails at once, p_cback is called before this
+**                  function returns, so the caller must be ready for it, and
+**                  may start the next stream from it.
+**
+** Parameters       conn_id: connection identifier.
+**                  handle: attribute handle to write.
+**                  len: number of bytes in p_data.
+**                  p_data: data to send; must stay valid until p_cback is called.
+**                  p_cback: called once when the stream ends, possibly from
+**                           within this function.
+**
+** Returns          GATT_SUCCESS if the stream started successfully.
+**
+*******************************************************************************/
+    GATT_API extern tGATT_STATUS GATTC_WriteStream (UINT16 conn_id, UINT16 handle, UINT32 len,
+                                                    UINT8 *p_data, tGATT_STREAM_CMPL_CBACK *p_cback);
+
 /*******************************************************************************
 **
 ** Function         GATTC_SendHandleValueConfirm
@@ -960,6 +960,14 @@ HCI_API extern void btsnd_hcic_vendor_spec_cmd (
                                                 UINT8 len, UINT8 *p_data,
                                                 void *p_cmd_cplt_cback);
 
+/* As above, with context_len bytes of context returned with the completion.
+** The buffer must have room for the context after the callback. */
+HCI_API extern void btsnd_hcic_vendor_spec_cmd_ctx (
+                                                void *buffer, UINT16 opcode,
+                                                UINT8 len, UINT8 *p_data,
+                                                void *p_cmd_cplt_cback,
+                                                void *p_context, UINT8 context_len);
+
 
 /*********************************************************************************
 **                                                                              **
@@ -362,8 +362,9 @@ PAN_API extern tPAN_RESULT PAN_Write (UINT16 handle,
 **                  on GN or NAP side and the packet is multicast or broadcast
 **                  it will be sent on all the links. Otherwise the correct link
 **                  is found based on the destination address and forwarded on it
-**                  If the return value is not PAN_SUCCESS the application should
-**                  take care of releasing the message buffer
+**                  The buffer is always consumed, except on PAN_Q_SIZE_EXCEEDED
+**                  where the application keeps it and may send it again once
+**                  the data flow is back on
 **
 ** Parameters:      dst      - MAC or BD Addr of the destination device
 **                  src      - MAC or BD Addr of the source who sent this packet
@@ -372,6 +373,7 @@ PAN_API extern tPAN_RESULT PAN_Write (UINT16 handle,
 **                  ext      - to indicate that extension headers present
 **
 ** Returns          PAN_SUCCESS       - if the data is sent successfully
+**                  PAN_Q_SIZE_EXCEEDED - if the BNEP transmit queue is full
 **                  PAN_FAILURE       - if the connection is not found or
 **                                           there is an error in sending data
 **
@@ -181,6 +181,28 @@ typedef struct t_sdp_di_get_record
     tSDP_DI_RECORD  rec;
 }tSDP_DI_GET_RECORD;
 
+/* SDP record cache persistence. The load callback copies the stored cache
+** blob of a device into p_buf (at most *p_len bytes) and updates *p_len. The
+** store callback saves a blob, a length of 0 removes the stored blob.
+*/
+typedef BOOLEAN (tSDP_CACHE_LOAD_CBACK) (BD_ADDR bd_addr, UINT8 *p_buf, UINT16 *p_len);
+typedef void (tSDP_CACHE_STORE_CBACK) (BD_ADDR bd_addr, UINT8 *p_buf, UINT16 len);
+
+typedef struct
+{
+    tSDP_CACHE_LOAD_CBACK   *p_load;
+    tSDP_CACHE_STORE_CBACK  *p_store;
+} tSDP_CACHE_STORAGE;
+
+/* SDP record cache counters */
+typedef struct
+{
+    UINT32          hits;           /* searches answered from the cache */
+    UINT32          misses;         /* searches that went over the air */
+    UINT32          stores;         /* search results added to the cache */
+    UINT32          invalidations;  /* results dropped by TTL, EIR change or request */
+} tSDP_CACHE_STATS;
+
 
 /*****************************************************************************
 **  External Function Declarations
@@ -712,6 +734,67 @@ SDP_API extern UINT16 SDP_GetDiRecord (UINT8 getRecordIndex,
 *******************************************************************************/
 SDP_API extern UINT8 SDP_SetTraceLevel (UINT8 new_level);
 
+/*******************************************************************************
+**
+** Function         SDP_CacheRegisterStorage
+**
+** Description      This function registers the persistent storage used to
+**                  keep cached SDP results across restarts.
+**
+** Returns          void
+**
+*******************************************************************************/
+SDP_API extern void SDP_CacheRegisterStorage (tSDP_CACHE_STORAGE *p_storage);
+
+/*******************************************************************************
+**
+** Function         SDP_CacheSetTtl
+**
+** Description      This function sets how long, in seconds, a cached SDP
+**                  result is used before the remote device is searched again.
+**                  A value of 0 disables the cache.
+**
+** Returns          void
+**
+*******************************************************************************/
+SDP_API extern void SDP_CacheSetTtl (UINT32 ttl);
+
+/*******************************************************************************
+**
+** Function         SDP_CacheInvalidate
+**
+** Description      This function drops the cached SDP results of a device,
+**                  or of all devices if bd_addr is NULL.
+**
+** Returns          void
+**
+*******************************************************************************/
+SDP_API extern void SDP_CacheInvalidate (BD_ADDR bd_addr);
+
+/*******************************************************************************
+**
+** Function         SDP_CacheEirUpdate
+**
+** Description      This function is called when EIR data has been received
+**                  from a device. Cached results are dropped if the services
+**                  advertised in EIR changed since they were stored.
+**
+** Returns          void
+**
+*******************************************************************************/
+SDP_API extern void SDP_CacheEirUpdate (BD_ADDR bd_addr, UINT8 *p_eir_uuid, UINT16 len);
+
+/*******************************************************************************
+**
+** Function         SDP_CacheGetStats
+**
+** Description      This function reads the SDP record cache counters.
+**
+** Returns          void
+**
+*******************************************************************************/
+SDP_API extern void SDP_CacheGetStats (tSDP_CACHE_STATS *p_stats);
+
 /*******************************************************************************
 **
 ** Function         SDP_ConnOpen
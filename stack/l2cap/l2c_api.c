@@ -896,7 +896,7 @@ UINT16 L2CA_LocalLoopbackReq (UINT16 psm, UINT16 handle, BD_ADDR p_bd_addr)
     }
 
     p_lcb->link_state = LST_CONNECTED;
-    p_lcb->handle     = handle;
+    l2cu_set_lcb_handle (p_lcb, handle);
 
     /* Allocate a channel control block */
     if ((p_ccb = l2cu_allocate_ccb (p_lcb, 0)) == NULL)
@@ -331,7 +331,7 @@ void l2cble_scanner_conn_comp (UINT16 handle, BD_ADDR bda, tBLE_ADDR_TYPE type,
     btu_stop_timer(&p_lcb->timer_entry);
 
     /* Save the handle */
-    p_lcb->handle = handle;
+    l2cu_set_lcb_handle (p_lcb, handle);
 
     /* Connected OK. Change state to connected, we were scanning so we are master */
     p_lcb->link_role  = HCI_ROLE_MASTER;
@@ -418,7 +418,7 @@ void l2cble_advertiser_conn_comp (UINT16 handle, BD_ADDR bda, tBLE_ADDR_TYPE typ
     }
 
     /* Save the handle */
-    p_lcb->handle = handle;
+    l2cu_set_lcb_handle (p_lcb, handle);
 
     /* Connected OK. Change state to connected, we were advertising, so we are slave */
     p_lcb->link_role  = HCI_ROLE_SLAVE;
@@ -28,6 +28,7 @@
 #include "l2cdefs.h"
 #include "gki.h"
 #include "btm_api.h"
+#include "slab.h"
 
 #define L2CAP_MIN_MTU   48      /* Minimum acceptable MTU is 48 bytes */
 
@@ -477,9 +478,6 @@ typedef struct
     tL2C_CCB        ccb_pool[MAX_L2CAP_CHANNELS];   /* Channel Control Block pool       */
     tL2C_RCB        rcb_pool[MAX_L2CAP_CLIENTS];    /* Registration info pool           */
 
-    tL2C_CCB        *p_free_ccb_first;              /* Pointer to first free CCB        */
-    tL2C_CCB        *p_free_ccb_last;               /* Pointer to last  free CCB        */
-
     UINT8           desire_role;                    /* desire to be master/slave when accepting a connection */
     BOOLEAN         disallow_switch;                /* FALSE, to allow switch at create conn */
     UINT16          num_lm_acl_bufs;                /* # of ACL buffers on controller   */
@@ -572,6 +570,19 @@ L2C_API extern tL2C_CB *l2c_cb_ptr;
 #define l2cb (*l2c_cb_ptr)
 #endif
 
+/* Allocators of lcb_pool and ccb_pool. They live outside l2cb, which is
+** cleared on every init, so their bookkeeping is reused rather than leaked.
+** LCBs are also mapped by HCI handle.
+*/
+extern tSLAB    l2c_lcb_slab;
+extern tSLAB    l2c_ccb_slab;
+
+/* How many LCBs and CCBs may be in use at once, at most MAX_L2CAP_LINKS and
+** MAX_L2CAP_CHANNELS. Set from the stack configuration before l2c_init.
+*/
+extern UINT16   l2c_max_links;
+extern UINT16   l2c_max_channels;
+
 
 /* Functions provided by l2c_main.c
 ************************************
@@ -590,6 +601,7 @@ extern BOOLEAN  l2cu_start_post_bond_timer (UINT16 handle);
 extern void     l2cu_release_lcb (tL2C_LCB *p_lcb);
 extern tL2C_LCB *l2cu_find_lcb_by_bd_addr (BD_ADDR p_bd_addr, tBT_TRANSPORT transport);
 extern tL2C_LCB *l2cu_find_lcb_by_handle (UINT16 handle);
+extern void     l2cu_set_lcb_handle (tL2C_LCB *p_lcb, UINT16 handle);
 extern void     l2cu_update_lcb_4_bonding (BD_ADDR p_bd_addr, BOOLEAN is_bonding);
 
 extern UINT8    l2cu_get_conn_role (tL2C_LCB *p_this_lcb);
@@ -38,6 +38,7 @@
 #include "btu.h"
 #include "btm_api.h"
 #include "btm_int.h"
+#include "interop.h"
 
 static BOOLEAN l2c_link_send_to_lower (tL2C_LCB *p_lcb, BT_HDR *p_buf);
 
@@ -47,37 +48,19 @@ static BOOLEAN l2c_link_send_to_lower (tL2C_LCB *p_lcb, BT_HDR *p_buf);
 #define L2C_LINK_SEND_BLE_ACL_DATA(x)  HCI_BLE_ACL_DATA_TO_LOWER((x))
 #endif
 
-/* Black listed car kits/headsets for role switch */
-static const UINT8 hci_role_switch_black_list_prefix[][3] = {{0x00, 0x26, 0xb4}, /* NAC FORD,2013 Lincoln */
-                                                             {0x00, 0x26, 0xe8}, /* Nissan Murano */
-                                                             {0x00, 0x37, 0x6d}, /* Lexus ES300h */
-                                                             {0x9c, 0x3a, 0xaf}  /* SAMSUNG HM1900 */
-                                                            };
-
 /*******************************************************************************
 **
 ** Function         hci_blacklistted_for_role_switch
 **
 ** Description      This function is called to find the blacklisted carkits
-**                  for role switch.
+**                  for role switch. The list lives in the interop database.
 **
 ** Returns          TRUE, if black listed
 **
 *******************************************************************************/
 BOOLEAN hci_blacklistted_for_role_switch (BD_ADDR addr)
 {
-    int blacklistsize = 0;
-    int i =0;
-
-    blacklistsize = sizeof(hci_role_switch_black_list_prefix)/sizeof(hci_role_switch_black_list_prefix[0]);
-    for (i=0; i < blacklistsize; i++)
-    {
-        if (0 == memcmp(hci_role_switch_black_list_prefix[i], addr, 3))
-        {
-            return TRUE;
-        }
-    }
-    return FALSE;
+    return interop_match_addr(INTEROP_ACCEPT_CONN_AS_SLAVE, addr);
 }
 
 #define HI_PRI_LINK_QUOTA 2 //Mininum ACL buffer quota for high priority link
@@ -228,7 +211,7 @@ BOOLEAN l2c_link_hci_conn_comp (UINT8 status, UINT16 handle, BD_ADDR p_bda)
     }
 
     /* Save the handle */
-    p_lcb->handle = handle;
+    l2cu_set_lcb_handle (p_lcb, handle);
 
     if (ci.status == HCI_SUCCESS)
     {
@@ -281,7 +264,7 @@ BOOLEAN l2c_link_hci_conn_comp (UINT8 status, UINT16 handle, BD_ADDR p_bda)
     else if ((ci.status == HCI_ERR_MAX_NUM_OF_CONNECTIONS) && l2cu_lcb_disconnecting())
     {
         p_lcb->link_state = LST_CONNECT_HOLDING;
-        p_lcb->handle = HCI_INVALID_HANDLE;
+        l2cu_set_lcb_handle (p_lcb, HCI_INVALID_HANDLE);
     }
     else
     {
@@ -474,8 +457,18 @@ BOOLEAN l2c_link_hci_disc_comp (UINT16 handle, UINT8 reason)
             if (p_lcb->transport == BT_TRANSPORT_LE)
             {
                 l2cu_release_lcb (p_lcb);
-                p_lcb->in_use = TRUE;
-                transport = BT_TRANSPORT_LE;
+
+                /* a fixed channel callback of the release may have used the block up */
+                if (SLAB_TAKE (&l2c_lcb_slab, tL2C_LCB, slab_index (&l2c_lcb_slab, p_lcb)) == NULL)
+                {
+                    L2CAP_TRACE_ERROR ("l2c_link_hci_disc_comp: LCB taken, LE reconnect dropped");
+                    p_lcb = NULL;
+                }
+                else
+                {
+                    p_lcb->in_use = TRUE;
+                    transport = BT_TRANSPORT_LE;
+                }
             }
             else
 #endif
@@ -502,15 +495,19 @@ BOOLEAN l2c_link_hci_disc_comp (UINT16 handle, UINT8 reason)
           }
 #endif
         }
-            if (l2cu_create_conn(p_lcb, transport))
+            if (p_lcb != NULL && l2cu_create_conn(p_lcb, transport))
                 lcb_is_free = FALSE; /* still using this lcb */
         }
 
-        p_lcb->p_pending_ccb = NULL;
+        /* NULL if the LCB was already released and may belong to another link */
+        if (p_lcb != NULL)
+        {
+            p_lcb->p_pending_ccb = NULL;
 
-        /* Release the LCB */
-        if (lcb_is_free)
-            l2cu_release_lcb (p_lcb);
+            /* Release the LCB */
+            if (lcb_is_free)
+                l2cu_release_lcb (p_lcb);
+        }
     }
 
     /* Now that we have a free acl connection, see if any lcbs are pending */
@@ -47,6 +47,11 @@ static void process_l2cap_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len);
 tL2C_CB l2cb;
 #endif
 
+tSLAB   l2c_lcb_slab;
+tSLAB   l2c_ccb_slab;
+UINT16  l2c_max_links    = MAX_L2CAP_LINKS;
+UINT16  l2c_max_channels = MAX_L2CAP_CHANNELS;
+
 /* Temporary - until l2cap implements group management */
 #if (TCS_BCST_SETUP_INCLUDED == TRUE && TCS_INCLUDED == TRUE)
 extern void tcs_proc_bcst_msg( BD_ADDR addr, BT_HDR *p_msg ) ;
@@ -878,27 +883,16 @@ void l2c_process_held_packets (BOOLEAN timed_out)
 *******************************************************************************/
 void l2c_init (void)
 {
-    INT16  xx;
-
     memset (&l2cb, 0, sizeof (tL2C_CB));
     /* the psm is increased by 2 before being used */
     l2cb.dyn_psm = 0xFFF;
 
-    /* Put all the channel control blocks on the free queue */
-    for (xx = 0; xx < MAX_L2CAP_CHANNELS - 1; xx++)
-    {
-        l2cb.ccb_pool[xx].p_next_ccb = &l2cb.ccb_pool[xx + 1];
-    }
-
 #if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
     /* it will be set to L2CAP_PKT_START_NON_FLUSHABLE if controller supports */
     l2cb.non_flushable_pbf = L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT;
 #endif
 
 
-    l2cb.p_free_ccb_first = &l2cb.ccb_pool[0];
-    l2cb.p_free_ccb_last  = &l2cb.ccb_pool[MAX_L2CAP_CHANNELS - 1];
-
 #ifdef L2CAP_DESIRED_LINK_ROLE
     l2cb.desire_role      = L2CAP_DESIRED_LINK_ROLE;
 #else
@@ -924,6 +918,14 @@ void l2c_init (void)
     l2cb.high_pri_min_xmit_quota = L2CAP_HIGH_PRI_MIN_XMIT_QUOTA;
 #endif
 
+    /* Put all the link and channel control blocks on the free lists */
+    if (!slab_init (&l2c_lcb_slab, l2cb.lcb_pool, sizeof (tL2C_LCB), MAX_L2CAP_LINKS,
+                    l2c_max_links, TRUE)
+     || !slab_init (&l2c_ccb_slab, l2cb.ccb_pool, sizeof (tL2C_CCB), MAX_L2CAP_CHANNELS,
+                    l2c_max_channels, FALSE))
+    {
+        L2CAP_TRACE_ERROR ("l2c_init: unable to set up the control block pools");
+    }
 }
 
 /*******************************************************************************
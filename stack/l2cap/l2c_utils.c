@@ -43,53 +43,47 @@
 **
 ** Function         l2cu_allocate_lcb
 **
-** Description      Look for an unused LCB
+** Description      Take an unused LCB off the free list
 **
 ** Returns          LCB address or NULL if none found
 **
 *******************************************************************************/
 tL2C_LCB *l2cu_allocate_lcb (BD_ADDR p_bd_addr, BOOLEAN is_bonding, tBT_TRANSPORT transport)
 {
-    int         xx;
-    tL2C_LCB    *p_lcb = &l2cb.lcb_pool[0];
+    tL2C_LCB    *p_lcb = SLAB_ALLOC (&l2c_lcb_slab, tL2C_LCB);
 
-    for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++)
-    {
-        if (!p_lcb->in_use)
-        {
-            memset (p_lcb, 0, sizeof (tL2C_LCB));
+    /* If no free LCB found */
+    if (p_lcb == NULL)
+        return (NULL);
+
+    memset (p_lcb, 0, sizeof (tL2C_LCB));
 
-            memcpy (p_lcb->remote_bd_addr, p_bd_addr, BD_ADDR_LEN);
+    memcpy (p_lcb->remote_bd_addr, p_bd_addr, BD_ADDR_LEN);
 
-            p_lcb->in_use          = TRUE;
-            p_lcb->link_state      = LST_DISCONNECTED;
-            p_lcb->handle          = HCI_INVALID_HANDLE;
-            p_lcb->link_flush_tout = 0xFFFF;
-            p_lcb->timer_entry.param = (TIMER_PARAM_TYPE)p_lcb;
-            p_lcb->info_timer_entry.param = (TIMER_PARAM_TYPE)p_lcb;
-            p_lcb->idle_timeout    = l2cb.idle_timeout;
-            p_lcb->id              = 1;                     /* spec does not allow '0' */
-            p_lcb->is_bonding      = is_bonding;
+    p_lcb->in_use          = TRUE;
+    p_lcb->link_state      = LST_DISCONNECTED;
+    p_lcb->handle          = HCI_INVALID_HANDLE;
+    p_lcb->link_flush_tout = 0xFFFF;
+    p_lcb->timer_entry.param = (TIMER_PARAM_TYPE)p_lcb;
+    p_lcb->info_timer_entry.param = (TIMER_PARAM_TYPE)p_lcb;
+    p_lcb->idle_timeout    = l2cb.idle_timeout;
+    p_lcb->id              = 1;                     /* spec does not allow '0' */
+    p_lcb->is_bonding      = is_bonding;
 #if (BLE_INCLUDED == TRUE)
-            p_lcb->transport       = transport;
+    p_lcb->transport       = transport;
 
-            if (transport == BT_TRANSPORT_LE)
-            {
-                l2cb.num_ble_links_active++;
-                l2c_ble_link_adjust_allocation();
-            }
-            else
+    if (transport == BT_TRANSPORT_LE)
+    {
+        l2cb.num_ble_links_active++;
+        l2c_ble_link_adjust_allocation();
+    }
+    else
 #endif
-            {
-                l2cb.num_links_active++;
-                l2c_link_adjust_allocation();
-            }
-            return (p_lcb);
-        }
+    {
+        l2cb.num_links_active++;
+        l2c_link_adjust_allocation();
     }
-
-    /* If here, no free LCB found */
-    return (NULL);
+    return (p_lcb);
 }
 
 /*******************************************************************************
@@ -132,6 +126,9 @@ void l2cu_release_lcb (tL2C_LCB *p_lcb)
     p_lcb->in_use     = FALSE;
     p_lcb->is_bonding = FALSE;
 
+    /* Back on the free list; the handle no longer finds it */
+    slab_free (&l2c_lcb_slab, p_lcb);
+
     /* Stop timers */
     btu_stop_timer (&p_lcb->timer_entry);
     btu_stop_timer (&p_lcb->info_timer_entry);
@@ -1474,47 +1471,19 @@ void l2cu_change_pri_ccb (tL2C_CCB *p_ccb, tL2CAP_CHNL_PRIORITY priority)
 tL2C_CCB *l2cu_allocate_ccb (tL2C_LCB *p_lcb, UINT16 cid)
 {
     tL2C_CCB    *p_ccb;
-    tL2C_CCB    *p_prev;
 
     L2CAP_TRACE_DEBUG ("l2cu_allocate_ccb: cid 0x%04x", cid);
 
-    if (!l2cb.p_free_ccb_first)
-        return (NULL);
-
     /* If a CID was passed in, use that, else take the first free one */
     if (cid == 0)
     {
-        p_ccb = l2cb.p_free_ccb_first;
-        l2cb.p_free_ccb_first = p_ccb->p_next_ccb;
+        if ((p_ccb = SLAB_ALLOC (&l2c_ccb_slab, tL2C_CCB)) == NULL)
+            return (NULL);
     }
-    else
+    else if ((p_ccb = SLAB_TAKE (&l2c_ccb_slab, tL2C_CCB, cid - L2CAP_BASE_APPL_CID)) == NULL)
     {
-        p_prev = NULL;
-
-        p_ccb = &l2cb.ccb_pool[cid - L2CAP_BASE_APPL_CID];
-
-        if (p_ccb == l2cb.p_free_ccb_first)
-            l2cb.p_free_ccb_first = p_ccb->p_next_ccb;
-        else
-        {
-            for (p_prev = l2cb.p_free_ccb_first; p_prev != NULL; p_prev = p_prev->p_next_ccb)
-            {
-                if (p_prev->p_next_ccb == p_ccb)
-                {
-                    p_prev->p_next_ccb = p_ccb->p_next_ccb;
-
-                    if (p_ccb == l2cb.p_free_ccb_last)
-                        l2cb.p_free_ccb_last = p_prev;
-
-                    break;
-                }
-            }
-            if (p_prev == NULL)
-            {
-                L2CAP_TRACE_ERROR ("l2cu_allocate_ccb: could not find CCB for CID 0x%04x in the free list", cid);
-                return NULL;
-            }
-        }
+        L2CAP_TRACE_ERROR ("l2cu_allocate_ccb: could not find CCB for CID 0x%04x in the free list", cid);
+        return NULL;
     }
 
     p_ccb->p_next_ccb = p_ccb->p_prev_ccb = NULL;
@@ -1718,20 +1687,9 @@ void l2cu_release_ccb (tL2C_CCB *p_ccb)
     }
 
     /* Put the CCB back on the free pool */
-    if (!l2cb.p_free_ccb_first)
-    {
-        l2cb.p_free_ccb_first = p_ccb;
-        l2cb.p_free_ccb_last  = p_ccb;
-        p_ccb->p_next_ccb     = NULL;
-        p_ccb->p_prev_ccb     = NULL;
-    }
-    else
-    {
-        p_ccb->p_next_ccb  = NULL;
-        p_ccb->p_prev_ccb  = l2cb.p_free_ccb_last;
-        l2cb.p_free_ccb_last->p_next_ccb = p_ccb;
-        l2cb.p_free_ccb_last  = p_ccb;
-    }
+    p_ccb->p_next_ccb = NULL;
+    p_ccb->p_prev_ccb = NULL;
+    slab_free (&l2c_ccb_slab, p_ccb);
 
     /* Flag as not in use */
     p_ccb->in_use = FALSE;
@@ -3007,29 +2965,44 @@ void l2cu_send_peer_ble_par_rsp (tL2C_LCB *p_lcb, UINT16 reason, UINT8 rem_id)
 **
 ** Function         l2cu_find_lcb_by_handle
 **
-** Description      Look through all active LCBs for a match based on the
-**                  HCI handle.
+** Description      Look up the active LCB with the HCI handle. This is on
+**                  the path of every received ACL packet, so LCBs are mapped
+**                  by handle when it is set (see l2cu_set_lcb_handle).
 **
 ** Returns          pointer to matched LCB, or NULL if no match
 **
 *******************************************************************************/
 tL2C_LCB  *l2cu_find_lcb_by_handle (UINT16 handle)
 {
-    int         xx;
-    tL2C_LCB    *p_lcb = &l2cb.lcb_pool[0];
+    tL2C_LCB    *p_lcb = SLAB_FIND (&l2c_lcb_slab, tL2C_LCB, handle);
 
-    for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++)
-    {
-        if ((p_lcb->in_use) && (p_lcb->handle == handle))
-        {
-            return (p_lcb);
-        }
-    }
+    if ((p_lcb) && (p_lcb->in_use) && (p_lcb->handle == handle))
+        return (p_lcb);
 
     /* If here, no match found */
     return (NULL);
 }
 
+/*******************************************************************************
+**
+** Function         l2cu_set_lcb_handle
+**
+** Description      Set the HCI handle of an LCB and map the LCB by it.
+**                  HCI_INVALID_HANDLE unmaps it.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cu_set_lcb_handle (tL2C_LCB *p_lcb, UINT16 handle)
+{
+    p_lcb->handle = handle;
+
+    if (handle == HCI_INVALID_HANDLE)
+        slab_map_clear (&l2c_lcb_slab, p_lcb);
+    else
+        slab_map_set (&l2c_lcb_slab, p_lcb, handle);
+}
+
 /*******************************************************************************
 **
 ** Function         l2cu_find_ccb_by_cid
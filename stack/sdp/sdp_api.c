@@ -186,6 +186,12 @@ BOOLEAN SDP_ServiceSearchAttributeRequest (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *
 #if SDP_CLIENT_ENABLED == TRUE
     tCONN_CB     *p_ccb;
 
+#if (SDP_CACHE_INCLUDED == TRUE)
+    /* Answer from the cache if this search was done before */
+    if (sdp_cache_start_search (p_bd_addr, p_db, p_cb, NULL, NULL))
+        return(TRUE);
+#endif
+
     /* Specific BD address */
     p_ccb = sdp_conn_originate (p_bd_addr);
 
@@ -223,6 +229,12 @@ BOOLEAN SDP_ServiceSearchAttributeRequest2 (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB
 #if SDP_CLIENT_ENABLED == TRUE
     tCONN_CB     *p_ccb;
 
+#if (SDP_CACHE_INCLUDED == TRUE)
+    /* Answer from the cache if this search was done before */
+    if (sdp_cache_start_search (p_bd_addr, p_db, NULL, p_cb2, user_data))
+        return(TRUE);
+#endif
+
     /* Specific BD address */
     p_ccb = sdp_conn_originate (p_bd_addr);
 
@@ -0,0 +1,758 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the SDP record cache. The complete attribute lists
+ *  returned by a ServiceSearchAttribute transaction are kept per remote
+ *  device and per search, so that a repeat of the same search can be
+ *  answered without opening an SDP channel. Cached results are persisted
+ *  through storage callbacks registered by the application layer, and are
+ *  dropped when their lifetime expires or when the services advertised in
+ *  the EIR of the device change. Only bonded devices are cached, so that
+ *  inquiry results of passing devices cost no storage access.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include <time.h>
+
+#include "bt_target.h"
+#include "gki.h"
+#include "bt_types.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+#include "btu.h"
+#include "btm_api.h"
+#include "bt_utils.h"
+
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+
+/* Layout of a persisted device blob:
+**   UINT8  version
+**   UINT32 EIR signature
+**   UINT8  number of entries
+**   per entry: UINT32 search key, UINT32 store time, UINT16 length, data
+*/
+#define SDP_CACHE_BLOB_VERSION      1
+#define SDP_CACHE_BLOB_HDR_LEN      6
+#define SDP_CACHE_ENTRY_HDR_LEN     10
+
+/* Largest blob kept per device, so that it fits in one GKI buffer */
+#define SDP_CACHE_MAX_BLOB_LEN      8000
+
+#define SDP_CACHE_FNV_OFFSET        0x811C9DC5
+#define SDP_CACHE_FNV_PRIME         0x01000193
+
+typedef struct
+{
+    UINT32          key;            /* hash of the UUID and attribute filters */
+    UINT32          store_time;     /* seconds since the epoch */
+    UINT16          len;
+    UINT8           *p_data;        /* GKI buffer holding the attribute lists */
+} tSDP_CACHE_ENTRY;
+
+typedef struct
+{
+    BOOLEAN             in_use;
+    BD_ADDR             bd_addr;
+    UINT32              eir_sig;    /* signature of the EIR UUIDs, 0 if unknown */
+    UINT32              last_used;
+    UINT8               num_entries;
+    tSDP_CACHE_ENTRY    entry[SDP_CACHE_MAX_ENTRIES];
+} tSDP_CACHE_DEV;
+
+typedef struct
+{
+    tSDP_CACHE_DEV      dev[SDP_CACHE_MAX_DEVICES];
+    tSDP_CACHE_STORAGE  storage;
+    tSDP_CACHE_STATS    stats;
+    UINT32              ttl;
+    UINT32              use_count;
+} tSDP_CACHE_CB;
+
+static tSDP_CACHE_CB sdp_cache_cb;
+
+/*******************************************************************************
+**
+** Function         sdp_cache_hash
+**
+** Description      This function adds a byte string to an FNV-1a hash.
+**
+** Returns          the updated hash
+**
+*******************************************************************************/
+static UINT32 sdp_cache_hash (UINT32 hash, UINT8 *p, UINT16 len)
+{
+    while (len--)
+    {
+        hash ^= *p++;
+        hash *= SDP_CACHE_FNV_PRIME;
+    }
+    return (hash);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_search_key
+**
+** Description      This function computes the key identifying a search from
+**                  the UUID and attribute filters of its discovery database.
+**
+** Returns          the search key
+**
+*******************************************************************************/
+static UINT32 sdp_cache_search_key (tSDP_DISCOVERY_DB *p_db)
+{
+    UINT32  hash = SDP_CACHE_FNV_OFFSET;
+    UINT16  xx;
+
+    for (xx = 0; xx < p_db->num_uuid_filters; xx++)
+    {
+        hash = sdp_cache_hash (hash, (UINT8 *)&p_db->uuid_filters[xx].len, sizeof (UINT16));
+        hash = sdp_cache_hash (hash, (UINT8 *)&p_db->uuid_filters[xx].uu,
+                               p_db->uuid_filters[xx].len);
+    }
+
+    /* Separate the two lists so that they can not alias each other */
+    hash = sdp_cache_hash (hash, (UINT8 *)&p_db->num_attr_filters, sizeof (UINT16));
+    hash = sdp_cache_hash (hash, (UINT8 *)p_db->attr_filters,
+                           (UINT16)(p_db->num_attr_filters * sizeof (UINT16)));
+    return (hash);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_now
+**
+** Description      This function returns the wall clock time used to age
+**                  cached results, which must survive a restart.
+**
+** Returns          seconds since the epoch
+**
+*******************************************************************************/
+static UINT32 sdp_cache_now (void)
+{
+    return ((UINT32)time (NULL));
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_is_bonded
+**
+** Description      This function checks whether the results of a device may
+**                  be cached, which is only done for bonded devices.
+**
+** Returns          TRUE if a link key is known for the device
+**
+*******************************************************************************/
+static BOOLEAN sdp_cache_is_bonded (BD_ADDR bd_addr)
+{
+    LINK_KEY    link_key;
+
+    return (BTM_SecGetDeviceLinkKey (bd_addr, link_key) == BTM_SUCCESS);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_remove_entry
+**
+** Description      This function frees a cached result and compacts the
+**                  entry table of the device.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_remove_entry (tSDP_CACHE_DEV *p_dev, UINT8 idx)
+{
+    GKI_freebuf (p_dev->entry[idx].p_data);
+
+    p_dev->num_entries--;
+    if (idx < p_dev->num_entries)
+        memmove (&p_dev->entry[idx], &p_dev->entry[idx + 1],
+                 (p_dev->num_entries - idx) * sizeof (tSDP_CACHE_ENTRY));
+
+    memset (&p_dev->entry[p_dev->num_entries], 0, sizeof (tSDP_CACHE_ENTRY));
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_release_dev
+**
+** Description      This function drops the in memory copy of a device. The
+**                  persisted copy is not affected.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_release_dev (tSDP_CACHE_DEV *p_dev)
+{
+    while (p_dev->num_entries)
+        sdp_cache_remove_entry (p_dev, (UINT8)(p_dev->num_entries - 1));
+
+    memset (p_dev, 0, sizeof (tSDP_CACHE_DEV));
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_save
+**
+** Description      This function writes the cached results of a device to
+**                  the registered persistent storage.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_save (tSDP_CACHE_DEV *p_dev)
+{
+    UINT8   *p_buf, *p;
+    UINT16  len = SDP_CACHE_BLOB_HDR_LEN;
+    UINT8   xx;
+
+    if (!sdp_cache_cb.storage.p_store)
+        return;
+
+    if (p_dev->num_entries == 0 && p_dev->eir_sig == 0)
+    {
+        (*sdp_cache_cb.storage.p_store) (p_dev->bd_addr, NULL, 0);
+        return;
+    }
+
+    for (xx = 0; xx < p_dev->num_entries; xx++)
+        len += SDP_CACHE_ENTRY_HDR_LEN + p_dev->entry[xx].len;
+
+    if ((p_buf = (UINT8 *)GKI_getbuf (len)) == NULL)
+    {
+        SDP_TRACE_WARNING ("SDP cache - no buffer to save %d bytes", len);
+        return;
+    }
+
+    p = p_buf;
+    UINT8_TO_STREAM  (p, SDP_CACHE_BLOB_VERSION);
+    UINT32_TO_STREAM (p, p_dev->eir_sig);
+    UINT8_TO_STREAM  (p, p_dev->num_entries);
+
+    for (xx = 0; xx < p_dev->num_entries; xx++)
+    {
+        UINT32_TO_STREAM (p, p_dev->entry[xx].key);
+        UINT32_TO_STREAM (p, p_dev->entry[xx].store_time);
+        UINT16_TO_STREAM (p, p_dev->entry[xx].len);
+        ARRAY_TO_STREAM  (p, p_dev->entry[xx].p_data, p_dev->entry[xx].len);
+    }
+
+    (*sdp_cache_cb.storage.p_store) (p_dev->bd_addr, p_buf, len);
+
+    GKI_freebuf (p_buf);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_load
+**
+** Description      This function reads the persisted results of a device
+**                  into an in memory device entry.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_load (tSDP_CACHE_DEV *p_dev)
+{
+    UINT8               *p_buf, *p, *p_end;
+    UINT16              len = SDP_CACHE_MAX_BLOB_LEN;
+    UINT8               version, num_entries, xx;
+    tSDP_CACHE_ENTRY    *p_entry;
+
+    if (!sdp_cache_cb.storage.p_load)
+        return;
+
+    if ((p_buf = (UINT8 *)GKI_getbuf (len)) == NULL)
+        return;
+
+    if (!(*sdp_cache_cb.storage.p_load) (p_dev->bd_addr, p_buf, &len)
+        || len < SDP_CACHE_BLOB_HDR_LEN)
+    {
+        GKI_freebuf (p_buf);
+        return;
+    }
+
+    p = p_buf;
+    p_end = p_buf + len;
+    STREAM_TO_UINT8  (version, p);
+    STREAM_TO_UINT32 (p_dev->eir_sig, p);
+    STREAM_TO_UINT8  (num_entries, p);
+
+    if (version != SDP_CACHE_BLOB_VERSION)
+        num_entries = 0;
+
+    for (xx = 0; xx < num_entries && xx < SDP_CACHE_MAX_ENTRIES; xx++)
+    {
+        if (p + SDP_CACHE_ENTRY_HDR_LEN > p_end)
+            break;
+
+        p_entry = &p_dev->entry[p_dev->num_entries];
+        STREAM_TO_UINT32 (p_entry->key, p);
+        STREAM_TO_UINT32 (p_entry->store_time, p);
+        STREAM_TO_UINT16 (p_entry->len, p);
+
+        if (p_entry->len == 0 || p_entry->len > SDP_MAX_LIST_BYTE_COUNT
+            || p + p_entry->len > p_end
+            || (p_entry->p_data = (UINT8 *)GKI_getbuf (p_entry->len)) == NULL)
+        {
+            memset (p_entry, 0, sizeof (tSDP_CACHE_ENTRY));
+            break;
+        }
+
+        STREAM_TO_ARRAY (p_entry->p_data, p, p_entry->len);
+        p_dev->num_entries++;
+    }
+
+    GKI_freebuf (p_buf);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_find_dev
+**
+** Description      This function finds the cache entry of a device, loading
+**                  it from persistent storage if it is not in memory. The
+**                  least recently used device is evicted from memory to make
+**                  room, but only once the device is known to have data or
+**                  create is TRUE, so that looking up unknown devices during
+**                  inquiry does not flush the cache. Devices that are not
+**                  bonded are never looked up in storage.
+**
+** Returns          pointer to the device entry, or NULL if the device is not
+**                  bonded, or has no cached data and create is FALSE
+**
+*******************************************************************************/
+static tSDP_CACHE_DEV *sdp_cache_find_dev (BD_ADDR bd_addr, BOOLEAN create)
+{
+    tSDP_CACHE_DEV  *p_dev, *p_lru = NULL;
+    tSDP_CACHE_DEV  loaded;
+    UINT8           xx;
+
+    if (!sdp_cache_is_bonded (bd_addr))
+        return (NULL);
+
+    for (xx = 0, p_dev = sdp_cache_cb.dev; xx < SDP_CACHE_MAX_DEVICES; xx++, p_dev++)
+    {
+        if (p_dev->in_use && !memcmp (p_dev->bd_addr, bd_addr, BD_ADDR_LEN))
+        {
+            p_dev->last_used = ++sdp_cache_cb.use_count;
+            return (p_dev);
+        }
+
+        if (!p_lru || !p_dev->in_use
+            || (p_lru->in_use && p_dev->last_used < p_lru->last_used))
+            p_lru = p_dev;
+    }
+
+    memset (&loaded, 0, sizeof (tSDP_CACHE_DEV));
+    loaded.in_use = TRUE;
+    memcpy (loaded.bd_addr, bd_addr, BD_ADDR_LEN);
+
+    sdp_cache_load (&loaded);
+
+    if (!create && loaded.num_entries == 0 && loaded.eir_sig == 0)
+        return (NULL);
+
+    if (p_lru->in_use)
+        sdp_cache_release_dev (p_lru);
+
+    *p_lru = loaded;
+    p_lru->last_used = ++sdp_cache_cb.use_count;
+    return (p_lru);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_find_entry
+**
+** Description      This function finds the cached result of a search.
+**
+** Returns          index of the entry, or SDP_CACHE_MAX_ENTRIES if not found
+**
+*******************************************************************************/
+static UINT8 sdp_cache_find_entry (tSDP_CACHE_DEV *p_dev, UINT32 key)
+{
+    UINT8   xx;
+
+    for (xx = 0; xx < p_dev->num_entries; xx++)
+    {
+        if (p_dev->entry[xx].key == key)
+            return (xx);
+    }
+    return (SDP_CACHE_MAX_ENTRIES);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_init
+**
+** Description      This function initializes the SDP record cache.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_cache_init (void)
+{
+    tSDP_CACHE_STORAGE  storage = sdp_cache_cb.storage;
+    UINT8               xx;
+
+    /* Keep any storage registered before the stack was started */
+    for (xx = 0; xx < SDP_CACHE_MAX_DEVICES; xx++)
+    {
+        if (sdp_cache_cb.dev[xx].in_use)
+            sdp_cache_release_dev (&sdp_cache_cb.dev[xx]);
+    }
+
+    memset (&sdp_cache_cb, 0, sizeof (tSDP_CACHE_CB));
+    sdp_cache_cb.storage = storage;
+    sdp_cache_cb.ttl     = SDP_CACHE_TTL;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_start_search
+**
+** Description      This function answers a ServiceSearchAttribute request
+**                  from the cache if a valid result of the same search is
+**                  available. The records are saved into the discovery
+**                  database immediately and the completion callback is
+**                  called from the BTU task on the next quick timer tick,
+**                  as it would be after an over the air search.
+**
+** Returns          TRUE if the search is answered from the cache
+**
+*******************************************************************************/
+BOOLEAN sdp_cache_start_search (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db,
+                                tSDP_DISC_CMPL_CB *p_cb, tSDP_DISC_CMPL_CB2 *p_cb2,
+                                void *user_data)
+{
+    tSDP_CACHE_DEV      *p_dev;
+    tSDP_CACHE_ENTRY    *p_entry;
+    tCONN_CB            *p_ccb;
+    UINT32              key;
+    UINT16              status;
+    UINT8               idx;
+
+    if (sdp_cache_cb.ttl == 0)
+        return (FALSE);
+
+    key = sdp_cache_search_key (p_db);
+
+    if ((p_dev = sdp_cache_find_dev (p_bd_addr, FALSE)) == NULL
+        || (idx = sdp_cache_find_entry (p_dev, key)) == SDP_CACHE_MAX_ENTRIES)
+    {
+        sdp_cache_cb.stats.misses++;
+        return (FALSE);
+    }
+
+    p_entry = &p_dev->entry[idx];
+    if ((UINT32)(sdp_cache_now () - p_entry->store_time) > sdp_cache_cb.ttl)
+    {
+        SDP_TRACE_DEBUG ("SDP cache - result expired, key 0x%08x", key);
+        sdp_cache_remove_entry (p_dev, idx);
+        sdp_cache_save (p_dev);
+        sdp_cache_cb.stats.invalidations++;
+        sdp_cache_cb.stats.misses++;
+        return (FALSE);
+    }
+
+    if ((p_ccb = sdpu_allocate_ccb ()) == NULL)
+    {
+        sdp_cache_cb.stats.misses++;
+        return (FALSE);
+    }
+
+    if ((p_ccb->rsp_list = (UINT8 *)GKI_getbuf (p_entry->len)) == NULL)
+    {
+        sdpu_release_ccb (p_ccb);
+        sdp_cache_cb.stats.misses++;
+        return (FALSE);
+    }
+
+    p_ccb->con_flags      = SDP_FLAGS_IS_ORIG | SDP_FLAGS_CACHED;
+    p_ccb->con_state      = SDP_STATE_CONN_SETUP;
+    p_ccb->disc_state     = SDP_DISC_WAIT_SEARCH_ATTR;
+    p_ccb->is_attr_search = TRUE;
+    p_ccb->p_db           = p_db;
+    p_ccb->p_cb           = p_cb;
+    p_ccb->p_cb2          = p_cb2;
+    p_ccb->user_data      = user_data;
+    memcpy (p_ccb->device_address, p_bd_addr, BD_ADDR_LEN);
+
+    memcpy (p_ccb->rsp_list, p_entry->p_data, p_entry->len);
+    p_ccb->list_len = p_entry->len;
+
+    status = sdp_disc_save_attr_lists (p_ccb);
+    if (status == SDP_ILLEGAL_PARAMETER || status == SDP_INVALID_CONT_STATE)
+    {
+        /* Nothing was saved into the database, search over the air instead */
+        SDP_TRACE_WARNING ("SDP cache - dropping corrupted result, key 0x%08x", key);
+        sdpu_release_ccb (p_ccb);
+        sdp_cache_remove_entry (p_dev, idx);
+        sdp_cache_save (p_dev);
+        sdp_cache_cb.stats.invalidations++;
+        sdp_cache_cb.stats.misses++;
+        return (FALSE);
+    }
+
+    SDP_TRACE_EVENT ("SDP cache - hit, key 0x%08x, %d bytes", key, p_entry->len);
+    sdp_cache_cb.stats.hits++;
+
+    p_ccb->disconnect_reason = status;
+    btu_start_quick_timer (&p_ccb->timer_entry, BTU_TTYPE_SDP, 0);
+
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_search_cmpl
+**
+** Description      This function completes a search answered from the cache.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_cache_search_cmpl (tCONN_CB *p_ccb)
+{
+    if (p_ccb->con_state == SDP_STATE_IDLE)
+        return;
+
+    if (p_ccb->p_cb)
+        (*p_ccb->p_cb) (p_ccb->disconnect_reason);
+    else if (p_ccb->p_cb2)
+        (*p_ccb->p_cb2) (p_ccb->disconnect_reason, p_ccb->user_data);
+
+    sdpu_release_ccb (p_ccb);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_store
+**
+** Description      This function caches the complete response of a
+**                  successful ServiceSearchAttribute transaction.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_cache_store (tCONN_CB *p_ccb)
+{
+    tSDP_CACHE_DEV      *p_dev;
+    tSDP_CACHE_ENTRY    *p_entry;
+    UINT32              key;
+    UINT32              len;
+    UINT8               idx;
+
+    if (sdp_cache_cb.ttl == 0 || p_ccb->list_len == 0
+        || (p_ccb->con_flags & SDP_FLAGS_CACHED))
+        return;
+
+    if (SDP_CACHE_BLOB_HDR_LEN + SDP_CACHE_ENTRY_HDR_LEN + p_ccb->list_len > SDP_CACHE_MAX_BLOB_LEN)
+        return;
+
+    key = sdp_cache_search_key (p_ccb->p_db);
+
+    if ((p_dev = sdp_cache_find_dev (p_ccb->device_address, TRUE)) == NULL)
+        return;
+
+    /* Replace an older result of the same search */
+    if ((idx = sdp_cache_find_entry (p_dev, key)) != SDP_CACHE_MAX_ENTRIES)
+        sdp_cache_remove_entry (p_dev, idx);
+
+    /* Make room by dropping the oldest results */
+    len = SDP_CACHE_BLOB_HDR_LEN + SDP_CACHE_ENTRY_HDR_LEN + p_ccb->list_len;
+    for (idx = 0; idx < p_dev->num_entries; idx++)
+        len += SDP_CACHE_ENTRY_HDR_LEN + p_dev->entry[idx].len;
+
+    while (p_dev->num_entries
+           && (p_dev->num_entries == SDP_CACHE_MAX_ENTRIES || len > SDP_CACHE_MAX_BLOB_LEN))
+    {
+        len -= SDP_CACHE_ENTRY_HDR_LEN + p_dev->entry[0].len;
+        sdp_cache_remove_entry (p_dev, 0);
+    }
+
+    p_entry = &p_dev->entry[p_dev->num_entries];
+    if ((p_entry->p_data = (UINT8 *)GKI_getbuf (p_ccb->list_len)) == NULL)
+        return;
+
+    memcpy (p_entry->p_data, p_ccb->rsp_list, p_ccb->list_len);
+    p_entry->len        = p_ccb->list_len;
+    p_entry->key        = key;
+    p_entry->store_time = sdp_cache_now ();
+    p_dev->num_entries++;
+
+    sdp_cache_cb.stats.stores++;
+    SDP_TRACE_DEBUG ("SDP cache - stored key 0x%08x, %d bytes", key, p_entry->len);
+
+    sdp_cache_save (p_dev);
+}
+
+#endif  /* SDP_CACHE_INCLUDED == TRUE && SDP_CLIENT_ENABLED == TRUE */
+
+/*******************************************************************************
+**
+** Function         SDP_CacheRegisterStorage
+**
+** Description      This function registers the persistent storage used to
+**                  keep cached SDP results across restarts.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SDP_CacheRegisterStorage (tSDP_CACHE_STORAGE *p_storage)
+{
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+    if (p_storage)
+        sdp_cache_cb.storage = *p_storage;
+    else
+        memset (&sdp_cache_cb.storage, 0, sizeof (tSDP_CACHE_STORAGE));
+#else
+    UNUSED(p_storage);
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         SDP_CacheSetTtl
+**
+** Description      This function sets how long, in seconds, a cached SDP
+**                  result is used before the remote device is searched again.
+**                  A value of 0 disables the cache.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SDP_CacheSetTtl (UINT32 ttl)
+{
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+    sdp_cache_cb.ttl = ttl;
+#else
+    UNUSED(ttl);
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         SDP_CacheInvalidate
+**
+** Description      This function drops the cached SDP results of a device,
+**                  or of all devices held in memory if bd_addr is NULL.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SDP_CacheInvalidate (BD_ADDR bd_addr)
+{
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+    tSDP_CACHE_DEV  *p_dev;
+    UINT8           xx;
+
+    for (xx = 0, p_dev = sdp_cache_cb.dev; xx < SDP_CACHE_MAX_DEVICES; xx++, p_dev++)
+    {
+        if (!p_dev->in_use || (bd_addr && memcmp (p_dev->bd_addr, bd_addr, BD_ADDR_LEN)))
+            continue;
+
+        sdp_cache_cb.stats.invalidations += p_dev->num_entries;
+        while (p_dev->num_entries)
+            sdp_cache_remove_entry (p_dev, (UINT8)(p_dev->num_entries - 1));
+        p_dev->eir_sig = 0;
+        sdp_cache_save (p_dev);
+        sdp_cache_release_dev (p_dev);
+
+        if (bd_addr)
+            return;
+    }
+
+    /* Not in memory, only the persisted copy needs removing */
+    if (bd_addr && sdp_cache_cb.storage.p_store)
+        (*sdp_cache_cb.storage.p_store) (bd_addr, NULL, 0);
+#else
+    UNUSED(bd_addr);
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         SDP_CacheEirUpdate
+**
+** Description      This function is called when EIR data has been received
+**                  from a device. Cached results are dropped if the services
+**                  advertised in EIR changed since they were stored.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SDP_CacheEirUpdate (BD_ADDR bd_addr, UINT8 *p_eir_uuid, UINT16 len)
+{
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+    tSDP_CACHE_DEV  *p_dev;
+    UINT32          sig;
+    UINT16          xx;
+
+    /* Devices that do not advertise any UUID tell us nothing */
+    for (xx = 0; xx < len && p_eir_uuid[xx] == 0; xx++)
+        ;
+    if (xx == len || sdp_cache_cb.ttl == 0)
+        return;
+
+    sig = sdp_cache_hash (SDP_CACHE_FNV_OFFSET, p_eir_uuid, len);
+    if (sig == 0)
+        sig = 1;
+
+    if ((p_dev = sdp_cache_find_dev (bd_addr, FALSE)) == NULL || p_dev->eir_sig == sig)
+        return;
+
+    if (p_dev->eir_sig != 0 && p_dev->num_entries)
+    {
+        SDP_TRACE_EVENT ("SDP cache - EIR services changed, dropping %d results",
+                          p_dev->num_entries);
+        sdp_cache_cb.stats.invalidations += p_dev->num_entries;
+        while (p_dev->num_entries)
+            sdp_cache_remove_entry (p_dev, (UINT8)(p_dev->num_entries - 1));
+    }
+
+    p_dev->eir_sig = sig;
+    sdp_cache_save (p_dev);
+#else
+    UNUSED(bd_addr);
+    UNUSED(p_eir_uuid);
+    UNUSED(len);
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         SDP_CacheGetStats
+**
+** Description      This function reads the SDP record cache counters.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SDP_CacheGetStats (tSDP_CACHE_STATS *p_stats)
+{
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+    *p_stats = sdp_cache_cb.stats;
+#else
+    memset (p_stats, 0, sizeof (tSDP_CACHE_STATS));
+#endif
+}
@@ -44,6 +44,8 @@
 /********************************************************************************/
 static BOOLEAN find_uuid_in_seq (UINT8 *p , UINT32 seq_len, UINT8 *p_his_uuid,
                                  UINT16 his_len, int nest_level);
+static void    sdp_db_build_index (void);
+static tSDP_RECORD *sdp_db_index_search (tSDP_RECORD *p_rec, tSDP_UUID_SEQ *p_seq);
 
 
 /*******************************************************************************
@@ -54,6 +56,9 @@ static BOOLEAN find_uuid_in_seq (UINT8 *p , UINT32 seq_len, UINT8 *p_his_uuid,
 **                  specified UIDs. It is passed either NULL to start at the
 **                  beginning, or the previous record found.
 **
+**                  The UUID index is used when it covers the database, else
+**                  the records are walked.
+**
 ** Returns          Pointer to the record, or NULL if not found.
 **
 *******************************************************************************/
@@ -63,6 +68,12 @@ tSDP_RECORD *sdp_db_service_search (tSDP_RECORD *p_rec, tSDP_UUID_SEQ *p_seq)
     tSDP_ATTRIBUTE *p_attr;
     tSDP_RECORD     *p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
 
+    if (sdp_cb.server_db.index_state == SDP_DB_INDEX_STALE)
+        sdp_db_build_index ();
+
+    if (sdp_cb.server_db.index_state == SDP_DB_INDEX_VALID)
+        return (sdp_db_index_search (p_rec, p_seq));
+
     /* If NULL, start at the beginning, else start at the first specified record */
     if (!p_rec)
         p_rec = &sdp_cb.server_db.record[0];
@@ -149,6 +160,259 @@ static BOOLEAN find_uuid_in_seq (UINT8 *p , UINT32 seq_len, UINT8 *p_uuid,
     return (FALSE);
 }
 
+/*******************************************************************************
+**
+** Function         sdp_db_find_index_uuid
+**
+** Description      This function looks up a 128-bit UUID in the UUID index.
+**
+** Returns          TRUE if found. *p_inx is the entry, or the position where
+**                  the UUID would be inserted if not found.
+**
+*******************************************************************************/
+static BOOLEAN sdp_db_find_index_uuid (UINT8 *p_uuid128, UINT16 *p_inx)
+{
+    tSDP_DB     *p_db = &sdp_cb.server_db;
+    UINT16      lo = 0, hi = p_db->num_index_uuids, mid;
+    int         cmp;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        cmp = memcmp (p_uuid128, p_db->uuid_index[mid].uuid, MAX_UUID_SIZE);
+
+        if (cmp == 0)
+        {
+            *p_inx = mid;
+            return (TRUE);
+        }
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    *p_inx = lo;
+    return (FALSE);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_index_uuid
+**
+** Description      This function adds a UUID found in a record to the UUID
+**                  index.
+**
+** Returns          FALSE if the index is full, else TRUE
+**
+*******************************************************************************/
+static BOOLEAN sdp_db_index_uuid (UINT8 *p_uuid, UINT32 uuid_len, UINT16 rec_inx)
+{
+    tSDP_DB         *p_db = &sdp_cb.server_db;
+    tSDP_UUID_INDEX *p_entry;
+    UINT8           uuid128[MAX_UUID_SIZE];
+    UINT16          inx;
+
+    /* A malformed UUID never matches a search, so it is simply left out */
+    if (!sdpu_uuid_to_uuid128 (p_uuid, uuid_len, uuid128))
+        return (TRUE);
+
+    if (!sdp_db_find_index_uuid (uuid128, &inx))
+    {
+        if (p_db->num_index_uuids == SDP_MAX_UUID_INDEX)
+            return (FALSE);
+
+        memmove (&p_db->uuid_index[inx + 1], &p_db->uuid_index[inx],
+                 (p_db->num_index_uuids - inx) * sizeof (tSDP_UUID_INDEX));
+        p_db->num_index_uuids++;
+
+        p_entry = &p_db->uuid_index[inx];
+        memcpy (p_entry->uuid, uuid128, MAX_UUID_SIZE);
+        memset (p_entry->rec_mask, 0, sizeof (p_entry->rec_mask));
+    }
+
+    p_db->uuid_index[inx].rec_mask[rec_inx / 32] |= (UINT32)1 << (rec_inx % 32);
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_index_seq
+**
+** Description      This function adds the UUIDs of a data element sequence to
+**                  the UUID index. It nests like find_uuid_in_seq, so the index
+**                  matches exactly what a record walk would.
+**
+** Returns          FALSE if the index is full, else TRUE
+**
+*******************************************************************************/
+static BOOLEAN sdp_db_index_seq (UINT8 *p, UINT32 seq_len, UINT16 rec_inx, int nest_level)
+{
+    UINT8   *p_end = p + seq_len;
+    UINT8   type;
+    UINT32  len;
+
+    if (nest_level > 3)
+        return (TRUE);
+
+    while (p < p_end)
+    {
+        type = *p++;
+        p = sdpu_get_len_from_type (p, type, &len);
+        type = type >> 3;
+        if (type == UUID_DESC_TYPE)
+        {
+            if (!sdp_db_index_uuid (p, len, rec_inx))
+                return (FALSE);
+        }
+        else if (type == DATA_ELE_SEQ_DESC_TYPE)
+        {
+            if (!sdp_db_index_seq (p, len, rec_inx, nest_level + 1))
+                return (FALSE);
+        }
+        p = p + len;
+    }
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_build_index
+**
+** Description      This function rebuilds the UUID-to-record index after the
+**                  database has changed. If the records hold more distinct
+**                  UUIDs than the index can take, searches walk the records.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_db_build_index (void)
+{
+    tSDP_DB         *p_db = &sdp_cb.server_db;
+    tSDP_RECORD     *p_rec = &p_db->record[0];
+    tSDP_ATTRIBUTE  *p_attr;
+    UINT16          xx, yy;
+    BOOLEAN         ok = TRUE;
+
+    p_db->num_index_uuids = 0;
+
+    for (xx = 0; xx < p_db->num_records && ok; xx++, p_rec++)
+    {
+        p_attr = &p_rec->attribute[0];
+        for (yy = 0; yy < p_rec->num_attributes && ok; yy++, p_attr++)
+        {
+            if (p_attr->type == UUID_DESC_TYPE)
+                ok = sdp_db_index_uuid (p_attr->value_ptr, p_attr->len, xx);
+            else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE)
+                ok = sdp_db_index_seq (p_attr->value_ptr, p_attr->len, xx, 0);
+        }
+    }
+
+    if (ok)
+        p_db->index_state = SDP_DB_INDEX_VALID;
+    else
+    {
+        SDP_TRACE_WARNING ("SDP UUID index full (%d), searching records", SDP_MAX_UUID_INDEX);
+        p_db->index_state = SDP_DB_INDEX_OVERFLOW;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_index_search
+**
+** Description      This function finds the next record containing all the
+**                  specified UUIDs using the UUID index.
+**
+** Returns          Pointer to the record, or NULL if not found.
+**
+*******************************************************************************/
+static tSDP_RECORD *sdp_db_index_search (tSDP_RECORD *p_rec, tSDP_UUID_SEQ *p_seq)
+{
+    tSDP_DB     *p_db = &sdp_cb.server_db;
+    UINT32      rec_mask[SDP_DB_REC_MASK_WORDS];
+    UINT8       uuid128[MAX_UUID_SIZE];
+    UINT16      xx, yy, inx;
+
+    /* A record matches if it contains all the passed UUIDs */
+    memset (rec_mask, 0xFF, sizeof (rec_mask));
+    for (yy = 0; yy < p_seq->num_uids; yy++)
+    {
+        if (!sdpu_uuid_to_uuid128 (p_seq->uuid_entry[yy].value, p_seq->uuid_entry[yy].len, uuid128)
+         || !sdp_db_find_index_uuid (uuid128, &inx))
+            return (NULL);
+
+        for (xx = 0; xx < SDP_DB_REC_MASK_WORDS; xx++)
+            rec_mask[xx] &= p_db->uuid_index[inx].rec_mask[xx];
+    }
+
+    /* If NULL, start at the beginning, else after the previous record */
+    xx = (p_rec) ? (UINT16)(p_rec - &p_db->record[0]) + 1 : 0;
+
+    for ( ; xx < p_db->num_records; xx++)
+    {
+        if (rec_mask[xx / 32] & ((UINT32)1 << (xx % 32)))
+            return (&p_db->record[xx]);
+    }
+    return (NULL);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_serialize_record
+**
+** Description      This function builds the attribute entries of a record as
+**                  they are sent to a client, if they are not up to date.
+**                  Responses are then copied out of ser_buf; the attributes
+**                  with IDs in a range are a contiguous slice of it.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_db_serialize_record (tSDP_RECORD *p_rec)
+{
+    tSDP_ATTRIBUTE  *p_attr = &p_rec->attribute[0];
+    UINT8           *p = &p_rec->ser_buf[0];
+    UINT16          xx;
+
+    if (p_rec->ser_valid)
+        return;
+
+    for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++)
+    {
+        p_rec->ser_off[xx] = (UINT16)(p - &p_rec->ser_buf[0]);
+
+        /* Cannot happen given the pad size, but never overrun ser_buf */
+        if (p_rec->ser_off[xx] + sdpu_get_attrib_entry_len (p_attr) > SDP_MAX_REC_SER_LEN)
+        {
+            SDP_TRACE_ERROR ("SDP record 0x%x: attr 0x%04x does not fit", p_rec->record_handle, p_attr->id);
+            continue;
+        }
+        p = sdpu_build_attrib_entry (p, p_attr);
+    }
+    p_rec->ser_off[xx] = (UINT16)(p - &p_rec->ser_buf[0]);
+    p_rec->ser_valid = TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_db_changed
+**
+** Description      This function is called when a record is added, removed or
+**                  has its attributes changed. The record's serialized form and
+**                  the UUID index are rebuilt when next needed.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_db_changed (tSDP_RECORD *p_rec)
+{
+    if (p_rec)
+        p_rec->ser_valid = FALSE;
+
+    sdp_cb.server_db.index_state = SDP_DB_INDEX_STALE;
+}
+
 /*******************************************************************************
 **
 ** Function         sdp_db_find_record
@@ -300,6 +564,7 @@ UINT32 SDP_CreateRecord (void)
         p_db->record[p_db->num_records].record_handle = handle;
 
         p_db->num_records++;
+        sdp_db_changed (NULL);
         SDP_TRACE_DEBUG("SDP_CreateRecord ok, num_records:%d", p_db->num_records);
         /* Add the first attribute (the handle) automatically */
         UINT32_TO_BE_FIELD (buf, handle);
@@ -337,6 +602,7 @@ BOOLEAN SDP_DeleteRecord (UINT32 handle)
     {
         /* Delete all records in the database */
         sdp_cb.server_db.num_records = 0;
+        sdp_db_changed (NULL);
 
         /* require new DI record to be created in SDP_SetLocalDiRecord */
         sdp_cb.server_db.di_primary_handle = 0;
@@ -362,6 +628,7 @@ BOOLEAN SDP_DeleteRecord (UINT32 handle)
                 }
 
                 sdp_cb.server_db.num_records--;
+                sdp_db_changed (NULL);
 
                 SDP_TRACE_DEBUG("SDP_DeleteRecord ok, num_records:%d", sdp_cb.server_db.num_records);
                 /* if we're deleting the primary DI record, clear the */
@@ -443,6 +710,8 @@ BOOLEAN SDP_AddAttribute (UINT32 handle, UINT16 attr_id, UINT8 attr_type,
         {
             tSDP_ATTRIBUTE  *p_attr = &p_rec->attribute[0];
 
+            sdp_db_changed (p_rec);
+
             /* Found the record. Now, see if the attribute already exists */
             for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++)
             {
@@ -928,6 +1197,7 @@ BOOLEAN SDP_DeleteAttribute (UINT32 handle, UINT16 attr_id)
 
                     /* Found it. Shift everything up one */
                     p_rec->num_attributes--;
+                    sdp_db_changed (p_rec);
 
                     for (yy = xx; yy < p_rec->num_attributes; yy++, p_attr++)
                     {
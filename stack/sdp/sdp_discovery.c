@@ -597,10 +597,9 @@ static void process_service_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
 *******************************************************************************/
 static void process_service_search_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
 {
-    UINT8           *p, *p_start, *p_end, *p_param_len;
-    UINT8           type;
-    UINT32          seq_len;
+    UINT8           *p_start, *p_param_len;
     UINT16          param_len, lists_byte_count = 0;
+    UINT16          status;
     BOOLEAN         cont_request_needed = FALSE;
 
 #if (SDP_DEBUG_RAW == TRUE)
@@ -735,6 +734,38 @@ static void process_service_search_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
     /*******************************************************************/
     /* We now have the full response, which is a sequence of sequences */
     /*******************************************************************/
+    status = sdp_disc_save_attr_lists (p_ccb);
+
+    /* A response with a bad outer sequence is left to the inactivity timer */
+    if (status == SDP_ILLEGAL_PARAMETER)
+        return;
+
+#if (SDP_CACHE_INCLUDED == TRUE)
+    if (status == SDP_SUCCESS)
+        sdp_cache_store (p_ccb);
+#endif
+
+    /* Since we got everything we need, disconnect the call */
+    sdp_disconnect (p_ccb, status);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_disc_save_attr_lists
+**
+** Description      This function saves a complete ServiceSearchAttribute
+**                  response, held in the CCB response list, into the
+**                  discovery database.
+**
+** Returns          SDP_SUCCESS, SDP_DB_FULL or SDP_INVALID_CONT_STATE, or
+**                  SDP_ILLEGAL_PARAMETER if the list is not a sequence
+**
+*******************************************************************************/
+UINT16 sdp_disc_save_attr_lists (tCONN_CB *p_ccb)
+{
+    UINT8           *p, *p_end;
+    UINT8           type;
+    UINT32          seq_len;
 
 #if (SDP_RAW_DATA_INCLUDED == TRUE)
     SDP_TRACE_WARNING("process_service_search_attr_rsp");
@@ -749,30 +780,23 @@ static void process_service_search_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
     if ((type >> 3) != DATA_ELE_SEQ_DESC_TYPE)
     {
         SDP_TRACE_WARNING ("SDP - Wrong type: 0x%02x in attr_rsp", type);
-        return;
+        return (SDP_ILLEGAL_PARAMETER);
     }
     p = sdpu_get_len_from_type (p, type, &seq_len);
 
     p_end = &p_ccb->rsp_list[p_ccb->list_len];
 
     if ((p + seq_len) != p_end)
-    {
-        sdp_disconnect (p_ccb, SDP_INVALID_CONT_STATE);
-        return;
-    }
+        return (SDP_INVALID_CONT_STATE);
 
     while (p < p_end)
     {
         p = save_attr_seq (p_ccb, p, &p_ccb->rsp_list[p_ccb->list_len]);
         if (!p)
-        {
-            sdp_disconnect (p_ccb, SDP_DB_FULL);
-            return;
-        }
+            return (SDP_DB_FULL);
     }
 
-    /* Since we got everything we need, disconnect the call */
-    sdp_disconnect (p_ccb, SDP_SUCCESS);
+    return (SDP_SUCCESS);
 }
 
 /*******************************************************************************
@@ -92,6 +92,10 @@ void sdp_init (void)
     sdp_cb.max_attr_list_size             = SDP_MTU_SIZE - 16;
     sdp_cb.max_recs_per_search            = SDP_MAX_DISC_SERVER_RECS;
 
+#if (SDP_CACHE_INCLUDED == TRUE) && (SDP_CLIENT_ENABLED == TRUE)
+    sdp_cache_init ();
+#endif
+
 #if SDP_SERVER_ENABLED == TRUE
     /* Register with Security Manager for the specific security level */
     if (!BTM_SetSecurityLevel (FALSE, SDP_SERVICE_NAME, BTM_SEC_SERVICE_SDP_SERVER,
@@ -36,6 +36,7 @@
 #include "l2cdefs.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
+#include "interop.h"
 
 #include "sdp_api.h"
 #include "sdpint.h"
@@ -54,31 +55,25 @@
 
 #define AVRCP_13  0x03
 #define AVRCP_14  0x04
-/* Few remote device does not understand AVRCP version greater
- * than 1.3 and falls back to 1.0, we would like to blacklist
- * and send AVRCP versio as 1.3.
- */
-static const UINT8 sdp_black_list_prefix[][3] = {{0x00, 0x1D, 0xBA},  /* JVC carkit */
-                                                 {0x64, 0xD4, 0xBD},  /* Honda handsfree carkit */
-                                                 {0x0C, 0xD9, 0xC1},  /* Honda handsfree carkit */
-                                                 {0x00, 0x06, 0xF7},  /* Denso carkit */
-                                                 {0x00, 0x1E, 0xB2},  /* AVN 3.0 Hyundai*/
-                                                 {0x00, 0x0E, 0x9F},  /* Porshe car kit */
-                                                 {0x00, 0x13, 0x7B},  /* BYOM Opel*/
-                                                 {0x68, 0x84, 0x70},  /* KIA MOTOR*/
-                                                 {0x00, 0x21, 0xCC},  /* FORD FIESTA*/
-                                                 {0x9C, 0xDF, 0x03},  /* BMW 3 Series*/
-                                                 {0x30, 0x14, 0x4A},  /* Mini Cooper*/
-                                                 {0x38, 0xC0, 0x96},  /* Seat Leon*/
-                                                 {0x00, 0x54, 0xAF},  /* Chrysler*/
-                                                 {0x04, 0x88, 0xE2},  /* BeatsStudio Wireless*/
-                                                 {0xA0, 0x14, 0x3D},  /* VW Sharen*/
-                                                 {0xE0, 0x75, 0x0A}   /* VW GOLF*/};
-
-/* Few carkits supports AVRCP1.4 but not AVRCP1.5
-*  In that case fall back to 1.4 to support browsing
-*/
-static const UINT8 sdp_dev_support_avrcp_14[][3] = {{0x00, 0x02, 0x0C} /*Clarion*/};
+
+/* Most bytes patched in a record sent to an AVRCP blacklisted device */
+#define SDP_RSP_MAX_PATCHES     2
+
+/* A response is a window onto the byte stream of the whole attribute list.  */
+/* The stream is made of slices of the serialized records, so a continuation */
+/* response is built the same way with the window further along the stream.  */
+typedef struct
+{
+    UINT8   *p_out;             /* where the next byte in the window goes, NULL to measure */
+    UINT16  skip;               /* stream bytes before the window */
+    UINT16  room;               /* bytes still free in the window */
+    UINT16  total;              /* stream bytes so far */
+    UINT8   *p_peer_addr;
+    UINT8   num_patches;
+    UINT16  patch_off[SDP_RSP_MAX_PATCHES];     /* serialized record offsets */
+    UINT8   patch_val[SDP_RSP_MAX_PATCHES];
+} tSDP_RSP_WINDOW;
+
 /********************************************************************************/
 /*              L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /********************************************************************************/
@@ -138,24 +133,18 @@ static void process_service_search_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
 ** Function         sdp_dev_blacklisted_for_avrcp15
 **
 ** Description      This function is called to check if Remote device
-**                  is blacklisted for Avrcp version.
+**                  is blacklisted for Avrcp version. The list lives in the
+**                  interop database.
 **
 ** Returns          BOOLEAN
 **
 *******************************************************************************/
 BOOLEAN sdp_dev_blacklisted_for_avrcp15 (BD_ADDR addr)
 {
-    int blacklistsize = 0;
-    int i =0;
-
-    blacklistsize = sizeof(sdp_black_list_prefix)/sizeof(sdp_black_list_prefix[0]);
-    for (i=0; i < blacklistsize; i++)
+    if (interop_match_addr(INTEROP_AVRCP_1_3_ONLY, addr))
     {
-        if (0 == memcmp(sdp_black_list_prefix[i], addr, 3))
-        {
-            SDP_TRACE_ERROR("SDP Avrcp Version Black List Device");
-            return TRUE;
-        }
+        SDP_TRACE_ERROR("SDP Avrcp Version Black List Device");
+        return TRUE;
     }
     return FALSE;
 }
@@ -172,17 +161,10 @@ BOOLEAN sdp_dev_blacklisted_for_avrcp15 (BD_ADDR addr)
 *******************************************************************************/
 BOOLEAN check_sdp_dev_supports_avrcp14 (BD_ADDR addr)
 {
-    int blacklistsize = 0;
-    int i = 0;
-
-    blacklistsize = sizeof(sdp_dev_support_avrcp_14)/sizeof(sdp_dev_support_avrcp_14[0]);
-    for (i=0; i < blacklistsize; i++)
+    if (interop_match_addr(INTEROP_AVRCP_1_4_ONLY, addr))
     {
-        if (0 == memcmp(sdp_dev_support_avrcp_14[i], addr, 3))
-        {
-            SDP_TRACE_ERROR("SDP Avrcp Version supports only 1.4");
-            return TRUE;
-        }
+        SDP_TRACE_ERROR("SDP Avrcp Version supports only 1.4");
+        return TRUE;
     }
     return FALSE;
 }
@@ -193,12 +175,14 @@ BOOLEAN check_sdp_dev_supports_avrcp14 (BD_ADDR addr)
 **
 ** Description     Checks if UUID is AV Remote Control, attribute id
 **                 is Profile descriptor list and remote BD address
-**                 matches device blacklist, change Avrcp version to 1.3
+**                 matches device blacklist, and gets the Avrcp version
+**                 to send instead (1.3 or 1.4)
 **
 ** Returns         BOOLEAN
 **
 ***************************************************************************************/
-BOOLEAN sdp_fallback_avrcp_version (tSDP_ATTRIBUTE *p_attr, BD_ADDR remote_address)
+BOOLEAN sdp_fallback_avrcp_version (tSDP_ATTRIBUTE *p_attr, BD_ADDR remote_address,
+                                    UINT8 *p_version)
 {
     if ((p_attr->id == ATTR_ID_BT_PROFILE_DESC_LIST) &&
         (p_attr->len >= SDP_AVRCP_PROFILE_DESC_LENGTH))
@@ -209,16 +193,14 @@ BOOLEAN sdp_fallback_avrcp_version (tSDP_ATTRIBUTE *p_attr, BD_ADDR remote_addre
         {
             if (sdp_dev_blacklisted_for_avrcp15 (remote_address))
             {
-                p_attr->value_ptr[AVRCP_VERSION_POSITION] = AVRCP_13; // Update AVRCP version as 1.3
-                SDP_TRACE_ERROR("SDP Change AVRCP Version = 0x%x",
-                         p_attr->value_ptr[AVRCP_VERSION_POSITION]);
+                *p_version = AVRCP_13; // Send AVRCP version as 1.3
+                SDP_TRACE_ERROR("SDP Change AVRCP Version = 0x%x", *p_version);
                 return TRUE;
             }
             else if (check_sdp_dev_supports_avrcp14 ( remote_address))
             {
-                p_attr->value_ptr[AVRCP_VERSION_POSITION] = AVRCP_14; // Update AVRCP version as 1.4
-                SDP_TRACE_ERROR("SDP Change AVRCP Version = 0x%x",
-                         p_attr->value_ptr[AVRCP_VERSION_POSITION]);
+                *p_version = AVRCP_14; // Send AVRCP version as 1.4
+                SDP_TRACE_ERROR("SDP Change AVRCP Version = 0x%x", *p_version);
                return TRUE;
             }
         }
@@ -232,7 +214,7 @@ BOOLEAN sdp_fallback_avrcp_version (tSDP_ATTRIBUTE *p_attr, BD_ADDR remote_addre
 **
 ** Description     Checks if Service Class ID is AV Remote Control TG, attribute id
 **                 is Supported features and remote BD address
-**                 matches device blacklist, reset Browsing Bit
+**                 matches device blacklist, i.e. Browsing Bit is to be reset
 **
 ** Returns         BOOLEAN
 **
@@ -241,18 +223,262 @@ BOOLEAN sdp_reset_avrcp_browsing_bit (tSDP_ATTRIBUTE attr, tSDP_ATTRIBUTE *p_att
 BD_ADDR                                                                      remote_address)
 {
     if ((p_attr->id == ATTR_ID_SUPPORTED_FEATURES) && (attr.id == ATTR_ID_SERVICE_CLASS_ID_LIST) &&
+        (p_attr->len > AVRCP_SUPPORTED_FEATURES_POSITION) && (attr.len >= 3) &&
         (((attr.value_ptr[1] << 8) | (attr.value_ptr[2])) == UUID_SERVCLASS_AV_REM_CTRL_TARGET))
     {
         if (sdp_dev_blacklisted_for_avrcp15 (remote_address))
         {
             SDP_TRACE_ERROR("Reset Browse feature bitmask");
-            p_attr->value_ptr[AVRCP_SUPPORTED_FEATURES_POSITION] &= ~AVRCP_BROWSE_SUPPORT_BITMASK;
             return TRUE;
         }
     }
     return FALSE;
 }
 
+#if SDP_AVRCP_1_5 == TRUE
+/*************************************************************************************
+**
+** Function        sdp_rsp_avrcp_patches
+**
+** Description     Records the bytes of a record that are sent differently to
+**                 the remote device, because of its AVRCP version blacklisting.
+**                 The serialized record itself is left untouched.
+**
+** Returns         void
+**
+***************************************************************************************/
+static void sdp_rsp_avrcp_patches (tSDP_RSP_WINDOW *p_win, tSDP_RECORD *p_rec)
+{
+    tSDP_ATTRIBUTE  *p_attr = &p_rec->attribute[0];
+    UINT16          xx, val_off;
+    UINT8           version;
+
+    p_win->num_patches = 0;
+
+    for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++)
+    {
+        /* The value is at the end of the serialized attribute entry */
+        if ((UINT32)(p_rec->ser_off[xx + 1] - p_rec->ser_off[xx]) < p_attr->len)
+            continue;
+        val_off = p_rec->ser_off[xx + 1] - (UINT16)p_attr->len;
+
+        if (sdp_fallback_avrcp_version (p_attr, p_win->p_peer_addr, &version))
+        {
+            p_win->patch_off[p_win->num_patches] = val_off + AVRCP_VERSION_POSITION;
+            p_win->patch_val[p_win->num_patches++] = version;
+        }
+        else if ((p_rec->num_attributes > 1) &&
+                 sdp_reset_avrcp_browsing_bit (p_rec->attribute[1], p_attr, p_win->p_peer_addr))
+        {
+            p_win->patch_off[p_win->num_patches] = val_off + AVRCP_SUPPORTED_FEATURES_POSITION;
+            p_win->patch_val[p_win->num_patches++] =
+                p_attr->value_ptr[AVRCP_SUPPORTED_FEATURES_POSITION] & ~AVRCP_BROWSE_SUPPORT_BITMASK;
+        }
+
+        if (p_win->num_patches == SDP_RSP_MAX_PATCHES)
+            break;
+    }
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         sdp_rsp_window_init
+**
+** Description      This function sets up a response window. With p_out NULL
+**                  nothing is copied and the window only measures the stream.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_rsp_window_init (tSDP_RSP_WINDOW *p_win, UINT8 *p_out, UINT16 skip,
+                                 UINT16 room, UINT8 *p_peer_addr)
+{
+    memset (p_win, 0, sizeof (tSDP_RSP_WINDOW));
+    p_win->p_out       = p_out;
+    p_win->skip        = skip;
+    p_win->room        = room;
+    p_win->p_peer_addr = p_peer_addr;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_rsp_copy
+**
+** Description      This function appends len bytes to the response stream,
+**                  copying the part that falls in the window. p_ser is the
+**                  serialized record p_src points into, or NULL.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_rsp_copy (tSDP_RSP_WINDOW *p_win, UINT8 *p_src, UINT16 len, UINT8 *p_ser)
+{
+    UINT16  start, n, xx, off;
+
+    p_win->total += len;
+
+    if (!p_win->p_out)
+        return;
+
+    /* Whole chunk is before the window (sent in an earlier response) */
+    if (p_win->skip >= len)
+    {
+        p_win->skip -= len;
+        return;
+    }
+
+    start = p_win->skip;
+    p_win->skip = 0;
+    n = len - start;
+    if (n > p_win->room)
+        n = p_win->room;
+
+    memcpy (p_win->p_out, p_src + start, n);
+
+    if (p_ser)
+    {
+        /* Serialized record offset of the first byte copied */
+        off = (UINT16)(p_src - p_ser) + start;
+        for (xx = 0; xx < p_win->num_patches; xx++)
+        {
+            if ((p_win->patch_off[xx] >= off) && (p_win->patch_off[xx] < off + n))
+                p_win->p_out[p_win->patch_off[xx] - off] = p_win->patch_val[xx];
+        }
+    }
+
+    p_win->p_out += n;
+    p_win->room  -= n;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_rsp_add_list_hdr
+**
+** Description      This function appends the data element sequence header of
+**                  the attribute list. list_len includes the header, which is
+**                  2 bytes for lists up to 255 bytes and 3 bytes otherwise.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_rsp_add_list_hdr (tSDP_RSP_WINDOW *p_win, UINT16 list_len)
+{
+    UINT8   hdr[3];
+
+    if (list_len > 255)
+    {
+        hdr[0] = (UINT8) ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
+        hdr[1] = (UINT8) ((list_len - 3) >> 8);
+        hdr[2] = (UINT8) (list_len - 3);
+        sdp_rsp_copy (p_win, hdr, 3, NULL);
+    }
+    else
+    {
+        hdr[0] = (UINT8) ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE);
+        hdr[1] = (UINT8) (list_len - 2);
+        sdp_rsp_copy (p_win, hdr, 2, NULL);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         sdp_rsp_list_len
+**
+** Description      This function gets the length of an attribute list, header
+**                  included, from the length of its contents.
+**
+** Returns          UINT16
+**
+*******************************************************************************/
+static UINT16 sdp_rsp_list_len (UINT16 body_len)
+{
+    if (body_len + 3 > 255)
+        return (body_len + 3);
+    else
+        return (body_len + 2);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_rsp_add_attrs
+**
+** Description      This function appends the attributes of a record that match
+**                  the attribute sequence. Attributes are kept sorted by ID, so
+**                  each ID or ID range is one slice of the serialized record.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_rsp_add_attrs (tSDP_RSP_WINDOW *p_win, tSDP_RECORD *p_rec,
+                               tSDP_ATTR_SEQ *p_attr_seq)
+{
+    UINT16  xx, first, last;
+
+#if SDP_AVRCP_1_5 == TRUE
+    if (p_win->p_out)
+        sdp_rsp_avrcp_patches (p_win, p_rec);
+#endif
+
+    for (xx = 0; xx < p_attr_seq->num_attr; xx++)
+    {
+        for (first = 0; first < p_rec->num_attributes; first++)
+        {
+            if (p_rec->attribute[first].id >= p_attr_seq->attr_entry[xx].start)
+                break;
+        }
+        for (last = first; last < p_rec->num_attributes; last++)
+        {
+            if (p_rec->attribute[last].id > p_attr_seq->attr_entry[xx].end)
+                break;
+        }
+
+        if (last > first)
+            sdp_rsp_copy (p_win, &p_rec->ser_buf[p_rec->ser_off[first]],
+                          (UINT16)(p_rec->ser_off[last] - p_rec->ser_off[first]), p_rec->ser_buf);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         sdp_rsp_add_search_attrs
+**
+** Description      This function appends, for each record matching the UUID
+**                  sequence, an attribute list of the attributes matching the
+**                  attribute sequence. Records without any are left out.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_rsp_add_search_attrs (tSDP_RSP_WINDOW *p_win, tSDP_UUID_SEQ *p_uid_seq,
+                                      tSDP_ATTR_SEQ *p_attr_seq)
+{
+    tSDP_RECORD     *p_rec;
+    tSDP_RSP_WINDOW rec_win;
+    UINT8           hdr[3];
+
+    for (p_rec = sdp_db_service_search (NULL, p_uid_seq); p_rec; p_rec = sdp_db_service_search (p_rec, p_uid_seq))
+    {
+        /* Stop once the window is full */
+        if ((p_win->p_out) && (p_win->room == 0))
+            break;
+
+        sdp_db_serialize_record (p_rec);
+
+        sdp_rsp_window_init (&rec_win, NULL, 0, 0, NULL);
+        sdp_rsp_add_attrs (&rec_win, p_rec, p_attr_seq);
+        if (rec_win.total == 0)
+            continue;
+
+        hdr[0] = (UINT8) ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
+        hdr[1] = (UINT8) (rec_win.total >> 8);
+        hdr[2] = (UINT8) (rec_win.total);
+        sdp_rsp_copy (p_win, hdr, 3, NULL);
+
+        sdp_rsp_add_attrs (p_win, p_rec, p_attr_seq);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         sdp_server_handle_client_req
@@ -480,18 +706,14 @@ static void process_service_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
                                       UINT8 *p_req_end)
 {
     UINT16          max_list_len, len_to_send, cont_offset;
-    INT16           rem_len;
-    tSDP_ATTR_SEQ   attr_seq, attr_seq_sav;
+    tSDP_ATTR_SEQ   attr_seq;
     UINT8           *p_rsp, *p_rsp_start, *p_rsp_param_len;
-    UINT16          rsp_param_len, xx;
+    UINT16          rsp_param_len;
     UINT32          rec_handle;
     tSDP_RECORD     *p_rec;
-    tSDP_ATTRIBUTE  *p_attr;
     BT_HDR          *p_buf;
+    tSDP_RSP_WINDOW win;
     BOOLEAN         is_cont = FALSE;
-    BOOLEAN         is_avrcp_fallback = FALSE;
-    BOOLEAN         is_avrcp_browse_bit_reset = FALSE;
-    UINT16          attr_len;
 
     /* Extract the record handle */
     BE_STREAM_TO_UINT32 (rec_handle, p_req);
@@ -516,8 +738,6 @@ static void process_service_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
         return;
     }
 
-    memcpy(&attr_seq_sav, &attr_seq, sizeof(tSDP_ATTR_SEQ)) ;
-
     /* Find a record with the record handle */
     p_rec = sdp_db_find_record (rec_handle);
     if (!p_rec)
@@ -529,19 +749,6 @@ static void process_service_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
     /* Check if this is a continuation request */
     if (*p_req)
     {
-        /* Free and reallocate buffer */
-        if (p_ccb->rsp_list)
-        {
-            GKI_freebuf (p_ccb->rsp_list);
-        }
-
-        p_ccb->rsp_list = (UINT8 *)GKI_getbuf (max_list_len);
-        if (p_ccb->rsp_list == NULL)
-        {
-            SDP_TRACE_ERROR ("SDP - no scratch buf for attr rsp");
-            return;
-        }
-
         if (*p_req++ != SDP_CONTINUATION_LEN)
         {
             sdpu_build_n_send_error (p_ccb, trans_num, SDP_INVALID_CONT_STATE, SDP_TEXT_BAD_CONT_LEN);
@@ -560,17 +767,7 @@ static void process_service_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
             sdpu_build_n_send_error (p_ccb, trans_num, SDP_INVALID_PDU_SIZE, SDP_TEXT_BAD_HEADER);
             return;
         }
-
-        if (!p_ccb->rsp_list)
-        {
-            sdpu_build_n_send_error (p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
-            return;
-        }
         is_cont = TRUE;
-
-        /* Initialise for continuation response */
-        p_rsp = &p_ccb->rsp_list[0];
-        attr_seq.attr_entry[p_ccb->cont_info.next_attr_index].start = p_ccb->cont_info.next_attr_start_id;
     }
     else
     {
@@ -579,155 +776,17 @@ static void process_service_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
             sdpu_build_n_send_error (p_ccb, trans_num, SDP_INVALID_PDU_SIZE, SDP_TEXT_BAD_HEADER);
             return;
         }
-        /* Get a scratch buffer to store response */
-        if (!p_ccb->rsp_list || (GKI_get_buf_size(p_ccb->rsp_list) < max_list_len))
-        {
-            /* Free and reallocate if the earlier allocated buffer is small */
-            if (p_ccb->rsp_list)
-            {
-                GKI_freebuf (p_ccb->rsp_list);
-            }
-
-            p_ccb->rsp_list = (UINT8 *)GKI_getbuf (max_list_len);
-            if (p_ccb->rsp_list == NULL)
-            {
-                SDP_TRACE_ERROR ("SDP - no scratch buf for search rsp");
-                return;
-            }
-        }
-
         p_ccb->cont_offset = 0;
-        p_rsp = &p_ccb->rsp_list[3];            /* Leave space for data elem descr */
-
-        /* Reset continuation parameters in p_ccb */
-        p_ccb->cont_info.prev_sdp_rec = NULL;
-        p_ccb->cont_info.next_attr_index = 0;
-        p_ccb->cont_info.attr_offset = 0;
-    }
-
-    /* Search for attributes that match the list given to us */
-    for (xx = p_ccb->cont_info.next_attr_index; xx < attr_seq.num_attr; xx++)
-    {
-        p_attr = sdp_db_find_attr_in_rec (p_rec, attr_seq.attr_entry[xx].start, attr_seq.attr_entry[xx].end);
-
-        if (p_attr)
-        {
-#if SDP_AVRCP_1_5 == TRUE
-            /* Check for UUID Remote Control and Remote BD address  */
-            is_avrcp_fallback = sdp_fallback_avrcp_version (p_attr, p_ccb->device_address);
-            is_avrcp_browse_bit_reset = sdp_reset_avrcp_browsing_bit(
-                        p_rec->attribute[1], p_attr, p_ccb->device_address);
-#endif
-            /* Check if attribute fits. Assume 3-byte value type/length */
-            rem_len = max_list_len - (INT16) (p_rsp - &p_ccb->rsp_list[0]);
-
-            /* just in case */
-            if (rem_len <= 0)
-            {
-                p_ccb->cont_info.next_attr_index = xx;
-                p_ccb->cont_info.next_attr_start_id = p_attr->id;
-                break;
-            }
-
-            attr_len = sdpu_get_attrib_entry_len(p_attr);
-            /* if there is a partial attribute pending to be sent */
-            if (p_ccb->cont_info.attr_offset)
-            {
-                p_rsp = sdpu_build_partial_attrib_entry (p_rsp, p_attr, rem_len,
-                                                         &p_ccb->cont_info.attr_offset);
-
-                /* If the partial attrib could not been fully added yet */
-                if (p_ccb->cont_info.attr_offset != attr_len)
-                    break;
-                else /* If the partial attrib has been added in full by now */
-                    p_ccb->cont_info.attr_offset = 0; /* reset attr_offset */
-            }
-            else if (rem_len < attr_len) /* Not enough space for attr... so add partially */
-            {
-                if (attr_len >= SDP_MAX_ATTR_LEN)
-                {
-                    SDP_TRACE_ERROR("SDP attr too big: max_list_len=%d,attr_len=%d", max_list_len, attr_len);
-                    sdpu_build_n_send_error (p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
-                    return;
-                }
-
-                /* add the partial attribute if possible */
-                p_rsp = sdpu_build_partial_attrib_entry (p_rsp, p_attr, (UINT16)rem_len,
-                                                         &p_ccb->cont_info.attr_offset);
-
-                p_ccb->cont_info.next_attr_index = xx;
-                p_ccb->cont_info.next_attr_start_id = p_attr->id;
-                break;
-            }
-            else /* build the whole attribute */
-                p_rsp = sdpu_build_attrib_entry (p_rsp, p_attr);
-
-            /* If doing a range, stick with this one till no more attributes found */
-            if (attr_seq.attr_entry[xx].start != attr_seq.attr_entry[xx].end)
-            {
-                /* Update for next time through */
-                attr_seq.attr_entry[xx].start = p_attr->id + 1;
-
-                xx--;
-            }
-            if (is_avrcp_fallback)
-            {
-                /* Update AVRCP version back to 1.5 */
-                p_attr->value_ptr[AVRCP_VERSION_POSITION] = 0x05;
-                is_avrcp_fallback = FALSE;
-            }
-            if (is_avrcp_browse_bit_reset)
-            {
-                /* Restore Browsing bit */
-                SDP_TRACE_ERROR("Restore Browsing bit");
-                p_attr->value_ptr[AVRCP_SUPPORTED_FEATURES_POSITION]
-                                        |= AVRCP_BROWSE_SUPPORT_BITMASK;
-                is_avrcp_browse_bit_reset = FALSE;
-            }
-        }
-    }
-    if (is_avrcp_fallback)
-    {
-        /* Update AVRCP version back to 1.5 */
-        p_attr->value_ptr[AVRCP_VERSION_POSITION] = 0x05;
-        is_avrcp_fallback = FALSE;
     }
-    if (is_avrcp_browse_bit_reset)
-    {
-        /* Restore Browsing bit */
-        SDP_TRACE_ERROR("Restore Browsing bit");
-        p_attr->value_ptr[AVRCP_SUPPORTED_FEATURES_POSITION]
-                                    |= AVRCP_BROWSE_SUPPORT_BITMASK;
-        is_avrcp_browse_bit_reset = FALSE;
-    }
-    /* If all the attributes have been accomodated in p_rsp,
-       reset next_attr_index */
-    if (xx == attr_seq.num_attr)
-        p_ccb->cont_info.next_attr_index = 0;
 
-    len_to_send = (UINT16) (p_rsp - &p_ccb->rsp_list[0]);
-    cont_offset = 0;
+    sdp_db_serialize_record (p_rec);
 
+    /* On the first response, measure the whole attribute list */
     if (!is_cont)
     {
-        p_ccb->list_len = sdpu_get_attrib_seq_len(p_rec, &attr_seq_sav) + 3;
-        /* Put in the sequence header (2 or 3 bytes) */
-        if (p_ccb->list_len > 255)
-        {
-            p_ccb->rsp_list[0] = (UINT8) ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
-            p_ccb->rsp_list[1] = (UINT8) ((p_ccb->list_len - 3) >> 8);
-            p_ccb->rsp_list[2] = (UINT8) (p_ccb->list_len - 3);
-        }
-        else
-        {
-            cont_offset = 1;
-
-            p_ccb->rsp_list[1] = (UINT8) ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE);
-            p_ccb->rsp_list[2] = (UINT8) (p_ccb->list_len - 3);
-
-            p_ccb->list_len--;
-            len_to_send--;
-        }
+        sdp_rsp_window_init (&win, NULL, 0, 0, NULL);
+        sdp_rsp_add_attrs (&win, p_rec, &attr_seq);
+        p_ccb->list_len = sdp_rsp_list_len (win.total);
     }
 
     /* Get a buffer to use to build the response */
@@ -747,9 +806,13 @@ static void process_service_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
     p_rsp_param_len = p_rsp;
     p_rsp += 2;
 
-    UINT16_TO_BE_STREAM (p_rsp, len_to_send);
+    /* Copy the part of the attribute list after what was already sent */
+    sdp_rsp_window_init (&win, p_rsp + 2, p_ccb->cont_offset, max_list_len, p_ccb->device_address);
+    sdp_rsp_add_list_hdr (&win, p_ccb->list_len);
+    sdp_rsp_add_attrs (&win, p_rec, &attr_seq);
+    len_to_send = (UINT16) (win.p_out - (p_rsp + 2));
 
-    memcpy (p_rsp, &p_ccb->rsp_list[cont_offset], len_to_send);
+    UINT16_TO_BE_STREAM (p_rsp, len_to_send);
     p_rsp += len_to_send;
 
     p_ccb->cont_offset += len_to_send;
@@ -757,8 +820,6 @@ static void process_service_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
     /* If anything left to send, continuation needed */
     if (p_ccb->cont_offset < p_ccb->list_len)
     {
-        is_cont = TRUE;
-
         UINT8_TO_BE_STREAM  (p_rsp, SDP_CONTINUATION_LEN);
         UINT16_TO_BE_STREAM (p_rsp, p_ccb->cont_offset);
     }
@@ -795,21 +856,14 @@ static void process_service_search_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
                                              UINT8 *p_req_end)
 {
     UINT16         max_list_len;
-    INT16          rem_len;
     UINT16         len_to_send, cont_offset;
     tSDP_UUID_SEQ   uid_seq;
     UINT8           *p_rsp, *p_rsp_start, *p_rsp_param_len;
-    UINT16          rsp_param_len, xx;
-    tSDP_RECORD    *p_rec;
-    tSDP_ATTR_SEQ   attr_seq, attr_seq_sav;
-    tSDP_ATTRIBUTE *p_attr;
+    UINT16          rsp_param_len;
+    tSDP_ATTR_SEQ   attr_seq;
     BT_HDR         *p_buf;
-    BOOLEAN         maxxed_out = FALSE, is_cont = FALSE;
-    BOOLEAN         is_avrcp_fallback = FALSE;
-    BOOLEAN         is_avrcp_browse_bit_reset = FALSE;
-    UINT8           *p_seq_start;
-    UINT16          seq_len, attr_len;
-    UNUSED(p_req_end);
+    tSDP_RSP_WINDOW win;
+    BOOLEAN         is_cont = FALSE;
 
     /* Extract the UUID sequence to search for */
     p_req = sdpu_extract_uid_seq (p_req, param_len, &uid_seq);
@@ -834,24 +888,9 @@ static void process_service_search_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
         return;
     }
 
-    memcpy(&attr_seq_sav, &attr_seq, sizeof(tSDP_ATTR_SEQ)) ;
-
     /* Check if this is a continuation request */
     if (*p_req)
     {
-        /* Free and reallocate buffer */
-        if (p_ccb->rsp_list)
-        {
-            GKI_freebuf (p_ccb->rsp_list);
-        }
-
-        p_ccb->rsp_list = (UINT8 *)GKI_getbuf (max_list_len);
-        if (p_ccb->rsp_list == NULL)
-        {
-            SDP_TRACE_ERROR ("SDP - no scratch buf for search rsp");
-            return;
-        }
-
         if (*p_req++ != SDP_CONTINUATION_LEN)
         {
             sdpu_build_n_send_error (p_ccb, trans_num, SDP_INVALID_CONT_STATE, SDP_TEXT_BAD_CONT_LEN);
@@ -869,16 +908,7 @@ static void process_service_search_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
             sdpu_build_n_send_error (p_ccb, trans_num, SDP_INVALID_PDU_SIZE, SDP_TEXT_BAD_HEADER);
             return;
         }
-        if (!p_ccb->rsp_list)
-        {
-            sdpu_build_n_send_error (p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
-            return;
-        }
         is_cont = TRUE;
-
-        /* Initialise for continuation response */
-        p_rsp = &p_ccb->rsp_list[0];
-        attr_seq.attr_entry[p_ccb->cont_info.next_attr_index].start = p_ccb->cont_info.next_attr_start_id;
     }
     else
     {
@@ -887,214 +917,15 @@ static void process_service_search_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
             sdpu_build_n_send_error (p_ccb, trans_num, SDP_INVALID_PDU_SIZE, SDP_TEXT_BAD_HEADER);
             return;
         }
-        /* Get a scratch buffer to store response */
-        if (!p_ccb->rsp_list || (GKI_get_buf_size(p_ccb->rsp_list) < max_list_len))
-        {
-            /* Free and reallocate if the earlier allocated buffer is small */
-            if (p_ccb->rsp_list)
-            {
-                GKI_freebuf (p_ccb->rsp_list);
-            }
-
-            p_ccb->rsp_list = (UINT8 *)GKI_getbuf (max_list_len);
-            if (p_ccb->rsp_list == NULL)
-            {
-                SDP_TRACE_ERROR ("SDP - no scratch buf for search rsp");
-                return;
-            }
-        }
-
         p_ccb->cont_offset = 0;
-        p_rsp = &p_ccb->rsp_list[3];            /* Leave space for data elem descr */
-
-        /* Reset continuation parameters in p_ccb */
-        p_ccb->cont_info.prev_sdp_rec = NULL;
-        p_ccb->cont_info.next_attr_index = 0;
-        p_ccb->cont_info.last_attr_seq_desc_sent = FALSE;
-        p_ccb->cont_info.attr_offset = 0;
-    }
-
-    /* Get a list of handles that match the UUIDs given to us */
-    for (p_rec = sdp_db_service_search (p_ccb->cont_info.prev_sdp_rec, &uid_seq); p_rec; p_rec = sdp_db_service_search (p_rec, &uid_seq))
-    {
-        /* Allow space for attribute sequence type and length */
-        p_seq_start = p_rsp;
-        if (p_ccb->cont_info.last_attr_seq_desc_sent == FALSE)
-        {
-            /* See if there is enough room to include a new service in the current response */
-            rem_len = max_list_len - (INT16) (p_rsp - &p_ccb->rsp_list[0]);
-            if (rem_len < 3)
-            {
-                /* Not enough room. Update continuation info for next response */
-                p_ccb->cont_info.next_attr_index = 0;
-                p_ccb->cont_info.next_attr_start_id = attr_seq.attr_entry[0].start;
-                break;
-            }
-            p_rsp += 3;
-        }
-
-        /* Get a list of handles that match the UUIDs given to us */
-        for (xx = p_ccb->cont_info.next_attr_index; xx < attr_seq.num_attr; xx++)
-        {
-            p_attr = sdp_db_find_attr_in_rec (p_rec, attr_seq.attr_entry[xx].start, attr_seq.attr_entry[xx].end);
-
-            if (p_attr)
-            {
-#if SDP_AVRCP_1_5 == TRUE
-                /* Check for UUID Remote Control and Remote BD address  */
-                is_avrcp_fallback = sdp_fallback_avrcp_version (p_attr, p_ccb->device_address);
-                is_avrcp_browse_bit_reset = sdp_reset_avrcp_browsing_bit(
-                            p_rec->attribute[1], p_attr, p_ccb->device_address);
-#endif
-                /* Check if attribute fits. Assume 3-byte value type/length */
-                rem_len = max_list_len - (INT16) (p_rsp - &p_ccb->rsp_list[0]);
-
-                /* just in case */
-                if (rem_len <= 0)
-                {
-                    p_ccb->cont_info.next_attr_index = xx;
-                    p_ccb->cont_info.next_attr_start_id = p_attr->id;
-                    maxxed_out = TRUE;
-                    break;
-                }
-
-                attr_len = sdpu_get_attrib_entry_len(p_attr);
-                /* if there is a partial attribute pending to be sent */
-                if (p_ccb->cont_info.attr_offset)
-                {
-                    p_rsp = sdpu_build_partial_attrib_entry (p_rsp, p_attr, rem_len,
-                                                             &p_ccb->cont_info.attr_offset);
-
-                    /* If the partial attrib could not been fully added yet */
-                    if (p_ccb->cont_info.attr_offset != attr_len)
-                    {
-                        maxxed_out = TRUE;
-                        break;
-                    }
-                    else /* If the partial attrib has been added in full by now */
-                        p_ccb->cont_info.attr_offset = 0; /* reset attr_offset */
-                }
-                else if (rem_len < attr_len) /* Not enough space for attr... so add partially */
-                {
-                    if (attr_len >= SDP_MAX_ATTR_LEN)
-                    {
-                        SDP_TRACE_ERROR("SDP attr too big: max_list_len=%d,attr_len=%d", max_list_len, attr_len);
-                        sdpu_build_n_send_error (p_ccb, trans_num, SDP_NO_RESOURCES, NULL);
-                        return;
-                    }
-
-                    /* add the partial attribute if possible */
-                    p_rsp = sdpu_build_partial_attrib_entry (p_rsp, p_attr, (UINT16)rem_len,
-                                                             &p_ccb->cont_info.attr_offset);
-
-                    p_ccb->cont_info.next_attr_index = xx;
-                    p_ccb->cont_info.next_attr_start_id = p_attr->id;
-                    maxxed_out = TRUE;
-                    break;
-                }
-                else /* build the whole attribute */
-                    p_rsp = sdpu_build_attrib_entry (p_rsp, p_attr);
-
-                /* If doing a range, stick with this one till no more attributes found */
-                if (attr_seq.attr_entry[xx].start != attr_seq.attr_entry[xx].end)
-                {
-                    /* Update for next time through */
-                    attr_seq.attr_entry[xx].start = p_attr->id + 1;
-
-                    xx--;
-                }
-                if (is_avrcp_fallback)
-                {
-                    /* Update AVRCP version back to 1.5 */
-                    p_attr->value_ptr[AVRCP_VERSION_POSITION] = 0x05;
-                    is_avrcp_fallback = FALSE;
-                }
-                if (is_avrcp_browse_bit_reset)
-                {
-                    /* Restore Browsing bit */
-                    SDP_TRACE_ERROR("Restore Browsing bit");
-                    p_attr->value_ptr[AVRCP_SUPPORTED_FEATURES_POSITION]
-                                            |= AVRCP_BROWSE_SUPPORT_BITMASK;
-                    is_avrcp_browse_bit_reset = FALSE;
-                }
-            }
-        }
-        if (is_avrcp_fallback)
-        {
-            /* Update AVRCP version back to 1.5 */
-            p_attr->value_ptr[AVRCP_VERSION_POSITION] = 0x05;
-            is_avrcp_fallback = FALSE;
-        }
-        if (is_avrcp_browse_bit_reset)
-        {
-            /* Restore Browsing bit */
-            SDP_TRACE_ERROR("Restore Browsing bit");
-            p_attr->value_ptr[AVRCP_SUPPORTED_FEATURES_POSITION]
-                                    |= AVRCP_BROWSE_SUPPORT_BITMASK;
-            is_avrcp_browse_bit_reset = FALSE;
-        }
-
-        /* Go back and put the type and length into the buffer */
-        if (p_ccb->cont_info.last_attr_seq_desc_sent == FALSE)
-        {
-            seq_len = sdpu_get_attrib_seq_len(p_rec, &attr_seq_sav);
-            if (seq_len != 0)
-            {
-                if (p_seq_start)
-                {
-                    UINT8_TO_BE_STREAM  (p_seq_start, (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
-                    UINT16_TO_BE_STREAM (p_seq_start, seq_len);
-                }
-                else
-                {
-                    SDP_TRACE_DEBUG("SDP service and attribute rsp: Attribute sequence p_seq_start is NULL");
-                }
-
-                if (maxxed_out)
-                    p_ccb->cont_info.last_attr_seq_desc_sent = TRUE;
-            }
-            else
-                p_rsp = p_seq_start;
-        }
-
-        if (maxxed_out)
-            break;
-
-        /* Restore the attr_seq to look for in the next sdp record */
-        memcpy(&attr_seq, &attr_seq_sav, sizeof(tSDP_ATTR_SEQ)) ;
-
-        /* Reset the next attr index */
-        p_ccb->cont_info.next_attr_index = 0;
-        p_ccb->cont_info.prev_sdp_rec = p_rec;
-        p_ccb->cont_info.last_attr_seq_desc_sent = FALSE;
     }
 
-    /* response length */
-    len_to_send = (UINT16) (p_rsp - &p_ccb->rsp_list[0]);
-    cont_offset = 0;
-
-    /* If first response, insert sequence header */
+    /* On the first response, measure the whole attribute list */
     if (!is_cont)
     {
-        /* Get the total list length for requested uid and attribute sequence */
-        p_ccb->list_len = sdpu_get_list_len(&uid_seq, &attr_seq_sav) + 3;
-        /* Put in the sequence header (2 or 3 bytes) */
-        if (p_ccb->list_len > 255)
-        {
-            p_ccb->rsp_list[0] = (UINT8) ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
-            p_ccb->rsp_list[1] = (UINT8) ((p_ccb->list_len - 3) >> 8);
-            p_ccb->rsp_list[2] = (UINT8) (p_ccb->list_len - 3);
-        }
-        else
-        {
-            cont_offset = 1;
-
-            p_ccb->rsp_list[1] = (UINT8) ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE);
-            p_ccb->rsp_list[2] = (UINT8) (p_ccb->list_len - 3);
-
-            p_ccb->list_len--;
-            len_to_send--;
-        }
+        sdp_rsp_window_init (&win, NULL, 0, 0, NULL);
+        sdp_rsp_add_search_attrs (&win, &uid_seq, &attr_seq);
+        p_ccb->list_len = sdp_rsp_list_len (win.total);
     }
 
     /* Get a buffer to use to build the response */
@@ -1114,11 +945,14 @@ static void process_service_search_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
     p_rsp_param_len = p_rsp;
     p_rsp += 2;
 
+    /* Copy the part of the attribute lists after what was already sent */
+    sdp_rsp_window_init (&win, p_rsp + 2, p_ccb->cont_offset, max_list_len, p_ccb->device_address);
+    sdp_rsp_add_list_hdr (&win, p_ccb->list_len);
+    sdp_rsp_add_search_attrs (&win, &uid_seq, &attr_seq);
+    len_to_send = (UINT16) (win.p_out - (p_rsp + 2));
+
     /* Stream the list length to send */
     UINT16_TO_BE_STREAM (p_rsp, len_to_send);
-
-    /* copy from rsp_list to the actual buffer to be sent */
-    memcpy (p_rsp, &p_ccb->rsp_list[cont_offset], len_to_send);
     p_rsp += len_to_send;
 
     p_ccb->cont_offset += len_to_send;
@@ -1126,8 +960,6 @@ static void process_service_search_attr_req (tCONN_CB *p_ccb, UINT16 trans_num,
     /* If anything left to send, continuation needed */
     if (p_ccb->cont_offset < p_ccb->list_len)
     {
-        is_cont = TRUE;
-
         UINT8_TO_BE_STREAM  (p_rsp, SDP_CONTINUATION_LEN);
         UINT16_TO_BE_STREAM (p_rsp, p_ccb->cont_offset);
     }
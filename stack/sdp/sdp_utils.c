@@ -145,6 +145,11 @@ tCONN_CB *sdpu_allocate_ccb (void)
 void sdpu_release_ccb (tCONN_CB *p_ccb)
 {
     /* Ensure timer is stopped */
+#if (SDP_CACHE_INCLUDED == TRUE)
+    if (p_ccb->con_flags & SDP_FLAGS_CACHED)
+        btu_stop_quick_timer (&p_ccb->timer_entry);
+    else
+#endif
     btu_stop_timer (&p_ccb->timer_entry);
 
     /* Drop any response pointer we may be holding */
@@ -847,85 +852,6 @@ void sdpu_sort_attr_list( UINT16 num_attr, tSDP_DISCOVERY_DB *p_db )
 }
 
 
-/*******************************************************************************
-**
-** Function         sdpu_get_list_len
-**
-** Description      gets the total list length in the sdp database for a given
-**                  uid sequence and attr sequence
-**
-** Returns          void
-**
-*******************************************************************************/
-UINT16 sdpu_get_list_len(tSDP_UUID_SEQ *uid_seq, tSDP_ATTR_SEQ *attr_seq)
-{
-    tSDP_RECORD    *p_rec;
-    UINT16 len = 0;
-    UINT16 len1;
-
-    for (p_rec = sdp_db_service_search (NULL, uid_seq); p_rec; p_rec = sdp_db_service_search (p_rec, uid_seq))
-    {
-        len += 3;
-
-        len1 = sdpu_get_attrib_seq_len(p_rec, attr_seq );
-
-        if (len1 != 0)
-            len += len1;
-        else
-            len -= 3;
-    }
-    return len;
-}
-
-/*******************************************************************************
-**
-** Function         sdpu_get_attrib_seq_len
-**
-** Description      gets the length of the specific attributes in a given
-**                  sdp record
-**
-** Returns          void
-**
-*******************************************************************************/
-UINT16 sdpu_get_attrib_seq_len(tSDP_RECORD *p_rec, tSDP_ATTR_SEQ *attr_seq)
-{
-    tSDP_ATTRIBUTE *p_attr;
-    UINT16 len1 = 0;
-    UINT16 xx;
-    BOOLEAN is_range = FALSE;
-    UINT16 start_id=0, end_id=0;
-
-    for (xx = 0; xx < attr_seq->num_attr; xx++)
-    {
-        if (is_range == FALSE)
-        {
-            start_id = attr_seq->attr_entry[xx].start;
-            end_id = attr_seq->attr_entry[xx].end;
-        }
-        p_attr = sdp_db_find_attr_in_rec (p_rec,
-                                          start_id,
-                                          end_id);
-        if (p_attr)
-        {
-            len1 += sdpu_get_attrib_entry_len (p_attr);
-
-            /* If doing a range, stick with this one till no more attributes found */
-            if (start_id != end_id)
-            {
-                /* Update for next time through */
-                start_id = p_attr->id + 1;
-                xx--;
-                is_range = TRUE;
-            }
-            else
-                is_range = FALSE;
-        }
-        else
-            is_range = FALSE;
-    }
-    return len1;
-}
-
 /*******************************************************************************
 **
 ** Function         sdpu_get_attrib_entry_len
@@ -992,68 +918,57 @@ UINT16 sdpu_get_attrib_entry_len(tSDP_ATTRIBUTE *p_attr)
 
 /*******************************************************************************
 **
-** Function         sdpu_build_partial_attrib_entry
+** Function         sdpu_uuid16_to_uuid128
 **
-** Description      This function fills a buffer with partial attribute. It is
-**                  assumed that the maximum size of any attribute is 256 bytes.
+** Description      This function converts UUID-16 to UUID-128 by including the base UUID
 **
-**                  p_out: output buffer
-**                  p_attr: attribute to be copied partially into p_out
-**                  rem_len: num bytes to copy into p_out
-**                  offset: current start offset within the attr that needs to be copied
+**                  uuid16: 2-byte UUID
+**                  p_uuid128: Expanded 128-bit UUID
 **
-** Returns          Pointer to next byte in the output buffer.
-**                  offset is also updated
+** Returns          None
 **
 *******************************************************************************/
-UINT8 *sdpu_build_partial_attrib_entry (UINT8 *p_out, tSDP_ATTRIBUTE *p_attr, UINT16 len, UINT16 *offset)
+void sdpu_uuid16_to_uuid128(UINT16 uuid16, UINT8* p_uuid128)
 {
-    UINT8   *p_attr_buff;
-    UINT8   *p_tmp_attr;
-    size_t  len_to_copy;
-    UINT16  attr_len;
-
-    if ((p_attr_buff = (UINT8 *) GKI_getbuf(sizeof(UINT8) * SDP_MAX_ATTR_LEN )) == NULL)
-    {
-        SDP_TRACE_ERROR("sdpu_build_partial_attrib_entry cannot get a buffer!");
-        return NULL;
-    }
-    p_tmp_attr = p_attr_buff;
-
-    sdpu_build_attrib_entry(p_tmp_attr, p_attr);
-    attr_len = sdpu_get_attrib_entry_len(p_attr);
-
-    len_to_copy = ((attr_len - *offset) < len) ? (attr_len - *offset): len;
-
-    if (p_out)
-    {
-        memcpy(p_out, &p_attr_buff[*offset], len_to_copy);
-        p_out = &p_out[len_to_copy];
-        *offset += len_to_copy;
-    }
+    UINT16 uuid16_bo;
+    memset(p_uuid128, 0, 16);
 
-    GKI_freebuf(p_attr_buff);
-    return p_out;
+    memcpy(p_uuid128, sdp_base_uuid, MAX_UUID_SIZE);
+    uuid16_bo = ntohs(uuid16);
+    memcpy(p_uuid128+ 2, &uuid16_bo, sizeof(uint16_t));
 }
 
 /*******************************************************************************
 **
-** Function         sdpu_uuid16_to_uuid128
+** Function         sdpu_uuid_to_uuid128
 **
-** Description      This function converts UUID-16 to UUID-128 by including the base UUID
+** Description      This function expands a 2, 4 or 16-byte BE UUID to its
+**                  128-bit form, so that equal UUIDs compare equal with memcmp.
 **
-**                  uuid16: 2-byte UUID
+**                  p_uuid: UUID in Big Endian format
+**                  len: length of p_uuid
 **                  p_uuid128: Expanded 128-bit UUID
 **
-** Returns          None
+** Returns          TRUE if expanded, FALSE if the length is invalid
 **
 *******************************************************************************/
-void sdpu_uuid16_to_uuid128(UINT16 uuid16, UINT8* p_uuid128)
+BOOLEAN sdpu_uuid_to_uuid128 (UINT8 *p_uuid, UINT32 len, UINT8 *p_uuid128)
 {
-    UINT16 uuid16_bo;
-    memset(p_uuid128, 0, 16);
+    switch (len)
+    {
+    case 2:
+        memcpy (p_uuid128, sdp_base_uuid, MAX_UUID_SIZE);
+        memcpy (p_uuid128 + 2, p_uuid, 2);
+        return (TRUE);
 
-    memcpy(p_uuid128, sdp_base_uuid, MAX_UUID_SIZE);
-    uuid16_bo = ntohs(uuid16);
-    memcpy(p_uuid128+ 2, &uuid16_bo, sizeof(uint16_t));
+    case 4:
+        memcpy (p_uuid128, sdp_base_uuid, MAX_UUID_SIZE);
+        memcpy (p_uuid128, p_uuid, 4);
+        return (TRUE);
+
+    case 16:
+        memcpy (p_uuid128, p_uuid, MAX_UUID_SIZE);
+        return (TRUE);
+    }
+    return (FALSE);
 }
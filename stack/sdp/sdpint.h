@@ -126,6 +126,10 @@ typedef struct
     UINT8   type;
 } tSDP_ATTRIBUTE;
 
+/* Room for the attribute entries of a record as sent on the air: the values */
+/* plus up to 8 bytes of attribute ID and data element header per attribute  */
+#define SDP_MAX_REC_SER_LEN     (SDP_MAX_PAD_LEN + SDP_MAX_REC_ATTR * 8)
+
 /* An SDP record consists of a handle, and 1 or more attributes */
 typedef struct
 {
@@ -134,9 +138,21 @@ typedef struct
     UINT16              num_attributes;
     tSDP_ATTRIBUTE      attribute[SDP_MAX_REC_ATTR];
     UINT8               attr_pad[SDP_MAX_PAD_LEN];
+    BOOLEAN             ser_valid;                      /* ser_buf matches the attributes */
+    UINT16              ser_off[SDP_MAX_REC_ATTR + 1];  /* offset of each attribute entry in ser_buf */
+    UINT8               ser_buf[SDP_MAX_REC_SER_LEN];   /* serialized attribute entries */
 } tSDP_RECORD;
 
 
+/* Entry of the server's UUID index: the records containing a UUID */
+#define SDP_DB_REC_MASK_WORDS   ((SDP_MAX_RECORDS + 31) / 32)
+
+typedef struct
+{
+    UINT8          uuid[MAX_UUID_SIZE];     /* UUID in 128-bit form */
+    UINT32         rec_mask[SDP_DB_REC_MASK_WORDS];
+} tSDP_UUID_INDEX;
+
 /* Define the SDP database */
 typedef struct
 {
@@ -144,6 +160,13 @@ typedef struct
     BOOLEAN        brcm_di_registered;
     UINT16         num_records;
     tSDP_RECORD    record[SDP_MAX_RECORDS];
+
+#define SDP_DB_INDEX_STALE      0           /* rebuilt on the next search */
+#define SDP_DB_INDEX_VALID      1
+#define SDP_DB_INDEX_OVERFLOW   2           /* too many UUIDs, records are walked */
+    UINT8          index_state;
+    UINT16         num_index_uuids;
+    tSDP_UUID_INDEX uuid_index[SDP_MAX_UUID_INDEX];   /* sorted by UUID */
 } tSDP_DB;
 
 enum
@@ -153,18 +176,6 @@ enum
     SDP_IS_PASS_THRU    /* only when SDP_FOR_JV_INCLUDED == TRUE */
 };
 
-#if SDP_SERVER_ENABLED == TRUE
-/* Continuation information for the SDP server response */
-typedef struct
-{
-    UINT16            next_attr_index; /* attr index for next continuation response */
-    UINT16            next_attr_start_id;  /* attr id to start with for the attr index in next cont. response */
-    tSDP_RECORD       *prev_sdp_rec; /* last sdp record that was completely sent in the response */
-    BOOLEAN           last_attr_seq_desc_sent; /* whether attr seq length has been sent previously */
-    UINT16            attr_offset; /* offset within the attr to keep trak of partial attributes in the responses */
-} tSDP_CONT_INFO;
-#endif  /* SDP_SERVER_ENABLED == TRUE */
-
 /* Define the SDP Connection Control Block */
 typedef struct
 {
@@ -177,6 +188,7 @@ typedef struct
 #define SDP_FLAGS_IS_ORIG           0x01
 #define SDP_FLAGS_HIS_CFG_DONE      0x02
 #define SDP_FLAGS_MY_CFG_DONE       0x04
+#define SDP_FLAGS_CACHED            0x08    /* result served from the SDP record cache */
     UINT8             con_flags;
 
     BD_ADDR           device_address;
@@ -213,7 +225,6 @@ typedef struct
 
 #if SDP_SERVER_ENABLED == TRUE
     UINT16            cont_offset;              /* Continuation state data in the server response */
-    tSDP_CONT_INFO    cont_info;                /* structure to hold continuation information for the server response */
 #endif  /* SDP_SERVER_ENABLED == TRUE */
 
 } tCONN_CB;
@@ -292,17 +303,16 @@ SDP_API extern BOOLEAN  sdpu_compare_bt_uuids (tBT_UUID *p_uuid1, tBT_UUID *p_uu
 extern BOOLEAN  sdpu_compare_uuid_with_attr (tBT_UUID *p_btuuid, tSDP_DISC_ATTR *p_attr);
 
 extern void     sdpu_sort_attr_list( UINT16 num_attr, tSDP_DISCOVERY_DB *p_db );
-extern UINT16 sdpu_get_list_len( tSDP_UUID_SEQ   *uid_seq, tSDP_ATTR_SEQ   *attr_seq );
-extern UINT16 sdpu_get_attrib_seq_len(tSDP_RECORD *p_rec, tSDP_ATTR_SEQ *attr_seq);
 extern UINT16 sdpu_get_attrib_entry_len(tSDP_ATTRIBUTE *p_attr);
-extern UINT8 *sdpu_build_partial_attrib_entry (UINT8 *p_out, tSDP_ATTRIBUTE *p_attr, UINT16 len, UINT16 *offset);
 extern void sdpu_uuid16_to_uuid128(UINT16 uuid16, UINT8* p_uuid128);
+extern BOOLEAN sdpu_uuid_to_uuid128 (UINT8 *p_uuid, UINT32 len, UINT8 *p_uuid128);
 
 /* Functions provided by sdp_db.c
 */
 extern tSDP_RECORD    *sdp_db_service_search (tSDP_RECORD *p_rec, tSDP_UUID_SEQ *p_seq);
 extern tSDP_RECORD    *sdp_db_find_record (UINT32 handle);
 extern tSDP_ATTRIBUTE *sdp_db_find_attr_in_rec (tSDP_RECORD *p_rec, UINT16 start_attr, UINT16 end_attr);
+extern void            sdp_db_serialize_record (tSDP_RECORD *p_rec);
 
 
 /* Functions provided by sdp_server.c
@@ -320,11 +330,23 @@ extern BOOLEAN sdp_dev_blacklisted_for_avrcp15 (BD_ADDR addr);
 #if SDP_CLIENT_ENABLED == TRUE
 extern void sdp_disc_connected (tCONN_CB *p_ccb);
 extern void sdp_disc_server_rsp (tCONN_CB *p_ccb, BT_HDR *p_msg);
+extern UINT16 sdp_disc_save_attr_lists (tCONN_CB *p_ccb);
 #else
 #define sdp_disc_connected(p_ccb)
 #define sdp_disc_server_rsp(p_ccb, p_msg)
 #endif
 
+/* Functions provided by sdp_cache.c
+*/
+#if (SDP_CACHE_INCLUDED == TRUE)
+extern void    sdp_cache_init (void);
+extern BOOLEAN sdp_cache_start_search (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db,
+                                       tSDP_DISC_CMPL_CB *p_cb, tSDP_DISC_CMPL_CB2 *p_cb2,
+                                       void *user_data);
+extern void    sdp_cache_store (tCONN_CB *p_ccb);
+extern void    sdp_cache_search_cmpl (tCONN_CB *p_ccb);
+#endif
+
 
 
 #endif
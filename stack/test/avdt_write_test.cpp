@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "fake_l2cap.h"
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "avdt_api.h"
+#include "avdt_defs.h"
+#include "avdt_int.h"
+#include "gki.h"
+}
+
+#define MEDIA_LCID 0x0045
+#define PAYLOAD_LEN 4
+
+// Every AVDT_WRITE_CFM_EVT the stream got.
+static int write_cfms;
+
+static void ctrl_cback(UINT8 handle, BD_ADDR, UINT8 event, tAVDT_CTRL *) {
+  EXPECT_EQ(1, handle);
+  if (event == AVDT_WRITE_CFM_EVT)
+    ++write_cfms;
+}
+
+static UINT16 be16(const std::vector<UINT8> &data, size_t pos) {
+  return (UINT16)((data[pos] << 8) | data[pos + 1]);
+}
+
+static UINT32 be32(const std::vector<UINT8> &data, size_t pos) {
+  return ((UINT32)be16(data, pos) << 16) | be16(data, pos + 2);
+}
+
+// A streaming source on handle 1, with its media channel open.
+class AvdtWriteBatchTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      l2cap_reset();
+      write_cfms = 0;
+      memset(&avdt_cb, 0, sizeof(avdt_cb));
+      avdt_scb_init();
+
+      p_scb = &avdt_cb.scb[0];
+      p_scb->allocated = TRUE;
+      p_scb->state = AVDT_SCB_STREAM_ST;
+      p_scb->p_ccb = &avdt_cb.ccb[0];
+      p_scb->cs.p_ctrl_cback = ctrl_cback;
+      p_scb->cs.cfg.codec_info[1] = 0x10;
+      p_scb->cs.cfg.codec_info[2] = 0x02;
+      GKI_init_q(&p_scb->media_q);
+      avdt_cb.ad.rt_tbl[0][avdt_ad_type_to_tcid(AVDT_CHAN_MEDIA, p_scb)].lcid = MEDIA_LCID;
+    }
+
+    virtual void TearDown() {
+      EXPECT_TRUE(GKI_queue_is_empty(&p_scb->media_q));
+    }
+
+    // Payload |n| is PAYLOAD_LEN bytes of n, with room for the headers.
+    BT_HDR *media_pkt(UINT8 n) {
+      BT_HDR *p_buf = (BT_HDR *)GKI_getbuf(sizeof(BT_HDR) + AVDT_MEDIA_OFFSET + PAYLOAD_LEN);
+      p_buf->offset = AVDT_MEDIA_OFFSET;
+      p_buf->len = PAYLOAD_LEN;
+      memset((UINT8 *)(p_buf + 1) + p_buf->offset, n, PAYLOAD_LEN);
+      return p_buf;
+    }
+
+    UINT16 write_batch(UINT8 first, UINT8 count, UINT32 ts, UINT8 m_pt) {
+      BT_HDR *pkts[8];
+      UINT32 stamps[8];
+
+      for (UINT8 i = 0; i < count; ++i) {
+        pkts[i] = media_pkt((UINT8)(first + i));
+        stamps[i] = ts + i * 128;
+      }
+      return AVDT_WriteReqBatch(1, count, pkts, stamps, m_pt, AVDT_DATA_OPT_NONE);
+    }
+
+    // Checks PDU |n| sent on the media channel is a media packet with the
+    // sequence number, time stamp and payload given.
+    void expect_media(size_t n, UINT8 m_pt, UINT16 seq, UINT32 ts, UINT8 payload) {
+      ASSERT_LT(n, l2cap_sent.size());
+      const std::vector<UINT8> &data = l2cap_sent[n].data;
+
+      EXPECT_EQ(MEDIA_LCID, l2cap_sent[n].cid);
+      ASSERT_EQ((size_t)(AVDT_MEDIA_HDR_SIZE + PAYLOAD_LEN), data.size());
+      EXPECT_EQ(AVDT_MEDIA_OCTET1, data[0]);
+      EXPECT_EQ(m_pt, data[1]);
+      EXPECT_EQ(seq, be16(data, 2));
+      EXPECT_EQ(ts, be32(data, 4));
+      EXPECT_EQ(0x12u, be32(data, 8));
+      for (int i = 0; i < PAYLOAD_LEN; ++i)
+        EXPECT_EQ(payload, data[AVDT_MEDIA_HDR_SIZE + i]);
+    }
+
+    void set_congested(BOOLEAN congested) {
+      tAVDT_SCB_EVT evt;
+
+      evt.llcong = congested;
+      avdt_scb_event(p_scb, AVDT_SCB_TC_CONG_EVT, &evt);
+    }
+
+    tAVDT_SCB *p_scb;
+};
+
+TEST_F(AvdtWriteBatchTest, test_batch_is_sent_with_one_confirm) {
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(0, 3, 1000, 0x60));
+
+  ASSERT_EQ(3u, l2cap_sent.size());
+  EXPECT_EQ(1, write_cfms);
+  for (int i = 0; i < 3; ++i)
+    expect_media(i, 0x60, (UINT16)(1 + i), 1000 + i * 128, (UINT8)i);
+}
+
+TEST_F(AvdtWriteBatchTest, test_template_is_patched_across_batches) {
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(0, 2, 1000, 0x60));
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(2, 2, 5000, 0x60));
+
+  ASSERT_EQ(4u, l2cap_sent.size());
+  EXPECT_EQ(2, write_cfms);
+  expect_media(0, 0x60, 1, 1000, 0);
+  expect_media(1, 0x60, 2, 1128, 1);
+  expect_media(2, 0x60, 3, 5000, 2);
+  expect_media(3, 0x60, 4, 5128, 3);
+
+  // A new payload type rebuilds the template; the sequence carries on.
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(4, 1, 9000, 0x61));
+  expect_media(4, 0x61, 5, 9000, 4);
+}
+
+TEST_F(AvdtWriteBatchTest, test_sequence_number_wraps) {
+  p_scb->media_seq = 0xFFFF;
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(0, 2, 0xFFFFFF80, 0x60));
+
+  expect_media(0, 0x60, 0, 0xFFFFFF80, 0);
+  expect_media(1, 0x60, 1, 0, 1);
+}
+
+TEST_F(AvdtWriteBatchTest, test_congested_batch_waits_for_channel) {
+  set_congested(TRUE);
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(0, 3, 1000, 0x60));
+  EXPECT_TRUE(l2cap_sent.empty());
+  EXPECT_EQ(0, write_cfms);
+
+  set_congested(FALSE);
+  ASSERT_EQ(3u, l2cap_sent.size());
+  EXPECT_EQ(1, write_cfms);
+  for (int i = 0; i < 3; ++i)
+    expect_media(i, 0x60, (UINT16)(1 + i), 1000 + i * 128, (UINT8)i);
+}
+
+TEST_F(AvdtWriteBatchTest, test_newer_batch_replaces_congested_one) {
+  set_congested(TRUE);
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(0, 3, 1000, 0x60));
+  EXPECT_EQ(AVDT_SUCCESS, write_batch(3, 2, 2000, 0x60));
+
+  set_congested(FALSE);
+  ASSERT_EQ(2u, l2cap_sent.size());
+  EXPECT_EQ(1, write_cfms);
+  expect_media(0, 0x60, 4, 2000, 3);
+  expect_media(1, 0x60, 5, 2128, 4);
+}
+
+TEST_F(AvdtWriteBatchTest, test_bad_params_and_handle) {
+  EXPECT_EQ(AVDT_BAD_PARAMS, AVDT_WriteReqBatch(1, 0, NULL, NULL, 0x60, AVDT_DATA_OPT_NONE));
+
+  // The packets are freed even though the handle is unknown.
+  p_scb->allocated = FALSE;
+  EXPECT_EQ(AVDT_BAD_HANDLE, write_batch(0, 2, 1000, 0x60));
+  EXPECT_TRUE(l2cap_sent.empty());
+  EXPECT_EQ(0, write_cfms);
+}
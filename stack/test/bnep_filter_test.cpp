@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#include "fake_l2cap.h"
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bnep_api.h"
+#include "bnep_int.h"
+#include "gki.h"
+#include "slab.h"
+
+tBNEP_CB bnep_cb;
+tSLAB bnep_bcb_slab;
+}
+
+typedef std::pair<UINT16, UINT16> prot_range_t;
+typedef std::pair<UINT64, UINT64> mcast_range_t;
+
+static void uint64_to_bda(UINT64 value, BD_ADDR bda) {
+  for (int i = BD_ADDR_LEN - 1; i >= 0; --i, value >>= 8)
+    bda[i] = (UINT8)value;
+}
+
+// The filter check as it was before the filters were compiled: a linear walk
+// of the ranges exactly as the peer sent them.
+static BOOLEAN linear_prot_allowed(tBNEP_CONN *p_bcb, UINT16 proto) {
+  UINT16 i;
+
+  if (!p_bcb->rcvd_num_filters)
+    return TRUE;
+  for (i = 0; i < p_bcb->rcvd_num_filters; i++)
+    if (p_bcb->rcvd_prot_filter_start[i] <= proto && proto <= p_bcb->rcvd_prot_filter_end[i])
+      break;
+  return i != p_bcb->rcvd_num_filters;
+}
+
+static BOOLEAN linear_mcast_allowed(tBNEP_CONN *p_bcb, BD_ADDR dest) {
+  UINT16 i;
+
+  if (!(dest[0] & 0x01) || !p_bcb->rcvd_mcast_filters)
+    return TRUE;
+  if (p_bcb->rcvd_mcast_filters == 0xFFFF)
+    return FALSE;
+  for (i = 0; i < p_bcb->rcvd_mcast_filters; i++)
+    if (memcmp(p_bcb->rcvd_mcast_filter_start[i], dest, BD_ADDR_LEN) <= 0 &&
+        memcmp(p_bcb->rcvd_mcast_filter_end[i], dest, BD_ADDR_LEN) >= 0)
+      break;
+  return i != p_bcb->rcvd_mcast_filters;
+}
+
+class BnepFilterTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&bnep_cb, 0, sizeof(bnep_cb));
+      l2cap_reset();
+      p_bcb = &bnep_cb.bcb[0];
+      p_bcb->con_state = BNEP_STATE_CONNECTED;
+      p_bcb->l2cap_cid = 0x0040;
+      memset(unicast, 0x02, sizeof(unicast));
+    }
+
+    // Hands the peer's filter set message to BNEP and returns the response code.
+    UINT16 control(UINT8 type, const std::vector<UINT8> &filters) {
+      std::vector<UINT8> pkt;
+      UINT16 rem_len;
+
+      pkt.push_back(type);
+      pkt.push_back((UINT8)(filters.size() >> 8));
+      pkt.push_back((UINT8)filters.size());
+      pkt.insert(pkt.end(), filters.begin(), filters.end());
+      rem_len = (UINT16)pkt.size();
+      l2cap_sent.clear();
+      bnep_process_control_packet(p_bcb, &pkt[0], &rem_len, FALSE);
+
+      EXPECT_EQ(1u, l2cap_sent.size());
+      if (l2cap_sent.size() != 1)
+        return 0xFFFF;
+      const std::vector<UINT8> &rsp = l2cap_sent[0].data;
+      return (UINT16)((rsp[2] << 8) | rsp[3]);
+    }
+
+    UINT16 set_prot_filters(const std::vector<prot_range_t> &ranges) {
+      std::vector<UINT8> filters;
+      for (size_t i = 0; i < ranges.size(); ++i) {
+        filters.push_back((UINT8)(ranges[i].first >> 8));
+        filters.push_back((UINT8)ranges[i].first);
+        filters.push_back((UINT8)(ranges[i].second >> 8));
+        filters.push_back((UINT8)ranges[i].second);
+      }
+      return control(BNEP_FILTER_NET_TYPE_SET_MSG, filters);
+    }
+
+    UINT16 set_mcast_filters(const std::vector<mcast_range_t> &ranges) {
+      std::vector<UINT8> filters;
+      BD_ADDR bda;
+      for (size_t i = 0; i < ranges.size(); ++i) {
+        uint64_to_bda(ranges[i].first, bda);
+        filters.insert(filters.end(), bda, bda + BD_ADDR_LEN);
+        uint64_to_bda(ranges[i].second, bda);
+        filters.insert(filters.end(), bda, bda + BD_ADDR_LEN);
+      }
+      return control(BNEP_FILTER_MULTI_ADDR_SET_MSG, filters);
+    }
+
+    // An 802.1Q frame is checked by the protocol it carries, so the payload
+    // always holds a tag carrying |proto| again.
+    BOOLEAN prot_allowed(UINT16 proto) {
+      UINT8 tag[4] = { 0, 0, (UINT8)(proto >> 8), (UINT8)proto };
+      return bnep_is_packet_allowed(p_bcb, unicast, proto, FALSE, tag) == BNEP_SUCCESS;
+    }
+
+    BOOLEAN mcast_allowed(UINT64 addr) {
+      BD_ADDR bda;
+      uint64_to_bda(addr, bda);
+      return bnep_is_packet_allowed(p_bcb, bda, BNEP_IPV4_PROTOCOL, FALSE, NULL) == BNEP_SUCCESS;
+    }
+
+    // Every protocol value gets the same answer as the linear check.
+    void expect_prot_matches_linear(void) {
+      for (UINT32 proto = 0; proto <= 0xFFFF; ++proto)
+        ASSERT_EQ(linear_prot_allowed(p_bcb, (UINT16)proto), prot_allowed((UINT16)proto))
+            << "protocol 0x" << std::hex << proto;
+    }
+
+    // Addresses on and next to every range edge, plus random multicast
+    // addresses, get the same answer as the linear check.
+    void expect_mcast_matches_linear(const std::vector<mcast_range_t> &ranges) {
+      std::vector<UINT64> addrs;
+      const UINT64 max = 0xFFFFFFFFFFFFULL;
+
+      for (size_t i = 0; i < ranges.size(); ++i) {
+        UINT64 edges[2] = { ranges[i].first, ranges[i].second };
+        for (int e = 0; e < 2; ++e) {
+          addrs.push_back(edges[e]);
+          if (edges[e] > 0)
+            addrs.push_back(edges[e] - 1);
+          if (edges[e] < max)
+            addrs.push_back(edges[e] + 1);
+        }
+      }
+      for (int i = 0; i < 200; ++i)
+        addrs.push_back((((UINT64)rand() << 24) ^ rand()) & max);
+      addrs.push_back(0);
+      addrs.push_back(max);
+
+      for (size_t i = 0; i < addrs.size(); ++i) {
+        BD_ADDR bda;
+        uint64_to_bda(addrs[i], bda);
+        ASSERT_EQ(linear_mcast_allowed(p_bcb, bda), mcast_allowed(addrs[i]))
+            << "address 0x" << std::hex << addrs[i];
+      }
+    }
+
+    tBNEP_CONN *p_bcb;
+    BD_ADDR unicast;
+};
+
+TEST_F(BnepFilterTest, test_overlapping_ranges_are_merged) {
+  std::vector<prot_range_t> ranges;
+  ranges.push_back(prot_range_t(0x0900, 0x0a00));
+  ranges.push_back(prot_range_t(0x0700, 0x0850));
+  ranges.push_back(prot_range_t(0x0800, 0x0950));
+  ranges.push_back(prot_range_t(0x0780, 0x0790));
+  ASSERT_EQ(BNEP_FILTER_CRL_OK, set_prot_filters(ranges));
+
+  EXPECT_EQ(1, p_bcb->rcvd_prot_ranges);
+  expect_prot_matches_linear();
+}
+
+TEST_F(BnepFilterTest, test_adjacent_ranges_are_merged) {
+  std::vector<prot_range_t> ranges;
+  ranges.push_back(prot_range_t(0x0806, 0x0806));
+  ranges.push_back(prot_range_t(0x0800, 0x0805));
+  ranges.push_back(prot_range_t(0x0807, 0x0810));
+  ranges.push_back(prot_range_t(0x86dd, 0x86dd));
+  ASSERT_EQ(BNEP_FILTER_CRL_OK, set_prot_filters(ranges));
+
+  EXPECT_EQ(2, p_bcb->rcvd_prot_ranges);
+  expect_prot_matches_linear();
+}
+
+TEST_F(BnepFilterTest, test_common_protocols_on_range_edges) {
+  std::vector<prot_range_t> ranges;
+  ranges.push_back(prot_range_t(0x0000, BNEP_IPV4_PROTOCOL));
+  ranges.push_back(prot_range_t(BNEP_ARP_PROTOCOL + 1, 0x1000));
+  ranges.push_back(prot_range_t(BNEP_IPV6_PROTOCOL, 0xFFFF));
+  ASSERT_EQ(BNEP_FILTER_CRL_OK, set_prot_filters(ranges));
+
+  EXPECT_TRUE(prot_allowed(BNEP_IPV4_PROTOCOL));
+  EXPECT_FALSE(prot_allowed(BNEP_ARP_PROTOCOL));
+  EXPECT_TRUE(prot_allowed(BNEP_IPV6_PROTOCOL));
+  expect_prot_matches_linear();
+}
+
+TEST_F(BnepFilterTest, test_random_protocol_filters_match_linear) {
+  srand(34);
+  for (int round = 0; round < 200; ++round) {
+    std::vector<prot_range_t> ranges;
+    int n = 1 + rand() % BNEP_MAX_PROT_FILTERS;
+    for (int i = 0; i < n; ++i) {
+      UINT16 start = (UINT16)(rand() % 0x10000);
+      UINT16 span = (UINT16)(rand() % 3 ? rand() % 0x100 : rand() % 0x4000);
+      ranges.push_back(prot_range_t(start, start + span > 0xFFFF ? 0xFFFF : start + span));
+    }
+    ASSERT_EQ(BNEP_FILTER_CRL_OK, set_prot_filters(ranges));
+    expect_prot_matches_linear();
+  }
+}
+
+TEST_F(BnepFilterTest, test_tagged_frame_is_filtered_on_inner_protocol) {
+  // An 802.1Q frame behind one extension header: ext type, len, 2 bytes, then
+  // the tag and the inner protocol.
+  UINT8 data[] = { 0x00, 0x02, 0xaa, 0xbb, 0x00, 0x05, 0x08, 0x06 };
+  std::vector<prot_range_t> ranges;
+  ranges.push_back(prot_range_t(BNEP_ARP_PROTOCOL, BNEP_ARP_PROTOCOL));
+  ASSERT_EQ(BNEP_FILTER_CRL_OK, set_prot_filters(ranges));
+
+  EXPECT_EQ(BNEP_SUCCESS, bnep_is_packet_allowed(p_bcb, unicast, BNEP_802_1_P_PROTOCOL, TRUE,
+                                                 data));
+  EXPECT_EQ(BNEP_SUCCESS, bnep_is_packet_allowed(p_bcb, unicast, BNEP_802_1_P_PROTOCOL, FALSE,
+                                                 data + 4));
+  data[7] = 0x00;
+  EXPECT_EQ(BNEP_IGNORE_CMD, bnep_is_packet_allowed(p_bcb, unicast, BNEP_802_1_P_PROTOCOL, TRUE,
+                                                    data));
+}
+
+TEST_F(BnepFilterTest, test_bad_range_keeps_previous_filters) {
+  std::vector<prot_range_t> ranges;
+  ranges.push_back(prot_range_t(0x0800, 0x0800));
+  ASSERT_EQ(BNEP_FILTER_CRL_OK, set_prot_filters(ranges));
+
+  ranges.push_back(prot_range_t(0x0900, 0x08ff));
+  EXPECT_EQ(BNEP_FILTER_CRL_BAD_RANGE, set_prot_filters(ranges));
+  EXPECT_EQ(1, p_bcb->rcvd_num_filters);
+  expect_prot_matches_linear();
+}
+
+TEST_F(BnepFilterTest, test_multicast_merged_and_adjacent_ranges) {
+  std::vector<mcast_range_t> ranges;
+  ranges.push_back(mcast_range_t(0x01005e000000ULL, 0x01005e0000ffULL));
+  ranges.push_back(mcast_range_t(0x01005e000100ULL, 0x01005e0001ffULL));
+  ranges.push_back(mcast_range_t(0x01005e000080ULL, 0x01005e000180ULL));
+  ranges.push_back(mcast_range_t(0x333300000001ULL, 0x333300000001ULL));
+  ranges.push_back(mcast_range_t(0x333300000000ULL, 0x333300000000ULL));
+  ASSERT_EQ(BNEP_FILTER_CRL_OK, set_mcast_filters(ranges));
+
+  EXPECT_EQ(2, p_bcb->rcvd_mcast_ranges);
+  expect_mcast_matches_linear(ranges);
+}
+
+TEST_F(BnepFilterTest, test_multicast_block_all) {
+  std::vector<mcast_range_t> ranges;
+  ranges.push_back(mcast_range_t(0x01005e000000ULL, 0x01005effffffULL));
+  ranges.push_back(mcast_range_t(0, 0));
+  ranges.push_back(mcast_range_t(0x333300000000ULL, 0x3333ffffffffULL));
+  ASSERT_EQ(BNEP_FILTER_CRL_OK, set_mcast_filters(ranges));
+
+  EXPECT_EQ(0xFFFF, p_bcb->rcvd_mcast_filters);
+  EXPECT_FALSE(mcast_allowed(0x01005e000001ULL));
+  EXPECT_TRUE(mcast_allowed(0x02005e000001ULL));
+  expect_mcast_matches_linear(ranges);
+}
+
+TEST_F(BnepFilterTest, test_random_multicast_filters_match_linear) {
+  srand(340);
+  for (int round = 0; round < 500; ++round) {
+    std::vector<mcast_range_t> ranges;
+    int n = 1 + rand() % BNEP_MAX_MULTI_FILTERS;
+    for (int i = 0; i < n; ++i) {
+      // Few distinct prefixes, so that ranges overlap and touch.
+      UINT64 start = ((UINT64)(rand() % 4) << 40) | (UINT64)(rand() % 0x400);
+      UINT64 span = rand() % 3 ? rand() % 0x100 : ((UINT64)rand() << 8);
+      ranges.push_back(mcast_range_t(start, start + span));
+    }
+    ASSERT_EQ(BNEP_FILTER_CRL_OK, set_mcast_filters(ranges));
+    expect_mcast_matches_linear(ranges);
+  }
+}
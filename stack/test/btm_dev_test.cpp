@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btm_int.h"
+}
+
+#define NUM_RECS BTM_SEC_MAX_DEVICE_RECORDS
+#define CONN_HANDLE(n) ((UINT16)(0x0100 + (n)))
+
+// Devices are told apart by the number in their last two address bytes.
+static void make_addr(int n, BD_ADDR bd_addr) {
+  static const BD_ADDR base = { 0x00, 0x1A, 0x7D, 0xDA, 0x00, 0x00 };
+
+  memcpy(bd_addr, base, BD_ADDR_LEN);
+  bd_addr[4] = (UINT8)(n >> 8);
+  bd_addr[5] = (UINT8)n;
+}
+
+static int addr_num(const UINT8 *bd_addr) {
+  return (bd_addr[4] << 8) | bd_addr[5];
+}
+
+// Devices with an ACL link, the bonded devices in storage, and the devices
+// the loader was asked for.
+static std::vector<int> connected;
+static std::vector<int> bonded;
+static std::vector<int> loads;
+
+static bool contains(const std::vector<int> &devs, int n) {
+  return std::find(devs.begin(), devs.end(), n) != devs.end();
+}
+
+extern "C" {
+UINT16 BTM_GetHCIConnHandle(BD_ADDR bd_addr, tBT_TRANSPORT transport) {
+  if (transport == BT_TRANSPORT_BR_EDR && contains(connected, addr_num(bd_addr)))
+    return CONN_HANDLE(addr_num(bd_addr));
+  return BTM_INVALID_HCI_HANDLE;
+}
+
+BOOLEAN BTM_IsAclConnectionUp(BD_ADDR bd_addr, tBT_TRANSPORT transport) {
+  return BTM_GetHCIConnHandle(bd_addr, transport) != BTM_INVALID_HCI_HANDLE;
+}
+}
+
+static BOOLEAN add_dev(int n, bool bond) {
+  BD_ADDR bd_addr;
+  LINK_KEY link_key;
+  UINT32 trusted_mask[BTM_SEC_SERVICE_ARRAY_SIZE];
+
+  make_addr(n, bd_addr);
+  memset(link_key, n, sizeof(link_key));
+  memset(trusted_mask, 0, sizeof(trusted_mask));
+  return BTM_SecAddDevice(bd_addr, NULL, NULL, NULL, trusted_mask,
+                          bond ? link_key : NULL, HCI_LKEY_TYPE_COMBINATION,
+                          BTM_IO_CAP_NONE, 0);
+}
+
+// Pages a device in the way the btif storage does, with the key it holds.
+static BOOLEAN load_dev(BD_ADDR bd_addr) {
+  int n = addr_num(bd_addr);
+
+  loads.push_back(n);
+  if (!contains(bonded, n))
+    return FALSE;
+  return add_dev(n, true);
+}
+
+static tBTM_SEC_DEV_REC *find(int n) {
+  BD_ADDR bd_addr;
+
+  make_addr(n, bd_addr);
+  return btm_find_dev(bd_addr);
+}
+
+static tBTM_SEC_DEV_REC *find_or_alloc(int n) {
+  BD_ADDR bd_addr;
+
+  make_addr(n, bd_addr);
+  return btm_find_or_alloc_dev(bd_addr);
+}
+
+class BtmDevTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&btm_cb, 0, sizeof(btm_cb));
+      connected.clear();
+      bonded.clear();
+      loads.clear();
+    }
+
+    virtual void TearDown() {
+      btm_cb.p_dev_load_cback = NULL;
+    }
+
+    // Adds devices first..first+count-1, oldest first.
+    void fill(int first, int count, bool bond) {
+      for (int n = first; n < first + count; ++n)
+        ASSERT_TRUE(add_dev(n, bond));
+    }
+
+    // Every in use record is in exactly one bucket chain, under its address.
+    void expect_indexed() {
+      int linked = 0;
+
+      for (int b = 0; b < BTM_SEC_DEV_HASH_SIZE; ++b) {
+        for (UINT16 idx = btm_cb.sec_dev_hash[b]; idx != 0 && linked <= NUM_RECS;
+             idx = btm_cb.sec_dev_next[idx - 1]) {
+          tBTM_SEC_DEV_REC *p_dev_rec = &btm_cb.sec_dev_rec[idx - 1];
+
+          EXPECT_TRUE(p_dev_rec->sec_flags & BTM_SEC_IN_USE);
+          EXPECT_EQ(p_dev_rec, btm_find_dev(p_dev_rec->bd_addr));
+          ++linked;
+        }
+      }
+      EXPECT_EQ(in_use(), linked);
+    }
+
+    int in_use() {
+      int count = 0;
+
+      for (int i = 0; i < NUM_RECS; ++i)
+        if (btm_cb.sec_dev_rec[i].sec_flags & BTM_SEC_IN_USE)
+          ++count;
+      return count;
+    }
+};
+
+TEST_F(BtmDevTest, test_find_dev_follows_bucket_chains) {
+  fill(0, NUM_RECS, true);
+
+  for (int n = 0; n < NUM_RECS; ++n) {
+    tBTM_SEC_DEV_REC *p_dev_rec = find(n);
+    ASSERT_TRUE(p_dev_rec != NULL);
+    EXPECT_EQ(n, addr_num(p_dev_rec->bd_addr));
+  }
+  EXPECT_TRUE(find(NUM_RECS) == NULL);
+  EXPECT_TRUE(btm_find_dev(NULL) == NULL);
+  expect_indexed();
+
+  // A bucket holding at least three records, to delete from its head, its
+  // middle and its tail.
+  int head = -1;
+  for (int b = 0; b < BTM_SEC_DEV_HASH_SIZE && head < 0; ++b) {
+    UINT16 idx = btm_cb.sec_dev_hash[b];
+    if (idx != 0 && btm_cb.sec_dev_next[idx - 1] != 0 &&
+        btm_cb.sec_dev_next[btm_cb.sec_dev_next[idx - 1] - 1] != 0)
+      head = idx - 1;
+  }
+  ASSERT_LE(0, head);
+
+  int chain[3];
+  UINT16 idx = (UINT16)(head + 1);
+  for (int i = 0; i < 3; ++i, idx = btm_cb.sec_dev_next[idx - 1])
+    chain[i] = addr_num(btm_cb.sec_dev_rec[idx - 1].bd_addr);
+
+  const int order[3] = { 1, 0, 2 };
+  for (int i = 0; i < 3; ++i) {
+    BD_ADDR bd_addr;
+    make_addr(chain[order[i]], bd_addr);
+    ASSERT_TRUE(BTM_SecDeleteDevice(bd_addr));
+    EXPECT_TRUE(find(chain[order[i]]) == NULL);
+    for (int j = i + 1; j < 3; ++j)
+      EXPECT_TRUE(find(chain[order[j]]) != NULL);
+    expect_indexed();
+  }
+  EXPECT_EQ(NUM_RECS - 3, in_use());
+}
+
+TEST_F(BtmDevTest, test_full_table_evicts_oldest_idle) {
+  // The three oldest are connected, pairing and in a collision.
+  connected.push_back(0);
+  fill(0, NUM_RECS, true);
+  find(1)->sec_state = BTM_SEC_STATE_AUTHENTICATING;
+  btm_cb.p_collided_dev_rec = find(2);
+  EXPECT_EQ(CONN_HANDLE(0), find(0)->hci_handle);
+
+  ASSERT_TRUE(add_dev(NUM_RECS, true));
+  EXPECT_TRUE(find(3) == NULL);
+  ASSERT_TRUE(add_dev(NUM_RECS + 1, true));
+  EXPECT_TRUE(find(4) == NULL);
+  for (int n = 0; n < 3; ++n)
+    EXPECT_TRUE(find(n) != NULL);
+  EXPECT_TRUE(find(NUM_RECS) != NULL);
+  EXPECT_TRUE(find(NUM_RECS + 1) != NULL);
+  EXPECT_EQ(NUM_RECS, in_use());
+  expect_indexed();
+
+  // A device that is not paired goes before older bonded devices.
+  find(NUM_RECS - 1)->sec_flags &= ~BTM_SEC_LINK_KEY_KNOWN;
+  ASSERT_TRUE(add_dev(NUM_RECS + 2, true));
+  EXPECT_TRUE(find(NUM_RECS - 1) == NULL);
+  EXPECT_TRUE(find(5) != NULL);
+  expect_indexed();
+}
+
+TEST_F(BtmDevTest, test_full_table_of_busy_evicts_oldest) {
+  for (int n = 0; n < NUM_RECS; ++n)
+    connected.push_back(n);
+  fill(0, NUM_RECS, true);
+
+  // Touching device 0 makes device 1 the oldest.
+  ASSERT_TRUE(add_dev(0, true));
+  ASSERT_TRUE(add_dev(NUM_RECS, true));
+  EXPECT_TRUE(find(1) == NULL);
+  EXPECT_TRUE(find(0) != NULL);
+  EXPECT_TRUE(find(NUM_RECS) != NULL);
+  expect_indexed();
+}
+
+TEST_F(BtmDevTest, test_loader_pages_bonded_devices_in) {
+  BTM_SecRegisterDevLoader(load_dev);
+  for (int n = 0; n < NUM_RECS + 2; ++n)
+    bonded.push_back(n);
+  fill(0, NUM_RECS, true);
+
+  // A bonded device that is not resident comes back with its key, in place
+  // of the oldest.
+  tBTM_SEC_DEV_REC *p_dev_rec = find_or_alloc(NUM_RECS);
+  ASSERT_TRUE(p_dev_rec != NULL);
+  ASSERT_EQ(1u, loads.size());
+  EXPECT_EQ(NUM_RECS, loads[0]);
+  EXPECT_EQ(p_dev_rec, find(NUM_RECS));
+  EXPECT_TRUE(p_dev_rec->sec_flags & BTM_SEC_LINK_KEY_KNOWN);
+  EXPECT_EQ(NUM_RECS, p_dev_rec->link_key[0]);
+  EXPECT_TRUE(find(0) == NULL);
+
+  // A resident device is not loaded again.
+  EXPECT_EQ(p_dev_rec, find_or_alloc(NUM_RECS));
+  EXPECT_EQ(1u, loads.size());
+
+  // The device paged out is paged back in, in place of the next oldest.
+  p_dev_rec = find_or_alloc(0);
+  ASSERT_TRUE(p_dev_rec != NULL);
+  ASSERT_EQ(2u, loads.size());
+  EXPECT_EQ(0, loads[1]);
+  EXPECT_TRUE(p_dev_rec->sec_flags & BTM_SEC_LINK_KEY_KNOWN);
+  EXPECT_TRUE(find(1) == NULL);
+  EXPECT_EQ(NUM_RECS, in_use());
+  expect_indexed();
+  EXPECT_FALSE(btm_cb.dev_loading);
+}
+
+TEST_F(BtmDevTest, test_loader_miss_allocates_new_record) {
+  BTM_SecRegisterDevLoader(load_dev);
+  bonded.push_back(0);
+  fill(0, 1, true);
+
+  // A device storage does not know gets a fresh record, without a key.
+  tBTM_SEC_DEV_REC *p_dev_rec = find_or_alloc(1);
+  ASSERT_TRUE(p_dev_rec != NULL);
+  ASSERT_EQ(1u, loads.size());
+  EXPECT_EQ(1, loads[0]);
+  EXPECT_EQ(p_dev_rec, find(1));
+  EXPECT_FALSE(p_dev_rec->sec_flags & BTM_SEC_LINK_KEY_KNOWN);
+  EXPECT_TRUE(find(0) != NULL);
+  EXPECT_EQ(2, in_use());
+
+  // Without a loader nothing is paged in.
+  BTM_SecRegisterDevLoader(NULL);
+  p_dev_rec = find_or_alloc(2);
+  ASSERT_TRUE(p_dev_rec != NULL);
+  EXPECT_EQ(1u, loads.size());
+  expect_indexed();
+}
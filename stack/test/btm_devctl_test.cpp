@@ -0,0 +1,397 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "hcidefs.h"
+#include "hcimsgs.h"
+}
+
+#define LE_ACL_DATA_SIZE 251
+#define LE_NUM_BUFS 8
+#define MAX_PAGE HCI_EXT_FEATURES_PAGE_1
+#define HCI_VERSION_4_0 0x06
+
+// The controller the reset runs against. Its host supported features live
+// in page 1 and are cleared by every HCI_Reset.
+struct sim_ctrl_t {
+  tBTM_VERSION_INFO version;
+  UINT8 supported_cmds[HCI_NUM_SUPP_COMMANDS_BYTES];
+  BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1];
+  UINT8 white_list_size;
+  UINT8 le_supported_states[BTM_LE_SUPPORT_STATES_LEN];
+  BD_FEATURES le_features;
+};
+
+struct sim_cmd_t {
+  UINT16 opcode;
+  UINT8 param;
+};
+
+static sim_ctrl_t ctrl;
+
+// Commands sent and not answered yet, and every command sent, by round trip.
+static std::vector<sim_cmd_t> pending;
+static std::vector<std::vector<sim_cmd_t> > rounds;
+static bool reset_done;
+
+// The snapshot as NVRAM holds it, and how often it was written.
+static std::vector<UINT8> nvram;
+static int stores;
+
+static void send(UINT16 opcode, UINT8 param) {
+  sim_cmd_t cmd = { opcode, param };
+  pending.push_back(cmd);
+}
+
+static void reset_cback(void *) {
+  reset_done = true;
+}
+
+// Loads the snapshot the way the btif storage does: a blob of another size
+// is copied as far as it goes, but turned down.
+static BOOLEAN load_caps(tBTM_CTRL_CAPS *p_caps) {
+  if (nvram.empty())
+    return FALSE;
+  memcpy(p_caps, &nvram[0], std::min(nvram.size(), sizeof(*p_caps)));
+  return nvram.size() == sizeof(*p_caps);
+}
+
+static void store_caps(const tBTM_CTRL_CAPS *p_caps) {
+  const UINT8 *p = (const UINT8 *)p_caps;
+
+  nvram.assign(p, p + sizeof(*p_caps));
+  ++stores;
+}
+
+extern "C" {
+BOOLEAN btsnd_hcic_reset(UINT8) { send(HCI_RESET, 0); return TRUE; }
+BOOLEAN btsnd_hcic_read_buffer_size(void) { send(HCI_READ_BUFFER_SIZE, 0); return TRUE; }
+BOOLEAN btsnd_hcic_read_local_ver(UINT8) { send(HCI_READ_LOCAL_VERSION_INFO, 0); return TRUE; }
+BOOLEAN btsnd_hcic_read_local_supported_cmds(UINT8) {
+  send(HCI_READ_LOCAL_SUPPORTED_CMDS, 0);
+  return TRUE;
+}
+BOOLEAN btsnd_hcic_read_local_features(void) { send(HCI_READ_LOCAL_FEATURES, 0); return TRUE; }
+BOOLEAN btsnd_hcic_read_local_ext_features(UINT8 page_num) {
+  send(HCI_READ_LOCAL_EXT_FEATURES, page_num);
+  return TRUE;
+}
+BOOLEAN btsnd_hcic_write_simple_pairing_mode(UINT8 mode) {
+  send(HCI_WRITE_SIMPLE_PAIRING_MODE, mode);
+  return TRUE;
+}
+BOOLEAN btsnd_hcic_ble_write_host_supported(UINT8 le_host_spt, UINT8) {
+  send(HCI_WRITE_LE_HOST_SUPPORTED, le_host_spt);
+  return TRUE;
+}
+BOOLEAN btsnd_hcic_ble_read_white_list_size(void) {
+  send(HCI_BLE_READ_WHITE_LIST_SIZE, 0);
+  return TRUE;
+}
+BOOLEAN btsnd_hcic_ble_read_buffer_size(void) { send(HCI_BLE_READ_BUFFER_SIZE, 0); return TRUE; }
+BOOLEAN btsnd_hcic_ble_read_supported_states(void) {
+  send(HCI_BLE_READ_SUPPORTED_STATES, 0);
+  return TRUE;
+}
+BOOLEAN btsnd_hcic_ble_read_local_spt_feat(void) {
+  send(HCI_BLE_READ_LOCAL_SPT_FEAT, 0);
+  return TRUE;
+}
+
+// The vendor hook run between HCI_Reset and the reads hands straight back.
+void bte_main_post_reset_init(void) {
+  BTM_ContinueReset();
+}
+}
+
+// Answers |cmd| as the controller would, through the command complete
+// handler the HCI layer calls for it.
+static void answer(const sim_cmd_t &cmd) {
+  UINT8 rsp[1 + HCI_NUM_SUPP_COMMANDS_BYTES];
+  UINT8 *p = rsp;
+
+  UINT8_TO_STREAM(p, HCI_SUCCESS);
+  switch (cmd.opcode) {
+    case HCI_RESET:
+      ctrl.pages[HCI_EXT_FEATURES_PAGE_1][0] = 0;
+      btm_reset_complete();
+      break;
+
+    case HCI_READ_BUFFER_SIZE:
+      UINT16_TO_STREAM(p, 1021);
+      UINT8_TO_STREAM(p, 64);
+      UINT16_TO_STREAM(p, 8);
+      UINT16_TO_STREAM(p, 2);
+      btm_read_hci_buf_size_complete(rsp, p - rsp);
+      break;
+
+    case HCI_READ_LOCAL_VERSION_INFO:
+      UINT8_TO_STREAM(p, ctrl.version.hci_version);
+      UINT16_TO_STREAM(p, ctrl.version.hci_revision);
+      UINT8_TO_STREAM(p, ctrl.version.lmp_version);
+      UINT16_TO_STREAM(p, ctrl.version.manufacturer);
+      UINT16_TO_STREAM(p, ctrl.version.lmp_subversion);
+      btm_read_local_version_complete(rsp, p - rsp);
+      break;
+
+    case HCI_READ_LOCAL_SUPPORTED_CMDS:
+      ARRAY_TO_STREAM(p, ctrl.supported_cmds, HCI_NUM_SUPP_COMMANDS_BYTES);
+      btm_read_local_supported_cmds_complete(rsp);
+      break;
+
+    case HCI_READ_LOCAL_FEATURES:
+      ARRAY_TO_STREAM(p, ctrl.pages[0], HCI_FEATURE_BYTES_PER_PAGE);
+      btm_read_local_features_complete(rsp, p - rsp);
+      break;
+
+    case HCI_READ_LOCAL_EXT_FEATURES:
+      if (cmd.param > MAX_PAGE) {
+        rsp[0] = HCI_ERR_ILLEGAL_PARAMETER_FMT;
+      } else {
+        UINT8_TO_STREAM(p, cmd.param);
+        UINT8_TO_STREAM(p, MAX_PAGE);
+        ARRAY_TO_STREAM(p, ctrl.pages[cmd.param], HCI_FEATURE_BYTES_PER_PAGE);
+      }
+      btm_read_local_ext_features_complete(rsp, p - rsp);
+      break;
+
+    case HCI_WRITE_SIMPLE_PAIRING_MODE:
+      if (cmd.param)
+        ctrl.pages[HCI_EXT_FEATURES_PAGE_1][HCI_EXT_FEATURE_SSP_HOST_OFF] |=
+            HCI_EXT_FEATURE_SSP_HOST_MASK;
+      btm_write_simple_paring_mode_complete(rsp);
+      break;
+
+    case HCI_WRITE_LE_HOST_SUPPORTED:
+      if (cmd.param)
+        ctrl.pages[HCI_EXT_FEATURES_PAGE_1][HCI_EXT_FEATURE_LE_HOST_OFF] |=
+            HCI_EXT_FEATURE_LE_HOST_MASK;
+      btm_write_le_host_supported_complete(rsp);
+      break;
+
+    case HCI_BLE_READ_WHITE_LIST_SIZE:
+      UINT8_TO_STREAM(p, ctrl.white_list_size);
+      btm_read_white_list_size_complete(rsp, p - rsp);
+      break;
+
+    case HCI_BLE_READ_BUFFER_SIZE:
+      UINT16_TO_STREAM(p, LE_ACL_DATA_SIZE);
+      UINT8_TO_STREAM(p, LE_NUM_BUFS);
+      btm_read_ble_buf_size_complete(rsp, p - rsp);
+      break;
+
+    case HCI_BLE_READ_SUPPORTED_STATES:
+      ARRAY_TO_STREAM(p, ctrl.le_supported_states, BTM_LE_SUPPORT_STATES_LEN);
+      btm_read_ble_local_supported_states_complete(rsp, p - rsp);
+      break;
+
+    case HCI_BLE_READ_LOCAL_SPT_FEAT:
+      ARRAY_TO_STREAM(p, ctrl.le_features, HCI_FEATURE_BYTES_PER_PAGE);
+      btm_read_ble_local_supported_features_complete(rsp, p - rsp);
+      break;
+  }
+}
+
+// A 4.0 controller with SSP and LE, and features pages 0 and 1.
+class BtmDevResetTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&btm_cb, 0, sizeof(btm_cb));
+      memset(&btu_cb, 0, sizeof(btu_cb));
+      memset(&ctrl, 0, sizeof(ctrl));
+      nvram.clear();
+      stores = 0;
+
+      ctrl.version.hci_version = HCI_VERSION_4_0;
+      ctrl.version.hci_revision = 0x1234;
+      ctrl.version.lmp_version = HCI_VERSION_4_0;
+      ctrl.version.manufacturer = LMP_COMPID_BROADCOM;
+      ctrl.version.lmp_subversion = 0x4103;
+      memset(ctrl.supported_cmds, 0xFF, sizeof(ctrl.supported_cmds));
+      ctrl.pages[0][HCI_FEATURE_SIMPLE_PAIRING_OFF] |= HCI_FEATURE_SIMPLE_PAIRING_MASK;
+      ctrl.pages[0][HCI_FEATURE_LE_SPT_OFF] |= HCI_FEATURE_LE_SPT_MASK;
+      ctrl.pages[0][HCI_FEATURE_EXTENDED_OFF] |= HCI_FEATURE_EXTENDED_MASK;
+      ctrl.pages[0][0] = 0xBF;
+      ctrl.white_list_size = 16;
+      memset(ctrl.le_supported_states, 0x3F, sizeof(ctrl.le_supported_states));
+      ctrl.le_features[0] = 0x1F;
+
+      BTM_RegisterCtrlCapsCache(load_caps, store_caps);
+    }
+
+    // Resets the stack side against the controller, answering every command
+    // sent in one round trip before those sent in reply to them.
+    void reset() {
+      pending.clear();
+      rounds.clear();
+      reset_done = false;
+
+      BTM_DeviceReset(reset_cback);
+      while (!pending.empty() && rounds.size() < 20) {
+        std::vector<sim_cmd_t> round;
+
+        round.swap(pending);
+        rounds.push_back(round);
+        for (size_t i = 0; i < round.size(); ++i)
+          answer(round[i]);
+      }
+      ASSERT_TRUE(reset_done);
+      EXPECT_TRUE(BTM_IsDeviceUp());
+    }
+
+    // The number of times |opcode| was sent in round |n|, or in all rounds.
+    int sent(UINT16 opcode, int n = -1) {
+      int count = 0;
+
+      for (size_t r = 0; r < rounds.size(); ++r)
+        for (size_t i = 0; i < rounds[r].size(); ++i)
+          if ((n < 0 || (size_t)n == r) && rounds[r][i].opcode == opcode)
+            ++count;
+      return count;
+    }
+
+    // The round |opcode| was first sent in.
+    int round_of(UINT16 opcode) {
+      for (size_t r = 0; r < rounds.size(); ++r)
+        if (sent(opcode, r))
+          return r;
+      return -1;
+    }
+
+    // Checks the stack took up the controller as it is after the reset.
+    void expect_controller() {
+      tBTM_DEVCB *p_devcb = &btm_cb.devcb;
+
+      EXPECT_EQ(0, memcmp(&ctrl.version, &p_devcb->local_version, sizeof(ctrl.version)));
+      EXPECT_EQ(0, memcmp(ctrl.supported_cmds, p_devcb->supported_cmds,
+                          HCI_NUM_SUPP_COMMANDS_BYTES));
+      for (int page = 0; page <= HCI_EXT_FEATURES_PAGE_MAX; ++page)
+        EXPECT_EQ(0, memcmp(ctrl.pages[page], p_devcb->local_lmp_features[page],
+                            HCI_FEATURE_BYTES_PER_PAGE)) << "page " << page;
+      EXPECT_TRUE(HCI_LE_HOST_SUPPORTED(p_devcb->local_lmp_features[HCI_EXT_FEATURES_PAGE_1]));
+      EXPECT_EQ(0, memcmp(ctrl.le_supported_states, p_devcb->le_supported_states,
+                          BTM_LE_SUPPORT_STATES_LEN));
+      EXPECT_EQ(0, memcmp(ctrl.le_features, p_devcb->local_le_features,
+                          HCI_FEATURE_BYTES_PER_PAGE));
+      EXPECT_EQ(ctrl.white_list_size, btm_cb.ble_ctr_cb.max_filter_entries);
+      EXPECT_EQ(LE_ACL_DATA_SIZE, btu_cb.hcit_ble_acl_data_size);
+    }
+
+    // Checks NVRAM holds the controller as it was before host support was
+    // written.
+    void expect_snapshot() {
+      tBTM_CTRL_CAPS caps;
+
+      ASSERT_EQ(sizeof(caps), nvram.size());
+      memcpy(&caps, &nvram[0], sizeof(caps));
+      EXPECT_EQ(0, memcmp(&ctrl.version, &caps.version, sizeof(ctrl.version)));
+      EXPECT_EQ(0, memcmp(ctrl.supported_cmds, caps.supported_cmds, HCI_NUM_SUPP_COMMANDS_BYTES));
+      EXPECT_EQ(MAX_PAGE, caps.max_page);
+      EXPECT_EQ(0, memcmp(ctrl.pages[0], caps.lmp_features[0], HCI_FEATURE_BYTES_PER_PAGE));
+      EXPECT_FALSE(HCI_SSP_HOST_SUPPORTED(caps.lmp_features[HCI_EXT_FEATURES_PAGE_1]));
+      EXPECT_FALSE(HCI_LE_HOST_SUPPORTED(caps.lmp_features[HCI_EXT_FEATURES_PAGE_1]));
+      EXPECT_TRUE(caps.le_valid);
+      EXPECT_EQ(LE_ACL_DATA_SIZE, caps.le_acl_data_size);
+      EXPECT_EQ(LE_NUM_BUFS, caps.le_num_bufs);
+      EXPECT_EQ(ctrl.white_list_size, caps.white_list_size);
+      EXPECT_EQ(0, memcmp(ctrl.le_features, caps.le_features, HCI_FEATURE_BYTES_PER_PAGE));
+    }
+
+    // Checks the last reset read everything from the controller again.
+    void expect_full_read() {
+      EXPECT_EQ(1, sent(HCI_READ_LOCAL_SUPPORTED_CMDS));
+      EXPECT_EQ(HCI_EXT_FEATURES_PAGE_MAX + 2, sent(HCI_READ_LOCAL_EXT_FEATURES));
+      EXPECT_EQ(1, sent(HCI_BLE_READ_WHITE_LIST_SIZE));
+      EXPECT_EQ(1, sent(HCI_BLE_READ_BUFFER_SIZE));
+      EXPECT_EQ(1, sent(HCI_BLE_READ_SUPPORTED_STATES));
+      EXPECT_EQ(1, sent(HCI_BLE_READ_LOCAL_SPT_FEAT));
+    }
+};
+
+TEST_F(BtmDevResetTest, test_each_stage_is_read_at_once) {
+  reset();
+
+  // Buffer size and version go out together right after the reset.
+  int version = round_of(HCI_READ_LOCAL_VERSION_INFO);
+  EXPECT_EQ(1, version);
+  EXPECT_EQ(1, sent(HCI_READ_BUFFER_SIZE, version));
+
+  // Then the supported commands and every features page; page 1 is read
+  // once more after host support is written.
+  int features = round_of(HCI_READ_LOCAL_SUPPORTED_CMDS);
+  EXPECT_EQ(version + 1, features);
+  EXPECT_EQ(HCI_EXT_FEATURES_PAGE_MAX + 1, sent(HCI_READ_LOCAL_EXT_FEATURES, features));
+  for (UINT8 page = 0; page <= HCI_EXT_FEATURES_PAGE_MAX; ++page)
+    EXPECT_EQ(page, rounds[features][1 + page].param);
+
+  // Host support is written once, after the last of them is in.
+  EXPECT_EQ(1, sent(HCI_WRITE_SIMPLE_PAIRING_MODE));
+  EXPECT_EQ(features + 1, round_of(HCI_WRITE_SIMPLE_PAIRING_MODE));
+
+  // And the LE reads, all four together.
+  int le = round_of(HCI_BLE_READ_WHITE_LIST_SIZE);
+  EXPECT_LT(features, le);
+  EXPECT_EQ(1, sent(HCI_BLE_READ_BUFFER_SIZE, le));
+  EXPECT_EQ(1, sent(HCI_BLE_READ_SUPPORTED_STATES, le));
+  EXPECT_EQ(1, sent(HCI_BLE_READ_LOCAL_SPT_FEAT, le));
+
+  expect_full_read();
+  expect_controller();
+  EXPECT_EQ(1, stores);
+  expect_snapshot();
+}
+
+TEST_F(BtmDevResetTest, test_snapshot_of_same_firmware_skips_the_reads) {
+  reset();
+  size_t full_rounds = rounds.size();
+
+  reset();
+
+  // Only page 1 is read again, for the host supported bits.
+  EXPECT_EQ(0, sent(HCI_READ_LOCAL_SUPPORTED_CMDS));
+  EXPECT_EQ(1, sent(HCI_READ_LOCAL_EXT_FEATURES));
+  EXPECT_EQ(0, sent(HCI_BLE_READ_WHITE_LIST_SIZE));
+  EXPECT_EQ(0, sent(HCI_BLE_READ_BUFFER_SIZE));
+  EXPECT_EQ(0, sent(HCI_BLE_READ_SUPPORTED_STATES));
+  EXPECT_EQ(0, sent(HCI_BLE_READ_LOCAL_SPT_FEAT));
+  EXPECT_EQ(full_rounds - 2, rounds.size());
+
+  expect_controller();
+  EXPECT_EQ(1, stores);
+}
+
+TEST_F(BtmDevResetTest, test_snapshot_of_other_firmware_is_read_again) {
+  reset();
+
+  ++ctrl.version.lmp_subversion;
+  ctrl.white_list_size = 32;
+  ctrl.le_features[0] = 0x01;
+  reset();
+
+  expect_full_read();
+  expect_controller();
+  EXPECT_EQ(2, stores);
+  expect_snapshot();
+}
+
+TEST_F(BtmDevResetTest, test_snapshot_of_wrong_size_is_read_again) {
+  reset();
+
+  // A snapshot written by a build with a different layout; what it holds
+  // still matches the controller, as far as it goes.
+  nvram.resize(nvram.size() - 1);
+  reset();
+
+  expect_full_read();
+  expect_controller();
+  EXPECT_EQ(2, stores);
+  expect_snapshot();
+}
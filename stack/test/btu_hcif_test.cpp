@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btu.h"
+#include "gki.h"
+#include "hcidefs.h"
+#include "hcimsgs.h"
+}
+
+// Eight vendor specific opcodes that all fall in the same hash bucket.
+#define NUM_OPCODES 8
+#define VSC_OPCODE(n) ((UINT16)(HCI_GRP_VENDOR_SPECIFIC | ((n) << 4) | 0x01))
+
+struct vsc_cmpl_t {
+  UINT16 opcode;
+  UINT8 tag;
+  UINT8 status;
+};
+
+// Opcodes handed to the transport, and the completions the callers got.
+static std::vector<UINT16> lower;
+static std::vector<vsc_cmpl_t> cmpls;
+
+extern "C" {
+void bte_main_hci_send(BT_HDR *p_msg, UINT16) {
+  UINT8 *p = (UINT8 *)(p_msg + 1) + p_msg->offset;
+  UINT16 opcode;
+
+  STREAM_TO_UINT16(opcode, p);
+  lower.push_back(opcode);
+  GKI_freebuf(p_msg);
+}
+}
+
+// Every command carries its send order as context, to tell which of those
+// with the same opcode completed.
+static void vsc_cback(tBTM_VSC_CMPL *p_params) {
+  vsc_cmpl_t cmpl = { p_params->opcode, 0xFF, p_params->p_param_buf[0] };
+
+  if (p_params->context_len == 1)
+    cmpl.tag = p_params->p_context[0];
+  cmpls.push_back(cmpl);
+}
+
+static UINT32 gki_free_bufs(void) {
+  UINT32 count = 0;
+
+  for (UINT8 pool = 0; pool < GKI_NUM_TOTAL_BUF_POOLS; ++pool)
+    count += GKI_poolfreecount(pool);
+  return count;
+}
+
+class BtuHcifPendTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&btu_cb, 0, sizeof(btu_cb));
+      btu_hcif_init_cmd_cb(LOCAL_BR_EDR_CONTROLLER_ID);
+      p_cmd_cb = &btu_cb.hci_cmd_cb[LOCAL_BR_EDR_CONTROLLER_ID];
+      p_cmd_cb->cmd_window = 0xFF;
+      lower.clear();
+      cmpls.clear();
+      free_bufs = gki_free_bufs();
+    }
+
+    virtual void TearDown() {
+      while (p_cmd_cb->pend_count != 0 && !HasFatalFailure())
+        complete(p_cmd_cb->pend[oldest()].opcode);
+      EXPECT_EQ(free_bufs, gki_free_bufs());
+    }
+
+    // Sends vendor specific command |tag| the way btsnd_hcic_vendor_spec_cmd_ctx
+    // lays it out: callback, then context, then the HCI packet.
+    void send(UINT16 opcode, UINT8 tag) {
+      BT_HDR *p_buf = (BT_HDR *)GKI_getbuf(sizeof(BT_HDR) + sizeof(void *) + 1 +
+                                           HCIC_PREAMBLE_SIZE);
+      UINT8 *p = (UINT8 *)(p_buf + 1);
+      void *p_cback = (void *)vsc_cback;
+
+      p_buf->len = HCIC_PREAMBLE_SIZE;
+      p_buf->offset = sizeof(void *) + 1;
+      p_buf->layer_specific = 1;
+      memcpy(p, &p_cback, sizeof(p_cback));
+      p += sizeof(void *);
+      UINT8_TO_STREAM(p, tag);
+      UINT16_TO_STREAM(p, opcode);
+      UINT8_TO_STREAM(p, 0);
+      btu_hcif_send_cmd(LOCAL_BR_EDR_CONTROLLER_ID, p_buf);
+    }
+
+    // Sends command n with opcode n % NUM_OPCODES for every n below |count|,
+    // so each opcode is outstanding more than once.
+    void fill(int count) {
+      for (int n = 0; n < count; ++n)
+        send(VSC_OPCODE(n % NUM_OPCODES), (UINT8)n);
+    }
+
+    void complete(UINT16 opcode) {
+      UINT8 evt[] = { HCI_COMMAND_COMPLETE_EVT, 4, 1,
+                      (UINT8)opcode, (UINT8)(opcode >> 8), HCI_SUCCESS };
+      BT_HDR *p_msg = (BT_HDR *)GKI_getbuf(sizeof(BT_HDR) + sizeof(evt));
+
+      p_msg->offset = 0;
+      p_msg->len = sizeof(evt);
+      memcpy(p_msg + 1, evt, sizeof(evt));
+      btu_hcif_process_event(LOCAL_BR_EDR_CONTROLLER_ID, p_msg);
+      GKI_freebuf(p_msg);
+    }
+
+    // The slot of the outstanding command sent first.
+    UINT8 oldest() {
+      UINT8 slot = BTU_CMD_SLOT_NONE;
+
+      for (UINT8 i = 0; i < BTU_MAX_PEND_CMDS; ++i)
+        if (p_cmd_cb->pend[i].p_cmd != NULL &&
+            (slot == BTU_CMD_SLOT_NONE || p_cmd_cb->pend[i].seq < p_cmd_cb->pend[slot].seq))
+          slot = i;
+      return slot;
+    }
+
+    // Checks the last completion was command |tag| with |status|.
+    void expect_cmpl(int tag, UINT8 status) {
+      ASSERT_FALSE(cmpls.empty());
+      EXPECT_EQ(VSC_OPCODE(tag % NUM_OPCODES), cmpls.back().opcode);
+      EXPECT_EQ(tag, cmpls.back().tag);
+      EXPECT_EQ(status, cmpls.back().status);
+    }
+
+    tHCI_CMD_CB *p_cmd_cb;
+    UINT32 free_bufs;
+};
+
+TEST_F(BtuHcifPendTest, test_full_table_holds_back_commands) {
+  fill(BTU_MAX_PEND_CMDS + 1);
+
+  // Every opcode falls in one bucket, all chained there.
+  for (int n = 1; n < NUM_OPCODES; ++n)
+    ASSERT_EQ(BTU_CMD_HASH(VSC_OPCODE(0)), BTU_CMD_HASH(VSC_OPCODE(n)));
+  EXPECT_EQ(BTU_MAX_PEND_CMDS, p_cmd_cb->pend_count);
+  EXPECT_EQ((size_t)BTU_MAX_PEND_CMDS, lower.size());
+  EXPECT_EQ(1u, p_cmd_cb->cmd_xmit_q.count);
+
+  // A completion frees a slot for the command held back.
+  complete(VSC_OPCODE(0));
+  expect_cmpl(0, HCI_SUCCESS);
+  EXPECT_EQ(BTU_MAX_PEND_CMDS, p_cmd_cb->pend_count);
+  ASSERT_EQ((size_t)BTU_MAX_PEND_CMDS + 1, lower.size());
+  EXPECT_EQ(VSC_OPCODE(BTU_MAX_PEND_CMDS % NUM_OPCODES), lower.back());
+  EXPECT_EQ(0u, p_cmd_cb->cmd_xmit_q.count);
+}
+
+TEST_F(BtuHcifPendTest, test_completion_finds_oldest_with_opcode) {
+  fill(BTU_MAX_PEND_CMDS);
+
+  // Out of send order, the commands of one opcode in the order they went.
+  complete(VSC_OPCODE(5));
+  expect_cmpl(5, HCI_SUCCESS);
+  complete(VSC_OPCODE(5));
+  expect_cmpl(5 + NUM_OPCODES, HCI_SUCCESS);
+  EXPECT_EQ(BTU_MAX_PEND_CMDS - 2, p_cmd_cb->pend_count);
+
+  // An opcode nothing is waiting for has no command to complete.
+  complete(VSC_OPCODE(5));
+  EXPECT_EQ(2u, cmpls.size());
+  EXPECT_EQ(BTU_MAX_PEND_CMDS - 2, p_cmd_cb->pend_count);
+
+  // The rest, last sent first, leave the table empty.
+  for (int n = BTU_MAX_PEND_CMDS - 1; n >= 0; --n) {
+    if (n % NUM_OPCODES == 5)
+      continue;
+    complete(VSC_OPCODE(n % NUM_OPCODES));
+    expect_cmpl(n >= NUM_OPCODES ? n - NUM_OPCODES : n + NUM_OPCODES, HCI_SUCCESS);
+  }
+  EXPECT_EQ(0, p_cmd_cb->pend_count);
+  for (int b = 0; b < BTU_CMD_HASH_SIZE; ++b)
+    EXPECT_EQ(BTU_CMD_SLOT_NONE, p_cmd_cb->pend_hash[b]);
+
+  const tHCI_CMD_STATS *p_stats = btu_hcif_get_cmd_stats(LOCAL_BR_EDR_CONTROLLER_ID,
+                                                         VSC_OPCODE(5));
+  ASSERT_TRUE(p_stats != NULL);
+  EXPECT_EQ(2u, p_stats->count);
+  EXPECT_EQ(0u, p_stats->timeouts);
+}
+
+TEST_F(BtuHcifPendTest, test_timeout_evicts_oldest) {
+  fill(BTU_MAX_PEND_CMDS + 1);
+
+  // Command 0 is the oldest even once a newer one of its bucket completed.
+  complete(VSC_OPCODE(3));
+  expect_cmpl(3, HCI_SUCCESS);
+  ASSERT_EQ(0u, p_cmd_cb->cmd_xmit_q.count);
+
+  btu_hcif_cmd_timeout(LOCAL_BR_EDR_CONTROLLER_ID);
+  expect_cmpl(0, HCI_ERR_UNSPECIFIED);
+  EXPECT_EQ(BTU_MAX_PEND_CMDS - 1, p_cmd_cb->pend_count);
+
+  const tHCI_CMD_STATS *p_stats = btu_hcif_get_cmd_stats(LOCAL_BR_EDR_CONTROLLER_ID,
+                                                         VSC_OPCODE(0));
+  ASSERT_TRUE(p_stats != NULL);
+  EXPECT_EQ(1u, p_stats->count);
+  EXPECT_EQ(1u, p_stats->timeouts);
+
+  // The next command with its opcode is still found, and command 1 is now
+  // the one to time out.
+  complete(VSC_OPCODE(0));
+  expect_cmpl(NUM_OPCODES, HCI_SUCCESS);
+  btu_hcif_cmd_timeout(LOCAL_BR_EDR_CONTROLLER_ID);
+  expect_cmpl(1, HCI_ERR_UNSPECIFIED);
+}
@@ -0,0 +1,61 @@
+#include "fake_l2cap.h"
+
+#include <map>
+
+extern "C" {
+#include "gki.h"
+#include "l2c_api.h"
+}
+
+std::vector<l2cap_pdu_t> l2cap_sent;
+
+static std::map<UINT8, UINT8> results;
+static std::map<UINT16, tL2CAP_FIXED_CHNL_REG> fixed_regs;
+
+void l2cap_set_result(UINT8 peer, UINT8 result) {
+  results[peer] = result;
+}
+
+void l2cap_fixed_congestion(UINT16 fixed_cid, UINT8 peer, BOOLEAN congested) {
+  BD_ADDR bda = {0};
+
+  bda[BD_ADDR_LEN - 1] = peer;
+  if (fixed_regs.count(fixed_cid) && fixed_regs[fixed_cid].pL2CA_FixedCong_Cb)
+    fixed_regs[fixed_cid].pL2CA_FixedCong_Cb(bda, congested);
+}
+
+void l2cap_reset(void) {
+  l2cap_sent.clear();
+  results.clear();
+}
+
+// Takes the buffer as L2CAP would; a failed send frees it too.
+static UINT8 send(UINT16 cid, UINT8 peer, BT_HDR *p_buf) {
+  l2cap_pdu_t pdu;
+  UINT8 *p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+  UINT8 result = results.count(peer) ? results[peer] : L2CAP_DW_SUCCESS;
+
+  if (result != L2CAP_DW_FAILED) {
+    pdu.cid = cid;
+    pdu.peer = peer;
+    pdu.data.assign(p, p + p_buf->len);
+    l2cap_sent.push_back(pdu);
+  }
+  GKI_freebuf(p_buf);
+  return result;
+}
+
+extern "C" {
+BOOLEAN L2CA_RegisterFixedChannel(UINT16 fixed_cid, tL2CAP_FIXED_CHNL_REG *p_freg) {
+  fixed_regs[fixed_cid] = *p_freg;
+  return TRUE;
+}
+
+UINT16 L2CA_SendFixedChnlData(UINT16 fixed_cid, BD_ADDR rem_bda, BT_HDR *p_buf) {
+  return send(fixed_cid, rem_bda[BD_ADDR_LEN - 1], p_buf);
+}
+
+UINT8 L2CA_DataWrite(UINT16 cid, BT_HDR *p_data) {
+  return send(cid, 0, p_data);
+}
+}
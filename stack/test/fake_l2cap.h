@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+}
+
+// A PDU handed to L2CAP: the channel, the peer of a fixed channel and the bytes
+// from the buffer offset on.
+struct l2cap_pdu_t {
+  UINT16 cid;
+  UINT8 peer;
+  std::vector<UINT8> data;
+};
+
+// Everything sent through L2CA_SendFixedChnlData and L2CA_DataWrite, in order.
+extern std::vector<l2cap_pdu_t> l2cap_sent;
+
+// The L2CAP_DW_* result given to the next sends on a channel to a peer, by the
+// last byte of the peer address; L2CAP_DW_SUCCESS if not set.
+void l2cap_set_result(UINT8 peer, UINT8 result);
+
+// Reports the fixed channel to a peer congested or not through the callback
+// registered for the channel, as L2CAP does when its transmit queue fills or
+// drains.
+void l2cap_fixed_congestion(UINT16 fixed_cid, UINT8 peer, BOOLEAN congested);
+
+void l2cap_reset(void);
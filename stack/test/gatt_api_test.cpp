@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include "fake_l2cap.h"
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "gki.h"
+#include "l2c_api.h"
+}
+
+#define GATT_IF     1
+#define NUM_LINKS   3
+#define ATTR_HANDLE 0x0042
+
+static const UINT16 mtus[NUM_LINKS] = { GATT_DEF_BLE_MTU_SIZE, 50, 185 };
+
+// Free buffers over all GKI pools, to check no buffer is left behind.
+static UINT32 gki_free_bufs(void) {
+  UINT32 count = 0;
+
+  for (UINT8 pool = 0; pool < GKI_NUM_TOTAL_BUF_POOLS; ++pool)
+    count += GKI_poolfreecount(pool);
+  return count;
+}
+
+class GattNotifyMultiTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&gatt_cb, 0, sizeof(gatt_cb));
+      l2cap_reset();
+      gatt_cb.cl_rcb[GATT_IF - 1].in_use = TRUE;
+      gatt_cb.cl_rcb[GATT_IF - 1].gatt_if = GATT_IF;
+
+      for (UINT8 i = 0; i < NUM_LINKS; ++i) {
+        tGATT_TCB *p_tcb = &gatt_cb.tcb[i];
+        p_tcb->in_use = TRUE;
+        p_tcb->tcb_idx = i;
+        p_tcb->att_lcid = L2CAP_ATT_CID;
+        p_tcb->payload_size = mtus[i];
+        p_tcb->peer_bda[BD_ADDR_LEN - 1] = i;
+        conn_ids[i] = GATT_CREATE_CONN_ID(i, GATT_IF);
+      }
+
+      for (int i = 0; i < (int)sizeof(value); ++i)
+        value[i] = (UINT8)i;
+      free_bufs = gki_free_bufs();
+    }
+
+    virtual void TearDown() {
+      EXPECT_EQ(free_bufs, gki_free_bufs());
+    }
+
+    // The PDUs sent to link |i|.
+    std::vector<l2cap_pdu_t> sent_to(UINT8 i) {
+      std::vector<l2cap_pdu_t> pdus;
+      for (size_t n = 0; n < l2cap_sent.size(); ++n)
+        if (l2cap_sent[n].peer == i)
+          pdus.push_back(l2cap_sent[n]);
+      return pdus;
+    }
+
+    // Checks the notification to link |i| holds the first |len| value bytes.
+    void expect_notification(UINT8 i, size_t len) {
+      std::vector<l2cap_pdu_t> pdus = sent_to(i);
+      ASSERT_EQ(1u, pdus.size());
+      EXPECT_EQ(L2CAP_ATT_CID, pdus[0].cid);
+      ASSERT_EQ(3 + len, pdus[0].data.size());
+      EXPECT_EQ(GATT_HANDLE_VALUE_NOTIF, pdus[0].data[0]);
+      EXPECT_EQ(ATTR_HANDLE & 0xff, pdus[0].data[1]);
+      EXPECT_EQ(ATTR_HANDLE >> 8, pdus[0].data[2]);
+      EXPECT_EQ(0, memcmp(value, &pdus[0].data[3], len));
+    }
+
+    UINT16 conn_ids[NUM_LINKS];
+    tGATT_STATUS status[NUM_LINKS];
+    UINT8 value[200];
+    UINT32 free_bufs;
+};
+
+TEST_F(GattNotifyMultiTest, test_each_link_gets_copy_cut_to_its_mtu) {
+  EXPECT_EQ(GATT_SUCCESS, GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, ATTR_HANDLE,
+                                                       sizeof(value), value, status));
+
+  for (UINT8 i = 0; i < NUM_LINKS; ++i) {
+    EXPECT_EQ(GATT_SUCCESS, status[i]);
+    expect_notification(i, mtus[i] - 3);
+  }
+}
+
+TEST_F(GattNotifyMultiTest, test_short_value_is_sent_whole) {
+  EXPECT_EQ(GATT_SUCCESS, GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, ATTR_HANDLE,
+                                                       10, value, status));
+
+  for (UINT8 i = 0; i < NUM_LINKS; ++i)
+    expect_notification(i, 10);
+}
+
+TEST_F(GattNotifyMultiTest, test_status_per_link) {
+  gatt_cb.tcb[2].congested = TRUE;
+  l2cap_set_result(1, L2CAP_DW_CONGESTED);
+
+  EXPECT_EQ(GATT_SUCCESS, GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, ATTR_HANDLE,
+                                                       sizeof(value), value, status));
+
+  EXPECT_EQ(GATT_SUCCESS, status[0]);
+  EXPECT_EQ(GATT_CONGESTED, status[1]);
+  EXPECT_EQ(GATT_BUSY, status[2]);
+  expect_notification(0, mtus[0] - 3);
+  expect_notification(1, mtus[1] - 3);
+  EXPECT_TRUE(sent_to(2).empty());
+
+  // The link that became congested is skipped from now on.
+  EXPECT_TRUE(gatt_cb.tcb[1].congested);
+  l2cap_sent.clear();
+  GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, ATTR_HANDLE, 10, value, status);
+  EXPECT_EQ(GATT_SUCCESS, status[0]);
+  EXPECT_EQ(GATT_BUSY, status[1]);
+  EXPECT_EQ(1u, l2cap_sent.size());
+}
+
+TEST_F(GattNotifyMultiTest, test_unknown_connection_does_not_stop_others) {
+  conn_ids[1] = GATT_CREATE_CONN_ID(NUM_LINKS, GATT_IF);
+  conn_ids[2] = GATT_CREATE_CONN_ID(2, GATT_IF + 1);
+
+  EXPECT_EQ(GATT_SUCCESS, GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, ATTR_HANDLE,
+                                                       10, value, status));
+  EXPECT_EQ(GATT_SUCCESS, status[0]);
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, status[1]);
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, status[2]);
+  EXPECT_EQ(1u, l2cap_sent.size());
+}
+
+TEST_F(GattNotifyMultiTest, test_failure_on_every_link_is_returned) {
+  for (UINT8 i = 0; i < NUM_LINKS; ++i)
+    l2cap_set_result(i, L2CAP_DW_FAILED);
+
+  EXPECT_EQ(GATT_INTERNAL_ERROR, GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, ATTR_HANDLE,
+                                                              10, value, status));
+  for (UINT8 i = 0; i < NUM_LINKS; ++i)
+    EXPECT_EQ(GATT_INTERNAL_ERROR, status[i]);
+}
+
+TEST_F(GattNotifyMultiTest, test_bad_parameters_are_rejected) {
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTS_HandleValueNotifyMulti(0, conn_ids, ATTR_HANDLE,
+                                                                 10, value, status));
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, 0,
+                                                                 10, value, status));
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTS_HandleValueNotifyMulti(NUM_LINKS, conn_ids, ATTR_HANDLE,
+                                                                 GATT_MAX_ATTR_LEN + 1, value,
+                                                                 status));
+  EXPECT_TRUE(l2cap_sent.empty());
+}
@@ -0,0 +1,484 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "fake_l2cap.h"
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "gki.h"
+#include "l2c_api.h"
+}
+
+#define NUM_APPS 4
+
+// A completed client operation, as the application saw it.
+struct completion_t {
+  UINT16 conn_id;
+  tGATTC_OPTYPE op;
+  tGATT_STATUS status;
+  UINT16 handle;
+  std::vector<UINT8> value;
+};
+
+static std::vector<completion_t> completions;
+
+static void cmpl_cb(UINT16 conn_id, tGATTC_OPTYPE op, tGATT_STATUS status,
+                    tGATT_CL_COMPLETE *p_data) {
+  completion_t c;
+
+  c.conn_id = conn_id;
+  c.op = op;
+  c.status = status;
+  c.handle = p_data->att_value.handle;
+  c.value.assign(p_data->att_value.value, p_data->att_value.value + p_data->att_value.len);
+  completions.push_back(c);
+}
+
+// Free buffers over all GKI pools, to check no buffer is left behind.
+static UINT32 gki_free_bufs(void) {
+  UINT32 count = 0;
+
+  for (UINT8 pool = 0; pool < GKI_NUM_TOTAL_BUF_POOLS; ++pool)
+    count += GKI_poolfreecount(pool);
+  return count;
+}
+
+static UINT16 conn_id(tGATT_IF gatt_if) {
+  return GATT_CREATE_CONN_ID(0, gatt_if);
+}
+
+class GattClTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&gatt_cb, 0, sizeof(gatt_cb));
+      memset(&cback, 0, sizeof(cback));
+      l2cap_reset();
+      completions.clear();
+
+      cback.p_cmpl_cb = cmpl_cb;
+      for (tGATT_IF gatt_if = 1; gatt_if <= NUM_APPS; ++gatt_if) {
+        gatt_cb.cl_rcb[gatt_if - 1].in_use = TRUE;
+        gatt_cb.cl_rcb[gatt_if - 1].gatt_if = gatt_if;
+        gatt_cb.cl_rcb[gatt_if - 1].app_cb = cback;
+      }
+
+      p_tcb = &gatt_cb.tcb[0];
+      p_tcb->in_use = TRUE;
+      p_tcb->tcb_idx = 0;
+      p_tcb->transport = BT_TRANSPORT_LE;
+      p_tcb->att_lcid = L2CAP_ATT_CID;
+      p_tcb->payload_size = 185;
+      free_bufs = gki_free_bufs();
+    }
+
+    virtual void TearDown() {
+      for (int i = 0; i < GATT_CL_MAX_LCB; ++i)
+        if (p_tcb->cl_cmd_q[i].p_cmd)
+          GKI_freebuf(p_tcb->cl_cmd_q[i].p_cmd);
+      EXPECT_EQ(free_bufs, gki_free_bufs());
+    }
+
+    void read(tGATT_IF gatt_if, UINT16 handle) {
+      tGATT_READ_PARAM param;
+
+      memset(&param, 0, sizeof(param));
+      param.by_handle.handle = handle;
+      param.by_handle.auth_req = GATT_AUTH_REQ_NONE;
+      ASSERT_EQ(GATT_SUCCESS, GATTC_Read(conn_id(gatt_if), GATT_READ_BY_HANDLE, &param));
+    }
+
+    // Hands a server PDU, opcode first, to the client.
+    void respond(const std::vector<UINT8> &pdu) {
+      std::vector<UINT8> copy(pdu);
+      gatt_client_handle_server_rsp(p_tcb, copy[0], (UINT16)(copy.size() - 1), &copy[1]);
+    }
+
+    void respond_read(const char *value) {
+      std::vector<UINT8> pdu(1, GATT_RSP_READ);
+      pdu.insert(pdu.end(), value, value + strlen(value));
+      respond(pdu);
+    }
+
+    void respond_error(UINT8 req_op, UINT16 handle, UINT8 reason) {
+      std::vector<UINT8> pdu;
+      pdu.push_back(GATT_RSP_ERROR);
+      pdu.push_back(req_op);
+      pdu.push_back(handle & 0xff);
+      pdu.push_back(handle >> 8);
+      pdu.push_back(reason);
+      respond(pdu);
+    }
+
+    // A Read Multiple Variable Length response: each value with its length,
+    // the declared length of a value being |declared| if not zero.
+    static void add_value(std::vector<UINT8> &pdu, const char *value, UINT16 declared = 0) {
+      UINT16 len = declared ? declared : (UINT16)strlen(value);
+      pdu.push_back(len & 0xff);
+      pdu.push_back(len >> 8);
+      pdu.insert(pdu.end(), value, value + strlen(value));
+    }
+
+    // The handles of the last PDU sent, and its opcode.
+    UINT8 last_sent(std::vector<UINT16> *p_handles) {
+      const std::vector<UINT8> &data = l2cap_sent.back().data;
+      p_handles->clear();
+      for (size_t i = 1; i + 1 < data.size(); i += 2)
+        p_handles->push_back((UINT16)(data[i] | (data[i + 1] << 8)));
+      return data[0];
+    }
+
+    void expect_read_done(size_t n, tGATT_IF gatt_if, UINT16 handle, const char *value) {
+      ASSERT_LT(n, completions.size());
+      EXPECT_EQ(conn_id(gatt_if), completions[n].conn_id);
+      EXPECT_EQ(GATTC_OPTYPE_READ, completions[n].op);
+      EXPECT_EQ(GATT_SUCCESS, completions[n].status);
+      EXPECT_EQ(handle, completions[n].handle);
+      EXPECT_EQ(std::string(value), std::string(completions[n].value.begin(),
+                                                completions[n].value.end()));
+    }
+
+    tGATT_CBACK cback;
+    tGATT_TCB *p_tcb;
+    UINT32 free_bufs;
+};
+
+TEST_F(GattClTest, test_queued_reads_of_several_apps_are_merged) {
+  std::vector<UINT16> handles;
+
+  read(1, 0x0010);
+  read(2, 0x0020);
+  read(3, 0x0030);
+  read(4, 0x0040);
+  ASSERT_EQ(1u, l2cap_sent.size());
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+
+  respond_read("one");
+  expect_read_done(0, 1, 0x0010, "one");
+
+  // The three reads queued behind the first go out as one request.
+  ASSERT_EQ(2u, l2cap_sent.size());
+  EXPECT_EQ(GATT_REQ_READ_MULTI_VAR, last_sent(&handles));
+  ASSERT_EQ(3u, handles.size());
+  EXPECT_EQ(0x0020, handles[0]);
+  EXPECT_EQ(0x0030, handles[1]);
+  EXPECT_EQ(0x0040, handles[2]);
+
+  std::vector<UINT8> pdu(1, GATT_RSP_READ_MULTI_VAR);
+  add_value(pdu, "two");
+  add_value(pdu, "");
+  add_value(pdu, "four");
+  respond(pdu);
+
+  ASSERT_EQ(4u, completions.size());
+  expect_read_done(1, 2, 0x0020, "two");
+  expect_read_done(2, 3, 0x0030, "");
+  expect_read_done(3, 4, 0x0040, "four");
+  EXPECT_EQ(2u, l2cap_sent.size());
+  EXPECT_EQ(2, p_tcb->cl_rtt_saved);
+  EXPECT_EQ(p_tcb->pending_cl_req, p_tcb->next_slot_inq);
+}
+
+TEST_F(GattClTest, test_truncated_value_and_the_rest_are_read_singly) {
+  std::vector<UINT16> handles;
+
+  read(1, 0x0010);
+  read(2, 0x0020);
+  read(3, 0x0030);
+  read(4, 0x0040);
+  respond_read("one");
+  ASSERT_EQ(GATT_REQ_READ_MULTI_VAR, last_sent(&handles));
+
+  // The second value is cut short by the MTU; the third is not in the PDU.
+  std::vector<UINT8> pdu(1, GATT_RSP_READ_MULTI_VAR);
+  add_value(pdu, "two");
+  add_value(pdu, "thr", 40);
+  respond(pdu);
+
+  ASSERT_EQ(2u, completions.size());
+  expect_read_done(1, 2, 0x0020, "two");
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0030, handles[0]);
+
+  respond_read("three");
+  expect_read_done(2, 3, 0x0030, "three");
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0040, handles[0]);
+
+  respond_read("four");
+  expect_read_done(3, 4, 0x0040, "four");
+  EXPECT_EQ(4u, l2cap_sent.size());
+  EXPECT_FALSE(p_tcb->no_read_multi_var);
+}
+
+TEST_F(GattClTest, test_response_over_mtu_is_read_singly) {
+  std::vector<UINT16> handles;
+
+  p_tcb->payload_size = GATT_DEF_BLE_MTU_SIZE;
+  read(1, 0x0010);
+  read(2, 0x0020);
+  read(3, 0x0030);
+  respond_read("one");
+  ASSERT_EQ(GATT_REQ_READ_MULTI_VAR, last_sent(&handles));
+
+  std::vector<UINT8> pdu(1, GATT_RSP_READ_MULTI_VAR);
+  add_value(pdu, "0123456789");
+  add_value(pdu, "0123456789");
+  respond(pdu);
+
+  EXPECT_EQ(1u, completions.size());
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0020, handles[0]);
+}
+
+TEST_F(GattClTest, test_request_not_supported_stops_merging_on_link) {
+  std::vector<UINT16> handles;
+
+  read(1, 0x0010);
+  read(2, 0x0020);
+  read(3, 0x0030);
+  respond_read("one");
+  ASSERT_EQ(GATT_REQ_READ_MULTI_VAR, last_sent(&handles));
+
+  respond_error(GATT_REQ_READ_MULTI_VAR, 0x0020, GATT_REQ_NOT_SUPPORTED);
+  EXPECT_TRUE(p_tcb->no_read_multi_var);
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0020, handles[0]);
+
+  // Reads queued from now on go out one at a time.
+  read(1, 0x0050);
+  read(4, 0x0060);
+  respond_read("two");
+  expect_read_done(1, 2, 0x0020, "two");
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0030, handles[0]);
+
+  respond_read("three");
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0050, handles[0]);
+  respond_read("five");
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0060, handles[0]);
+}
+
+TEST_F(GattClTest, test_other_error_retries_singly_but_keeps_merging) {
+  std::vector<UINT16> handles;
+
+  read(1, 0x0010);
+  read(2, 0x0020);
+  read(3, 0x0030);
+  respond_read("one");
+  respond_error(GATT_REQ_READ_MULTI_VAR, 0x0030, GATT_INSUF_RESOURCE);
+
+  EXPECT_FALSE(p_tcb->no_read_multi_var);
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0020, handles[0]);
+}
+
+TEST_F(GattClTest, test_reads_over_br_edr_are_not_merged) {
+  std::vector<UINT16> handles;
+
+  p_tcb->transport = BT_TRANSPORT_BR_EDR;
+  read(1, 0x0010);
+  read(2, 0x0020);
+  read(3, 0x0030);
+  respond_read("one");
+
+  EXPECT_EQ(GATT_REQ_READ, last_sent(&handles));
+  EXPECT_EQ(0x0020, handles[0]);
+}
+
+#define STREAM_IF     1
+#define STREAM_HANDLE 0x0025
+#define STREAM_PEER   7
+
+struct stream_end_t {
+  UINT16 conn_id;
+  UINT16 handle;
+  tGATT_STATUS status;
+  tGATT_STREAM_STATS stats;
+};
+
+static std::vector<stream_end_t> stream_ends;
+
+static void stream_cb(UINT16 conn_id, UINT16 handle, tGATT_STATUS status,
+                      tGATT_STREAM_STATS *p_stats) {
+  stream_end_t end;
+
+  end.conn_id = conn_id;
+  end.handle = handle;
+  end.status = status;
+  end.stats = *p_stats;
+  stream_ends.push_back(end);
+}
+
+static void conn_cb(tGATT_IF, BD_ADDR, UINT16, BOOLEAN, tGATT_DISCONN_REASON, tBT_TRANSPORT) {}
+
+class GattStreamTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      gatt_init();
+      memset(&cback, 0, sizeof(cback));
+      l2cap_reset();
+      stream_ends.clear();
+
+      cback.p_conn_cb = conn_cb;
+      gatt_cb.cl_rcb[STREAM_IF - 1].in_use = TRUE;
+      gatt_cb.cl_rcb[STREAM_IF - 1].gatt_if = STREAM_IF;
+      gatt_cb.cl_rcb[STREAM_IF - 1].app_cb = cback;
+
+      p_tcb = &gatt_cb.tcb[0];
+      p_tcb->in_use = TRUE;
+      p_tcb->tcb_idx = 0;
+      p_tcb->transport = BT_TRANSPORT_LE;
+      p_tcb->att_lcid = L2CAP_ATT_CID;
+      p_tcb->payload_size = 185;
+      p_tcb->ch_state = GATT_CH_OPEN;
+      p_tcb->peer_bda[BD_ADDR_LEN - 1] = STREAM_PEER;
+      conn = GATT_CREATE_CONN_ID(0, STREAM_IF);
+
+      for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = (UINT8)(i * 7);
+      free_bufs = gki_free_bufs();
+    }
+
+    virtual void TearDown() {
+      EXPECT_EQ(free_bufs, gki_free_bufs());
+    }
+
+    void congestion(BOOLEAN congested) {
+      l2cap_fixed_congestion(L2CAP_ATT_CID, STREAM_PEER, congested);
+    }
+
+    // Checks every PDU sent is a Write Command of at most MTU bytes to the
+    // stream handle, and that together they carry the first |len| bytes.
+    void expect_stream_sent(size_t len) {
+      std::vector<UINT8> received;
+
+      for (size_t n = 0; n < l2cap_sent.size(); ++n) {
+        const std::vector<UINT8> &pdu = l2cap_sent[n].data;
+        ASSERT_EQ(STREAM_PEER, l2cap_sent[n].peer);
+        ASSERT_LE(pdu.size(), p_tcb->payload_size);
+        ASSERT_EQ(GATT_CMD_WRITE, pdu[0]);
+        EXPECT_EQ(STREAM_HANDLE & 0xff, pdu[1]);
+        EXPECT_EQ(STREAM_HANDLE >> 8, pdu[2]);
+        received.insert(received.end(), pdu.begin() + 3, pdu.end());
+      }
+      ASSERT_EQ(len, received.size());
+      EXPECT_EQ(0, memcmp(data, &received[0], len));
+    }
+
+    tGATT_CBACK cback;
+    tGATT_TCB *p_tcb;
+    UINT16 conn;
+    UINT8 data[1000];
+    UINT32 free_bufs;
+};
+
+TEST_F(GattStreamTest, test_uncongested_stream_ends_within_call) {
+  EXPECT_EQ(GATT_SUCCESS, GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data, stream_cb));
+
+  // 1000 bytes at 182 per Write Command.
+  EXPECT_EQ(6u, l2cap_sent.size());
+  expect_stream_sent(sizeof(data));
+  ASSERT_EQ(1u, stream_ends.size());
+  EXPECT_EQ(conn, stream_ends[0].conn_id);
+  EXPECT_EQ(STREAM_HANDLE, stream_ends[0].handle);
+  EXPECT_EQ(GATT_SUCCESS, stream_ends[0].status);
+  EXPECT_EQ(sizeof(data), stream_ends[0].stats.bytes);
+  EXPECT_EQ(6u, stream_ends[0].stats.num_pkts);
+  EXPECT_EQ(0u, stream_ends[0].stats.num_stalls);
+  EXPECT_FALSE(p_tcb->wr_stream.in_use);
+}
+
+TEST_F(GattStreamTest, test_pump_stops_on_congestion_and_resumes) {
+  l2cap_set_result(STREAM_PEER, L2CAP_DW_CONGESTED);
+  EXPECT_EQ(GATT_SUCCESS, GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data, stream_cb));
+
+  EXPECT_EQ(1u, l2cap_sent.size());
+  EXPECT_TRUE(p_tcb->congested);
+  EXPECT_TRUE(stream_ends.empty());
+
+  // Still congested: nothing more goes out.
+  congestion(TRUE);
+  EXPECT_EQ(1u, l2cap_sent.size());
+
+  // Every time the channel drains one more segment fills it again.
+  for (size_t sent = 2; sent <= 6; ++sent) {
+    congestion(FALSE);
+    EXPECT_EQ(sent, l2cap_sent.size());
+  }
+  expect_stream_sent(sizeof(data));
+
+  ASSERT_EQ(1u, stream_ends.size());
+  EXPECT_EQ(GATT_SUCCESS, stream_ends[0].status);
+  EXPECT_EQ(6u, stream_ends[0].stats.num_pkts);
+  EXPECT_EQ(5u, stream_ends[0].stats.num_stalls);
+
+  congestion(FALSE);
+  EXPECT_EQ(6u, l2cap_sent.size());
+  EXPECT_EQ(1u, stream_ends.size());
+}
+
+TEST_F(GattStreamTest, test_send_failure_ends_stream) {
+  l2cap_set_result(STREAM_PEER, L2CAP_DW_CONGESTED);
+  GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data, stream_cb);
+
+  l2cap_set_result(STREAM_PEER, L2CAP_DW_FAILED);
+  congestion(FALSE);
+
+  ASSERT_EQ(1u, stream_ends.size());
+  EXPECT_EQ(GATT_ERROR, stream_ends[0].status);
+  EXPECT_EQ(1u, stream_ends[0].stats.num_pkts);
+  EXPECT_FALSE(p_tcb->wr_stream.in_use);
+}
+
+TEST_F(GattStreamTest, test_disconnect_ends_stream) {
+  l2cap_set_result(STREAM_PEER, L2CAP_DW_CONGESTED);
+  GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data, stream_cb);
+
+  gatt_cleanup_upon_disc(p_tcb->peer_bda, 0, BT_TRANSPORT_LE);
+
+  ASSERT_EQ(1u, stream_ends.size());
+  EXPECT_EQ(GATT_ERROR, stream_ends[0].status);
+}
+
+TEST_F(GattStreamTest, test_stream_of_deregistered_app_is_dropped) {
+  l2cap_set_result(STREAM_PEER, L2CAP_DW_CONGESTED);
+  GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data, stream_cb);
+
+  gatt_cb.cl_rcb[STREAM_IF - 1].in_use = FALSE;
+  congestion(FALSE);
+
+  EXPECT_EQ(1u, l2cap_sent.size());
+  EXPECT_TRUE(stream_ends.empty());
+  EXPECT_FALSE(p_tcb->wr_stream.in_use);
+}
+
+TEST_F(GattStreamTest, test_one_stream_per_link) {
+  l2cap_set_result(STREAM_PEER, L2CAP_DW_CONGESTED);
+  EXPECT_EQ(GATT_SUCCESS, GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data, stream_cb));
+  EXPECT_EQ(GATT_BUSY, GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data, stream_cb));
+  EXPECT_EQ(1u, l2cap_sent.size());
+}
+
+TEST_F(GattStreamTest, test_bad_parameters_are_rejected) {
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTC_WriteStream(conn, 0, sizeof(data), data, stream_cb));
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTC_WriteStream(conn, STREAM_HANDLE, 0, data, stream_cb));
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), NULL,
+                                                      stream_cb));
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data,
+                                                      NULL));
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTC_WriteStream(GATT_CREATE_CONN_ID(0, STREAM_IF + 1),
+                                                      STREAM_HANDLE, sizeof(data), data,
+                                                      stream_cb));
+  p_tcb->ch_state = GATT_CH_CONN;
+  EXPECT_EQ(GATT_ILLEGAL_PARAMETER, GATTC_WriteStream(conn, STREAM_HANDLE, sizeof(data), data,
+                                                      stream_cb));
+  EXPECT_TRUE(l2cap_sent.empty());
+  EXPECT_TRUE(stream_ends.empty());
+}
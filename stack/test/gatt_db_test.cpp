@@ -0,0 +1,347 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "gki.h"
+#include "l2c_api.h"
+}
+
+#define NUM_SERVICES      30
+#define CHARS_PER_SERVICE 10
+#define START_HANDLE      0x0010
+
+// Handles of characteristic values the databases passed up for the app to read.
+static std::vector<UINT16> app_reads;
+
+static void req_cb(UINT16, UINT32, tGATTS_REQ_TYPE, tGATTS_DATA *p_data) {
+  app_reads.push_back(p_data->read_req.handle);
+}
+
+static tBT_UUID uuid16(UINT16 uuid) {
+  tBT_UUID u;
+  u.len = LEN_UUID_16;
+  u.uu.uuid16 = uuid;
+  return u;
+}
+
+static tBT_UUID uuid32(UINT32 uuid) {
+  tBT_UUID u;
+  u.len = LEN_UUID_32;
+  u.uu.uuid32 = uuid;
+  return u;
+}
+
+// The base UUID form of a 16 or 32 bits type.
+static tBT_UUID uuid128_base(UINT32 uuid) {
+  tBT_UUID u;
+  u.len = LEN_UUID_128;
+  gatt_convert_uuid32_to_uuid128(u.uu.uuid128, uuid);
+  return u;
+}
+
+static tBT_UUID uuid128_custom(UINT8 seed) {
+  tBT_UUID u;
+  u.len = LEN_UUID_128;
+  for (int i = 0; i < LEN_UUID_128; ++i)
+    u.uu.uuid128[i] = (UINT8)(seed * 7 + i);
+  return u;
+}
+
+// Characteristic value types of a service; a custom type is shared by every
+// service so buckets hold attributes of more than one service.
+static tBT_UUID char_type(int svc, int chr) {
+  switch (chr % 5) {
+    case 0: return uuid16((UINT16)(0x2A00 + chr));
+    case 1: return uuid32(0x12340000 + chr);
+    case 2: return uuid128_custom((UINT8)chr);
+    case 3: return uuid128_base((UINT32)(0x2A00 + chr));
+    default: return uuid128_custom((UINT8)(svc + 100));
+  }
+}
+
+// The types Read By Type requests ask for, in every form they can be asked in.
+static std::vector<tBT_UUID> query_types() {
+  std::vector<tBT_UUID> types;
+  tBT_UUID none;
+
+  types.push_back(uuid16(GATT_UUID_PRI_SERVICE));
+  types.push_back(uuid16(GATT_UUID_SEC_SERVICE));
+  types.push_back(uuid16(GATT_UUID_INCLUDE_SERVICE));
+  types.push_back(uuid16(GATT_UUID_CHAR_DECLARE));
+  types.push_back(uuid128_base(GATT_UUID_CHAR_DECLARE));
+  types.push_back(uuid16(GATT_UUID_CHAR_CLIENT_CONFIG));
+  for (int chr = 0; chr < CHARS_PER_SERVICE; ++chr) {
+    types.push_back(char_type(0, chr));
+    types.push_back(uuid16((UINT16)(0x2A00 + chr)));
+    types.push_back(uuid32(0x2A00 + chr));
+    types.push_back(uuid128_base((UINT32)(0x2A00 + chr)));
+  }
+  types.push_back(uuid128_custom(0xee));
+  memset(&none, 0, sizeof(none));
+  types.push_back(none);
+  return types;
+}
+
+// Builds service |svc|. A service with an unindexed database reserves more
+// handles than one GKI buffer can hold a table for.
+static void build_service(tGATT_SVC_DB *p_db, int svc, bool indexed) {
+  UINT16 s_hdl = (UINT16)(START_HANDLE + svc * 0x40);
+  UINT16 num_handle = indexed ? 0x40 : (UINT16)(GKI_MAX_BUF_SIZE / sizeof(void *) + 1);
+  tBT_UUID svc_uuid = (svc % 3 == 0) ? uuid16((UINT16)(0x1800 + svc))
+                    : (svc % 3 == 1) ? uuid32(0x00ab0000 + svc)
+                    : uuid128_custom((UINT8)(svc + 50));
+
+  memset(p_db, 0, sizeof(*p_db));
+  ASSERT_TRUE(gatts_init_service_db(p_db, &svc_uuid, svc % 4 != 3, s_hdl, num_handle));
+  ASSERT_EQ(indexed, p_db->p_attr_tbl != NULL);
+
+  ASSERT_NE(0, gatts_add_included_service(p_db, 0x0100, 0x0110, uuid16(0x180f)));
+  ASSERT_NE(0, gatts_add_included_service(p_db, 0x0120, 0x0130, uuid128_custom(9)));
+
+  for (int chr = 0; chr < CHARS_PER_SERVICE; ++chr) {
+    tBT_UUID type = char_type(svc, chr);
+    tGATT_PERM perm = (chr % 2) ? (GATT_PERM_READ | GATT_PERM_WRITE)
+                                : (GATT_PERM_READ_ENCRYPTED | GATT_PERM_WRITE_ENCRYPTED);
+    tBT_UUID ccc = uuid16(GATT_UUID_CHAR_CLIENT_CONFIG);
+    tBT_UUID desc = uuid16(GATT_UUID_CHAR_DESCRIPTION);
+
+    ASSERT_NE(0, gatts_add_characteristic(p_db, perm,
+                                          GATT_CHAR_PROP_BIT_READ | GATT_CHAR_PROP_BIT_WRITE, &type));
+    if (chr % 3 == 0) {
+      ASSERT_NE(0, gatts_add_char_descr(p_db, GATT_PERM_READ | GATT_PERM_WRITE, &ccc));
+    }
+    if (chr % 4 == 1) {
+      ASSERT_NE(0, gatts_add_char_descr(p_db, GATT_PERM_READ, &desc));
+    }
+  }
+}
+
+static void free_service(tGATT_SVC_DB *p_db) {
+  while (p_db->svc_buffer.p_first)
+    GKI_freebuf(GKI_dequeue(&p_db->svc_buffer));
+}
+
+// The attribute |handle| found by walking the attribute chain.
+static tGATT_ATTR16 *walk_to(tGATT_SVC_DB *p_db, UINT16 handle) {
+  tGATT_ATTR16 *p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
+
+  while (p_attr && p_attr->handle != handle)
+    p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+  return p_attr;
+}
+
+// The outcome of one Read By Type request.
+struct read_by_type_t {
+  tGATT_STATUS status;
+  UINT16 len;
+  UINT16 cur_handle;
+  std::vector<UINT8> rsp;
+  std::vector<UINT16> app_reads;
+
+  bool operator==(const read_by_type_t &other) const {
+    return status == other.status && len == other.len && cur_handle == other.cur_handle &&
+           rsp == other.rsp && app_reads == other.app_reads;
+  }
+};
+
+static read_by_type_t read_by_type(tGATT_TCB *p_tcb, tGATT_SVC_DB *p_db, UINT16 s_handle,
+                                   UINT16 e_handle, tBT_UUID type, UINT16 mtu,
+                                   tGATT_SEC_FLAG sec_flag) {
+  std::vector<UINT8> buf(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + mtu, 0);
+  BT_HDR *p_rsp = (BT_HDR *)&buf[0];
+  UINT8 *p_data = (UINT8 *)(p_rsp + 1) + L2CAP_MIN_OFFSET;
+  read_by_type_t result;
+
+  app_reads.clear();
+  result.len = (UINT16)(mtu - 2);
+  result.cur_handle = 0;
+  result.status = gatts_db_read_attr_value_by_type(p_tcb, p_db, GATT_REQ_READ_BY_TYPE, p_rsp,
+                                                   s_handle, e_handle, type, &result.len,
+                                                   sec_flag, 16, 1, &result.cur_handle);
+  result.rsp.assign(p_data, p_data + p_rsp->len);
+  result.app_reads = app_reads;
+  return result;
+}
+
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+class GattDbTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&gatt_cb, 0, sizeof(gatt_cb));
+      memset(&tcb, 0, sizeof(tcb));
+      gatt_cb.sr_reg[0].in_use = TRUE;
+      gatt_cb.sr_reg[0].s_hdl = 1;
+      gatt_cb.sr_reg[0].e_hdl = 0xffff;
+      gatt_cb.sr_reg[0].gatt_if = 1;
+      gatt_cb.cl_rcb[0].in_use = TRUE;
+      gatt_cb.cl_rcb[0].gatt_if = 1;
+      gatt_cb.cl_rcb[0].app_cb.p_req_cb = req_cb;
+
+      for (int svc = 0; svc < NUM_SERVICES; ++svc) {
+        build_service(&indexed[svc], svc, true);
+        build_service(&listed[svc], svc, false);
+      }
+    }
+
+    virtual void TearDown() {
+      for (int svc = 0; svc < NUM_SERVICES; ++svc) {
+        free_service(&indexed[svc]);
+        free_service(&listed[svc]);
+      }
+    }
+
+    tGATT_TCB tcb;
+    tGATT_SVC_DB indexed[NUM_SERVICES];
+    tGATT_SVC_DB listed[NUM_SERVICES];
+};
+
+TEST_F(GattDbTest, test_handle_lookup_matches_chain_walk) {
+  for (int svc = 0; svc < NUM_SERVICES; ++svc) {
+    tGATT_SVC_DB *p_db = &indexed[svc];
+
+    for (UINT16 handle = p_db->start_handle - 1; handle <= p_db->next_handle; ++handle) {
+      tGATT_ATTR16 *p_attr = walk_to(p_db, handle);
+      EXPECT_EQ(p_attr, gatts_find_attr_by_handle(p_db, handle));
+      EXPECT_EQ(p_attr != NULL, walk_to(&listed[svc], handle) != NULL);
+      EXPECT_EQ(walk_to(&listed[svc], handle), gatts_find_attr_by_handle(&listed[svc], handle));
+    }
+  }
+  EXPECT_TRUE(gatts_find_attr_by_handle(NULL, START_HANDLE) == NULL);
+}
+
+TEST_F(GattDbTest, test_permission_checks_match_without_table) {
+  static const tGATT_SEC_FLAG sec_flags[] = {
+    0, GATT_SEC_FLAG_LKEY_UNAUTHED | GATT_SEC_FLAG_ENCRYPTED,
+  };
+  UINT8 value[2] = { 0x01, 0x00 };
+
+  for (int svc = 0; svc < NUM_SERVICES; ++svc) {
+    for (UINT16 handle = indexed[svc].start_handle - 1; handle <= indexed[svc].next_handle;
+         ++handle) {
+      for (size_t i = 0; i < sizeof(sec_flags) / sizeof(sec_flags[0]); ++i) {
+        EXPECT_EQ(gatts_read_attr_perm_check(&listed[svc], FALSE, handle, sec_flags[i], 16),
+                  gatts_read_attr_perm_check(&indexed[svc], FALSE, handle, sec_flags[i], 16));
+        EXPECT_EQ(gatts_write_attr_perm_check(&listed[svc], GATT_REQ_WRITE, handle, 0, value,
+                                              sizeof(value), sec_flags[i], 16),
+                  gatts_write_attr_perm_check(&indexed[svc], GATT_REQ_WRITE, handle, 0, value,
+                                              sizeof(value), sec_flags[i], 16));
+      }
+    }
+  }
+}
+
+TEST_F(GattDbTest, test_read_by_type_matches_without_table) {
+  std::vector<tBT_UUID> types = query_types();
+  static const UINT16 mtus[] = { GATT_DEF_BLE_MTU_SIZE, 185 };
+
+  for (int svc = 0; svc < NUM_SERVICES; ++svc) {
+    UINT16 first = indexed[svc].start_handle;
+    UINT16 last = indexed[svc].next_handle - 1;
+    UINT16 ranges[][2] = {
+      { 0x0001, 0xffff }, { first, last }, { (UINT16)(first + 5), (UINT16)(last - 7) },
+      { (UINT16)(first + 3), (UINT16)(first + 3) }, { (UINT16)(last + 1), 0xffff },
+    };
+
+    for (size_t t = 0; t < types.size(); ++t) {
+      for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r) {
+        for (size_t m = 0; m < sizeof(mtus) / sizeof(mtus[0]); ++m) {
+          read_by_type_t expected = read_by_type(&tcb, &listed[svc], ranges[r][0], ranges[r][1],
+                                                 types[t], mtus[m], GATT_SEC_FLAG_ENCRYPTED);
+          read_by_type_t actual = read_by_type(&tcb, &indexed[svc], ranges[r][0], ranges[r][1],
+                                               types[t], mtus[m], GATT_SEC_FLAG_ENCRYPTED);
+          EXPECT_TRUE(expected == actual) << "service " << svc << " type " << t
+                                          << " range " << r << " mtu " << mtus[m];
+        }
+      }
+    }
+  }
+}
+
+TEST_F(GattDbTest, test_read_by_type_finds_every_form_of_a_type) {
+  tGATT_SVC_DB *p_db = &indexed[0];
+
+  // Characteristic 3 is stored in its 128 bits base form.
+  read_by_type_t by16 = read_by_type(&tcb, p_db, 1, 0xffff, uuid16(0x2A03), 185,
+                                     GATT_SEC_FLAG_ENCRYPTED);
+  read_by_type_t by128 = read_by_type(&tcb, p_db, 1, 0xffff, uuid128_base(0x2A03), 185,
+                                      GATT_SEC_FLAG_ENCRYPTED);
+  ASSERT_EQ(1u, by16.app_reads.size());
+  EXPECT_TRUE(by16 == by128);
+
+  // Characteristic 0 is stored in its 16 bits form.
+  read_by_type_t stored16 = read_by_type(&tcb, p_db, 1, 0xffff, uuid128_base(0x2A00), 185, 0);
+  EXPECT_EQ(GATT_INSUF_AUTHENTICATION, stored16.status);
+  EXPECT_NE(0, stored16.cur_handle);
+}
+
+TEST_F(GattDbTest, test_read_by_type_of_declarations_fills_response) {
+  tGATT_SVC_DB *p_db = &indexed[1];
+  read_by_type_t decls = read_by_type(&tcb, p_db, 1, 0xffff, uuid16(GATT_UUID_CHAR_DECLARE),
+                                      185, 0);
+
+  // Characteristic 0 has a 16 bits value type: handle, property, value handle,
+  // UUID. The 128 bits entry of characteristic 1 does not fit the same format
+  // and ends the response, which gatt_sr.c sends as it is.
+  EXPECT_EQ(GATT_NO_RESOURCES, decls.status);
+  ASSERT_EQ(7u, decls.rsp.size());
+  EXPECT_TRUE(decls.app_reads.empty());
+  EXPECT_EQ(0x00, decls.rsp[5]);
+  EXPECT_EQ(0x2A, decls.rsp[6]);
+}
+
+// Times the lookups of an ATT request against every service, indexed and not.
+// Only the results are checked; the times are reported for comparison.
+TEST_F(GattDbTest, test_att_request_throughput) {
+  static const int ROUNDS = 20;
+  tBT_UUID char_decl = uuid16(GATT_UUID_CHAR_DECLARE);
+  tGATT_SVC_DB *dbs[2] = { listed, indexed };
+  double perm_ns[2], type_ns[2];
+  int perm_ok[2] = { 0, 0 }, type_ok[2] = { 0, 0 };
+  int perm_ops = 0, type_ops = 0;
+
+  for (int d = 0; d < 2; ++d) {
+    double start = now_ns();
+    perm_ops = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+      for (int svc = 0; svc < NUM_SERVICES; ++svc) {
+        tGATT_SVC_DB *p_db = &dbs[d][svc];
+        for (UINT16 handle = p_db->start_handle; handle < p_db->next_handle; ++handle, ++perm_ops)
+          perm_ok[d] += gatts_read_attr_perm_check(p_db, FALSE, handle,
+                                                   GATT_SEC_FLAG_ENCRYPTED, 16) == GATT_SUCCESS;
+      }
+    }
+    perm_ns[d] = (now_ns() - start) / perm_ops;
+
+    start = now_ns();
+    type_ops = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+      for (int svc = 0; svc < NUM_SERVICES; ++svc, ++type_ops) {
+        tGATT_SVC_DB *p_db = &dbs[d][svc];
+        type_ok[d] += read_by_type(&tcb, p_db, p_db->start_handle, p_db->next_handle - 1,
+                                   char_decl, GATT_MAX_MTU_SIZE, 0).rsp.size();
+      }
+    }
+    type_ns[d] = (now_ns() - start) / type_ops;
+  }
+
+  EXPECT_EQ(perm_ok[0], perm_ok[1]);
+  EXPECT_EQ(type_ok[0], type_ok[1]);
+  printf("permission check per handle: %.0f ns list walk, %.0f ns indexed\n",
+         perm_ns[0], perm_ns[1]);
+  printf("characteristic discovery per service: %.0f ns list walk, %.0f ns indexed\n",
+         type_ns[0], type_ns[1]);
+}
@@ -0,0 +1,574 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "fake_l2cap.h"
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "gki.h"
+#include "l2c_api.h"
+}
+
+// Application 1 takes discovery results in batches, application 2 one by one.
+#define BATCH_APP 1
+#define SINGLE_APP 2
+#define NUM_APPS 2
+
+#define NUM_SERVICES 8
+#define CHARS_PER_SERVICE 31
+// A service declaration, an include, then a declaration, a value and two
+// descriptors per characteristic.
+#define SERVICE_HANDLES (2 + CHARS_PER_SERVICE * 4)
+
+// An attribute of the simulated server.
+struct attr_t {
+  UINT16 handle;
+  std::vector<UINT8> type;
+  std::vector<UINT8> value;
+  UINT16 end_handle;
+};
+
+// A discovery result as the application saw it, flattened so results from
+// either callback can be compared.
+typedef std::vector<UINT8> result_t;
+
+static std::vector<result_t> results[NUM_APPS + 1];
+static std::vector<UINT16> batches[NUM_APPS + 1];
+
+// Every discovery completion, as its status.
+static std::vector<tGATT_STATUS> disc_cmpls;
+
+static void add_u16(std::vector<UINT8> &v, UINT16 x) {
+  v.push_back(x & 0xff);
+  v.push_back(x >> 8);
+}
+
+static void add_uuid(result_t &r, const tBT_UUID &uuid) {
+  r.push_back(uuid.len);
+  if (uuid.len == LEN_UUID_16)
+    add_u16(r, uuid.uu.uuid16);
+  else
+    r.insert(r.end(), uuid.uu.uuid128, uuid.uu.uuid128 + uuid.len);
+}
+
+// Flattens a little endian UUID as add_uuid does.
+static void add_uuid(result_t &r, const std::vector<UINT8> &uuid) {
+  r.push_back((UINT8)uuid.size());
+  r.insert(r.end(), uuid.begin(), uuid.end());
+}
+
+static result_t flatten(tGATT_DISC_TYPE disc_type, const tGATT_DISC_RES *p_res) {
+  result_t r;
+
+  r.push_back(disc_type);
+  add_u16(r, p_res->handle);
+  add_uuid(r, p_res->type);
+  switch (disc_type) {
+    case GATT_DISC_SRVC_ALL:
+      add_u16(r, p_res->value.group_value.e_handle);
+      add_uuid(r, p_res->value.group_value.service_type);
+      break;
+    case GATT_DISC_INC_SRVC:
+      add_u16(r, p_res->value.incl_service.s_handle);
+      add_u16(r, p_res->value.incl_service.e_handle);
+      add_uuid(r, p_res->value.incl_service.service_type);
+      break;
+    case GATT_DISC_CHAR:
+      r.push_back(p_res->value.dclr_value.char_prop);
+      add_u16(r, p_res->value.dclr_value.val_handle);
+      add_uuid(r, p_res->value.dclr_value.char_uuid);
+      break;
+    default:
+      break;
+  }
+  return r;
+}
+
+static void disc_res_cb(UINT16 conn_id, tGATT_DISC_TYPE disc_type, tGATT_DISC_RES *p_data) {
+  results[GATT_GET_GATT_IF(conn_id)].push_back(flatten(disc_type, p_data));
+}
+
+static void disc_res_batch_cb(UINT16 conn_id, tGATT_DISC_TYPE disc_type, UINT16 num_res,
+                              tGATT_DISC_RES *p_data) {
+  tGATT_IF gatt_if = GATT_GET_GATT_IF(conn_id);
+
+  batches[gatt_if].push_back(num_res);
+  for (UINT16 i = 0; i < num_res; ++i)
+    results[gatt_if].push_back(flatten(disc_type, &p_data[i]));
+}
+
+static void disc_cmpl_cb(UINT16, tGATT_DISC_TYPE, tGATT_STATUS status) {
+  disc_cmpls.push_back(status);
+}
+
+static std::vector<UINT8> uuid16(UINT16 uuid) {
+  std::vector<UINT8> v;
+  add_u16(v, uuid);
+  return v;
+}
+
+static std::vector<UINT8> uuid128(UINT8 tag) {
+  std::vector<UINT8> v(LEN_UUID_128, 0);
+  for (int i = 0; i < LEN_UUID_128; ++i)
+    v[i] = (UINT8)(0xA0 + i);
+  v[0] = tag;
+  return v;
+}
+
+static UINT16 get_u16(const std::vector<UINT8> &v, size_t pos) {
+  return (UINT16)(v[pos] | (v[pos + 1] << 8));
+}
+
+static UINT16 conn_id(tGATT_IF gatt_if) {
+  return GATT_CREATE_CONN_ID(0, gatt_if);
+}
+
+class GattDiscTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      tGATT_CBACK cback;
+
+      memset(&gatt_cb, 0, sizeof(gatt_cb));
+      l2cap_reset();
+      disc_cmpls.clear();
+      for (tGATT_IF gatt_if = 1; gatt_if <= NUM_APPS; ++gatt_if) {
+        results[gatt_if].clear();
+        batches[gatt_if].clear();
+
+        memset(&cback, 0, sizeof(cback));
+        cback.p_disc_res_cb = disc_res_cb;
+        cback.p_disc_cmpl_cb = disc_cmpl_cb;
+        if (gatt_if == BATCH_APP)
+          cback.p_disc_res_batch_cb = disc_res_batch_cb;
+        gatt_cb.cl_rcb[gatt_if - 1].in_use = TRUE;
+        gatt_cb.cl_rcb[gatt_if - 1].gatt_if = gatt_if;
+        gatt_cb.cl_rcb[gatt_if - 1].app_cb = cback;
+      }
+
+      p_tcb = &gatt_cb.tcb[0];
+      p_tcb->in_use = TRUE;
+      p_tcb->tcb_idx = 0;
+      p_tcb->transport = BT_TRANSPORT_LE;
+      p_tcb->att_lcid = L2CAP_ATT_CID;
+      p_tcb->payload_size = 185;
+      served = 0;
+      build_server();
+    }
+
+    virtual void TearDown() {
+      for (int i = 0; i < GATT_CL_MAX_LCB; ++i)
+        if (p_tcb->cl_cmd_q[i].p_cmd)
+          GKI_freebuf(p_tcb->cl_cmd_q[i].p_cmd);
+    }
+
+    void add_attr(UINT16 handle, const std::vector<UINT8> &type,
+                  const std::vector<UINT8> &value, UINT16 end_handle = 0) {
+      attr_t a = { handle, type, value, end_handle };
+      attrs.push_back(a);
+    }
+
+    // Services alternate between 16 and 128 bit UUIDs, and so do their
+    // characteristics; each service includes the next one.
+    void build_server() {
+      attrs.clear();
+      for (int s = 0; s < NUM_SERVICES; ++s) {
+        UINT16 start = (UINT16)(1 + s * SERVICE_HANDLES);
+        UINT16 end = (UINT16)(start + SERVICE_HANDLES - 1);
+        int inc = (s + 1) % NUM_SERVICES;
+        UINT16 inc_start = (UINT16)(1 + inc * SERVICE_HANDLES);
+        std::vector<UINT8> inc_uuid = service_uuid(inc);
+        std::vector<UINT8> decl;
+        UINT16 h = start;
+
+        add_attr(h++, uuid16(GATT_UUID_PRI_SERVICE), service_uuid(s), end);
+
+        add_u16(decl, inc_start);
+        add_u16(decl, (UINT16)(inc_start + SERVICE_HANDLES - 1));
+        if (inc_uuid.size() == LEN_UUID_16)
+          decl.insert(decl.end(), inc_uuid.begin(), inc_uuid.end());
+        add_attr(h++, uuid16(GATT_UUID_INCLUDE_SERVICE), decl);
+
+        for (int c = 0; c < CHARS_PER_SERVICE; ++c) {
+          std::vector<UINT8> char_uuid = (s % 2) ? uuid128((UINT8)(s * 32 + c))
+                                                 : uuid16((UINT16)(0x2A00 + c));
+          decl.clear();
+          decl.push_back(GATT_CHAR_PROP_BIT_READ | GATT_CHAR_PROP_BIT_NOTIFY);
+          add_u16(decl, (UINT16)(h + 1));
+          decl.insert(decl.end(), char_uuid.begin(), char_uuid.end());
+          add_attr(h++, uuid16(GATT_UUID_CHAR_DECLARE), decl);
+          add_attr(h++, char_uuid, std::vector<UINT8>(1, (UINT8)c));
+          add_attr(h++, uuid16(GATT_UUID_CHAR_CLIENT_CONFIG), std::vector<UINT8>(2, 0));
+          add_attr(h++, uuid16(GATT_UUID_CHAR_DESCRIPTION), std::vector<UINT8>(1, 'x'));
+        }
+      }
+    }
+
+    static std::vector<UINT8> service_uuid(int s) {
+      return (s % 2) ? uuid128((UINT8)s) : uuid16((UINT16)(0x1800 + s));
+    }
+
+    // What a discovery of the whole server must report, from the table.
+    std::vector<result_t> expected(tGATT_DISC_TYPE disc_type) {
+      std::vector<result_t> v;
+
+      for (size_t i = 0; i < attrs.size(); ++i) {
+        const attr_t &a = attrs[i];
+        UINT16 type = (a.type.size() == LEN_UUID_16) ? get_u16(a.type, 0) : 0;
+        result_t r;
+
+        r.push_back(disc_type);
+        add_u16(r, a.handle);
+        if (disc_type == GATT_DISC_SRVC_ALL && type == GATT_UUID_PRI_SERVICE) {
+          add_uuid(r, a.type);
+          add_u16(r, a.end_handle);
+          add_uuid(r, a.value);
+        } else if (disc_type == GATT_DISC_INC_SRVC && type == GATT_UUID_INCLUDE_SERVICE) {
+          UINT16 inc_start = get_u16(a.value, 0);
+          add_uuid(r, a.type);
+          r.insert(r.end(), a.value.begin(), a.value.begin() + 4);
+          add_uuid(r, attr(inc_start).value);
+        } else if (disc_type == GATT_DISC_CHAR && type == GATT_UUID_CHAR_DECLARE) {
+          add_uuid(r, a.type);
+          r.insert(r.end(), a.value.begin(), a.value.begin() + 3);
+          add_uuid(r, std::vector<UINT8>(a.value.begin() + 3, a.value.end()));
+        } else if (disc_type == GATT_DISC_CHAR_DSCPT) {
+          add_uuid(r, a.type);
+        } else {
+          continue;
+        }
+        v.push_back(r);
+      }
+      return v;
+    }
+
+    const attr_t &attr(UINT16 handle) {
+      return attrs[handle - 1];
+    }
+
+    // Hands a server PDU, opcode first, to the client.
+    void respond(const std::vector<UINT8> &pdu) {
+      std::vector<UINT8> copy(pdu);
+      gatt_client_handle_server_rsp(p_tcb, copy[0], (UINT16)(copy.size() - 1), &copy[1]);
+    }
+
+    void respond_not_found(UINT8 req_op, UINT16 handle) {
+      std::vector<UINT8> pdu(1, GATT_RSP_ERROR);
+      pdu.push_back(req_op);
+      add_u16(pdu, handle);
+      pdu.push_back(GATT_NOT_FOUND);
+      respond(pdu);
+    }
+
+    // Answers a request as a server holding |attrs| would, within the MTU:
+    // each response carries the run of matching attributes from the start
+    // handle on whose entries are as long as the first one.
+    void answer(const std::vector<UINT8> &req) {
+      UINT16 mtu = p_tcb->payload_size;
+      UINT8 op = req[0];
+      std::vector<UINT8> pdu;
+
+      if (op == GATT_REQ_READ) {
+        const std::vector<UINT8> &value = attr(get_u16(req, 1)).value;
+        pdu.push_back(GATT_RSP_READ);
+        pdu.insert(pdu.end(), value.begin(),
+                   value.begin() + std::min(value.size(), (size_t)(mtu - 1)));
+        respond(pdu);
+        return;
+      }
+
+      UINT16 s_handle = get_u16(req, 1);
+      UINT16 e_handle = get_u16(req, 3);
+      size_t entry_len = 0;
+
+      pdu.push_back(op + 1);
+      pdu.push_back(0);
+      for (UINT16 h = s_handle; h <= e_handle && h <= attrs.size(); ++h) {
+        const attr_t &a = attr(h);
+        std::vector<UINT8> entry;
+
+        add_u16(entry, h);
+        if (op == GATT_REQ_FIND_INFO) {
+          entry.insert(entry.end(), a.type.begin(), a.type.end());
+        } else {
+          if (a.type != std::vector<UINT8>(req.begin() + 5, req.end()))
+            continue;
+          if (op == GATT_REQ_READ_BY_GRP_TYPE)
+            add_u16(entry, a.end_handle);
+          entry.insert(entry.end(), a.value.begin(), a.value.end());
+        }
+
+        if (entry_len == 0)
+          entry_len = entry.size();
+        if (entry.size() != entry_len || pdu.size() + entry_len > mtu)
+          break;
+        pdu.insert(pdu.end(), entry.begin(), entry.end());
+      }
+
+      if (entry_len == 0) {
+        respond_not_found(op, s_handle);
+        return;
+      }
+      if (op == GATT_REQ_FIND_INFO)
+        pdu[1] = (entry_len == 2 + LEN_UUID_16) ? GATT_INFO_TYPE_PAIR_16 : GATT_INFO_TYPE_PAIR_128;
+      else
+        pdu[1] = (UINT8)entry_len;
+      respond(pdu);
+    }
+
+    // Answers every request the client sends until it stops asking.
+    void serve() {
+      while (served < l2cap_sent.size()) {
+        std::vector<UINT8> req = l2cap_sent[served++].data;
+        answer(req);
+      }
+    }
+
+    void discover_all(tGATT_IF gatt_if, tGATT_DISC_TYPE disc_type) {
+      tGATT_DISC_PARAM param;
+
+      memset(&param, 0, sizeof(param));
+      param.s_handle = 1;
+      param.e_handle = 0xFFFF;
+      ASSERT_EQ(GATT_SUCCESS, GATTC_Discover(conn_id(gatt_if), disc_type, &param));
+      serve();
+      ASSERT_FALSE(disc_cmpls.empty());
+      EXPECT_EQ(GATT_SUCCESS, disc_cmpls.back());
+    }
+
+    // Starts a discovery whose responses the test makes up.
+    void start(tGATT_IF gatt_if, tGATT_DISC_TYPE disc_type) {
+      tGATT_DISC_PARAM param;
+
+      memset(&param, 0, sizeof(param));
+      param.s_handle = 1;
+      param.e_handle = 0x40;
+      ASSERT_EQ(GATT_SUCCESS, GATTC_Discover(conn_id(gatt_if), disc_type, &param));
+      served = l2cap_sent.size();
+    }
+
+    tGATT_TCB *p_tcb;
+    std::vector<attr_t> attrs;
+    size_t served;
+};
+
+TEST_F(GattDiscTest, test_batches_match_single_results) {
+  static const UINT16 mtus[] = { GATT_DEF_BLE_MTU_SIZE, 185, GATT_MAX_MTU_SIZE };
+  static const tGATT_DISC_TYPE types[] = {
+    GATT_DISC_SRVC_ALL, GATT_DISC_INC_SRVC, GATT_DISC_CHAR, GATT_DISC_CHAR_DSCPT
+  };
+
+  ASSERT_LE(1000u, attrs.size());
+  for (size_t m = 0; m < sizeof(mtus) / sizeof(mtus[0]); ++m) {
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); ++t) {
+      SCOPED_TRACE(testing::Message() << "mtu " << mtus[m] << " type " << (int)types[t]);
+      p_tcb->payload_size = mtus[m];
+      for (tGATT_IF gatt_if = 1; gatt_if <= NUM_APPS; ++gatt_if) {
+        results[gatt_if].clear();
+        batches[gatt_if].clear();
+        discover_all(gatt_if, types[t]);
+      }
+
+      EXPECT_EQ(expected(types[t]), results[BATCH_APP]);
+      EXPECT_EQ(results[BATCH_APP], results[SINGLE_APP]);
+      EXPECT_TRUE(batches[SINGLE_APP].empty());
+      EXPECT_LE(batches[BATCH_APP].size(), results[BATCH_APP].size());
+      EXPECT_GE(GATT_DISC_RES_BATCH_MAX,
+                *std::max_element(batches[BATCH_APP].begin(), batches[BATCH_APP].end()));
+    }
+  }
+
+  // A large MTU fits more descriptors in a response than one batch holds.
+  EXPECT_EQ(GATT_DISC_RES_BATCH_MAX,
+            *std::max_element(batches[BATCH_APP].begin(), batches[BATCH_APP].end()));
+}
+
+TEST_F(GattDiscTest, test_128_bit_include_is_read_between_batches) {
+  std::vector<UINT8> pdu;
+  std::vector<UINT8> uuid = uuid128(0x55);
+
+  for (tGATT_IF gatt_if = 1; gatt_if <= NUM_APPS; ++gatt_if) {
+    SCOPED_TRACE(testing::Message() << "app " << (int)gatt_if);
+    disc_cmpls.clear();
+    start(gatt_if, GATT_DISC_INC_SRVC);
+
+    // Two includes of 16 bit services.
+    pdu.clear();
+    pdu.push_back(GATT_RSP_READ_BY_TYPE);
+    pdu.push_back(8);
+    for (UINT16 h = 2; h <= 3; ++h) {
+      add_u16(pdu, h);
+      add_u16(pdu, (UINT16)(0x10 * h));
+      add_u16(pdu, (UINT16)(0x10 * h + 5));
+      add_u16(pdu, (UINT16)(0x1800 + h));
+    }
+    respond(pdu);
+    ASSERT_EQ(2u, results[gatt_if].size());
+    ASSERT_EQ(served + 1, l2cap_sent.size());
+    EXPECT_EQ(GATT_REQ_READ_BY_TYPE, l2cap_sent.back().data[0]);
+    EXPECT_EQ(4, get_u16(l2cap_sent.back().data, 1));
+    served = l2cap_sent.size();
+
+    // The first of two includes of 128 bit services stops the parsing: its
+    // UUID is read from the service declaration before anything else.
+    pdu.clear();
+    pdu.push_back(GATT_RSP_READ_BY_TYPE);
+    pdu.push_back(6);
+    for (UINT16 h = 4; h <= 5; ++h) {
+      add_u16(pdu, h);
+      add_u16(pdu, (UINT16)(0x10 * h));
+      add_u16(pdu, (UINT16)(0x10 * h + 5));
+    }
+    respond(pdu);
+    EXPECT_EQ(2u, results[gatt_if].size());
+    ASSERT_EQ(served + 1, l2cap_sent.size());
+    EXPECT_EQ(GATT_REQ_READ, l2cap_sent.back().data[0]);
+    EXPECT_EQ(0x40, get_u16(l2cap_sent.back().data, 1));
+    served = l2cap_sent.size();
+
+    pdu.assign(1, GATT_RSP_READ);
+    pdu.insert(pdu.end(), uuid.begin(), uuid.end());
+    respond(pdu);
+    ASSERT_EQ(3u, results[gatt_if].size());
+    result_t r;
+    r.push_back(GATT_DISC_INC_SRVC);
+    add_u16(r, 4);
+    add_uuid(r, uuid16(GATT_UUID_INCLUDE_SERVICE));
+    add_u16(r, 0x40);
+    add_u16(r, 0x45);
+    add_uuid(r, uuid);
+    EXPECT_EQ(r, results[gatt_if][2]);
+
+    // Discovery carries on after the include that was read.
+    ASSERT_EQ(served + 1, l2cap_sent.size());
+    EXPECT_EQ(GATT_REQ_READ_BY_TYPE, l2cap_sent.back().data[0]);
+    EXPECT_EQ(5, get_u16(l2cap_sent.back().data, 1));
+    EXPECT_TRUE(disc_cmpls.empty());
+    respond_not_found(GATT_REQ_READ_BY_TYPE, 5);
+    ASSERT_EQ(1u, disc_cmpls.size());
+    EXPECT_EQ(GATT_SUCCESS, disc_cmpls[0]);
+  }
+
+  EXPECT_EQ(results[BATCH_APP], results[SINGLE_APP]);
+  ASSERT_EQ(2u, batches[BATCH_APP].size());
+  EXPECT_EQ(2, batches[BATCH_APP][0]);
+  EXPECT_EQ(1, batches[BATCH_APP][1]);
+}
+
+TEST_F(GattDiscTest, test_128_bit_include_of_wrong_length_ends_discovery) {
+  std::vector<UINT8> pdu;
+
+  start(BATCH_APP, GATT_DISC_INC_SRVC);
+  pdu.push_back(GATT_RSP_READ_BY_TYPE);
+  pdu.push_back(6);
+  add_u16(pdu, 2);
+  add_u16(pdu, 0x20);
+  add_u16(pdu, 0x25);
+  respond(pdu);
+
+  pdu.assign(1, GATT_RSP_READ);
+  pdu.push_back(0x12);
+  pdu.push_back(0x34);
+  respond(pdu);
+  EXPECT_TRUE(results[BATCH_APP].empty());
+  ASSERT_EQ(1u, disc_cmpls.size());
+  EXPECT_EQ(GATT_INVALID_PDU, disc_cmpls[0]);
+}
+
+// In each response the third entry has a zero handle where the first two do
+// not; the first two are delivered before the procedure fails.
+TEST_F(GattDiscTest, test_invalid_handles_deliver_results_so_far) {
+  enum { ATTR_HANDLE, VALUE_HANDLE, END_HANDLE };
+  static const int cases[] = { ATTR_HANDLE, VALUE_HANDLE, END_HANDLE };
+
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    for (tGATT_IF gatt_if = 1; gatt_if <= NUM_APPS; ++gatt_if) {
+      SCOPED_TRACE(testing::Message() << "case " << cases[c] << " app " << (int)gatt_if);
+      tGATT_DISC_TYPE disc_type = (cases[c] == END_HANDLE) ? GATT_DISC_SRVC_ALL : GATT_DISC_CHAR;
+      std::vector<UINT8> pdu;
+
+      results[gatt_if].clear();
+      batches[gatt_if].clear();
+      disc_cmpls.clear();
+      start(gatt_if, disc_type);
+
+      if (disc_type == GATT_DISC_SRVC_ALL) {
+        pdu.push_back(GATT_RSP_READ_BY_GRP_TYPE);
+        pdu.push_back(6);
+        for (UINT16 i = 0; i < 3; ++i) {
+          add_u16(pdu, (UINT16)(1 + 0x10 * i));
+          add_u16(pdu, (i == 2) ? 0 : (UINT16)(0x10 * (i + 1)));
+          add_u16(pdu, (UINT16)(0x1800 + i));
+        }
+      } else {
+        pdu.push_back(GATT_RSP_READ_BY_TYPE);
+        pdu.push_back(7);
+        for (UINT16 i = 0; i < 3; ++i) {
+          UINT16 h = (UINT16)(2 + 2 * i);
+          add_u16(pdu, (i == 2 && cases[c] == ATTR_HANDLE) ? 0 : h);
+          pdu.push_back(GATT_CHAR_PROP_BIT_READ);
+          add_u16(pdu, (i == 2 && cases[c] == VALUE_HANDLE) ? 0 : (UINT16)(h + 1));
+          add_u16(pdu, (UINT16)(0x2A00 + i));
+        }
+      }
+      respond(pdu);
+
+      ASSERT_EQ(2u, results[gatt_if].size());
+      for (size_t i = 0; i < 2; ++i)
+        EXPECT_EQ(get_u16(pdu, 2 + i * pdu[1]), get_u16(results[gatt_if][i], 1));
+      if (gatt_if == BATCH_APP) {
+        ASSERT_EQ(1u, batches[gatt_if].size());
+        EXPECT_EQ(2, batches[gatt_if][0]);
+      }
+      ASSERT_EQ(1u, disc_cmpls.size());
+      EXPECT_EQ(GATT_INVALID_HANDLE, disc_cmpls[0]);
+      EXPECT_EQ(served, l2cap_sent.size());
+    }
+  }
+}
+
+static UINT64 now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (UINT64)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// Discovers the whole server as an application would, with the simulated
+// server's time included. Times are printed rather than asserted since they
+// vary between devices.
+TEST_F(GattDiscTest, test_benchmark_full_discovery) {
+  static const UINT16 mtus[] = { GATT_DEF_BLE_MTU_SIZE, GATT_MAX_MTU_SIZE };
+  static const int ITERATIONS = 5;
+
+  for (size_t m = 0; m < sizeof(mtus) / sizeof(mtus[0]); ++m) {
+    UINT64 us[NUM_APPS + 1];
+    size_t pdus = 0;
+
+    p_tcb->payload_size = mtus[m];
+    for (tGATT_IF gatt_if = 1; gatt_if <= NUM_APPS; ++gatt_if) {
+      size_t sent = l2cap_sent.size();
+      UINT64 start = now_us();
+
+      for (int i = 0; i < ITERATIONS; ++i) {
+        results[gatt_if].clear();
+        discover_all(gatt_if, GATT_DISC_SRVC_ALL);
+        discover_all(gatt_if, GATT_DISC_INC_SRVC);
+        discover_all(gatt_if, GATT_DISC_CHAR);
+        discover_all(gatt_if, GATT_DISC_CHAR_DSCPT);
+      }
+      us[gatt_if] = (now_us() - start) / ITERATIONS;
+      pdus = (l2cap_sent.size() - sent) / ITERATIONS;
+    }
+
+    EXPECT_EQ(results[BATCH_APP], results[SINGLE_APP]);
+    printf("discovery of %u attributes, mtu %u, %u requests: batched %llu us, single %llu us\n",
+           (unsigned)attrs.size(), mtus[m], (unsigned)pdus,
+           (unsigned long long)us[BATCH_APP], (unsigned long long)us[SINGLE_APP]);
+  }
+}
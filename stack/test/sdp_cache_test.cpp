@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "btm_api.h"
+#include "btu.h"
+#include "gki.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+
+tSDP_CB sdp_cb;
+}
+
+// Devices with a link key, by the last byte of their address.
+static std::set<UINT8> bonded;
+static std::map<UINT8, std::vector<UINT8> > stored;
+static int loads;
+static int stores;
+static int timers;
+static tCONN_CB ccb;
+
+extern "C" {
+tBTM_STATUS BTM_SecGetDeviceLinkKey(BD_ADDR bd_addr, LINK_KEY) {
+  return bonded.count(bd_addr[5]) ? BTM_SUCCESS : BTM_UNKNOWN_ADDR;
+}
+
+tCONN_CB *sdpu_allocate_ccb(void) {
+  memset(&ccb, 0, sizeof(ccb));
+  return &ccb;
+}
+
+void sdpu_release_ccb(tCONN_CB *p_ccb) {
+  GKI_freebuf(p_ccb->rsp_list);
+  p_ccb->rsp_list = NULL;
+  p_ccb->con_state = SDP_STATE_IDLE;
+}
+
+UINT16 sdp_disc_save_attr_lists(tCONN_CB *) {
+  return SDP_SUCCESS;
+}
+
+void btu_start_quick_timer(TIMER_LIST_ENT *, UINT16, UINT32) {
+  ++timers;
+}
+}
+
+static BOOLEAN load_cb(BD_ADDR bd_addr, UINT8 *p_buf, UINT16 *p_len) {
+  ++loads;
+  if (!stored.count(bd_addr[5]))
+    return FALSE;
+
+  std::vector<UINT8> &blob = stored[bd_addr[5]];
+  if (blob.size() > *p_len)
+    return FALSE;
+  memcpy(p_buf, &blob[0], blob.size());
+  *p_len = (UINT16)blob.size();
+  return TRUE;
+}
+
+static void store_cb(BD_ADDR bd_addr, UINT8 *p_buf, UINT16 len) {
+  ++stores;
+  if (len == 0)
+    stored.erase(bd_addr[5]);
+  else
+    stored[bd_addr[5]] = std::vector<UINT8>(p_buf, p_buf + len);
+}
+
+class SdpCacheTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      tSDP_CACHE_STORAGE storage = { load_cb, store_cb };
+
+      bonded.clear();
+      stored.clear();
+      loads = stores = timers = 0;
+
+      SDP_CacheRegisterStorage(&storage);
+      sdp_cache_init();
+
+      memset(&db, 0, sizeof(db));
+      db.num_uuid_filters = 1;
+      db.uuid_filters[0].len = LEN_UUID_16;
+      db.uuid_filters[0].uu.uuid16 = UUID_PROTOCOL_L2CAP;
+    }
+
+    virtual void TearDown() {
+      SDP_CacheInvalidate(NULL);
+      SDP_CacheRegisterStorage(NULL);
+    }
+
+    // Completes an over the air search of |db| on the device ending in |id|.
+    void search_done(UINT8 id) {
+      static UINT8 rsp[] = { 0x35, 0x03, 0x09, 0x00, 0x01 };
+      tCONN_CB conn;
+
+      memset(&conn, 0, sizeof(conn));
+      conn.device_address[5] = id;
+      conn.p_db = &db;
+      conn.rsp_list = rsp;
+      conn.list_len = sizeof(rsp);
+      sdp_cache_store(&conn);
+    }
+
+    BOOLEAN search(UINT8 id) {
+      BD_ADDR bd_addr = { 0, 0, 0, 0, 0, id };
+      BOOLEAN hit = sdp_cache_start_search(bd_addr, &db, NULL, NULL, NULL);
+
+      if (hit)
+        sdp_cache_search_cmpl(&ccb);
+      return hit;
+    }
+
+    tSDP_DISCOVERY_DB db;
+};
+
+TEST_F(SdpCacheTest, test_repeat_search_of_bonded_device_is_a_hit) {
+  tSDP_CACHE_STATS stats;
+
+  bonded.insert(1);
+  EXPECT_FALSE(search(1));
+  search_done(1);
+  EXPECT_TRUE(search(1));
+  EXPECT_EQ(1, timers);
+
+  SDP_CacheGetStats(&stats);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.stores);
+}
+
+TEST_F(SdpCacheTest, test_unbonded_device_is_not_cached) {
+  EXPECT_FALSE(search(2));
+  search_done(2);
+  EXPECT_FALSE(search(2));
+
+  // Nothing is read from or written to storage for it.
+  EXPECT_EQ(0, loads);
+  EXPECT_EQ(0, stores);
+}
+
+TEST_F(SdpCacheTest, test_eir_of_unbonded_device_does_not_touch_storage) {
+  UINT8 eir_uuid[4] = { 0x01, 0, 0, 0 };
+  BD_ADDR bd_addr = { 0, 0, 0, 0, 0, 3 };
+
+  SDP_CacheEirUpdate(bd_addr, eir_uuid, sizeof(eir_uuid));
+  EXPECT_EQ(0, loads);
+  EXPECT_EQ(0, stores);
+}
+
+TEST_F(SdpCacheTest, test_result_survives_restart) {
+  bonded.insert(4);
+  search_done(4);
+  ASSERT_EQ(1u, stored.count(4));
+
+  sdp_cache_init();
+  loads = 0;
+  EXPECT_TRUE(search(4));
+  EXPECT_EQ(1, loads);
+}
+
+TEST_F(SdpCacheTest, test_invalidate_drops_memory_and_storage) {
+  BD_ADDR bd_addr = { 0, 0, 0, 0, 0, 5 };
+
+  bonded.insert(5);
+  search_done(5);
+  SDP_CacheInvalidate(bd_addr);
+
+  EXPECT_EQ(0u, stored.count(5));
+  EXPECT_FALSE(search(5));
+}
+
+TEST_F(SdpCacheTest, test_eir_change_drops_results) {
+  UINT8 eir_a[4] = { 0x01, 0, 0, 0 };
+  UINT8 eir_b[4] = { 0x02, 0, 0, 0 };
+  BD_ADDR bd_addr = { 0, 0, 0, 0, 0, 6 };
+
+  bonded.insert(6);
+  search_done(6);
+  SDP_CacheEirUpdate(bd_addr, eir_a, sizeof(eir_a));
+  EXPECT_TRUE(search(6));
+
+  SDP_CacheEirUpdate(bd_addr, eir_b, sizeof(eir_b));
+  EXPECT_FALSE(search(6));
+}
+
+TEST_F(SdpCacheTest, test_zero_ttl_disables_cache) {
+  bonded.insert(7);
+  SDP_CacheSetTtl(0);
+  search_done(7);
+  EXPECT_FALSE(search(7));
+  EXPECT_EQ(0, stores);
+}
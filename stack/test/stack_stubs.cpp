@@ -0,0 +1,226 @@
+// The GKI OS layer under the real buffer pools, and stubs for the calls of the
+// stack sources under test that the tests do not exercise. Calls the tests
+// drive are faked in the test files.
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "avdt_int.h"
+#include "btm_api.h"
+#include "bnep_int.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "gatt_int.h"
+#include "gki.h"
+#include "gki_int.h"
+#include "l2c_api.h"
+#include "sdp_api.h"
+
+tGKI_CB gki_cb;
+tBTM_CB btm_cb;
+tBTU_CB btu_cb;
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+UINT8 audio_latency_trace_level = BT_TRACE_LEVEL_NONE;
+const tL2CAP_APPL_INFO avdt_l2c_appl = {};
+
+void gki_buffer_init(void);
+
+void GKI_disable(void) {}
+void GKI_enable(void) {}
+void GKI_exception(UINT16, char *) {}
+UINT8 GKI_get_taskid(void) { return 0; }
+UINT8 GKI_send_event(UINT8, UINT16) { return GKI_SUCCESS; }
+void *GKI_os_malloc(UINT32 size) { return malloc(size); }
+void GKI_os_free(void *p_mem) { free(p_mem); }
+
+void LogMsg(UINT32, const char *, ...) {}
+}
+
+class GkiEnvironment : public ::testing::Environment {
+  public:
+    virtual void SetUp() {
+      gki_buffer_init();
+    }
+};
+
+static ::testing::Environment *const gki_env =
+    ::testing::AddGlobalTestEnvironment(new GkiEnvironment);
+
+extern "C" {
+BOOLEAN BTM_BleDataSignature(UINT8 *, UINT8 *, UINT16, UINT8 *) { return 0; }
+void BTM_BleUpdateAdvFilterPolicy(tBTM_BLE_AFP) {}
+BOOLEAN BTM_BleUpdateAdvWhitelist(BOOLEAN, UINT8 *) { return 0; }
+BOOLEAN BTM_BleUpdateBgConnDev(BOOLEAN, UINT8 *) { return 0; }
+BOOLEAN BTM_BleVerifySignature(UINT8 *, UINT8 *, UINT16, UINT32, UINT8 *) { return 0; }
+BOOLEAN BTM_GetSecurityFlagsByTransport(UINT8 *, UINT8 *, tBT_TRANSPORT) { return 0; }
+tBTM_INQ_INFO *BTM_InqDbRead(UINT8 *) { return 0; }
+UINT16 BTM_ReadConnectability(UINT16 *, UINT16 *) { return 0; }
+tBTM_STATUS BTM_SetConnectability(UINT16, UINT16, UINT16) { return 0; }
+tBTM_STATUS BTM_SetDiscoverability(UINT16, UINT16, UINT16) { return 0; }
+tBTM_STATUS BTM_SetEncryption(UINT8 *, tBT_TRANSPORT, tBTM_SEC_CBACK (*), void *) { return 0; }
+tBTM_STATUS BTM_SetInquiryMode(UINT8) { return 0; }
+tBTM_STATUS BTM_SetInquiryScanType(UINT16) { return 0; }
+tBTM_STATUS BTM_SetPageScanType(UINT16) { return 0; }
+void BTM_SetPinType(UINT8, UINT8 *, UINT8) {}
+BOOLEAN BTM_SetSecurityLevel(BOOLEAN, char *, UINT8, UINT16, UINT16, UINT32, UINT32) { return 0; }
+UINT32 GKI_get_os_tick_count(void) { return 0; }
+UINT64 GKI_now_us(void) { return 0; }
+BOOLEAN L2CA_CancelBleConnectReq(UINT8 *) { return 0; }
+BOOLEAN L2CA_ConfigReq(UINT16, tL2CAP_CFG_INFO *) { return 0; }
+BOOLEAN L2CA_ConfigRsp(UINT16, tL2CAP_CFG_INFO *) { return 0; }
+BOOLEAN L2CA_ConnectFixedChnl(UINT16, UINT8 *) { return 0; }
+UINT16 L2CA_ConnectReq(UINT16, UINT8 *) { return 0; }
+BOOLEAN L2CA_ConnectRsp(UINT8 *, UINT8, UINT16, UINT16, UINT16) { return 0; }
+void L2CA_Deregister(UINT16) {}
+BOOLEAN L2CA_DisconnectReq(UINT16) { return 0; }
+BOOLEAN L2CA_DisconnectRsp(UINT16) { return 0; }
+UINT16 L2CA_FlushChannel(UINT16, UINT16) { return 0; }
+UINT16 L2CA_GetDisconnectReason(UINT8 *, tBT_TRANSPORT) { return 0; }
+UINT16 L2CA_Register(UINT16, tL2CAP_APPL_INFO *) { return 0; }
+BOOLEAN L2CA_RemoveFixedChnl(UINT16, UINT8 *) { return 0; }
+BOOLEAN L2CA_SetFixedChannelTout(UINT8 *, UINT16, UINT16) { return 0; }
+BOOLEAN L2CA_SetIdleTimeout(UINT16, UINT16, BOOLEAN) { return 0; }
+BOOLEAN L2CA_SetTxPriority(UINT16, tL2CAP_CHNL_PRIORITY) { return 0; }
+BOOLEAN SDP_AddAttribute(UINT32, UINT16, UINT8, UINT32, UINT8 *) { return 0; }
+BOOLEAN SDP_AddProtocolList(UINT32, UINT16, tSDP_PROTOCOL_ELEM *) { return 0; }
+BOOLEAN SDP_AddServiceClassIdList(UINT32, UINT16, UINT16 *) { return 0; }
+BOOLEAN SDP_AddUuidSequence(UINT32, UINT16, UINT16, UINT16 *) { return 0; }
+UINT32 SDP_CreateRecord(void) { return 0; }
+BOOLEAN SDP_DeleteRecord(UINT32) { return 0; }
+tAVDT_CCB *avdt_ccb_alloc(UINT8 *) { return 0; }
+tAVDT_CCB *avdt_ccb_by_bd(UINT8 *) { return 0; }
+tAVDT_CCB *avdt_ccb_by_idx(UINT8) { return 0; }
+void avdt_ccb_event(tAVDT_CCB *, UINT8, tAVDT_CCB_EVT *) {}
+void avdt_ccb_init(void) {}
+UINT8 avdt_ccb_to_idx(tAVDT_CCB *) { return 0; }
+void avdt_msg_ind(tAVDT_CCB *, BT_HDR *) {}
+void avdt_msg_send_cmd(tAVDT_CCB *, void *, UINT8, tAVDT_MSG *) {}
+void avdt_msg_send_rej(tAVDT_CCB *, UINT8, tAVDT_MSG *) {}
+void avdt_msg_send_rsp(tAVDT_CCB *, UINT8, tAVDT_MSG *) {}
+void bnep_connected(tBNEP_CONN *) {}
+void bte_ssr_cleanup(void) {}
+void btm_acl_device_down(void) {}
+void btm_acl_encrypt_change(UINT16, UINT8, UINT8) {}
+void btm_acl_link_key_change(UINT16, UINT8) {}
+void btm_acl_role_changed(UINT8, UINT8 *, UINT8) {}
+void btm_ble_add_2_white_list_complete(UINT8) {}
+void btm_ble_clear_white_list_complete(UINT8 *, UINT16) {}
+void btm_ble_conn_complete(UINT8 *, UINT16) {}
+void btm_ble_create_ll_conn_complete(UINT8) {}
+BOOLEAN btm_ble_get_enc_key_type(UINT8 *, UINT8 *) { return 0; }
+void btm_ble_link_sec_check(UINT8 *, tBTM_LE_AUTH_REQ, tBTM_BLE_SEC_REQ_ACT *) {}
+void btm_ble_ltk_request(UINT16, UINT8 *, UINT16) {}
+void btm_ble_process_adv_pkt(UINT8 *) {}
+void btm_ble_rand_enc_complete(UINT8 *, UINT16, tBTM_RAND_ENC_CB (*)) {}
+void btm_ble_read_remote_features_complete(UINT8 *) {}
+UINT8 btm_ble_read_sec_key_size(UINT8 *) { return 0; }
+void btm_ble_remove_from_white_list_complete(UINT8 *, UINT16) {}
+tBTM_STATUS btm_ble_set_connectability(UINT16) { return 0; }
+void btm_ble_test_command_complete(UINT8 *) {}
+void btm_ble_vendor_irk_list_remove_dev(tBTM_SEC_DEV_REC *) {}
+void btm_ble_write_adv_enable_complete(UINT8 *) {}
+void btm_create_conn_cancel_complete(UINT8 *) {}
+void btm_esco_proc_conn_chg(UINT8, UINT16, UINT8, UINT8, UINT16, UINT16) {}
+void btm_event_filter_complete(UINT8 *) {}
+void btm_handle_rssi_monitor_event(UINT8 *, UINT8) {}
+void btm_inq_db_reset(void) {}
+void btm_io_capabilities_req(UINT8 *) {}
+void btm_io_capabilities_rsp(UINT8 *) {}
+BOOLEAN btm_is_sco_active(UINT16) { return 0; }
+BOOLEAN btm_is_sco_active_by_bdaddr(UINT8 *) { return 0; }
+void btm_keypress_notif_evt(UINT8 *) {}
+void btm_pm_proc_cmd_status(UINT8) {}
+void btm_pm_proc_mode_change(UINT8, UINT16, UINT8, UINT16) {}
+void btm_pm_proc_ssr_evt(UINT8 *, UINT16) {}
+void btm_pm_reset(void) {}
+void btm_proc_lsto_evt(UINT16, UINT16) {}
+void btm_proc_sp_req_evt(tBTM_SP_EVT, UINT8 *) {}
+void btm_process_cancel_complete(UINT8, UINT8) {}
+void btm_process_clk_off_comp_evt(UINT16, UINT16) {}
+void btm_process_inq_complete(UINT8, UINT8) {}
+void btm_process_inq_results(UINT8 *, UINT8) {}
+void btm_process_remote_name(UINT8 *, UINT8 *, UINT16, UINT8) {}
+void btm_qos_setup_complete(UINT8, UINT16, FLOW_SPEC *) {}
+void btm_read_link_policy_complete(UINT8 *) {}
+void btm_read_link_quality_complete(UINT8 *) {}
+void btm_read_linq_tx_power_complete(UINT8 *) {}
+void btm_read_local_oob_complete(UINT8 *) {}
+void btm_read_local_oob_extended_complete(UINT8 *) {}
+void btm_read_remote_ext_features_complete(UINT8 *) {}
+void btm_read_remote_ext_features_failed(UINT8, UINT16) {}
+void btm_read_remote_features_complete(UINT8 *) {}
+void btm_read_remote_version_complete(UINT8 *) {}
+void btm_read_rssi_complete(UINT8 *) {}
+void btm_read_tx_power_complete(UINT8 *, BOOLEAN) {}
+void btm_rem_oob_req(UINT8 *) {}
+void btm_sco_chk_pend_unpark(UINT8, UINT16) {}
+void btm_sco_conn_req(UINT8 *, UINT8 *, UINT8) {}
+void btm_sco_connected(UINT8, UINT8 *, UINT16, tBTM_ESCO_DATA *) {}
+void btm_sco_removed(UINT16, UINT8) {}
+void btm_sec_auth_complete(UINT16, UINT8) {}
+void btm_sec_clear_ble_keys(tBTM_SEC_DEV_REC *) {}
+void btm_sec_conn_req(UINT8 *, UINT8 *) {}
+void btm_sec_connected(UINT8 *, UINT16, UINT8, UINT8) {}
+void btm_sec_dev_reset(void) {}
+void btm_sec_disconnected(UINT16, UINT8) {}
+void btm_sec_encrypt_change(UINT16, UINT8, UINT8) {}
+BOOLEAN btm_sec_is_a_bonded_dev(UINT8 *) { return 0; }
+void btm_sec_link_key_notification(UINT8 *, UINT8 *, UINT8) {}
+void btm_sec_link_key_request(UINT8 *) {}
+void btm_sec_mkey_comp_event(UINT16, UINT8, UINT8) {}
+tBTM_STATUS btm_sec_mx_access_request(UINT8 *, UINT16, BOOLEAN, UINT32, UINT32, tBTM_SEC_CALLBACK (*), void *) { return 0; }
+void btm_sec_pin_code_request(UINT8 *) {}
+void btm_sec_rmt_host_support_feat_evt(UINT8 *) {}
+void btm_sec_rmt_name_request_complete(UINT8 *, UINT8 *, UINT8) {}
+void btm_sec_update_clock_offset(UINT16, UINT16) {}
+void btm_simple_pair_complete(UINT8 *) {}
+BOOLEAN btsnd_hcic_ble_set_evt_mask(UINT8 *) { return 0; }
+BOOLEAN btsnd_hcic_change_name(UINT8 *) { return 0; }
+BOOLEAN btsnd_hcic_delete_stored_key(UINT8 *, BOOLEAN) { return 0; }
+BOOLEAN btsnd_hcic_enable_test_mode(void) { return 0; }
+BOOLEAN btsnd_hcic_host_num_xmitted_pkts(UINT8, UINT16 *, UINT16 *) { return 0; }
+void btsnd_hcic_raw_cmd(void *, UINT16, UINT8, UINT8 *, void *) {}
+BOOLEAN btsnd_hcic_read_bd_addr(void) { return 0; }
+BOOLEAN btsnd_hcic_read_name(void) { return 0; }
+BOOLEAN btsnd_hcic_read_stored_key(UINT8 *, BOOLEAN) { return 0; }
+BOOLEAN btsnd_hcic_set_afh_channels(UINT8, UINT8) { return 0; }
+BOOLEAN btsnd_hcic_set_event_filter(UINT8, UINT8, UINT8 *, UINT8) { return 0; }
+BOOLEAN btsnd_hcic_set_event_mask(UINT8, UINT8 *) { return 0; }
+BOOLEAN btsnd_hcic_set_host_buf_size(UINT16, UINT8, UINT16, UINT16) { return 0; }
+void btsnd_hcic_vendor_spec_cmd_ctx(void *, UINT16, UINT8, UINT8 *, void *, void *, UINT8) {}
+BOOLEAN btsnd_hcic_write_afh_channel_assessment_mode(UINT8) { return 0; }
+BOOLEAN btsnd_hcic_write_dev_class(UINT8 *) { return 0; }
+BOOLEAN btsnd_hcic_write_page_tout(UINT16) { return 0; }
+BOOLEAN btsnd_hcic_write_sec_conn_host_support(UINT8) { return 0; }
+BOOLEAN btsnd_hcic_write_stored_key(UINT8, BD_ADDR (*), LINK_KEY (*)) { return 0; }
+BOOLEAN btsnd_hcic_write_voice_settings(UINT16) { return 0; }
+void btu_check_bt_sleep(void) {}
+void btu_start_timer(TIMER_LIST_ENT *, UINT16, UINT32) {}
+void btu_stop_timer(TIMER_LIST_ENT *) {}
+void gatt_dequeue_sr_cmd(tGATT_TCB *) {}
+void gatt_profile_db_init(void) {}
+UINT16 gatt_profile_find_conn_id_by_bd_addr(UINT8 *) { return 0; }
+void gatt_server_handle_client_req(tGATT_TCB *, UINT8, UINT16, UINT8 *) {}
+UINT32 gatt_sr_enqueue_cmd(tGATT_TCB *, UINT8, UINT16) { return 0; }
+tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB *, tGATT_IF, UINT32, UINT8, tGATT_STATUS, tGATTS_RSP *) { return 0; }
+void gatts_process_value_conf(tGATT_TCB *, UINT8) {}
+BOOLEAN l2c_link_hci_conn_comp(UINT8, UINT16, UINT8 *) { return 0; }
+BOOLEAN l2c_link_hci_disc_comp(UINT16, UINT8) { return 0; }
+BOOLEAN l2c_link_hci_qos_violation(UINT16) { return 0; }
+UINT8 l2c_link_pkts_rcvd(UINT16 *, UINT16 *) { return 0; }
+void l2c_link_process_num_completed_pkts(UINT8 *) {}
+void l2c_link_processs_ble_num_bufs(UINT16) {}
+void l2c_link_processs_num_bufs(UINT16) {}
+void l2c_link_role_changed(UINT8 *, UINT8, UINT8) {}
+void l2c_pin_code_request(UINT8 *) {}
+void l2cble_process_conn_update_evt(UINT16, UINT8) {}
+void l2cble_process_rc_param_request_evt(UINT16, UINT16, UINT16, UINT16, UINT16) {}
+void l2cu_device_reset(void) {}
+void l2cu_set_non_flushable_pbf(BOOLEAN) {}
+int property_get(const char *, char *, const char *) { return 0; }
+}
@@ -0,0 +1,30 @@
+LOCAL_PATH := $(call my-dir)
+
+# uipc.c is built into bluetooth.default by main/Android.mk; only its tests
+# are built here.
+
+#####################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/../audio_a2dp_hw \
+    $(LOCAL_PATH)/../gki/common \
+    $(LOCAL_PATH)/../gki/ulinux \
+    $(LOCAL_PATH)/../include \
+    $(LOCAL_PATH)/../stack/include \
+    $(LOCAL_PATH)/../utils/include \
+    $(bdroid_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ./test/uipc_test.cpp \
+    ./ulinux/uipc.c
+
+LOCAL_CFLAGS := -DBUILDCFG $(bdroid_CFLAGS)
+LOCAL_CONLYFLAGS := -std=c99
+LOCAL_MODULE := udrvtests
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog
+
+include $(BUILD_NATIVE_TEST)
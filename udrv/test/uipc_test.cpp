@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <cutils/sockets.h>
+
+extern "C" {
+#include "bt_target.h"
+#include "bt_types.h"
+#include "bt_utils.h"
+#include "gki.h"
+#include "uipc.h"
+#include "audio_a2dp_hw.h"
+}
+
+typedef std::pair<tUIPC_CH_ID, tUIPC_EVENT> uipc_evt_t;
+
+static pthread_mutex_t events_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t events_cond = PTHREAD_COND_INITIALIZER;
+
+// Every callback, with the first byte read for data events, in order.
+static std::vector<uipc_evt_t> events;
+static std::vector<UINT8> data_read[UIPC_CH_NUM];
+
+// Set while a callback finds a channel lock held by the read task.
+static bool lock_held_in_cback;
+static bool check_locks;
+
+// The control callback waits on this gate on its first data event, holding up
+// the read task until the test lets it go.
+static bool gate_armed;
+static bool gate_open;
+
+// The autobound address each server socket ended up on, by socket name.
+struct server_addr_t {
+  struct sockaddr_un addr;
+  socklen_t len;
+};
+
+static std::map<std::string, server_addr_t> server_addrs;
+
+extern "C" {
+UINT8 btif_trace_level = BT_TRACE_LEVEL_NONE;
+
+void LogMsg(UINT32, const char *, ...) {}
+void raise_priority_a2dp(tHIGH_PRIORITY_TASK) {}
+
+// Binds to a unique abstract address instead of the name, so the test does
+// not collide with a running stack, and remembers it for connect_ch.
+int socket_local_server_bind(int s, const char *name, int) {
+  server_addr_t server;
+
+  memset(&server, 0, sizeof(server));
+  server.addr.sun_family = AF_LOCAL;
+  if (bind(s, (struct sockaddr *)&server.addr, sizeof(sa_family_t)) < 0)
+    return -1;
+  server.len = sizeof(server.addr);
+  getsockname(s, (struct sockaddr *)&server.addr, &server.len);
+  server_addrs[name] = server;
+  return s;
+}
+}
+
+static void *try_ch_locks(void *) {
+  for (tUIPC_CH_ID ch = 0; ch < UIPC_CH_NUM; ++ch)
+    UIPC_Ioctl(ch, UIPC_SET_READ_POLL_TMO, (void *)(intptr_t)DEFAULT_READ_POLL_TMO_MS);
+  return NULL;
+}
+
+// Takes every channel lock from another thread; it can only finish in time if
+// the read task holds none of them.
+static void check_no_lock_held(void) {
+  pthread_t tid;
+  struct timespec deadline;
+
+  pthread_create(&tid, NULL, try_ch_locks, NULL);
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += 1;
+  if (pthread_timedjoin_np(tid, NULL, &deadline) != 0) {
+    lock_held_in_cback = true;
+    pthread_detach(tid);
+  }
+}
+
+static void uipc_cback(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  UINT8 byte = 0;
+
+  if (check_locks)
+    check_no_lock_held();
+
+  if (event == UIPC_RX_DATA_READY_EVT)
+    UIPC_Read(ch_id, NULL, &byte, 1);
+
+  pthread_mutex_lock(&events_lock);
+  events.push_back(uipc_evt_t(ch_id, event));
+  if (event == UIPC_RX_DATA_READY_EVT)
+    data_read[ch_id].push_back(byte);
+  pthread_cond_broadcast(&events_cond);
+  if (event == UIPC_RX_DATA_READY_EVT && ch_id == UIPC_CH_ID_AV_CTRL && gate_armed) {
+    gate_armed = false;
+    while (!gate_open)
+      pthread_cond_wait(&events_cond, &events_lock);
+  }
+  pthread_mutex_unlock(&events_lock);
+
+  // The audio close is answered on the control channel.
+  if (event == UIPC_CLOSE_EVT && ch_id == UIPC_CH_ID_AV_AUDIO)
+    UIPC_Send(UIPC_CH_ID_AV_CTRL, 0, &byte, 1);
+}
+
+class UipcTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      events.clear();
+      for (int i = 0; i < UIPC_CH_NUM; ++i) {
+        data_read[i].clear();
+        client[i] = -1;
+      }
+      lock_held_in_cback = false;
+      check_locks = false;
+      gate_armed = false;
+      gate_open = false;
+      server_addrs.clear();
+      UIPC_Init(NULL);
+    }
+
+    virtual void TearDown() {
+      UIPC_Close(UIPC_CH_ID_ALL);
+      for (int i = 0; i < UIPC_CH_NUM; ++i)
+        if (client[i] >= 0)
+          close(client[i]);
+    }
+
+    // Opens the channel and connects to it as the audio HAL does.
+    void connect_ch(tUIPC_CH_ID ch_id, const char *path) {
+      ASSERT_TRUE(UIPC_Open(ch_id, uipc_cback));
+      ASSERT_EQ(1u, server_addrs.count(path));
+
+      client[ch_id] = socket(AF_LOCAL, SOCK_STREAM, 0);
+      ASSERT_EQ(0, connect(client[ch_id], (struct sockaddr *)&server_addrs[path].addr,
+                           server_addrs[path].len));
+      ASSERT_TRUE(wait_event(ch_id, UIPC_OPEN_EVT));
+    }
+
+    void send_byte(tUIPC_CH_ID ch_id, UINT8 byte) {
+      ASSERT_EQ(1, write(client[ch_id], &byte, 1));
+    }
+
+    // Waits up to a second for a callback with the event on the channel.
+    bool wait_event(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+      struct timespec deadline;
+      bool found = false;
+
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += 1;
+      pthread_mutex_lock(&events_lock);
+      while (!found) {
+        for (size_t n = 0; n < events.size() && !found; ++n)
+          found = (events[n] == uipc_evt_t(ch_id, event));
+        if (!found && pthread_cond_timedwait(&events_cond, &events_lock, &deadline) == ETIMEDOUT)
+          break;
+      }
+      pthread_mutex_unlock(&events_lock);
+      return found;
+    }
+
+    // Waits up to a second for |count| bytes read on the channel.
+    bool wait_data(tUIPC_CH_ID ch_id, size_t count) {
+      struct timespec deadline;
+
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += 1;
+      pthread_mutex_lock(&events_lock);
+      while (data_read[ch_id].size() < count &&
+             pthread_cond_timedwait(&events_cond, &events_lock, &deadline) != ETIMEDOUT)
+        ;
+      bool done = data_read[ch_id].size() >= count;
+      pthread_mutex_unlock(&events_lock);
+      return done;
+    }
+
+    int client[UIPC_CH_NUM];
+};
+
+TEST_F(UipcTest, test_data_is_dispatched_to_its_channel) {
+  connect_ch(UIPC_CH_ID_AV_CTRL, A2DP_CTRL_PATH);
+  connect_ch(UIPC_CH_ID_AV_AUDIO, A2DP_DATA_PATH);
+
+  for (UINT8 i = 0; i < 20; ++i) {
+    send_byte(UIPC_CH_ID_AV_CTRL, i);
+    send_byte(UIPC_CH_ID_AV_AUDIO, (UINT8)(100 + i));
+  }
+  ASSERT_TRUE(wait_data(UIPC_CH_ID_AV_CTRL, 20));
+  ASSERT_TRUE(wait_data(UIPC_CH_ID_AV_AUDIO, 20));
+
+  for (UINT8 i = 0; i < 20; ++i) {
+    EXPECT_EQ(i, data_read[UIPC_CH_ID_AV_CTRL][i]);
+    EXPECT_EQ(100 + i, data_read[UIPC_CH_ID_AV_AUDIO][i]);
+  }
+}
+
+TEST_F(UipcTest, test_audio_is_served_first) {
+  connect_ch(UIPC_CH_ID_AV_CTRL, A2DP_CTRL_PATH);
+  connect_ch(UIPC_CH_ID_AV_AUDIO, A2DP_DATA_PATH);
+
+  // Hold the read task in the control callback so both channels become
+  // ready in the same epoll batch.
+  gate_armed = true;
+  send_byte(UIPC_CH_ID_AV_CTRL, 'h');
+  ASSERT_TRUE(wait_data(UIPC_CH_ID_AV_CTRL, 1));
+  send_byte(UIPC_CH_ID_AV_CTRL, 'c');
+  send_byte(UIPC_CH_ID_AV_AUDIO, 'a');
+  usleep(10000);
+
+  pthread_mutex_lock(&events_lock);
+  size_t held = events.size();
+  gate_open = true;
+  pthread_cond_broadcast(&events_cond);
+  pthread_mutex_unlock(&events_lock);
+
+  ASSERT_TRUE(wait_data(UIPC_CH_ID_AV_CTRL, 2));
+  ASSERT_TRUE(wait_data(UIPC_CH_ID_AV_AUDIO, 1));
+  ASSERT_LT(held + 1, events.size());
+  EXPECT_EQ(uipc_evt_t(UIPC_CH_ID_AV_AUDIO, UIPC_RX_DATA_READY_EVT), events[held]);
+  EXPECT_EQ(uipc_evt_t(UIPC_CH_ID_AV_CTRL, UIPC_RX_DATA_READY_EVT), events[held + 1]);
+}
+
+TEST_F(UipcTest, test_callbacks_run_without_channel_lock) {
+  check_locks = true;
+  connect_ch(UIPC_CH_ID_AV_CTRL, A2DP_CTRL_PATH);
+  connect_ch(UIPC_CH_ID_AV_AUDIO, A2DP_DATA_PATH);
+  send_byte(UIPC_CH_ID_AV_AUDIO, 1);
+  send_byte(UIPC_CH_ID_AV_CTRL, 2);
+  ASSERT_TRUE(wait_data(UIPC_CH_ID_AV_AUDIO, 1));
+  ASSERT_TRUE(wait_data(UIPC_CH_ID_AV_CTRL, 1));
+
+  // The audio close callback sends on the control channel.
+  UIPC_Close(UIPC_CH_ID_AV_AUDIO);
+  ASSERT_TRUE(wait_event(UIPC_CH_ID_AV_AUDIO, UIPC_CLOSE_EVT));
+  UINT8 byte;
+  EXPECT_EQ(1, read(client[UIPC_CH_ID_AV_CTRL], &byte, 1));
+
+  EXPECT_FALSE(lock_held_in_cback);
+}
+
+TEST_F(UipcTest, test_close_notifies_and_disconnects) {
+  UINT8 byte;
+
+  connect_ch(UIPC_CH_ID_AV_CTRL, A2DP_CTRL_PATH);
+  UIPC_Close(UIPC_CH_ID_AV_CTRL);
+  ASSERT_TRUE(wait_event(UIPC_CH_ID_AV_CTRL, UIPC_CLOSE_EVT));
+  EXPECT_EQ(0, read(client[UIPC_CH_ID_AV_CTRL], &byte, 1));
+}
+
+TEST_F(UipcTest, test_removed_channel_is_not_dispatched) {
+  UINT8 byte = 0;
+
+  connect_ch(UIPC_CH_ID_AV_AUDIO, A2DP_DATA_PATH);
+  UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REG_REMOVE_ACTIVE_READSET, NULL);
+
+  // The data is left for the owner to read directly.
+  send_byte(UIPC_CH_ID_AV_AUDIO, 9);
+  EXPECT_FALSE(wait_data(UIPC_CH_ID_AV_AUDIO, 1));
+  EXPECT_EQ(1u, UIPC_Read(UIPC_CH_ID_AV_AUDIO, NULL, &byte, 1));
+  EXPECT_EQ(9, byte);
+}
@@ -38,7 +38,8 @@
 #include <signal.h>
 #include <errno.h>
 #include <pthread.h>
-#include <sys/select.h>
+#include <time.h>
+#include <sys/epoll.h>
 #include <sys/poll.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -59,8 +60,6 @@
 
 #define PCM_FILENAME "/data/test.pcm"
 
-#define MAX(a,b) ((a)>(b)?(a):(b))
-
 #define CASE_RETURN_STR(const) case const: return #const;
 
 #define UIPC_DISCONNECTED (-1)
@@ -68,7 +67,27 @@
 #define UIPC_LOCK() /*BTIF_TRACE_EVENT(" %s lock", __FUNCTION__);*/ pthread_mutex_lock(&uipc_main.mutex);
 #define UIPC_UNLOCK() /*BTIF_TRACE_EVENT("%s unlock", __FUNCTION__);*/ pthread_mutex_unlock(&uipc_main.mutex);
 
-#define SAFE_FD_ISSET(fd, set) (((fd) == -1) ? FALSE : FD_ISSET((fd), (set)))
+/* Each channel has its own recursive lock, so audio data is never held up by
+** control traffic. No channel lock is held while a channel callback runs, so
+** a callback may call UIPC on any channel (the audio close callback answers
+** on the control channel), and no code path holds two channel locks at once.
+*/
+#define UIPC_CH_LOCK(ch_id) pthread_mutex_lock(&uipc_main.ch[ch_id].lock);
+#define UIPC_CH_UNLOCK(ch_id) pthread_mutex_unlock(&uipc_main.ch[ch_id].lock);
+
+/* epoll event data : fd in the upper 32 bits, fd kind and channel below */
+#define UIPC_EV_SIGNAL  0
+#define UIPC_EV_SRV     1
+#define UIPC_EV_DATA    2
+
+#define UIPC_EV_PACK(fd, kind, ch_id) \
+    (((uint64_t)(uint32_t)(fd) << 32) | ((uint64_t)(kind) << 8) | (uint64_t)(ch_id))
+#define UIPC_EV_FD(data)    ((int)((data) >> 32))
+#define UIPC_EV_KIND(data)  ((int)(((data) >> 8) & 0xFF))
+#define UIPC_EV_CH(data)    ((tUIPC_CH_ID)((data) & 0xFF))
+
+/* signal fd plus a server and a connection per channel */
+#define UIPC_MAX_EVENTS (1 + 2 * UIPC_CH_NUM)
 
 /*****************************************************************************
 **  Local type definitions
@@ -78,15 +97,25 @@ typedef enum {
     UIPC_TASK_FLAG_DISCONNECT_CHAN = 0x1,
 } tUIPC_TASK_FLAGS;
 
+/* time from epoll_wait returning to the channel callback being invoked */
+typedef struct {
+    UINT32 wakeups;
+    UINT32 max_us;
+    UINT64 total_us;
+} tUIPC_CH_STATS;
+
 typedef struct {
     int srvfd;
     int fd;
+    BOOLEAN rx_active;    /* fd is in the epoll set, see UIPC_REG_REMOVE_ACTIVE_READSET */
     int read_poll_tmo_ms;
     int task_evt_flags;   /* event flags pending to be processed in read task */
     tUIPC_EVENT cond_flags;
+    pthread_mutex_t lock;
     pthread_mutex_t cond_mutex;
     pthread_cond_t  cond;
     tUIPC_RCV_CBACK *cback;
+    tUIPC_CH_STATS stats;
 } tUIPC_CHAN;
 
 typedef struct {
@@ -94,9 +123,7 @@ typedef struct {
     int running;
     pthread_mutex_t mutex;
 
-    fd_set active_set;
-    fd_set read_set;
-    int max_fd;
+    int epfd;
     int signal_fds[2];
 
     tUIPC_CHAN ch[UIPC_CH_NUM];
@@ -115,6 +142,7 @@ static tUIPC_MAIN uipc_main;
 ******************************************************************************/
 
 static int uipc_close_ch_locked(tUIPC_CH_ID ch_id);
+static void uipc_notify(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 
 /*****************************************************************************
 **  Externs
@@ -206,34 +234,77 @@ static int accept_server_socket(int sfd)
 **
 *****************************************************************************/
 
-static int uipc_main_init(void)
+static inline UINT64 uipc_time_us(void)
 {
-    int i;
-    const pthread_mutexattr_t attr = PTHREAD_MUTEX_RECURSIVE;
-    pthread_mutex_init(&uipc_main.mutex, &attr);
+    struct timespec ts;
 
-    BTIF_TRACE_EVENT("### uipc_main_init ###");
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((UINT64)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
 
-    /* setup interrupt socket pair */
-    if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc_main.signal_fds) < 0)
+static int uipc_epoll_add(int fd, int kind, tUIPC_CH_ID ch_id)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = UIPC_EV_PACK(fd, kind, ch_id);
+
+    if (epoll_ctl(uipc_main.epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
     {
+        BTIF_TRACE_ERROR("failed to add fd %d to epoll set (%s)", fd, strerror(errno));
         return -1;
     }
+    return 0;
+}
+
+static void uipc_epoll_del(int fd)
+{
+    if (epoll_ctl(uipc_main.epfd, EPOLL_CTL_DEL, fd, NULL) < 0)
+        BTIF_TRACE_EVENT("failed to remove fd %d from epoll set (%s)", fd, strerror(errno));
+}
+
+static int uipc_main_init(void)
+{
+    int i;
+    pthread_mutexattr_t attr;
 
-    FD_SET(uipc_main.signal_fds[0], &uipc_main.active_set);
-    uipc_main.max_fd = MAX(uipc_main.max_fd, uipc_main.signal_fds[0]);
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&uipc_main.mutex, &attr);
+
+    BTIF_TRACE_EVENT("### uipc_main_init ###");
 
     for (i=0; i< UIPC_CH_NUM; i++)
     {
         tUIPC_CHAN *p = &uipc_main.ch[i];
         p->srvfd = UIPC_DISCONNECTED;
         p->fd = UIPC_DISCONNECTED;
+        p->rx_active = FALSE;
         p->task_evt_flags = 0;
+        pthread_mutex_init(&p->lock, &attr);
         pthread_cond_init(&p->cond, NULL);
         pthread_mutex_init(&p->cond_mutex, NULL);
         p->cback = NULL;
     }
 
+    pthread_mutexattr_destroy(&attr);
+
+    uipc_main.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (uipc_main.epfd < 0)
+    {
+        BTIF_TRACE_ERROR("epoll_create1 failed (%s)", strerror(errno));
+        return -1;
+    }
+
+    /* setup interrupt socket pair */
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc_main.signal_fds) < 0)
+    {
+        return -1;
+    }
+
+    uipc_epoll_add(uipc_main.signal_fds[0], UIPC_EV_SIGNAL, 0);
+
     return 0;
 }
 
@@ -248,85 +319,150 @@ void uipc_main_cleanup(void)
 
     /* close any open channels */
     for (i=0; i<UIPC_CH_NUM; i++)
+    {
+        UIPC_CH_LOCK(i);
         uipc_close_ch_locked(i);
+        UIPC_CH_UNLOCK(i);
+
+        uipc_notify(i, UIPC_CLOSE_EVT);
+    }
+
+    close(uipc_main.epfd);
+    uipc_main.epfd = -1;
 }
 
 
 
 /* check pending events in read task */
-static void uipc_check_task_flags_locked(void)
+static void uipc_check_task_flags(void)
 {
     int i;
 
+    BOOLEAN closed;
+
     for (i=0; i<UIPC_CH_NUM; i++)
     {
+        closed = FALSE;
+
+        UIPC_CH_LOCK(i);
+
         //BTIF_TRACE_EVENT("CHECK TASK FLAGS %x %x",  uipc_main.ch[i].task_evt_flags, UIPC_TASK_FLAG_DISCONNECT_CHAN);
         if (uipc_main.ch[i].task_evt_flags & UIPC_TASK_FLAG_DISCONNECT_CHAN)
         {
             uipc_main.ch[i].task_evt_flags &= ~UIPC_TASK_FLAG_DISCONNECT_CHAN;
             uipc_close_ch_locked(i);
+            closed = TRUE;
         }
 
         /* add here */
 
+        UIPC_CH_UNLOCK(i);
+
+        if (closed)
+            uipc_notify(i, UIPC_CLOSE_EVT);
     }
 }
 
 
-static int uipc_check_fd_locked(tUIPC_CH_ID ch_id)
+static void uipc_update_stats_locked(tUIPC_CH_ID ch_id, UINT64 wake_us)
 {
-    if (ch_id >= UIPC_CH_NUM)
-        return -1;
+    tUIPC_CH_STATS *p_stats = &uipc_main.ch[ch_id].stats;
+    UINT32 lat_us = (UINT32)(uipc_time_us() - wake_us);
+
+    p_stats->wakeups++;
+    p_stats->total_us += lat_us;
+    if (lat_us > p_stats->max_us)
+        p_stats->max_us = lat_us;
+}
+
+static void uipc_dump_stats_locked(tUIPC_CH_ID ch_id)
+{
+    tUIPC_CH_STATS *p_stats = &uipc_main.ch[ch_id].stats;
+
+    if (p_stats->wakeups == 0)
+        return;
+
+    BTIF_TRACE_DEBUG("UIPC CH %d wakeup latency : %u events, avg %u us, max %u us", ch_id,
+            p_stats->wakeups, (UINT32)(p_stats->total_us / p_stats->wakeups), p_stats->max_us);
 
-    //BTIF_TRACE_EVENT("CHECK SRVFD %d (ch %d)", uipc_main.ch[ch_id].srvfd, ch_id);
+    memset(p_stats, 0, sizeof(tUIPC_CH_STATS));
+}
+
+
+/* handle one ready fd of a channel, the channel lock must be held. Returns the
+** event to notify once the lock is released, 0 if none */
+static tUIPC_EVENT uipc_ch_event_locked(tUIPC_CH_ID ch_id, int kind, int fd, UINT64 wake_us)
+{
+    tUIPC_CHAN *p = &uipc_main.ch[ch_id];
 
-    if (SAFE_FD_ISSET(uipc_main.ch[ch_id].srvfd, &uipc_main.read_set))
+    if (kind == UIPC_EV_SRV)
     {
+        /* closed after epoll_wait returned */
+        if (p->srvfd != fd)
+            return 0;
+
         BTIF_TRACE_EVENT("INCOMING CONNECTION ON CH %d", ch_id);
 
-        uipc_main.ch[ch_id].fd = accept_server_socket(uipc_main.ch[ch_id].srvfd);
+        p->fd = accept_server_socket(p->srvfd);
 
-        BTIF_TRACE_EVENT("NEW FD %d", uipc_main.ch[ch_id].fd);
+        BTIF_TRACE_EVENT("NEW FD %d", p->fd);
 
-        if ((uipc_main.ch[ch_id].fd > 0) && uipc_main.ch[ch_id].cback)
+        if ((p->fd > 0) && p->cback)
         {
-            /*  if we have a callback we should add this fd to the active set
+            /*  if we have a callback we should add this fd to the epoll set
                 and notify user with callback event */
-            BTIF_TRACE_EVENT("ADD FD %d TO ACTIVE SET", uipc_main.ch[ch_id].fd);
-            FD_SET(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-            uipc_main.max_fd = MAX(uipc_main.max_fd, uipc_main.ch[ch_id].fd);
+            BTIF_TRACE_EVENT("ADD FD %d TO EPOLL SET", p->fd);
+            p->rx_active = (uipc_epoll_add(p->fd, UIPC_EV_DATA, ch_id) == 0);
         }
 
-        if (uipc_main.ch[ch_id].fd < 0)
+        if (p->fd < 0)
         {
             BTIF_TRACE_ERROR("FAILED TO ACCEPT CH %d (%s)", ch_id, strerror(errno));
-            return -1;
+            return 0;
         }
 
-        if (uipc_main.ch[ch_id].cback)
-            uipc_main.ch[ch_id].cback(ch_id, UIPC_OPEN_EVT);
+        if (p->cback)
+        {
+            uipc_update_stats_locked(ch_id, wake_us);
+            return UIPC_OPEN_EVT;
+        }
     }
-
-    //BTIF_TRACE_EVENT("CHECK FD %d (ch %d)", uipc_main.ch[ch_id].fd, ch_id);
-
-    if (SAFE_FD_ISSET(uipc_main.ch[ch_id].fd, &uipc_main.read_set))
+    else
     {
+        /* closed, or removed from the epoll set, after epoll_wait returned */
+        if ((p->fd != fd) || !p->rx_active)
+            return 0;
+
         //BTIF_TRACE_EVENT("INCOMING DATA ON CH %d", ch_id);
 
-        if (uipc_main.ch[ch_id].cback)
-            uipc_main.ch[ch_id].cback(ch_id, UIPC_RX_DATA_READY_EVT);
+        if (p->cback)
+        {
+            uipc_update_stats_locked(ch_id, wake_us);
+            return UIPC_RX_DATA_READY_EVT;
+        }
     }
+
     return 0;
 }
 
-static void uipc_check_interrupt_locked(void)
+/* call the channel callback, no channel lock may be held */
+static void uipc_notify(tUIPC_CH_ID ch_id, tUIPC_EVENT event)
 {
-    if (SAFE_FD_ISSET(uipc_main.signal_fds[0], &uipc_main.read_set))
-    {
-        char sig_recv = 0;
-        //BTIF_TRACE_EVENT("UIPC INTERRUPT");
-        recv(uipc_main.signal_fds[0], &sig_recv, sizeof(sig_recv), MSG_WAITALL);
-    }
+    tUIPC_RCV_CBACK *cback;
+
+    UIPC_CH_LOCK(ch_id);
+    cback = uipc_main.ch[ch_id].cback;
+    UIPC_CH_UNLOCK(ch_id);
+
+    if (cback)
+        cback(ch_id, event);
+}
+
+static void uipc_check_interrupt(void)
+{
+    char sig_recv = 0;
+    //BTIF_TRACE_EVENT("UIPC INTERRUPT");
+    recv(uipc_main.signal_fds[0], &sig_recv, sizeof(sig_recv), MSG_WAITALL);
 }
 
 static inline void uipc_wakeup_locked(void)
@@ -345,29 +481,21 @@ static int uipc_setup_server_locked(tUIPC_CH_ID ch_id, char *name, tUIPC_RCV_CBA
     if (ch_id >= UIPC_CH_NUM)
         return -1;
 
-    UIPC_LOCK();
-
     fd = create_server_socket(name);
 
     if (fd < 0)
     {
         BTIF_TRACE_ERROR("failed to setup %s", name, strerror(errno));
-        UIPC_UNLOCK();
          return -1;
     }
 
-    BTIF_TRACE_EVENT("ADD SERVER FD TO ACTIVE SET %d", fd);
-    FD_SET(fd, &uipc_main.active_set);
-    uipc_main.max_fd = MAX(uipc_main.max_fd, fd);
-
     uipc_main.ch[ch_id].srvfd = fd;
     uipc_main.ch[ch_id].cback = cback;
     uipc_main.ch[ch_id].read_poll_tmo_ms = DEFAULT_READ_POLL_TMO_MS;
 
-    /* trigger main thread to update read set */
-    uipc_wakeup_locked();
-
-    UIPC_UNLOCK();
+    /* the read task picks this up right away, no wakeup needed */
+    BTIF_TRACE_EVENT("ADD SERVER FD TO EPOLL SET %d", fd);
+    uipc_epoll_add(fd, UIPC_EV_SRV, ch_id);
 
     return 0;
 }
@@ -441,8 +569,6 @@ static void uipc_flush_locked(tUIPC_CH_ID ch_id)
 
 static int uipc_close_ch_locked(tUIPC_CH_ID ch_id)
 {
-    int wakeup = 0;
-
     BTIF_TRACE_EVENT("CLOSE CHANNEL %d", ch_id);
 
     if (ch_id >= UIPC_CH_NUM)
@@ -451,29 +577,24 @@ static int uipc_close_ch_locked(tUIPC_CH_ID ch_id)
     if (uipc_main.ch[ch_id].srvfd != UIPC_DISCONNECTED)
     {
         BTIF_TRACE_EVENT("CLOSE SERVER (FD %d)", uipc_main.ch[ch_id].srvfd);
+        uipc_epoll_del(uipc_main.ch[ch_id].srvfd);
         close(uipc_main.ch[ch_id].srvfd);
-        FD_CLR(uipc_main.ch[ch_id].srvfd, &uipc_main.active_set);
         uipc_main.ch[ch_id].srvfd = UIPC_DISCONNECTED;
-        wakeup = 1;
     }
 
     if (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED)
     {
         BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", uipc_main.ch[ch_id].fd);
+        if (uipc_main.ch[ch_id].rx_active)
+            uipc_epoll_del(uipc_main.ch[ch_id].fd);
         close(uipc_main.ch[ch_id].fd);
-        FD_CLR(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
         uipc_main.ch[ch_id].fd = UIPC_DISCONNECTED;
-        wakeup = 1;
+        uipc_main.ch[ch_id].rx_active = FALSE;
     }
 
-    /* notify this connection is closed */
-    if (uipc_main.ch[ch_id].cback)
-        uipc_main.ch[ch_id].cback(ch_id, UIPC_CLOSE_EVT);
-
-    /* trigger main thread update if something was updated */
-    if (wakeup)
-        uipc_wakeup_locked();
+    uipc_dump_stats_locked(ch_id);
 
+    /* the caller notifies UIPC_CLOSE_EVT once the channel lock is released */
     return 0;
 }
 
@@ -492,10 +613,35 @@ void uipc_close_locked(tUIPC_CH_ID ch_id)
 }
 
 
+static void uipc_dispatch_ch(tUIPC_CH_ID ch_id, struct epoll_event *events, int n, UINT64 wake_us)
+{
+    tUIPC_EVENT event;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        if ((UIPC_EV_KIND(events[i].data.u64) != UIPC_EV_SIGNAL) &&
+            (UIPC_EV_CH(events[i].data.u64) == ch_id))
+        {
+            UIPC_CH_LOCK(ch_id);
+            event = uipc_ch_event_locked(ch_id, UIPC_EV_KIND(events[i].data.u64),
+                                         UIPC_EV_FD(events[i].data.u64), wake_us);
+            UIPC_CH_UNLOCK(ch_id);
+
+            if (event)
+                uipc_notify(ch_id, event);
+        }
+    }
+}
+
+
 static void uipc_read_task(void *arg)
 {
+    struct epoll_event events[UIPC_MAX_EVENTS];
+    UINT64 wake_us;
     int ch_id;
     int result;
+    int i;
     UNUSED(arg);
 
     prctl(PR_SET_NAME, (unsigned long)"uipc-main", 0, 0, 0);
@@ -504,40 +650,38 @@ static void uipc_read_task(void *arg)
 
     while (uipc_main.running)
     {
-        uipc_main.read_set = uipc_main.active_set;
-
-        result = select(uipc_main.max_fd+1, &uipc_main.read_set, NULL, NULL, NULL);
+        result = epoll_wait(uipc_main.epfd, events, UIPC_MAX_EVENTS, -1);
 
-        if (result == 0)
-        {
-            BTIF_TRACE_EVENT("select timeout");
-            continue;
-        }
-        else if (result < 0)
+        if (result < 0)
         {
-            BTIF_TRACE_EVENT("select failed %s", strerror(errno));
+            if (errno != EINTR)
+                BTIF_TRACE_EVENT("epoll_wait failed %s", strerror(errno));
             continue;
         }
 
-        UIPC_LOCK();
-
-        /* clear any wakeup interrupt */
-        uipc_check_interrupt_locked();
-
-        /* check pending task events */
-        uipc_check_task_flags_locked();
+        wake_us = uipc_time_us();
 
         /* make sure we service audio channel first */
-        uipc_check_fd_locked(UIPC_CH_ID_AV_AUDIO);
+        uipc_dispatch_ch(UIPC_CH_ID_AV_AUDIO, events, result, wake_us);
 
         /* check for other connections */
         for (ch_id = 0; ch_id < UIPC_CH_NUM; ch_id++)
         {
             if (ch_id != UIPC_CH_ID_AV_AUDIO)
-                uipc_check_fd_locked(ch_id);
+                uipc_dispatch_ch(ch_id, events, result, wake_us);
         }
 
-        UIPC_UNLOCK();
+        for (i = 0; i < result; i++)
+        {
+            if (UIPC_EV_KIND(events[i].data.u64) == UIPC_EV_SIGNAL)
+            {
+                /* clear any wakeup interrupt */
+                uipc_check_interrupt();
+
+                /* check pending task events */
+                uipc_check_task_flags();
+            }
+        }
     }
 
     BTIF_TRACE_EVENT("UIPC READ THREAD EXITING");
@@ -613,18 +757,17 @@ UDRV_API BOOLEAN UIPC_Open(tUIPC_CH_ID ch_id, tUIPC_RCV_CBACK *p_cback)
 {
     BTIF_TRACE_DEBUG("UIPC_Open : ch_id %d, p_cback %x", ch_id, p_cback);
 
-    UIPC_LOCK();
-
     if (ch_id >= UIPC_CH_NUM)
     {
-        UIPC_UNLOCK();
         return FALSE;
     }
 
+    UIPC_CH_LOCK(ch_id);
+
     if (uipc_main.ch[ch_id].srvfd != UIPC_DISCONNECTED)
     {
         BTIF_TRACE_EVENT("CHANNEL %d ALREADY OPEN", ch_id);
-        UIPC_UNLOCK();
+        UIPC_CH_UNLOCK(ch_id);
         return 0;
     }
 
@@ -639,7 +782,7 @@ UDRV_API BOOLEAN UIPC_Open(tUIPC_CH_ID ch_id, tUIPC_RCV_CBACK *p_cback)
             break;
     }
 
-    UIPC_UNLOCK();
+    UIPC_CH_UNLOCK(ch_id);
 
     return TRUE;
 }
@@ -659,13 +802,13 @@ UDRV_API void UIPC_Close(tUIPC_CH_ID ch_id)
     BTIF_TRACE_DEBUG("UIPC_Close : ch_id %d", ch_id);
 
     /* special case handling uipc shutdown */
-    if (ch_id != UIPC_CH_ID_ALL)
+    if (ch_id < UIPC_CH_NUM)
     {
-        UIPC_LOCK();
+        UIPC_CH_LOCK(ch_id);
         uipc_close_locked(ch_id);
-        UIPC_UNLOCK();
+        UIPC_CH_UNLOCK(ch_id);
     }
-    else
+    else if (ch_id == UIPC_CH_ID_ALL)
     {
         BTIF_TRACE_DEBUG("UIPC_Close : waiting for shutdown to complete");
         uipc_stop_main_server_thread();
@@ -715,14 +858,17 @@ UDRV_API BOOLEAN UIPC_Send(tUIPC_CH_ID ch_id, UINT16 msg_evt, UINT8 *p_buf,
 
     BTIF_TRACE_DEBUG("UIPC_Send : ch_id:%d %d bytes", ch_id, msglen);
 
-    UIPC_LOCK();
+    if (ch_id >= UIPC_CH_NUM)
+        return FALSE;
+
+    UIPC_CH_LOCK(ch_id);
 
     if (write(uipc_main.ch[ch_id].fd, p_buf, msglen) < 0)
     {
         BTIF_TRACE_ERROR("failed to write (%s)", strerror(errno));
     }
 
-    UIPC_UNLOCK();
+    UIPC_CH_UNLOCK(ch_id);
 
     return FALSE;
 }
@@ -797,9 +943,9 @@ UDRV_API UINT32 UIPC_Read(tUIPC_CH_ID ch_id, UINT16 *p_msg_evt, UINT8 *p_buf, UI
         if (pfd.revents & (POLLHUP|POLLNVAL) )
         {
             BTIF_TRACE_EVENT("poll : channel detached remotely");
-            UIPC_LOCK();
+            UIPC_CH_LOCK(ch_id);
             uipc_close_locked(ch_id);
-            UIPC_UNLOCK();
+            UIPC_CH_UNLOCK(ch_id);
             return 0;
         }
 
@@ -810,9 +956,9 @@ UDRV_API UINT32 UIPC_Read(tUIPC_CH_ID ch_id, UINT16 *p_msg_evt, UINT8 *p_buf, UI
         if (n == 0)
         {
             BTIF_TRACE_EVENT("UIPC_Read : channel detached remotely");
-            UIPC_LOCK();
+            UIPC_CH_LOCK(ch_id);
             uipc_close_locked(ch_id);
-            UIPC_UNLOCK();
+            UIPC_CH_UNLOCK(ch_id);
             return 0;
         }
 
@@ -843,7 +989,10 @@ UDRV_API extern BOOLEAN UIPC_Ioctl(tUIPC_CH_ID ch_id, UINT32 request, void *para
 {
     BTIF_TRACE_DEBUG("#### UIPC_Ioctl : ch_id %d, request %d ####", ch_id, request);
 
-    UIPC_LOCK();
+    if (ch_id >= UIPC_CH_NUM)
+        return FALSE;
+
+    UIPC_CH_LOCK(ch_id);
 
     switch(request)
     {
@@ -858,14 +1007,12 @@ UDRV_API extern BOOLEAN UIPC_Ioctl(tUIPC_CH_ID ch_id, UINT32 request, void *para
 
         case UIPC_REG_REMOVE_ACTIVE_READSET:
 
-            /* user will read data directly and not use select loop */
-            if (uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED)
+            /* user will read data directly and not use the read task */
+            if ((uipc_main.ch[ch_id].fd != UIPC_DISCONNECTED) && uipc_main.ch[ch_id].rx_active)
             {
-                /* remove this channel from active set */
-                FD_CLR(uipc_main.ch[ch_id].fd, &uipc_main.active_set);
-
-                /* refresh active set */
-                uipc_wakeup_locked();
+                /* remove this channel from the epoll set */
+                uipc_epoll_del(uipc_main.ch[ch_id].fd);
+                uipc_main.ch[ch_id].rx_active = FALSE;
             }
             break;
 
@@ -879,7 +1026,7 @@ UDRV_API extern BOOLEAN UIPC_Ioctl(tUIPC_CH_ID ch_id, UINT32 request, void *para
             break;
     }
 
-    UIPC_UNLOCK();
+    UIPC_CH_UNLOCK(ch_id);
 
     return FALSE;
 }
@@ -11,10 +11,35 @@ LOCAL_CFLAGS += $(bdroid_CFLAGS) -std=c99
 
 LOCAL_PRELINK_MODULE :=false
 LOCAL_SRC_FILES := \
-	./src/bt_utils.c
+	./src/bt_utils.c \
+	./src/interop.c \
+	./src/slab.c
 
 LOCAL_MODULE := libbt-utils
 LOCAL_MODULE_TAGS := optional
 LOCAL_MODULE_CLASS := STATIC_LIBRARIES
 
 include $(BUILD_STATIC_LIBRARY)
+
+#####################################################
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/include \
+	$(LOCAL_PATH)/../gki/ulinux \
+	$(bdroid_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+	./src/interop.c \
+	./src/slab.c \
+	./test/interop_test.cpp \
+	./test/slab_test.cpp
+
+LOCAL_CFLAGS := $(bdroid_CFLAGS)
+LOCAL_CONLYFLAGS := -std=c99
+LOCAL_MODULE := bdutilstests
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog
+
+include $(BUILD_NATIVE_TEST)
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/************************************************************************************
+ *
+ *  Filename:      interop.h
+ *
+ *  Description:   Database of remote devices that need a workaround, looked up
+ *                 by BD address prefix or by device name
+ *
+ ***********************************************************************************/
+
+#ifndef INTEROP_H
+#define INTEROP_H
+
+#include "data_types.h"
+
+/*******************************************************************************
+**  Type definitions
+********************************************************************************/
+
+/* Workarounds. At most 32. */
+typedef enum {
+    /* Do not allow master/slave switch in the link policy */
+    INTEROP_DISABLE_ROLE_SWITCH = 0,
+    /* Stay slave when accepting an incoming connection */
+    INTEROP_ACCEPT_CONN_AS_SLAVE,
+    /* Advertise AVRCP 1.3 in the SDP record */
+    INTEROP_AVRCP_1_3_ONLY,
+    /* Advertise AVRCP 1.4 in the SDP record */
+    INTEROP_AVRCP_1_4_ONLY,
+    /* HID device does not want authentication on connection */
+    INTEROP_HID_NO_AUTH,
+    /* HID device that should not be searched with SDP during pairing */
+    INTEROP_HID_NO_SDP,
+    /* Retry pairing when the page times out */
+    INTEROP_AUTO_RETRY_PAIRING,
+    /* Do not try the fixed PIN codes of auto pairing */
+    INTEROP_DISABLE_AUTO_PAIRING,
+    /* Keyboard that takes a fixed PIN of zeros */
+    INTEROP_KEYBOARD_FIXED_PIN_ZEROS,
+    INTEROP_MAX_FEATURE
+} tINTEROP_FEATURE;
+
+/* How a name added with interop_add_name is compared */
+typedef enum {
+    INTEROP_NAME_EXACT = 0,     /* the whole name */
+    INTEROP_NAME_PREFIX,        /* the start of the name */
+    INTEROP_NAME_SUBSTR         /* anywhere in the name */
+} tINTEROP_NAME_MATCH;
+
+/*******************************************************************************
+**  Functions
+********************************************************************************/
+
+/*******************************************************************************
+**
+** Function         interop_match_addr
+**
+** Description      Looks the BD address of a remote device up in the database.
+**                  Takes time proportional to the address length only.
+**
+** Returns          TRUE if a prefix of the address has the workaround
+**
+*******************************************************************************/
+BOOLEAN interop_match_addr(tINTEROP_FEATURE feature, const UINT8 *bd_addr);
+
+/*******************************************************************************
+**
+** Function         interop_match_name
+**
+** Description      Looks the name of a remote device up in the database. Takes
+**                  time proportional to the name length, whatever the number
+**                  of names in the database.
+**
+** Returns          TRUE if a name entry with the workaround matches
+**
+*******************************************************************************/
+BOOLEAN interop_match_name(tINTEROP_FEATURE feature, const char *name);
+
+/*******************************************************************************
+**
+** Function         interop_add_addr
+**
+** Description      Adds the first len bytes of bd_addr to the database, for
+**                  entries that come from configuration files or are learned
+**                  at runtime. len is 1 to 6.
+**
+** Returns          TRUE if added
+**
+*******************************************************************************/
+BOOLEAN interop_add_addr(tINTEROP_FEATURE feature, const UINT8 *bd_addr, UINT8 len);
+
+/*******************************************************************************
+**
+** Function         interop_add_name
+**
+** Description      Adds a device name to the database. The name matcher is
+**                  rebuilt on the next lookup.
+**
+** Returns          TRUE if added
+**
+*******************************************************************************/
+BOOLEAN interop_add_name(tINTEROP_FEATURE feature, const char *name, tINTEROP_NAME_MATCH match);
+
+#endif /* INTEROP_H */
@@ -0,0 +1,182 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/************************************************************************************
+ *
+ *  Filename:      slab.h
+ *
+ *  Description:   Fixed-block allocator over a pool of control blocks, with
+ *                 O(1) allocation, release and lookup by handle
+ *
+ ***********************************************************************************/
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "data_types.h"
+
+/*******************************************************************************
+**  Constants & Macros
+********************************************************************************/
+
+#define SLAB_NONE           0xFFFF      /* no block */
+
+/* Typed access to the blocks of a slab */
+#define SLAB_ALLOC(p_slab, type)        ((type *)slab_alloc(p_slab))
+#define SLAB_TAKE(p_slab, type, index)  ((type *)slab_take((p_slab), (index)))
+#define SLAB_FIND(p_slab, type, key)    ((type *)slab_map_get((p_slab), (key)))
+
+/*******************************************************************************
+**  Type definitions
+********************************************************************************/
+
+/* Bookkeeping of one block */
+typedef struct {
+    UINT16  next;           /* free list, SLAB_NONE at the tail */
+    UINT16  prev;           /* free list, SLAB_NONE at the head */
+    UINT16  key;            /* handle the block is mapped under */
+    BOOLEAN in_use;
+    BOOLEAN has_key;
+} tSLAB_LINK;
+
+/* Slot of the handle map */
+typedef struct {
+    UINT16  key;
+    UINT16  index;          /* SLAB_NONE if the slot is empty */
+} tSLAB_MAP_SLOT;
+
+/* A slab hands out the blocks of a pool owned by the caller, usually a static
+** array of control blocks. Free blocks are kept in FIFO order so a released
+** block, and the identifiers derived from its index, are reused last.
+*/
+typedef struct {
+    UINT8           *p_base;        /* the pool */
+    UINT16          block_size;
+    UINT16          num_blocks;     /* blocks in the pool */
+    UINT16          capacity;       /* blocks that may be in use at once */
+    UINT16          num_used;
+    UINT16          free_first;
+    UINT16          free_last;
+    tSLAB_LINK      *p_links;       /* one per block */
+    tSLAB_MAP_SLOT  *p_map;         /* open addressing, NULL if no map */
+    UINT16          map_mask;
+} tSLAB;
+
+/*******************************************************************************
+**  Functions
+********************************************************************************/
+
+/*******************************************************************************
+**
+** Function         slab_init
+**
+** Description      Puts every block of the pool on the free list. capacity
+**                  limits the blocks in use at once and is clamped to
+**                  num_blocks; 0 means num_blocks. with_map adds a handle
+**                  map. A slab may be initialized again, its bookkeeping is
+**                  reused, so it should outlive the control block it serves
+**                  if that is cleared on init.
+**
+** Returns          TRUE if successful
+**
+*******************************************************************************/
+BOOLEAN slab_init(tSLAB *p_slab, void *p_base, UINT16 block_size, UINT16 num_blocks,
+                  UINT16 capacity, BOOLEAN with_map);
+
+/*******************************************************************************
+**
+** Function         slab_alloc
+**
+** Description      Takes the block at the head of the free list. The block is
+**                  not cleared.
+**
+** Returns          The block, NULL if capacity blocks are in use
+**
+*******************************************************************************/
+void *slab_alloc(tSLAB *p_slab);
+
+/*******************************************************************************
+**
+** Function         slab_take
+**
+** Description      Takes a given block off the free list, for pools whose
+**                  identifiers are chosen by the peer.
+**
+** Returns          The block, NULL if it is in use or capacity is reached
+**
+*******************************************************************************/
+void *slab_take(tSLAB *p_slab, UINT16 index);
+
+/*******************************************************************************
+**
+** Function         slab_free
+**
+** Description      Puts a block back at the tail of the free list and drops
+**                  its handle. Freeing a free block does nothing.
+**
+** Returns          void
+**
+*******************************************************************************/
+void slab_free(tSLAB *p_slab, void *p_block);
+
+/*******************************************************************************
+**
+** Function         slab_index
+**
+** Description      Index of a block in the pool
+**
+** Returns          The index, SLAB_NONE if the block is not in the pool
+**
+*******************************************************************************/
+UINT16 slab_index(const tSLAB *p_slab, const void *p_block);
+
+/*******************************************************************************
+**
+** Function         slab_map_set
+**
+** Description      Maps a handle to a block in use, replacing the handle the
+**                  block had. A block has at most one handle.
+**
+** Returns          TRUE if successful
+**
+*******************************************************************************/
+BOOLEAN slab_map_set(tSLAB *p_slab, void *p_block, UINT16 key);
+
+/*******************************************************************************
+**
+** Function         slab_map_clear
+**
+** Description      Drops the handle of a block
+**
+** Returns          void
+**
+*******************************************************************************/
+void slab_map_clear(tSLAB *p_slab, void *p_block);
+
+/*******************************************************************************
+**
+** Function         slab_map_get
+**
+** Description      Looks a handle up
+**
+** Returns          The block mapped under the handle, NULL if none
+**
+*******************************************************************************/
+void *slab_map_get(const tSLAB *p_slab, UINT16 key);
+
+#endif /* SLAB_H */
@@ -0,0 +1,559 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/************************************************************************************
+ *
+ *  Filename:      interop.c
+ *
+ *  Description:   Database of remote devices that need a workaround.
+ *
+ *                 The built-in entries below, and any added later from
+ *                 configuration, are compiled into two structures that answer
+ *                 every workaround at once:
+ *                 - a trie over the nibbles of BD address prefixes, each node
+ *                   holding the workarounds of the prefix that ends there, so
+ *                   a lookup walks at most 12 nodes;
+ *                 - an Aho-Corasick automaton over device names, whose nodes
+ *                   hold the workarounds of the names that match there, so a
+ *                   lookup reads each character of the name once.
+ *
+ ***********************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "BT_INTEROP"
+
+#include <utils/Log.h>
+
+#include "data_types.h"
+#include "interop.h"
+
+/*******************************************************************************
+**  Built-in database
+********************************************************************************/
+
+typedef struct {
+    tINTEROP_FEATURE feature;
+    UINT8            len;
+    UINT8            addr[6];
+} tINTEROP_ADDR_ENTRY;
+
+typedef struct {
+    tINTEROP_FEATURE    feature;
+    tINTEROP_NAME_MATCH match;
+    const char         *name;
+} tINTEROP_NAME_ENTRY;
+
+static const tINTEROP_ADDR_ENTRY interop_addr_db[] = {
+    {INTEROP_DISABLE_ROLE_SWITCH,   3, {0x00, 0x0d, 0xfd}},   /* MOT EQ5 */
+    {INTEROP_DISABLE_ROLE_SWITCH,   3, {0x00, 0x1b, 0xdc}},   /* BSHSBE20 */
+
+    {INTEROP_ACCEPT_CONN_AS_SLAVE,  3, {0x00, 0x26, 0xb4}},   /* NAC FORD,2013 Lincoln */
+    {INTEROP_ACCEPT_CONN_AS_SLAVE,  3, {0x00, 0x26, 0xe8}},   /* Nissan Murano */
+    {INTEROP_ACCEPT_CONN_AS_SLAVE,  3, {0x00, 0x37, 0x6d}},   /* Lexus ES300h */
+    {INTEROP_ACCEPT_CONN_AS_SLAVE,  3, {0x9c, 0x3a, 0xaf}},   /* SAMSUNG HM1900 */
+
+    /* Few remote devices do not understand AVRCP versions greater than 1.3
+     * and fall back to 1.0 */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x00, 0x1D, 0xBA}},   /* JVC carkit */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x64, 0xD4, 0xBD}},   /* Honda handsfree carkit */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x0C, 0xD9, 0xC1}},   /* Honda handsfree carkit */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x00, 0x06, 0xF7}},   /* Denso carkit */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x00, 0x1E, 0xB2}},   /* AVN 3.0 Hyundai */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x00, 0x0E, 0x9F}},   /* Porshe car kit */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x00, 0x13, 0x7B}},   /* BYOM Opel */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x68, 0x84, 0x70}},   /* KIA MOTOR */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x00, 0x21, 0xCC}},   /* FORD FIESTA */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x9C, 0xDF, 0x03}},   /* BMW 3 Series */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x30, 0x14, 0x4A}},   /* Mini Cooper */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x38, 0xC0, 0x96}},   /* Seat Leon */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x00, 0x54, 0xAF}},   /* Chrysler */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0x04, 0x88, 0xE2}},   /* BeatsStudio Wireless */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0xA0, 0x14, 0x3D}},   /* VW Sharen */
+    {INTEROP_AVRCP_1_3_ONLY,        3, {0xE0, 0x75, 0x0A}},   /* VW GOLF */
+
+    /* Few carkits support AVRCP 1.4 but not 1.5; fall back to 1.4 to
+     * support browsing */
+    {INTEROP_AVRCP_1_4_ONLY,        3, {0x00, 0x02, 0x0C}},   /* Clarion */
+
+    {INTEROP_HID_NO_AUTH,           3, {0x00, 0x12, 0xa1}},   /* Targus */
+
+    {INTEROP_HID_NO_SDP,            3, {0x00, 0x07, 0x61}},   /* Logitech */
+    {INTEROP_HID_NO_SDP,            3, {0x00, 0x1d, 0xd8}},   /* Microsoft Bluetooth Notebook Mouse 5000 #1 */
+    {INTEROP_HID_NO_SDP,            3, {0x7c, 0xed, 0x8d}},   /* Microsoft Bluetooth Notebook Mouse 5000 #2 */
+
+    {INTEROP_AUTO_RETRY_PAIRING,    3, {0x9C, 0xDF, 0x03}},   /* BMW car kits (Harman/Becker) */
+};
+
+static const tINTEROP_NAME_ENTRY interop_name_db[] = {
+    {INTEROP_HID_NO_SDP, INTEROP_NAME_PREFIX, "Microsoft Bluetooth Notebook Mouse 5000"},
+};
+
+/*******************************************************************************
+**  Compiled database
+********************************************************************************/
+
+#define INTEROP_NONE        0       /* no node; node 0 is the root, never a child */
+#define INTEROP_MAX_NODES   0xFFFF
+
+/* One nibble of a BD address per level */
+typedef struct {
+    UINT16 child[16];
+    UINT32 features;                /* workarounds of the prefix ending here */
+} tINTEROP_ADDR_NODE;
+
+typedef struct {
+    UINT16 first_child;
+    UINT16 next_sibling;
+    UINT16 fail;                    /* longest proper suffix that is a node */
+    UINT8  ch;
+    UINT32 exact;                   /* names that are exactly this path */
+    UINT32 prefix;                  /* names that match at the start of a name */
+    UINT32 substr;                  /* names that end here anywhere, suffixes included */
+} tINTEROP_NAME_NODE;
+
+typedef struct {
+    tINTEROP_ADDR_NODE *p_addr;
+    UINT16              num_addr;
+    UINT16              size_addr;
+
+    tINTEROP_NAME_NODE *p_name;
+    UINT16              num_name;
+    UINT16              size_name;
+    UINT16              root_next[256];     /* the root is dense, it is hit most */
+    BOOLEAN             name_dirty;         /* fail links need a rebuild */
+} tINTEROP_CB;
+
+static tINTEROP_CB interop_cb;
+static pthread_mutex_t interop_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t interop_once = PTHREAD_ONCE_INIT;
+
+static void interop_init(void);
+static BOOLEAN interop_insert_addr(tINTEROP_FEATURE feature, const UINT8 *bd_addr, UINT8 len);
+static BOOLEAN interop_insert_name(tINTEROP_FEATURE feature, const char *name, tINTEROP_NAME_MATCH match);
+static void interop_build_name_links(void);
+
+/*******************************************************************************
+**
+** Function         interop_match_addr
+**
+** Description      Looks the BD address of a remote device up in the database.
+**
+** Returns          TRUE if a prefix of the address has the workaround
+**
+*******************************************************************************/
+BOOLEAN interop_match_addr(tINTEROP_FEATURE feature, const UINT8 *bd_addr)
+{
+    UINT32 features = 0;
+    UINT16 node = 0;
+    int i;
+
+    if (feature >= INTEROP_MAX_FEATURE || bd_addr == NULL)
+        return FALSE;
+
+    pthread_once(&interop_once, interop_init);
+    pthread_mutex_lock(&interop_lock);
+    if (interop_cb.num_addr > 0)
+    {
+        for (i = 0; i < 12; i++)
+        {
+            UINT8 nibble = (i & 1) ? (bd_addr[i >> 1] & 0x0F) : (bd_addr[i >> 1] >> 4);
+
+            node = interop_cb.p_addr[node].child[nibble];
+            if (node == INTEROP_NONE)
+                break;
+            features |= interop_cb.p_addr[node].features;
+        }
+    }
+    pthread_mutex_unlock(&interop_lock);
+
+    return (features & (1u << feature)) != 0;
+}
+
+/*******************************************************************************
+**
+** Function         interop_match_name
+**
+** Description      Looks the name of a remote device up in the database.
+**
+** Returns          TRUE if a name entry with the workaround matches
+**
+*******************************************************************************/
+BOOLEAN interop_match_name(tINTEROP_FEATURE feature, const char *name)
+{
+    const tINTEROP_NAME_NODE *p_nodes;
+    const UINT8 *p;
+    UINT32 mask;
+    UINT32 features = 0;
+    UINT16 state = 0, next;
+    BOOLEAN anchored = TRUE;        /* state is the whole name read so far */
+
+    if (feature >= INTEROP_MAX_FEATURE || name == NULL)
+        return FALSE;
+    mask = 1u << feature;
+
+    pthread_once(&interop_once, interop_init);
+    pthread_mutex_lock(&interop_lock);
+    if (interop_cb.name_dirty)
+        interop_build_name_links();
+
+    p_nodes = interop_cb.p_name;
+    if (interop_cb.num_name > 1)
+    {
+        for (p = (const UINT8 *)name; *p && !(features & mask); p++)
+        {
+            next = INTEROP_NONE;
+            while (state != 0)
+            {
+                for (next = p_nodes[state].first_child; next != INTEROP_NONE;
+                     next = p_nodes[next].next_sibling)
+                {
+                    if (p_nodes[next].ch == *p)
+                        break;
+                }
+                if (next != INTEROP_NONE)
+                    break;
+                state = p_nodes[state].fail;
+                anchored = FALSE;
+            }
+            if (state == 0)
+            {
+                next = interop_cb.root_next[*p];
+                if (next == INTEROP_NONE)
+                    anchored = FALSE;
+            }
+            state = next;
+
+            features |= p_nodes[state].substr;
+            if (anchored)
+                features |= p_nodes[state].prefix;
+        }
+        if (anchored && *p == 0)
+            features |= p_nodes[state].exact;
+    }
+    pthread_mutex_unlock(&interop_lock);
+
+    return (features & mask) != 0;
+}
+
+/*******************************************************************************
+**
+** Function         interop_add_addr
+**
+** Description      Adds the first len bytes of bd_addr to the database.
+**
+** Returns          TRUE if added
+**
+*******************************************************************************/
+BOOLEAN interop_add_addr(tINTEROP_FEATURE feature, const UINT8 *bd_addr, UINT8 len)
+{
+    BOOLEAN added;
+
+    pthread_once(&interop_once, interop_init);
+    pthread_mutex_lock(&interop_lock);
+    added = interop_insert_addr(feature, bd_addr, len);
+    pthread_mutex_unlock(&interop_lock);
+    return added;
+}
+
+/*******************************************************************************
+**
+** Function         interop_add_name
+**
+** Description      Adds a device name to the database.
+**
+** Returns          TRUE if added
+**
+*******************************************************************************/
+BOOLEAN interop_add_name(tINTEROP_FEATURE feature, const char *name, tINTEROP_NAME_MATCH match)
+{
+    BOOLEAN added;
+
+    pthread_once(&interop_once, interop_init);
+    pthread_mutex_lock(&interop_lock);
+    added = interop_insert_name(feature, name, match);
+    pthread_mutex_unlock(&interop_lock);
+    return added;
+}
+
+/*******************************************************************************
+**
+** Function         interop_init
+**
+** Description      Compiles the built-in database, once per process
+**
+** Returns          void
+**
+*******************************************************************************/
+static void interop_init(void)
+{
+    size_t i;
+
+    pthread_mutex_lock(&interop_lock);
+    for (i = 0; i < sizeof(interop_addr_db) / sizeof(interop_addr_db[0]); i++)
+        interop_insert_addr(interop_addr_db[i].feature, interop_addr_db[i].addr, interop_addr_db[i].len);
+
+    for (i = 0; i < sizeof(interop_name_db) / sizeof(interop_name_db[0]); i++)
+        interop_insert_name(interop_name_db[i].feature, interop_name_db[i].name, interop_name_db[i].match);
+    pthread_mutex_unlock(&interop_lock);
+}
+
+/*******************************************************************************
+**
+** Function         interop_new_addr_node
+**
+** Description      Appends an empty node to the address trie
+**
+** Returns          Index of the node, INTEROP_NONE if out of memory
+**
+*******************************************************************************/
+static UINT16 interop_new_addr_node(void)
+{
+    if (interop_cb.num_addr == interop_cb.size_addr)
+    {
+        UINT32 size = interop_cb.size_addr ? interop_cb.size_addr * 2 : 64;
+        tINTEROP_ADDR_NODE *p_addr;
+
+        if (size > INTEROP_MAX_NODES)
+            size = INTEROP_MAX_NODES;
+        if (size == interop_cb.size_addr ||
+            (p_addr = realloc(interop_cb.p_addr, size * sizeof(tINTEROP_ADDR_NODE))) == NULL)
+        {
+            ALOGE("%s unable to grow the address trie past %d nodes", __func__, interop_cb.num_addr);
+            return INTEROP_NONE;
+        }
+        interop_cb.p_addr = p_addr;
+        interop_cb.size_addr = (UINT16)size;
+    }
+
+    memset(&interop_cb.p_addr[interop_cb.num_addr], 0, sizeof(tINTEROP_ADDR_NODE));
+    return interop_cb.num_addr++;
+}
+
+/*******************************************************************************
+**
+** Function         interop_insert_addr
+**
+** Description      Adds an address prefix to the trie. Lock must be held.
+**
+** Returns          TRUE if added
+**
+*******************************************************************************/
+static BOOLEAN interop_insert_addr(tINTEROP_FEATURE feature, const UINT8 *bd_addr, UINT8 len)
+{
+    UINT16 node, child;
+    int i;
+
+    if (feature >= INTEROP_MAX_FEATURE || bd_addr == NULL || len == 0 || len > 6)
+        return FALSE;
+
+    /* the root; its index is INTEROP_NONE, so check the count instead */
+    if (interop_cb.num_addr == 0)
+    {
+        interop_new_addr_node();
+        if (interop_cb.num_addr == 0)
+            return FALSE;
+    }
+
+    node = 0;
+    for (i = 0; i < len * 2; i++)
+    {
+        UINT8 nibble = (i & 1) ? (bd_addr[i >> 1] & 0x0F) : (bd_addr[i >> 1] >> 4);
+
+        child = interop_cb.p_addr[node].child[nibble];
+        if (child == INTEROP_NONE)
+        {
+            if ((child = interop_new_addr_node()) == INTEROP_NONE)
+                return FALSE;
+            interop_cb.p_addr[node].child[nibble] = child;
+        }
+        node = child;
+    }
+    interop_cb.p_addr[node].features |= 1u << feature;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         interop_new_name_node
+**
+** Description      Appends an empty node to the name automaton
+**
+** Returns          Index of the node, INTEROP_NONE if out of memory
+**
+*******************************************************************************/
+static UINT16 interop_new_name_node(void)
+{
+    if (interop_cb.num_name == interop_cb.size_name)
+    {
+        UINT32 size = interop_cb.size_name ? interop_cb.size_name * 2 : 256;
+        tINTEROP_NAME_NODE *p_name;
+
+        if (size > INTEROP_MAX_NODES)
+            size = INTEROP_MAX_NODES;
+        if (size == interop_cb.size_name ||
+            (p_name = realloc(interop_cb.p_name, size * sizeof(tINTEROP_NAME_NODE))) == NULL)
+        {
+            ALOGE("%s unable to grow the name matcher past %d nodes", __func__, interop_cb.num_name);
+            return INTEROP_NONE;
+        }
+        interop_cb.p_name = p_name;
+        interop_cb.size_name = (UINT16)size;
+    }
+
+    memset(&interop_cb.p_name[interop_cb.num_name], 0, sizeof(tINTEROP_NAME_NODE));
+    return interop_cb.num_name++;
+}
+
+/*******************************************************************************
+**
+** Function         interop_insert_name
+**
+** Description      Adds a name to the trie of the automaton. The fail links
+**                  are rebuilt on the next lookup. Lock must be held.
+**
+** Returns          TRUE if added
+**
+*******************************************************************************/
+static BOOLEAN interop_insert_name(tINTEROP_FEATURE feature, const char *name, tINTEROP_NAME_MATCH match)
+{
+    const UINT8 *p;
+    UINT16 node, child;
+
+    if (feature >= INTEROP_MAX_FEATURE || name == NULL || *name == 0)
+        return FALSE;
+
+    /* the root; its index is INTEROP_NONE, so check the count instead */
+    if (interop_cb.num_name == 0)
+    {
+        interop_new_name_node();
+        if (interop_cb.num_name == 0)
+            return FALSE;
+    }
+
+    node = 0;
+    for (p = (const UINT8 *)name; *p; p++)
+    {
+        if (node == 0)
+        {
+            child = interop_cb.root_next[*p];
+        }
+        else
+        {
+            for (child = interop_cb.p_name[node].first_child; child != INTEROP_NONE;
+                 child = interop_cb.p_name[child].next_sibling)
+            {
+                if (interop_cb.p_name[child].ch == *p)
+                    break;
+            }
+        }
+
+        if (child == INTEROP_NONE)
+        {
+            if ((child = interop_new_name_node()) == INTEROP_NONE)
+                return FALSE;
+            interop_cb.p_name[child].ch = *p;
+            interop_cb.p_name[child].next_sibling = interop_cb.p_name[node].first_child;
+            interop_cb.p_name[node].first_child = child;
+            if (node == 0)
+                interop_cb.root_next[*p] = child;
+        }
+        node = child;
+    }
+
+    if (match == INTEROP_NAME_EXACT)
+        interop_cb.p_name[node].exact |= 1u << feature;
+    else if (match == INTEROP_NAME_PREFIX)
+        interop_cb.p_name[node].prefix |= 1u << feature;
+    else
+        interop_cb.p_name[node].substr |= 1u << feature;
+
+    interop_cb.name_dirty = TRUE;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         interop_build_name_links
+**
+** Description      Computes the fail links of the automaton breadth first and
+**                  folds into every node the substring matches of its fail
+**                  chain. Lock must be held.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void interop_build_name_links(void)
+{
+    tINTEROP_NAME_NODE *p_nodes = interop_cb.p_name;
+    UINT16 *p_queue;
+    UINT16 head = 0, tail = 0;
+    UINT16 node, child, fail, next;
+
+    interop_cb.name_dirty = FALSE;
+    if (interop_cb.num_name < 2)
+        return;
+
+    if ((p_queue = malloc(interop_cb.num_name * sizeof(UINT16))) == NULL)
+    {
+        ALOGE("%s unable to allocate the queue, names will not match", __func__);
+        memset(p_nodes, 0, sizeof(tINTEROP_NAME_NODE));
+        memset(interop_cb.root_next, 0, sizeof(interop_cb.root_next));
+        interop_cb.num_name = 1;
+        return;
+    }
+
+    for (child = p_nodes[0].first_child; child != INTEROP_NONE; child = p_nodes[child].next_sibling)
+    {
+        p_nodes[child].fail = 0;
+        p_queue[tail++] = child;
+    }
+
+    while (head != tail)
+    {
+        node = p_queue[head++];
+        for (child = p_nodes[node].first_child; child != INTEROP_NONE; child = p_nodes[child].next_sibling)
+        {
+            /* the fail link of a child extends the fail chain of its parent */
+            next = INTEROP_NONE;
+            for (fail = p_nodes[node].fail; ; fail = p_nodes[fail].fail)
+            {
+                if (fail == 0)
+                {
+                    next = interop_cb.root_next[p_nodes[child].ch];
+                    break;
+                }
+                for (next = p_nodes[fail].first_child; next != INTEROP_NONE;
+                     next = p_nodes[next].next_sibling)
+                {
+                    if (p_nodes[next].ch == p_nodes[child].ch)
+                        break;
+                }
+                if (next != INTEROP_NONE)
+                    break;
+            }
+            p_nodes[child].fail = next;
+            p_nodes[child].substr |= p_nodes[next].substr;
+            p_queue[tail++] = child;
+        }
+    }
+
+    free(p_queue);
+}
@@ -0,0 +1,372 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/************************************************************************************
+ *
+ *  Filename:      slab.c
+ *
+ *  Description:   Fixed-block allocator over a pool of control blocks.
+ *
+ *                 The free blocks form a doubly linked list of indices kept
+ *                 beside the pool, so the blocks themselves are never
+ *                 written and the in_use or state fields the stack checks
+ *                 while walking a pool keep their meaning. Handles map to
+ *                 blocks through a linear probing table at least twice the
+ *                 size of the pool.
+ *
+ ***********************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "BT_SLAB"
+
+#include <utils/Log.h>
+
+#include "data_types.h"
+#include "slab.h"
+
+static UINT16 slab_map_slot(const tSLAB *p_slab, UINT16 key);
+static void slab_map_remove(tSLAB *p_slab, UINT16 key);
+static void slab_unlink(tSLAB *p_slab, UINT16 index);
+
+/*******************************************************************************
+**
+** Function         slab_init
+**
+** Description      Puts every block of the pool on the free list.
+**
+** Returns          TRUE if successful
+**
+*******************************************************************************/
+BOOLEAN slab_init(tSLAB *p_slab, void *p_base, UINT16 block_size, UINT16 num_blocks,
+                  UINT16 capacity, BOOLEAN with_map)
+{
+    UINT32 map_size = 0;
+    UINT16 i;
+
+    if (p_base == NULL || block_size == 0 || num_blocks == 0 || num_blocks == SLAB_NONE)
+        return FALSE;
+
+    if (p_slab->p_links == NULL || p_slab->num_blocks != num_blocks)
+    {
+        tSLAB_LINK *p_links = realloc(p_slab->p_links, num_blocks * sizeof(tSLAB_LINK));
+        if (p_links == NULL)
+        {
+            ALOGE("%s unable to allocate links for %d blocks", __func__, num_blocks);
+            return FALSE;
+        }
+        p_slab->p_links = p_links;
+    }
+
+    if (with_map)
+    {
+        for (map_size = 4; map_size < 2 * (UINT32)num_blocks; map_size <<= 1)
+            ;
+        if (p_slab->p_map == NULL || p_slab->map_mask != map_size - 1)
+        {
+            tSLAB_MAP_SLOT *p_map = realloc(p_slab->p_map, map_size * sizeof(tSLAB_MAP_SLOT));
+            if (p_map == NULL)
+            {
+                ALOGE("%s unable to allocate a map of %u slots", __func__, map_size);
+                return FALSE;
+            }
+            p_slab->p_map = p_map;
+        }
+        for (i = 0; i < map_size; i++)
+            p_slab->p_map[i].index = SLAB_NONE;
+        p_slab->map_mask = (UINT16)(map_size - 1);
+    }
+    else
+    {
+        free(p_slab->p_map);
+        p_slab->p_map = NULL;
+        p_slab->map_mask = 0;
+    }
+
+    p_slab->p_base     = p_base;
+    p_slab->block_size = block_size;
+    p_slab->num_blocks = num_blocks;
+    p_slab->capacity   = (capacity == 0 || capacity > num_blocks) ? num_blocks : capacity;
+    p_slab->num_used   = 0;
+
+    for (i = 0; i < num_blocks; i++)
+    {
+        p_slab->p_links[i].next    = (i + 1 < num_blocks) ? i + 1 : SLAB_NONE;
+        p_slab->p_links[i].prev    = (i > 0) ? i - 1 : SLAB_NONE;
+        p_slab->p_links[i].key     = 0;
+        p_slab->p_links[i].in_use  = FALSE;
+        p_slab->p_links[i].has_key = FALSE;
+    }
+    p_slab->free_first = 0;
+    p_slab->free_last  = num_blocks - 1;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         slab_alloc
+**
+** Description      Takes the block at the head of the free list.
+**
+** Returns          The block, NULL if capacity blocks are in use
+**
+*******************************************************************************/
+void *slab_alloc(tSLAB *p_slab)
+{
+    if (p_slab->p_links == NULL || p_slab->free_first == SLAB_NONE)
+        return NULL;
+
+    return slab_take(p_slab, p_slab->free_first);
+}
+
+/*******************************************************************************
+**
+** Function         slab_take
+**
+** Description      Takes a given block off the free list.
+**
+** Returns          The block, NULL if it is in use or capacity is reached
+**
+*******************************************************************************/
+void *slab_take(tSLAB *p_slab, UINT16 index)
+{
+    if (p_slab->p_links == NULL || index >= p_slab->num_blocks ||
+        p_slab->p_links[index].in_use || p_slab->num_used >= p_slab->capacity)
+        return NULL;
+
+    slab_unlink(p_slab, index);
+    p_slab->p_links[index].in_use = TRUE;
+    p_slab->num_used++;
+    return p_slab->p_base + (UINT32)index * p_slab->block_size;
+}
+
+/*******************************************************************************
+**
+** Function         slab_free
+**
+** Description      Puts a block back at the tail of the free list.
+**
+** Returns          void
+**
+*******************************************************************************/
+void slab_free(tSLAB *p_slab, void *p_block)
+{
+    UINT16 index = slab_index(p_slab, p_block);
+    tSLAB_LINK *p_link;
+
+    if (index == SLAB_NONE || !p_slab->p_links[index].in_use)
+        return;
+
+    slab_map_clear(p_slab, p_block);
+
+    p_link = &p_slab->p_links[index];
+    p_link->in_use = FALSE;
+    p_link->next   = SLAB_NONE;
+    p_link->prev   = p_slab->free_last;
+    if (p_slab->free_last == SLAB_NONE)
+        p_slab->free_first = index;
+    else
+        p_slab->p_links[p_slab->free_last].next = index;
+    p_slab->free_last = index;
+    p_slab->num_used--;
+}
+
+/*******************************************************************************
+**
+** Function         slab_index
+**
+** Description      Index of a block in the pool
+**
+** Returns          The index, SLAB_NONE if the block is not in the pool
+**
+*******************************************************************************/
+UINT16 slab_index(const tSLAB *p_slab, const void *p_block)
+{
+    const UINT8 *p = (const UINT8 *)p_block;
+    UINT32 offset;
+
+    if (p_slab->p_links == NULL || p < p_slab->p_base)
+        return SLAB_NONE;
+
+    offset = (UINT32)(p - p_slab->p_base);
+    if (offset % p_slab->block_size != 0 || offset / p_slab->block_size >= p_slab->num_blocks)
+        return SLAB_NONE;
+
+    return (UINT16)(offset / p_slab->block_size);
+}
+
+/*******************************************************************************
+**
+** Function         slab_map_set
+**
+** Description      Maps a handle to a block in use.
+**
+** Returns          TRUE if successful
+**
+*******************************************************************************/
+BOOLEAN slab_map_set(tSLAB *p_slab, void *p_block, UINT16 key)
+{
+    UINT16 index = slab_index(p_slab, p_block);
+    UINT16 slot;
+
+    if (index == SLAB_NONE || p_slab->p_map == NULL || !p_slab->p_links[index].in_use)
+        return FALSE;
+
+    slab_map_clear(p_slab, p_block);
+
+    /* A handle belongs to one block; a stale owner loses it */
+    slot = slab_map_slot(p_slab, key);
+    if (p_slab->p_map[slot].index != SLAB_NONE)
+    {
+        p_slab->p_links[p_slab->p_map[slot].index].has_key = FALSE;
+        p_slab->p_map[slot].index = index;
+    }
+    else
+    {
+        p_slab->p_map[slot].key   = key;
+        p_slab->p_map[slot].index = index;
+    }
+
+    p_slab->p_links[index].key     = key;
+    p_slab->p_links[index].has_key = TRUE;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         slab_map_clear
+**
+** Description      Drops the handle of a block
+**
+** Returns          void
+**
+*******************************************************************************/
+void slab_map_clear(tSLAB *p_slab, void *p_block)
+{
+    UINT16 index = slab_index(p_slab, p_block);
+
+    if (index == SLAB_NONE || p_slab->p_map == NULL || !p_slab->p_links[index].has_key)
+        return;
+
+    slab_map_remove(p_slab, p_slab->p_links[index].key);
+    p_slab->p_links[index].has_key = FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         slab_map_get
+**
+** Description      Looks a handle up
+**
+** Returns          The block mapped under the handle, NULL if none
+**
+*******************************************************************************/
+void *slab_map_get(const tSLAB *p_slab, UINT16 key)
+{
+    UINT16 index;
+
+    if (p_slab->p_map == NULL)
+        return NULL;
+
+    index = p_slab->p_map[slab_map_slot(p_slab, key)].index;
+    if (index == SLAB_NONE)
+        return NULL;
+
+    return p_slab->p_base + (UINT32)index * p_slab->block_size;
+}
+
+/*******************************************************************************
+**
+** Function         slab_map_slot
+**
+** Description      Probes for a handle
+**
+** Returns          The slot holding the handle, or the empty slot ending the
+**                  probe sequence. The map is never full.
+**
+*******************************************************************************/
+static UINT16 slab_map_slot(const tSLAB *p_slab, UINT16 key)
+{
+    UINT16 slot = (UINT16)(((UINT32)key * 40503u) >> 4) & p_slab->map_mask;
+
+    while (p_slab->p_map[slot].index != SLAB_NONE && p_slab->p_map[slot].key != key)
+        slot = (slot + 1) & p_slab->map_mask;
+
+    return slot;
+}
+
+/*******************************************************************************
+**
+** Function         slab_map_remove
+**
+** Description      Removes a handle and shifts back the entries probing past
+**                  it, so lookups need no tombstones
+**
+** Returns          void
+**
+*******************************************************************************/
+static void slab_map_remove(tSLAB *p_slab, UINT16 key)
+{
+    UINT16 hole = slab_map_slot(p_slab, key);
+    UINT16 slot, home;
+
+    if (p_slab->p_map[hole].index == SLAB_NONE)
+        return;
+
+    p_slab->p_map[hole].index = SLAB_NONE;
+    for (slot = (hole + 1) & p_slab->map_mask; p_slab->p_map[slot].index != SLAB_NONE;
+         slot = (slot + 1) & p_slab->map_mask)
+    {
+        home = (UINT16)(((UINT32)p_slab->p_map[slot].key * 40503u) >> 4) & p_slab->map_mask;
+
+        /* move the entry if the hole lies between its home and its slot */
+        if (((slot - home) & p_slab->map_mask) >= ((slot - hole) & p_slab->map_mask))
+        {
+            p_slab->p_map[hole] = p_slab->p_map[slot];
+            p_slab->p_map[slot].index = SLAB_NONE;
+            hole = slot;
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         slab_unlink
+**
+** Description      Takes a block off the free list
+**
+** Returns          void
+**
+*******************************************************************************/
+static void slab_unlink(tSLAB *p_slab, UINT16 index)
+{
+    tSLAB_LINK *p_link = &p_slab->p_links[index];
+
+    if (p_link->prev == SLAB_NONE)
+        p_slab->free_first = p_link->next;
+    else
+        p_slab->p_links[p_link->prev].next = p_link->next;
+
+    if (p_link->next == SLAB_NONE)
+        p_slab->free_last = p_link->prev;
+    else
+        p_slab->p_links[p_link->next].prev = p_link->prev;
+
+    p_link->next = p_link->prev = SLAB_NONE;
+}
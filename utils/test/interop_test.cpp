@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "data_types.h"
+#include "interop.h"
+}
+
+// The database is process wide, so every test adds entries of its own.
+
+TEST(InteropTest, test_builtin_addr_prefix_matches_any_device) {
+  UINT8 mot_eq5[6] = { 0x00, 0x0d, 0xfd, 0x12, 0x34, 0x56 };
+  UINT8 other[6] = { 0x00, 0x0d, 0xfe, 0x12, 0x34, 0x56 };
+
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_ROLE_SWITCH, mot_eq5));
+  EXPECT_FALSE(interop_match_addr(INTEROP_HID_NO_SDP, mot_eq5));
+  EXPECT_FALSE(interop_match_addr(INTEROP_DISABLE_ROLE_SWITCH, other));
+}
+
+TEST(InteropTest, test_builtin_addr_with_several_features) {
+  UINT8 bmw[6] = { 0x9c, 0xdf, 0x03, 0x00, 0x00, 0x01 };
+
+  EXPECT_TRUE(interop_match_addr(INTEROP_AVRCP_1_3_ONLY, bmw));
+  EXPECT_TRUE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, bmw));
+}
+
+TEST(InteropTest, test_added_full_addr_matches_only_itself) {
+  UINT8 addr[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+  UINT8 sibling[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x67 };
+
+  ASSERT_TRUE(interop_add_addr(INTEROP_HID_NO_AUTH, addr, 6));
+  EXPECT_TRUE(interop_match_addr(INTEROP_HID_NO_AUTH, addr));
+  EXPECT_FALSE(interop_match_addr(INTEROP_HID_NO_AUTH, sibling));
+}
+
+TEST(InteropTest, test_nested_prefixes_both_apply) {
+  UINT8 prefix[6] = { 0x21, 0x22, 0x23, 0x24, 0x00, 0x00 };
+  UINT8 addr[6] = { 0x21, 0x22, 0x23, 0x24, 0x25, 0x26 };
+
+  ASSERT_TRUE(interop_add_addr(INTEROP_ACCEPT_CONN_AS_SLAVE, prefix, 2));
+  ASSERT_TRUE(interop_add_addr(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, prefix, 4));
+  EXPECT_TRUE(interop_match_addr(INTEROP_ACCEPT_CONN_AS_SLAVE, addr));
+  EXPECT_TRUE(interop_match_addr(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, addr));
+
+  addr[3] = 0x14;
+  EXPECT_TRUE(interop_match_addr(INTEROP_ACCEPT_CONN_AS_SLAVE, addr));
+  EXPECT_FALSE(interop_match_addr(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, addr));
+}
+
+TEST(InteropTest, test_add_addr_rejects_bad_entries) {
+  UINT8 addr[6] = { 0x31, 0x32, 0x33, 0x34, 0x35, 0x36 };
+
+  EXPECT_FALSE(interop_add_addr(INTEROP_HID_NO_AUTH, addr, 0));
+  EXPECT_FALSE(interop_add_addr(INTEROP_HID_NO_AUTH, addr, 7));
+  EXPECT_FALSE(interop_add_addr(INTEROP_HID_NO_AUTH, NULL, 3));
+  EXPECT_FALSE(interop_add_addr(INTEROP_MAX_FEATURE, addr, 3));
+  EXPECT_FALSE(interop_match_addr(INTEROP_HID_NO_AUTH, addr));
+  EXPECT_FALSE(interop_match_addr(INTEROP_MAX_FEATURE, addr));
+  EXPECT_FALSE(interop_match_addr(INTEROP_HID_NO_AUTH, NULL));
+}
+
+TEST(InteropTest, test_builtin_name_prefix) {
+  EXPECT_TRUE(interop_match_name(INTEROP_HID_NO_SDP, "Microsoft Bluetooth Notebook Mouse 5000"));
+  EXPECT_TRUE(interop_match_name(INTEROP_HID_NO_SDP, "Microsoft Bluetooth Notebook Mouse 5000 #2"));
+  EXPECT_FALSE(interop_match_name(INTEROP_HID_NO_SDP, "My Microsoft Bluetooth Notebook Mouse 5000"));
+  EXPECT_FALSE(interop_match_name(INTEROP_HID_NO_SDP, "Microsoft Bluetooth Notebook Mouse"));
+}
+
+TEST(InteropTest, test_exact_name) {
+  ASSERT_TRUE(interop_add_name(INTEROP_DISABLE_AUTO_PAIRING, "Exact Kit", INTEROP_NAME_EXACT));
+
+  EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Exact Kit"));
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Exact Kit 2"));
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "My Exact Kit"));
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Exact"));
+}
+
+TEST(InteropTest, test_substring_name) {
+  ASSERT_TRUE(interop_add_name(INTEROP_AUTO_RETRY_PAIRING, "Substr MMI", INTEROP_NAME_SUBSTR));
+
+  EXPECT_TRUE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "Substr MMI"));
+  EXPECT_TRUE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "My Substr MMI 3G"));
+  EXPECT_TRUE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "SSubstr MMI"));
+  EXPECT_FALSE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "Substr MM"));
+}
+
+TEST(InteropTest, test_substring_found_through_fail_link) {
+  // Reading "qabce" goes down "qabcd" and must fall back to "bce".
+  ASSERT_TRUE(interop_add_name(INTEROP_HID_NO_AUTH, "qabcd", INTEROP_NAME_SUBSTR));
+  ASSERT_TRUE(interop_add_name(INTEROP_AVRCP_1_4_ONLY, "bce", INTEROP_NAME_SUBSTR));
+
+  EXPECT_TRUE(interop_match_name(INTEROP_AVRCP_1_4_ONLY, "qabce"));
+  EXPECT_FALSE(interop_match_name(INTEROP_HID_NO_AUTH, "qabce"));
+}
+
+TEST(InteropTest, test_substring_ending_inside_longer_name) {
+  // "wxy" is a node of "wxyq"; the shorter "xy" ends there too.
+  ASSERT_TRUE(interop_add_name(INTEROP_HID_NO_AUTH, "wxyq", INTEROP_NAME_EXACT));
+  ASSERT_TRUE(interop_add_name(INTEROP_ACCEPT_CONN_AS_SLAVE, "xy", INTEROP_NAME_SUBSTR));
+
+  EXPECT_TRUE(interop_match_name(INTEROP_ACCEPT_CONN_AS_SLAVE, "wxy"));
+  EXPECT_TRUE(interop_match_name(INTEROP_HID_NO_AUTH, "wxyq"));
+  EXPECT_FALSE(interop_match_name(INTEROP_HID_NO_AUTH, "wxy"));
+}
+
+TEST(InteropTest, test_prefix_is_anchored_after_fail) {
+  ASSERT_TRUE(interop_add_name(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, "Keyb", INTEROP_NAME_PREFIX));
+
+  EXPECT_TRUE(interop_match_name(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, "Keyboard"));
+  EXPECT_FALSE(interop_match_name(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, "KKeyboard"));
+  EXPECT_FALSE(interop_match_name(INTEROP_KEYBOARD_FIXED_PIN_ZEROS, "Key"));
+}
+
+TEST(InteropTest, test_name_added_after_lookup_matches) {
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_ROLE_SWITCH, "Late Name"));
+  ASSERT_TRUE(interop_add_name(INTEROP_DISABLE_ROLE_SWITCH, "Late", INTEROP_NAME_SUBSTR));
+  EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_ROLE_SWITCH, "Late Name"));
+}
+
+TEST(InteropTest, test_add_name_rejects_bad_entries) {
+  EXPECT_FALSE(interop_add_name(INTEROP_HID_NO_AUTH, "", INTEROP_NAME_SUBSTR));
+  EXPECT_FALSE(interop_add_name(INTEROP_HID_NO_AUTH, NULL, INTEROP_NAME_SUBSTR));
+  EXPECT_FALSE(interop_add_name(INTEROP_MAX_FEATURE, "Name", INTEROP_NAME_SUBSTR));
+  EXPECT_FALSE(interop_match_name(INTEROP_MAX_FEATURE, "Name"));
+  EXPECT_FALSE(interop_match_name(INTEROP_HID_NO_AUTH, NULL));
+  EXPECT_FALSE(interop_match_name(INTEROP_HID_NO_AUTH, ""));
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include "data_types.h"
+#include "slab.h"
+}
+
+#define NUM_BLOCKS 8
+
+typedef struct {
+  BOOLEAN in_use;
+  UINT32 payload;
+} block_t;
+
+class SlabTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&slab, 0, sizeof(slab));
+      memset(pool, 0, sizeof(pool));
+      ASSERT_TRUE(slab_init(&slab, pool, sizeof(block_t), NUM_BLOCKS, 0, TRUE));
+    }
+
+    virtual void TearDown() {
+      free(slab.p_links);
+      free(slab.p_map);
+    }
+
+    tSLAB slab;
+    block_t pool[NUM_BLOCKS];
+};
+
+TEST_F(SlabTest, test_init_rejects_bad_pool) {
+  tSLAB other;
+
+  memset(&other, 0, sizeof(other));
+  EXPECT_FALSE(slab_init(&other, NULL, sizeof(block_t), NUM_BLOCKS, 0, FALSE));
+  EXPECT_FALSE(slab_init(&other, pool, 0, NUM_BLOCKS, 0, FALSE));
+  EXPECT_FALSE(slab_init(&other, pool, sizeof(block_t), 0, 0, FALSE));
+  EXPECT_FALSE(slab_init(&other, pool, sizeof(block_t), SLAB_NONE, 0, FALSE));
+}
+
+TEST_F(SlabTest, test_alloc_hands_out_every_block_once) {
+  bool seen[NUM_BLOCKS] = { false };
+
+  for (int i = 0; i < NUM_BLOCKS; ++i) {
+    block_t *p = SLAB_ALLOC(&slab, block_t);
+    ASSERT_TRUE(p != NULL);
+    UINT16 index = slab_index(&slab, p);
+    ASSERT_LT(index, NUM_BLOCKS);
+    EXPECT_FALSE(seen[index]);
+    seen[index] = true;
+  }
+
+  EXPECT_TRUE(slab_alloc(&slab) == NULL);
+  EXPECT_EQ(NUM_BLOCKS, slab.num_used);
+}
+
+TEST_F(SlabTest, test_alloc_leaves_block_untouched) {
+  pool[0].in_use = TRUE;
+  pool[0].payload = 0xdeadbeef;
+
+  block_t *p = SLAB_ALLOC(&slab, block_t);
+  EXPECT_EQ(&pool[0], p);
+  EXPECT_EQ(0xdeadbeefu, p->payload);
+}
+
+TEST_F(SlabTest, test_freed_block_is_reused_last) {
+  block_t *first = SLAB_ALLOC(&slab, block_t);
+  slab_free(&slab, first);
+
+  for (int i = 1; i < NUM_BLOCKS; ++i)
+    EXPECT_NE(first, SLAB_ALLOC(&slab, block_t));
+  EXPECT_EQ(first, SLAB_ALLOC(&slab, block_t));
+}
+
+TEST_F(SlabTest, test_free_twice_is_harmless) {
+  block_t *p = SLAB_ALLOC(&slab, block_t);
+
+  slab_free(&slab, p);
+  slab_free(&slab, p);
+  EXPECT_EQ(0, slab.num_used);
+
+  for (int i = 0; i < NUM_BLOCKS; ++i)
+    EXPECT_TRUE(slab_alloc(&slab) != NULL);
+  EXPECT_TRUE(slab_alloc(&slab) == NULL);
+}
+
+TEST_F(SlabTest, test_capacity_limits_blocks_in_use) {
+  ASSERT_TRUE(slab_init(&slab, pool, sizeof(block_t), NUM_BLOCKS, 2, FALSE));
+
+  block_t *p = SLAB_ALLOC(&slab, block_t);
+  EXPECT_TRUE(slab_alloc(&slab) != NULL);
+  EXPECT_TRUE(slab_alloc(&slab) == NULL);
+  EXPECT_TRUE(slab_take(&slab, 5) == NULL);
+
+  slab_free(&slab, p);
+  EXPECT_EQ(&pool[5], SLAB_TAKE(&slab, block_t, 5));
+}
+
+TEST_F(SlabTest, test_take_given_block) {
+  EXPECT_EQ(&pool[3], SLAB_TAKE(&slab, block_t, 3));
+  EXPECT_TRUE(slab_take(&slab, 3) == NULL);
+  EXPECT_TRUE(slab_take(&slab, NUM_BLOCKS) == NULL);
+
+  // The taken block is off the free list.
+  for (int i = 1; i < NUM_BLOCKS; ++i)
+    EXPECT_NE(&pool[3], SLAB_ALLOC(&slab, block_t));
+  EXPECT_TRUE(slab_alloc(&slab) == NULL);
+}
+
+TEST_F(SlabTest, test_index_of_foreign_pointer) {
+  UINT8 *base = (UINT8 *)pool;
+
+  EXPECT_EQ(SLAB_NONE, slab_index(&slab, base + 1));
+  EXPECT_EQ(SLAB_NONE, slab_index(&slab, &pool[NUM_BLOCKS]));
+  EXPECT_EQ(SLAB_NONE, slab_index(&slab, base - sizeof(block_t)));
+  EXPECT_EQ(2, slab_index(&slab, &pool[2]));
+}
+
+TEST_F(SlabTest, test_map_finds_block_by_handle) {
+  block_t *a = SLAB_ALLOC(&slab, block_t);
+  block_t *b = SLAB_ALLOC(&slab, block_t);
+
+  EXPECT_TRUE(slab_map_set(&slab, a, 0x0040));
+  EXPECT_TRUE(slab_map_set(&slab, b, 0x0041));
+  EXPECT_EQ(a, SLAB_FIND(&slab, block_t, 0x0040));
+  EXPECT_EQ(b, SLAB_FIND(&slab, block_t, 0x0041));
+  EXPECT_TRUE(slab_map_get(&slab, 0x0042) == NULL);
+}
+
+TEST_F(SlabTest, test_map_rejects_free_block) {
+  EXPECT_FALSE(slab_map_set(&slab, &pool[0], 1));
+  EXPECT_TRUE(slab_map_get(&slab, 1) == NULL);
+}
+
+TEST_F(SlabTest, test_map_new_handle_replaces_old) {
+  block_t *p = SLAB_ALLOC(&slab, block_t);
+
+  slab_map_set(&slab, p, 1);
+  slab_map_set(&slab, p, 2);
+  EXPECT_TRUE(slab_map_get(&slab, 1) == NULL);
+  EXPECT_EQ(p, SLAB_FIND(&slab, block_t, 2));
+}
+
+TEST_F(SlabTest, test_map_handle_moves_to_new_owner) {
+  block_t *a = SLAB_ALLOC(&slab, block_t);
+  block_t *b = SLAB_ALLOC(&slab, block_t);
+
+  slab_map_set(&slab, a, 7);
+  slab_map_set(&slab, b, 7);
+  EXPECT_EQ(b, SLAB_FIND(&slab, block_t, 7));
+
+  // Clearing the stale owner must not drop the handle of the new one.
+  slab_map_clear(&slab, a);
+  EXPECT_EQ(b, SLAB_FIND(&slab, block_t, 7));
+}
+
+TEST_F(SlabTest, test_free_drops_handle) {
+  block_t *p = SLAB_ALLOC(&slab, block_t);
+
+  slab_map_set(&slab, p, 9);
+  slab_free(&slab, p);
+  EXPECT_TRUE(slab_map_get(&slab, 9) == NULL);
+}
+
+TEST_F(SlabTest, test_map_remove_keeps_colliding_handles) {
+  block_t *blocks[NUM_BLOCKS];
+
+  // Handles a multiple of the map size apart share a home slot.
+  UINT16 step = slab.map_mask + 1;
+  for (int i = 0; i < NUM_BLOCKS; ++i) {
+    blocks[i] = SLAB_ALLOC(&slab, block_t);
+    ASSERT_TRUE(slab_map_set(&slab, blocks[i], (UINT16)(i * step * 16)));
+  }
+
+  for (int i = 0; i < NUM_BLOCKS; i += 2)
+    slab_map_clear(&slab, blocks[i]);
+
+  for (int i = 0; i < NUM_BLOCKS; ++i) {
+    block_t *expected = (i % 2) ? blocks[i] : NULL;
+    EXPECT_EQ(expected, SLAB_FIND(&slab, block_t, (UINT16)(i * step * 16)));
+  }
+}
+
+TEST_F(SlabTest, test_without_map_lookups_fail) {
+  ASSERT_TRUE(slab_init(&slab, pool, sizeof(block_t), NUM_BLOCKS, 0, FALSE));
+
+  block_t *p = SLAB_ALLOC(&slab, block_t);
+  EXPECT_FALSE(slab_map_set(&slab, p, 1));
+  EXPECT_TRUE(slab_map_get(&slab, 1) == NULL);
+}
+
+TEST_F(SlabTest, test_init_again_frees_every_block) {
+  for (int i = 0; i < NUM_BLOCKS; ++i)
+    slab_map_set(&slab, slab_alloc(&slab), (UINT16)i);
+
+  ASSERT_TRUE(slab_init(&slab, pool, sizeof(block_t), NUM_BLOCKS, 0, TRUE));
+  EXPECT_EQ(0, slab.num_used);
+  EXPECT_TRUE(slab_map_get(&slab, 0) == NULL);
+  for (int i = 0; i < NUM_BLOCKS; ++i)
+    EXPECT_TRUE(slab_alloc(&slab) != NULL);
+}